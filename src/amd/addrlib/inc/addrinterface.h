@@ -2358,6 +2358,7 @@ ADDR_E_RETURNCODE ADDR_API AddrGetMaxMetaAlignments(
 ****************************************************************************************************
 *     Addr2ComputeSurfaceInfo()
 *     Addr2ComputeSurfaceAddrFromCoord()
+*     Addr2ComputeSurfaceAddrFromRect()
 *     Addr2ComputeSurfaceCoordFromAddr()
 
 *     Addr2ComputeHtileInfo()
@@ -2610,6 +2611,57 @@ ADDR_E_RETURNCODE ADDR_API Addr2ComputeSurfaceAddrFromCoord(
 
 
 
+/**
+****************************************************************************************************
+*   ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT
+*
+*   @brief
+*       Input structure for Addr2ComputeSurfaceAddrFromRect
+****************************************************************************************************
+*/
+typedef struct _ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT
+{
+    UINT_32                                   size;     ///< Size of this structure in bytes
+
+    ADDR2_COMPUTE_SURFACE_ADDRFROMCOORD_INPUT coordIn;  ///< Surface info, x/y give the top left
+                                                        ///  element of the rectangle
+    UINT_32                                   width;    ///< Width of the rectangle in elements
+    UINT_32                                   height;   ///< Height of the rectangle in elements
+} ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT;
+
+/**
+****************************************************************************************************
+*   ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT
+*
+*   @brief
+*       Output structure for Addr2ComputeSurfaceAddrFromRect
+****************************************************************************************************
+*/
+typedef struct _ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT
+{
+    UINT_32    size;             ///< Size of this structure in bytes
+
+    UINT_64*   pAddr;            ///< Client provided array of width * height byte addresses,
+                                 ///  filled row by row
+} ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT;
+
+/**
+****************************************************************************************************
+*   Addr2ComputeSurfaceAddrFromRect
+*
+*   @brief
+*       Compute the surface addresses of all elements in a rectangle of one slice/sample/mip.
+*       Same results as calling Addr2ComputeSurfaceAddrFromCoord for each element, but the
+*       swizzle is only evaluated once per address bit instead of once per element.
+****************************************************************************************************
+*/
+ADDR_E_RETURNCODE ADDR_API Addr2ComputeSurfaceAddrFromRect(
+    ADDR_HANDLE                                         hLib,
+    const ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT*     pIn,
+    ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT*          pOut);
+
+
+
 /**
 ****************************************************************************************************
 *   ADDR2_COMPUTE_SURFACE_COORDFROMADDR_INPUT
@@ -1203,6 +1203,39 @@ ADDR_E_RETURNCODE ADDR_API Addr2ComputeSurfaceAddrFromCoord(
 }
 
 
+/**
+****************************************************************************************************
+*   Addr2ComputeSurfaceAddrFromRect
+*
+*   @brief
+*       Compute surface addresses of a rectangle of elements
+*
+*   @return
+*       ADDR_OK if successful, otherwise an error code of ADDR_E_RETURNCODE
+****************************************************************************************************
+*/
+ADDR_E_RETURNCODE ADDR_API Addr2ComputeSurfaceAddrFromRect(
+    ADDR_HANDLE                                         hLib, ///< address lib handle
+    const ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT*     pIn,  ///< [in] surface info and rectangle
+    ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT*          pOut) ///< [out] surface addresses
+{
+    V2::Lib* pLib = V2::Lib::GetLib(hLib);
+
+    ADDR_E_RETURNCODE returnCode = ADDR_OK;
+
+    if (pLib != NULL)
+    {
+        returnCode = pLib->ComputeSurfaceAddrFromRect(pIn, pOut);
+    }
+    else
+    {
+        returnCode = ADDR_ERROR;
+    }
+
+    return returnCode;
+}
+
+
 /**
 ****************************************************************************************************
 *   Addr2ComputeSurfaceCoordFromAddr
@@ -392,6 +392,258 @@ ADDR_E_RETURNCODE Lib::ComputeSurfaceAddrFromCoord(
     return returnCode;
 }
 
+/**
+************************************************************************************************************************
+*   Lib::ComputeSurfaceAddrFromRect
+*
+*   @brief
+*       Interface function stub of Addr2ComputeSurfaceAddrFromRect.
+*
+*   @return
+*       ADDR_E_RETURNCODE
+************************************************************************************************************************
+*/
+ADDR_E_RETURNCODE Lib::ComputeSurfaceAddrFromRect(
+    const ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT* pIn,    ///< [in] input structure
+    ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT*      pOut    ///< [out] output structure
+    ) const
+{
+    ADDR_E_RETURNCODE returnCode = ADDR_OK;
+
+    if (GetFillSizeFieldsFlags() == TRUE)
+    {
+        if ((pIn->size != sizeof(ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT)) ||
+            (pOut->size != sizeof(ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT)))
+        {
+            returnCode = ADDR_PARAMSIZEMISMATCH;
+        }
+    }
+
+    if ((returnCode == ADDR_OK) &&
+        (pOut->pAddr == NULL) &&
+        (pIn->width != 0) &&
+        (pIn->height != 0))
+    {
+        returnCode = ADDR_INVALIDPARAMS;
+    }
+
+    if ((returnCode == ADDR_OK) &&
+        (pIn->width != 0) &&
+        (pIn->height != 0))
+    {
+        // Mip levels other than the first may live in a mip tail, which isn't laid out as a grid
+        // of blocks. Tiny rectangles don't amortize the probing done by the block path.
+        if ((Max(pIn->coordIn.numMipLevels, 1u) > 1) ||
+            ((pIn->width * pIn->height) <= MinRectElementsByBlock))
+        {
+            returnCode = ComputeSurfaceAddrFromRectPerElement(pIn, pOut);
+        }
+        else
+        {
+            returnCode = ComputeSurfaceAddrFromRectByBlock(pIn, pOut);
+        }
+    }
+
+    return returnCode;
+}
+
+/**
+************************************************************************************************************************
+*   Lib::ComputeSurfaceAddrFromRectPerElement
+*
+*   @brief
+*       Internal function to calculate addresses of a rectangle, one element at a time
+*
+*   @return
+*       ADDR_E_RETURNCODE
+************************************************************************************************************************
+*/
+ADDR_E_RETURNCODE Lib::ComputeSurfaceAddrFromRectPerElement(
+    const ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT* pIn,    ///< [in] input structure
+    ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT*      pOut    ///< [out] output structure
+    ) const
+{
+    ADDR_E_RETURNCODE returnCode = ADDR_OK;
+
+    ADDR2_COMPUTE_SURFACE_ADDRFROMCOORD_INPUT  localIn  = pIn->coordIn;
+    ADDR2_COMPUTE_SURFACE_ADDRFROMCOORD_OUTPUT localOut = {0};
+
+    localIn.size  = sizeof(localIn);
+    localOut.size = sizeof(localOut);
+
+    for (UINT_32 j = 0; (j < pIn->height) && (returnCode == ADDR_OK); j++)
+    {
+        localIn.y = pIn->coordIn.y + j;
+
+        for (UINT_32 i = 0; (i < pIn->width) && (returnCode == ADDR_OK); i++)
+        {
+            localIn.x = pIn->coordIn.x + i;
+
+            returnCode = ComputeSurfaceAddrFromCoord(&localIn, &localOut);
+
+            pOut->pAddr[j * pIn->width + i] = localOut.addr;
+        }
+    }
+
+    return returnCode;
+}
+
+/**
+************************************************************************************************************************
+*   Lib::ComputeSurfaceAddrFromRectByBlock
+*
+*   @brief
+*       Internal function to calculate addresses of a rectangle in the first mip level.
+*
+*       Within one slice and sample, every swizzle mode places blocks on a regular grid and every
+*       bit of the offset inside a block is a xor of bits of x and y. Pipe and bank xor bits also
+*       use the coordinate bits above the block, so the address of (x, y) is
+*
+*           base + (x / blockWidth) * xStride + (y / blockHeight) * yStride + (xMask(x) ^ yMask(y))
+*
+*       where xMask and yMask are xors of one mask per coordinate bit. Those masks and the strides
+*       are probed from the per element path, so this gives the same results by construction. The
+*       column part is computed once for the rectangle and each row adds its own part on top.
+*       Linear surfaces are handled as 1x1 element blocks without xor masks.
+*
+*   @return
+*       ADDR_E_RETURNCODE
+************************************************************************************************************************
+*/
+ADDR_E_RETURNCODE Lib::ComputeSurfaceAddrFromRectByBlock(
+    const ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT* pIn,    ///< [in] input structure
+    ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT*      pOut    ///< [out] output structure
+    ) const
+{
+    ADDR_E_RETURNCODE returnCode = ADDR_OK;
+
+    ADDR2_COMPUTE_SURFACE_ADDRFROMCOORD_INPUT  localIn  = pIn->coordIn;
+    ADDR2_COMPUTE_SURFACE_ADDRFROMCOORD_OUTPUT localOut = {0};
+
+    localIn.size  = sizeof(localIn);
+    localOut.size = sizeof(localOut);
+
+    UINT_32 blkWidth    = 1;
+    UINT_32 blkHeight   = 1;
+    UINT_32 blkDepth    = 1;
+    UINT_32 blkSizeLog2 = 0;
+
+    if (IsLinear(localIn.swizzleMode) == FALSE)
+    {
+        returnCode = ComputeBlockDimensionForSurf(&blkWidth,
+                                                  &blkHeight,
+                                                  &blkDepth,
+                                                  localIn.bpp,
+                                                  Max(localIn.numFrags, 1u),
+                                                  localIn.resourceType,
+                                                  localIn.swizzleMode);
+        blkSizeLog2 = GetBlockSizeLog2(localIn.swizzleMode);
+    }
+
+    const UINT_32 blkWidthLog2  = Log2(blkWidth);
+    const UINT_32 blkHeightLog2 = Log2(blkHeight);
+    const UINT_64 blkMask       = (1ull << blkSizeLog2) - 1;
+    const UINT_32 xBits         = Log2NonPow2(pIn->coordIn.x + pIn->width - 1) + 1;
+    const UINT_32 yBits         = Log2NonPow2(pIn->coordIn.y + pIn->height - 1) + 1;
+
+    UINT_64 blk0Addr = 0;
+    UINT_64 xStride  = 0;
+    UINT_64 yStride  = 0;
+    UINT_32 blk0Xor  = 0;
+    UINT_32 xMask[MaxCoordBits];
+    UINT_32 yMask[MaxCoordBits];
+
+    // Probe the first block: its base, the xor of its first element and one mask per coordinate
+    // bit, then the strides to the next block to the right and to the next block below.
+    if (returnCode == ADDR_OK)
+    {
+        localIn.x  = 0;
+        localIn.y  = 0;
+        returnCode = ComputeSurfaceAddrFromCoord(&localIn, &localOut);
+        blk0Xor    = static_cast<UINT_32>(localOut.addr & blkMask);
+        blk0Addr   = localOut.addr - blk0Xor;
+    }
+
+    for (UINT_32 i = 0; (i < xBits) && (returnCode == ADDR_OK); i++)
+    {
+        localIn.x  = 1u << i;
+        returnCode = ComputeSurfaceAddrFromCoord(&localIn, &localOut);
+        xMask[i]   = static_cast<UINT_32>(localOut.addr & blkMask) ^ blk0Xor;
+    }
+
+    if (returnCode == ADDR_OK)
+    {
+        localIn.x  = blkWidth;
+        returnCode = ComputeSurfaceAddrFromCoord(&localIn, &localOut);
+        xStride    = (localOut.addr & ~blkMask) - blk0Addr;
+        localIn.x  = 0;
+    }
+
+    for (UINT_32 i = 0; (i < yBits) && (returnCode == ADDR_OK); i++)
+    {
+        localIn.y  = 1u << i;
+        returnCode = ComputeSurfaceAddrFromCoord(&localIn, &localOut);
+        yMask[i]   = static_cast<UINT_32>(localOut.addr & blkMask) ^ blk0Xor;
+    }
+
+    if (returnCode == ADDR_OK)
+    {
+        localIn.y  = blkHeight;
+        returnCode = ComputeSurfaceAddrFromCoord(&localIn, &localOut);
+        yStride    = (localOut.addr & ~blkMask) - blk0Addr;
+    }
+
+    if (returnCode == ADDR_OK)
+    {
+        // The column parts go into the last row of the output, which is written last. They are
+        // block aligned strides plus xor masks inside the block, so they can be split again with
+        // blkMask.
+        UINT_64* pCols = pOut->pAddr + (pIn->height - 1) * pIn->width;
+
+        for (UINT_32 i = 0; i < pIn->width; i++)
+        {
+            const UINT_32 x    = pIn->coordIn.x + i;
+            UINT_32       xXor = 0;
+
+            for (UINT_32 b = 0; b < xBits; b++)
+            {
+                if ((x >> b) & 1)
+                {
+                    xXor ^= xMask[b];
+                }
+            }
+
+            pCols[i] = (x >> blkWidthLog2) * xStride + xXor;
+        }
+
+        for (UINT_32 j = 0; j < pIn->height; j++)
+        {
+            const UINT_32 y       = pIn->coordIn.y + j;
+            const UINT_64 rowAddr = blk0Addr + (y >> blkHeightLog2) * yStride;
+            UINT_32       yXor    = blk0Xor;
+
+            for (UINT_32 b = 0; b < yBits; b++)
+            {
+                if ((y >> b) & 1)
+                {
+                    yXor ^= yMask[b];
+                }
+            }
+
+            UINT_64* pRow = pOut->pAddr + j * pIn->width;
+
+            for (UINT_32 i = 0; i < pIn->width; i++)
+            {
+                const UINT_64 col = pCols[i];
+
+                pRow[i] = rowAddr + (col & ~blkMask) + ((col & blkMask) ^ yXor);
+            }
+        }
+    }
+
+    return returnCode;
+}
+
 /**
 ************************************************************************************************************************
 *   Lib::ComputeSurfaceCoordFromAddr
@@ -226,6 +226,10 @@ public:
         const ADDR2_COMPUTE_SURFACE_ADDRFROMCOORD_INPUT* pIn,
         ADDR2_COMPUTE_SURFACE_ADDRFROMCOORD_OUTPUT*      pOut) const;
 
+    ADDR_E_RETURNCODE ComputeSurfaceAddrFromRect(
+        const ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT* pIn,
+        ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT*      pOut) const;
+
     ADDR_E_RETURNCODE ComputeSurfaceCoordFromAddr(
         const ADDR2_COMPUTE_SURFACE_COORDFROMADDR_INPUT* pIn,
         ADDR2_COMPUTE_SURFACE_COORDFROMADDR_OUTPUT*      pOut) const;
@@ -321,6 +325,11 @@ protected:
 
     static const UINT_32 MaxMipLevels = 16;
 
+    // Number of bits of a x/y coordinate
+    static const UINT_32 MaxCoordBits = 32;
+    // Rectangles up to this many elements are cheaper to compute element by element
+    static const UINT_32 MinRectElementsByBlock = 64;
+
     BOOL_32 IsValidSwMode(AddrSwizzleMode swizzleMode) const
     {
         // Don't dereference a reinterpret_cast pointer so as not to break
@@ -735,6 +744,14 @@ protected:
         const ADDR2_COMPUTE_SURFACE_ADDRFROMCOORD_INPUT* pIn,
         ADDR2_COMPUTE_SURFACE_ADDRFROMCOORD_OUTPUT*      pOut) const;
 
+    ADDR_E_RETURNCODE ComputeSurfaceAddrFromRectPerElement(
+        const ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT* pIn,
+        ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT*      pOut) const;
+
+    ADDR_E_RETURNCODE ComputeSurfaceAddrFromRectByBlock(
+        const ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT* pIn,
+        ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT*      pOut) const;
+
     ADDR_E_RETURNCODE ComputeSurfaceCoordFromAddrLinear(
         const ADDR2_COMPUTE_SURFACE_COORDFROMADDR_INPUT* pIn,
         ADDR2_COMPUTE_SURFACE_COORDFROMADDR_OUTPUT*      pOut) const;
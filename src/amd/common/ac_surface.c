@@ -35,8 +35,10 @@
 #include "sid.h"
 #include "util/hash_table.h"
 #include "util/macros.h"
+#include "util/ralloc.h"
 #include "util/simple_mtx.h"
 #include "util/u_atomic.h"
+#include "util/u_debug.h"
 #include "util/format/u_format.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
@@ -137,10 +139,176 @@ typedef uint64_t __u64;
 #define CIASICIDGFXENGINE_ARCTICISLAND 0x0000000D
 #endif
 
+/* Bound on the number of cached results of each kind, the caches are
+ * emptied when they reach it.
+ */
+#define AC_ADDRLIB_CACHE_SIZE 4096
+
+struct ac_addrlib_cache {
+   void *mem_ctx;
+   struct hash_table *table;
+   unsigned hits;
+   unsigned misses;
+};
+
 struct ac_addrlib {
    ADDR_HANDLE handle;
+
+   /* The same surfaces get computed over and over (e.g. when streaming
+    * textures), so the results of the expensive gfx9+ entrypoints are
+    * cached. Their inputs don't contain pointers and are fully
+    * initialized, so they can be hashed and compared as is.
+    */
+   simple_mtx_t cache_lock;
+   struct ac_addrlib_cache surface_info_cache;
+   struct ac_addrlib_cache swizzle_mode_cache;
+};
+
+struct ac_surface_info_cache_entry {
+   ADDR2_COMPUTE_SURFACE_INFO_INPUT in;
+   ADDR2_COMPUTE_SURFACE_INFO_OUTPUT out;
+   ADDR2_MIP_INFO mip_info[RADEON_SURF_MAX_LEVELS];
 };
 
+struct ac_swizzle_mode_cache_entry {
+   ADDR2_GET_PREFERRED_SURF_SETTING_INPUT in;
+   AddrSwizzleMode swizzle_mode;
+};
+
+static uint32_t surface_info_hash(const void *key)
+{
+   return _mesa_hash_data(key, sizeof(ADDR2_COMPUTE_SURFACE_INFO_INPUT));
+}
+
+static bool surface_info_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, sizeof(ADDR2_COMPUTE_SURFACE_INFO_INPUT)) == 0;
+}
+
+static uint32_t swizzle_mode_hash(const void *key)
+{
+   return _mesa_hash_data(key, sizeof(ADDR2_GET_PREFERRED_SURF_SETTING_INPUT));
+}
+
+static bool swizzle_mode_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, sizeof(ADDR2_GET_PREFERRED_SURF_SETTING_INPUT)) == 0;
+}
+
+static bool ac_addrlib_cache_init(struct ac_addrlib_cache *cache,
+                                  uint32_t (*hash)(const void *key),
+                                  bool (*equal)(const void *a, const void *b))
+{
+   cache->mem_ctx = ralloc_context(NULL);
+   cache->table = _mesa_hash_table_create(NULL, hash, equal);
+   return cache->mem_ctx && cache->table;
+}
+
+static void ac_addrlib_cache_finish(struct ac_addrlib_cache *cache, const char *name)
+{
+   if (debug_get_bool_option("AMD_PRINT_ADDRLIB_CACHE_STATS", false)) {
+      fprintf(stderr, "ac_addrlib: %s cache: %u hits, %u misses\n",
+              name, cache->hits, cache->misses);
+   }
+
+   _mesa_hash_table_destroy(cache->table, NULL);
+   ralloc_free(cache->mem_ctx);
+}
+
+/* Returns a new entry to fill and insert, it must start with the key. */
+static void *ac_addrlib_cache_alloc_entry(struct ac_addrlib_cache *cache, size_t entry_size)
+{
+   if (cache->table->entries >= AC_ADDRLIB_CACHE_SIZE) {
+      _mesa_hash_table_clear(cache->table, NULL);
+      ralloc_free(cache->mem_ctx);
+      cache->mem_ctx = ralloc_context(NULL);
+   }
+
+   return ralloc_size(cache->mem_ctx, entry_size);
+}
+
+static ADDR_E_RETURNCODE
+ac_addrlib_compute_surface_info(struct ac_addrlib *addrlib,
+                                const ADDR2_COMPUTE_SURFACE_INFO_INPUT *in,
+                                ADDR2_COMPUTE_SURFACE_INFO_OUTPUT *out)
+{
+   struct ac_addrlib_cache *cache = &addrlib->surface_info_cache;
+   ADDR2_MIP_INFO *mip_info = out->pMipInfo;
+   ADDR_E_RETURNCODE ret;
+
+   assert(mip_info && in->numMipLevels <= RADEON_SURF_MAX_LEVELS);
+
+   simple_mtx_lock(&addrlib->cache_lock);
+   struct hash_entry *he = _mesa_hash_table_search(cache->table, in);
+   if (he) {
+      const struct ac_surface_info_cache_entry *entry = he->data;
+      *out = entry->out;
+      out->pMipInfo = mip_info;
+      memcpy(mip_info, entry->mip_info, sizeof(entry->mip_info));
+      cache->hits++;
+      simple_mtx_unlock(&addrlib->cache_lock);
+      return ADDR_OK;
+   }
+   cache->misses++;
+   simple_mtx_unlock(&addrlib->cache_lock);
+
+   ret = Addr2ComputeSurfaceInfo(addrlib->handle, in, out);
+   if (ret != ADDR_OK)
+      return ret;
+
+   simple_mtx_lock(&addrlib->cache_lock);
+   struct ac_surface_info_cache_entry *entry =
+      ac_addrlib_cache_alloc_entry(cache, sizeof(*entry));
+   if (entry) {
+      entry->in = *in;
+      entry->out = *out;
+      entry->out.pMipInfo = NULL;
+      memcpy(entry->mip_info, mip_info, sizeof(entry->mip_info));
+      _mesa_hash_table_insert(cache->table, &entry->in, entry);
+   }
+   simple_mtx_unlock(&addrlib->cache_lock);
+   return ADDR_OK;
+}
+
+static ADDR_E_RETURNCODE
+ac_addrlib_get_preferred_swizzle_mode(struct ac_addrlib *addrlib,
+                                      const ADDR2_GET_PREFERRED_SURF_SETTING_INPUT *in,
+                                      AddrSwizzleMode *swizzle_mode)
+{
+   struct ac_addrlib_cache *cache = &addrlib->swizzle_mode_cache;
+   ADDR2_GET_PREFERRED_SURF_SETTING_OUTPUT out = {0};
+   ADDR_E_RETURNCODE ret;
+
+   simple_mtx_lock(&addrlib->cache_lock);
+   struct hash_entry *he = _mesa_hash_table_search(cache->table, in);
+   if (he) {
+      *swizzle_mode = ((const struct ac_swizzle_mode_cache_entry *)he->data)->swizzle_mode;
+      cache->hits++;
+      simple_mtx_unlock(&addrlib->cache_lock);
+      return ADDR_OK;
+   }
+   cache->misses++;
+   simple_mtx_unlock(&addrlib->cache_lock);
+
+   out.size = sizeof(ADDR2_GET_PREFERRED_SURF_SETTING_OUTPUT);
+   ret = Addr2GetPreferredSurfaceSetting(addrlib->handle, in, &out);
+   if (ret != ADDR_OK)
+      return ret;
+
+   *swizzle_mode = out.swizzleMode;
+
+   simple_mtx_lock(&addrlib->cache_lock);
+   struct ac_swizzle_mode_cache_entry *entry =
+      ac_addrlib_cache_alloc_entry(cache, sizeof(*entry));
+   if (entry) {
+      entry->in = *in;
+      entry->swizzle_mode = out.swizzleMode;
+      _mesa_hash_table_insert(cache->table, &entry->in, entry);
+   }
+   simple_mtx_unlock(&addrlib->cache_lock);
+   return ADDR_OK;
+}
+
 bool ac_modifier_has_dcc(uint64_t modifier)
 {
    return IS_AMD_FMT_MOD(modifier) && AMD_FMT_MOD_GET(DCC, modifier);
@@ -479,11 +647,22 @@ struct ac_addrlib *ac_addrlib_create(const struct radeon_info *info,
    }
 
    addrlib->handle = addrCreateOutput.hLib;
+   simple_mtx_init(&addrlib->cache_lock, mtx_plain);
+   if (!ac_addrlib_cache_init(&addrlib->surface_info_cache,
+                              surface_info_hash, surface_info_equal) ||
+       !ac_addrlib_cache_init(&addrlib->swizzle_mode_cache,
+                              swizzle_mode_hash, swizzle_mode_equal)) {
+      ac_addrlib_destroy(addrlib);
+      return NULL;
+   }
    return addrlib;
 }
 
 void ac_addrlib_destroy(struct ac_addrlib *addrlib)
 {
+   ac_addrlib_cache_finish(&addrlib->surface_info_cache, "surface info");
+   ac_addrlib_cache_finish(&addrlib->swizzle_mode_cache, "swizzle mode");
+   simple_mtx_destroy(&addrlib->cache_lock);
    AddrDestroy(addrlib->handle);
    free(addrlib);
 }
@@ -1326,17 +1505,16 @@ static int gfx6_compute_surface(ADDR_HANDLE addrlib, const struct radeon_info *i
 }
 
 /* This is only called when expecting a tiled layout. */
-static int gfx9_get_preferred_swizzle_mode(ADDR_HANDLE addrlib, const struct radeon_info *info,
+static int gfx9_get_preferred_swizzle_mode(struct ac_addrlib *addrlib, const struct radeon_info *info,
                                            struct radeon_surf *surf,
                                            ADDR2_COMPUTE_SURFACE_INFO_INPUT *in, bool is_fmask,
                                            AddrSwizzleMode *swizzle_mode)
 {
-   ADDR_E_RETURNCODE ret;
-   ADDR2_GET_PREFERRED_SURF_SETTING_INPUT sin = {0};
-   ADDR2_GET_PREFERRED_SURF_SETTING_OUTPUT sout = {0};
+   ADDR2_GET_PREFERRED_SURF_SETTING_INPUT sin;
 
+   /* Also clears the padding, the input is the key of the cache. */
+   memset(&sin, 0, sizeof(sin));
    sin.size = sizeof(ADDR2_GET_PREFERRED_SURF_SETTING_INPUT);
-   sout.size = sizeof(ADDR2_GET_PREFERRED_SURF_SETTING_OUTPUT);
 
    sin.flags = in->flags;
    sin.resourceType = in->resourceType;
@@ -1398,12 +1576,7 @@ static int gfx9_get_preferred_swizzle_mode(ADDR_HANDLE addrlib, const struct rad
       sin.preferredSwSet.sw_S = 1;
    }
 
-   ret = Addr2GetPreferredSurfaceSetting(addrlib, &sin, &sout);
-   if (ret != ADDR_OK)
-      return ret;
-
-   *swizzle_mode = sout.swizzleMode;
-   return 0;
+   return ac_addrlib_get_preferred_swizzle_mode(addrlib, &sin, swizzle_mode);
 }
 
 static bool is_dcc_supported_by_CB(const struct radeon_info *info, unsigned sw_mode)
@@ -1560,7 +1733,7 @@ static int gfx9_compute_miptree(struct ac_addrlib *addrlib, const struct radeon_
    out.size = sizeof(ADDR2_COMPUTE_SURFACE_INFO_OUTPUT);
    out.pMipInfo = mip_info;
 
-   ret = Addr2ComputeSurfaceInfo(addrlib->handle, in, &out);
+   ret = ac_addrlib_compute_surface_info(addrlib, in, &out);
    if (ret != ADDR_OK)
       return ret;
 
@@ -1859,7 +2032,7 @@ static int gfx9_compute_miptree(struct ac_addrlib *addrlib, const struct radeon_
          fin.size = sizeof(ADDR2_COMPUTE_FMASK_INFO_INPUT);
          fout.size = sizeof(ADDR2_COMPUTE_FMASK_INFO_OUTPUT);
 
-         ret = gfx9_get_preferred_swizzle_mode(addrlib->handle, info, surf, in, true, &fin.swizzleMode);
+         ret = gfx9_get_preferred_swizzle_mode(addrlib, info, surf, in, true, &fin.swizzleMode);
          if (ret != ADDR_OK)
             return ret;
 
@@ -2111,7 +2284,7 @@ static int gfx9_compute_surface(struct ac_addrlib *addrlib, const struct radeon_
             break;
          }
 
-         r = gfx9_get_preferred_swizzle_mode(addrlib->handle, info, surf, &AddrSurfInfoIn, false,
+         r = gfx9_get_preferred_swizzle_mode(addrlib, info, surf, &AddrSurfInfoIn, false,
                                              &AddrSurfInfoIn.swizzleMode);
          if (r)
             return r;
@@ -2160,7 +2333,7 @@ static int gfx9_compute_surface(struct ac_addrlib *addrlib, const struct radeon_
       AddrSurfInfoIn.format = ADDR_FMT_8;
 
       if (!AddrSurfInfoIn.flags.depth) {
-         r = gfx9_get_preferred_swizzle_mode(addrlib->handle, info, surf, &AddrSurfInfoIn, false,
+         r = gfx9_get_preferred_swizzle_mode(addrlib, info, surf, &AddrSurfInfoIn, false,
                                              &AddrSurfInfoIn.swizzleMode);
          if (r)
             return r;
@@ -159,6 +159,38 @@ void generate_hash(struct ac_addrlib *ac_addrlib,
                                                    false, false);
    }
 
+   /* The rectangle entrypoint has to match the per element one. */
+   ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_INPUT rect_input = {0};
+   rect_input.size = sizeof(rect_input);
+   rect_input.coordIn = input;
+   rect_input.coordIn.x = entry->w / 3;
+   rect_input.coordIn.y = entry->h / 3;
+   rect_input.width = MIN2(entry->w - rect_input.coordIn.x, 96);
+   rect_input.height = MIN2(entry->h - rect_input.coordIn.y, 32);
+
+   UINT_64 rect_addrs[96 * 32];
+   ADDR2_COMPUTE_SURFACE_ADDRFROMRECT_OUTPUT rect_output = {0};
+   rect_output.size = sizeof(rect_output);
+   rect_output.pAddr = rect_addrs;
+
+   ADDR_E_RETURNCODE rect_ret = Addr2ComputeSurfaceAddrFromRect(addrlib, &rect_input, &rect_output);
+   assert(rect_ret == ADDR_OK);
+
+   for (unsigned y = 0; y < rect_input.height; ++y) {
+      for (unsigned x = 0; x < rect_input.width; ++x) {
+         ADDR2_COMPUTE_SURFACE_ADDRFROMCOORD_INPUT coord_input = rect_input.coordIn;
+         coord_input.x += x;
+         coord_input.y += y;
+
+         ADDR2_COMPUTE_SURFACE_ADDRFROMCOORD_OUTPUT output = {0};
+         output.size = sizeof(output);
+
+         rect_ret = Addr2ComputeSurfaceAddrFromCoord(addrlib, &coord_input, &output);
+         assert(rect_ret == ADDR_OK);
+         assert(output.addr == rect_addrs[y * rect_input.width + x]);
+      }
+   }
+
    for (unsigned i = 0; i < 1000; ++i) {
       int32_t x, y;
       x = random();
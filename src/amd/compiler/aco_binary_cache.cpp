@@ -0,0 +1,198 @@
+/*
+ * Copyright © 2021 Valve Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include "aco_ir.h"
+#include "util/mesa-sha1.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+/*
+ * In-process cache of finished binaries, keyed on a hash of the program
+ * right after instruction selection. Shaders which only differ in NIR
+ * metadata usually select to the same program, so a cache hit skips
+ * everything from spilling to assembly.
+ */
+
+namespace aco {
+namespace {
+
+struct program_hasher {
+   struct mesa_sha1 ctx;
+
+   program_hasher() { _mesa_sha1_init(&ctx); }
+
+   template <typename T>
+   void add(T v) { _mesa_sha1_update(&ctx, &v, sizeof(T)); }
+
+   template <typename T>
+   void add_vector(const std::vector<T>& v)
+   {
+      add<uint32_t>(v.size());
+      _mesa_sha1_update(&ctx, v.data(), v.size() * sizeof(T));
+   }
+
+   void add_fp_mode(float_mode mode)
+   {
+      /* float_mode has padding bits, so add the fields individually */
+      add<uint8_t>(mode.val);
+      add<uint8_t>(mode.preserve_signed_zero_inf_nan32 |
+                   mode.preserve_signed_zero_inf_nan16_64 << 1 |
+                   mode.must_flush_denorms32 << 2 |
+                   mode.must_flush_denorms16_64 << 3 |
+                   mode.care_about_round32 << 4 |
+                   mode.care_about_round16_64 << 5);
+   }
+
+   void add_instr(const Instruction* instr)
+   {
+      /* Instructions are zero-initialized and their operands and definitions
+       * directly follow the format-specific data, so the whole allocation can
+       * be hashed at once. */
+      const uint8_t* begin = (const uint8_t*)instr;
+      const uint8_t* end = (const uint8_t*)instr->definitions.end();
+      add<uint32_t>(end - begin);
+      _mesa_sha1_update(&ctx, begin, end - begin);
+   }
+};
+
+struct key_hash {
+   std::size_t operator()(const binary_cache_key& key) const
+   {
+      std::size_t res;
+      memcpy(&res, key.data(), sizeof(res));
+      return res;
+   }
+};
+
+struct binary_cache {
+   static constexpr unsigned max_entries = 256;
+
+   std::mutex mutex;
+   /* most recently used entry first */
+   std::list<std::pair<binary_cache_key, binary_cache_entry>> entries;
+   std::unordered_map<binary_cache_key, decltype(entries)::iterator, key_hash> map;
+   uint64_t hits = 0;
+   uint64_t misses = 0;
+};
+
+binary_cache cache;
+
+} /* end namespace */
+
+binary_cache_key hash_program(Program* program, bool disable_optimizations)
+{
+   program_hasher h;
+
+   /* everything that changes what the remaining passes do */
+   h.add<uint32_t>(debug_flags);
+   h.add<bool>(disable_optimizations);
+   h.add<bool>(program->collect_statistics);
+
+   h.add<uint32_t>(program->chip_class);
+   h.add<uint32_t>(program->family);
+   h.add<uint32_t>(program->wave_size);
+   h.add<uint8_t>((uint8_t)program->stage.sw);
+   h.add<uint8_t>((uint8_t)program->stage.hw);
+   h.add<uint16_t>(program->num_waves);
+   h.add<uint16_t>(program->max_waves);
+   h.add<uint16_t>(program->min_waves);
+   h.add<uint32_t>(program->workgroup_size);
+   h.add<uint8_t>(program->wgp_mode | program->early_rast << 1 |
+                  program->needs_exact << 2 | program->needs_wqm << 3 |
+                  program->needs_vcc << 4 | program->needs_flat_scr << 5);
+   h.add<uint32_t>(program->private_segment_buffer.id());
+   h.add<uint32_t>(program->scratch_offset.id());
+   h.add<uint32_t>(program->tg_size.id());
+   h.add<uint32_t>(program->peekAllocationId());
+   h.add_vector(program->temp_rc);
+   h.add_vector(program->constant_data);
+   h.add<ac_shader_config>(*program->config);
+
+   h.add<uint32_t>(program->blocks.size());
+   for (const Block& block : program->blocks) {
+      h.add_fp_mode(block.fp_mode);
+      h.add<uint16_t>(block.kind);
+      h.add<uint16_t>(block.loop_nest_depth);
+      h.add<uint16_t>(block.divergent_if_logical_depth);
+      h.add<uint16_t>(block.uniform_if_depth);
+      h.add<int16_t>(block.register_demand.vgpr);
+      h.add<int16_t>(block.register_demand.sgpr);
+      h.add_vector(block.logical_preds);
+      h.add_vector(block.linear_preds);
+      h.add_vector(block.logical_succs);
+      h.add_vector(block.linear_succs);
+
+      h.add<uint32_t>(block.instructions.size());
+      for (const aco_ptr<Instruction>& instr : block.instructions)
+         h.add_instr(instr.get());
+   }
+
+   binary_cache_key key;
+   _mesa_sha1_final(&h.ctx, key.data());
+   return key;
+}
+
+bool binary_cache_lookup(const binary_cache_key& key, binary_cache_entry* entry)
+{
+   std::lock_guard<std::mutex> lock(cache.mutex);
+
+   auto it = cache.map.find(key);
+   if (it == cache.map.end()) {
+      cache.misses++;
+      return false;
+   }
+
+   cache.hits++;
+   cache.entries.splice(cache.entries.begin(), cache.entries, it->second);
+   *entry = it->second->second;
+   return true;
+}
+
+void binary_cache_insert(const binary_cache_key& key, binary_cache_entry entry)
+{
+   std::lock_guard<std::mutex> lock(cache.mutex);
+
+   /* another thread might have compiled the same program in the meantime */
+   if (cache.map.count(key))
+      return;
+
+   if (cache.entries.size() >= binary_cache::max_entries) {
+      cache.map.erase(cache.entries.back().first);
+      cache.entries.pop_back();
+   }
+
+   cache.entries.emplace_front(key, std::move(entry));
+   cache.map.emplace(key, cache.entries.begin());
+}
+
+void binary_cache_get_stats(uint64_t* hits, uint64_t* misses)
+{
+   std::lock_guard<std::mutex> lock(cache.mutex);
+   *hits = cache.hits;
+   *misses = cache.misses;
+}
+
+} /* end namespace aco */
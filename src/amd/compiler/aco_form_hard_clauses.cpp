@@ -36,6 +36,24 @@ enum clause_type
    clause_other,
 };
 
+clause_type get_clause_type(const Instruction *instr, unsigned *resource)
+{
+   *resource = 0;
+   if (instr->isVMEM() && !instr->operands.empty()) {
+      *resource = instr->operands[0].tempId();
+      return clause_vmem;
+   } else if (instr->isScratch() || instr->isGlobal()) {
+      return clause_vmem;
+   } else if (instr->isFlat()) {
+      return clause_flat;
+   } else if (instr->isSMEM() && !instr->operands.empty()) {
+      if (instr->operands[0].bytes() == 16)
+         *resource = instr->operands[0].tempId();
+      return clause_smem;
+   }
+   return clause_other;
+}
+
 void emit_clause(Builder& bld, unsigned num_instrs, aco_ptr<Instruction> *instrs)
 {
    unsigned start = 0;
@@ -58,6 +76,14 @@ void emit_clause(Builder& bld, unsigned num_instrs, aco_ptr<Instruction> *instrs
 
 } /* end namespace */
 
+bool should_form_clause(const Instruction *a, const Instruction *b)
+{
+   unsigned a_resource, b_resource;
+   clause_type a_type = get_clause_type(a, &a_resource);
+   clause_type b_type = get_clause_type(b, &b_resource);
+   return a_type != clause_other && a_type == b_type && a_resource == b_resource;
+}
+
 void form_hard_clauses(Program *program)
 {
    for (Block& block : program->blocks) {
@@ -73,20 +99,8 @@ void form_hard_clauses(Program *program)
       for (unsigned i = 0; i < block.instructions.size(); i++) {
          aco_ptr<Instruction>& instr = block.instructions[i];
 
-         unsigned resource = 0;
-         clause_type type = clause_other;
-         if (instr->isVMEM() && !instr->operands.empty()) {
-            resource = instr->operands[0].tempId();
-            type = clause_vmem;
-         } else if (instr->isScratch() || instr->isGlobal()) {
-            type = clause_vmem;
-         } else if (instr->isFlat()) {
-            type = clause_flat;
-         } else if (instr->isSMEM() && !instr->operands.empty()) {
-            type = clause_smem;
-            if (instr->operands[0].bytes() == 16)
-               resource = instr->operands[0].tempId();
-         }
+         unsigned resource;
+         clause_type type = get_clause_type(instr.get(), &resource);
 
          if (type != current_type || resource != current_resource || num_instrs == 64) {
             emit_clause(bld, num_instrs, current_instrs);
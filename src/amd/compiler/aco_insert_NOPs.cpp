@@ -201,6 +201,22 @@ bool regs_intersect(PhysReg a_reg, unsigned a_size, PhysReg b_reg, unsigned b_si
           (b_reg - a_reg < a_size);
 }
 
+/* Returns a bitset with size consecutive bits set, starting at start. Bits
+ * outside of the bitset are dropped. This allows to test and update whole
+ * register ranges a word at a time instead of bit by bit. */
+template <std::size_t N>
+std::bitset<N> bitset_range(unsigned start, unsigned size)
+{
+   if (start >= N || size == 0)
+      return std::bitset<N>();
+
+   std::bitset<N> res;
+   res.set();
+   res >>= N - MIN2(size, N - start);
+   res <<= start;
+   return res;
+}
+
 template <bool Valu, bool Vintrp, bool Salu>
 int handle_raw_hazard_internal(Program *program, Block *block,
                                int nops_needed, PhysReg reg, uint32_t mask)
@@ -253,6 +269,52 @@ void handle_raw_hazard(Program *program, Block *cur_block, int *NOPs, int min_st
    *NOPs = MAX2(*NOPs, res);
 }
 
+/* Same as handle_raw_hazard_internal(), but for any number of SGPRs at once,
+ * so that an instruction with several SGPR operands needs only one walk. */
+template <bool Valu, bool Vintrp, bool Salu>
+int handle_raw_hazard_sgprs_internal(Program *program, Block *block,
+                                     int nops_needed, std::bitset<128> mask)
+{
+   for (int pred_idx = block->instructions.size() - 1; pred_idx >= 0; pred_idx--) {
+      aco_ptr<Instruction>& pred = block->instructions[pred_idx];
+
+      std::bitset<128> writemask;
+      for (Definition& def : pred->definitions)
+         writemask |= bitset_range<128>(def.physReg(), def.size());
+      writemask &= mask;
+
+      bool is_hazard = writemask.any() &&
+                       ((pred->isVALU() && Valu) ||
+                        (pred->isVINTRP() && Vintrp) ||
+                        (pred->isSALU() && Salu));
+      if (is_hazard)
+         return nops_needed;
+
+      mask &= ~writemask;
+      nops_needed -= get_wait_states(pred);
+
+      if (nops_needed <= 0 || mask.none())
+         return 0;
+   }
+
+   int res = 0;
+   for (unsigned lin_pred : block->linear_preds) {
+      res = std::max(res, handle_raw_hazard_sgprs_internal<Valu, Vintrp, Salu>(
+         program, &program->blocks[lin_pred], nops_needed, mask));
+   }
+   return res;
+}
+
+template <bool Valu, bool Vintrp, bool Salu>
+void handle_raw_hazard_sgprs(Program *program, Block *cur_block, int *NOPs, int min_states,
+                             std::bitset<128> sgprs)
+{
+   if (*NOPs >= min_states || sgprs.none())
+      return;
+   int res = handle_raw_hazard_sgprs_internal<Valu, Vintrp, Salu>(program, cur_block, min_states, sgprs);
+   *NOPs = MAX2(*NOPs, res);
+}
+
 static auto handle_valu_then_read_hazard = handle_raw_hazard<true, true, false>;
 static auto handle_vintrp_then_read_hazard = handle_raw_hazard<false, true, false>;
 static auto handle_valu_salu_then_read_hazard = handle_raw_hazard<true, true, true>;
@@ -374,10 +436,9 @@ void handle_instruction_gfx6(Program *program, Block *cur_block, NOP_ctx_gfx6 &c
       }
 
       for (Definition def : instr->definitions) {
-         if (def.regClass().type() != RegType::sgpr) {
-            for (unsigned i = 0; i < def.size(); i++)
-               NOPs = MAX2(NOPs, ctx.vmem_store_then_wr_data[(def.physReg() & 0xff) + i]);
-         }
+         if (def.regClass().type() != RegType::sgpr &&
+             (ctx.vmem_store_then_wr_data & bitset_range<256>(def.physReg() & 0xff, def.size())).any())
+            NOPs = MAX2(NOPs, 1);
       }
 
       if ((instr->opcode == aco_opcode::v_readlane_b32 ||
@@ -403,10 +464,12 @@ void handle_instruction_gfx6(Program *program, Block *cur_block, NOP_ctx_gfx6 &c
          NOPs = MAX2(NOPs, ctx.valu_wr_vcc_then_div_fmas);
    } else if (instr->isVMEM() || instr->isFlatLike()) {
       /* If the VALU writes the SGPR that is used by a VMEM, the user must add five wait states. */
+      std::bitset<128> sgprs;
       for (Operand op : instr->operands) {
          if (!op.isConstant() && !op.isUndefined() && op.regClass().type() == RegType::sgpr)
-            handle_valu_then_read_hazard(program, cur_block, &NOPs, 5, op);
+            sgprs |= bitset_range<128>(op.physReg(), op.size());
       }
+      handle_raw_hazard_sgprs<true, true, false>(program, cur_block, &NOPs, 5, sgprs);
    }
 
    if (!instr->isSALU() && instr->format != Format::SMEM)
@@ -514,8 +577,7 @@ void handle_instruction_gfx6(Program *program, Block *cur_block, NOP_ctx_gfx6 &c
       if (consider_buf || consider_mimg || consider_flat) {
          PhysReg wrdata = instr->operands[consider_flat ? 2 : 3].physReg();
          unsigned size = instr->operands[consider_flat ? 2 : 3].size();
-         for (unsigned i = 0; i < size; i++)
-            ctx.vmem_store_then_wr_data[(wrdata & 0xff) + i] = 1;
+         ctx.vmem_store_then_wr_data |= bitset_range<256>(wrdata & 0xff, size);
       }
    }
 }
@@ -524,25 +586,15 @@ template <std::size_t N>
 bool check_written_regs(const aco_ptr<Instruction> &instr, const std::bitset<N> &check_regs)
 {
    return std::any_of(instr->definitions.begin(), instr->definitions.end(), [&check_regs](const Definition &def) -> bool {
-      bool writes_any = false;
-      for (unsigned i = 0; i < def.size(); i++) {
-         unsigned def_reg = def.physReg() + i;
-         writes_any |= def_reg < check_regs.size() && check_regs[def_reg];
-      }
-      return writes_any;
+      return (check_regs & bitset_range<N>(def.physReg(), def.size())).any();
    });
 }
 
 template <std::size_t N>
 void mark_read_regs(const aco_ptr<Instruction> &instr, std::bitset<N> &reg_reads)
 {
-   for (const Operand &op : instr->operands) {
-      for (unsigned i = 0; i < op.size(); i++) {
-         unsigned reg = op.physReg() + i;
-         if (reg < reg_reads.size())
-            reg_reads.set(reg);
-      }
-   }
+   for (const Operand &op : instr->operands)
+      reg_reads |= bitset_range<N>(op.physReg(), op.size());
 }
 
 bool VALU_writes_sgpr(aco_ptr<Instruction>& instr)
@@ -10887,6 +10887,8 @@ Pseudo_instruction *add_startpgm(struct isel_context *ctx)
     */
    ctx->program->private_segment_buffer = get_arg(ctx, ctx->args->ring_offsets);
    ctx->program->scratch_offset = get_arg(ctx, ctx->args->ac.scratch_offset);
+   if (ctx->stage == compute_cs && ctx->args->ac.tg_size.used)
+      ctx->program->tg_size = get_arg(ctx, ctx->args->ac.tg_size);
 
    return instr;
 }
@@ -28,6 +28,7 @@
 #include "nir_control_flow.h"
 #include "sid.h"
 #include "ac_exp_param.h"
+#include "c11/threads.h"
 
 namespace aco {
 
@@ -502,17 +503,54 @@ setup_variables(isel_context *ctx, nir_shader *nir)
    assert((ctx->program->config->lds_size * ctx->program->dev.lds_encoding_granule) <= ctx->program->dev.lds_limit);
 }
 
+/* NIR preparation which only depends on the shader itself, so that it can
+ * be run concurrently for the different parts of a merged shader. */
 void
-setup_nir(isel_context *ctx, nir_shader *nir)
+prepare_nir(nir_shader *nir)
 {
-   /* the variable setup has to be done before lower_io / CSE */
-   setup_variables(ctx, nir);
-
    nir_convert_to_lcssa(nir, true, false);
    nir_lower_phis_to_scalar(nir);
 
    nir_function_impl *func = nir_shader_get_entrypoint(nir);
    nir_index_ssa_defs(func);
+
+   nir_divergence_analysis(nir);
+   nir_opt_uniform_atomics(nir);
+}
+
+int
+prepare_nir_thread(void *data)
+{
+   prepare_nir((nir_shader *)data);
+   return 0;
+}
+
+void
+setup_nir(isel_context *ctx, unsigned shader_count, nir_shader *const *shaders)
+{
+   /* the variable setup has to be done before lower_io / CSE */
+   for (unsigned i = 0; i < shader_count; i++)
+      setup_variables(ctx, shaders[i]);
+
+   /* Prepare the later stages of merged shaders on separate threads while
+    * this thread takes care of the first one. */
+   thrd_t threads[2];
+   bool spawned[2] = {false, false};
+   assert(shader_count <= ARRAY_SIZE(threads) + 1);
+   if (ctx->options->parallel_isel) {
+      for (unsigned i = 1; i < shader_count; i++)
+         spawned[i - 1] = thrd_create(&threads[i - 1], prepare_nir_thread, shaders[i]) == thrd_success;
+   }
+
+   for (unsigned i = 0; i < shader_count; i++) {
+      if (i == 0 || !spawned[i - 1])
+         prepare_nir(shaders[i]);
+   }
+
+   for (unsigned i = 1; i < shader_count; i++) {
+      if (spawned[i - 1])
+         thrd_join(threads[i - 1], NULL);
+   }
 }
 
 } /* end namespace */
@@ -580,9 +618,6 @@ void init_context(isel_context *ctx, nir_shader *shader)
       ctx->ub_config.vertex_attrib_max[i] = max;
    }
 
-   nir_divergence_analysis(shader);
-   nir_opt_uniform_atomics(shader);
-
    fill_desc_set_info(ctx, impl);
 
    apply_nuw_to_offsets(ctx, impl);
@@ -1133,10 +1168,7 @@ setup_isel_context(Program* program,
       assert(shader_count == 1);
       setup_vs_output_info(&ctx, shaders[0], false, true, &args->shader_info->vs.outinfo);
    } else {
-      for (unsigned i = 0; i < shader_count; i++) {
-         nir_shader *nir = shaders[i];
-         setup_nir(&ctx, nir);
-      }
+      setup_nir(&ctx, shader_count, shaders);
 
       for (unsigned i = 0; i < shader_count; i++)
          scratch_size = std::max(scratch_size, shaders[i]->scratch_size);
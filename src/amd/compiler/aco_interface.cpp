@@ -24,6 +24,7 @@
 #include "aco_interface.h"
 #include "aco_ir.h"
 #include "util/memstream.h"
+#include "util/os_time.h"
 #include "vulkan/radv_shader.h"
 #include "vulkan/radv_shader_args.h"
 
@@ -39,16 +40,31 @@ static const std::array<aco_compiler_statistic_info, aco::num_statistics> statis
    ret[aco::statistic_branches] = aco_compiler_statistic_info{"Branches", "Branch instructions"};
    ret[aco::statistic_latency] = aco_compiler_statistic_info{"Latency", "Issue cycles plus stall cycles"};
    ret[aco::statistic_inv_throughput] = aco_compiler_statistic_info{"Inverse Throughput", "Estimated busy cycles to execute one wave"};
+   ret[aco::statistic_waitcnt_stalls] = aco_compiler_statistic_info{"Waitcnt Stalls", "Estimated stall cycles at s_waitcnt, weighted like Latency"};
    ret[aco::statistic_vmem_clauses] = aco_compiler_statistic_info{"VMEM Clause", "Number of VMEM clauses (includes 1-sized clauses)"};
    ret[aco::statistic_smem_clauses] = aco_compiler_statistic_info{"SMEM Clause", "Number of SMEM clauses (includes 1-sized clauses)"};
    ret[aco::statistic_sgpr_presched] = aco_compiler_statistic_info{"Pre-Sched SGPRs", "SGPR usage before scheduling"};
    ret[aco::statistic_vgpr_presched] = aco_compiler_statistic_info{"Pre-Sched VGPRs", "VGPR usage before scheduling"};
+   ret[aco::statistic_scratch_vgpr_spills] = aco_compiler_statistic_info{"Scratch VGPR Spills", "VGPR spill slots in scratch memory"};
+   ret[aco::statistic_lds_vgpr_spills] = aco_compiler_statistic_info{"LDS VGPR Spills", "VGPR spill slots in otherwise unused LDS"};
+   ret[aco::statistic_instr_arena] = aco_compiler_statistic_info{"Instruction Arena", "Peak bytes of memory reserved for instructions"};
+   ret[aco::statistic_spill_time] = aco_compiler_statistic_info{"Spill Time", "Microseconds spent in spilling and next-use analysis"};
+   ret[aco::statistic_isel_time] = aco_compiler_statistic_info{"ISel Time", "Microseconds spent in instruction selection"};
+   ret[aco::statistic_opt_time] = aco_compiler_statistic_info{"Opt Time", "Microseconds spent from phi lowering to exec mask insertion"};
+   ret[aco::statistic_sched_time] = aco_compiler_statistic_info{"Sched Time", "Microseconds spent in scheduling"};
+   ret[aco::statistic_ra_time] = aco_compiler_statistic_info{"RA Time", "Microseconds spent in register allocation and SSA elimination"};
+   ret[aco::statistic_lower_time] = aco_compiler_statistic_info{"Lowering Time", "Microseconds spent from HW lowering to assembly"};
    return ret;
 }();
 
 const unsigned aco_num_statistics = aco::num_statistics;
 const aco_compiler_statistic_info *aco_statistic_infos = statistic_infos.data();
 
+void aco_get_binary_cache_stats(uint64_t *hits, uint64_t *misses)
+{
+   aco::binary_cache_get_stats(hits, misses);
+}
+
 static void validate(aco::Program *program)
 {
    if (!(aco::debug_flags & aco::DEBUG_VALIDATE_IR))
@@ -58,6 +74,58 @@ static void validate(aco::Program *program)
    assert(is_valid);
 }
 
+/* Stores the microseconds since start in the statistic and returns the current time. */
+static int64_t record_time(aco::Program *program, aco::statistic stat, int64_t start)
+{
+   int64_t now = os_time_get_nano();
+   if (program->collect_statistics)
+      program->statistics[stat] = (now - start) / 1000;
+   return now;
+}
+
+static radv_shader_binary* create_binary(aco::Program* program, gl_shader_stage stage,
+                                         bool is_gs_copy_shader, const ac_shader_config& config,
+                                         const std::vector<uint32_t>& code, unsigned exec_size,
+                                         const std::string& llvm_ir, const std::string& disasm)
+{
+   size_t size = llvm_ir.size() + disasm.size();
+
+   size_t stats_size = 0;
+   if (program->collect_statistics)
+      stats_size = aco::num_statistics * sizeof(uint32_t);
+   size += stats_size;
+
+   size += code.size() * sizeof(uint32_t) + sizeof(radv_shader_binary_legacy);
+   /* We need to calloc to prevent unintialized data because this will be used
+    * directly for the disk cache. Uninitialized data can appear because of
+    * padding in the struct or because legacy_binary->data can be at an offset
+    * from the start less than sizeof(radv_shader_binary_legacy). */
+   radv_shader_binary_legacy* legacy_binary = (radv_shader_binary_legacy*) calloc(size, 1);
+
+   legacy_binary->base.type = RADV_BINARY_TYPE_LEGACY;
+   legacy_binary->base.stage = stage;
+   legacy_binary->base.is_gs_copy_shader = is_gs_copy_shader;
+   legacy_binary->base.total_size = size;
+
+   if (program->collect_statistics)
+      memcpy(legacy_binary->data, program->statistics, aco::num_statistics * sizeof(uint32_t));
+   legacy_binary->stats_size = stats_size;
+
+   memcpy(legacy_binary->data + legacy_binary->stats_size, code.data(), code.size() * sizeof(uint32_t));
+   legacy_binary->exec_size = exec_size;
+   legacy_binary->code_size = code.size() * sizeof(uint32_t);
+
+   legacy_binary->config = config;
+   legacy_binary->ir_size = llvm_ir.size();
+
+   llvm_ir.copy((char*) legacy_binary->data + legacy_binary->stats_size + legacy_binary->code_size, llvm_ir.size());
+
+   disasm.copy((char*) legacy_binary->data + legacy_binary->stats_size + legacy_binary->code_size + llvm_ir.size(), disasm.size());
+   legacy_binary->disasm_size = disasm.size();
+
+   return (radv_shader_binary*) legacy_binary;
+}
+
 void aco_compile_shader(unsigned shader_count,
                         struct nir_shader *const *shaders,
                         struct radv_shader_binary **binary,
@@ -75,6 +143,8 @@ void aco_compile_shader(unsigned shader_count,
    program->debug.func = args->options->debug.func;
    program->debug.private_data = args->options->debug.private_data;
 
+   int64_t time = os_time_get_nano();
+
    /* Instruction Selection */
    if (args->is_gs_copy_shader)
       aco::select_gs_copy_shader(program.get(), shaders[0], &config, args);
@@ -82,13 +152,39 @@ void aco_compile_shader(unsigned shader_count,
       aco::select_trap_handler_shader(program.get(), shaders[0], &config, args);
    else
       aco::select_program(program.get(), shader_count, shaders, &config, args);
+   record_time(program.get(), aco::statistic_isel_time, time);
    if (args->options->dump_preoptir) {
       std::cerr << "After Instruction Selection:\n";
       aco_print_program(program.get(), stderr);
    }
 
+   /* Identical programs produce identical binaries, so try to skip the rest
+    * of the compilation. Dumping needs the program, so don't use the cache
+    * in that case. */
+   bool get_disasm = args->options->dump_shader || args->options->record_ir;
+   bool use_cache = args->options->aco_binary_cache && !args->is_trap_handler_shader &&
+                    !get_disasm && !(aco::debug_flags & aco::DEBUG_PERF_INFO);
+   aco::binary_cache_key cache_key;
+   if (use_cache) {
+      cache_key = aco::hash_program(program.get(), args->options->disable_optimizations);
+
+      aco::binary_cache_entry entry;
+      if (aco::binary_cache_lookup(cache_key, &entry)) {
+         config = entry.config;
+         if (program->collect_statistics)
+            memcpy(program->statistics, entry.statistics.data(), sizeof(program->statistics));
+
+         *binary = create_binary(program.get(), shaders[shader_count - 1]->info.stage,
+                                 args->is_gs_copy_shader, config, entry.code, entry.exec_size,
+                                 std::string(), std::string());
+         return;
+      }
+   }
+
    aco::live live_vars;
    if (!args->is_trap_handler_shader) {
+      time = os_time_get_nano();
+
       /* Phi lowering */
       aco::lower_phis(program.get());
       aco::dominator_tree(program.get());
@@ -106,6 +202,7 @@ void aco_compile_shader(unsigned shader_count,
       aco::setup_reduce_temp(program.get());
       aco::insert_exec_mask(program.get());
       validate(program.get());
+      record_time(program.get(), aco::statistic_opt_time, time);
 
       /* spilling and scheduling */
       live_vars = aco::live_var_analysis(program.get());
@@ -135,10 +232,12 @@ void aco_compile_shader(unsigned shader_count,
       aco_print_program(program.get(), stderr, live_vars, aco::print_live_vars | aco::print_kill);
 
    if (!args->is_trap_handler_shader) {
+      time = os_time_get_nano();
       if (!args->options->disable_optimizations &&
           !(aco::debug_flags & aco::DEBUG_NO_SCHED))
          aco::schedule_program(program.get(), live_vars);
       validate(program.get());
+      time = record_time(program.get(), aco::statistic_sched_time, time);
 
       /* Register Allocation */
       aco::register_allocation(program.get(), live_vars.live_out);
@@ -156,8 +255,11 @@ void aco_compile_shader(unsigned shader_count,
       validate(program.get());
 
       aco::ssa_elimination(program.get());
+      record_time(program.get(), aco::statistic_ra_time, time);
    }
 
+   time = os_time_get_nano();
+
    /* Lower to HW Instructions */
    aco::lower_to_hw_instr(program.get());
 
@@ -174,13 +276,22 @@ void aco_compile_shader(unsigned shader_count,
    /* Assembly */
    std::vector<uint32_t> code;
    unsigned exec_size = aco::emit_program(program.get(), code);
+   record_time(program.get(), aco::statistic_lower_time, time);
 
-   if (program->collect_statistics)
+   if (program->collect_statistics) {
       aco::collect_postasm_stats(program.get(), code);
+      program->statistics[aco::statistic_instr_arena] = program->m.high_water();
+   }
 
-   bool get_disasm = args->options->dump_shader || args->options->record_ir;
-
-   size_t size = llvm_ir.size();
+   if (use_cache) {
+      aco::binary_cache_entry entry;
+      entry.code = code;
+      entry.exec_size = exec_size;
+      entry.config = config;
+      if (program->collect_statistics)
+         entry.statistics.assign(program->statistics, program->statistics + aco::num_statistics);
+      aco::binary_cache_insert(cache_key, std::move(entry));
+   }
 
    std::string disasm;
    if (get_disasm) {
@@ -195,45 +306,9 @@ void aco_compile_shader(unsigned shader_count,
       }
 
       disasm = std::string(data, data + disasm_size);
-      size += disasm_size;
       free(data);
    }
 
-   size_t stats_size = 0;
-   if (program->collect_statistics)
-      stats_size = aco::num_statistics * sizeof(uint32_t);
-   size += stats_size;
-
-   size += code.size() * sizeof(uint32_t) + sizeof(radv_shader_binary_legacy);
-   /* We need to calloc to prevent unintialized data because this will be used
-    * directly for the disk cache. Uninitialized data can appear because of
-    * padding in the struct or because legacy_binary->data can be at an offset
-    * from the start less than sizeof(radv_shader_binary_legacy). */
-   radv_shader_binary_legacy* legacy_binary = (radv_shader_binary_legacy*) calloc(size, 1);
-
-   legacy_binary->base.type = RADV_BINARY_TYPE_LEGACY;
-   legacy_binary->base.stage = shaders[shader_count-1]->info.stage;
-   legacy_binary->base.is_gs_copy_shader = args->is_gs_copy_shader;
-   legacy_binary->base.total_size = size;
-
-   if (program->collect_statistics)
-      memcpy(legacy_binary->data, program->statistics, aco::num_statistics * sizeof(uint32_t));
-   legacy_binary->stats_size = stats_size;
-
-   memcpy(legacy_binary->data + legacy_binary->stats_size, code.data(), code.size() * sizeof(uint32_t));
-   legacy_binary->exec_size = exec_size;
-   legacy_binary->code_size = code.size() * sizeof(uint32_t);
-
-   legacy_binary->config = config;
-   legacy_binary->disasm_size = 0;
-   legacy_binary->ir_size = llvm_ir.size();
-
-   llvm_ir.copy((char*) legacy_binary->data + legacy_binary->stats_size + legacy_binary->code_size, llvm_ir.size());
-
-   if (get_disasm) {
-      disasm.copy((char*) legacy_binary->data + legacy_binary->stats_size + legacy_binary->code_size + llvm_ir.size(), disasm.size());
-      legacy_binary->disasm_size = disasm.size();
-   }
-
-   *binary = (radv_shader_binary*) legacy_binary;
+   *binary = create_binary(program.get(), shaders[shader_count - 1]->info.stage,
+                           args->is_gs_copy_shader, config, code, exec_size, llvm_ir, disasm);
 }
@@ -45,6 +45,9 @@ void aco_compile_shader(unsigned shader_count,
                         struct radv_shader_binary** binary,
                         struct radv_shader_args *args);
 
+/* Returns the number of hits and misses of the in-process binary cache. */
+void aco_get_binary_cache_stats(uint64_t *hits, uint64_t *misses);
+
 #ifdef __cplusplus
 }
 #endif
@@ -30,6 +30,8 @@ namespace aco {
 
 uint64_t debug_flags = 0;
 
+thread_local monotonic_buffer_resource* instruction_buffer = nullptr;
+
 static const struct debug_control aco_debug_options[] = {
    {"validateir", DEBUG_VALIDATE_IR},
    {"validatera", DEBUG_VALIDATE_RA},
@@ -60,6 +62,18 @@ void init()
    call_once(&init_once_flag, init_once);
 }
 
+Program::Program()
+{
+   /* Instructions created on this thread from now on belong to this program. */
+   instruction_buffer = &m;
+}
+
+Program::~Program()
+{
+   if (instruction_buffer == &m)
+      instruction_buffer = nullptr;
+}
+
 void init_program(Program *program, Stage stage, struct radv_shader_info *info,
                   enum chip_class chip_class, enum radeon_family family,
                   bool wgp_mode, ac_shader_config *config)
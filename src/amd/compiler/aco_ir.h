@@ -26,6 +26,7 @@
 #define ACO_IR_H
 
 #include <algorithm>
+#include <array>
 #include <vector>
 #include <set>
 #include <unordered_set>
@@ -1540,9 +1541,15 @@ struct Pseudo_reduction_instruction : public Instruction {
 };
 static_assert(sizeof(Pseudo_reduction_instruction) == sizeof(Instruction) + 4, "Unexpected padding");
 
+/* Instructions are allocated from the arena of the Program which is being
+ * compiled on the current thread and freed all at once together with the
+ * Program, so deleting an individual instruction is a no-op.
+ */
+extern thread_local monotonic_buffer_resource* instruction_buffer;
+
 struct instr_deleter_functor {
    void operator()(void* p) {
-      free(p);
+      /* memory is released together with the Program's arena */
    }
 };
 
@@ -1553,7 +1560,9 @@ template<typename T>
 T* create_instruction(aco_opcode opcode, Format format, uint32_t num_operands, uint32_t num_definitions)
 {
    std::size_t size = sizeof(T) + num_operands * sizeof(Operand) + num_definitions * sizeof(Definition);
-   char *data = (char*) calloc(1, size);
+   assert(instruction_buffer);
+   char *data = (char*) instruction_buffer->allocate(size, alignof(T));
+   memset(data, 0, size);
    T* inst = (T*) data;
 
    inst->opcode = opcode;
@@ -1834,10 +1843,20 @@ enum statistic {
    statistic_branches,
    statistic_latency,
    statistic_inv_throughput,
+   statistic_waitcnt_stalls,
    statistic_vmem_clauses,
    statistic_smem_clauses,
    statistic_sgpr_presched,
    statistic_vgpr_presched,
+   statistic_scratch_vgpr_spills,
+   statistic_lds_vgpr_spills,
+   statistic_instr_arena,
+   statistic_spill_time,
+   statistic_isel_time,
+   statistic_opt_time,
+   statistic_sched_time,
+   statistic_ra_time,
+   statistic_lower_time,
    num_statistics
 };
 
@@ -1861,6 +1880,13 @@ struct DeviceInfo {
 
 class Program final {
 public:
+   Program();
+   ~Program();
+   Program(const Program&) = delete;
+   Program& operator=(const Program&) = delete;
+
+   /* backing memory for all instructions of this program */
+   monotonic_buffer_resource m{65536};
    std::vector<Block> blocks;
    std::vector<RegClass> temp_rc = {s1};
    RegisterDemand max_reg_demand = RegisterDemand();
@@ -1880,6 +1906,7 @@ public:
    std::vector<uint8_t> constant_data;
    Temp private_segment_buffer;
    Temp scratch_offset;
+   Temp tg_size; /* compute shaders only, if the shader has the argument */
 
    uint16_t min_waves = 0;
    unsigned workgroup_size; /* if known; otherwise UINT_MAX */
@@ -1982,8 +2009,15 @@ void select_trap_handler_shader(Program *program, struct nir_shader *shader,
 
 void lower_phis(Program* program);
 void calc_min_waves(Program* program);
+/* maximum number of waves per SIMD allowed by the workgroup size and lds_bytes of LDS per workgroup */
+uint16_t calc_max_waves(Program* program, unsigned lds_bytes);
 void update_vgpr_sgpr_demand(Program* program, const RegisterDemand new_demand);
 live live_var_analysis(Program* program);
+/* Updates live_vars after instructions were changed in modified_blocks only.
+ * The live-in sets of all blocks must be the same as before, which is the case
+ * e.g. if only phi operands and copies at the end of blocks were changed. */
+void update_live_var_analysis(Program* program, live& live_vars,
+                              const std::vector<bool>& modified_blocks);
 std::vector<uint16_t> dead_code_analysis(Program *program);
 void dominator_tree(Program* program);
 void insert_exec_mask(Program *program);
@@ -1999,6 +2033,8 @@ void schedule_program(Program* program, live& live_vars);
 void spill(Program* program, live& live_vars);
 void insert_wait_states(Program* program);
 void insert_NOPs(Program* program);
+/* whether form_hard_clauses() would put a and b into the same clause if they were adjacent */
+bool should_form_clause(const Instruction *a, const Instruction *b);
 void form_hard_clauses(Program *program);
 unsigned emit_program(Program* program, std::vector<uint32_t>& code);
 bool print_asm(Program *program, std::vector<uint32_t>& binary,
@@ -2015,6 +2051,20 @@ void collect_presched_stats(Program *program);
 void collect_preasm_stats(Program *program);
 void collect_postasm_stats(Program *program, const std::vector<uint32_t>& code);
 
+/* in-process cache of finished binaries, keyed on the program after isel */
+typedef std::array<uint8_t, 20> binary_cache_key;
+struct binary_cache_entry {
+   std::vector<uint32_t> code;
+   unsigned exec_size;
+   ac_shader_config config;
+   std::vector<uint32_t> statistics;
+};
+
+binary_cache_key hash_program(Program* program, bool disable_optimizations);
+bool binary_cache_lookup(const binary_cache_key& key, binary_cache_entry* entry);
+void binary_cache_insert(const binary_cache_key& key, binary_cache_entry entry);
+void binary_cache_get_stats(uint64_t* hits, uint64_t* misses);
+
 enum print_flags {
    print_no_ssa = 0x1,
    print_perf_info = 0x2,
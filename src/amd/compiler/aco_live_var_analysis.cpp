@@ -30,6 +30,7 @@
 #include "aco_ir.h"
 #include "util/u_math.h"
 
+#include <algorithm>
 #include <set>
 #include <vector>
 
@@ -319,12 +320,30 @@ void calc_min_waves(Program* program)
    program->min_waves = DIV_ROUND_UP(waves_per_workgroup, simd_per_cu_wgp);
 }
 
-void update_vgpr_sgpr_demand(Program* program, const RegisterDemand new_demand)
+uint16_t calc_max_waves(Program* program, unsigned lds_bytes)
 {
    unsigned max_waves_per_simd = program->dev.max_wave64_per_simd * (64 / program->wave_size);
    unsigned simd_per_cu_wgp = program->dev.simd_per_cu * (program->wgp_mode ? 2 : 1);
    unsigned lds_limit = program->wgp_mode ? program->dev.lds_limit * 2 : program->dev.lds_limit;
 
+   /* adjust max_waves for workgroup and LDS limits */
+   unsigned waves_per_workgroup = calc_waves_per_workgroup(program);
+   unsigned workgroups_per_cu_wgp = max_waves_per_simd * simd_per_cu_wgp / waves_per_workgroup;
+   if (lds_bytes) {
+      unsigned lds = align(lds_bytes, program->dev.lds_alloc_granule);
+      workgroups_per_cu_wgp = std::min(workgroups_per_cu_wgp, lds_limit / lds);
+   }
+   if (waves_per_workgroup > 1 && program->chip_class < GFX10)
+      workgroups_per_cu_wgp = std::min(workgroups_per_cu_wgp, 16u); /* TODO: is this a SI-only limit? what about Navi? */
+
+   /* in cases like waves_per_workgroup=3 or lds=65536 and
+    * waves_per_workgroup=1, we want the maximum possible number of waves per
+    * SIMD and not the minimum. so DIV_ROUND_UP is used */
+   return std::min<uint16_t>(max_waves_per_simd, DIV_ROUND_UP(workgroups_per_cu_wgp * waves_per_workgroup, simd_per_cu_wgp));
+}
+
+void update_vgpr_sgpr_demand(Program* program, const RegisterDemand new_demand)
+{
    assert(program->min_waves >= 1);
    uint16_t sgpr_limit = get_addr_sgpr_from_waves(program, program->min_waves);
    uint16_t vgpr_limit = get_addr_vgpr_from_waves(program, program->min_waves);
@@ -337,23 +356,7 @@ void update_vgpr_sgpr_demand(Program* program, const RegisterDemand new_demand)
       program->num_waves = program->dev.physical_sgprs / get_sgpr_alloc(program, new_demand.sgpr);
       uint16_t vgpr_demand = get_vgpr_alloc(program, new_demand.vgpr) + program->config->num_shared_vgprs / 2;
       program->num_waves = std::min<uint16_t>(program->num_waves, program->dev.physical_vgprs / vgpr_demand);
-      program->max_waves = max_waves_per_simd;
-
-      /* adjust max_waves for workgroup and LDS limits */
-      unsigned waves_per_workgroup = calc_waves_per_workgroup(program);
-      unsigned workgroups_per_cu_wgp = max_waves_per_simd * simd_per_cu_wgp / waves_per_workgroup;
-      if (program->config->lds_size) {
-         unsigned lds = program->config->lds_size * program->dev.lds_encoding_granule;
-         lds = align(lds, program->dev.lds_alloc_granule);
-         workgroups_per_cu_wgp = std::min(workgroups_per_cu_wgp, lds_limit / lds);
-      }
-      if (waves_per_workgroup > 1 && program->chip_class < GFX10)
-         workgroups_per_cu_wgp = std::min(workgroups_per_cu_wgp, 16u); /* TODO: is this a SI-only limit? what about Navi? */
-
-      /* in cases like waves_per_workgroup=3 or lds=65536 and
-       * waves_per_workgroup=1, we want the maximum possible number of waves per
-       * SIMD and not the minimum. so DIV_ROUND_UP is used */
-      program->max_waves = std::min<uint16_t>(program->max_waves, DIV_ROUND_UP(workgroups_per_cu_wgp * waves_per_workgroup, simd_per_cu_wgp));
+      program->max_waves = calc_max_waves(program, program->config->lds_size * program->dev.lds_encoding_granule);
 
       /* incorporate max_waves and calculate max_reg_demand */
       program->num_waves = std::min<uint16_t>(program->num_waves, program->max_waves);
@@ -390,5 +393,67 @@ live live_var_analysis(Program* program)
    return result;
 }
 
+void update_live_var_analysis(Program* program, live& live_vars,
+                              const std::vector<bool>& modified_blocks)
+{
+   assert(modified_blocks.size() == program->blocks.size());
+   assert(live_vars.live_out.size() == program->blocks.size());
+   std::set<unsigned> worklist;
+   std::vector<uint16_t> phi_sgpr_ops(program->blocks.size());
+
+   /* The live-out sets of the modified blocks might contain stale entries:
+    * rebuild them from the live-in sets and phi operands of their successors,
+    * which are therefore processed again, too. */
+   for (Block& block : program->blocks) {
+      if (!modified_blocks[block.index])
+         continue;
+      live_vars.live_out[block.index] = IDSet();
+      worklist.insert(block.index);
+      for (unsigned succ : block.linear_succs)
+         worklist.insert(succ);
+      for (unsigned succ : block.logical_succs)
+         worklist.insert(succ);
+   }
+
+   /* phi_sgpr_ops is only accumulated when phi operands are newly inserted
+    * into a live-out set, so compute it upfront for unmodified blocks which
+    * are processed again. */
+   for (unsigned block_idx : worklist) {
+      Block& block = program->blocks[block_idx];
+      if (modified_blocks[block_idx])
+         continue;
+
+      IDSet sgpr_phi_ops{};
+      for (unsigned succ_idx : block.logical_succs) {
+         Block& succ = program->blocks[succ_idx];
+         unsigned pred_idx = std::find(succ.logical_preds.begin(), succ.logical_preds.end(), block_idx) -
+                             succ.logical_preds.begin();
+         for (aco_ptr<Instruction>& phi : succ.instructions) {
+            if (!is_phi(phi))
+               break;
+            if (phi->opcode != aco_opcode::p_phi)
+               continue;
+            const Operand& op = phi->operands[pred_idx];
+            if (op.isTemp() && op.getTemp().type() == RegType::sgpr && sgpr_phi_ops.insert(op.tempId()).second)
+               phi_sgpr_ops[block_idx] += op.size();
+         }
+      }
+   }
+
+   while (!worklist.empty()) {
+      std::set<unsigned>::reverse_iterator b_it = worklist.rbegin();
+      unsigned block_idx = *b_it;
+      worklist.erase(block_idx);
+      process_live_temps_per_block(program, live_vars, &program->blocks[block_idx], worklist, phi_sgpr_ops);
+   }
+
+   RegisterDemand new_demand;
+   for (Block& block : program->blocks)
+      new_demand.update(block.register_demand);
+
+   /* calculate the program's register demand and number of waves */
+   update_vgpr_sgpr_demand(program, new_demand);
+}
+
 }
 
@@ -519,8 +519,13 @@ void lower_to_cssa(Program* program, live& live_vars)
    collect_parallelcopies(ctx);
    emit_parallelcopies(ctx);
 
-   /* update live variable information */
-   live_vars = live_var_analysis(program);
+   /* Update live variable information: Only the blocks which got parallelcopies
+    * (and the phis of their successors) have changed. The copies read values
+    * which were already live-out, so the live-in sets remain the same. */
+   std::vector<bool> modified_blocks(program->blocks.size());
+   for (unsigned i = 0; i < program->blocks.size(); i++)
+      modified_blocks[i] = !ctx.parallelcopies[i].empty();
+   update_live_var_analysis(program, live_vars, modified_blocks);
 }
 }
 
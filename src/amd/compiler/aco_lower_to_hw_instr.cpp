@@ -1285,6 +1285,24 @@ void do_pack_2x16(lower_context *ctx, Builder& bld, Definition def, Operand lo,
       return;
    }
 
+   /* v_perm_b32 can select both halves at once, but the selector has to be a
+    * literal, and a literal and two different SGPRs exceed the constant bus
+    * limit */
+   if (ctx->program->chip_class >= GFX10 &&
+       (lo.physReg().reg() >= 256 || hi.physReg().reg() >= 256 ||
+        lo.physReg().reg() == hi.physReg().reg())) {
+      /* bytes 0-3 select from src1, 4-7 select from src0 */
+      uint32_t lo_sel = lo.physReg().byte() | ((lo.physReg().byte() + 1) << 8);
+      uint32_t hi_sel = (hi.physReg().byte() + 4) | ((hi.physReg().byte() + 5) << 8);
+      PhysReg hi_reg = PhysReg(hi.physReg().reg());
+      PhysReg lo_reg = PhysReg(lo.physReg().reg());
+      bld.vop3(aco_opcode::v_perm_b32, def,
+               Operand(hi_reg, hi_reg.reg() >= 256 ? v1 : s1),
+               Operand(lo_reg, lo_reg.reg() >= 256 ? v1 : s1),
+               Operand(lo_sel | (hi_sel << 16)));
+      return;
+   }
+
    if (lo.physReg().reg() == def.physReg().reg()) {
       /* lo is in the high bits of def */
       assert(lo.physReg().byte() == 2);
@@ -22,9 +22,9 @@
  *
  */
 
-#include <map>
-#include <unordered_map>
+#include <vector>
 #include "aco_ir.h"
+#include "util/u_math.h"
 
 /*
  * Implements the algorithm for dominator-tree value numbering
@@ -329,12 +329,46 @@ struct InstrPred {
    }
 };
 
-using expr_set = std::unordered_map<Instruction*, uint32_t, InstrHash, InstrPred>;
+/* Open-addressing hash table of the available expressions, mapping each one
+ * to the block it was found in.  Value numbering never creates instructions
+ * and only ever replaces entries, so the table is sized once for every
+ * instruction of the program and never has to grow or delete.
+ */
+struct expr_set {
+   struct entry {
+      Instruction* instr;
+      uint32_t hash;
+      uint32_t block;
+   };
+
+   std::vector<entry> slots;
+   uint32_t mask = 0;
+
+   void init(unsigned num_instrs)
+   {
+      unsigned size = util_next_power_of_two(std::max(num_instrs * 2, 16u));
+      slots.assign(size, entry{nullptr, 0, 0});
+      mask = size - 1;
+   }
+
+   /* Returns the entry of an expression equal to instr,
+    * or the empty entry where it should be inserted. */
+   entry& lookup(Instruction* instr, uint32_t hash)
+   {
+      InstrPred pred;
+      for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+         entry& e = slots[i];
+         if (!e.instr || (e.hash == hash && pred(e.instr, instr)))
+            return e;
+      }
+   }
+};
 
 struct vn_ctx {
    Program* program;
    expr_set expr_values;
-   std::map<uint32_t, Temp> renames;
+   /* renamed temporaries, indexed by temp id (an id of 0 means not renamed) */
+   std::vector<Temp> renames;
 
    /* The exec id should be the same on the same level of control flow depth.
     * Together with the check for dominator relations, it is safe to assume
@@ -348,7 +382,8 @@ struct vn_ctx {
       unsigned size = 0;
       for (Block& block : program->blocks)
          size += block.instructions.size();
-      expr_values.reserve(size);
+      expr_values.init(size);
+      renames.resize(program->peekAllocationId());
    }
 };
 
@@ -416,11 +451,8 @@ void process_block(vn_ctx& ctx, Block& block)
    for (aco_ptr<Instruction>& instr : block.instructions) {
       /* first, rename operands */
       for (Operand& op : instr->operands) {
-         if (!op.isTemp())
-            continue;
-         auto it = ctx.renames.find(op.tempId());
-         if (it != ctx.renames.end())
-            op.setTemp(it->second);
+         if (op.isTemp() && ctx.renames[op.tempId()].id())
+            op.setTemp(ctx.renames[op.tempId()]);
       }
 
       if (instr->opcode == aco_opcode::p_discard_if ||
@@ -442,15 +474,16 @@ void process_block(vn_ctx& ctx, Block& block)
       }
 
       instr->pass_flags = ctx.exec_id;
-      std::pair<expr_set::iterator, bool> res = ctx.expr_values.emplace(instr.get(), block.index);
+      uint32_t hash = InstrHash()(instr.get());
+      expr_set::entry& res = ctx.expr_values.lookup(instr.get(), hash);
 
       /* if there was already an expression with the same value number */
-      if (!res.second) {
-         Instruction* orig_instr = res.first->first;
+      if (res.instr) {
+         Instruction* orig_instr = res.instr;
          assert(instr->definitions.size() == orig_instr->definitions.size());
          /* check if the original instruction dominates the current one */
-         if (dominates(ctx, res.first->second, block.index) &&
-             ctx.program->blocks[res.first->second].fp_mode.canReplace(block.fp_mode)) {
+         if (dominates(ctx, res.block, block.index) &&
+             ctx.program->blocks[res.block].fp_mode.canReplace(block.fp_mode)) {
             for (unsigned i = 0; i < instr->definitions.size(); i++) {
                assert(instr->definitions[i].regClass() == orig_instr->definitions[i].regClass());
                assert(instr->definitions[i].isTemp());
@@ -465,11 +498,12 @@ void process_block(vn_ctx& ctx, Block& block)
                   orig_instr->definitions[i].setNUW(true);
             }
          } else {
-            ctx.expr_values.erase(res.first);
-            ctx.expr_values.emplace(instr.get(), block.index);
+            res.instr = instr.get();
+            res.block = block.index;
             new_instructions.emplace_back(std::move(instr));
          }
       } else {
+         res = expr_set::entry{instr.get(), hash, block.index};
          new_instructions.emplace_back(std::move(instr));
       }
    }
@@ -477,18 +511,15 @@ void process_block(vn_ctx& ctx, Block& block)
    block.instructions = std::move(new_instructions);
 }
 
-void rename_phi_operands(Block& block, std::map<uint32_t, Temp>& renames)
+void rename_phi_operands(Block& block, std::vector<Temp>& renames)
 {
    for (aco_ptr<Instruction>& phi : block.instructions) {
       if (phi->opcode != aco_opcode::p_phi && phi->opcode != aco_opcode::p_linear_phi)
          break;
 
       for (Operand& op : phi->operands) {
-         if (!op.isTemp())
-            continue;
-         auto it = renames.find(op.tempId());
-         if (it != renames.end())
-            op.setTemp(it->second);
+         if (op.isTemp() && renames[op.tempId()].id())
+            op.setTemp(renames[op.tempId()]);
       }
    }
 }
@@ -99,7 +99,9 @@ enum Label {
    label_omod2 = 1 << 8,
    label_omod4 = 1 << 9,
    label_omod5 = 1 << 10,
+   label_vop3p = 1 << 11,
    label_clamp = 1 << 12,
+   label_canonicalized = 1 << 13,
    label_undefined = 1 << 14,
    label_vcc = 1 << 15,
    label_b2f = 1 << 16,
@@ -117,29 +119,49 @@ enum Label {
    label_fcanonicalize = 1 << 28,
    label_constant_16bit = 1 << 29,
    label_usedef = 1 << 30, /* generic label */
-   label_vop3p = 1ull << 31, /* 1ull to prevent sign extension */
-   label_canonicalized = 1ull << 32,
 };
 
-static constexpr uint64_t instr_usedef_labels = label_vec | label_mul | label_mad | label_add_sub | label_vop3p |
+static constexpr uint32_t instr_usedef_labels = label_vec | label_mul | label_mad | label_add_sub | label_vop3p |
                                                 label_bitwise | label_uniform_bitwise | label_minmax | label_vopc | label_usedef;
-static constexpr uint64_t instr_mod_labels = label_omod2 | label_omod4 | label_omod5 | label_clamp;
+static constexpr uint32_t instr_mod_labels = label_omod2 | label_omod4 | label_omod5 | label_clamp;
 
-static constexpr uint64_t instr_labels = instr_usedef_labels | instr_mod_labels;
-static constexpr uint64_t temp_labels = label_abs | label_neg | label_temp | label_vcc | label_b2f | label_uniform_bool |
+static constexpr uint32_t instr_labels = instr_usedef_labels | instr_mod_labels;
+static constexpr uint32_t temp_labels = label_abs | label_neg | label_temp | label_vcc | label_b2f | label_uniform_bool |
                                         label_scc_invert | label_b2i | label_fcanonicalize;
 static constexpr uint32_t val_labels = label_constant_32bit | label_constant_64bit | label_constant_16bit | label_literal;
 
 static_assert((instr_labels & temp_labels) == 0, "labels cannot intersect");
 static_assert((instr_labels & val_labels) == 0, "labels cannot intersect");
 static_assert((temp_labels & val_labels) == 0, "labels cannot intersect");
+static_assert(label_usedef < (1u << 31), "labels have to fit into 32 bits");
 
+/* Instruction pointers referenced by ssa_info, owned by optimize(). */
+static thread_local std::vector<Instruction*>* instr_table;
+
+/* An instruction pointer stored as a 32-bit index into instr_table. */
+struct instr_ref {
+   uint32_t idx;
+
+   instr_ref& operator=(Instruction* instr)
+   {
+      if (instr_table->empty() || instr_table->back() != instr)
+         instr_table->push_back(instr);
+      idx = instr_table->size() - 1;
+      return *this;
+   }
+
+   operator Instruction*() const { return (*instr_table)[idx]; }
+   Instruction* operator->() const { return (*instr_table)[idx]; }
+};
+
+/* There is one of these for every temporary, so keep it small: the labels
+ * fit into 32 bits and instruction pointers are stored in a side table. */
 struct ssa_info {
-   uint64_t label;
+   uint32_t label;
    union {
       uint32_t val;
       Temp temp;
-      Instruction* instr;
+      instr_ref instr;
    };
 
    ssa_info() : label(0) {}
@@ -3672,6 +3694,8 @@ void optimize(Program* program)
    ctx.program = program;
    std::vector<ssa_info> info(program->peekAllocationId());
    ctx.info = info.data();
+   std::vector<Instruction*> instrs;
+   instr_table = &instrs;
 
    /* 1. Bottom-Up DAG pass (forward) to label all ssa-defs */
    for (Block& block : program->blocks) {
@@ -3706,6 +3730,7 @@ void optimize(Program* program)
       block.instructions.swap(ctx.instructions);
    }
 
+   instr_table = nullptr;
 }
 
 }
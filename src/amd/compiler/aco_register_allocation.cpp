@@ -826,55 +826,66 @@ std::pair<PhysReg, bool> get_reg_simple(ra_ctx& ctx,
    return {{}, false};
 }
 
-/* collect variables from a register area and clear reg_file */
-std::set<std::pair<unsigned, unsigned>> find_vars(ra_ctx& ctx, RegisterFile& reg_file,
-                                                  const PhysRegInterval reg_interval)
+/* collect variables from a register area */
+std::vector<unsigned> find_vars(ra_ctx& ctx, RegisterFile& reg_file,
+                                const PhysRegInterval reg_interval)
 {
-   std::set<std::pair<unsigned, unsigned>> vars;
+   std::vector<unsigned> vars;
    for (PhysReg j : reg_interval) {
       if (reg_file.is_blocked(j))
          continue;
       if (reg_file[j] == 0xF0000000) {
          for (unsigned k = 0; k < 4; k++) {
             unsigned id = reg_file.subdword_regs[j][k];
-            if (id) {
-               assignment& var = ctx.assignments[id];
-               vars.emplace(var.rc.bytes(), id);
-            }
+            if (id && (vars.empty() || id != vars.back()))
+               vars.emplace_back(id);
          }
-      } else if (reg_file[j] != 0) {
+      } else {
          unsigned id = reg_file[j];
-         assignment& var = ctx.assignments[id];
-         vars.emplace(var.rc.bytes(), id);
+         if (id && (vars.empty() || id != vars.back()))
+            vars.emplace_back(id);
       }
    }
    return vars;
 }
 
 /* collect variables from a register area and clear reg_file */
-std::set<std::pair<unsigned, unsigned>> collect_vars(ra_ctx& ctx, RegisterFile& reg_file,
-                                                     const PhysRegInterval reg_interval)
+std::vector<unsigned> collect_vars(ra_ctx& ctx, RegisterFile& reg_file,
+                                   const PhysRegInterval reg_interval)
 {
-   std::set<std::pair<unsigned, unsigned>> vars = find_vars(ctx, reg_file, reg_interval);
-   for (std::pair<unsigned, unsigned> size_id : vars) {
-      assignment& var = ctx.assignments[size_id.second];
+   std::vector<unsigned> vars = find_vars(ctx, reg_file, reg_interval);
+   for (unsigned id : vars) {
+      assignment& var = ctx.assignments[id];
       reg_file.clear(var.reg, var.rc);
    }
    return vars;
 }
 
+/* sort variables from large sized to small and by descending ID and remove duplicates */
+void sort_vars(ra_ctx& ctx, std::vector<unsigned>& vars)
+{
+   std::sort(vars.begin(), vars.end(), [&ctx](unsigned a, unsigned b) {
+      unsigned a_bytes = ctx.assignments[a].rc.bytes();
+      unsigned b_bytes = ctx.assignments[b].rc.bytes();
+      if (a_bytes != b_bytes)
+         return a_bytes > b_bytes;
+      return a > b;
+   });
+   vars.erase(std::unique(vars.begin(), vars.end()), vars.end());
+}
+
 bool get_regs_for_copies(ra_ctx& ctx,
                          RegisterFile& reg_file,
                          std::vector<std::pair<Operand, Definition>>& parallelcopies,
-                         const std::set<std::pair<unsigned, unsigned>> &vars,
+                         std::vector<unsigned> vars,
                          const PhysRegInterval bounds,
                          aco_ptr<Instruction>& instr,
                          const PhysRegInterval def_reg)
 {
-   /* variables are sorted from small sized to large */
+   /* process variables from large sized to small */
    /* NOTE: variables are also sorted by ID. this only affects a very small number of shaders slightly though. */
-   for (std::set<std::pair<unsigned, unsigned>>::const_reverse_iterator it = vars.rbegin(); it != vars.rend(); ++it) {
-      unsigned id = it->second;
+   sort_vars(ctx, vars);
+   for (unsigned id : vars) {
       assignment& var = ctx.assignments[id];
       DefInfo info = DefInfo(ctx, ctx.pseudo_dummy, var.rc, -1);
       uint32_t size = info.size;
@@ -1002,13 +1013,13 @@ bool get_regs_for_copies(ra_ctx& ctx,
       PhysRegInterval reg_win { best_pos, size };
 
       /* collect variables and block reg file */
-      std::set<std::pair<unsigned, unsigned>> new_vars = collect_vars(ctx, reg_file, reg_win);
+      std::vector<unsigned> new_vars = collect_vars(ctx, reg_file, reg_win);
 
       /* mark the area as blocked */
       reg_file.block(reg_win.lo(), var.rc);
       adjust_max_used_regs(ctx, var.rc, reg_win.lo());
 
-      if (!get_regs_for_copies(ctx, reg_file, parallelcopies, new_vars, bounds, instr, def_reg))
+      if (!get_regs_for_copies(ctx, reg_file, parallelcopies, std::move(new_vars), bounds, instr, def_reg))
          return false;
 
       /* create parallelcopy pair (without definition id) */
@@ -1142,7 +1153,7 @@ std::pair<PhysReg, bool> get_reg_impl(ra_ctx& ctx,
 
    /* now, we figured the placement for our definition */
    RegisterFile tmp_file(reg_file);
-   std::set<std::pair<unsigned, unsigned>> vars = collect_vars(ctx, tmp_file, best_win);
+   std::vector<unsigned> vars = collect_vars(ctx, tmp_file, best_win);
 
    if (instr->opcode == aco_opcode::p_create_vector) {
       /* move killed operands which aren't yet at the correct position (GFX9+)
@@ -1155,7 +1166,7 @@ std::pair<PhysReg, bool> get_reg_impl(ra_ctx& ctx,
                 (ctx.program->chip_class >= GFX9 ||
                  (op.physReg().advance(op.bytes()) > best_win.lo() &&
                   op.physReg() < best_win.hi()))) {
-               vars.emplace(op.bytes(), op.tempId());
+               vars.emplace_back(op.tempId());
                tmp_file.clear(op);
             } else {
                tmp_file.fill(op);
@@ -1172,7 +1183,7 @@ std::pair<PhysReg, bool> get_reg_impl(ra_ctx& ctx,
    }
 
    std::vector<std::pair<Operand, Definition>> pc;
-   if (!get_regs_for_copies(ctx, tmp_file, pc, vars, bounds, instr, best_win))
+   if (!get_regs_for_copies(ctx, tmp_file, pc, std::move(vars), bounds, instr, best_win))
       return {{}, false};
 
    parallelcopies.insert(parallelcopies.end(), pc.begin(), pc.end());
@@ -1447,8 +1458,8 @@ PhysReg get_reg(ra_ctx& ctx,
 
       /* reallocate passthrough variables and non-killed operands */
       std::vector<IDAndRegClass> vars;
-      for (const std::pair<unsigned, unsigned>& var : find_vars(ctx, reg_file, regs))
-         vars.emplace_back(var.second, ctx.assignments[var.second].rc);
+      for (unsigned id : find_vars(ctx, reg_file, regs))
+         vars.emplace_back(id, ctx.assignments[id].rc);
       vars.emplace_back(0xffffffff, RegClass(info.rc.type(), MAX2(def_size, killed_op_size)));
 
       PhysReg space = compact_relocate_vars(ctx, vars, parallelcopies, regs.lo());
@@ -1579,7 +1590,7 @@ PhysReg get_reg_create_vector(ra_ctx& ctx,
    }
 
    /* collect variables to be moved */
-   std::set<std::pair<unsigned, unsigned>> vars = collect_vars(ctx, tmp_file, PhysRegInterval { best_pos, size });
+   std::vector<unsigned> vars = collect_vars(ctx, tmp_file, PhysRegInterval { best_pos, size });
 
    for (unsigned i = 0, offset = 0; i < instr->operands.size(); offset += instr->operands[i].bytes(), i++) {
       if (!instr->operands[i].isTemp() || !instr->operands[i].isFirstKillBeforeDef() ||
@@ -1591,7 +1602,7 @@ PhysReg get_reg_create_vector(ra_ctx& ctx,
        * This is only done on GFX9+ because of the cheap v_swap instruction.
        */
       if (ctx.program->chip_class >= GFX9 && !correct_pos) {
-         vars.emplace(instr->operands[i].bytes(), instr->operands[i].tempId());
+         vars.emplace_back(instr->operands[i].tempId());
          tmp_file.clear(instr->operands[i]);
       /* fill operands which are in the correct position to avoid overwriting */
       } else if (correct_pos) {
@@ -1600,7 +1611,7 @@ PhysReg get_reg_create_vector(ra_ctx& ctx,
    }
    bool success = false;
    std::vector<std::pair<Operand, Definition>> pc;
-   success = get_regs_for_copies(ctx, tmp_file, pc, vars, bounds, instr, PhysRegInterval { best_pos, size });
+   success = get_regs_for_copies(ctx, tmp_file, pc, std::move(vars), bounds, instr, PhysRegInterval { best_pos, size });
 
    if (!success) {
       if (!increase_register_file(ctx, temp.type())) {
@@ -2377,7 +2388,7 @@ void register_allocation(Program *program, std::vector<IDSet>& live_out_per_bloc
                const PhysRegInterval def_regs { definition.physReg(), definition.size() };
 
                /* create parallelcopy pair to move blocking vars */
-               std::set<std::pair<unsigned, unsigned>> vars = collect_vars(ctx, register_file, def_regs);
+               std::vector<unsigned> vars = collect_vars(ctx, register_file, def_regs);
 
                RegisterFile tmp_file(register_file);
                /* re-enable the killed operands, so that we don't move the blocking vars there */
@@ -2389,7 +2400,7 @@ void register_allocation(Program *program, std::vector<IDSet>& live_out_per_bloc
                ASSERTED bool success = false;
                DefInfo info(ctx, instr, definition.regClass(), -1);
                success = get_regs_for_copies(ctx, tmp_file, parallelcopy,
-                                             vars, info.bounds, instr,
+                                             std::move(vars), info.bounds, instr,
                                              def_regs);
                assert(success);
 
@@ -88,6 +88,8 @@ void reindex_program(idx_ctx& ctx, Program* program)
                                           program->private_segment_buffer.regClass());
    program->scratch_offset = Temp(ctx.renames[program->scratch_offset.id()],
                                   program->scratch_offset.regClass());
+   if (program->tg_size.id())
+      program->tg_size = Temp(ctx.renames[program->tg_size.id()], program->tg_size.regClass());
    program->temp_rc = ctx.temp_rc;
 }
 
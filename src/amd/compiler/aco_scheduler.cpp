@@ -29,13 +29,16 @@
 
 #include "amdgfxregs.h"
 
-#define SMEM_WINDOW_SIZE (350 - ctx.num_waves * 35)
-#define VMEM_WINDOW_SIZE (1024 - ctx.num_waves * 64)
+#define SMEM_WINDOW_SIZE (ctx.window_scale * (350 - ctx.num_waves * 35) / 4)
+#define VMEM_WINDOW_SIZE (ctx.window_scale * (1024 - ctx.num_waves * 64) / 4)
 #define POS_EXP_WINDOW_SIZE 512
 #define SMEM_MAX_MOVES (64 - ctx.num_waves * 4)
 #define VMEM_MAX_MOVES (256 - ctx.num_waves * 16)
 /* creating clauses decreases def-use distances, so make it less aggressive the lower num_waves is */
 #define VMEM_CLAUSE_MAX_GRAB_DIST (ctx.num_waves * 8)
+#define SMEM_CLAUSE_MAX_GRAB_DIST (ctx.num_waves * 4)
+/* form_hard_clauses() doesn't create larger clauses */
+#define MAX_CLAUSE_SIZE 64
 #define POS_EXP_MAX_MOVES 512
 
 namespace aco {
@@ -84,6 +87,7 @@ private:
 
 struct sched_ctx {
    int16_t num_waves;
+   int16_t window_scale; /* in quarters, see get_window_scale() */
    int16_t last_SMEM_stall;
    int last_SMEM_dep_idx;
    MoveState mv;
@@ -533,6 +537,8 @@ void schedule_SMEM(sched_ctx& ctx, Block* block,
    assert(idx != 0);
    int window_size = SMEM_WINDOW_SIZE;
    int max_moves = SMEM_MAX_MOVES;
+   int clause_max_grab_dist = SMEM_CLAUSE_MAX_GRAB_DIST;
+   int clause_size = 1;
    int16_t k = 0;
 
    /* don't move s_memtime/s_memrealtime */
@@ -541,10 +547,12 @@ void schedule_SMEM(sched_ctx& ctx, Block* block,
 
    /* first, check if we have instructions before current to move down */
    hazard_query hq;
+   hazard_query clause_hq;
    init_hazard_query(&hq);
+   init_hazard_query(&clause_hq);
    add_to_hazard_query(&hq, current);
 
-   ctx.mv.downwards_init(idx, false, false);
+   ctx.mv.downwards_init(idx, false, true);
 
    for (int candidate_idx = idx - 1; k < max_moves && candidate_idx > (int) idx - window_size; candidate_idx--) {
       assert(candidate_idx >= 0);
@@ -562,9 +570,16 @@ void schedule_SMEM(sched_ctx& ctx, Block* block,
       if (candidate->isVMEM())
          break;
 
+      /* gather loads which form_hard_clauses() can put into the same clause */
+      bool part_of_clause = false;
+      if (clause_size < MAX_CLAUSE_SIZE && should_form_clause(current, candidate.get())) {
+         int grab_dist = ctx.mv.insert_idx_clause - candidate_idx;
+         part_of_clause = grab_dist < clause_max_grab_dist;
+      }
+
       bool can_move_down = true;
 
-      HazardResult haz = perform_hazard_query(&hq, candidate.get(), false);
+      HazardResult haz = perform_hazard_query(part_of_clause ? &clause_hq : &hq, candidate.get(), false);
       if (haz == hazard_fail_reorder_ds || haz == hazard_fail_spill || haz == hazard_fail_reorder_sendmsg || haz == hazard_fail_barrier || haz == hazard_fail_export)
          can_move_down = false;
       else if (haz != hazard_success)
@@ -574,13 +589,16 @@ void schedule_SMEM(sched_ctx& ctx, Block* block,
        * significanly worsen LDS scheduling */
       if (candidate->isDS() || !can_move_down) {
          add_to_hazard_query(&hq, candidate.get());
+         add_to_hazard_query(&clause_hq, candidate.get());
          ctx.mv.downwards_skip();
          continue;
       }
 
-      MoveResult res = ctx.mv.downwards_move(false);
+      Instruction *candidate_ptr = candidate.get();
+      MoveResult res = ctx.mv.downwards_move(part_of_clause);
       if (res == move_fail_ssa || res == move_fail_rar) {
          add_to_hazard_query(&hq, candidate.get());
+         add_to_hazard_query(&clause_hq, candidate.get());
          ctx.mv.downwards_skip();
          continue;
       } else if (res == move_fail_pressure) {
@@ -589,7 +607,12 @@ void schedule_SMEM(sched_ctx& ctx, Block* block,
 
       if (candidate_idx < ctx.last_SMEM_dep_idx)
          ctx.last_SMEM_stall++;
-      k++;
+      if (part_of_clause) {
+         add_to_hazard_query(&hq, candidate_ptr);
+         clause_size++;
+      } else {
+         k++;
+      }
    }
 
    /* find the first instruction depending on current or find another MEM */
@@ -664,6 +687,7 @@ void schedule_VMEM(sched_ctx& ctx, Block* block,
    int window_size = VMEM_WINDOW_SIZE;
    int max_moves = VMEM_MAX_MOVES;
    int clause_max_grab_dist = VMEM_CLAUSE_MAX_GRAB_DIST;
+   int clause_size = 1;
    int16_t k = 0;
 
    /* first, check if we have instructions before current to move down */
@@ -690,15 +714,13 @@ void schedule_VMEM(sched_ctx& ctx, Block* block,
       if (can_stall_prev_smem && ctx.last_SMEM_stall >= 0)
          break;
 
+      /* gather loads which form_hard_clauses() can put into the same clause */
       bool part_of_clause = false;
-      if (current->isVMEM() == candidate->isVMEM()) {
-         bool same_resource = true;
-         if (current->isVMEM())
-            same_resource = candidate->operands[0].tempId() == current->operands[0].tempId();
+      if (clause_size < MAX_CLAUSE_SIZE && should_form_clause(current, candidate.get())) {
          int grab_dist = ctx.mv.insert_idx_clause - candidate_idx;
          /* We can't easily tell how much this will decrease the def-to-use
           * distances, so just use how far it will be moved as a heuristic. */
-         part_of_clause = same_resource && grab_dist < clause_max_grab_dist;
+         part_of_clause = grab_dist < clause_max_grab_dist;
       }
 
       /* if current depends on candidate, add additional dependencies and continue */
@@ -729,10 +751,12 @@ void schedule_VMEM(sched_ctx& ctx, Block* block,
       } else if (res == move_fail_pressure) {
          break;
       }
-      if (part_of_clause)
+      if (part_of_clause) {
          add_to_hazard_query(&indep_hq, candidate_ptr);
-      else
+         clause_size++;
+      } else {
          k++;
+      }
       if (candidate_idx < ctx.last_SMEM_dep_idx)
          ctx.last_SMEM_stall++;
    }
@@ -886,6 +910,23 @@ void schedule_block(sched_ctx& ctx, Program *program, Block* block, live& live_v
 }
 
 
+/* The window sizes were tuned on GFX6-9, where a wave64 VALU instruction
+ * takes 4 cycles to issue. On GFX10+, a wave issues 2-4x as many
+ * instructions while a memory load is in flight, so the scheduler has to look
+ * further to find enough independent instructions. This uses the same issue
+ * model as the cycle estimator in aco_statistics.cpp and caps the window at
+ * twice the original size to bound compile times. The result is in
+ * quarters: 4 means the window is unchanged.
+ */
+int16_t get_window_scale(Program *program)
+{
+   unsigned issue_cycles = 4;
+   if (program->chip_class >= GFX10)
+      issue_cycles = program->wave_size == 64 ? 2 : 1;
+
+   return MIN2(4 * 4 / issue_cycles, 8);
+}
+
 void schedule_program(Program *program, live& live_vars)
 {
    /* don't use program->max_reg_demand because that is affected by max_waves_per_simd */
@@ -918,6 +959,7 @@ void schedule_program(Program *program, live& live_vars)
    ctx.num_waves = std::max<uint16_t>(ctx.num_waves / wave_fac, 1);
 
    assert(ctx.num_waves > 0);
+   ctx.window_scale = get_window_scale(program);
    ctx.mv.max_registers = { int16_t(get_addr_vgpr_from_waves(program, ctx.num_waves * wave_fac) - 2),
                             int16_t(get_addr_sgpr_from_waves(program, ctx.num_waves * wave_fac))};
 
@@ -26,6 +26,7 @@
 #include "aco_ir.h"
 #include "aco_builder.h"
 #include "sid.h"
+#include "util/os_time.h"
 
 #include <map>
 #include <set>
@@ -144,7 +145,49 @@ int32_t get_dominator(int idx_a, int idx_b, Program* program, bool is_linear)
    return idx_a;
 }
 
-void next_uses_per_block(spill_ctx& ctx, unsigned block_idx, std::set<uint32_t>& worklist)
+/* Dense worklist of block indices which always returns the largest pending index. */
+struct block_worklist {
+   std::vector<bool> pending;
+   int max_pending = -1;
+
+   block_worklist(unsigned num_blocks) : pending(num_blocks, true), max_pending(num_blocks - 1) {}
+
+   void insert(unsigned block_idx)
+   {
+      pending[block_idx] = true;
+      max_pending = std::max<int>(max_pending, block_idx);
+   }
+
+   bool empty() const
+   {
+      return max_pending < 0;
+   }
+
+   unsigned pop()
+   {
+      unsigned block_idx = max_pending;
+      pending[block_idx] = false;
+      while (max_pending >= 0 && !pending[max_pending])
+         max_pending--;
+      return block_idx;
+   }
+};
+
+/* Updates the next-use distance of temp at the end of a predecessor and
+ * returns whether it changed. */
+bool update_next_use_end(std::map<Temp, std::pair<uint32_t, uint32_t>>& next_uses_end,
+                         Temp temp, std::pair<uint32_t, uint32_t> distance)
+{
+   auto res = next_uses_end.emplace(temp, distance);
+   if (res.second)
+      return true;
+   if (res.first->second == distance)
+      return false;
+   res.first->second = distance;
+   return true;
+}
+
+void next_uses_per_block(spill_ctx& ctx, unsigned block_idx, block_worklist& worklist)
 {
    Block* block = &ctx.program->blocks[block_idx];
    std::map<Temp, std::pair<uint32_t, uint32_t>> next_uses = ctx.next_use_distances_end[block_idx];
@@ -196,10 +239,8 @@ void next_uses_per_block(spill_ctx& ctx, unsigned block_idx, std::set<uint32_t>&
                              block->logical_preds[i] :
                              block->linear_preds[i];
          if (instr->operands[i].isTemp()) {
-            if (ctx.next_use_distances_end[pred_idx].find(instr->operands[i].getTemp()) == ctx.next_use_distances_end[pred_idx].end() ||
-                ctx.next_use_distances_end[pred_idx][instr->operands[i].getTemp()] != distance)
+            if (update_next_use_end(ctx.next_use_distances_end[pred_idx], instr->operands[i].getTemp(), distance))
                worklist.insert(pred_idx);
-            ctx.next_use_distances_end[pred_idx][instr->operands[i].getTemp()] = distance;
          }
       }
       next_uses.erase(instr->definitions[0].getTemp());
@@ -215,13 +256,20 @@ void next_uses_per_block(spill_ctx& ctx, unsigned block_idx, std::set<uint32_t>&
       for (unsigned pred_idx : preds) {
          if (ctx.program->blocks[pred_idx].loop_nest_depth > block->loop_nest_depth)
             distance += 0xFFFF;
-         if (ctx.next_use_distances_end[pred_idx].find(temp) != ctx.next_use_distances_end[pred_idx].end()) {
-            dom = get_dominator(dom, ctx.next_use_distances_end[pred_idx][temp].first, ctx.program, temp.is_linear());
-            distance = std::min(ctx.next_use_distances_end[pred_idx][temp].second, distance);
+         std::map<Temp, std::pair<uint32_t, uint32_t>>& pred_next_uses = ctx.next_use_distances_end[pred_idx];
+         auto pred_it = pred_next_uses.find(temp);
+         if (pred_it != pred_next_uses.end()) {
+            dom = get_dominator(dom, pred_it->second.first, ctx.program, temp.is_linear());
+            distance = std::min(pred_it->second.second, distance);
+            if (pred_it->second != std::pair<uint32_t, uint32_t>{dom, distance}) {
+               pred_it->second = {dom, distance};
+               worklist.insert(pred_idx);
+            }
+         } else {
+            pred_next_uses.emplace_hint(pred_it, temp, std::pair<uint32_t, uint32_t>{dom, distance});
+            if (dom || distance)
+               worklist.insert(pred_idx);
          }
-         if (ctx.next_use_distances_end[pred_idx][temp] != std::pair<uint32_t, uint32_t>{dom, distance})
-            worklist.insert(pred_idx);
-         ctx.next_use_distances_end[pred_idx][temp] = {dom, distance};
       }
    }
 
@@ -231,16 +279,10 @@ void compute_global_next_uses(spill_ctx& ctx)
 {
    ctx.next_use_distances_start.resize(ctx.program->blocks.size());
    ctx.next_use_distances_end.resize(ctx.program->blocks.size());
-   std::set<uint32_t> worklist;
-   for (Block& block : ctx.program->blocks)
-      worklist.insert(block.index);
-
-   while (!worklist.empty()) {
-      std::set<unsigned>::reverse_iterator b_it = worklist.rbegin();
-      unsigned block_idx = *b_it;
-      worklist.erase(block_idx);
-      next_uses_per_block(ctx, block_idx, worklist);
-   }
+
+   block_worklist worklist(ctx.program->blocks.size());
+   while (!worklist.empty())
+      next_uses_per_block(ctx, worklist.pop(), worklist);
 }
 
 bool should_rematerialize(aco_ptr<Instruction>& instr)
@@ -1291,6 +1333,66 @@ Temp load_scratch_resource(spill_ctx& ctx, Temp& scratch_offset,
                      Operand(rsrc_conf));
 }
 
+/* Returns the distance in bytes between two VGPR spill slots in LDS, or 0 if
+ * the VGPR spills have to go to scratch memory. */
+unsigned get_lds_spill_stride(spill_ctx& ctx, unsigned vgpr_spill_slots,
+                              unsigned spills_to_vgpr, unsigned* lds_offset)
+{
+   Program* program = ctx.program;
+
+   /* The wave's location in the workgroup's LDS is derived from the wave id
+    * in tg_size and ds_*_addtid is GFX9+. The LDS is allocated per workgroup,
+    * so its size has to be known. */
+   if (program->chip_class < GFX9 || program->stage != compute_cs ||
+       program->tg_size == Temp() || program->workgroup_size == UINT_MAX)
+      return 0;
+
+   /* each slot has one dword for every lane of the workgroup */
+   unsigned waves_per_workgroup = align(program->workgroup_size, program->wave_size) / program->wave_size;
+   unsigned stride = waves_per_workgroup * program->wave_size * 4;
+   unsigned lds_used = program->config->lds_size * program->dev.lds_encoding_granule;
+   unsigned lds_total = lds_used + vgpr_spill_slots * stride;
+   if (lds_total > program->dev.lds_limit)
+      return 0;
+
+   /* only use the LDS if it doesn't limit the occupancy reached after spilling */
+   RegisterDemand demand = ctx.target_pressure;
+   demand.vgpr += spills_to_vgpr;
+   uint16_t vgpr_demand = get_vgpr_alloc(program, demand.vgpr) + program->config->num_shared_vgprs / 2;
+   uint16_t waves = std::min<uint16_t>(program->dev.physical_sgprs / get_sgpr_alloc(program, demand.sgpr),
+                                       program->dev.physical_vgprs / vgpr_demand);
+   waves = std::min(waves, calc_max_waves(program, lds_used));
+   if (calc_max_waves(program, lds_total) < waves)
+      return 0;
+
+   *lds_offset = lds_used;
+   return stride;
+}
+
+/* Returns the LDS address of the wave's dword of the first spill slot. */
+Temp load_lds_spill_base(spill_ctx& ctx, std::vector<aco_ptr<Instruction>>& instructions,
+                         unsigned lds_offset, bool is_top_level)
+{
+   Builder bld(ctx.program);
+   if (is_top_level) {
+      bld.reset(&instructions);
+   } else {
+      /* find p_logical_end */
+      unsigned idx = instructions.size() - 1;
+      while (instructions[idx]->opcode != aco_opcode::p_logical_end)
+         idx--;
+      bld.reset(&instructions, std::next(instructions.begin(), idx));
+   }
+
+   /* The tg_size bits [6:11] contain the wave id, which is multiplied
+    * by 64 after the s_and. Each wave needs wave_size dwords per slot.
+    */
+   Temp wave_id = bld.sop2(aco_opcode::s_and_b32, bld.def(s1), bld.def(s1, scc),
+                           Operand(0xfc0u), ctx.program->tg_size);
+   aco_opcode op = ctx.program->wave_size == 64 ? aco_opcode::s_lshl2_add_u32 : aco_opcode::s_lshl1_add_u32;
+   return bld.sop2(op, bld.def(s1), bld.def(s1, scc), wave_id, Operand(lds_offset));
+}
+
 void add_interferences(spill_ctx& ctx, std::vector<bool>& is_assigned,
                        std::vector<uint32_t>& slots, std::vector<bool>& slots_used,
                        unsigned id)
@@ -1413,6 +1515,10 @@ void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr) {
    assign_spill_slots_helper(ctx, RegType::sgpr, is_assigned, slots, &sgpr_spill_slots);
    assign_spill_slots_helper(ctx, RegType::vgpr, is_assigned, slots, &vgpr_spill_slots);
 
+   /* compute shaders with unused LDS can spill VGPRs there instead of to scratch */
+   unsigned lds_spill_offset = 0;
+   unsigned lds_spill_stride = vgpr_spill_slots ? get_lds_spill_stride(ctx, vgpr_spill_slots, spills_to_vgpr, &lds_spill_offset) : 0;
+
    for (unsigned id = 0; id < is_assigned.size(); id++)
       assert(is_assigned[id] || !ctx.is_reloaded[id]);
 
@@ -1435,6 +1541,7 @@ void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr) {
 
    /* replace pseudo instructions with actual hardware instructions */
    Temp scratch_offset = ctx.program->scratch_offset, scratch_rsrc = Temp();
+   Temp lds_spill_base = Temp();
    unsigned last_top_level_block_idx = 0;
    std::vector<bool> reload_in_loop(vgpr_spill_temps.size());
    for (Block& block : ctx.program->blocks) {
@@ -1498,6 +1605,37 @@ void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr) {
                /* never reloaded, so don't spill */
             } else if (!is_assigned[spill_id]) {
                unreachable("No spill slot assigned for spill id");
+            } else if (ctx.interferences[spill_id].first.type() == RegType::vgpr && lds_spill_stride) {
+               /* spill vgpr to LDS */
+               ctx.program->config->spilled_vgprs += (*it)->operands[0].size();
+
+               /* check if the LDS address already exists */
+               if (lds_spill_base == Temp()) {
+                  lds_spill_base = load_lds_spill_base(ctx,
+                                                       last_top_level_block_idx == block.index ?
+                                                       instructions : ctx.program->blocks[last_top_level_block_idx].instructions,
+                                                       lds_spill_offset,
+                                                       last_top_level_block_idx == block.index);
+               }
+
+               unsigned offset = slots[spill_id] * lds_spill_stride;
+               assert((*it)->operands[0].isTemp());
+               Temp temp = (*it)->operands[0].getTemp();
+               assert(temp.type() == RegType::vgpr && !temp.is_linear());
+               Instruction* split = NULL;
+               if (temp.size() > 1) {
+                  split = create_instruction<Pseudo_instruction>(aco_opcode::p_split_vector, Format::PSEUDO, 1, temp.size());
+                  split->operands[0] = Operand(temp);
+                  for (unsigned i = 0; i < temp.size(); i++)
+                     split->definitions[i] = bld.def(v1);
+                  bld.insert(split);
+               }
+               for (unsigned i = 0; i < temp.size(); i++) {
+                  Temp data = split ? split->definitions[i].getTemp() : temp;
+                  Instruction *instr = bld.ds(aco_opcode::ds_write_addtid_b32, Operand(v1), data,
+                                              bld.m0(lds_spill_base), offset + i * lds_spill_stride);
+                  instr->ds().sync = memory_sync_info(storage_vgpr_spill, semantic_private);
+               }
             } else if (ctx.interferences[spill_id].first.type() == RegType::vgpr) {
                /* spill vgpr */
                ctx.program->config->spilled_vgprs += (*it)->operands[0].size();
@@ -1571,6 +1709,34 @@ void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr) {
 
             if (!is_assigned[spill_id]) {
                unreachable("No spill slot assigned for spill id");
+            } else if (ctx.interferences[spill_id].first.type() == RegType::vgpr && lds_spill_stride) {
+               /* reload vgpr from LDS */
+               if (lds_spill_base == Temp()) {
+                  lds_spill_base = load_lds_spill_base(ctx,
+                                                       last_top_level_block_idx == block.index ?
+                                                       instructions : ctx.program->blocks[last_top_level_block_idx].instructions,
+                                                       lds_spill_offset,
+                                                       last_top_level_block_idx == block.index);
+               }
+
+               unsigned offset = slots[spill_id] * lds_spill_stride;
+               Definition def = (*it)->definitions[0];
+               if (def.size() > 1) {
+                  Instruction* vec{create_instruction<Pseudo_instruction>(aco_opcode::p_create_vector, Format::PSEUDO, def.size(), 1)};
+                  vec->definitions[0] = def;
+                  for (unsigned i = 0; i < def.size(); i++) {
+                     Temp tmp = bld.tmp(v1);
+                     vec->operands[i] = Operand(tmp);
+                     Instruction *instr = bld.ds(aco_opcode::ds_read_addtid_b32, Definition(tmp), Operand(v1),
+                                                 bld.m0(lds_spill_base), offset + i * lds_spill_stride);
+                     instr->ds().sync = memory_sync_info(storage_vgpr_spill, semantic_private);
+                  }
+                  bld.insert(vec);
+               } else {
+                  Instruction *instr = bld.ds(aco_opcode::ds_read_addtid_b32, def, Operand(v1),
+                                              bld.m0(lds_spill_base), offset);
+                  instr->ds().sync = memory_sync_info(storage_vgpr_spill, semantic_private);
+               }
             } else if (ctx.interferences[spill_id].first.type() == RegType::vgpr) {
                /* reload vgpr */
                uint32_t spill_slot = slots[spill_id];
@@ -1641,8 +1807,18 @@ void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr) {
       block.instructions = std::move(instructions);
    }
 
-   /* update required scratch memory */
-   ctx.program->config->scratch_bytes_per_wave += align(vgpr_spill_slots * 4 * ctx.program->wave_size, 1024);
+   /* update required LDS or scratch memory */
+   if (lds_spill_stride) {
+      unsigned lds_bytes = lds_spill_offset + vgpr_spill_slots * lds_spill_stride;
+      ctx.program->config->lds_size = DIV_ROUND_UP(lds_bytes, ctx.program->dev.lds_encoding_granule);
+   } else {
+      ctx.program->config->scratch_bytes_per_wave += align(vgpr_spill_slots * 4 * ctx.program->wave_size, 1024);
+   }
+
+   if (ctx.program->collect_statistics) {
+      ctx.program->statistics[statistic_lds_vgpr_spills] = lds_spill_stride ? vgpr_spill_slots : 0;
+      ctx.program->statistics[statistic_scratch_vgpr_spills] = lds_spill_stride ? 0 : vgpr_spill_slots;
+   }
 
    /* SSA elimination inserts copies for logical phis right before p_logical_end
     * So if a linear vgpr is used between that p_logical_end and the branch,
@@ -1708,6 +1884,8 @@ void spill(Program* program, live& live_vars)
    if (program->num_waves > 0)
       return;
 
+   int64_t start_time = program->collect_statistics ? os_time_get_nano() : 0;
+
    /* lower to CSSA before spilling to ensure correctness w.r.t. phis */
    lower_to_cssa(program, live_vars);
 
@@ -1740,6 +1918,9 @@ void spill(Program* program, live& live_vars)
    live_vars = live_var_analysis(program);
 
    assert(program->num_waves > 0);
+
+   if (program->collect_statistics)
+      program->statistics[statistic_spill_time] = (os_time_get_nano() - start_time) / 1000;
 }
 
 }
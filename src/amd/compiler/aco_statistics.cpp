@@ -480,6 +480,7 @@ void collect_preasm_stats(Program *program)
    }
 
    double latency = 0;
+   double waitcnt_stalls = 0;
    double usage[(int)BlockCycleEstimator::resource_count] = {0};
    std::vector<BlockCycleEstimator> blocks(program->blocks.size(), program);
 
@@ -488,7 +489,12 @@ void collect_preasm_stats(Program *program)
       for (unsigned pred : block.linear_preds)
          block_est.join(blocks[pred]);
 
+      unsigned block_waitcnt_stalls = 0;
       for (aco_ptr<Instruction>& instr : block.instructions) {
+         if (instr->opcode == aco_opcode::s_waitcnt ||
+             instr->opcode == aco_opcode::s_waitcnt_vscnt)
+            block_waitcnt_stalls += block_est.predict_cost(instr);
+
          unsigned before = block_est.cur_cycle;
          block_est.add(instr);
          instr->pass_flags = block_est.cur_cycle - before;
@@ -519,6 +525,7 @@ void collect_preasm_stats(Program *program)
          iter *= 0.25;
 
       latency += block_est.cur_cycle * iter;
+      waitcnt_stalls += block_waitcnt_stalls * iter;
       for (unsigned i = 0; i < (unsigned)BlockCycleEstimator::resource_count; i++)
          usage[i] += block_est.res_usage[i] * iter;
    }
@@ -544,6 +551,7 @@ void collect_preasm_stats(Program *program)
 
    program->statistics[statistic_latency] = round(latency);
    program->statistics[statistic_inv_throughput] = round(1.0 / wave64_per_cycle);
+   program->statistics[statistic_waitcnt_stalls] = round(waitcnt_stalls);
 
    if (debug_flags & DEBUG_PERF_INFO) {
       aco_print_program(program, stderr, print_no_ssa | print_perf_info);
@@ -557,6 +565,7 @@ void collect_preasm_stats(Program *program)
       fprintf(stderr, "export_gds_usage: %f\n", usage[(int)BlockCycleEstimator::export_gds]);
       fprintf(stderr, "vmem_usage: %f\n", usage[(int)BlockCycleEstimator::vmem]);
       fprintf(stderr, "latency: %f\n", latency);
+      fprintf(stderr, "waitcnt_stalls: %f\n", waitcnt_stalls);
       fprintf(stderr, "parallelism: %f\n", parallelism);
       fprintf(stderr, "max_utilization: %f\n", max_utilization);
       fprintf(stderr, "wave64_per_cycle: %f\n", wave64_per_cycle);
@@ -25,7 +25,12 @@
 #ifndef ACO_UTIL_H
 #define ACO_UTIL_H
 
+#include "util/macros.h"
+#include "util/u_math.h"
+
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <iterator>
 #include <vector>
 
@@ -380,6 +385,101 @@ inline uint32_t IDSet::Iterator::operator * () const {
    return (word << 6) | bit;
 }
 
+/*
+ * Light-weight memory resource which allows to sequentially allocate from
+ * a buffer. Deallocation of individual allocations is a no-op: both release()
+ * and the destructor free all managed memory at once.
+ *
+ * The memory resource is not thread-safe.
+ * The interface resembles a subset of std::pmr::monotonic_buffer_resource.
+ */
+class monotonic_buffer_resource final {
+public:
+   explicit monotonic_buffer_resource(size_t size = initial_size)
+   {
+      /* The size parameter refers to the total size of the first chunk.
+       * The usable data_size is size - sizeof(Buffer).
+       */
+      size = MAX2(size, minimum_size);
+      buffer = (Buffer*)malloc(size);
+      buffer->next = nullptr;
+      buffer->data_size = size - sizeof(Buffer);
+      buffer->current_idx = 0;
+      reserved = max_reserved = size;
+   }
+
+   ~monotonic_buffer_resource()
+   {
+      release();
+      free(buffer);
+   }
+
+   monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+   monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+   void* allocate(size_t size, size_t alignment)
+   {
+      buffer->current_idx = align64(buffer->current_idx, alignment);
+      if (buffer->current_idx + size <= buffer->data_size) {
+         uint8_t* ptr = &buffer->data[buffer->current_idx];
+         buffer->current_idx += size;
+         used += size;
+         return ptr;
+      }
+
+      /* create a new, larger chunk */
+      size_t total_size = buffer->data_size + sizeof(Buffer);
+      do {
+         total_size *= 2;
+      } while (total_size - sizeof(Buffer) < size + alignment);
+
+      Buffer* next = buffer;
+      buffer = (Buffer*)malloc(total_size);
+      buffer->next = next;
+      buffer->data_size = total_size - sizeof(Buffer);
+      buffer->current_idx = 0;
+      reserved += total_size;
+      max_reserved = MAX2(max_reserved, reserved);
+
+      return allocate(size, alignment);
+   }
+
+   /* Frees all chunks except for the first one, which is reused. */
+   void release()
+   {
+      while (buffer->next) {
+         Buffer* next = buffer->next;
+         reserved -= buffer->data_size + sizeof(Buffer);
+         free(buffer);
+         buffer = next;
+      }
+      buffer->current_idx = 0;
+      used = 0;
+   }
+
+   /* Number of bytes handed out since the last release(). */
+   size_t bytes_used() const { return used; }
+
+   /* Peak number of bytes malloc'd to back allocations, including all chunk overhead. */
+   size_t high_water() const { return max_reserved; }
+
+private:
+   struct Buffer {
+      Buffer* next;
+      uint32_t current_idx;
+      uint32_t data_size;
+      uint8_t data[];
+   };
+
+   Buffer* buffer;
+   size_t reserved = 0;
+   size_t max_reserved = 0;
+   size_t used = 0;
+   static constexpr size_t initial_size = 4096;
+   static constexpr size_t minimum_size = 128;
+   static_assert(minimum_size > sizeof(Buffer), "Minimum chunk size must hold the header");
+};
+
 } // namespace aco
 
 #endif // ACO_UTIL_H
@@ -430,8 +430,11 @@ bool validate_ir(Program* program)
             break;
          }
          case Format::DS: {
+            bool addtid = instr->opcode == aco_opcode::ds_read_addtid_b32 ||
+                          instr->opcode == aco_opcode::ds_write_addtid_b32;
             for (const Operand& op : instr->operands) {
-               check((op.isTemp() && op.regClass().type() == RegType::vgpr) || op.physReg() == m0,
+               check((op.isTemp() && op.regClass().type() == RegType::vgpr) || op.physReg() == m0 ||
+                     (addtid && op.isUndefined()),
                      "Only VGPRs are valid DS instruction operands", instr.get());
             }
             if (!instr->definitions.empty())
@@ -66,7 +66,8 @@ static std::mutex create_device_mutex;
    ITEM(CreateRenderPass)\
    ITEM(DestroyRenderPass)\
    ITEM(GetPipelineExecutablePropertiesKHR)\
-   ITEM(GetPipelineExecutableInternalRepresentationsKHR)
+   ITEM(GetPipelineExecutableInternalRepresentationsKHR)\
+   ITEM(GetPipelineExecutableStatisticsKHR)
 
 #define ITEM(n) PFN_vk##n n;
 FUNCTION_LIST
@@ -358,6 +359,44 @@ void print_pipeline_ir(VkDevice device, VkPipeline pipeline, VkShaderStageFlagBi
    }
 }
 
+void add_pipeline_statistics(VkDevice device, VkPipeline pipeline,
+                             std::map<std::string, uint64_t>& stats)
+{
+   uint32_t executable_count = 16;
+   VkPipelineExecutablePropertiesKHR executables[16];
+   VkPipelineInfoKHR pipeline_info;
+   pipeline_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INFO_KHR;
+   pipeline_info.pNext = NULL;
+   pipeline_info.pipeline = pipeline;
+   ASSERTED VkResult result = GetPipelineExecutablePropertiesKHR(device, &pipeline_info, &executable_count, executables);
+   assert(result == VK_SUCCESS);
+
+   for (uint32_t executable = 0; executable < executable_count; executable++) {
+      VkPipelineExecutableInfoKHR exec_info;
+      exec_info.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INFO_KHR;
+      exec_info.pNext = NULL;
+      exec_info.pipeline = pipeline;
+      exec_info.executableIndex = executable;
+
+      uint32_t stat_count = 0;
+      result = GetPipelineExecutableStatisticsKHR(device, &exec_info, &stat_count, NULL);
+      assert(result == VK_SUCCESS);
+
+      std::vector<VkPipelineExecutableStatisticKHR> exec_stats(stat_count);
+      for (VkPipelineExecutableStatisticKHR& stat : exec_stats) {
+         stat.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR;
+         stat.pNext = NULL;
+      }
+      result = GetPipelineExecutableStatisticsKHR(device, &exec_info, &stat_count, exec_stats.data());
+      assert(result == VK_SUCCESS);
+
+      for (const VkPipelineExecutableStatisticKHR& stat : exec_stats) {
+         if (stat.format == VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR)
+            stats[stat.name] += stat.value.u64;
+      }
+   }
+}
+
 VkShaderModule __qoCreateShaderModule(VkDevice dev, const QoShaderModuleCreateInfo *module_info)
 {
     VkShaderModuleCreateInfo vk_module_info;
@@ -377,6 +416,7 @@ VkShaderModule __qoCreateShaderModule(VkDevice dev, const QoShaderModuleCreateIn
 PipelineBuilder::PipelineBuilder(VkDevice dev) {
    memset(this, 0, sizeof(*this));
    topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+   create_flags = VK_PIPELINE_CREATE_CAPTURE_INTERNAL_REPRESENTATIONS_BIT_KHR;
    device = dev;
 }
 
@@ -539,7 +579,7 @@ void PipelineBuilder::create_compute_pipeline() {
    VkComputePipelineCreateInfo create_info;
    create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
    create_info.pNext = NULL;
-   create_info.flags = VK_PIPELINE_CREATE_CAPTURE_INTERNAL_REPRESENTATIONS_BIT_KHR;
+   create_info.flags = create_flags;
    create_info.stage = stages[0];
    create_info.layout = pipeline_layout;
    create_info.basePipelineHandle = VK_NULL_HANDLE;
@@ -706,7 +746,7 @@ void PipelineBuilder::create_graphics_pipeline() {
 
    gfx_pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
    gfx_pipeline_info.pNext = NULL;
-   gfx_pipeline_info.flags = VK_PIPELINE_CREATE_CAPTURE_INTERNAL_REPRESENTATIONS_BIT_KHR;
+   gfx_pipeline_info.flags = create_flags;
    gfx_pipeline_info.pVertexInputState = &vs_input;
    gfx_pipeline_info.pInputAssemblyState = &assembly_state;
    gfx_pipeline_info.pTessellationState = &tess_state;
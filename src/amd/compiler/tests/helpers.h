@@ -92,6 +92,9 @@ VkDevice get_vk_device(enum radeon_family family);
 
 void print_pipeline_ir(VkDevice device, VkPipeline pipeline, VkShaderStageFlagBits stages,
                        const char *name, bool remove_encoding=false);
+/* adds the statistics of all executables of the pipeline to stats */
+void add_pipeline_statistics(VkDevice device, VkPipeline pipeline,
+                             std::map<std::string, uint64_t>& stats);
 
 VkShaderModule __qoCreateShaderModule(VkDevice dev, const QoShaderModuleCreateInfo *info);
 
@@ -115,6 +118,7 @@ public:
    VkDescriptorSetLayoutBinding desc_bindings[64][64];
    VkPipelineShaderStageCreateInfo stages[5];
    VkShaderStageFlags owned_stages;
+   VkPipelineCreateFlags create_flags;
 
    /* outputs */
    VkGraphicsPipelineCreateInfo gfx_pipeline_info;
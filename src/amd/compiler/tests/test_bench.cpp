@@ -0,0 +1,291 @@
+/*
+ * Copyright © 2021 Valve Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+#include "helpers.h"
+#include "spirv/spirv.h"
+#include "util/os_time.h"
+
+#include <dirent.h>
+#include <inttypes.h>
+
+using namespace aco;
+
+namespace {
+
+struct bench_shader {
+   std::string name;
+   std::vector<uint32_t> spirv;
+   std::string entrypoint;
+};
+
+struct spirv_id {
+   SpvOp op = SpvOpNop;
+   uint32_t args[2] = {0, 0};
+   int set = -1;
+   int binding = -1;
+   bool buffer_block = false;
+};
+
+std::vector<uint32_t> read_spirv(const std::string& path)
+{
+   std::vector<uint32_t> words;
+   FILE *f = fopen(path.c_str(), "rb");
+   if (!f)
+      return words;
+
+   fseek(f, 0, SEEK_END);
+   long size = ftell(f);
+   fseek(f, 0, SEEK_SET);
+   if (size > 0 && size % 4 == 0) {
+      words.resize(size / 4);
+      if (fread(words.data(), 4, words.size(), f) != words.size())
+         words.clear();
+   }
+   fclose(f);
+
+   if (words.size() < 5 || words[0] != SpvMagicNumber)
+      words.clear();
+   return words;
+}
+
+/* Declares the descriptors used by a compute shader, so that a matching
+ * pipeline layout can be created. Returns false for unsupported shaders. */
+bool add_spirv_decls(PipelineBuilder& pbld, bench_shader& shader)
+{
+   const std::vector<uint32_t>& spirv = shader.spirv;
+   std::vector<spirv_id> ids(spirv[3]);
+   std::vector<uint32_t> variables;
+   bool has_push_constants = false;
+
+   for (unsigned i = 5; i < spirv.size();) {
+      const uint32_t *w = &spirv[i];
+      unsigned count = w[0] >> 16;
+      if (!count || i + count > spirv.size())
+         return false;
+      i += count;
+
+      switch ((SpvOp)(w[0] & 0xffff)) {
+      case SpvOpEntryPoint:
+         if (w[1] != SpvExecutionModelGLCompute || !shader.entrypoint.empty())
+            return false;
+         shader.entrypoint = (const char *)&w[3];
+         break;
+      case SpvOpDecorate:
+         if (w[2] == SpvDecorationDescriptorSet)
+            ids[w[1]].set = w[3];
+         else if (w[2] == SpvDecorationBinding)
+            ids[w[1]].binding = w[3];
+         else if (w[2] == SpvDecorationBufferBlock)
+            ids[w[1]].buffer_block = true;
+         break;
+      case SpvOpTypeImage:
+         ids[w[1]].op = SpvOpTypeImage;
+         ids[w[1]].args[0] = w[3]; /* dim */
+         ids[w[1]].args[1] = w[7]; /* sampled */
+         break;
+      case SpvOpTypeSampler:
+      case SpvOpTypeSampledImage:
+         ids[w[1]].op = (SpvOp)(w[0] & 0xffff);
+         break;
+      case SpvOpTypeArray:
+         ids[w[1]].op = SpvOpTypeArray;
+         ids[w[1]].args[0] = w[2]; /* element type */
+         ids[w[1]].args[1] = w[3]; /* length */
+         break;
+      case SpvOpTypeRuntimeArray:
+         ids[w[1]].op = SpvOpTypeRuntimeArray;
+         ids[w[1]].args[0] = w[2]; /* element type */
+         break;
+      case SpvOpConstant:
+         ids[w[2]].op = SpvOpConstant;
+         ids[w[2]].args[0] = w[3];
+         break;
+      case SpvOpTypePointer:
+         ids[w[1]].op = SpvOpTypePointer;
+         ids[w[1]].args[0] = w[2]; /* storage class */
+         ids[w[1]].args[1] = w[3]; /* pointee */
+         break;
+      case SpvOpVariable:
+         if (w[3] == SpvStorageClassPushConstant)
+            has_push_constants = true;
+         ids[w[2]].op = SpvOpVariable;
+         ids[w[2]].args[0] = w[1];
+         variables.push_back(w[2]);
+         break;
+      default:
+         break;
+      }
+   }
+
+   if (shader.entrypoint.empty())
+      return false;
+
+   for (uint32_t var : variables) {
+      if (ids[var].set < 0 || ids[var].binding < 0)
+         continue;
+
+      const spirv_id& ptr = ids[ids[var].args[0]];
+      uint32_t type = ptr.args[1];
+      unsigned count = 1;
+      while (ids[type].op == SpvOpTypeArray || ids[type].op == SpvOpTypeRuntimeArray) {
+         /* runtime arrays get an arbitrary size */
+         count *= ids[type].op == SpvOpTypeArray ? ids[ids[type].args[1]].args[0] : 64;
+         type = ids[type].args[0];
+      }
+
+      VkDescriptorType desc_type;
+      if (ptr.args[0] == SpvStorageClassStorageBuffer) {
+         desc_type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      } else if (ptr.args[0] == SpvStorageClassUniform) {
+         desc_type = ids[type].buffer_block ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER :
+                                              VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+      } else if (ptr.args[0] == SpvStorageClassUniformConstant) {
+         bool is_buffer = ids[type].args[0] == SpvDimBuffer;
+         switch (ids[type].op) {
+         case SpvOpTypeSampler:
+            desc_type = VK_DESCRIPTOR_TYPE_SAMPLER;
+            break;
+         case SpvOpTypeSampledImage:
+            desc_type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            break;
+         case SpvOpTypeImage:
+            if (ids[type].args[1] == 2)
+               desc_type = is_buffer ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER :
+                                       VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            else
+               desc_type = is_buffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER :
+                                       VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            break;
+         default:
+            return false;
+         }
+      } else {
+         return false;
+      }
+
+      pbld.add_desc_binding(VK_SHADER_STAGE_COMPUTE_BIT, ids[var].set, ids[var].binding,
+                            desc_type, count);
+   }
+
+   if (has_push_constants)
+      pbld.push_constant_range = {VK_SHADER_STAGE_COMPUTE_BIT, 0, 128};
+
+   return true;
+}
+
+std::vector<bench_shader> load_shaders(const char *dir_name)
+{
+   std::vector<bench_shader> shaders;
+   DIR *dir = opendir(dir_name);
+   if (!dir)
+      return shaders;
+
+   while (struct dirent *entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name.size() < 4 || name.compare(name.size() - 4, 4, ".spv"))
+         continue;
+
+      bench_shader shader;
+      shader.name = name;
+      shader.spirv = read_spirv(std::string(dir_name) + "/" + name);
+      if (!shader.spirv.empty())
+         shaders.push_back(std::move(shader));
+   }
+   closedir(dir);
+
+   std::sort(shaders.begin(), shaders.end(),
+             [](const bench_shader& a, const bench_shader& b) { return a.name < b.name; });
+   return shaders;
+}
+
+} /* end namespace */
+
+BEGIN_TEST(bench.compile.spirv)
+   /* Not a correctness test: this compiles every SPIR-V compute shader in
+    * $ACO_BENCH_DIR $ACO_BENCH_ITERATIONS times and reports the time spent in
+    * each group of ACO passes, using the pipeline statistics. Use --no-check
+    * to see the results and run it on its own, so that the device is created
+    * with the pipeline cache disabled.
+    */
+   const char *dir_name = getenv("ACO_BENCH_DIR");
+   if (!dir_name) {
+      skip_test("ACO_BENCH_DIR is not set");
+      return;
+   }
+   const char *iterations_str = getenv("ACO_BENCH_ITERATIONS");
+   unsigned iterations = iterations_str ? MAX2(atoi(iterations_str), 1) : 8;
+
+   std::vector<bench_shader> shaders = load_shaders(dir_name);
+   if (shaders.empty()) {
+      skip_test("no SPIR-V shaders found in %s", dir_name);
+      return;
+   }
+
+   const char *radv_debug = getenv("RADV_DEBUG");
+   std::string debug_str = radv_debug ? std::string(radv_debug) + ",nocache" : "nocache";
+   setenv("RADV_DEBUG", debug_str.c_str(), 1);
+
+   for (unsigned i = GFX8; i <= GFX10; i++) {
+      if (!set_variant((chip_class)i))
+         continue;
+
+      VkDevice device = get_vk_device((chip_class)i);
+
+      unsigned num_compiled = 0;
+      uint64_t total_ns = 0;
+      std::map<std::string, uint64_t> stats;
+      for (unsigned iter = 0; iter < iterations; iter++) {
+         for (bench_shader& shader : shaders) {
+            PipelineBuilder pbld(device);
+            pbld.create_flags = VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR;
+            shader.entrypoint.clear();
+            if (!add_spirv_decls(pbld, shader))
+               continue;
+
+            QoShaderModuleCreateInfo module = {NULL, shader.spirv.size() * 4, shader.spirv.data(),
+                                               0, NULL, VK_SHADER_STAGE_COMPUTE_BIT};
+            pbld.add_stage(VK_SHADER_STAGE_COMPUTE_BIT, __qoCreateShaderModule(device, &module),
+                           shader.entrypoint.c_str());
+
+            int64_t start = os_time_get_nano();
+            pbld.create_pipeline();
+            total_ns += os_time_get_nano() - start;
+
+            add_pipeline_statistics(device, pbld.pipeline, stats);
+            num_compiled += iter == 0;
+         }
+      }
+
+      fprintf(output, "%u of %u shaders compiled, %u iterations\n",
+              num_compiled, (unsigned)shaders.size(), iterations);
+      fprintf(output, "pipeline creation: %" PRIu64 " us per iteration\n",
+              total_ns / 1000 / iterations);
+      for (const std::pair<const std::string, uint64_t>& stat : stats) {
+         const std::string& name = stat.first;
+         if (name.size() > 5 && !name.compare(name.size() - 5, 5, " Time"))
+            fprintf(output, "%s: %" PRIu64 " us per iteration\n", name.c_str(), stat.second / iterations);
+         else if (name == "Instruction Arena")
+            fprintf(output, "%s: %" PRIu64 " bytes per iteration\n", name.c_str(), stat.second / iterations);
+      }
+   }
+END_TEST
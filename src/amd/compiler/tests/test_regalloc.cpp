@@ -22,6 +22,9 @@
  *
  */
 #include "helpers.h"
+#include "util/os_time.h"
+
+#include <inttypes.h>
 
 using namespace aco;
 
@@ -77,3 +80,55 @@ BEGIN_TEST(regalloc.32bit_partial_write)
 
    finish_ra_test(ra_test_policy());
 END_TEST
+
+BEGIN_TEST(regalloc.bench.high_pressure)
+   /* Not a correctness test: this measures the time spent in register
+    * allocation on a synthetic program which fragments the VGPR file and then
+    * allocates vectors, so that many live ranges have to be split. Use
+    * --no-check to see the results.
+    */
+   const unsigned num_scalars = 200;
+   const unsigned num_vectors = 20;
+   const unsigned iterations = 16;
+
+   uint64_t total_ns = 0;
+   for (unsigned iter = 0; iter < iterations; iter++) {
+      if (!setup_cs(NULL, GFX10))
+         return;
+
+      std::vector<Temp> scalars;
+      for (unsigned i = 0; i < num_scalars; i++)
+         scalars.push_back(bld.vop1(aco_opcode::v_mov_b32, bld.def(v1), Operand(i)));
+
+      /* kill every other scalar to leave single-register holes */
+      unsigned idx = 0;
+      for (unsigned i = 1; i < num_scalars; i += 2)
+         writeout(idx++, scalars[i]);
+
+      std::vector<Temp> vectors;
+      for (unsigned i = 0; i < num_vectors; i++)
+         vectors.push_back(bld.pseudo(aco_opcode::p_create_vector, bld.def(v4),
+                                      Operand(i), Operand(i + 1), Operand(i + 2), Operand(i + 3)));
+
+      for (unsigned i = 0; i < num_scalars; i += 2)
+         writeout(idx++, scalars[i]);
+      for (Temp vec : vectors)
+         writeout(idx++, vec);
+
+      finish_program(program.get());
+      program->workgroup_size = program->wave_size;
+
+      int64_t start = os_time_get_nano();
+      aco::live live_vars = aco::live_var_analysis(program.get());
+      aco::register_allocation(program.get(), live_vars.live_out);
+      total_ns += os_time_get_nano() - start;
+
+      if (aco::validate_ra(program.get())) {
+         fail_test("Validation after register allocation failed");
+         return;
+      }
+   }
+
+   fprintf(output, "register allocation: %" PRIu64 " us per program (%u iterations)\n",
+           total_ns / 1000 / iterations, iterations);
+END_TEST
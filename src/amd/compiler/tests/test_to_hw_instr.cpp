@@ -474,6 +474,39 @@ BEGIN_TEST(to_hw_instr.subdword_constant)
    }
 END_TEST
 
+BEGIN_TEST(to_hw_instr.pack2x16_perm)
+   if (!setup_cs(NULL, GFX10))
+      return;
+
+   /* v_pack_b32_f16 flushes denormals */
+   program->blocks[0].fp_mode.denorm16_64 = fp_denorm_flush;
+
+   PhysReg v0_lo{256};
+   PhysReg v0_hi{256};
+   PhysReg v1_lo{257};
+   PhysReg v2_hi{258};
+   v0_hi.reg_b += 2;
+   v2_hi.reg_b += 2;
+
+   //>> p_unit_test 0
+   //! v1: %0:v[0] = v_perm_b32 %0:v[2], %0:v[1], 0x7060100
+   bld.pseudo(aco_opcode::p_unit_test, Operand(0u));
+   bld.pseudo(aco_opcode::p_parallelcopy,
+              Definition(v0_lo, v2b), Definition(v0_hi, v2b),
+              Operand(v1_lo, v2b), Operand(v2_hi, v2b));
+
+   //! p_unit_test 1
+   //! v1: %0:v[0] = v_perm_b32 %0:v[0], %0:v[1], 0x5040100
+   bld.pseudo(aco_opcode::p_unit_test, Operand(1u));
+   bld.pseudo(aco_opcode::p_parallelcopy,
+              Definition(v0_lo, v2b), Definition(v0_hi, v2b),
+              Operand(v1_lo, v2b), Operand(v0_lo, v2b));
+
+   //! s_endpgm
+
+   finish_to_hw_instr_test();
+END_TEST
+
 BEGIN_TEST(to_hw_instr.self_intersecting_swap)
    if (!setup_cs(NULL, GFX9))
       return;
@@ -77,6 +77,8 @@ enum {
    RADV_PERFTEST_NO_SAM = 1u << 8,
    RADV_PERFTEST_SAM = 1u << 9,
    RADV_PERFTEST_DCC_STORES = 1u << 10,
+   RADV_PERFTEST_PARALLEL_ISEL = 1u << 11,
+   RADV_PERFTEST_ACO_CACHE = 1u << 12,
 };
 
 bool radv_init_trace(struct radv_device *device);
@@ -799,7 +799,9 @@ static const struct debug_control radv_perftest_options[] = {
    {"cswave32", RADV_PERFTEST_CS_WAVE_32},  {"pswave32", RADV_PERFTEST_PS_WAVE_32},
    {"gewave32", RADV_PERFTEST_GE_WAVE_32},  {"dfsm", RADV_PERFTEST_DFSM},
    {"nosam", RADV_PERFTEST_NO_SAM},         {"sam", RADV_PERFTEST_SAM},
-   {"dccstores", RADV_PERFTEST_DCC_STORES}, {NULL, 0}};
+   {"dccstores", RADV_PERFTEST_DCC_STORES}, {"parallelisel", RADV_PERFTEST_PARALLEL_ISEL},
+   {"acocache", RADV_PERFTEST_ACO_CACHE},
+   {NULL, 0}};
 
 const char *
 radv_get_perftest_option_name(int id)
@@ -1328,6 +1328,8 @@ shader_variant_compile(struct radv_device *device, struct vk_shader_module *modu
       options->dump_shader && device->instance->debug_flags & RADV_DEBUG_PREOPTIR;
    options->record_ir = keep_shader_info;
    options->record_stats = keep_statistic_info;
+   options->parallel_isel = device->instance->perftest_flags & RADV_PERFTEST_PARALLEL_ISEL;
+   options->aco_binary_cache = device->instance->perftest_flags & RADV_PERFTEST_ACO_CACHE;
    options->check_ir = device->instance->debug_flags & RADV_DEBUG_CHECKIR;
    options->tess_offchip_block_dw_size = device->tess_offchip_block_dw_size;
    options->address32_hi = device->physical_device->rad_info.address32_hi;
@@ -137,6 +137,8 @@ struct radv_nir_compiler_options {
    bool use_ngg_streamout;
    bool enable_mrt_output_nan_fixup;
    bool disable_optimizations; /* only used by ACO */
+   bool parallel_isel; /* only used by ACO */
+   bool aco_binary_cache; /* only used by ACO */
    bool wgp_mode;
    enum radeon_family family;
    enum chip_class chip_class;
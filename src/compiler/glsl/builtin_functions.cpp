@@ -39,7 +39,8 @@
  *
  *    The builtin_builder::create_builtins() function contains lists of all
  *    built-in function signatures, where they're available, what types they
- *    take, and so on.
+ *    take, and so on.  Apart from the intrinsics, a function's signatures
+ *    are only generated once a shader that can use them looks it up.
  *
  * 4. Implementations of built-in function signatures
  *
@@ -83,6 +84,7 @@
 #include <math.h>
 #include "builtin_functions.h"
 #include "util/hash_table.h"
+#include "util/set.h"
 
 #define M_PIf   ((float) M_PI)
 #define M_PI_2f ((float) M_PI_2)
@@ -888,6 +890,13 @@ is_not_nir(const _mesa_glsl_parse_state *state)
 
 namespace {
 
+/**
+ * Returned by a signature generator instead of a signature which isn't
+ * available to the shader it runs for.  add_function() drops it.
+ */
+static char skipped_signature;
+#define SKIPPED_SIGNATURE ((ir_function_signature *) &skipped_signature)
+
 /**
  * builtin_builder: A singleton object representing the core of the built-in
  * function module.
@@ -904,6 +913,8 @@ public:
    void release();
    ir_function_signature *find(_mesa_glsl_parse_state *state,
                                const char *name, exec_list *actual_parameters);
+   ir_function *get_function(_mesa_glsl_parse_state *state,
+                             const char *name);
 
    /**
     * A shader to hold all the built-in signatures; created by this module.
@@ -917,9 +928,44 @@ public:
 private:
    void *mem_ctx;
 
+   /**
+    * Names of the built-in functions with signatures that haven't been
+    * generated yet, each mapped to the set of availability predicates whose
+    * signatures already have been.  Generating every signature up front takes
+    * a lot of time and memory, and most shaders only use a handful of
+    * built-ins.
+    */
+   struct hash_table *pending_functions;
+
+   /**
+    * Availability predicates of the signatures generated by the current
+    * create_builtins() pass.
+    */
+   struct set *pass_predicates;
+
+   /**
+    * When set, create_builtins() only records the function names in
+    * pending_functions instead of generating any signatures.
+    */
+   bool collecting_names;
+
+   /**
+    * When not NULL, the only function create_builtins() generates the
+    * signatures of, and the shader they are generated for.  Signatures which
+    * aren't available to that shader are skipped until another shader needs
+    * them.
+    */
+   const char *wanted_function;
+   const _mesa_glsl_parse_state *wanted_state;
+   struct set *built_predicates;
+   bool wanted_function_added;
+   bool skipped_signatures;
+
    void create_shader();
    void create_intrinsics();
    void create_builtins();
+   bool wants_function(const char *name);
+   bool wants_signature(builtin_available_predicate avail);
 
    /**
     * IR builder helpers:
@@ -1292,6 +1338,14 @@ builtin_builder::builtin_builder()
    : shader(NULL)
 {
    mem_ctx = NULL;
+   pending_functions = NULL;
+   pass_predicates = NULL;
+   collecting_names = false;
+   wanted_function = NULL;
+   wanted_state = NULL;
+   built_predicates = NULL;
+   wanted_function_added = false;
+   skipped_signatures = false;
 }
 
 builtin_builder::~builtin_builder()
@@ -1312,7 +1366,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = shader->symbols->get_function(name);
+   ir_function *f = get_function(state, name);
    if (f == NULL)
       return NULL;
 
@@ -1324,6 +1378,80 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
    return sig;
 }
 
+/**
+ * Look up a built-in function by name, first generating the signatures
+ * that are available to \p state if that hasn't happened yet.
+ */
+ir_function *
+builtin_builder::get_function(_mesa_glsl_parse_state *state,
+                              const char *name)
+{
+   struct hash_entry *entry = _mesa_hash_table_search(pending_functions, name);
+   if (entry != NULL) {
+      if (entry->data == NULL)
+         entry->data = _mesa_pointer_set_create(mem_ctx);
+
+      wanted_function = name;
+      wanted_state = state;
+      built_predicates = (struct set *) entry->data;
+      wanted_function_added = false;
+      skipped_signatures = false;
+
+      create_builtins();
+
+      set_foreach(pass_predicates, pred)
+         _mesa_set_add(built_predicates, pred->key);
+      _mesa_set_clear(pass_predicates, NULL);
+
+      /* Once nothing was left out, the function is complete. */
+      if (!skipped_signatures)
+         _mesa_hash_table_remove(pending_functions, entry);
+
+      wanted_function = NULL;
+      wanted_state = NULL;
+      built_predicates = NULL;
+   }
+
+   return shader->symbols->get_function(name);
+}
+
+bool
+builtin_builder::wants_function(const char *name)
+{
+   if (collecting_names) {
+      _mesa_hash_table_insert(pending_functions, name, NULL);
+      return false;
+   }
+
+   /* Only the first list of signatures for a name counts; the symbol table
+    * never accepted a second function of the same name.
+    */
+   return wanted_function == NULL ||
+          (!wanted_function_added && strcmp(name, wanted_function) == 0);
+}
+
+/**
+ * Whether the signature generator for a signature with the given
+ * availability predicate should build it in the current pass.
+ */
+bool
+builtin_builder::wants_signature(builtin_available_predicate avail)
+{
+   if (wanted_state == NULL)
+      return true;
+
+   if (_mesa_set_search(built_predicates, (void *) avail))
+      return false;
+
+   if (!avail(wanted_state)) {
+      skipped_signatures = true;
+      return false;
+   }
+
+   _mesa_set_add(pass_predicates, (void *) avail);
+   return true;
+}
+
 void
 builtin_builder::initialize()
 {
@@ -1336,7 +1464,16 @@ builtin_builder::initialize()
    mem_ctx = ralloc_context(NULL);
    create_shader();
    create_intrinsics();
+
+   /* Only remember which functions exist; get_function() generates their
+    * signatures on first use.
+    */
+   pending_functions = _mesa_hash_table_create(mem_ctx, _mesa_hash_string,
+                                               _mesa_key_string_equal);
+   pass_predicates = _mesa_pointer_set_create(mem_ctx);
+   collecting_names = true;
    create_builtins();
+   collecting_names = false;
 }
 
 void
@@ -1344,6 +1481,8 @@ builtin_builder::release()
 {
    ralloc_free(mem_ctx);
    mem_ctx = NULL;
+   pending_functions = NULL;
+   pass_predicates = NULL;
 
    ralloc_free(shader);
    shader = NULL;
@@ -1619,6 +1758,13 @@ builtin_builder::create_intrinsics()
 void
 builtin_builder::create_builtins()
 {
+/* Skip evaluating the signatures of every function but the wanted one. */
+#define add_function(NAME, ...)                 \
+   do {                                         \
+      if (wants_function(NAME))                 \
+         add_function(NAME, __VA_ARGS__);       \
+   } while (0)
+
 #define F(NAME)                                 \
    add_function(#NAME,                          \
                 _##NAME(glsl_type::float_type), \
@@ -4673,6 +4819,7 @@ builtin_builder::create_builtins()
 #undef FIUD_VEC
 #undef FIUBD_VEC
 #undef FIU2_MIXED
+#undef add_function
 }
 
 void
@@ -4680,7 +4827,16 @@ builtin_builder::add_function(const char *name, ...)
 {
    va_list ap;
 
-   ir_function *f = new(mem_ctx) ir_function(name);
+   /* Signatures generated for another shader went into the same function
+    * before.
+    */
+   ir_function *f = shader->symbols->get_function(name);
+   bool new_function = f == NULL;
+   if (new_function)
+      f = new(mem_ctx) ir_function(name);
+
+   if (wanted_function != NULL)
+      wanted_function_added = true;
 
    va_start(ap, name);
    while (true) {
@@ -4688,6 +4844,9 @@ builtin_builder::add_function(const char *name, ...)
       if (sig == NULL)
          break;
 
+      if (sig == SKIPPED_SIGNATURE)
+         continue;
+
       if (false) {
          exec_list stuff;
          stuff.push_tail(sig);
@@ -4698,7 +4857,8 @@ builtin_builder::add_function(const char *name, ...)
    }
    va_end(ap);
 
-   shader->symbols->add_function(f);
+   if (new_function)
+      shader->symbols->add_function(f);
 }
 
 void
@@ -4745,6 +4905,9 @@ builtin_builder::add_image_function(const char *name,
       glsl_type::uimage2DMSArray_type
    };
 
+   if (!wants_function(name))
+      return;
+
    ir_function *f = new(mem_ctx) ir_function(name);
 
    for (unsigned i = 0; i < ARRAY_SIZE(types); ++i) {
@@ -4964,12 +5127,16 @@ builtin_builder::new_sig(const glsl_type *return_type,
 }
 
 #define MAKE_SIG(return_type, avail, ...)  \
+   if (!wants_signature(avail))               \
+      return SKIPPED_SIGNATURE;               \
    ir_function_signature *sig =               \
       new_sig(return_type, avail, __VA_ARGS__);      \
    ir_factory body(&sig->body, mem_ctx);             \
    sig->is_defined = true;
 
 #define MAKE_INTRINSIC(return_type, id, avail, ...)  \
+   if (!wants_signature(avail))                      \
+      return SKIPPED_SIGNATURE;                      \
    ir_function_signature *sig =                      \
       new_sig(return_type, avail, __VA_ARGS__);      \
    sig->intrinsic_id = id;
@@ -7797,7 +7964,7 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    ir_function *f;
    bool ret = false;
    mtx_lock(&builtins_lock);
-   f = builtins.shader->symbols->get_function(name);
+   f = builtins.get_function(state, name);
    if (f != NULL) {
       foreach_in_list(ir_function_signature, sig, &f->signatures) {
          if (sig->is_builtin_available(state)) {
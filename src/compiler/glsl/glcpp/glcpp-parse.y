@@ -118,6 +118,9 @@ _parser_active_list_pop(glcpp_parser_t *parser);
 static int
 _parser_active_list_contains(glcpp_parser_t *parser, const char *identifier);
 
+static macro_t *
+_glcpp_parser_lookup_macro(glcpp_parser_t *parser, const char *identifier);
+
 typedef enum {
    EXPANSION_MODE_IGNORE_DEFINED,
    EXPANSION_MODE_EVALUATE_DEFINED
@@ -344,7 +347,8 @@ control_line_success:
 			}
 		}
 
-		entry = _mesa_hash_table_search (parser->defines, $3);
+		entry = _mesa_hash_table_search (parser->defines,
+						 glcpp_parser_intern (parser, $3));
 		if (entry) {
 			_mesa_hash_table_remove (parser->defines, entry);
 		}
@@ -373,6 +377,11 @@ control_line_success:
 			tmp_parser->version_set = true;
 			tmp_parser->version = parser->version;
 
+			/* Share the interned identifiers, so that macros can
+			 * be copied between the parsers.
+			 */
+			tmp_parser->identifiers = parser->identifiers;
+
 			/* Set the shader source and run the lexer */
 			glcpp_lex_set_source_string(tmp_parser, shader);
 
@@ -455,15 +464,11 @@ control_line_success:
 		_glcpp_parser_skip_stack_push_if (parser, & @1, 0);
 	}
 |	HASH_TOKEN IFDEF IDENTIFIER junk NEWLINE {
-		struct hash_entry *entry =
-				_mesa_hash_table_search(parser->defines, $3);
-		macro_t *macro = entry ? entry->data : NULL;
+		macro_t *macro = _glcpp_parser_lookup_macro (parser, $3);
 		_glcpp_parser_skip_stack_push_if (parser, & @1, macro != NULL);
 	}
 |	HASH_TOKEN IFNDEF IDENTIFIER junk NEWLINE {
-		struct hash_entry *entry =
-				_mesa_hash_table_search(parser->defines, $3);
-		macro_t *macro = entry ? entry->data : NULL;
+		macro_t *macro = _glcpp_parser_lookup_macro (parser, $3);
 		_glcpp_parser_skip_stack_push_if (parser, & @3, macro == NULL);
 	}
 |	HASH_TOKEN ELIF pp_tokens NEWLINE {
@@ -888,7 +893,7 @@ _string_list_append_item(glcpp_parser_t *parser, string_list_t *list,
    string_node_t *node;
 
    node = linear_alloc_child(parser->linalloc, sizeof(string_node_t));
-   node->str = linear_strdup(parser->linalloc, str);
+   node->str = glcpp_parser_intern(parser, str);
 
    node->next = NULL;
 
@@ -910,8 +915,11 @@ _string_list_contains(string_list_t *list, const char *member, int *index)
    if (list == NULL)
       return 0;
 
+   /* Both the parameters and the identifiers looked up here are interned,
+    * so comparing the pointers is enough.
+    */
    for (i = 0, node = list->head; node; i++, node = node->next) {
-      if (strcmp (node->str, member) == 0) {
+      if (node->str == member) {
          if (index)
             *index = i;
          return 1;
@@ -1415,6 +1423,9 @@ _token_paste(glcpp_parser_t *parser, token_t *token, token_t *other)
       if (combined_type == INTEGER)
          combined_type = INTEGER_STRING;
 
+      if (combined_type == IDENTIFIER)
+         str = (char *) glcpp_parser_intern(parser, str);
+
       combined = _token_create_str (parser, combined_type, str);
       combined->location = token->location;
       return combined;
@@ -1467,6 +1478,37 @@ add_builtin_define(glcpp_parser_t *parser, const char *name, int value)
  */
 #define INITIAL_PP_OUTPUT_BUF_SIZE 4048
 
+const char *
+glcpp_parser_intern(glcpp_parser_t *parser, const char *str)
+{
+   uint32_t hash = _mesa_hash_string(str);
+   struct set_entry *entry;
+
+   entry = _mesa_set_search_pre_hashed(parser->identifiers, hash, str);
+   if (entry)
+      return entry->key;
+
+   str = linear_strdup(parser->linalloc, str);
+   _mesa_set_add_pre_hashed(parser->identifiers, hash, str);
+   return str;
+}
+
+/* Look up the macro defined for an interned identifier, if any. */
+static macro_t *
+_glcpp_parser_lookup_macro(glcpp_parser_t *parser, const char *identifier)
+{
+   struct hash_entry *entry;
+
+#ifndef NDEBUG
+   struct set_entry *interned = _mesa_set_search(parser->identifiers,
+                                                 identifier);
+   assert(interned != NULL && interned->key == identifier);
+#endif
+
+   entry = _mesa_hash_table_search(parser->defines, identifier);
+   return entry ? entry->data : NULL;
+}
+
 glcpp_parser_t *
 glcpp_parser_create(struct gl_context *gl_ctx,
                     glcpp_extension_iterator extensions, void *state)
@@ -1476,8 +1518,10 @@ glcpp_parser_create(struct gl_context *gl_ctx,
    parser = ralloc (NULL, glcpp_parser_t);
 
    glcpp_lex_init_extra (parser, &parser->scanner);
-   parser->defines = _mesa_hash_table_create(NULL, _mesa_hash_string,
-                                             _mesa_key_string_equal);
+   parser->defines = _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                                             _mesa_key_pointer_equal);
+   parser->identifiers = _mesa_set_create(parser, _mesa_hash_string,
+                                          _mesa_key_string_equal);
    parser->linalloc = linear_alloc_parent(parser, 0);
    parser->active = NULL;
    parser->lexing_directive = 0;
@@ -1705,8 +1749,10 @@ _glcpp_parser_evaluate_defined(glcpp_parser_t *parser, token_node_t *node,
 
    *last = node;
 
-   return _mesa_hash_table_search(parser->defines,
-                                  argument->token->value.str) ? 1 : 0;
+   /* The argument may be an OTHER token, which isn't interned. */
+   return _glcpp_parser_lookup_macro(parser,
+                                     glcpp_parser_intern(parser,
+                                                         argument->token->value.str)) ? 1 : 0;
 
 FAIL:
    glcpp_error (&defined->token->location, parser,
@@ -1847,7 +1893,6 @@ static token_list_t *
 _glcpp_parser_expand_function(glcpp_parser_t *parser, token_node_t *node,
                               token_node_t **last, expansion_mode_t mode)
 {
-   struct hash_entry *entry;
    macro_t *macro;
    const char *identifier;
    argument_list_t *arguments;
@@ -1857,8 +1902,7 @@ _glcpp_parser_expand_function(glcpp_parser_t *parser, token_node_t *node,
 
    identifier = node->token->value.str;
 
-   entry = _mesa_hash_table_search(parser->defines, identifier);
-   macro = entry ? entry->data : NULL;
+   macro = _glcpp_parser_lookup_macro(parser, identifier);
 
    assert(macro->is_function);
 
@@ -1955,7 +1999,6 @@ _glcpp_parser_expand_node(glcpp_parser_t *parser, token_node_t *node,
 {
    token_t *token = node->token;
    const char *identifier;
-   struct hash_entry *entry;
    macro_t *macro;
 
    /* We only expand identifiers */
@@ -1978,8 +2021,7 @@ _glcpp_parser_expand_node(glcpp_parser_t *parser, token_node_t *node,
    }
 
    /* Look up this identifier in the hash table. */
-   entry = _mesa_hash_table_search(parser->defines, identifier);
-   macro = entry ? entry->data : NULL;
+   macro = _glcpp_parser_lookup_macro(parser, identifier);
 
    /* Not a macro, so no expansion needed. */
    if (macro == NULL)
@@ -2030,7 +2072,7 @@ _parser_active_list_push(glcpp_parser_t *parser, const char *identifier,
    active_list_t *node;
 
    node = linear_alloc_child(parser->linalloc, sizeof(active_list_t));
-   node->identifier = linear_strdup(parser->linalloc, identifier);
+   node->identifier = identifier;
    node->marker = marker;
    node->next = parser->active;
 
@@ -2059,8 +2101,9 @@ _parser_active_list_contains(glcpp_parser_t *parser, const char *identifier)
    if (parser->active == NULL)
       return 0;
 
+   /* Only interned identifiers are expanded, so compare the pointers. */
    for (node = parser->active; node; node = node->next)
-      if (strcmp(node->identifier, identifier) == 0)
+      if (node->identifier == identifier)
          return 1;
 
    return 0;
@@ -2242,10 +2285,10 @@ _define_object_macro(glcpp_parser_t *parser, YYLTYPE *loc,
 
    macro->is_function = 0;
    macro->parameters = NULL;
-   macro->identifier = linear_strdup(parser->linalloc, identifier);
+   macro->identifier = glcpp_parser_intern(parser, identifier);
    macro->replacements = replacements;
 
-   entry = _mesa_hash_table_search(parser->defines, identifier);
+   entry = _mesa_hash_table_search(parser->defines, macro->identifier);
    previous = entry ? entry->data : NULL;
    if (previous) {
       if (_macro_equal (macro, previous)) {
@@ -2254,7 +2297,7 @@ _define_object_macro(glcpp_parser_t *parser, YYLTYPE *loc,
       glcpp_error (loc, parser, "Redefinition of macro %s\n",  identifier);
    }
 
-   _mesa_hash_table_insert (parser->defines, identifier, macro);
+   _mesa_hash_table_insert (parser->defines, macro->identifier, macro);
 }
 
 void
@@ -2277,10 +2320,10 @@ _define_function_macro(glcpp_parser_t *parser, YYLTYPE *loc,
 
    macro->is_function = 1;
    macro->parameters = parameters;
-   macro->identifier = linear_strdup(parser->linalloc, identifier);
+   macro->identifier = glcpp_parser_intern(parser, identifier);
    macro->replacements = replacements;
 
-   entry = _mesa_hash_table_search(parser->defines, identifier);
+   entry = _mesa_hash_table_search(parser->defines, macro->identifier);
    previous = entry ? entry->data : NULL;
    if (previous) {
       if (_macro_equal (macro, previous)) {
@@ -2289,7 +2332,7 @@ _define_function_macro(glcpp_parser_t *parser, YYLTYPE *loc,
       glcpp_error (loc, parser, "Redefinition of macro %s\n", identifier);
    }
 
-   _mesa_hash_table_insert(parser->defines, identifier, macro);
+   _mesa_hash_table_insert(parser->defines, macro->identifier, macro);
 }
 
 static int
@@ -2335,9 +2378,7 @@ glcpp_parser_lex(YYSTYPE *yylval, YYLTYPE *yylloc, glcpp_parser_t *parser)
                ret == ENDIF || ret == HASH_TOKEN) {
          parser->in_control_line = 1;
       } else if (ret == IDENTIFIER) {
-         struct hash_entry *entry = _mesa_hash_table_search(parser->defines,
-                                                            yylval->str);
-         macro_t *macro = entry ? entry->data : NULL;
+         macro_t *macro = _glcpp_parser_lookup_macro(parser, yylval->str);
          if (macro && macro->is_function) {
             parser->newline_as_space = 1;
             parser->paren_count = 0;
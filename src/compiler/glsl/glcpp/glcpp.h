@@ -32,6 +32,7 @@
 #include "util/ralloc.h"
 
 #include "util/hash_table.h"
+#include "util/set.h"
 
 #include "util/string_buffer.h"
 
@@ -188,6 +189,9 @@ struct glcpp_parser {
 	void *linalloc;
 	yyscan_t scanner;
 	struct hash_table *defines;
+	/* Identifiers are interned, so the macros defined for them are looked
+	 * up by pointer. Shared with the parsers of included sources. */
+	struct set *identifiers;
 	active_list_t *active;
 	int lexing_directive;
 	int lexing_version_directive;
@@ -236,6 +240,9 @@ glcpp_parser_create(struct gl_context *gl_ctx,
 int
 glcpp_parser_parse (glcpp_parser_t *parser);
 
+const char *
+glcpp_parser_intern(glcpp_parser_t *parser, const char *str);
+
 void
 glcpp_parser_destroy (glcpp_parser_t *parser);
 
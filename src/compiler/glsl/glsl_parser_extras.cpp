@@ -32,12 +32,17 @@
 #include "main/shaderobj.h"
 #include "util/u_atomic.h" /* for p_atomic_cmpxchg */
 #include "util/ralloc.h"
+#include "util/debug.h"
 #include "util/disk_cache.h"
 #include "util/mesa-sha1.h"
+#include "util/os_misc.h"
+#include "util/os_time.h"
+#include "util/set.h"
 #include "ast.h"
 #include "glsl_parser_extras.h"
 #include "glsl_parser.h"
 #include "ir_optimization.h"
+#include "program.h"
 #include "loop_analysis.h"
 #include "builtin_functions.h"
 
@@ -2078,9 +2083,12 @@ opt_shader_and_create_symbol_table(struct gl_context *ctx,
                              ctx->Const.NativeIntegers);
    } else {
       /* Repeat it until it stops making changes. */
+      struct set *clean_functions = _mesa_pointer_set_create(NULL);
       while (do_common_optimization(shader->ir, false, false, options,
-                                    ctx->Const.NativeIntegers))
+                                    ctx->Const.NativeIntegers,
+                                    clean_functions))
          ;
+      _mesa_set_destroy(clean_functions, NULL);
    }
 
    validate_ir_tree(shader->ir);
@@ -2122,6 +2130,43 @@ opt_shader_and_create_symbol_table(struct gl_context *ctx,
                                       shader->symbols);
 }
 
+/**
+ * Compute the key recording that \c source is known to compile.
+ *
+ * Besides the source itself, whether it compiles depends on its stage and
+ * on the language versions and extensions the context exposes, so those
+ * are hashed as well.  Otherwise a source which once compiled could have
+ * its compile deferred in a setup it fails to compile with, and the error
+ * would only show up at link time.
+ */
+static void
+compute_shader_key(struct gl_context *ctx, struct gl_shader *shader,
+                   const char *source)
+{
+   unsigned char source_sha1[20];
+   char sha1buf[41];
+
+   _mesa_sha1_compute(source, strlen(source), source_sha1);
+
+   char *buf = ralloc_asprintf(NULL, "stage: %d api: %d glsl: %d fglsl: %d\n",
+                               shader->Stage, ctx->API,
+                               ctx->Const.GLSLVersion,
+                               ctx->Const.ForceGLSLVersion);
+
+   const char *ext_override = os_get_option("MESA_EXTENSION_OVERRIDE");
+   if (ext_override)
+      ralloc_asprintf_append(&buf, "ext:%s\n", ext_override);
+
+   _mesa_sha1_format(sha1buf, ctx->Const.dri_config_options_sha1);
+   ralloc_asprintf_append(&buf, "driconf: %s\n", sha1buf);
+
+   _mesa_sha1_format(sha1buf, source_sha1);
+   ralloc_asprintf_append(&buf, "source: %s\n", sha1buf);
+
+   disk_cache_compute_key(ctx->Cache, buf, strlen(buf), shader->sha1);
+   ralloc_free(buf);
+}
+
 static bool
 can_skip_compile(struct gl_context *ctx, struct gl_shader *shader,
                  const char *source, bool force_recompile,
@@ -2130,8 +2175,7 @@ can_skip_compile(struct gl_context *ctx, struct gl_shader *shader,
    if (!force_recompile) {
       if (ctx->Cache) {
          char buf[41];
-         disk_cache_compute_key(ctx->Cache, source, strlen(source),
-                                shader->sha1);
+         compute_shader_key(ctx, shader, source);
          if (disk_cache_has_key(ctx->Cache, shader->sha1)) {
             /* We've seen this shader before and know it compiles */
             if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
@@ -2166,6 +2210,26 @@ can_skip_compile(struct gl_context *ctx, struct gl_shader *shader,
 void
 _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
                           bool dump_ast, bool dump_hir, bool force_recompile)
+{
+   _mesa_glsl_compile_shader_timed(ctx, shader, dump_ast, dump_hir,
+                                   force_recompile, NULL);
+}
+
+/* Adds the time elapsed since *start to *phase and restarts the clock. */
+static void
+add_phase_time(int64_t *phase, int64_t *start)
+{
+   int64_t now = os_time_get_nano();
+   *phase += now - *start;
+   *start = now;
+}
+
+void
+_mesa_glsl_compile_shader_timed(struct gl_context *ctx,
+                                struct gl_shader *shader,
+                                bool dump_ast, bool dump_hir,
+                                bool force_recompile,
+                                struct glsl_compile_timings *timings)
 {
    const char *source = force_recompile && shader->FallbackSource ?
       shader->FallbackSource : shader->Source;
@@ -2192,11 +2256,16 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
       (void) p_atomic_cmpxchg(&ir_variable::temporaries_allocate_names,
                               false, true);
 
+   struct glsl_compile_timings elapsed = {};
+   int64_t start = os_time_get_nano();
+
    if (!source_has_shader_include || !force_recompile) {
       state->error = glcpp_preprocess(state, &source, &state->info_log,
                                       add_builtin_defines, state, ctx);
    }
 
+   add_phase_time(&elapsed.preprocess, &start);
+
    /* Now that we have run the preprocessor we can check the shader cache and
     * skip compilation if possible for those shaders that contained a shader
     * include.
@@ -2212,6 +2281,8 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
      do_late_parsing_checks(state);
    }
 
+   add_phase_time(&elapsed.parse, &start);
+
    if (dump_ast) {
       foreach_list_typed(ast_node, ast, link, &state->translation_unit) {
          ast->print();
@@ -2221,6 +2292,21 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
 
    ralloc_free(shader->ir);
    shader->ir = new(shader) exec_list;
+
+   /* Most IR nodes live until the shader is recompiled or deleted, so
+    * allocate them from an arena going away with the IR list, rather
+    * than with a malloc each.
+    */
+   static const bool use_ir_arena =
+      env_var_as_boolean("MESA_GLSL_IR_ARENA", true);
+   if (use_ir_arena) {
+      void *arena = ralloc_arena_create(shader->ir);
+      if (arena) {
+         ralloc_use_arena(shader->ir, arena);
+         ralloc_use_arena(state, arena);
+      }
+   }
+
    if (!state->error && !state->translation_unit.is_empty())
       _mesa_ast_to_hir(shader->ir, state);
 
@@ -2239,6 +2325,8 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
    if (!state->error)
       set_shader_inout_layout(shader, state);
 
+   add_phase_time(&elapsed.ast_to_hir, &start);
+
    shader->symbols = new(shader->ir) glsl_symbol_table;
    shader->CompileStatus = state->error ? COMPILE_FAILURE : COMPILE_SUCCESS;
    shader->InfoLog = state->info_log;
@@ -2258,6 +2346,15 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
       opt_shader_and_create_symbol_table(ctx, state->symbols, shader);
    }
 
+   add_phase_time(&elapsed.optimize, &start);
+
+   if (timings) {
+      timings->preprocess += elapsed.preprocess;
+      timings->parse += elapsed.parse;
+      timings->ast_to_hir += elapsed.ast_to_hir;
+      timings->optimize += elapsed.optimize;
+   }
+
    if (!force_recompile) {
       free((void *)shader->FallbackSource);
 
@@ -2282,6 +2379,188 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
 }
 
 } /* extern "C" */
+
+namespace {
+
+/**
+ * The functions the function-local passes of do_common_optimization() have
+ * to visit.
+ *
+ * Without a set of clean functions this is just the whole instruction list.
+ * Otherwise every function which isn't known to be optimized already is
+ * detached in turn into a list of its own for the pass to run on, so that
+ * the pass neither walks the clean functions nor hides which function it
+ * changed.
+ */
+class dirty_function_list {
+public:
+   dirty_function_list(exec_list *ir, struct set *clean_functions)
+      : ir(ir), clean_functions(clean_functions), functions(NULL),
+        changed(NULL), num_functions(0), capacity(0), prev_node(NULL),
+        global_progress(false)
+   {
+      if (clean_functions == NULL)
+         return;
+
+      /* Before linking, global initializers still live at global scope.
+       * Anything besides functions and declarations there isn't visited
+       * when running on single functions, so fall back to the whole list.
+       */
+      foreach_in_list(ir_instruction, node, ir) {
+         if (node->ir_type != ir_type_function &&
+             node->ir_type != ir_type_variable) {
+            _mesa_set_clear(clean_functions, NULL);
+            this->clean_functions = NULL;
+            return;
+         }
+      }
+
+      gather(false);
+   }
+
+   ~dirty_function_list()
+   {
+      free(functions);
+      free(changed);
+   }
+
+   unsigned count() const
+   {
+      return clean_functions != NULL ? num_functions : 1;
+   }
+
+   exec_list *enter(unsigned i)
+   {
+      if (clean_functions == NULL)
+         return ir;
+
+      prev_node = functions[i]->prev;
+      functions[i]->remove();
+      single.push_tail(functions[i]);
+      return &single;
+   }
+
+   void leave(unsigned i, bool progress)
+   {
+      if (clean_functions == NULL)
+         return;
+
+      functions[i]->remove();
+      prev_node->insert_after(functions[i]);
+      changed[i] |= progress;
+   }
+
+   /**
+    * A pass working across functions made progress, which may have created
+    * opportunities in any function.
+    */
+   void mark_all_dirty()
+   {
+      if (clean_functions == NULL)
+         return;
+
+      global_progress = true;
+      gather(true);
+   }
+
+   /**
+    * Record which of the visited functions no function-local pass changed.
+    * Those don't need to be visited again, unless a pass working across
+    * functions makes progress.
+    */
+   void update_clean_functions()
+   {
+      if (clean_functions == NULL)
+         return;
+
+      if (global_progress) {
+         _mesa_set_clear(clean_functions, NULL);
+         return;
+      }
+
+      for (unsigned i = 0; i < num_functions; i++) {
+         if (!changed[i])
+            _mesa_set_add(clean_functions, functions[i]);
+      }
+   }
+
+private:
+   void gather(bool all)
+   {
+      num_functions = 0;
+      foreach_in_list(ir_instruction, node, ir) {
+         ir_function *f = node->as_function();
+         if (f == NULL || (!all && _mesa_set_search(clean_functions, f)))
+            continue;
+
+         if (num_functions == capacity) {
+            capacity = MAX2(capacity * 2, 8);
+            functions = (ir_function **)
+               realloc(functions, capacity * sizeof(*functions));
+            changed = (bool *) realloc(changed, capacity * sizeof(*changed));
+         }
+
+         functions[num_functions] = f;
+         changed[num_functions] = false;
+         num_functions++;
+      }
+   }
+
+   exec_list *ir;
+   struct set *clean_functions;
+   ir_function **functions;
+   bool *changed;
+   unsigned num_functions;
+   unsigned capacity;
+
+   /** List holding the function a pass currently runs on. */
+   exec_list single;
+   exec_node *prev_node;
+
+   bool global_progress;
+};
+
+} /* anonymous namespace */
+
+static bool
+unroll_and_cleanup_loops(exec_list *ir,
+                         const struct gl_shader_compiler_options *options)
+{
+   bool progress = false;
+
+   loop_state *ls = analyze_loop_variables(ir);
+   if (ls->loop_found) {
+      bool loop_progress = unroll_loops(ir, ls, options);
+      while (loop_progress) {
+         loop_progress = false;
+         loop_progress |= do_constant_propagation(ir);
+         loop_progress |= do_if_simplification(ir);
+
+         /* Some drivers only call do_common_optimization() once rather
+          * than in a loop. So we must call do_lower_jumps() after
+          * unrolling a loop because for drivers that use LLVM validation
+          * will fail if a jump is not the last instruction in the block.
+          * For example the following will fail LLVM validation:
+          *
+          *   (loop (
+          *      ...
+          *   break
+          *   (assign  (x) (var_ref v124)  (expression int + (var_ref v124)
+          *      (constant int (1)) ) )
+          *   ))
+          */
+         loop_progress |= do_lower_jumps(ir, true, true,
+                                         options->EmitNoMainReturn,
+                                         options->EmitNoCont,
+                                         options->EmitNoLoops);
+      }
+      progress |= loop_progress;
+   }
+   delete ls;
+
+   return progress;
+}
+
 /**
  * Do the set of common optimizations passes
  *
@@ -2300,31 +2579,61 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
  *                                    implementations supporting integers
  *                                    natively (as opposed to supporting
  *                                    integers in floating point registers).
+ * \param clean_functions             Optional set of the functions that the
+ *                                    previous call, in a loop running until
+ *                                    no progress is made, didn't change.
+ *                                    Their bodies are skipped by the passes
+ *                                    that only look at one function at a
+ *                                    time, and the set is updated for the
+ *                                    next call.  The IR must not be changed
+ *                                    by anything else between the calls.
  */
 bool
 do_common_optimization(exec_list *ir, bool linked,
 		       bool uniform_locations_assigned,
                        const struct gl_shader_compiler_options *options,
-                       bool native_integers)
+                       bool native_integers, struct set *clean_functions)
 {
    const bool debug = false;
    bool progress = false;
+   dirty_function_list functions(ir, clean_functions);
+   exec_list *pass_ir;
 
-#define OPT(PASS, ...) do {                                             \
-      if (debug) {                                                      \
+#define RUN_OPT(opt_progress, print_ir, PASS, ...) do {                  \
+      if (debug)                                                        \
          fprintf(stderr, "START GLSL optimization %s\n", #PASS);        \
-         const bool opt_progress = PASS(__VA_ARGS__);                   \
-         progress = opt_progress || progress;                           \
+      opt_progress = PASS(__VA_ARGS__);                                 \
+      if (debug) {                                                      \
          if (opt_progress)                                              \
-            _mesa_print_ir(stderr, ir, NULL);                           \
+            _mesa_print_ir(stderr, print_ir, NULL);                     \
          fprintf(stderr, "GLSL optimization %s: %s progress\n",         \
                  #PASS, opt_progress ? "made" : "no");                  \
-      } else {                                                          \
-         progress = PASS(__VA_ARGS__) || progress;                      \
       }                                                                 \
    } while (false)
 
-   OPT(lower_instructions, ir, SUB_TO_ADD_NEG);
+   /* Passes which may look at or change several functions at once. */
+#define OPT(PASS, ...) do {                                             \
+      bool opt_progress;                                                \
+      RUN_OPT(opt_progress, ir, PASS, __VA_ARGS__);                     \
+      if (opt_progress)                                                 \
+         functions.mark_all_dirty();                                    \
+      progress = opt_progress || progress;                              \
+   } while (false)
+
+   /* Passes which only look at one function at a time.  They run on
+    * pass_ir, which holds each function that still needs work in turn.
+    */
+#define OPT_LOCAL(PASS, ...) do {                                       \
+      for (unsigned f = 0; f < functions.count(); f++) {                \
+         bool opt_progress;                                             \
+         pass_ir = functions.enter(f);                                  \
+         RUN_OPT(opt_progress, pass_ir, PASS, __VA_ARGS__);             \
+         functions.leave(f, opt_progress);                              \
+         progress = opt_progress || progress;                           \
+      }                                                                 \
+   } while (false)
+
+   OPT_LOCAL(lower_instructions, pass_ir, SUB_TO_ADD_NEG);
 
    if (linked) {
       OPT(do_function_inlining, ir);
@@ -2332,10 +2641,10 @@ do_common_optimization(exec_list *ir, bool linked,
       OPT(do_structure_splitting, ir);
    }
    propagate_invariance(ir);
-   OPT(do_if_simplification, ir);
-   OPT(opt_flatten_nested_if_blocks, ir);
-   OPT(opt_conditional_discard, ir);
-   OPT(do_copy_propagation_elements, ir);
+   OPT_LOCAL(do_if_simplification, pass_ir);
+   OPT_LOCAL(opt_flatten_nested_if_blocks, pass_ir);
+   OPT_LOCAL(opt_conditional_discard, pass_ir);
+   OPT_LOCAL(do_copy_propagation_elements, pass_ir);
 
    if (options->OptimizeForAOS && !linked)
       OPT(opt_flip_matrices, ir);
@@ -2348,22 +2657,22 @@ do_common_optimization(exec_list *ir, bool linked,
       OPT(do_dead_code, ir, uniform_locations_assigned);
    else
       OPT(do_dead_code_unlinked, ir);
-   OPT(do_dead_code_local, ir);
-   OPT(do_tree_grafting, ir);
-   OPT(do_constant_propagation, ir);
+   OPT_LOCAL(do_dead_code_local, pass_ir);
+   OPT_LOCAL(do_tree_grafting, pass_ir);
+   OPT_LOCAL(do_constant_propagation, pass_ir);
    if (linked)
       OPT(do_constant_variable, ir);
    else
       OPT(do_constant_variable_unlinked, ir);
-   OPT(do_constant_folding, ir);
-   OPT(do_minmax_prune, ir);
-   OPT(do_rebalance_tree, ir);
-   OPT(do_algebraic, ir, native_integers, options);
-   OPT(do_lower_jumps, ir, true, true, options->EmitNoMainReturn,
-       options->EmitNoCont, options->EmitNoLoops);
-   OPT(do_vec_index_to_swizzle, ir);
-   OPT(lower_vector_insert, ir, false);
-   OPT(optimize_swizzles, ir);
+   OPT_LOCAL(do_constant_folding, pass_ir);
+   OPT_LOCAL(do_minmax_prune, pass_ir);
+   OPT_LOCAL(do_rebalance_tree, pass_ir);
+   OPT_LOCAL(do_algebraic, pass_ir, native_integers, options);
+   OPT_LOCAL(do_lower_jumps, pass_ir, true, true, options->EmitNoMainReturn,
+             options->EmitNoCont, options->EmitNoLoops);
+   OPT_LOCAL(do_vec_index_to_swizzle, pass_ir);
+   OPT_LOCAL(lower_vector_insert, pass_ir, false);
+   OPT_LOCAL(optimize_swizzles, pass_ir);
 
    /* Some drivers only call do_common_optimization() once rather than in a
     * loop, and split arrays causes each element of a constant array to
@@ -2375,45 +2684,22 @@ do_common_optimization(exec_list *ir, bool linked,
     * causes to constant arrays.
     */
    bool array_split = optimize_split_arrays(ir, linked);
-   if (array_split)
+   if (array_split) {
       do_constant_propagation(ir);
+      functions.mark_all_dirty();
+   }
    progress |= array_split;
 
-   OPT(optimize_redundant_jumps, ir);
-
-   if (options->MaxUnrollIterations) {
-      loop_state *ls = analyze_loop_variables(ir);
-      if (ls->loop_found) {
-         bool loop_progress = unroll_loops(ir, ls, options);
-         while (loop_progress) {
-            loop_progress = false;
-            loop_progress |= do_constant_propagation(ir);
-            loop_progress |= do_if_simplification(ir);
-
-            /* Some drivers only call do_common_optimization() once rather
-             * than in a loop. So we must call do_lower_jumps() after
-             * unrolling a loop because for drivers that use LLVM validation
-             * will fail if a jump is not the last instruction in the block.
-             * For example the following will fail LLVM validation:
-             *
-             *   (loop (
-             *      ...
-             *   break
-             *   (assign  (x) (var_ref v124)  (expression int + (var_ref v124)
-             *      (constant int (1)) ) )
-             *   ))
-             */
-            loop_progress |= do_lower_jumps(ir, true, true,
-                                            options->EmitNoMainReturn,
-                                            options->EmitNoCont,
-                                            options->EmitNoLoops);
-         }
-         progress |= loop_progress;
-      }
-      delete ls;
-   }
+   OPT_LOCAL(optimize_redundant_jumps, pass_ir);
+
+   if (options->MaxUnrollIterations)
+      OPT_LOCAL(unroll_and_cleanup_loops, pass_ir, options);
 
+#undef OPT_LOCAL
 #undef OPT
+#undef RUN_OPT
+
+   functions.update_clean_functions();
 
    return progress;
 }
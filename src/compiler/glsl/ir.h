@@ -102,6 +102,23 @@ public:
    {
    }
 
+   /**
+    * IR nodes come from the arena of their context, if it uses one (see
+    * ralloc_use_arena()), and are plain ralloc blocks otherwise.  Either
+    * way they can be stolen, reparented and freed as usual.
+    */
+   static void *operator new(size_t size, void *mem_ctx)
+   {
+      void *node = rzalloc_arena_size(mem_ctx, size);
+      assert(node != NULL);
+      return node;
+   }
+
+   static void operator delete(void *node)
+   {
+      ralloc_free(node);
+   }
+
    /** ir_print_visitor helper for debugging. */
    void print(void) const;
    void fprint(FILE *f) const;
@@ -1578,6 +1595,16 @@ public:
    virtual ir_constant *constant_expression_value(void *mem_ctx,
                                                   struct hash_table *variable_context = NULL);
 
+   /**
+    * Like constant_expression_value(), but stores the folded value in \c result
+    * instead of allocating a new ir_constant.
+    *
+    * \return false if the expression cannot be constant folded.
+    */
+   bool constant_expression_data(void *mem_ctx,
+                                 struct hash_table *variable_context,
+                                 union ir_constant_data *result);
+
    /**
     * This is only here for ir_reader to used for testing purposes please use
     * the precomputed num_operands field if you need the number of operands.
@@ -573,6 +573,34 @@ ir_rvalue::constant_expression_value(void *, struct hash_table *)
    return NULL;
 }
 
+/**
+ * Get the constant value of a variable dereference without copying it.
+ *
+ * The returned constant may be shared with the variable or with the variable
+ * context, so it must not be modified or handed out to the caller.
+ *
+ * \return NULL if \c ir isn't a variable dereference with a known value.
+ */
+static ir_constant *
+peek_constant_value(ir_rvalue *ir, struct hash_table *variable_context)
+{
+   ir_dereference_variable *deref = ir->as_dereference_variable();
+   if (deref == NULL)
+      return NULL;
+
+   if (variable_context) {
+      hash_entry *entry = _mesa_hash_table_search(variable_context, deref->var);
+
+      if (entry)
+         return (ir_constant *) entry->data;
+   }
+
+   if (deref->var->data.mode == ir_var_uniform)
+      return NULL;
+
+   return deref->var->constant_value;
+}
+
 static uint32_t
 bitfield_reverse(uint32_t v)
 {
@@ -691,21 +719,59 @@ ir_expression::constant_expression_value(void *mem_ctx,
 {
    assert(mem_ctx);
 
-   if (this->type->is_error())
+   ir_constant_data data;
+   if (!constant_expression_data(mem_ctx, variable_context, &data))
       return NULL;
 
+   return new(mem_ctx) ir_constant(this->type, &data);
+}
+
+
+bool
+ir_expression::constant_expression_data(void *mem_ctx,
+                                        struct hash_table *variable_context,
+                                        ir_constant_data *result)
+{
+   if (this->type->is_error())
+      return false;
+
    const glsl_type *return_type = this->type;
    ir_constant *op[ARRAY_SIZE(this->operands)] = { NULL, };
    ir_constant_data data;
 
    memset(&data, 0, sizeof(data));
 
+   /* Operands that are folded here or widened from 16 bits are kept in
+    * these, so that only the final result has to be allocated.
+    */
+   const ir_constant_data zero = { { 0 } };
+   ir_constant scratch[] = {
+      ir_constant(glsl_type::float_type, &zero),
+      ir_constant(glsl_type::float_type, &zero),
+      ir_constant(glsl_type::float_type, &zero),
+      ir_constant(glsl_type::float_type, &zero),
+   };
+   STATIC_ASSERT(ARRAY_SIZE(scratch) == ARRAY_SIZE(this->operands));
+
    for (unsigned operand = 0; operand < this->num_operands; operand++) {
-      op[operand] =
-         this->operands[operand]->constant_expression_value(mem_ctx,
-                                                            variable_context);
+      ir_rvalue *const src = this->operands[operand];
+      ir_expression *const expr = src->as_expression();
+
+      if (expr) {
+         if (!expr->constant_expression_data(mem_ctx, variable_context,
+                                             &scratch[operand].value))
+            return false;
+         scratch[operand].type = expr->type;
+         op[operand] = &scratch[operand];
+      } else {
+         op[operand] = peek_constant_value(src, variable_context);
+         if (!op[operand])
+            op[operand] = src->constant_expression_value(mem_ctx,
+                                                         variable_context);
+      }
+
       if (!op[operand])
-         return NULL;
+         return false;
    }
 
    for (unsigned operand = 0; operand < this->num_operands; operand++) {
@@ -722,7 +788,9 @@ ir_expression::constant_expression_value(void *mem_ctx,
          for (unsigned i = 0; i < ARRAY_SIZE(f.f); i++)
             f.f[i] = _mesa_half_to_float(op[operand]->value.f16[i]);
 
-         op[operand] = new(mem_ctx) ir_constant(float_type, &f);
+         scratch[operand].type = float_type;
+         scratch[operand].value = f;
+         op[operand] = &scratch[operand];
          break;
       }
       case GLSL_TYPE_INT16: {
@@ -737,7 +805,9 @@ ir_expression::constant_expression_value(void *mem_ctx,
          for (unsigned i = 0; i < ARRAY_SIZE(d.i); i++)
             d.i[i] = op[operand]->value.i16[i];
 
-         op[operand] = new(mem_ctx) ir_constant(int_type, &d);
+         scratch[operand].type = int_type;
+         scratch[operand].value = d;
+         op[operand] = &scratch[operand];
          break;
       }
       case GLSL_TYPE_UINT16: {
@@ -752,7 +822,9 @@ ir_expression::constant_expression_value(void *mem_ctx,
          for (unsigned i = 0; i < ARRAY_SIZE(d.u); i++)
             d.u[i] = op[operand]->value.u16[i];
 
-         op[operand] = new(mem_ctx) ir_constant(uint_type, &d);
+         scratch[operand].type = uint_type;
+         scratch[operand].value = d;
+         op[operand] = &scratch[operand];
          break;
       }
       default:
@@ -825,42 +897,41 @@ ir_expression::constant_expression_value(void *mem_ctx,
       assert(op[1] != NULL && op[1]->type->is_array());
       switch (this->operation) {
       case ir_binop_all_equal:
-         return new(mem_ctx) ir_constant(op[0]->has_value(op[1]));
       case ir_binop_any_nequal:
-         return new(mem_ctx) ir_constant(!op[0]->has_value(op[1]));
+         memset(result, 0, sizeof(*result));
+         result->b[0] = op[0]->has_value(op[1]) ==
+                        (this->operation == ir_binop_all_equal);
+         return true;
       default:
          break;
       }
-      return NULL;
+      return false;
    }
 
 #include "ir_expression_operation_constant.h"
 
    switch (type->base_type) {
-   case GLSL_TYPE_FLOAT16: {
-      ir_constant_data f;
-      for (unsigned i = 0; i < ARRAY_SIZE(f.f16); i++)
-         f.f16[i] = _mesa_float_to_half(data.f[i]);
-
-      return new(mem_ctx) ir_constant(this->type, &f);
-   }
-   case GLSL_TYPE_INT16: {
-      ir_constant_data d;
-      for (unsigned i = 0; i < ARRAY_SIZE(d.i16); i++)
-         d.i16[i] = data.i[i];
-
-      return new(mem_ctx) ir_constant(this->type, &d);
-   }
-   case GLSL_TYPE_UINT16: {
-      ir_constant_data d;
-      for (unsigned i = 0; i < ARRAY_SIZE(d.u16); i++)
-         d.u16[i] = data.u[i];
-
-      return new(mem_ctx) ir_constant(this->type, &d);
-   }
+   case GLSL_TYPE_FLOAT16:
+      memset(result, 0, sizeof(*result));
+      for (unsigned i = 0; i < ARRAY_SIZE(result->f16); i++)
+         result->f16[i] = _mesa_float_to_half(data.f[i]);
+      break;
+   case GLSL_TYPE_INT16:
+      memset(result, 0, sizeof(*result));
+      for (unsigned i = 0; i < ARRAY_SIZE(result->i16); i++)
+         result->i16[i] = data.i[i];
+      break;
+   case GLSL_TYPE_UINT16:
+      memset(result, 0, sizeof(*result));
+      for (unsigned i = 0; i < ARRAY_SIZE(result->u16); i++)
+         result->u16[i] = data.u[i];
+      break;
    default:
-      return new(mem_ctx) ir_constant(this->type, &data);
+      *result = data;
+      break;
    }
+
+   return true;
 }
 
 
@@ -878,8 +949,9 @@ ir_swizzle::constant_expression_value(void *mem_ctx,
 {
    assert(mem_ctx);
 
-   ir_constant *v = this->val->constant_expression_value(mem_ctx,
-                                                         variable_context);
+   ir_constant *v = peek_constant_value(this->val, variable_context);
+   if (v == NULL)
+      v = this->val->constant_expression_value(mem_ctx, variable_context);
 
    if (v != NULL) {
       ir_constant_data data = { { 0 } };
@@ -944,8 +1016,14 @@ ir_dereference_array::constant_expression_value(void *mem_ctx,
 {
    assert(mem_ctx);
 
-   ir_constant *array = this->array->constant_expression_value(mem_ctx, variable_context);
-   ir_constant *idx = this->array_index->constant_expression_value(mem_ctx, variable_context);
+   /* Don't copy a whole constant array just to read one element of it. */
+   ir_constant *array = peek_constant_value(this->array, variable_context);
+   if (array == NULL)
+      array = this->array->constant_expression_value(mem_ctx, variable_context);
+
+   ir_constant *idx = peek_constant_value(this->array_index, variable_context);
+   if (idx == NULL)
+      idx = this->array_index->constant_expression_value(mem_ctx, variable_context);
 
    if ((array != NULL) && (idx != NULL)) {
       if (array->type->is_matrix()) {
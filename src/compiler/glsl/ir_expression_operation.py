@@ -804,7 +804,7 @@ ${op.get_template()}
 % endfor
    default:
       /* FINISHME: Should handle all expression types. */
-      return NULL;
+      return false;
    }
 """)
 
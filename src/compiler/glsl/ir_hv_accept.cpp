@@ -1,33 +1,573 @@
-/*
- * Copyright © 2010 Intel Corporation
+#include "ir.h"
+
+/**
+ * \file ir_hv_accept.cpp
+ * Implementations of all hierarchical visitor accept methods for IR
+ * instructions.
  *
- * Permission is hereby granted, free of charge, to any person obtaining a
- * copy of this software and associated documentation files (the "Software"),
- * to deal in the Software without restriction, including without limitation
- * the rights to use, copy, modify, merge, publish, distribute, sublicense,
- * and/or sell copies of the Software, and to permit persons to whom the
- * Software is furnished to do so, subject to the following conditions:
+ * Only leaf instructions call the visitor directly.  Everything else goes
+ * through hv_traverse(), which walks the tree with an explicit stack instead
+ * of recursing through accept().  Shaders with very deep expression trees
+ * would otherwise need a lot of native stack, which is a problem for the
+ * glthread and util_queue worker threads that run the compiler.
+ */
+
+namespace {
+
+/**
+ * What to do when a child returns visit_continue_with_parent.
+ */
+enum hv_cwp_policy {
+   /** Return visit_continue without calling visit_leave on the parent. */
+   hv_cwp_return,
+   /** Skip the remaining children but still call visit_leave. */
+   hv_cwp_leave,
+   /** Ignore it and carry on with the next child. */
+   hv_cwp_next,
+};
+
+/**
+ * How a child changes ir_hierarchical_visitor::in_assignee.
+ */
+enum hv_assignee_mode {
+   hv_assignee_keep,
+   /** Set while visiting the child and clear afterwards. */
+   hv_assignee_set,
+   /** Clear while visiting the child and restore afterwards. */
+   hv_assignee_clear,
+};
+
+struct hv_child {
+   ir_instruction *ir;
+   exec_list *list;
+   bool statement_list;
+   hv_cwp_policy cwp;
+   hv_assignee_mode assignee;
+};
+
+/**
+ * A pending instruction or list of instructions on the traversal stack.
+ */
+struct hv_frame {
+   /** The instruction being visited, or NULL for a list frame. */
+   ir_instruction *ir;
+
+   /** List frames: the next node to visit. */
+   exec_node *next;
+   ir_instruction *prev_base_ir;
+   bool statement_list;
+
+   /** Instruction frames: the next child slot and what the current one
+    * asked for.
+    */
+   unsigned slot;
+   hv_cwp_policy cwp;
+   hv_assignee_mode assignee;
+   bool was_in_assignee;
+};
+
+class hv_stack {
+public:
+   hv_stack() : frames(inline_frames), size(0), capacity(ARRAY_SIZE(inline_frames))
+   {
+   }
+
+   ~hv_stack()
+   {
+      if (frames != inline_frames)
+         free(frames);
+   }
+
+   hv_frame *push()
+   {
+      if (size == capacity) {
+         hv_frame *grown = (hv_frame *) malloc(2 * capacity * sizeof(hv_frame));
+         memcpy(grown, frames, size * sizeof(hv_frame));
+         if (frames != inline_frames)
+            free(frames);
+         frames = grown;
+         capacity *= 2;
+      }
+
+      hv_frame *f = &frames[size++];
+      memset(f, 0, sizeof(*f));
+      return f;
+   }
+
+   void pop() { size--; }
+   bool empty() const { return size == 0; }
+   hv_frame *top() { return &frames[size - 1]; }
+
+private:
+   hv_frame inline_frames[32];
+   hv_frame *frames;
+   unsigned size, capacity;
+};
+
+bool
+is_leaf(const ir_instruction *ir)
+{
+   switch (ir->ir_type) {
+   case ir_type_dereference_variable:
+   case ir_type_constant:
+   case ir_type_variable:
+   case ir_type_loop_jump:
+   case ir_type_barrier:
+   case ir_type_unset:
+      return true;
+   default:
+      return false;
+   }
+}
+
+ir_visitor_status
+visit_enter(ir_hierarchical_visitor *v, ir_instruction *ir)
+{
+   switch (ir->ir_type) {
+   case ir_type_dereference_array:
+      return v->visit_enter(static_cast<ir_dereference_array *>(ir));
+   case ir_type_dereference_record:
+      return v->visit_enter(static_cast<ir_dereference_record *>(ir));
+   case ir_type_expression:
+      return v->visit_enter(static_cast<ir_expression *>(ir));
+   case ir_type_swizzle:
+      return v->visit_enter(static_cast<ir_swizzle *>(ir));
+   case ir_type_texture:
+      return v->visit_enter(static_cast<ir_texture *>(ir));
+   case ir_type_assignment:
+      return v->visit_enter(static_cast<ir_assignment *>(ir));
+   case ir_type_call:
+      return v->visit_enter(static_cast<ir_call *>(ir));
+   case ir_type_function:
+      return v->visit_enter(static_cast<ir_function *>(ir));
+   case ir_type_function_signature:
+      return v->visit_enter(static_cast<ir_function_signature *>(ir));
+   case ir_type_if:
+      return v->visit_enter(static_cast<ir_if *>(ir));
+   case ir_type_loop:
+      return v->visit_enter(static_cast<ir_loop *>(ir));
+   case ir_type_return:
+      return v->visit_enter(static_cast<ir_return *>(ir));
+   case ir_type_discard:
+      return v->visit_enter(static_cast<ir_discard *>(ir));
+   case ir_type_demote:
+      return v->visit_enter(static_cast<ir_demote *>(ir));
+   case ir_type_emit_vertex:
+      return v->visit_enter(static_cast<ir_emit_vertex *>(ir));
+   case ir_type_end_primitive:
+      return v->visit_enter(static_cast<ir_end_primitive *>(ir));
+   default:
+      unreachable("not an inner node");
+   }
+}
+
+ir_visitor_status
+visit_leave(ir_hierarchical_visitor *v, ir_instruction *ir)
+{
+   switch (ir->ir_type) {
+   case ir_type_dereference_array:
+      return v->visit_leave(static_cast<ir_dereference_array *>(ir));
+   case ir_type_dereference_record:
+      return v->visit_leave(static_cast<ir_dereference_record *>(ir));
+   case ir_type_expression:
+      return v->visit_leave(static_cast<ir_expression *>(ir));
+   case ir_type_swizzle:
+      return v->visit_leave(static_cast<ir_swizzle *>(ir));
+   case ir_type_texture:
+      return v->visit_leave(static_cast<ir_texture *>(ir));
+   case ir_type_assignment:
+      return v->visit_leave(static_cast<ir_assignment *>(ir));
+   case ir_type_call:
+      return v->visit_leave(static_cast<ir_call *>(ir));
+   case ir_type_function:
+      return v->visit_leave(static_cast<ir_function *>(ir));
+   case ir_type_function_signature:
+      return v->visit_leave(static_cast<ir_function_signature *>(ir));
+   case ir_type_if:
+      return v->visit_leave(static_cast<ir_if *>(ir));
+   case ir_type_loop:
+      return v->visit_leave(static_cast<ir_loop *>(ir));
+   case ir_type_return:
+      return v->visit_leave(static_cast<ir_return *>(ir));
+   case ir_type_discard:
+      return v->visit_leave(static_cast<ir_discard *>(ir));
+   case ir_type_demote:
+      return v->visit_leave(static_cast<ir_demote *>(ir));
+   case ir_type_emit_vertex:
+      return v->visit_leave(static_cast<ir_emit_vertex *>(ir));
+   case ir_type_end_primitive:
+      return v->visit_leave(static_cast<ir_end_primitive *>(ir));
+   default:
+      unreachable("not an inner node");
+   }
+}
+
+/**
+ * Get the child of \c ir in the given slot.
  *
- * The above copyright notice and this permission notice (including the next
- * paragraph) shall be included in all copies or substantial portions of the
- * Software.
+ * The children are read only once the previous ones have been visited, so
+ * visitors may replace them from visit_enter or from a sibling, just as they
+ * could with recursive accept() calls.  Empty slots have neither an
+ * instruction nor a list.
  *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
- * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
- * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
- * DEALINGS IN THE SOFTWARE.
+ * \return false if there are no slots left.
  */
+bool
+get_child(ir_instruction *ir, unsigned slot, hv_child *c)
+{
+   memset(c, 0, sizeof(*c));
+   c->cwp = hv_cwp_return;
+
+   switch (ir->ir_type) {
+   case ir_type_dereference_array: {
+      ir_dereference_array *deref = static_cast<ir_dereference_array *>(ir);
+      if (slot == 0) {
+         /* The array index is not the target of the assignment, so clear
+          * the 'in_assignee' flag while visiting it.
+          */
+         c->ir = deref->array_index;
+         c->assignee = hv_assignee_clear;
+      } else if (slot == 1) {
+         c->ir = deref->array;
+         c->cwp = hv_cwp_leave;
+      } else {
+         return false;
+      }
+      return true;
+   }
 
-#include "ir.h"
+   case ir_type_dereference_record:
+      if (slot > 0)
+         return false;
+      c->ir = static_cast<ir_dereference_record *>(ir)->record;
+      c->cwp = hv_cwp_leave;
+      return true;
+
+   case ir_type_expression: {
+      ir_expression *expr = static_cast<ir_expression *>(ir);
+      if (slot >= expr->num_operands)
+         return false;
+      c->ir = expr->operands[slot];
+      c->cwp = hv_cwp_leave;
+      return true;
+   }
+
+   case ir_type_swizzle:
+      if (slot > 0)
+         return false;
+      c->ir = static_cast<ir_swizzle *>(ir)->val;
+      c->cwp = hv_cwp_leave;
+      return true;
+
+   case ir_type_texture: {
+      ir_texture *tex = static_cast<ir_texture *>(ir);
+      switch (slot) {
+      case 0: c->ir = tex->sampler; return true;
+      case 1: c->ir = tex->coordinate; return true;
+      case 2: c->ir = tex->projector; return true;
+      case 3: c->ir = tex->shadow_comparator; return true;
+      case 4: c->ir = tex->offset; return true;
+      case 5:
+         switch (tex->op) {
+         case ir_tex:
+         case ir_lod:
+         case ir_query_levels:
+         case ir_texture_samples:
+         case ir_samples_identical:
+            break;
+         case ir_txb:
+            c->ir = tex->lod_info.bias;
+            break;
+         case ir_txl:
+         case ir_txf:
+         case ir_txs:
+            c->ir = tex->lod_info.lod;
+            break;
+         case ir_txf_ms:
+            c->ir = tex->lod_info.sample_index;
+            break;
+         case ir_txd:
+            c->ir = tex->lod_info.grad.dPdx;
+            break;
+         case ir_tg4:
+            c->ir = tex->lod_info.component;
+            break;
+         }
+         return true;
+      case 6:
+         if (tex->op == ir_txd)
+            c->ir = tex->lod_info.grad.dPdy;
+         return true;
+      default:
+         return false;
+      }
+   }
+
+   case ir_type_assignment: {
+      ir_assignment *assign = static_cast<ir_assignment *>(ir);
+      if (slot == 0) {
+         c->ir = assign->lhs;
+         c->assignee = hv_assignee_set;
+      } else if (slot == 1) {
+         c->ir = assign->rhs;
+      } else if (slot == 2) {
+         c->ir = assign->condition;
+         c->cwp = hv_cwp_leave;
+      } else {
+         return false;
+      }
+      return true;
+   }
+
+   case ir_type_call: {
+      ir_call *call = static_cast<ir_call *>(ir);
+      if (slot == 0) {
+         c->ir = call->return_deref;
+         c->assignee = hv_assignee_set;
+      } else if (slot == 1) {
+         c->list = &call->actual_parameters;
+         c->cwp = hv_cwp_leave;
+      } else {
+         return false;
+      }
+      return true;
+   }
+
+   case ir_type_function:
+      if (slot > 0)
+         return false;
+      c->list = &static_cast<ir_function *>(ir)->signatures;
+      c->cwp = hv_cwp_leave;
+      return true;
+
+   case ir_type_function_signature: {
+      ir_function_signature *sig = static_cast<ir_function_signature *>(ir);
+      if (slot == 0) {
+         c->list = &sig->parameters;
+         c->statement_list = true;
+         c->cwp = hv_cwp_next;
+      } else if (slot == 1) {
+         c->list = &sig->body;
+         c->statement_list = true;
+         c->cwp = hv_cwp_leave;
+      } else {
+         return false;
+      }
+      return true;
+   }
+
+   case ir_type_if: {
+      ir_if *if_ir = static_cast<ir_if *>(ir);
+      if (slot == 0) {
+         c->ir = if_ir->condition;
+      } else if (slot == 1) {
+         c->list = &if_ir->then_instructions;
+         c->statement_list = true;
+         c->cwp = hv_cwp_leave;
+      } else if (slot == 2) {
+         c->list = &if_ir->else_instructions;
+         c->statement_list = true;
+         c->cwp = hv_cwp_leave;
+      } else {
+         return false;
+      }
+      return true;
+   }
+
+   case ir_type_loop:
+      if (slot > 0)
+         return false;
+      c->list = &static_cast<ir_loop *>(ir)->body_instructions;
+      c->statement_list = true;
+      c->cwp = hv_cwp_leave;
+      return true;
+
+   case ir_type_return:
+      if (slot > 0)
+         return false;
+      c->ir = static_cast<ir_return *>(ir)->get_value();
+      return true;
+
+   case ir_type_discard:
+      if (slot > 0)
+         return false;
+      c->ir = static_cast<ir_discard *>(ir)->condition;
+      return true;
+
+   case ir_type_demote:
+      return false;
+
+   case ir_type_emit_vertex:
+      if (slot > 0)
+         return false;
+      c->ir = static_cast<ir_emit_vertex *>(ir)->stream;
+      return true;
+
+   case ir_type_end_primitive:
+      if (slot > 0)
+         return false;
+      c->ir = static_cast<ir_end_primitive *>(ir)->stream;
+      return true;
+
+   default:
+      unreachable("not an inner node");
+   }
+}
+
+void
+push_list(hv_stack &stack, ir_hierarchical_visitor *v, exec_list *l,
+          bool statement_list)
+{
+   hv_frame *f = stack.push();
+   f->next = l->get_head_raw();
+   f->prev_base_ir = v->base_ir;
+   f->statement_list = statement_list;
+}
 
 /**
- * \file ir_hv_accept.cpp
- * Implementations of all hierarchical visitor accept methods for IR
- * instructions.
+ * Visit \c root (or the list \c root_list if root is NULL) and everything
+ * below it without recursing.
  */
+ir_visitor_status
+hv_traverse(ir_hierarchical_visitor *v, ir_instruction *root,
+            exec_list *root_list, bool statement_list)
+{
+   hv_stack stack;
+   ir_visitor_status s = visit_continue;
+
+   if (root)
+      stack.push()->ir = root;
+   else
+      push_list(stack, v, root_list, statement_list);
+
+   /* A frame is "resumed" when the child it pushed has finished, with that
+    * child's result in s.
+    */
+   bool resumed = false;
+
+   while (!stack.empty()) {
+      hv_frame *f = stack.top();
+      ir_instruction *child = NULL;
+
+      if (f->ir == NULL) {
+         /* See visit_list_elements() for the semantics.  The next node is
+          * looked up before visiting the current one, so removing it from
+          * the list is fine.
+          */
+         if (resumed && s != visit_continue) {
+            stack.pop();
+            continue;
+         }
+
+         exec_node *node = f->next;
+         if (node->next == NULL) {
+            if (f->statement_list)
+               v->base_ir = f->prev_base_ir;
+            s = visit_continue;
+            stack.pop();
+            resumed = true;
+            continue;
+         }
+
+         f->next = node->next;
+         child = (ir_instruction *) node;
+         if (f->statement_list)
+            v->base_ir = child;
+      } else {
+         bool leave = false;
+
+         if (!resumed) {
+            s = visit_enter(v, f->ir);
+            if (s != visit_continue) {
+               if (s == visit_continue_with_parent)
+                  s = visit_continue;
+               stack.pop();
+               resumed = true;
+               continue;
+            }
+         } else {
+            switch (f->assignee) {
+            case hv_assignee_keep:
+               break;
+            case hv_assignee_set:
+               v->in_assignee = false;
+               break;
+            case hv_assignee_clear:
+               v->in_assignee = f->was_in_assignee;
+               break;
+            }
+
+            if (s == visit_stop) {
+               stack.pop();
+               continue;
+            } else if (s == visit_continue_with_parent) {
+               if (f->cwp == hv_cwp_return) {
+                  s = visit_continue;
+                  stack.pop();
+                  continue;
+               } else if (f->cwp == hv_cwp_leave) {
+                  leave = true;
+               }
+            }
+         }
+
+         /* Find the next non-empty child slot. */
+         hv_child c;
+         exec_list *list = NULL;
+         while (!leave) {
+            if (!get_child(f->ir, f->slot++, &c)) {
+               leave = true;
+               break;
+            }
+            if (c.ir || c.list) {
+               child = c.ir;
+               list = c.list;
+               break;
+            }
+         }
+
+         if (leave) {
+            s = visit_leave(v, f->ir);
+            stack.pop();
+            resumed = true;
+            continue;
+         }
+
+         f->cwp = c.cwp;
+         f->assignee = c.assignee;
+         switch (c.assignee) {
+         case hv_assignee_keep:
+            break;
+         case hv_assignee_set:
+            v->in_assignee = true;
+            break;
+         case hv_assignee_clear:
+            f->was_in_assignee = v->in_assignee;
+            v->in_assignee = false;
+            break;
+         }
+
+         if (list) {
+            push_list(stack, v, list, c.statement_list);
+            resumed = false;
+            continue;
+         }
+      }
+
+      /* Leaves don't need a frame of their own. */
+      if (is_leaf(child)) {
+         s = child->accept(v);
+         resumed = true;
+      } else {
+         stack.push()->ir = child;
+         resumed = false;
+      }
+   }
+
+   return s;
+}
+
+} /* anonymous namespace */
 
 /**
  * Process a list of nodes using a hierarchical vistor.
@@ -47,20 +587,7 @@ ir_visitor_status
 visit_list_elements(ir_hierarchical_visitor *v, exec_list *l,
                     bool statement_list)
 {
-   ir_instruction *prev_base_ir = v->base_ir;
-
-   foreach_in_list_safe(ir_instruction, ir, l) {
-      if (statement_list)
-         v->base_ir = ir;
-      ir_visitor_status s = ir->accept(v);
-
-      if (s != visit_continue)
-	 return s;
-   }
-   if (statement_list)
-      v->base_ir = prev_base_ir;
-
-   return visit_continue;
+   return hv_traverse(v, NULL, l, statement_list);
 }
 
 
@@ -81,16 +608,7 @@ ir_variable::accept(ir_hierarchical_visitor *v)
 ir_visitor_status
 ir_loop::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   s = visit_list_elements(v, &this->body_instructions);
-   if (s == visit_stop)
-      return s;
-
-   return v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
@@ -104,146 +622,35 @@ ir_loop_jump::accept(ir_hierarchical_visitor *v)
 ir_visitor_status
 ir_function_signature::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   s = visit_list_elements(v, &this->parameters);
-   if (s == visit_stop)
-      return s;
-
-   s = visit_list_elements(v, &this->body);
-   return (s == visit_stop) ? s : v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
 ir_visitor_status
 ir_function::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   s = visit_list_elements(v, &this->signatures, false);
-   return (s == visit_stop) ? s : v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
 ir_visitor_status
 ir_expression::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   for (unsigned i = 0; i < this->num_operands; i++) {
-      switch (this->operands[i]->accept(v)) {
-      case visit_continue:
-	 break;
-
-      case visit_continue_with_parent:
-	 // I wish for Java's labeled break-statement here.
-	 goto done;
-
-      case visit_stop:
-	 return visit_stop;
-      }
-   }
-
-done:
-   return v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
+
 ir_visitor_status
 ir_texture::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   s = this->sampler->accept(v);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   if (this->coordinate) {
-      s = this->coordinate->accept(v);
-      if (s != visit_continue)
-	 return (s == visit_continue_with_parent) ? visit_continue : s;
-   }
-
-   if (this->projector) {
-      s = this->projector->accept(v);
-      if (s != visit_continue)
-	 return (s == visit_continue_with_parent) ? visit_continue : s;
-   }
-
-   if (this->shadow_comparator) {
-      s = this->shadow_comparator->accept(v);
-      if (s != visit_continue)
-	 return (s == visit_continue_with_parent) ? visit_continue : s;
-   }
-
-   if (this->offset) {
-      s = this->offset->accept(v);
-      if (s != visit_continue)
-	 return (s == visit_continue_with_parent) ? visit_continue : s;
-   }
-
-   switch (this->op) {
-   case ir_tex:
-   case ir_lod:
-   case ir_query_levels:
-   case ir_texture_samples:
-   case ir_samples_identical:
-      break;
-   case ir_txb:
-      s = this->lod_info.bias->accept(v);
-      if (s != visit_continue)
-	 return (s == visit_continue_with_parent) ? visit_continue : s;
-      break;
-   case ir_txl:
-   case ir_txf:
-   case ir_txs:
-      s = this->lod_info.lod->accept(v);
-      if (s != visit_continue)
-	 return (s == visit_continue_with_parent) ? visit_continue : s;
-      break;
-   case ir_txf_ms:
-      s = this->lod_info.sample_index->accept(v);
-      if (s != visit_continue)
-         return (s == visit_continue_with_parent) ? visit_continue : s;
-      break;
-   case ir_txd:
-      s = this->lod_info.grad.dPdx->accept(v);
-      if (s != visit_continue)
-	 return (s == visit_continue_with_parent) ? visit_continue : s;
-
-      s = this->lod_info.grad.dPdy->accept(v);
-      if (s != visit_continue)
-	 return (s == visit_continue_with_parent) ? visit_continue : s;
-      break;
-   case ir_tg4:
-      s = this->lod_info.component->accept(v);
-      if (s != visit_continue)
-         return (s == visit_continue_with_parent) ? visit_continue : s;
-      break;
-   }
-
-   assert(s == visit_continue);
-   return v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
 ir_visitor_status
 ir_swizzle::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   s = this->val->accept(v);
-   return (s == visit_stop) ? s : v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
@@ -257,59 +664,21 @@ ir_dereference_variable::accept(ir_hierarchical_visitor *v)
 ir_visitor_status
 ir_dereference_array::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   /* The array index is not the target of the assignment, so clear the
-    * 'in_assignee' flag.  Restore it after returning from the array index.
-    */
-   const bool was_in_assignee = v->in_assignee;
-   v->in_assignee = false;
-   s = this->array_index->accept(v);
-   v->in_assignee = was_in_assignee;
-
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   s = this->array->accept(v);
-   return (s == visit_stop) ? s : v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
 ir_visitor_status
 ir_dereference_record::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   s = this->record->accept(v);
-   return (s == visit_stop) ? s : v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
 ir_visitor_status
 ir_assignment::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   v->in_assignee = true;
-   s = this->lhs->accept(v);
-   v->in_assignee = false;
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   s = this->rhs->accept(v);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   if (this->condition)
-      s = this->condition->accept(v);
-
-   return (s == visit_stop) ? s : v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
@@ -323,130 +692,52 @@ ir_constant::accept(ir_hierarchical_visitor *v)
 ir_visitor_status
 ir_call::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   if (this->return_deref != NULL) {
-      v->in_assignee = true;
-      s = this->return_deref->accept(v);
-      v->in_assignee = false;
-      if (s != visit_continue)
-	 return (s == visit_continue_with_parent) ? visit_continue : s;
-   }
-
-   s = visit_list_elements(v, &this->actual_parameters, false);
-   if (s == visit_stop)
-      return s;
-
-   return v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
 ir_visitor_status
 ir_return::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   ir_rvalue *val = this->get_value();
-   if (val) {
-      s = val->accept(v);
-      if (s != visit_continue)
-	 return (s == visit_continue_with_parent) ? visit_continue : s;
-   }
-
-   return v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
 ir_visitor_status
 ir_discard::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   if (this->condition != NULL) {
-      s = this->condition->accept(v);
-      if (s != visit_continue)
-	 return (s == visit_continue_with_parent) ? visit_continue : s;
-   }
-
-   return v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
 ir_visitor_status
 ir_demote::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   return v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
 ir_visitor_status
 ir_if::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   s = this->condition->accept(v);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   if (s != visit_continue_with_parent) {
-      s = visit_list_elements(v, &this->then_instructions);
-      if (s == visit_stop)
-	 return s;
-   }
-
-   if (s != visit_continue_with_parent) {
-      s = visit_list_elements(v, &this->else_instructions);
-      if (s == visit_stop)
-	 return s;
-   }
-
-   return v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
+
 ir_visitor_status
 ir_emit_vertex::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   s = this->stream->accept(v);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   assert(s == visit_continue);
-   return v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
 
 ir_visitor_status
 ir_end_primitive::accept(ir_hierarchical_visitor *v)
 {
-   ir_visitor_status s = v->visit_enter(this);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   s = this->stream->accept(v);
-   if (s != visit_continue)
-      return (s == visit_continue_with_parent) ? visit_continue : s;
-
-   assert(s == visit_continue);
-   return v->visit_leave(this);
+   return hv_traverse(v, this, NULL, false);
 }
 
+
 ir_visitor_status
 ir_barrier::accept(ir_hierarchical_visitor *v)
 {
@@ -30,6 +30,7 @@
 #ifndef GLSL_IR_OPTIMIZATION_H
 #define GLSL_IR_OPTIMIZATION_H
 
+struct set;
 struct gl_linked_shader;
 struct gl_shader_program;
 
@@ -93,7 +94,8 @@ enum lower_packing_builtins_op {
 bool do_common_optimization(exec_list *ir, bool linked,
 			    bool uniform_locations_assigned,
                             const struct gl_shader_compiler_options *options,
-                            bool native_integers);
+                            bool native_integers,
+                            struct set *clean_functions = NULL);
 
 bool ir_constant_fold(ir_rvalue **rvalue);
 
@@ -39,6 +39,7 @@
 #include "util/hash_table.h"
 #include "util/macros.h"
 #include "util/set.h"
+#include "util/u_atomic.h"
 #include "compiler/glsl_types.h"
 
 namespace {
@@ -89,6 +90,18 @@ public:
 
 } /* anonymous namespace */
 
+static void
+check_node_type(ir_instruction *ir)
+{
+   if (ir->ir_type >= ir_type_max) {
+      printf("Instruction node with unset type\n");
+      ir->print(); printf("\n");
+   }
+   ir_rvalue *value = ir->as_rvalue();
+   if (value != NULL)
+      assert(value->type != glsl_type::error_type);
+}
+
 ir_visitor_status
 ir_validate::visit(ir_dereference_variable *ir)
 {
@@ -160,6 +173,8 @@ ir_validate::visit_enter(class ir_dereference_array *ir)
       abort();
    }
 
+   check_node_type(ir);
+
    return visit_continue;
 }
 
@@ -182,6 +197,8 @@ ir_validate::visit_enter(class ir_dereference_record *ir)
       abort();
    }
 
+   check_node_type(ir);
+
    return visit_continue;
 }
 
@@ -1172,27 +1189,16 @@ ir_validate::validate_ir(ir_instruction *ir, void *data)
 {
    struct set *ir_set = (struct set *) data;
 
-   if (_mesa_set_search(ir_set, ir)) {
+   bool found;
+   _mesa_set_search_or_add(ir_set, ir, &found);
+   if (found) {
       printf("Instruction node present twice in ir tree:\n");
       ir->print();
       printf("\n");
       abort();
    }
-   _mesa_set_add(ir_set, ir);
-}
-
-static void
-check_node_type(ir_instruction *ir, void *data)
-{
-   (void) data;
 
-   if (ir->ir_type >= ir_type_max) {
-      printf("Instruction node with unset type\n");
-      ir->print(); printf("\n");
-   }
-   ir_rvalue *value = ir->as_rvalue();
-   if (value != NULL)
-      assert(value->type != glsl_type::error_type);
+   check_node_type(ir);
 }
 
 void
@@ -1206,11 +1212,22 @@ validate_ir_tree(exec_list *instructions)
    if (!env_var_as_boolean("GLSL_VALIDATE", false))
       return;
 #endif
+
+   /* Validating everything can be too slow for running large shader
+    * collections, so allow checking only every Nth tree instead.
+    */
+   static const unsigned interval =
+      MAX2(env_var_as_unsigned("GLSL_VALIDATE_INTERVAL", 1), 1);
+   if (interval > 1) {
+      static uint32_t count = 0;
+      if (p_atomic_inc_return(&count) % interval != 0)
+         return;
+   }
+
    ir_validate v;
 
+   /* The node type checks happen as part of validate_ir(), so a single walk
+    * over the tree is enough.
+    */
    v.run(instructions);
-
-   foreach_in_list(ir_instruction, ir, instructions) {
-      visit_tree(ir, check_node_type, NULL);
-   }
 }
@@ -30,6 +30,7 @@
 #include "ir_array_refcount.h"
 
 #include "main/mtypes.h"
+#include "util/hash_table.h"
 #include "util/strndup.h"
 
 /**
@@ -189,9 +190,60 @@ get_array_stride(struct gl_uniform_storage *uni, const glsl_type *iface,
    return 0;
 }
 
+struct ssbo_field {
+   const glsl_type *iface;
+   const glsl_struct_field *field;
+};
+
+/**
+ * Indexes the members of the shader storage blocks of all stages by their
+ * "block.member" name, so that calculate_array_size_and_stride() doesn't
+ * have to walk the IR of every stage for each buffer variable.  The first
+ * declaration in stage and IR order wins.
+ */
+static struct hash_table *
+index_ssbo_fields(struct gl_shader_program *shProg)
+{
+   struct hash_table *ht = _mesa_hash_table_create(NULL, _mesa_hash_string,
+                                                   _mesa_key_string_equal);
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      const gl_linked_shader *sh = shProg->_LinkedShaders[i];
+      if (sh == NULL)
+         continue;
+
+      foreach_in_list(ir_instruction, node, sh->ir) {
+         ir_variable *var = node->as_variable();
+         if (!var || !var->get_interface_type() ||
+             var->data.mode != ir_var_shader_storage)
+            continue;
+
+         const glsl_type *iface = var->get_interface_type();
+
+         for (unsigned j = 0; j < iface->length; j++) {
+            const glsl_struct_field *field = &iface->fields.structure[j];
+            char *key = ralloc_asprintf(ht, "%s.%s", iface->name, field->name);
+
+            if (_mesa_hash_table_search(ht, key)) {
+               ralloc_free(key);
+               continue;
+            }
+
+            struct ssbo_field *entry = ralloc(ht, struct ssbo_field);
+            entry->iface = iface;
+            entry->field = field;
+            _mesa_hash_table_insert(ht, key, entry);
+         }
+      }
+   }
+
+   return ht;
+}
+
 static void
 calculate_array_size_and_stride(struct gl_shader_program *shProg,
                                 struct gl_uniform_storage *uni,
+                                struct hash_table *ssbo_fields,
                                 bool use_std430_as_default)
 {
    if (!uni->is_shader_storage)
@@ -222,32 +274,18 @@ calculate_array_size_and_stride(struct gl_shader_program *shProg,
       }
    }
 
-   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
-      const gl_linked_shader *sh = shProg->_LinkedShaders[i];
-      if (sh == NULL)
-         continue;
-
-      foreach_in_list(ir_instruction, node, sh->ir) {
-         ir_variable *var = node->as_variable();
-         if (!var || !var->get_interface_type() ||
-             var->data.mode != ir_var_shader_storage)
-            continue;
-
-         const glsl_type *iface = var->get_interface_type();
-
-         if (strcmp(interface_name, iface->name) != 0)
-            continue;
+   {
+      char *key = ralloc_asprintf(NULL, "%s.%s", interface_name, var_name);
+      struct hash_entry *entry = _mesa_hash_table_search(ssbo_fields, key);
+      ralloc_free(key);
 
-         for (unsigned i = 0; i < iface->length; i++) {
-            const glsl_struct_field *field = &iface->fields.structure[i];
-            if (strcmp(field->name, var_name) != 0)
-               continue;
+      if (entry) {
+         const struct ssbo_field *f = (const struct ssbo_field *) entry->data;
 
-            array_stride = get_array_stride(uni, iface, field, interface_name,
-                                            var_name, use_std430_as_default);
-            array_size = get_array_size(uni, field, interface_name, var_name);
-            goto write_top_level_array_size_and_stride;
-         }
+         array_stride = get_array_stride(uni, f->iface, f->field,
+                                         interface_name, var_name,
+                                         use_std430_as_default);
+         array_size = get_array_size(uni, f->field, interface_name, var_name);
       }
    }
 write_top_level_array_size_and_stride:
@@ -692,9 +730,12 @@ public:
         next_bindless_image(0), next_subroutine(0),
         use_std430_as_default(use_std430_as_default),
         field_counter(0), current_var(NULL), explicit_location(0),
-        record_array_count(0), record_next_sampler(NULL),
-        record_next_image(NULL), record_next_bindless_sampler(NULL),
-        record_next_bindless_image(NULL),
+        record_array_count(0),
+        record_next_sampler(new string_to_uint_map),
+        record_next_image(new string_to_uint_map),
+        record_next_bindless_sampler(new string_to_uint_map),
+        record_next_bindless_image(new string_to_uint_map),
+        ssbo_fields(index_ssbo_fields(prog)),
         values(values),
         shader_samplers_used(0), shader_shadow_samplers(0),
         num_bindless_samplers(0),
@@ -709,6 +750,13 @@ public:
    {
       free(this->bindless_targets);
       free(this->bindless_access);
+
+      delete this->record_next_sampler;
+      delete this->record_next_bindless_sampler;
+      delete this->record_next_image;
+      delete this->record_next_bindless_image;
+
+      _mesa_hash_table_destroy(this->ssbo_fields, NULL);
    }
 
    void start_shader(gl_shader_stage shader_type)
@@ -740,10 +788,10 @@ public:
    {
       current_var = var;
       field_counter = 0;
-      this->record_next_sampler = new string_to_uint_map;
-      this->record_next_bindless_sampler = new string_to_uint_map;
-      this->record_next_image = new string_to_uint_map;
-      this->record_next_bindless_image = new string_to_uint_map;
+      this->record_next_sampler->clear();
+      this->record_next_bindless_sampler->clear();
+      this->record_next_image->clear();
+      this->record_next_bindless_image->clear();
 
       buffer_block_index = -1;
       if (var->is_in_buffer_block()) {
@@ -824,10 +872,6 @@ public:
 
          process(var, use_std430_as_default);
       }
-      delete this->record_next_sampler;
-      delete this->record_next_bindless_sampler;
-      delete this->record_next_image;
-      delete this->record_next_bindless_image;
    }
 
    int buffer_block_index;
@@ -1182,6 +1226,7 @@ private:
          this->values += type->component_slots();
 
       calculate_array_size_and_stride(prog, &this->uniforms[id],
+                                      this->ssbo_fields,
                                       use_std430_as_default);
    }
 
@@ -1240,6 +1285,11 @@ private:
     */
    struct string_to_uint_map *record_next_bindless_image;
 
+   /**
+    * Members of the shader storage blocks, see index_ssbo_fields().
+    */
+   struct hash_table *ssbo_fields;
+
 public:
    union gl_constant_value *values;
 
@@ -1296,11 +1346,100 @@ variable_is_referenced(ir_array_refcount_visitor &v, ir_variable *var)
  * would point at the uniform block list in one of the pre-linked
  * shaders).
  */
+namespace {
+
+/**
+ * Looks up the block members matching a variable name, where the member
+ * name either equals the variable name or starts with it followed by a
+ * sentinel character.  The tables are only built for the sentinels used.
+ */
+class block_member_index {
+public:
+   block_member_index(struct gl_uniform_block **blks, unsigned num_blocks)
+      : blks(blks), num_blocks(num_blocks)
+   {
+      memset(this->tables, 0, sizeof(this->tables));
+   }
+
+   ~block_member_index()
+   {
+      for (unsigned i = 0; i < ARRAY_SIZE(this->tables); i++)
+         _mesa_hash_table_destroy(this->tables[i], NULL);
+   }
+
+   /**
+    * Finds the first member in block order matching name.
+    */
+   bool find(const char *name, char sentinel,
+             unsigned *block, unsigned *member)
+   {
+      struct hash_entry *entry =
+         _mesa_hash_table_search(get_table(sentinel), name);
+      if (entry == NULL)
+         return false;
+
+      const uintptr_t packed = (uintptr_t) entry->data;
+      *block = (packed >> 16) - 1;
+      *member = packed & 0xffff;
+      return true;
+   }
+
+private:
+   struct hash_table *get_table(char sentinel)
+   {
+      const unsigned t = sentinel == '\0' ? 0 : sentinel == '.' ? 1 : 2;
+      assert(sentinel == '\0' || sentinel == '.' || sentinel == '[');
+
+      if (this->tables[t] != NULL)
+         return this->tables[t];
+
+      struct hash_table *ht =
+         _mesa_hash_table_create(NULL, _mesa_hash_string,
+                                 _mesa_key_string_equal);
+
+      for (unsigned i = 0; i < this->num_blocks; i++) {
+         for (unsigned j = 0; j < this->blks[i]->NumUniforms; j++) {
+            const char *key = this->blks[i]->Uniforms[j].Name;
+
+            if (sentinel) {
+               const char *end = strchr(key, sentinel);
+               if (end == NULL)
+                  continue;
+
+               key = ralloc_strndup(ht, key, end - key);
+            }
+
+            /* The block index is stored biased by one so that the key of
+             * the first member of the first block isn't NULL.
+             */
+            assert(j <= 0xffff);
+            if (!_mesa_hash_table_search(ht, key)) {
+               _mesa_hash_table_insert(ht, key,
+                                       (void *) (uintptr_t) ((i + 1) << 16 | j));
+            }
+         }
+      }
+
+      this->tables[t] = ht;
+      return ht;
+   }
+
+   struct gl_uniform_block **blks;
+   unsigned num_blocks;
+   struct hash_table *tables[3];
+};
+
+} /* anonymous namespace */
+
 static void
 link_update_uniform_buffer_variables(struct gl_linked_shader *shader,
                                      unsigned stage)
 {
    ir_array_refcount_visitor v;
+   block_member_index ubo_members(shader->Program->sh.UniformBlocks,
+                                  shader->Program->info.num_ubos);
+   block_member_index ssbo_members(shader->Program->sh.ShaderStorageBlocks,
+                                   shader->Program->info.num_ssbos);
 
    v.run(shader->ir);
 
@@ -1360,7 +1499,6 @@ link_update_uniform_buffer_variables(struct gl_linked_shader *shader,
          continue;
       }
 
-      bool found = false;
       char sentinel = '\0';
 
       if (var->type->is_struct()) {
@@ -1370,38 +1508,18 @@ link_update_uniform_buffer_variables(struct gl_linked_shader *shader,
          sentinel = '[';
       }
 
-      const unsigned l = strlen(var->name);
-      for (unsigned i = 0; i < num_blocks; i++) {
-         for (unsigned j = 0; j < blks[i]->NumUniforms; j++) {
-            if (sentinel) {
-               const char *begin = blks[i]->Uniforms[j].Name;
-               const char *end = strchr(begin, sentinel);
-
-               if (end == NULL)
-                  continue;
-
-               if ((ptrdiff_t) l != (end - begin))
-                  continue;
-
-               found = strncmp(var->name, begin, l) == 0;
-            } else {
-               found = strcmp(var->name, blks[i]->Uniforms[j].Name) == 0;
-            }
-
-            if (found) {
-               var->data.location = j;
-
-               if (variable_is_referenced(v, var))
-                  blks[i]->stageref |= 1U << stage;
+      block_member_index &members = var->data.mode == ir_var_uniform ?
+         ubo_members : ssbo_members;
+      unsigned block, member;
+      if (!members.find(var->name, sentinel, &block, &member)) {
+         assert(!"buffer variable not found in its block");
+         continue;
+      }
 
-               break;
-            }
-         }
+      var->data.location = member;
 
-         if (found)
-            break;
-      }
-      assert(found);
+      if (variable_is_referenced(v, var))
+         blks[block]->stageref |= 1U << stage;
    }
 }
 
@@ -1452,6 +1570,26 @@ link_setup_uniform_remap_tables(struct gl_context *ctx,
       }
    }
 
+   /* Grow the remap table once for everything that may not fit into the
+    * empty locations rather than for each uniform, and trim it afterwards.
+    */
+   unsigned remap_table_size = prog->NumUniformRemapTable;
+   for (unsigned i = 0; i < prog->data->NumUniformStorage; i++) {
+      if (prog->data->UniformStorage[i].type->is_subroutine() ||
+          prog->data->UniformStorage[i].is_shader_storage ||
+          prog->data->UniformStorage[i].builtin ||
+          prog->data->UniformStorage[i].remap_location != UNMAPPED_UNIFORM_LOC)
+         continue;
+
+      remap_table_size += MAX2(1, prog->data->UniformStorage[i].array_elements);
+   }
+
+   if (remap_table_size > prog->NumUniformRemapTable) {
+      prog->UniformRemapTable = reralloc(prog, prog->UniformRemapTable,
+                                         gl_uniform_storage *,
+                                         remap_table_size);
+   }
+
    /* Reserve locations for rest of the uniforms. */
    for (unsigned i = 0; i < prog->data->NumUniformStorage; i++) {
 
@@ -1488,14 +1626,8 @@ link_setup_uniform_remap_tables(struct gl_context *ctx,
          empty_locs -= entries;
       } else {
          chosen_location = prog->NumUniformRemapTable;
-
-         /* resize remap table to fit new entries */
-         prog->UniformRemapTable =
-            reralloc(prog,
-                     prog->UniformRemapTable,
-                     gl_uniform_storage *,
-                     prog->NumUniformRemapTable + entries);
          prog->NumUniformRemapTable += entries;
+         assert(prog->NumUniformRemapTable <= remap_table_size);
       }
 
       /* set pointers for this uniform */
@@ -1507,6 +1639,12 @@ link_setup_uniform_remap_tables(struct gl_context *ctx,
       prog->data->UniformStorage[i].remap_location = chosen_location;
    }
 
+   if (remap_table_size > prog->NumUniformRemapTable) {
+      prog->UniformRemapTable = reralloc(prog, prog->UniformRemapTable,
+                                         gl_uniform_storage *,
+                                         prog->NumUniformRemapTable);
+   }
+
    /* Verify that total amount of entries for explicit and implicit locations
     * is less than MAX_UNIFORM_LOCATIONS.
     */
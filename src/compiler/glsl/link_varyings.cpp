@@ -1072,6 +1072,24 @@ tfeedback_decl::is_same(const tfeedback_decl &x, const tfeedback_decl &y)
 }
 
 
+/**
+ * Return a string identifying the variable and array index (if applicable)
+ * that this tfeedback_decl refers to, such that two declarations have equal
+ * keys exactly when is_same() is true for them.
+ */
+const char *
+tfeedback_decl::hash_key(void *mem_ctx) const
+{
+   assert(this->is_varying());
+
+   if (!this->is_subscripted)
+      return this->var_name;
+
+   return ralloc_asprintf(mem_ctx, "%s[%u]", this->var_name,
+                          this->array_subscript);
+}
+
+
 /**
  * Assign a location and stream ID for this tfeedback_decl object based on the
  * transform feedback candidate found by find_candidate.
@@ -1495,6 +1513,14 @@ parse_tfeedback_decls(struct gl_context *ctx, struct gl_shader_program *prog,
                       const void *mem_ctx, unsigned num_names,
                       char **varying_names, tfeedback_decl *decls)
 {
+   /* Varyings seen so far, keyed by name and array index, so duplicates can
+    * be found without comparing every pair of declarations.
+    */
+   void *seen_ctx = ralloc_context(NULL);
+   struct hash_table *seen_decls =
+      _mesa_hash_table_create(seen_ctx, _mesa_hash_string,
+                              _mesa_key_string_equal);
+
    for (unsigned i = 0; i < num_names; ++i) {
       decls[i].init(ctx, mem_ctx, varying_names[i]);
 
@@ -1511,16 +1537,21 @@ parse_tfeedback_decls(struct gl_context *ctx, struct gl_shader_program *prog,
        * specify the same varying variable and array index", since transform
        * feedback of arrays would be useless otherwise.
        */
-      for (unsigned j = 0; j < i; ++j) {
-         if (decls[j].is_varying()) {
-            if (tfeedback_decl::is_same(decls[i], decls[j])) {
-               linker_error(prog, "Transform feedback varying %s specified "
-                            "more than once.", varying_names[i]);
-               return false;
-            }
-         }
+      const char *key = decls[i].hash_key(seen_ctx);
+      hash_entry *entry = _mesa_hash_table_search(seen_decls, key);
+      if (entry != NULL) {
+         assert(tfeedback_decl::is_same(decls[i],
+                                        *(const tfeedback_decl *) entry->data));
+         linker_error(prog, "Transform feedback varying %s specified "
+                      "more than once.", varying_names[i]);
+         ralloc_free(seen_ctx);
+         return false;
       }
+
+      _mesa_hash_table_insert(seen_decls, key, &decls[i]);
    }
+
+   ralloc_free(seen_ctx);
    return true;
 }
 
@@ -99,6 +99,7 @@ class tfeedback_decl
 public:
    void init(struct gl_context *ctx, const void *mem_ctx, const char *input);
    static bool is_same(const tfeedback_decl &x, const tfeedback_decl &y);
+   const char *hash_key(void *mem_ctx) const;
    bool assign_location(struct gl_context *ctx,
                         struct gl_shader_program *prog);
    unsigned get_num_outputs() const;
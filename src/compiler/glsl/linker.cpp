@@ -85,6 +85,11 @@
 #include "shader_cache.h"
 #include "util/u_string.h"
 #include "util/u_math.h"
+#include "util/os_time.h"
+#include "util/debug.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
+#include "c11/threads.h"
 
 
 #include "main/shaderobj.h"
@@ -4458,11 +4463,40 @@ link_and_validate_uniforms(struct gl_context *ctx,
    link_check_atomic_counter_resources(ctx, prog);
 }
 
+/**
+ * Nanoseconds spent in the phases of link_shaders(), printed to stderr with
+ * MESA_GLSL=link_time.
+ */
+struct link_time_breakdown {
+   int64_t intrastage;
+   int64_t interstage;
+   int64_t optimization;
+   int64_t varyings;
+   int64_t uniforms;
+};
+
+static void
+print_link_time_breakdown(const struct gl_shader_program *prog,
+                          const struct link_time_breakdown *times,
+                          int64_t total)
+{
+   fprintf(stderr, "GLSL link time for program %u: "
+           "intrastage %.3f ms, interstage %.3f ms, optimization %.3f ms, "
+           "varyings %.3f ms, uniforms %.3f ms, total %.3f ms\n",
+           prog->Name,
+           times->intrastage / 1000000.0, times->interstage / 1000000.0,
+           times->optimization / 1000000.0, times->varyings / 1000000.0,
+           times->uniforms / 1000000.0, total / 1000000.0);
+}
+
 static bool
 link_varyings_and_uniforms(unsigned first, unsigned last,
                            struct gl_context *ctx,
-                           struct gl_shader_program *prog, void *mem_ctx)
+                           struct gl_shader_program *prog, void *mem_ctx,
+                           struct link_time_breakdown *times)
 {
+   int64_t phase_start = os_time_get_nano();
+
    /* Mark all generic shader inputs and outputs as unpaired. */
    for (unsigned i = MESA_SHADER_VERTEX; i <= MESA_SHADER_FRAGMENT; i++) {
       if (prog->_LinkedShaders[i] != NULL) {
@@ -4499,11 +4533,15 @@ link_varyings_and_uniforms(unsigned first, unsigned last,
       break;
    }
 
-   if (!link_varyings(prog, first, last, ctx, mem_ctx))
+   bool varyings_linked = link_varyings(prog, first, last, ctx, mem_ctx);
+   times->varyings = os_time_get_nano() - phase_start;
+   if (!varyings_linked)
       return false;
 
+   phase_start = os_time_get_nano();
    if (!ctx->Const.UseNIRGLSLLinker)
       link_and_validate_uniforms(ctx, prog);
+   times->uniforms = os_time_get_nano() - phase_start;
 
    if (!prog->data->LinkStatus)
       return false;
@@ -4541,19 +4579,130 @@ linker_optimisation_loop(struct gl_context *ctx, exec_list *ir,
                                 ctx->Const.NativeIntegers);
       } else {
          /* Repeat it until it stops making changes. */
+         struct set *clean_functions = _mesa_pointer_set_create(NULL);
          while (do_common_optimization(ir, true, false,
                                        &ctx->Const.ShaderCompilerOptions[stage],
-                                       ctx->Const.NativeIntegers))
+                                       ctx->Const.NativeIntegers,
+                                       clean_functions))
             ;
+         _mesa_set_destroy(clean_functions, NULL);
       }
 }
 
+static void
+optimize_linked_stage(struct gl_context *ctx, exec_list *ir, unsigned stage)
+{
+   /* Call opts before lowering const arrays to uniforms so we can const
+    * propagate any elements accessed directly.
+    */
+   linker_optimisation_loop(ctx, ir, stage);
+
+   /* Call opts after lowering const arrays to copy propagate things. */
+   if (ctx->Const.GLSLLowerConstArrays &&
+       lower_const_arrays_to_uniforms(ir, stage,
+                                      ctx->Const.Program[stage].MaxUniformComponents))
+      linker_optimisation_loop(ctx, ir, stage);
+}
+
+/**
+ * Queue used to optimize the stages of a program in parallel.  It is shared
+ * by all contexts, and NULL when parallel linking is disabled or there is
+ * only one CPU.
+ */
+static struct util_queue stage_queue;
+static struct util_queue *stage_queue_ptr;
+static once_flag stage_queue_once_flag = ONCE_FLAG_INIT;
+
+static void
+init_stage_queue(void)
+{
+   if (!env_var_as_boolean("MESA_GLSL_PARALLEL_LINK", true))
+      return;
+
+   util_cpu_detect();
+   const unsigned num_threads =
+      MIN2(util_get_cpu_caps()->nr_cpus, MESA_SHADER_STAGES) - 1;
+   if (num_threads == 0)
+      return;
+
+   if (util_queue_init(&stage_queue, "glsl_link", MESA_SHADER_STAGES,
+                       num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL))
+      stage_queue_ptr = &stage_queue;
+}
+
+struct stage_optimization_job {
+   struct gl_context *ctx;
+   exec_list *ir;
+   unsigned stage;
+   struct util_queue_fence fence;
+};
+
+static void
+optimize_linked_stage_job(void *data, int thread_index)
+{
+   struct stage_optimization_job *job =
+      (struct stage_optimization_job *) data;
+
+   optimize_linked_stage(job->ctx, job->ir, job->stage);
+}
+
+/**
+ * Run the per-stage optimization loops of all linked stages.
+ *
+ * Until the cross-stage varying and uniform linking the stages don't share
+ * any IR, so all stages but the first are handed to the shared queue while
+ * the calling thread optimizes the first one.  The link then takes about as
+ * long as the most expensive stage.
+ */
+static void
+optimize_linked_stages(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   struct stage_optimization_job jobs[MESA_SHADER_STAGES];
+   unsigned num_jobs = 0;
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i] == NULL)
+         continue;
+
+      jobs[num_jobs].ctx = ctx;
+      jobs[num_jobs].ir = prog->_LinkedShaders[i]->ir;
+      jobs[num_jobs].stage = i;
+      num_jobs++;
+   }
+
+   if (num_jobs > 1)
+      call_once(&stage_queue_once_flag, init_stage_queue);
+
+   if (num_jobs <= 1 || stage_queue_ptr == NULL) {
+      for (unsigned i = 0; i < num_jobs; i++)
+         optimize_linked_stage(ctx, jobs[i].ir, jobs[i].stage);
+      return;
+   }
+
+   for (unsigned i = 1; i < num_jobs; i++) {
+      util_queue_fence_init(&jobs[i].fence);
+      util_queue_add_job(stage_queue_ptr, &jobs[i], &jobs[i].fence,
+                         optimize_linked_stage_job, NULL, 0);
+   }
+
+   optimize_linked_stage(ctx, jobs[0].ir, jobs[0].stage);
+
+   for (unsigned i = 1; i < num_jobs; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+}
+
 void
 link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
 {
    prog->data->LinkStatus = LINKING_SUCCESS; /* All error paths will set this to false */
    prog->data->Validated = false;
 
+   struct link_time_breakdown times = {};
+   const int64_t link_start = os_time_get_nano();
+   int64_t phase_start = link_start;
+
    /* Section 7.3 (Program Objects) of the OpenGL 4.5 Core Profile spec says:
     *
     *     "Linking can fail for a variety of reasons as specified in the
@@ -4741,6 +4890,9 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
       }
    }
 
+   times.intrastage = os_time_get_nano() - phase_start;
+   phase_start = os_time_get_nano();
+
    /* Here begins the inter-stage linking phase.  Some initial validation is
     * performed, then locations are assigned for uniforms, attributes, and
     * varyings.
@@ -4843,6 +4995,9 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
    if (!interstage_cross_validate_uniform_blocks(prog, true))
       goto done;
 
+   times.interstage = os_time_get_nano() - phase_start;
+   phase_start = os_time_get_nano();
+
    /* Do common optimization before assigning storage for attributes,
     * uniforms, and varyings.  Later optimization could possibly make
     * some of that unused.
@@ -4883,20 +5038,10 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
             goto done;
          }
       }
-
-      /* Call opts before lowering const arrays to uniforms so we can const
-       * propagate any elements accessed directly.
-       */
-      linker_optimisation_loop(ctx, prog->_LinkedShaders[i]->ir, i);
-
-      /* Call opts after lowering const arrays to copy propagate things. */
-      if (ctx->Const.GLSLLowerConstArrays &&
-          lower_const_arrays_to_uniforms(prog->_LinkedShaders[i]->ir, i,
-                                         ctx->Const.Program[i].MaxUniformComponents))
-         linker_optimisation_loop(ctx, prog->_LinkedShaders[i]->ir, i);
-
    }
 
+   optimize_linked_stages(ctx, prog);
+
    /* Validation for special cases where we allow sampler array indexing
     * with loop induction variable. This check emits a warning or error
     * depending if backend can handle dynamic indexing.
@@ -4912,7 +5057,9 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
 
    store_fragdepth_layout(prog);
 
-   if(!link_varyings_and_uniforms(first, last, ctx, prog, mem_ctx))
+   times.optimization = os_time_get_nano() - phase_start;
+
+   if(!link_varyings_and_uniforms(first, last, ctx, prog, mem_ctx, &times))
       goto done;
 
    /* Linking varyings can cause some extra, useless swizzles to be generated
@@ -4984,4 +5131,7 @@ done:
    }
 
    ralloc_free(mem_ctx);
+
+   if (ctx->_Shader && (ctx->_Shader->Flags & GLSL_LINK_TIME))
+      print_link_time_breakdown(prog, &times, os_time_get_nano() - link_start);
 }
@@ -37,10 +37,12 @@ public:
       this->state = state;
       this->progress = false;
       this->options = options;
+      this->growth_budget = 0;
    }
 
    virtual ir_visitor_status visit_leave(ir_loop *ir);
    void simple_unroll(ir_loop *ir, int iterations);
+   bool partial_unroll(ir_loop *ir, int iterations, int nodes);
    void complex_unroll(ir_loop *ir, int iterations,
                        bool continue_from_then_branch,
                        bool limiting_term_first,
@@ -51,28 +53,28 @@ public:
 
    bool progress;
    const struct gl_shader_compiler_options *options;
+
+   /**
+    * How many more nodes unrolling may add to the shader.
+    *
+    * Every loop may be small enough to unroll on its own, but a shader with
+    * many of them would still blow up.
+    */
+   int growth_budget;
 };
 
 } /* anonymous namespace */
 
-class loop_unroll_count : public ir_hierarchical_visitor {
+/**
+ * Rough estimate of how many instructions some IR will turn into.
+ */
+class ir_cost_count : public ir_hierarchical_visitor {
 public:
    int nodes;
-   bool unsupported_variable_indexing;
-   bool array_indexed_by_induction_var_with_exact_iterations;
-   /* If there are nested loops, the node count will be inaccurate. */
-   bool nested_loop;
 
-   loop_unroll_count(exec_list *list, loop_variable_state *ls,
-                     const struct gl_shader_compiler_options *options)
-      : ls(ls), options(options)
+   ir_cost_count()
    {
       nodes = 0;
-      nested_loop = false;
-      unsupported_variable_indexing = false;
-      array_indexed_by_induction_var_with_exact_iterations = false;
-
-      run(list);
    }
 
    virtual ir_visitor_status visit_enter(ir_assignment *)
@@ -87,6 +89,32 @@ public:
       return visit_continue;
    }
 
+   virtual ir_visitor_status visit_enter(ir_texture *)
+   {
+      /* Sampling costs a lot more than an ALU instruction. */
+      nodes += 4;
+      return visit_continue;
+   }
+};
+
+class loop_unroll_count : public ir_cost_count {
+public:
+   bool unsupported_variable_indexing;
+   bool array_indexed_by_induction_var_with_exact_iterations;
+   /* If there are nested loops, the node count will be inaccurate. */
+   bool nested_loop;
+
+   loop_unroll_count(exec_list *list, loop_variable_state *ls,
+                     const struct gl_shader_compiler_options *options)
+      : ls(ls), options(options)
+   {
+      nested_loop = false;
+      unsupported_variable_indexing = false;
+      array_indexed_by_induction_var_with_exact_iterations = false;
+
+      run(list);
+   }
+
    virtual ir_visitor_status visit_enter(ir_loop *)
    {
       nested_loop = true;
@@ -328,6 +356,95 @@ loop_unroll_visitor::complex_unroll(ir_loop *ir, int iterations,
 }
 
 
+/**
+ * Unroll a counted loop that is too long to unroll completely by a factor
+ * that divides its iteration count.  This only handles loops whose only jump
+ * is the limiting terminator at the top.  For example, if the input is:
+ *
+ *     (loop (
+ *      (if (cond) (break))
+ *      ...body...))
+ *
+ * And the factor is 2, the output will be:
+ *
+ *     (loop (
+ *      (if (cond) (break))
+ *      ...body...
+ *      ...body...))
+ *
+ * The terminator of the second copy can be dropped because the exit happens
+ * on an iteration that is a multiple of the factor.
+ *
+ * \return true if the loop was unrolled.
+ */
+bool
+loop_unroll_visitor::partial_unroll(ir_loop *ir, int iterations, int nodes)
+{
+   loop_variable_state *const ls = this->state->get(ir);
+
+   /* The driver wants the loop gone entirely. */
+   if (options->EmitNoLoops)
+      return false;
+
+   if (ls->num_loop_jumps != 1)
+      return false;
+
+   ir_if *limit_if = ls->limiting_terminator->ir;
+   if (limit_if != ir->body_instructions.get_head())
+      return false;
+
+   /* The terminator must be nothing but the break. */
+   exec_list *break_list = &limit_if->then_instructions;
+   exec_list *other_list = &limit_if->else_instructions;
+   if (!is_break((ir_instruction *) break_list->get_tail())) {
+      break_list = &limit_if->else_instructions;
+      other_list = &limit_if->then_instructions;
+   }
+
+   if (!is_break((ir_instruction *) break_list->get_tail()) ||
+       break_list->get_head() != break_list->get_tail() ||
+       !other_list->is_empty())
+      return false;
+
+   const int max_nodes = options->MaxUnrollIterations * 5;
+
+   int factor;
+   for (factor = 4; factor > 1; factor /= 2) {
+      if (iterations > factor && iterations % factor == 0 &&
+          nodes * factor <= max_nodes &&
+          nodes * (factor - 1) <= this->growth_budget)
+         break;
+   }
+
+   if (factor == 1)
+      return false;
+
+   void *const mem_ctx = ralloc_parent(ir);
+
+   /* Make all the copies before adding any of them to the body. */
+   exec_list copies;
+   copies.make_empty();
+   for (int i = 1; i < factor; i++) {
+      exec_list copy_list;
+
+      copy_list.make_empty();
+      clone_ir_list(mem_ctx, &copy_list, &ir->body_instructions);
+
+      /* Drop the copy of the terminator. */
+      ((ir_instruction *) copy_list.get_head())->remove();
+
+      copies.append_list(&copy_list);
+   }
+
+   ir->body_instructions.append_list(&copies);
+
+   this->growth_budget -= nodes * (factor - 1);
+   this->progress = true;
+
+   return true;
+}
+
+
 /**
  * Move all of the instructions which follow \c ir_if to the end of
  * \c splice_dest.
@@ -467,21 +584,33 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
 
    const int max_iterations = options->MaxUnrollIterations;
 
+   loop_unroll_count count(&ir->body_instructions, ls, options);
+
    /* Don't try to unroll loops that have zillions of iterations either.
     */
-   if (iterations > max_iterations)
+   if (iterations > max_iterations) {
+      if (!count.nested_loop)
+         partial_unroll(ir, iterations, count.nodes);
       return visit_continue;
+   }
 
-   /* Don't try to unroll nested loops and loops with a huge body.
+   /* Don't try to unroll nested loops and loops with a huge body, or loops
+    * that would make the shader as a whole too large.  Drivers that can't
+    * do loops at all have to unroll them no matter what.
     */
-   loop_unroll_count count(&ir->body_instructions, ls, options);
+   const int growth = count.nodes * iterations;
+   const bool must_unroll = count.unsupported_variable_indexing ||
+      count.array_indexed_by_induction_var_with_exact_iterations;
 
    bool loop_too_large =
-      count.nested_loop || count.nodes * iterations > max_iterations * 5;
+      count.nested_loop || growth > max_iterations * 5 ||
+      (growth > this->growth_budget && !options->EmitNoLoops);
 
-   if (loop_too_large && !count.unsupported_variable_indexing &&
-       !count.array_indexed_by_induction_var_with_exact_iterations)
+   if (loop_too_large && !must_unroll) {
+      if (!count.nested_loop)
+         partial_unroll(ir, iterations, count.nodes);
       return visit_continue;
+   }
 
    /* Note: the limiting terminator contributes 1 to ls->num_loop_jumps.
     * We'll be removing the limiting terminator before we unroll.
@@ -494,6 +623,7 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
 
    if (predicted_num_loop_jumps == 0) {
       simple_unroll(ir, iterations);
+      this->growth_budget -= growth;
       return visit_continue;
    }
 
@@ -544,6 +674,7 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
                            first_ir->as_if() != ls->limiting_terminator->ir ||
                            ebi,
                            first_term_then_continue);
+            this->growth_budget -= growth;
             return visit_continue;
          }
       } else {
@@ -562,6 +693,7 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
                               first_ir->as_if() != ls->limiting_terminator->ir ||
                               ebi,
                               first_term_then_continue);
+               this->growth_budget -= growth;
                return visit_continue;
             } else {
                first_term_then_continue = true;
@@ -585,6 +717,13 @@ unroll_loops(exec_list *instructions, loop_state *ls,
 {
    loop_unroll_visitor v(ls, options);
 
+   /* Let unrolling at most quadruple the size of the shader, but always
+    * allow one loop of the maximum size.
+    */
+   ir_cost_count size;
+   size.run(instructions);
+   v.growth_budget = MAX2(size.nodes * 3, (int) options->MaxUnrollIterations * 5);
+
    v.run(instructions);
 
    return v.progress;
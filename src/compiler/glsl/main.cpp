@@ -38,6 +38,8 @@
 #include "standalone.h"
 
 static struct standalone_options options;
+static int batch;
+static unsigned num_threads = 1;
 
 const struct option compiler_opts[] = {
    { "dump-ast", no_argument, &options.dump_ast, 1 },
@@ -48,6 +50,8 @@ const struct option compiler_opts[] = {
    { "just-log", no_argument, &options.just_log, 1 },
    { "lower-precision", no_argument, &options.lower_precision, 1 },
    { "version",  required_argument, NULL, 'v' },
+   { "batch",    no_argument, &batch, 1 },
+   { "threads",  required_argument, NULL, 't' },
    { NULL, 0, NULL, 0 }
 };
 
@@ -60,9 +64,10 @@ usage_fail(const char *name)
 
    const char *header =
       "usage: %s [options] <file.vert | file.tesc | file.tese | file.geom | file.frag | file.comp>\n"
+      "       %s --batch [--threads N] <file.shader_test | directory>...\n"
       "\n"
       "Possible options are:\n";
-   printf(header, name);
+   printf(header, name, name);
    for (const struct option *o = compiler_opts; o->name != 0; ++o) {
       printf("    --%s", o->name);
       if (o->has_arg == required_argument)
@@ -84,6 +89,9 @@ main(int argc, char * const* argv)
       case 'v':
          options.glsl_version = strtol(optarg, NULL, 10);
          break;
+      case 't':
+         num_threads = strtol(optarg, NULL, 10);
+         break;
       default:
          break;
       }
@@ -92,6 +100,11 @@ main(int argc, char * const* argv)
    if (argc <= optind)
       usage_fail(argv[0]);
 
+   if (batch) {
+      return standalone_compile_batch(&options, argc - optind, &argv[optind],
+                                      num_threads);
+   }
+
    struct gl_shader_program *whole_program;
    static struct gl_context local_ctx;
 
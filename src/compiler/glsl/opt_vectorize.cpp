@@ -50,6 +50,22 @@
  * into a single vector operation
  *
  * (assign (xyz) (var_ref r1) (expression vec3 log2 (swiz xyz (var_ref v0))))
+ *
+ * Afterwards, consecutive scalar assignments of isomorphic expressions to
+ * different variables are packed as well (superword-level parallelism).
+ * The expression trees have to match except for the channels of the
+ * swizzles and the values of the constants at their leaves, e.g.
+ *
+ * (assign (x) (var_ref t0) (expression float * (swiz x (var_ref v0)) (constant float (2.0))))
+ * (assign (x) (var_ref t1) (expression float * (swiz z (var_ref v0)) (constant float (3.0))))
+ *
+ * becomes
+ *
+ * (assign (xy) (var_ref tmp) (expression vec2 * (swiz xz (var_ref v0)) (constant vec2 (2.0 3.0))))
+ * (assign (x) (var_ref t0) (swiz x (var_ref tmp)))
+ * (assign (x) (var_ref t1) (swiz y (var_ref tmp)))
+ *
+ * and copy propagation then replaces the uses of t0 and t1.
  */
 
 #include "ir.h"
@@ -388,10 +404,257 @@ ir_vectorize_visitor::visit_leave(ir_assignment *ir)
    return visit_continue;
 }
 
+static bool
+is_packable_type(const glsl_type *type)
+{
+   return type->is_scalar() &&
+          (type->base_type == GLSL_TYPE_FLOAT ||
+           type->base_type == GLSL_TYPE_INT ||
+           type->base_type == GLSL_TYPE_UINT ||
+           type->base_type == GLSL_TYPE_BOOL);
+}
+
+/**
+ * Returns whether two scalar expression trees can be computed by a single
+ * vector expression tree.
+ */
+static bool
+lanes_match(const ir_rvalue *a, const ir_rvalue *b)
+{
+   if (a->ir_type != b->ir_type || a->type != b->type ||
+       !is_packable_type(a->type))
+      return false;
+
+   switch (a->ir_type) {
+   case ir_type_expression: {
+      const ir_expression *expr_a = (const ir_expression *)a;
+      const ir_expression *expr_b = (const ir_expression *)b;
+
+      if (expr_a->operation != expr_b->operation || expr_a->is_horizontal())
+         return false;
+
+      for (unsigned i = 0; i < expr_a->num_operands; i++) {
+         if (!lanes_match(expr_a->operands[i], expr_b->operands[i]))
+            return false;
+      }
+      return true;
+   }
+   case ir_type_swizzle: {
+      const ir_swizzle *swz_a = (const ir_swizzle *)a;
+      const ir_swizzle *swz_b = (const ir_swizzle *)b;
+
+      return swz_a->val->as_dereference_variable() &&
+             swz_a->val->equals(swz_b->val);
+   }
+   case ir_type_constant:
+      return true;
+   case ir_type_dereference_variable:
+      return a->equals(b);
+   default:
+      return false;
+   }
+}
+
+/**
+ * Returns whether an expression tree accepted by lanes_match() reads var.
+ */
+static bool
+rvalue_reads(const ir_rvalue *ir, const ir_variable *var)
+{
+   switch (ir->ir_type) {
+   case ir_type_expression: {
+      const ir_expression *expr = (const ir_expression *)ir;
+      for (unsigned i = 0; i < expr->num_operands; i++) {
+         if (rvalue_reads(expr->operands[i], var))
+            return true;
+      }
+      return false;
+   }
+   case ir_type_swizzle:
+      return rvalue_reads(((const ir_swizzle *)ir)->val, var);
+   case ir_type_dereference_variable:
+      return ((const ir_dereference_variable *)ir)->var == var;
+   default:
+      return false;
+   }
+}
+
+/**
+ * Only assignments to temporaries are packed, copy propagation can then get
+ * rid of the copies out of the vector temporary.
+ */
+static bool
+is_pack_candidate(const ir_assignment *ir)
+{
+   const ir_dereference_variable *lhs = ir->lhs->as_dereference_variable();
+
+   return !ir->condition && lhs &&
+          (lhs->var->data.mode == ir_var_temporary ||
+           lhs->var->data.mode == ir_var_auto) &&
+          single_channel_write_mask(ir->write_mask) &&
+          ir->rhs->as_expression() &&
+          lanes_match(ir->rhs, ir->rhs);
+}
+
+/**
+ * Returns whether ir can be computed together with the assignments in
+ * group.  It must not read anything written by them, since the packed
+ * expression is evaluated before the first of them.
+ */
+static bool
+can_join_group(ir_assignment **group, unsigned count, const ir_assignment *ir)
+{
+   if (!is_pack_candidate(ir) || !lanes_match(group[0]->rhs, ir->rhs))
+      return false;
+
+   for (unsigned i = 0; i < count; i++) {
+      if (rvalue_reads(ir->rhs, group[i]->lhs->variable_referenced()))
+         return false;
+   }
+   return true;
+}
+
+/**
+ * Builds the vector form of the expression trees in lanes, which must have
+ * been accepted by lanes_match().
+ */
+static ir_rvalue *
+pack_lanes(void *mem_ctx, ir_rvalue **lanes, unsigned count)
+{
+   ir_rvalue *ir = lanes[0];
+   const glsl_type *type =
+      glsl_type::get_instance(ir->type->base_type, count, 1);
+
+   switch (ir->ir_type) {
+   case ir_type_expression: {
+      ir_expression *expr = (ir_expression *)ir;
+      ir_rvalue *ops[4] = { NULL, NULL, NULL, NULL };
+
+      for (unsigned i = 0; i < expr->num_operands; i++) {
+         ir_rvalue *op_lanes[4];
+         for (unsigned j = 0; j < count; j++)
+            op_lanes[j] = ((ir_expression *)lanes[j])->operands[i];
+         ops[i] = pack_lanes(mem_ctx, op_lanes, count);
+      }
+
+      return new(mem_ctx) ir_expression(expr->operation, type,
+                                        ops[0], ops[1], ops[2], ops[3]);
+   }
+   case ir_type_swizzle: {
+      unsigned components[4];
+      for (unsigned j = 0; j < count; j++)
+         components[j] = ((ir_swizzle *)lanes[j])->mask.x;
+
+      return new(mem_ctx) ir_swizzle(((ir_swizzle *)ir)->val->clone(mem_ctx, NULL),
+                                     components, count);
+   }
+   case ir_type_constant: {
+      ir_constant_data data;
+      memset(&data, 0, sizeof(data));
+      for (unsigned j = 0; j < count; j++) {
+         if (type->base_type == GLSL_TYPE_BOOL)
+            data.b[j] = ((ir_constant *)lanes[j])->value.b[0];
+         else
+            data.u[j] = ((ir_constant *)lanes[j])->value.u[0];
+      }
+
+      return new(mem_ctx) ir_constant(type, &data);
+   }
+   case ir_type_dereference_variable:
+      return new(mem_ctx) ir_swizzle(ir->clone(mem_ctx, NULL), 0, 0, 0, 0,
+                                     count);
+   default:
+      unreachable("not reached");
+   }
+}
+
+/**
+ * Replaces the assignments in group by one vector assignment to a new
+ * temporary, followed by scalar copies out of it.
+ */
+static bool
+pack_group(ir_assignment **group, unsigned count)
+{
+   if (count < 2)
+      return false;
+
+   void *mem_ctx = ralloc_parent(group[0]);
+
+   ir_rvalue *lanes[4];
+   for (unsigned j = 0; j < count; j++)
+      lanes[j] = group[j]->rhs;
+
+   ir_rvalue *packed = pack_lanes(mem_ctx, lanes, count);
+   ir_variable *tmp = new(mem_ctx) ir_variable(packed->type, "vectorize_tmp",
+                                               ir_var_temporary);
+   group[0]->insert_before(tmp);
+   group[0]->insert_before(
+      new(mem_ctx) ir_assignment(new(mem_ctx) ir_dereference_variable(tmp),
+                                 packed));
+
+   for (unsigned j = 0; j < count; j++) {
+      group[j]->rhs =
+         new(mem_ctx) ir_swizzle(new(mem_ctx) ir_dereference_variable(tmp),
+                                 j, 0, 0, 0, 1);
+   }
+
+   return true;
+}
+
+/**
+ * Packs runs of up to four consecutive isomorphic scalar assignments in
+ * instructions and in the blocks nested in it.
+ */
+static bool
+pack_isomorphic_assignments(exec_list *instructions)
+{
+   ir_assignment *group[4];
+   unsigned count = 0;
+   bool progress = false;
+
+   foreach_in_list(ir_instruction, ir, instructions) {
+      ir_assignment *assign = ir->as_assignment();
+
+      if (assign && count > 0 && count < 4 &&
+          can_join_group(group, count, assign)) {
+         group[count++] = assign;
+         continue;
+      }
+
+      progress = pack_group(group, count) || progress;
+      count = 0;
+
+      if (assign && is_pack_candidate(assign)) {
+         group[count++] = assign;
+         continue;
+      }
+
+      switch (ir->ir_type) {
+      case ir_type_function:
+         foreach_in_list(ir_function_signature, sig,
+                         &((ir_function *)ir)->signatures) {
+            progress = pack_isomorphic_assignments(&sig->body) || progress;
+         }
+         break;
+      case ir_type_if:
+         progress = pack_isomorphic_assignments(&((ir_if *)ir)->then_instructions) || progress;
+         progress = pack_isomorphic_assignments(&((ir_if *)ir)->else_instructions) || progress;
+         break;
+      case ir_type_loop:
+         progress = pack_isomorphic_assignments(&((ir_loop *)ir)->body_instructions) || progress;
+         break;
+      default:
+         break;
+      }
+   }
+
+   return pack_group(group, count) || progress;
+}
+
 /**
  * Combines scalar assignments of the same expression (modulo swizzle) to
  * multiple channels of the same variable into a single vectorized expression
- * and assignment.
+ * and assignment, then packs the remaining isomorphic scalar assignments.
  */
 bool
 do_vectorize(exec_list *instructions)
@@ -403,5 +666,8 @@ do_vectorize(exec_list *instructions)
    /* Try to vectorize the last assignments seen. */
    v.try_vectorize();
 
+   if (pack_isomorphic_assignments(instructions))
+      v.progress = true;
+
    return v.progress;
 }
@@ -25,6 +25,9 @@
 #ifndef GLSL_PROGRAM_H
 #define GLSL_PROGRAM_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -37,6 +40,27 @@ extern void
 _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
 			  bool dump_ast, bool dump_hir, bool force_recompile);
 
+/**
+ * Time spent in each phase of _mesa_glsl_compile_shader(), in nanoseconds.
+ */
+struct glsl_compile_timings {
+   int64_t preprocess;
+   int64_t parse;
+   int64_t ast_to_hir;
+   int64_t optimize;
+};
+
+/**
+ * Same as _mesa_glsl_compile_shader(), adding the time spent in each phase
+ * to \p timings.
+ */
+extern void
+_mesa_glsl_compile_shader_timed(struct gl_context *ctx,
+                                struct gl_shader *shader,
+                                bool dump_ast, bool dump_hir,
+                                bool force_recompile,
+                                struct glsl_compile_timings *timings);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
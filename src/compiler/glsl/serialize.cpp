@@ -37,10 +37,13 @@
 #include "program/program.h"
 #include "string_to_uint_map.h"
 #include "util/bitscan.h"
+#include "util/hash_table.h"
+#include "util/u_dynarray.h"
 
 
 static void
-write_subroutines(struct blob *metadata, struct gl_shader_program *prog)
+write_subroutines(struct blob *metadata, struct gl_shader_program *prog,
+                  struct hash_table *types)
 {
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
       struct gl_linked_shader *sh = prog->_LinkedShaders[i];
@@ -60,15 +63,17 @@ write_subroutines(struct blob *metadata, struct gl_shader_program *prog)
          blob_write_uint32(metadata, num_types);
 
          for (int k = 0; k < num_types; k++) {
-            encode_type_to_blob(metadata,
-                                glprog->sh.SubroutineFunctions[j].types[k]);
+            encode_type_to_blob_table(metadata,
+                                      glprog->sh.SubroutineFunctions[j].types[k],
+                                      types);
          }
       }
    }
 }
 
 static void
-read_subroutines(struct blob_reader *metadata, struct gl_shader_program *prog)
+read_subroutines(struct blob_reader *metadata, struct gl_shader_program *prog,
+                 struct util_dynarray *types)
 {
    struct gl_subroutine_function *subs;
 
@@ -95,14 +100,15 @@ read_subroutines(struct blob_reader *metadata, struct gl_shader_program *prog)
          subs[j].types = rzalloc_array(prog, const struct glsl_type *,
                                        subs[j].num_compat_types);
          for (int k = 0; k < subs[j].num_compat_types; k++) {
-            subs[j].types[k] = decode_type_from_blob(metadata);
+            subs[j].types[k] = decode_type_from_blob_table(metadata, types);
          }
       }
    }
 }
 
 static void
-write_buffer_block(struct blob *metadata, struct gl_uniform_block *b)
+write_buffer_block(struct blob *metadata, struct gl_uniform_block *b,
+                   struct hash_table *types)
 {
    blob_write_string(metadata, b->Name);
    blob_write_uint32(metadata, b->NumUniforms);
@@ -113,23 +119,25 @@ write_buffer_block(struct blob *metadata, struct gl_uniform_block *b)
    for (unsigned j = 0; j < b->NumUniforms; j++) {
       blob_write_string(metadata, b->Uniforms[j].Name);
       blob_write_string(metadata, b->Uniforms[j].IndexName);
-      encode_type_to_blob(metadata, b->Uniforms[j].Type);
+      encode_type_to_blob_table(metadata, b->Uniforms[j].Type, types);
       blob_write_uint32(metadata, b->Uniforms[j].Offset);
    }
 }
 
 static void
-write_buffer_blocks(struct blob *metadata, struct gl_shader_program *prog)
+write_buffer_blocks(struct blob *metadata, struct gl_shader_program *prog,
+                    struct hash_table *types)
 {
    blob_write_uint32(metadata, prog->data->NumUniformBlocks);
    blob_write_uint32(metadata, prog->data->NumShaderStorageBlocks);
 
    for (unsigned i = 0; i < prog->data->NumUniformBlocks; i++) {
-      write_buffer_block(metadata, &prog->data->UniformBlocks[i]);
+      write_buffer_block(metadata, &prog->data->UniformBlocks[i], types);
    }
 
    for (unsigned i = 0; i < prog->data->NumShaderStorageBlocks; i++) {
-      write_buffer_block(metadata, &prog->data->ShaderStorageBlocks[i]);
+      write_buffer_block(metadata, &prog->data->ShaderStorageBlocks[i],
+                         types);
    }
 
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
@@ -156,11 +164,27 @@ write_buffer_blocks(struct blob *metadata, struct gl_shader_program *prog)
    }
 }
 
+/**
+ * Read a name owned by the program data.
+ *
+ * When the blob is kept alive as long as the program data, the name is
+ * referenced in place instead of being copied.
+ */
+static char *
+read_data_name(struct blob_reader *metadata, struct gl_shader_program *prog,
+               bool in_place)
+{
+   char *name = blob_read_string(metadata);
+
+   return in_place ? name : ralloc_strdup(prog->data, name);
+}
+
 static void
 read_buffer_block(struct blob_reader *metadata, struct gl_uniform_block *b,
-                  struct gl_shader_program *prog)
+                  struct gl_shader_program *prog, bool in_place,
+                  struct util_dynarray *types)
 {
-      b->Name = ralloc_strdup(prog->data, blob_read_string (metadata));
+      b->Name = read_data_name(metadata, prog, in_place);
       b->NumUniforms = blob_read_uint32(metadata);
       b->Binding = blob_read_uint32(metadata);
       b->UniformBufferSize = blob_read_uint32(metadata);
@@ -170,24 +194,25 @@ read_buffer_block(struct blob_reader *metadata, struct gl_uniform_block *b,
          rzalloc_array(prog->data, struct gl_uniform_buffer_variable,
                        b->NumUniforms);
       for (unsigned j = 0; j < b->NumUniforms; j++) {
-         b->Uniforms[j].Name = ralloc_strdup(prog->data,
-                                             blob_read_string (metadata));
+         b->Uniforms[j].Name = read_data_name(metadata, prog, in_place);
 
          char *index_name = blob_read_string(metadata);
          if (strcmp(b->Uniforms[j].Name, index_name) == 0) {
             b->Uniforms[j].IndexName = b->Uniforms[j].Name;
          } else {
-            b->Uniforms[j].IndexName = ralloc_strdup(prog->data, index_name);
+            b->Uniforms[j].IndexName = in_place ? index_name :
+               ralloc_strdup(prog->data, index_name);
          }
 
-         b->Uniforms[j].Type = decode_type_from_blob(metadata);
+         b->Uniforms[j].Type = decode_type_from_blob_table(metadata, types);
          b->Uniforms[j].Offset = blob_read_uint32(metadata);
       }
 }
 
 static void
 read_buffer_blocks(struct blob_reader *metadata,
-                   struct gl_shader_program *prog)
+                   struct gl_shader_program *prog, bool in_place,
+                   struct util_dynarray *types)
 {
    prog->data->NumUniformBlocks = blob_read_uint32(metadata);
    prog->data->NumShaderStorageBlocks = blob_read_uint32(metadata);
@@ -201,11 +226,13 @@ read_buffer_blocks(struct blob_reader *metadata,
                     prog->data->NumShaderStorageBlocks);
 
    for (unsigned i = 0; i < prog->data->NumUniformBlocks; i++) {
-      read_buffer_block(metadata, &prog->data->UniformBlocks[i], prog);
+      read_buffer_block(metadata, &prog->data->UniformBlocks[i], prog,
+                        in_place, types);
    }
 
    for (unsigned i = 0; i < prog->data->NumShaderStorageBlocks; i++) {
-      read_buffer_block(metadata, &prog->data->ShaderStorageBlocks[i], prog);
+      read_buffer_block(metadata, &prog->data->ShaderStorageBlocks[i], prog,
+                        in_place, types);
    }
 
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
@@ -426,14 +453,16 @@ has_uniform_storage(struct gl_shader_program *prog, unsigned idx)
 }
 
 static void
-write_uniforms(struct blob *metadata, struct gl_shader_program *prog)
+write_uniforms(struct blob *metadata, struct gl_shader_program *prog,
+               struct hash_table *types)
 {
    blob_write_uint32(metadata, prog->SamplersValidated);
    blob_write_uint32(metadata, prog->data->NumUniformStorage);
    blob_write_uint32(metadata, prog->data->NumUniformDataSlots);
 
    for (unsigned i = 0; i < prog->data->NumUniformStorage; i++) {
-      encode_type_to_blob(metadata, prog->data->UniformStorage[i].type);
+      encode_type_to_blob_table(metadata, prog->data->UniformStorage[i].type,
+                                types);
       blob_write_uint32(metadata, prog->data->UniformStorage[i].array_elements);
       if (prog->data->UniformStorage[i].name) {
          blob_write_string(metadata, prog->data->UniformStorage[i].name);
@@ -489,7 +518,8 @@ write_uniforms(struct blob *metadata, struct gl_shader_program *prog)
 }
 
 static void
-read_uniforms(struct blob_reader *metadata, struct gl_shader_program *prog)
+read_uniforms(struct blob_reader *metadata, struct gl_shader_program *prog,
+              bool in_place, struct util_dynarray *types)
 {
    struct gl_uniform_storage *uniforms;
    union gl_constant_value *data;
@@ -512,9 +542,10 @@ read_uniforms(struct blob_reader *metadata, struct gl_shader_program *prog)
    prog->UniformHash = new string_to_uint_map;
 
    for (unsigned i = 0; i < prog->data->NumUniformStorage; i++) {
-      uniforms[i].type = decode_type_from_blob(metadata);
+      uniforms[i].type = decode_type_from_blob_table(metadata, types);
       uniforms[i].array_elements = blob_read_uint32(metadata);
-      uniforms[i].name = ralloc_strdup(prog, blob_read_string (metadata));
+      uniforms[i].name = in_place ? blob_read_string(metadata) :
+         ralloc_strdup(prog, blob_read_string(metadata));
       uniforms[i].builtin = blob_read_uint32(metadata);
       uniforms[i].remap_location = blob_read_uint32(metadata);
       uniforms[i].block_index = blob_read_uint32(metadata);
@@ -796,7 +827,8 @@ enum uniform_type
 static void
 write_program_resource_data(struct blob *metadata,
                             struct gl_shader_program *prog,
-                            struct gl_program_resource *res)
+                            struct gl_program_resource *res,
+                            struct hash_table *types)
 {
    struct gl_linked_shader *sh;
 
@@ -805,9 +837,9 @@ write_program_resource_data(struct blob *metadata,
    case GL_PROGRAM_OUTPUT: {
       const gl_shader_variable *var = (gl_shader_variable *)res->Data;
 
-      encode_type_to_blob(metadata, var->type);
-      encode_type_to_blob(metadata, var->interface_type);
-      encode_type_to_blob(metadata, var->outermost_struct_type);
+      encode_type_to_blob_table(metadata, var->type, types);
+      encode_type_to_blob_table(metadata, var->interface_type, types);
+      encode_type_to_blob_table(metadata, var->outermost_struct_type, types);
 
       if (var->name) {
          blob_write_string(metadata, var->name);
@@ -909,7 +941,8 @@ write_program_resource_data(struct blob *metadata,
 static void
 read_program_resource_data(struct blob_reader *metadata,
                            struct gl_shader_program *prog,
-                           struct gl_program_resource *res)
+                           struct gl_program_resource *res, bool in_place,
+                           struct util_dynarray *types)
 {
    struct gl_linked_shader *sh;
 
@@ -918,11 +951,12 @@ read_program_resource_data(struct blob_reader *metadata,
    case GL_PROGRAM_OUTPUT: {
       gl_shader_variable *var = ralloc(prog, struct gl_shader_variable);
 
-      var->type = decode_type_from_blob(metadata);
-      var->interface_type = decode_type_from_blob(metadata);
-      var->outermost_struct_type = decode_type_from_blob(metadata);
+      var->type = decode_type_from_blob_table(metadata, types);
+      var->interface_type = decode_type_from_blob_table(metadata, types);
+      var->outermost_struct_type = decode_type_from_blob_table(metadata, types);
 
-      var->name = ralloc_strdup(prog, blob_read_string(metadata));
+      var->name = in_place ? blob_read_string(metadata) :
+         ralloc_strdup(prog, blob_read_string(metadata));
 
       size_t s_var_size, s_var_ptrs;
       get_shader_var_and_pointer_sizes(&s_var_size, &s_var_ptrs, var);
@@ -984,14 +1018,15 @@ read_program_resource_data(struct blob_reader *metadata,
 
 static void
 write_program_resource_list(struct blob *metadata,
-                            struct gl_shader_program *prog)
+                            struct gl_shader_program *prog,
+                            struct hash_table *types)
 {
    blob_write_uint32(metadata, prog->data->NumProgramResourceList);
 
    for (unsigned i = 0; i < prog->data->NumProgramResourceList; i++) {
       blob_write_uint32(metadata, prog->data->ProgramResourceList[i].Type);
       write_program_resource_data(metadata, prog,
-                                  &prog->data->ProgramResourceList[i]);
+                                  &prog->data->ProgramResourceList[i], types);
       blob_write_bytes(metadata,
                        &prog->data->ProgramResourceList[i].StageReferences,
                        sizeof(prog->data->ProgramResourceList[i].StageReferences));
@@ -1000,7 +1035,8 @@ write_program_resource_list(struct blob *metadata,
 
 static void
 read_program_resource_list(struct blob_reader *metadata,
-                           struct gl_shader_program *prog)
+                           struct gl_shader_program *prog, bool in_place,
+                           struct util_dynarray *types)
 {
    prog->data->NumProgramResourceList = blob_read_uint32(metadata);
 
@@ -1011,7 +1047,8 @@ read_program_resource_list(struct blob_reader *metadata,
    for (unsigned i = 0; i < prog->data->NumProgramResourceList; i++) {
       prog->data->ProgramResourceList[i].Type = blob_read_uint32(metadata);
       read_program_resource_data(metadata, prog,
-                                 &prog->data->ProgramResourceList[i]);
+                                 &prog->data->ProgramResourceList[i],
+                                 in_place, types);
       blob_copy_bytes(metadata,
                       (uint8_t *) &prog->data->ProgramResourceList[i].StageReferences,
                       sizeof(prog->data->ProgramResourceList[i].StageReferences));
@@ -1254,9 +1291,26 @@ extern "C" void
 serialize_glsl_program(struct blob *blob, struct gl_context *ctx,
                        struct gl_shader_program *prog)
 {
+   /* Most of the binary is the shader info and the driver blobs of the
+    * linked stages, so allocate space for them upfront instead of growing
+    * the blob many times.
+    */
+   size_t size_hint = sizeof(prog->data->sha1);
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      struct gl_linked_shader *sh = prog->_LinkedShaders[i];
+      if (sh)
+         size_hint += sizeof(shader_info) + sh->Program->driver_cache_blob_size;
+   }
+   blob_ensure_capacity(blob, size_hint);
+
    blob_write_bytes(blob, prog->data->sha1, sizeof(prog->data->sha1));
 
-   write_uniforms(blob, prog);
+   /* Uniforms, blocks and resources tend to repeat the same aggregate types,
+    * so each one is written once and referred to by index afterwards.
+    */
+   struct hash_table *types = _mesa_pointer_hash_table_create(NULL);
+
+   write_uniforms(blob, prog, types);
 
    write_hash_tables(blob, prog);
 
@@ -1296,16 +1350,18 @@ serialize_glsl_program(struct blob *blob, struct gl_context *ctx,
 
    write_atomic_buffers(blob, prog);
 
-   write_buffer_blocks(blob, prog);
+   write_buffer_blocks(blob, prog, types);
+
+   write_subroutines(blob, prog, types);
 
-   write_subroutines(blob, prog);
+   write_program_resource_list(blob, prog, types);
 
-   write_program_resource_list(blob, prog);
+   _mesa_hash_table_destroy(types, NULL);
 }
 
 extern "C" bool
 deserialize_glsl_program(struct blob_reader *blob, struct gl_context *ctx,
-                         struct gl_shader_program *prog)
+                         struct gl_shader_program *prog, bool in_place)
 {
    /* Fixed function programs generated by Mesa can't be serialized. */
    if (prog->Name == 0)
@@ -1315,7 +1371,10 @@ deserialize_glsl_program(struct blob_reader *blob, struct gl_context *ctx,
 
    blob_copy_bytes(blob, prog->data->sha1, sizeof(prog->data->sha1));
 
-   read_uniforms(blob, prog);
+   struct util_dynarray types;
+   util_dynarray_init(&types, NULL);
+
+   read_uniforms(blob, prog, in_place, &types);
 
    read_hash_tables(blob, prog);
 
@@ -1336,11 +1395,13 @@ deserialize_glsl_program(struct blob_reader *blob, struct gl_context *ctx,
 
    read_atomic_buffers(blob, prog);
 
-   read_buffer_blocks(blob, prog);
+   read_buffer_blocks(blob, prog, in_place, &types);
+
+   read_subroutines(blob, prog, &types);
 
-   read_subroutines(blob, prog);
+   read_program_resource_list(blob, prog, in_place, &types);
 
-   read_program_resource_list(blob, prog);
+   util_dynarray_fini(&types);
 
    return !blob->overrun;
 }
@@ -39,9 +39,16 @@ void
 serialize_glsl_program(struct blob *blob, struct gl_context *ctx,
                        struct gl_shader_program *prog);
 
+/**
+ * Restore a program serialized by serialize_glsl_program().
+ *
+ * With \p in_place, the uniform, block and resource names are referenced
+ * from the blob instead of being copied, so its buffer must stay alive as
+ * long as \c prog->data.
+ */
 bool
 deserialize_glsl_program(struct blob_reader *blob, struct gl_context *ctx,
-                         struct gl_shader_program *prog);
+                         struct gl_shader_program *prog, bool in_place);
 
 #ifdef __cplusplus
 } /* extern "C" */
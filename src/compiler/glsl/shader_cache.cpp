@@ -71,11 +71,32 @@ extern "C" {
 
 static void
 compile_shaders(struct gl_context *ctx, struct gl_shader_program *prog) {
+   /* The IR of fixed function programs is generated before linking, there
+    * is nothing to recompile.
+    */
+   if (prog->IsFixedFunction)
+      return;
+
    for (unsigned i = 0; i < prog->NumShaders; i++) {
       _mesa_glsl_compile_shader(ctx, prog->Shaders[i], false, false, true);
    }
 }
 
+static void
+free_cache_item(void *ptr)
+{
+   free(*(void **) ptr);
+}
+
+/* Free a cache item together with the program data. */
+static void
+keep_cache_item(struct gl_shader_program_data *data, void *buffer)
+{
+   void **item = ralloc(data, void *);
+   *item = buffer;
+   ralloc_set_destructor(item, free_cache_item);
+}
+
 static void
 create_binding_str(const char *key, unsigned value, void *closure)
 {
@@ -91,11 +112,11 @@ shader_cache_write_program_metadata(struct gl_context *ctx,
    if (!cache)
       return;
 
-   /* Exit early when we are dealing with a ff shader with no source file to
-    * generate a source from, or with a SPIR-V shader.
+   /* Exit early when we are dealing with a SPIR-V shader, or with a program
+    * for which no key was computed.
     *
-    * TODO: In future we should use another method to generate a key for ff
-    * programs, and SPIR-V shaders.
+    * TODO: In future we should use another method to generate a key for
+    * SPIR-V shaders.
     */
    static const char zero[sizeof(prog->data->sha1)] = {0};
    if (memcmp(prog->data->sha1, zero, sizeof(prog->data->sha1)) == 0)
@@ -146,10 +167,11 @@ bool
 shader_cache_read_program_metadata(struct gl_context *ctx,
                                    struct gl_shader_program *prog)
 {
-   /* Fixed function programs generated by Mesa, or SPIR-V shaders, are not
-    * cached. So don't try to read metadata for them from the cache.
+   /* Programs generated by Mesa, other than the fixed function ones which
+    * are keyed by their state, or SPIR-V shaders, are not cached. So don't
+    * try to read metadata for them from the cache.
     */
-   if (prog->Name == 0 || prog->data->spirv)
+   if ((prog->Name == 0 && !prog->IsFixedFunction) || prog->data->spirv)
       return false;
 
    struct disk_cache *cache = ctx->Cache;
@@ -235,10 +257,15 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
               sha1buf);
    }
 
+   /* Rather than copying the names out of the cache item, reference them
+    * in place and keep the item around as long as the program data.
+    */
+   keep_cache_item(prog->data, buffer);
+
    struct blob_reader metadata;
    blob_reader_init(&metadata, buffer, size);
 
-   bool deserialized = deserialize_glsl_program(&metadata, ctx, prog);
+   bool deserialized = deserialize_glsl_program(&metadata, ctx, prog, true);
 
    if (!deserialized || metadata.current != metadata.end || metadata.overrun) {
       /* Something has gone wrong discard the item from the cache and rebuild
@@ -253,14 +280,11 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
 
       disk_cache_remove(cache, prog->data->sha1);
       compile_shaders(ctx, prog);
-      free(buffer);
       return false;
    }
 
    /* This is used to flag a shader retrieved from cache */
    prog->data->LinkStatus = LINKING_SKIPPED;
 
-   free (buffer);
-
    return true;
 }
@@ -43,8 +43,18 @@
 #include "ir_builder_print_visitor.h"
 #include "builtin_functions.h"
 #include "opt_add_neg_to_sub.h"
+#include "glsl_to_nir.h"
 #include "main/mtypes.h"
 #include "program/program.h"
+#include "util/os_time.h"
+#include "util/u_atomic.h"
+#include "util/u_dynarray.h"
+#include "util/u_thread.h"
+
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <dirent.h>
+#endif
 
 class dead_variable_visitor : public ir_hierarchical_visitor {
 public:
@@ -119,7 +129,7 @@ new_program(UNUSED struct gl_context *ctx, gl_shader_stage stage,
 static const struct standalone_options *options;
 
 static void
-initialize_context(struct gl_context *ctx, gl_api api)
+initialize_context(struct gl_context *ctx, gl_api api, int glsl_version)
 {
    initialize_context_to_defaults(ctx, api);
    _mesa_glsl_builtin_functions_init_or_ref();
@@ -127,7 +137,7 @@ initialize_context(struct gl_context *ctx, gl_api api)
    /* The standalone compiler needs to claim support for almost
     * everything in order to compile the built-in functions.
     */
-   ctx->Const.GLSLVersion = options->glsl_version;
+   ctx->Const.GLSLVersion = glsl_version;
    ctx->Extensions.ARB_ES3_compatibility = true;
    ctx->Extensions.ARB_ES3_1_compatibility = true;
    ctx->Extensions.ARB_ES3_2_compatibility = true;
@@ -398,16 +408,12 @@ compile_shader(struct gl_context *ctx, struct gl_shader *shader)
    return;
 }
 
-extern "C" struct gl_shader_program *
-standalone_compile_shader(const struct standalone_options *_options,
-      unsigned num_files, char* const* files, struct gl_context *ctx)
+static bool
+setup_context(struct gl_context *ctx, int glsl_version)
 {
-   int status = EXIT_SUCCESS;
    bool glsl_es = false;
 
-   options = _options;
-
-   switch (options->glsl_version) {
+   switch (glsl_version) {
    case 100:
    case 300:
    case 310:
@@ -430,14 +436,15 @@ standalone_compile_shader(const struct standalone_options *_options,
       glsl_es = false;
       break;
    default:
-      fprintf(stderr, "Unrecognized GLSL version `%d'\n", options->glsl_version);
-      return NULL;
+      fprintf(stderr, "Unrecognized GLSL version `%d'\n", glsl_version);
+      return false;
    }
 
    if (glsl_es) {
-      initialize_context(ctx, API_OPENGLES2);
+      initialize_context(ctx, API_OPENGLES2, glsl_version);
    } else {
-      initialize_context(ctx, options->glsl_version > 130 ? API_OPENGL_CORE : API_OPENGL_COMPAT);
+      initialize_context(ctx, glsl_version > 130 ? API_OPENGL_CORE : API_OPENGL_COMPAT,
+                         glsl_version);
    }
 
    if (options->lower_precision) {
@@ -452,6 +459,12 @@ standalone_compile_shader(const struct standalone_options *_options,
       }
    }
 
+   return true;
+}
+
+static struct gl_shader_program *
+create_program(void)
+{
    struct gl_shader_program *whole_program;
 
    whole_program = rzalloc (NULL, struct gl_shader_program);
@@ -465,6 +478,38 @@ standalone_compile_shader(const struct standalone_options *_options,
    whole_program->FragDataBindings = new string_to_uint_map;
    whole_program->FragDataIndexBindings = new string_to_uint_map;
 
+   return whole_program;
+}
+
+static void
+destroy_program(struct gl_shader_program *whole_program)
+{
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (whole_program->_LinkedShaders[i])
+         _mesa_delete_linked_shader(NULL, whole_program->_LinkedShaders[i]);
+   }
+
+   delete whole_program->AttributeBindings;
+   delete whole_program->FragDataBindings;
+   delete whole_program->FragDataIndexBindings;
+   delete whole_program->UniformHash;
+
+   ralloc_free(whole_program);
+}
+
+extern "C" struct gl_shader_program *
+standalone_compile_shader(const struct standalone_options *_options,
+      unsigned num_files, char* const* files, struct gl_context *ctx)
+{
+   int status = EXIT_SUCCESS;
+
+   options = _options;
+
+   if (!setup_context(ctx, options->glsl_version))
+      return NULL;
+
+   struct gl_shader_program *whole_program = create_program();
+
    for (unsigned i = 0; i < num_files; i++) {
       whole_program->Shaders =
             reralloc(whole_program, whole_program->Shaders,
@@ -616,16 +661,370 @@ fail:
 extern "C" void
 standalone_compiler_cleanup(struct gl_shader_program *whole_program)
 {
+   destroy_program(whole_program);
+   _mesa_glsl_builtin_functions_decref();
+}
+
+/* Batch mode
+ *
+ * Compiles and links a whole corpus of shader_test files (as found in
+ * shader-db) in a single process, reporting the time spent in each phase of
+ * the compiler.
+ */
+
+struct batch_timings {
+   struct glsl_compile_timings compile;
+   int64_t link;
+   int64_t glsl_to_nir;
+};
+
+struct batch_state {
+   struct util_dynarray files;
+   unsigned next_file;
+};
+
+struct batch_thread {
+   struct batch_state *state;
+   thrd_t thread;
+
+   struct gl_context *ctx;
+   int ctx_glsl_version;
+
+   struct batch_timings timings;
+   unsigned num_programs;
+   unsigned num_shaders;
+   unsigned num_failed;
+};
+
+static const struct {
+   const char *name;
+   GLenum type;
+} shader_test_sections[] = {
+   { "[vertex shader]", GL_VERTEX_SHADER },
+   { "[tessellation control shader]", GL_TESS_CONTROL_SHADER },
+   { "[tessellation evaluation shader]", GL_TESS_EVALUATION_SHADER },
+   { "[geometry shader]", GL_GEOMETRY_SHADER },
+   { "[fragment shader]", GL_FRAGMENT_SHADER },
+   { "[compute shader]", GL_COMPUTE_SHADER },
+};
+
+static void
+add_shader(struct gl_shader_program *whole_program, GLenum type,
+           const char *source)
+{
+   whole_program->Shaders =
+      reralloc(whole_program, whole_program->Shaders,
+               struct gl_shader *, whole_program->NumShaders + 1);
+
+   struct gl_shader *shader = rzalloc(whole_program, gl_shader);
+   shader->Type = type;
+   shader->Stage = _mesa_shader_enum_to_shader_stage(type);
+   shader->Source = source;
+
+   whole_program->Shaders[whole_program->NumShaders++] = shader;
+}
+
+/**
+ * Splits the sections of a shader_test file into the shaders of
+ * \p whole_program.  The shader sources point into \p text, which is
+ * modified to terminate them.
+ */
+static bool
+parse_shader_test(struct gl_shader_program *whole_program, char *text,
+                  int *glsl_version)
+{
+   bool in_require = false;
+   char *line = text;
+
+   *glsl_version = 110;
+
+   while (*line != '\0') {
+      char *next = strchr(line, '\n');
+      next = next ? next + 1 : line + strlen(line);
+
+      if (line[0] == '[') {
+         GLenum type = GL_NONE;
+         for (unsigned i = 0; i < ARRAY_SIZE(shader_test_sections); i++) {
+            const char *name = shader_test_sections[i].name;
+            if (strncmp(line, name, strlen(name)) == 0) {
+               type = shader_test_sections[i].type;
+               break;
+            }
+         }
+
+         in_require = strncmp(line, "[require]", 9) == 0;
+
+         /* Terminates the source of the previous section. */
+         line[0] = '\0';
+
+         if (type != GL_NONE)
+            add_shader(whole_program, type, next);
+      } else if (in_require) {
+         int major, minor;
+         if (sscanf(line, "GLSL ES >= %d.%d", &major, &minor) == 2 ||
+             sscanf(line, "GLSL >= %d.%d", &major, &minor) == 2)
+            *glsl_version = major * 100 + minor;
+         else if (strncmp(line, "SSO ENABLED", 11) == 0)
+            whole_program->SeparateShader = true;
+      }
+
+      line = next;
+   }
+
+   return whole_program->NumShaders > 0;
+}
+
+static void
+print_batch_log(const char *file_name, const char *what, const char *log)
+{
+   fprintf(stderr, "%s: %s failed\n", file_name, what);
+   if (log && log[0] != '\0')
+      fprintf(stderr, "%s\n", log);
+}
+
+static bool
+compile_batch_program(struct batch_thread *thread, const char *file_name)
+{
+   static const nir_shader_compiler_options nir_options = {};
+   struct gl_context *ctx = thread->ctx;
+   struct gl_shader_program *whole_program = create_program();
+   bool success = false;
+   int glsl_version;
+
+   char *text = load_text_file(whole_program, file_name);
+   if (text == NULL) {
+      fprintf(stderr, "File \"%s\" does not exist.\n", file_name);
+      goto done;
+   }
+
+   if (!parse_shader_test(whole_program, text, &glsl_version)) {
+      fprintf(stderr, "%s: no shaders found\n", file_name);
+      goto done;
+   }
+
+   if (glsl_version != thread->ctx_glsl_version) {
+      if (thread->ctx_glsl_version != 0)
+         _mesa_glsl_builtin_functions_decref();
+      thread->ctx_glsl_version = 0;
+
+      if (!setup_context(ctx, glsl_version))
+         goto done;
+      thread->ctx_glsl_version = glsl_version;
+   }
+
+   for (unsigned i = 0; i < whole_program->NumShaders; i++) {
+      struct gl_shader *shader = whole_program->Shaders[i];
+
+      _mesa_glsl_compile_shader_timed(ctx, shader, false, false, true,
+                                      &thread->timings.compile);
+      thread->num_shaders++;
+
+      if (!shader->CompileStatus) {
+         print_batch_log(file_name, "compilation", shader->InfoLog);
+         goto done;
+      }
+   }
+
+   _mesa_clear_shader_program_data(ctx, whole_program);
+
+   {
+      int64_t start = os_time_get_nano();
+      link_shaders(ctx, whole_program);
+      thread->timings.link += os_time_get_nano() - start;
+   }
+
+   if (!whole_program->data->LinkStatus) {
+      print_batch_log(file_name, "linking", whole_program->data->InfoLog);
+      goto done;
+   }
+
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
-      if (whole_program->_LinkedShaders[i])
-         _mesa_delete_linked_shader(NULL, whole_program->_LinkedShaders[i]);
+      if (!whole_program->_LinkedShaders[i])
+         continue;
+
+      int64_t start = os_time_get_nano();
+      nir_shader *nir = glsl_to_nir(ctx, whole_program, (gl_shader_stage) i,
+                                    &nir_options);
+      thread->timings.glsl_to_nir += os_time_get_nano() - start;
+
+      ralloc_free(nir);
    }
 
-   delete whole_program->AttributeBindings;
-   delete whole_program->FragDataBindings;
-   delete whole_program->FragDataIndexBindings;
-   delete whole_program->UniformHash;
+   success = true;
+
+done:
+   destroy_program(whole_program);
+   return success;
+}
+
+static int
+batch_thread_func(void *data)
+{
+   struct batch_thread *thread = (struct batch_thread *) data;
+   struct batch_state *state = thread->state;
+   const unsigned num_files =
+      util_dynarray_num_elements(&state->files, char *);
+
+   thread->ctx = (struct gl_context *) calloc(1, sizeof(*thread->ctx));
+
+   while (true) {
+      unsigned idx = p_atomic_inc_return(&state->next_file) - 1;
+      if (idx >= num_files)
+         break;
+
+      const char *file_name =
+         *util_dynarray_element(&state->files, char *, idx);
+
+      thread->num_programs++;
+      if (!compile_batch_program(thread, file_name))
+         thread->num_failed++;
+   }
+
+   if (thread->ctx_glsl_version != 0)
+      _mesa_glsl_builtin_functions_decref();
+   free(thread->ctx);
+
+   return 0;
+}
+
+static bool
+has_suffix(const char *str, const char *suffix)
+{
+   const size_t len = strlen(str), suffix_len = strlen(suffix);
+   return len >= suffix_len && strcmp(str + len - suffix_len, suffix) == 0;
+}
+
+/* Adds the shader_test files found under path, recursing into
+ * directories.
+ */
+static void
+add_batch_files(struct batch_state *state, const char *path)
+{
+   struct stat st;
+
+   if (stat(path, &st) != 0) {
+      fprintf(stderr, "File \"%s\" does not exist.\n", path);
+      return;
+   }
+
+#ifndef _WIN32
+   if (S_ISDIR(st.st_mode)) {
+      DIR *dir = opendir(path);
+      if (!dir)
+         return;
+
+      struct dirent *entry;
+      while ((entry = readdir(dir)) != NULL) {
+         if (entry->d_name[0] == '.')
+            continue;
+
+         char *child = ralloc_asprintf(NULL, "%s/%s", path, entry->d_name);
+         add_batch_files(state, child);
+         ralloc_free(child);
+      }
+
+      closedir(dir);
+      return;
+   }
+#endif
+
+   if (has_suffix(path, ".shader_test")) {
+      char *file_name = ralloc_strdup(state, path);
+      util_dynarray_append(&state->files, char *, file_name);
+   }
+}
+
+static int
+compare_file_names(const void *a, const void *b)
+{
+   return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+static void
+print_phase_time(const char *phase, int64_t ns, int64_t total_ns)
+{
+   printf("  %-14s %10.2f ms  %5.1f%%\n", phase, ns / 1000000.0,
+          total_ns ? 100.0 * ns / total_ns : 0.0);
+}
+
+extern "C" int
+standalone_compile_batch(const struct standalone_options *_options,
+                         unsigned num_paths, char* const* paths,
+                         unsigned num_threads)
+{
+   options = _options;
+
+   struct batch_state *state = rzalloc(NULL, struct batch_state);
+   util_dynarray_init(&state->files, state);
+
+   for (unsigned i = 0; i < num_paths; i++)
+      add_batch_files(state, paths[i]);
+
+   /* Directory order isn't stable, sort so runs are comparable. */
+   const unsigned num_files =
+      util_dynarray_num_elements(&state->files, char *);
+   qsort(state->files.data, num_files, sizeof(char *), compare_file_names);
+
+   num_threads = CLAMP(num_threads, 1, MAX2(num_files, 1));
+   struct batch_thread *threads =
+      rzalloc_array(state, struct batch_thread, num_threads);
+
+   /* Keep the builtins alive for the whole run, instead of letting them go
+    * away whenever a thread switches to another GLSL version.
+    */
+   _mesa_glsl_builtin_functions_init_or_ref();
+
+   int64_t start = os_time_get_nano();
+
+   for (unsigned i = 0; i < num_threads; i++) {
+      threads[i].state = state;
+      if (num_threads > 1)
+         threads[i].thread = u_thread_create(batch_thread_func, &threads[i]);
+      else
+         batch_thread_func(&threads[i]);
+   }
+
+   struct batch_timings timings = {};
+   unsigned num_programs = 0, num_shaders = 0, num_failed = 0;
+
+   for (unsigned i = 0; i < num_threads; i++) {
+      if (num_threads > 1)
+         thrd_join(threads[i].thread, NULL);
+
+      timings.compile.preprocess += threads[i].timings.compile.preprocess;
+      timings.compile.parse += threads[i].timings.compile.parse;
+      timings.compile.ast_to_hir += threads[i].timings.compile.ast_to_hir;
+      timings.compile.optimize += threads[i].timings.compile.optimize;
+      timings.link += threads[i].timings.link;
+      timings.glsl_to_nir += threads[i].timings.glsl_to_nir;
+      num_programs += threads[i].num_programs;
+      num_shaders += threads[i].num_shaders;
+      num_failed += threads[i].num_failed;
+   }
+
+   int64_t wall_ns = os_time_get_nano() - start;
 
-   ralloc_free(whole_program);
    _mesa_glsl_builtin_functions_decref();
+
+   const int64_t total_ns =
+      timings.compile.preprocess + timings.compile.parse +
+      timings.compile.ast_to_hir + timings.compile.optimize +
+      timings.link + timings.glsl_to_nir;
+
+   printf("%u programs (%u shaders, %u failed) in %.2f ms using %u thread%s, "
+          "%.1f programs/s\n",
+          num_programs, num_shaders, num_failed, wall_ns / 1000000.0,
+          num_threads, num_threads > 1 ? "s" : "",
+          wall_ns ? num_programs * 1000000000.0 / wall_ns : 0.0);
+   print_phase_time("glcpp", timings.compile.preprocess, total_ns);
+   print_phase_time("parse", timings.compile.parse, total_ns);
+   print_phase_time("ast_to_hir", timings.compile.ast_to_hir, total_ns);
+   print_phase_time("optimization", timings.compile.optimize, total_ns);
+   print_phase_time("linking", timings.link, total_ns);
+   print_phase_time("glsl_to_nir", timings.glsl_to_nir, total_ns);
+   print_phase_time("total", total_ns, total_ns);
+
+   ralloc_free(state);
+
+   return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
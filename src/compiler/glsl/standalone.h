@@ -48,6 +48,15 @@ struct gl_shader_program * standalone_compile_shader(
 
 void standalone_compiler_cleanup(struct gl_shader_program *prog);
 
+/**
+ * Compiles and links every shader_test file found in \p paths (recursing
+ * into directories) using \p num_threads threads, then prints the time
+ * spent in each compiler phase.
+ */
+int standalone_compile_batch(const struct standalone_options *options,
+                             unsigned num_paths, char* const* paths,
+                             unsigned num_threads);
+
 #ifdef __cplusplus
 }
 #endif
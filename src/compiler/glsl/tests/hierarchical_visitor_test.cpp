@@ -0,0 +1,180 @@
+/*
+ * Copyright © 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+#include "ir.h"
+#include "ir_hierarchical_visitor.h"
+
+namespace {
+
+class counting_visitor : public ir_hierarchical_visitor {
+public:
+   counting_visitor()
+      : enters(0), leaves(0), constants(0), max_depth(0), depth(0),
+        stop_at(NULL), skip(NULL)
+   {
+   }
+
+   virtual ir_visitor_status visit(ir_constant *)
+   {
+      constants++;
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit(ir_variable *)
+   {
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *)
+   {
+      EXPECT_TRUE(in_assignee);
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_expression *ir)
+   {
+      enters++;
+      if (ir == stop_at)
+         return visit_stop;
+      if (ir == skip)
+         return visit_continue_with_parent;
+
+      depth++;
+      max_depth = MAX2(max_depth, depth);
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_leave(ir_expression *)
+   {
+      leaves++;
+      depth--;
+      return visit_continue;
+   }
+
+   unsigned enters, leaves, constants, max_depth, depth;
+   ir_expression *stop_at;
+   ir_expression *skip;
+};
+
+class hierarchical_visitor : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   /* Builds -(-(...-(1.0)...)) and returns the outermost expression. */
+   ir_expression *neg_chain(unsigned length);
+
+   void *mem_ctx;
+};
+
+void
+hierarchical_visitor::SetUp()
+{
+   glsl_type_singleton_init_or_ref();
+   mem_ctx = ralloc_context(NULL);
+}
+
+void
+hierarchical_visitor::TearDown()
+{
+   ralloc_free(mem_ctx);
+   mem_ctx = NULL;
+   glsl_type_singleton_decref();
+}
+
+ir_expression *
+hierarchical_visitor::neg_chain(unsigned length)
+{
+   ir_rvalue *val = new(mem_ctx) ir_constant(1.0f);
+   for (unsigned i = 0; i < length; i++)
+      val = new(mem_ctx) ir_expression(ir_unop_neg, val);
+   return val->as_expression();
+}
+
+} /* anonymous namespace */
+
+TEST_F(hierarchical_visitor, deep_expression)
+{
+   /* Deep enough to overflow a small thread stack with recursive accept(). */
+   const unsigned length = 200000;
+   ir_expression *expr = neg_chain(length);
+
+   counting_visitor v;
+   EXPECT_EQ(visit_continue, expr->accept(&v));
+   EXPECT_EQ(length, v.enters);
+   EXPECT_EQ(length, v.leaves);
+   EXPECT_EQ(length, v.max_depth);
+   EXPECT_EQ(1u, v.constants);
+}
+
+TEST_F(hierarchical_visitor, continue_with_parent)
+{
+   ir_expression *inner = neg_chain(2);
+   ir_expression *expr =
+      new(mem_ctx) ir_expression(ir_binop_add, inner,
+                                 new(mem_ctx) ir_constant(2.0f));
+
+   /* Skipping inner's child doesn't skip the sibling of inner. */
+   counting_visitor v;
+   v.skip = inner->operands[0]->as_expression();
+   EXPECT_EQ(visit_continue, expr->accept(&v));
+   EXPECT_EQ(3u, v.enters);
+   EXPECT_EQ(2u, v.leaves);
+   EXPECT_EQ(1u, v.constants);
+}
+
+TEST_F(hierarchical_visitor, stop)
+{
+   ir_expression *inner = neg_chain(3);
+   ir_expression *expr =
+      new(mem_ctx) ir_expression(ir_binop_add, inner,
+                                 new(mem_ctx) ir_constant(2.0f));
+
+   counting_visitor v;
+   v.stop_at = inner->operands[0]->as_expression();
+   EXPECT_EQ(visit_stop, expr->accept(&v));
+   EXPECT_EQ(3u, v.enters);
+   EXPECT_EQ(0u, v.leaves);
+   EXPECT_EQ(0u, v.constants);
+}
+
+TEST_F(hierarchical_visitor, statement_list)
+{
+   ir_variable *var = new(mem_ctx) ir_variable(glsl_type::float_type, "x",
+                                               ir_var_temporary);
+   ir_assignment *assign =
+      new(mem_ctx) ir_assignment(new(mem_ctx) ir_dereference_variable(var),
+                                 neg_chain(4));
+
+   exec_list instructions;
+   instructions.push_tail(var);
+   instructions.push_tail(assign);
+
+   counting_visitor v;
+   EXPECT_EQ(visit_continue, visit_list_elements(&v, &instructions));
+   EXPECT_EQ(4u, v.enters);
+   EXPECT_EQ(4u, v.leaves);
+   EXPECT_EQ(1u, v.constants);
+   EXPECT_FALSE(v.in_assignee);
+   EXPECT_EQ(NULL, v.base_ir);
+}
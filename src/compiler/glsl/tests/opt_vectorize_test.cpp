@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+#include "ir.h"
+#include "ir_builder.h"
+#include "ir_optimization.h"
+
+using namespace ir_builder;
+
+class opt_vectorize : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   ir_variable *temp(const glsl_type *type, const char *name);
+   unsigned count_assignments();
+
+   exec_list instructions;
+   ir_factory *body;
+   void *mem_ctx;
+   ir_variable *v;
+};
+
+void
+opt_vectorize::SetUp()
+{
+   glsl_type_singleton_init_or_ref();
+
+   mem_ctx = ralloc_context(NULL);
+
+   instructions.make_empty();
+   body = new ir_factory(&instructions, mem_ctx);
+
+   v = temp(glsl_type::vec4_type, "v");
+}
+
+void
+opt_vectorize::TearDown()
+{
+   delete body;
+   body = NULL;
+
+   ralloc_free(mem_ctx);
+   mem_ctx = NULL;
+
+   glsl_type_singleton_decref();
+}
+
+ir_variable *
+opt_vectorize::temp(const glsl_type *type, const char *name)
+{
+   ir_variable *var = new(mem_ctx) ir_variable(type, name, ir_var_temporary);
+   body->emit(var);
+   return var;
+}
+
+unsigned
+opt_vectorize::count_assignments()
+{
+   unsigned count = 0;
+   foreach_in_list(ir_instruction, ir, &instructions) {
+      if (ir->as_assignment())
+         count++;
+   }
+   return count;
+}
+
+TEST_F(opt_vectorize, isomorphic_different_temporaries)
+{
+   ir_variable *t0 = temp(glsl_type::float_type, "t0");
+   ir_variable *t1 = temp(glsl_type::float_type, "t1");
+
+   body->emit(assign(t0, mul(swizzle_x(v), body->constant(2.0f))));
+   body->emit(assign(t1, mul(swizzle_z(v), body->constant(3.0f))));
+
+   EXPECT_TRUE(do_vectorize(&instructions));
+
+   /* One vec2 multiply and two copies out of it. */
+   ASSERT_EQ(3u, count_assignments());
+
+   ir_assignment *packed = NULL;
+   foreach_in_list(ir_instruction, ir, &instructions) {
+      if (ir->as_assignment()) {
+         packed = ir->as_assignment();
+         break;
+      }
+   }
+
+   ir_expression *expr = packed->rhs->as_expression();
+   ASSERT_NE(expr, nullptr);
+   EXPECT_EQ(ir_binop_mul, expr->operation);
+   EXPECT_EQ(glsl_type::vec2_type, expr->type);
+
+   ir_swizzle *swz = expr->operands[0]->as_swizzle();
+   ASSERT_NE(swz, nullptr);
+   EXPECT_EQ(0u, swz->mask.x);
+   EXPECT_EQ(2u, swz->mask.y);
+
+   ir_constant *c = expr->operands[1]->as_constant();
+   ASSERT_NE(c, nullptr);
+   EXPECT_EQ(2.0f, c->value.f[0]);
+   EXPECT_EQ(3.0f, c->value.f[1]);
+}
+
+TEST_F(opt_vectorize, dependent_not_packed)
+{
+   ir_variable *t0 = temp(glsl_type::float_type, "t0");
+   ir_variable *t1 = temp(glsl_type::float_type, "t1");
+
+   body->emit(assign(t0, add(swizzle_x(v), t0)));
+   body->emit(assign(t1, add(swizzle_y(v), t0)));
+
+   EXPECT_FALSE(do_vectorize(&instructions));
+   EXPECT_EQ(2u, count_assignments());
+}
+
+TEST_F(opt_vectorize, different_shapes_not_packed)
+{
+   ir_variable *t0 = temp(glsl_type::float_type, "t0");
+   ir_variable *t1 = temp(glsl_type::float_type, "t1");
+
+   body->emit(assign(t0, mul(swizzle_x(v), swizzle_y(v))));
+   body->emit(assign(t1, add(swizzle_y(v), swizzle_z(v))));
+
+   EXPECT_FALSE(do_vectorize(&instructions));
+   EXPECT_EQ(2u, count_assignments());
+}
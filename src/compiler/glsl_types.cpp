@@ -26,17 +26,49 @@
 #include "compiler/glsl/glsl_parser_extras.h"
 #include "glsl_types.h"
 #include "util/hash_table.h"
+#include "util/u_dynarray.h"
 #include "util/u_cpu_detect.h"
 #include "util/u_string.h"
 
 
 mtx_t glsl_type::hash_mutex = _MTX_INITIALIZER_NP;
-hash_table *glsl_type::explicit_matrix_types = NULL;
-hash_table *glsl_type::array_types = NULL;
-hash_table *glsl_type::struct_types = NULL;
-hash_table *glsl_type::interface_types = NULL;
-hash_table *glsl_type::function_types = NULL;
-hash_table *glsl_type::subroutine_types = NULL;
+
+/**
+ * Each of the type tables is split into 2^TYPE_TABLE_SHARD_BITS
+ * independently locked shards.
+ */
+#define TYPE_TABLE_SHARD_BITS 4
+#define TYPE_TABLE_SHARDS (1 << TYPE_TABLE_SHARD_BITS)
+
+/**
+ * One shard of a type table.  A lookup hashes its key once, picks the shard
+ * from the hash and only takes that shard's lock, so threads compiling
+ * unrelated shaders rarely have to wait for each other.
+ */
+struct type_table_shard {
+   mtx_t mutex;
+   struct hash_table *table;
+};
+
+/** Known explicit matrix and vector types. */
+static type_table_shard explicit_matrix_types[TYPE_TABLE_SHARDS];
+
+/** Known array types. */
+static type_table_shard array_types[TYPE_TABLE_SHARDS];
+
+/** Known struct types. */
+static type_table_shard struct_types[TYPE_TABLE_SHARDS];
+
+/** Known interface types. */
+static type_table_shard interface_types[TYPE_TABLE_SHARDS];
+
+/** Known function types. */
+static type_table_shard function_types[TYPE_TABLE_SHARDS];
+
+/** Known subroutine types. */
+static type_table_shard subroutine_types[TYPE_TABLE_SHARDS];
+
+static once_flag type_table_once_flag = ONCE_FLAG_INIT;
 
 /* There might be multiple users for types (e.g. application using OpenGL
  * and Vulkan simultaneously or app using multiple Vulkan instances). Counter
@@ -516,6 +548,65 @@ hash_free_type_function(struct hash_entry *entry)
    delete type;
 }
 
+static void
+init_type_table_mutexes(void)
+{
+   type_table_shard *tables[] = {
+      explicit_matrix_types,
+      array_types,
+      struct_types,
+      interface_types,
+      function_types,
+      subroutine_types,
+   };
+
+   for (unsigned i = 0; i < ARRAY_SIZE(tables); i++) {
+      for (unsigned j = 0; j < TYPE_TABLE_SHARDS; j++)
+         mtx_init(&tables[i][j].mutex, mtx_plain);
+   }
+}
+
+static void
+destroy_type_table(type_table_shard *shards)
+{
+   for (unsigned i = 0; i < TYPE_TABLE_SHARDS; i++) {
+      mtx_lock(&shards[i].mutex);
+      if (shards[i].table != NULL) {
+         _mesa_hash_table_destroy(shards[i].table, hash_free_type_function);
+         shards[i].table = NULL;
+      }
+      mtx_unlock(&shards[i].mutex);
+   }
+}
+
+/**
+ * Find the shard of a type table holding keys with the given hash, lock it
+ * and make sure its hash table exists.  The caller must unlock the shard's
+ * mutex once it is done with the table.
+ */
+static type_table_shard *
+lock_type_table_shard(type_table_shard *shards, uint32_t hash,
+                      uint32_t (*key_hash_function)(const void *key),
+                      bool (*key_equals_function)(const void *a,
+                                                  const void *b))
+{
+   /* Some of the key hashes are weak in their low bits, so mix the hash
+    * and pick the shard from its top bits.
+    */
+   type_table_shard *shard =
+      &shards[(hash * 0x9e3779b1u) >> (32 - TYPE_TABLE_SHARD_BITS)];
+
+   mtx_lock(&shard->mutex);
+   assert(glsl_type_users > 0);
+
+   if (shard->table == NULL) {
+      shard->table = _mesa_hash_table_create(NULL, key_hash_function,
+                                             key_equals_function);
+   }
+
+   return shard;
+}
+
 void
 glsl_type_singleton_init_or_ref()
 {
@@ -524,6 +615,8 @@ glsl_type_singleton_init_or_ref()
     */
    util_cpu_detect();
 
+   call_once(&type_table_once_flag, init_type_table_mutexes);
+
    mtx_lock(&glsl_type::hash_mutex);
    glsl_type_users++;
    mtx_unlock(&glsl_type::hash_mutex);
@@ -541,36 +634,12 @@ glsl_type_singleton_decref()
       return;
    }
 
-   if (glsl_type::explicit_matrix_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::explicit_matrix_types,
-                               hash_free_type_function);
-      glsl_type::explicit_matrix_types = NULL;
-   }
-
-   if (glsl_type::array_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::array_types, hash_free_type_function);
-      glsl_type::array_types = NULL;
-   }
-
-   if (glsl_type::struct_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::struct_types, hash_free_type_function);
-      glsl_type::struct_types = NULL;
-   }
-
-   if (glsl_type::interface_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::interface_types, hash_free_type_function);
-      glsl_type::interface_types = NULL;
-   }
-
-   if (glsl_type::function_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::function_types, hash_free_type_function);
-      glsl_type::function_types = NULL;
-   }
-
-   if (glsl_type::subroutine_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::subroutine_types, hash_free_type_function);
-      glsl_type::subroutine_types = NULL;
-   }
+   destroy_type_table(explicit_matrix_types);
+   destroy_type_table(array_types);
+   destroy_type_table(struct_types);
+   destroy_type_table(interface_types);
+   destroy_type_table(function_types);
+   destroy_type_table(subroutine_types);
 
    mtx_unlock(&glsl_type::hash_mutex);
 }
@@ -691,17 +760,13 @@ glsl_type::get_instance(unsigned base_type, unsigned rows, unsigned columns,
       snprintf(name, sizeof(name), "%sx%ua%uB%s", bare_type->name,
                explicit_stride, explicit_alignment, row_major ? "RM" : "");
 
-      mtx_lock(&glsl_type::hash_mutex);
-      assert(glsl_type_users > 0);
-
-      if (explicit_matrix_types == NULL) {
-         explicit_matrix_types =
-            _mesa_hash_table_create(NULL, _mesa_hash_string,
-                                    _mesa_key_string_equal);
-      }
+      const uint32_t hash = _mesa_hash_string(name);
+      type_table_shard *shard =
+         lock_type_table_shard(explicit_matrix_types, hash,
+                               _mesa_hash_string, _mesa_key_string_equal);
 
       const struct hash_entry *entry =
-         _mesa_hash_table_search(explicit_matrix_types, name);
+         _mesa_hash_table_search_pre_hashed(shard->table, hash, name);
       if (entry == NULL) {
          const glsl_type *t = new glsl_type(bare_type->gl_type,
                                             (glsl_base_type)base_type,
@@ -709,8 +774,8 @@ glsl_type::get_instance(unsigned base_type, unsigned rows, unsigned columns,
                                             explicit_stride, row_major,
                                             explicit_alignment);
 
-         entry = _mesa_hash_table_insert(explicit_matrix_types,
-                                         t->name, (void *)t);
+         entry = _mesa_hash_table_insert_pre_hashed(shard->table, hash,
+                                                    t->name, (void *)t);
       }
 
       assert(((glsl_type *) entry->data)->base_type == base_type);
@@ -721,7 +786,7 @@ glsl_type::get_instance(unsigned base_type, unsigned rows, unsigned columns,
 
       const glsl_type *t = (const glsl_type *) entry->data;
 
-      mtx_unlock(&glsl_type::hash_mutex);
+      mtx_unlock(&shard->mutex);
 
       return t;
    }
@@ -1130,21 +1195,19 @@ glsl_type::get_array_instance(const glsl_type *base,
    snprintf(key, sizeof(key), "%p[%u]x%uB", (void *) base, array_size,
             explicit_stride);
 
-   mtx_lock(&glsl_type::hash_mutex);
-   assert(glsl_type_users > 0);
+   const uint32_t hash = _mesa_hash_string(key);
+   type_table_shard *shard =
+      lock_type_table_shard(array_types, hash,
+                            _mesa_hash_string, _mesa_key_string_equal);
 
-   if (array_types == NULL) {
-      array_types = _mesa_hash_table_create(NULL, _mesa_hash_string,
-                                            _mesa_key_string_equal);
-   }
-
-   const struct hash_entry *entry = _mesa_hash_table_search(array_types, key);
+   const struct hash_entry *entry =
+      _mesa_hash_table_search_pre_hashed(shard->table, hash, key);
    if (entry == NULL) {
       const glsl_type *t = new glsl_type(base, array_size, explicit_stride);
 
-      entry = _mesa_hash_table_insert(array_types,
-                                      strdup(key),
-                                      (void *) t);
+      entry = _mesa_hash_table_insert_pre_hashed(shard->table, hash,
+                                                 strdup(key),
+                                                 (void *) t);
    }
 
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_ARRAY);
@@ -1153,7 +1216,7 @@ glsl_type::get_array_instance(const glsl_type *base,
 
    glsl_type *t = (glsl_type *) entry->data;
 
-   mtx_unlock(&glsl_type::hash_mutex);
+   mtx_unlock(&shard->mutex);
 
    return t;
 }
@@ -1339,21 +1402,19 @@ glsl_type::get_struct_instance(const glsl_struct_field *fields,
 {
    const glsl_type key(fields, num_fields, name, packed, explicit_alignment);
 
-   mtx_lock(&glsl_type::hash_mutex);
-   assert(glsl_type_users > 0);
-
-   if (struct_types == NULL) {
-      struct_types = _mesa_hash_table_create(NULL, record_key_hash,
-                                             record_key_compare);
-   }
+   const uint32_t hash = record_key_hash(&key);
+   type_table_shard *shard =
+      lock_type_table_shard(struct_types, hash,
+                            record_key_hash, record_key_compare);
 
-   const struct hash_entry *entry = _mesa_hash_table_search(struct_types,
-                                                            &key);
+   const struct hash_entry *entry =
+      _mesa_hash_table_search_pre_hashed(shard->table, hash, &key);
    if (entry == NULL) {
       const glsl_type *t = new glsl_type(fields, num_fields, name, packed,
                                          explicit_alignment);
 
-      entry = _mesa_hash_table_insert(struct_types, t, (void *) t);
+      entry = _mesa_hash_table_insert_pre_hashed(shard->table, hash,
+                                                 t, (void *) t);
    }
 
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_STRUCT);
@@ -1364,7 +1425,7 @@ glsl_type::get_struct_instance(const glsl_struct_field *fields,
 
    glsl_type *t = (glsl_type *) entry->data;
 
-   mtx_unlock(&glsl_type::hash_mutex);
+   mtx_unlock(&shard->mutex);
 
    return t;
 }
@@ -1379,21 +1440,19 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
 {
    const glsl_type key(fields, num_fields, packing, row_major, block_name);
 
-   mtx_lock(&glsl_type::hash_mutex);
-   assert(glsl_type_users > 0);
-
-   if (interface_types == NULL) {
-      interface_types = _mesa_hash_table_create(NULL, record_key_hash,
-                                                record_key_compare);
-   }
+   const uint32_t hash = record_key_hash(&key);
+   type_table_shard *shard =
+      lock_type_table_shard(interface_types, hash,
+                            record_key_hash, record_key_compare);
 
-   const struct hash_entry *entry = _mesa_hash_table_search(interface_types,
-                                                            &key);
+   const struct hash_entry *entry =
+      _mesa_hash_table_search_pre_hashed(shard->table, hash, &key);
    if (entry == NULL) {
       const glsl_type *t = new glsl_type(fields, num_fields,
                                          packing, row_major, block_name);
 
-      entry = _mesa_hash_table_insert(interface_types, t, (void *) t);
+      entry = _mesa_hash_table_insert_pre_hashed(shard->table, hash,
+                                                 t, (void *) t);
    }
 
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_INTERFACE);
@@ -1402,7 +1461,7 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
 
    glsl_type *t = (glsl_type *) entry->data;
 
-   mtx_unlock(&glsl_type::hash_mutex);
+   mtx_unlock(&shard->mutex);
 
    return t;
 }
@@ -1412,20 +1471,18 @@ glsl_type::get_subroutine_instance(const char *subroutine_name)
 {
    const glsl_type key(subroutine_name);
 
-   mtx_lock(&glsl_type::hash_mutex);
-   assert(glsl_type_users > 0);
+   const uint32_t hash = record_key_hash(&key);
+   type_table_shard *shard =
+      lock_type_table_shard(subroutine_types, hash,
+                            record_key_hash, record_key_compare);
 
-   if (subroutine_types == NULL) {
-      subroutine_types = _mesa_hash_table_create(NULL, record_key_hash,
-                                                 record_key_compare);
-   }
-
-   const struct hash_entry *entry = _mesa_hash_table_search(subroutine_types,
-                                                            &key);
+   const struct hash_entry *entry =
+      _mesa_hash_table_search_pre_hashed(shard->table, hash, &key);
    if (entry == NULL) {
       const glsl_type *t = new glsl_type(subroutine_name);
 
-      entry = _mesa_hash_table_insert(subroutine_types, t, (void *) t);
+      entry = _mesa_hash_table_insert_pre_hashed(shard->table, hash,
+                                                 t, (void *) t);
    }
 
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_SUBROUTINE);
@@ -1433,7 +1490,7 @@ glsl_type::get_subroutine_instance(const char *subroutine_name)
 
    glsl_type *t = (glsl_type *) entry->data;
 
-   mtx_unlock(&glsl_type::hash_mutex);
+   mtx_unlock(&shard->mutex);
 
    return t;
 }
@@ -1468,19 +1525,18 @@ glsl_type::get_function_instance(const glsl_type *return_type,
 {
    const glsl_type key(return_type, params, num_params);
 
-   mtx_lock(&glsl_type::hash_mutex);
-   assert(glsl_type_users > 0);
+   const uint32_t hash = function_key_hash(&key);
+   type_table_shard *shard =
+      lock_type_table_shard(function_types, hash,
+                            function_key_hash, function_key_compare);
 
-   if (function_types == NULL) {
-      function_types = _mesa_hash_table_create(NULL, function_key_hash,
-                                               function_key_compare);
-   }
-
-   struct hash_entry *entry = _mesa_hash_table_search(function_types, &key);
+   struct hash_entry *entry =
+      _mesa_hash_table_search_pre_hashed(shard->table, hash, &key);
    if (entry == NULL) {
       const glsl_type *t = new glsl_type(return_type, params, num_params);
 
-      entry = _mesa_hash_table_insert(function_types, t, (void *) t);
+      entry = _mesa_hash_table_insert_pre_hashed(shard->table, hash,
+                                                 t, (void *) t);
    }
 
    const glsl_type *t = (const glsl_type *)entry->data;
@@ -1488,7 +1544,7 @@ glsl_type::get_function_instance(const glsl_type *return_type,
    assert(t->base_type == GLSL_TYPE_FUNCTION);
    assert(t->length == num_params);
 
-   mtx_unlock(&glsl_type::hash_mutex);
+   mtx_unlock(&shard->mutex);
 
    return t;
 }
@@ -2944,9 +3000,16 @@ union packed_type {
 };
 
 static void
-encode_glsl_struct_field(blob *blob, const glsl_struct_field *struct_field)
+encode_type(struct blob *blob, const glsl_type *type, struct hash_table *table);
+
+static const glsl_type *
+decode_type(struct blob_reader *blob, struct util_dynarray *table);
+
+static void
+encode_glsl_struct_field(blob *blob, const glsl_struct_field *struct_field,
+                         struct hash_table *table)
 {
-   encode_type_to_blob(blob, struct_field->type);
+   encode_type(blob, struct_field->type, table);
    blob_write_string(blob, struct_field->name);
    blob_write_uint32(blob, struct_field->location);
    blob_write_uint32(blob, struct_field->offset);
@@ -2957,9 +3020,11 @@ encode_glsl_struct_field(blob *blob, const glsl_struct_field *struct_field)
 }
 
 static void
-decode_glsl_struct_field_from_blob(blob_reader *blob, glsl_struct_field *struct_field)
+decode_glsl_struct_field_from_blob(blob_reader *blob,
+                                   glsl_struct_field *struct_field,
+                                   struct util_dynarray *table)
 {
-   struct_field->type = decode_type_from_blob(blob);
+   struct_field->type = decode_type(blob, table);
    struct_field->name = blob_read_string(blob);
    struct_field->location = blob_read_uint32(blob);
    struct_field->offset = blob_read_uint32(blob);
@@ -2969,14 +3034,28 @@ decode_glsl_struct_field_from_blob(blob_reader *blob, glsl_struct_field *struct_
    struct_field->flags = blob_read_uint32(blob);
 }
 
-void
-encode_type_to_blob(struct blob *blob, const glsl_type *type)
+/**
+ * Whether the type is worth writing out only once per type table.  The other
+ * types are no bigger than a reference and quick to look up.
+ */
+static bool
+type_uses_table(const glsl_type *type)
 {
-   if (!type) {
-      blob_write_uint32(blob, 0);
-      return;
+   switch (type->base_type) {
+   case GLSL_TYPE_ARRAY:
+   case GLSL_TYPE_STRUCT:
+   case GLSL_TYPE_INTERFACE:
+   case GLSL_TYPE_SUBROUTINE:
+      return true;
+   default:
+      return false;
    }
+}
 
+static void
+encode_type_full(struct blob *blob, const glsl_type *type,
+                 struct hash_table *table)
+{
    STATIC_ASSERT(sizeof(union packed_type) == 4);
    union packed_type encoded;
    encoded.u32 = 0;
@@ -3044,7 +3123,7 @@ encode_type_to_blob(struct blob *blob, const glsl_type *type)
          blob_write_uint32(blob, type->length);
       if (encoded.array.explicit_stride == 0x3fff)
          blob_write_uint32(blob, type->explicit_stride);
-      encode_type_to_blob(blob, type->fields.array);
+      encode_type(blob, type->fields.array, table);
       return;
    case GLSL_TYPE_STRUCT:
    case GLSL_TYPE_INTERFACE:
@@ -3067,7 +3146,7 @@ encode_type_to_blob(struct blob *blob, const glsl_type *type)
          blob_write_uint32(blob, type->explicit_alignment);
 
       for (unsigned i = 0; i < type->length; i++)
-         encode_glsl_struct_field(blob, &type->fields.structure[i]);
+         encode_glsl_struct_field(blob, &type->fields.structure[i], table);
       return;
    case GLSL_TYPE_VOID:
       break;
@@ -3081,16 +3160,55 @@ encode_type_to_blob(struct blob *blob, const glsl_type *type)
    blob_write_uint32(blob, encoded.u32);
 }
 
-const glsl_type *
-decode_type_from_blob(struct blob_reader *blob)
+static void
+encode_type(struct blob *blob, const glsl_type *type, struct hash_table *table)
 {
-   union packed_type encoded;
-   encoded.u32 = blob_read_uint32(blob);
+   if (!type) {
+      blob_write_uint32(blob, 0);
+      return;
+   }
 
-   if (encoded.u32 == 0) {
-      return NULL;
+   if (table == NULL || !type_uses_table(type)) {
+      encode_type_full(blob, type, table);
+      return;
+   }
+
+   /* Error types are never encoded, so that base type marks a reference to
+    * a type written before.
+    */
+   struct hash_entry *entry = _mesa_hash_table_search(table, type);
+   if (entry) {
+      union packed_type encoded;
+      encoded.u32 = 0;
+      encoded.basic.base_type = GLSL_TYPE_ERROR;
+      blob_write_uint32(blob, encoded.u32);
+      blob_write_uint32(blob, (uintptr_t) entry->data);
+      return;
    }
 
+   encode_type_full(blob, type, table);
+
+   /* Types are numbered once they are complete, like the decoder does. */
+   _mesa_hash_table_insert(table, type, (void *)(uintptr_t) table->entries);
+}
+
+void
+encode_type_to_blob(struct blob *blob, const glsl_type *type)
+{
+   encode_type(blob, type, NULL);
+}
+
+void
+encode_type_to_blob_table(struct blob *blob, const glsl_type *type,
+                          struct hash_table *table)
+{
+   encode_type(blob, type, table);
+}
+
+static const glsl_type *
+decode_type_full(struct blob_reader *blob, union packed_type encoded,
+                 struct util_dynarray *table)
+{
    glsl_base_type base_type = (glsl_base_type)encoded.basic.base_type;
 
    switch (base_type) {
@@ -3145,7 +3263,7 @@ decode_type_from_blob(struct blob_reader *blob)
       unsigned explicit_stride = encoded.array.explicit_stride;
       if (explicit_stride == 0x3fff)
          explicit_stride = blob_read_uint32(blob);
-      return glsl_type::get_array_instance(decode_type_from_blob(blob),
+      return glsl_type::get_array_instance(decode_type(blob, table),
                                            length, explicit_stride);
    }
    case GLSL_TYPE_STRUCT:
@@ -3163,7 +3281,7 @@ decode_type_from_blob(struct blob_reader *blob)
       glsl_struct_field *fields =
          (glsl_struct_field *) malloc(sizeof(glsl_struct_field) * num_fields);
       for (unsigned i = 0; i < num_fields; i++)
-         decode_glsl_struct_field_from_blob(blob, &fields[i]);
+         decode_glsl_struct_field_from_blob(blob, &fields[i], table);
 
       const glsl_type *t;
       if (base_type == GLSL_TYPE_INTERFACE) {
@@ -3191,6 +3309,46 @@ decode_type_from_blob(struct blob_reader *blob)
    }
 }
 
+static const glsl_type *
+decode_type(struct blob_reader *blob, struct util_dynarray *table)
+{
+   union packed_type encoded;
+   encoded.u32 = blob_read_uint32(blob);
+
+   if (encoded.u32 == 0) {
+      return NULL;
+   }
+
+   if (table && encoded.basic.base_type == GLSL_TYPE_ERROR) {
+      uint32_t index = blob_read_uint32(blob);
+      if (index >= util_dynarray_num_elements(table, const glsl_type *)) {
+         blob->overrun = true;
+         return NULL;
+      }
+      return *util_dynarray_element(table, const glsl_type *, index);
+   }
+
+   const glsl_type *type = decode_type_full(blob, encoded, table);
+
+   if (table && type && type_uses_table(type))
+      util_dynarray_append(table, const glsl_type *, type);
+
+   return type;
+}
+
+const glsl_type *
+decode_type_from_blob(struct blob_reader *blob)
+{
+   return decode_type(blob, NULL);
+}
+
+const glsl_type *
+decode_type_from_blob_table(struct blob_reader *blob,
+                            struct util_dynarray *table)
+{
+   return decode_type(blob, table);
+}
+
 unsigned
 glsl_type::cl_alignment() const
 {
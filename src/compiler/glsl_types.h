@@ -64,6 +64,27 @@ void encode_type_to_blob(struct blob *blob, const struct glsl_type *type);
 
 const struct glsl_type *decode_type_from_blob(struct blob_reader *blob);
 
+struct hash_table;
+struct util_dynarray;
+
+/**
+ * Like encode_type_to_blob(), but arrays, structures, interfaces and
+ * subroutine types already written with the same \c table (a pointer hash
+ * table, initially empty) are only referenced instead of being written out
+ * again.  They have to be read back with decode_type_from_blob_table(), in
+ * the same order.
+ */
+void encode_type_to_blob_table(struct blob *blob, const struct glsl_type *type,
+                               struct hash_table *table);
+
+/**
+ * Reads a type written by encode_type_to_blob_table().  \c table is an
+ * initially empty array of the types decoded so far.
+ */
+const struct glsl_type *
+decode_type_from_blob_table(struct blob_reader *blob,
+                            struct util_dynarray *table);
+
 typedef void (*glsl_type_size_align_func)(const struct glsl_type *type,
                                           unsigned *size, unsigned *align);
 
@@ -1309,24 +1330,6 @@ private:
    /** Constructor for subroutine types */
    glsl_type(const char *name);
 
-   /** Hash table containing the known explicit matrix and vector types. */
-   static struct hash_table *explicit_matrix_types;
-
-   /** Hash table containing the known array types. */
-   static struct hash_table *array_types;
-
-   /** Hash table containing the known struct types. */
-   static struct hash_table *struct_types;
-
-   /** Hash table containing the known interface types. */
-   static struct hash_table *interface_types;
-
-   /** Hash table containing the known subroutine types. */
-   static struct hash_table *subroutine_types;
-
-   /** Hash table containing the known function types. */
-   static struct hash_table *function_types;
-
    static bool record_key_compare(const void *a, const void *b);
    static unsigned record_key_hash(const void *key);
 
@@ -0,0 +1,272 @@
+/*
+ * Copyright © 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Compile-time benchmarks of the core NIR passes on large synthetic
+ * shaders.  Every pass runs on a fresh clone of the shader, only the pass
+ * itself is timed.  The number of runs per pass can be set with
+ * NIR_BENCH_ITERATIONS.
+ */
+
+#include <gtest/gtest.h>
+
+#include "nir.h"
+#include "nir_builder.h"
+#include "util/os_time.h"
+#include "util/u_debug.h"
+
+namespace {
+
+struct bench_pass {
+   const char *name;
+   bool (*pass)(nir_shader *shader);
+};
+
+static const bench_pass passes[] = {
+   { "nir_opt_algebraic",      nir_opt_algebraic },
+   { "nir_opt_copy_prop_vars", nir_opt_copy_prop_vars },
+   { "nir_lower_vars_to_ssa",  nir_lower_vars_to_ssa },
+   { "nir_opt_cse",            nir_opt_cse },
+   { "nir_opt_dce",            nir_opt_dce },
+};
+
+class nir_pass_benchmark : public ::testing::Test {
+protected:
+   nir_pass_benchmark();
+   ~nir_pass_benchmark();
+
+   nir_variable *create_int(nir_variable_mode mode, const char *name) {
+      if (mode == nir_var_function_temp)
+         return nir_local_variable_create(b->impl, glsl_int_type(), name);
+      else
+         return nir_variable_create(b->shader, mode, glsl_int_type(), name);
+   }
+
+   nir_ssa_def *source();
+   void build_big_block(unsigned count);
+   void build_deep_cfg(unsigned depth);
+   void build_many_vars(unsigned count);
+   void build_deref_chains(unsigned count);
+
+   void run_passes();
+
+   nir_builder *b, _b;
+   nir_variable *out;
+};
+
+nir_pass_benchmark::nir_pass_benchmark()
+{
+   glsl_type_singleton_init_or_ref();
+
+   static const nir_shader_compiler_options options = { };
+   _b = nir_builder_init_simple_shader(MESA_SHADER_COMPUTE, &options,
+                                       "pass benchmark");
+   b = &_b;
+   out = create_int(nir_var_mem_ssbo, "out");
+}
+
+nir_pass_benchmark::~nir_pass_benchmark()
+{
+   ralloc_free(b->shader);
+
+   glsl_type_singleton_decref();
+}
+
+nir_ssa_def *
+nir_pass_benchmark::source()
+{
+   return nir_channel(b, nir_load_local_invocation_id(b), 0);
+}
+
+/* One block with long arithmetic chains, full of redundant and trivially
+ * foldable expressions and of values nothing uses.
+ */
+void
+nir_pass_benchmark::build_big_block(unsigned count)
+{
+   nir_ssa_def *x = source();
+   for (unsigned i = 0; i < count; i++) {
+      nir_ssa_def *a = nir_iadd(b, x, nir_imm_int(b, i));
+      nir_ssa_def *c = nir_iadd(b, x, nir_imm_int(b, i));
+      nir_imul(b, a, nir_imm_int(b, 3));
+      x = nir_iadd(b, nir_imul(b, a, nir_imm_int(b, 1)), nir_ineg(b, nir_ineg(b, c)));
+   }
+   nir_store_var(b, out, x, 1);
+}
+
+/* Nested ifs inside a chain of loops, with a local variable written in
+ * every branch so that lowering it needs phis all over the CFG.
+ */
+void
+nir_pass_benchmark::build_deep_cfg(unsigned depth)
+{
+   nir_variable *v = create_int(nir_var_function_temp, "v");
+   nir_ssa_def *x = source();
+   nir_store_var(b, v, x, 1);
+
+   for (unsigned l = 0; l < 4; l++) {
+      nir_push_loop(b);
+      {
+         nir_push_if(b, nir_ige(b, nir_load_var(b, v), nir_imm_int(b, 1000)));
+            nir_jump(b, nir_jump_break);
+         nir_pop_if(b, NULL);
+
+         nir_if **ifs = new nir_if *[depth];
+         for (unsigned i = 0; i < depth; i++) {
+            ifs[i] = nir_push_if(b, nir_ilt(b, x, nir_imm_int(b, i)));
+            nir_store_var(b, v, nir_iadd_imm(b, nir_load_var(b, v), i), 1);
+            nir_push_else(b, ifs[i]);
+            nir_store_var(b, v, nir_imul_imm(b, nir_load_var(b, v), i), 1);
+         }
+         for (unsigned i = depth; i-- > 0;)
+            nir_pop_if(b, ifs[i]);
+         delete[] ifs;
+      }
+      nir_pop_loop(b, NULL);
+   }
+
+   nir_store_var(b, out, nir_load_var(b, v), 1);
+}
+
+/* Many local variables, copied into each other and read back repeatedly. */
+void
+nir_pass_benchmark::build_many_vars(unsigned count)
+{
+   nir_variable **vars = new nir_variable *[count];
+   nir_ssa_def *x = source();
+   for (unsigned i = 0; i < count; i++) {
+      vars[i] = create_int(nir_var_function_temp, "v");
+      nir_store_var(b, vars[i], nir_iadd_imm(b, x, i), 1);
+   }
+
+   for (unsigned i = 1; i < count; i++) {
+      nir_copy_var(b, vars[i], vars[i - 1]);
+      nir_store_var(b, vars[i - 1],
+                    nir_iadd(b, nir_load_var(b, vars[i]),
+                             nir_load_var(b, vars[i / 2])), 1);
+   }
+
+   nir_store_var(b, out, nir_load_var(b, vars[count - 1]), 1);
+   delete[] vars;
+}
+
+/* Loads and stores through long deref chains into a local array of
+ * structs of arrays.
+ */
+void
+nir_pass_benchmark::build_deref_chains(unsigned count)
+{
+   const glsl_struct_field field = glsl_struct_field(
+      glsl_array_type(glsl_int_type(), 8, 0), "a");
+   const glsl_type *elem = glsl_struct_type(&field, 1, "s", false);
+   const glsl_type *type =
+      glsl_array_type(glsl_array_type(elem, 8, 0), 8, 0);
+   nir_variable *v = nir_local_variable_create(b->impl, type, "arr");
+
+   nir_ssa_def *x = source();
+   for (unsigned i = 0; i < count; i++) {
+      nir_deref_instr *d = nir_build_deref_var(b, v);
+      d = nir_build_deref_array_imm(b, d, i % 8);
+      d = nir_build_deref_array_imm(b, d, (i / 8) % 8);
+      d = nir_build_deref_struct(b, d, 0);
+      d = nir_build_deref_array_imm(b, d, (i / 64) % 8);
+      nir_store_deref(b, d, nir_iadd_imm(b, x, i), 1);
+
+      nir_deref_instr *s = nir_build_deref_var(b, v);
+      s = nir_build_deref_array_imm(b, s, (i * 7) % 8);
+      s = nir_build_deref_array_imm(b, s, (i / 8) % 8);
+      s = nir_build_deref_struct(b, s, 0);
+      s = nir_build_deref_array_imm(b, s, (i / 64) % 8);
+      x = nir_iadd(b, x, nir_load_deref(b, s));
+   }
+
+   nir_store_var(b, out, x, 1);
+}
+
+void
+nir_pass_benchmark::run_passes()
+{
+   const unsigned iterations =
+      MAX2(debug_get_num_option("NIR_BENCH_ITERATIONS", 10), 1);
+   const testing::TestInfo *info =
+      testing::UnitTest::GetInstance()->current_test_info();
+
+   nir_validate_shader(b->shader, "after building the shader");
+
+   unsigned instrs = 0;
+   nir_foreach_block(block, b->impl) {
+      nir_foreach_instr(instr, block)
+         instrs++;
+   }
+
+   for (unsigned p = 0; p < ARRAY_SIZE(passes); p++) {
+      int64_t total = 0, best = INT64_MAX;
+
+      for (unsigned i = 0; i < iterations; i++) {
+         nir_shader *clone = nir_shader_clone(NULL, b->shader);
+
+         int64_t start = os_time_get_nano();
+         passes[p].pass(clone);
+         int64_t elapsed = os_time_get_nano() - start;
+
+         total += elapsed;
+         best = MIN2(best, elapsed);
+
+         if (i == 0)
+            nir_validate_shader(clone, passes[p].name);
+         ralloc_free(clone);
+      }
+
+      printf("%s,%s,%u,%u,%.3f,%.3f\n", info->name(), passes[p].name,
+             instrs, iterations, total / 1000000.0 / iterations,
+             best / 1000000.0);
+      RecordProperty(passes[p].name, (int)(total / 1000 / iterations));
+   }
+}
+
+} // namespace
+
+/* Output is CSV: benchmark,pass,instructions,iterations,mean ms,best ms */
+
+TEST_F(nir_pass_benchmark, big_block)
+{
+   build_big_block(20000);
+   run_passes();
+}
+
+TEST_F(nir_pass_benchmark, deep_cfg)
+{
+   build_deep_cfg(200);
+   run_passes();
+}
+
+TEST_F(nir_pass_benchmark, many_vars)
+{
+   build_many_vars(4000);
+   run_passes();
+}
+
+TEST_F(nir_pass_benchmark, deref_chains)
+{
+   build_deref_chains(4000);
+   run_passes();
+}
@@ -618,7 +618,8 @@ vtn_handle_decoration(struct vtn_builder *b, SpvOp opcode,
    case SpvOpExecutionModeId: {
       struct vtn_value *val = vtn_untyped_value(b, target);
 
-      struct vtn_decoration *dec = rzalloc(b, struct vtn_decoration);
+      struct vtn_decoration *dec =
+         linear_zalloc_child(b->lin_ctx, sizeof(struct vtn_decoration));
       switch (opcode) {
       case SpvOpDecorate:
       case SpvOpDecorateId:
@@ -654,7 +655,8 @@ vtn_handle_decoration(struct vtn_builder *b, SpvOp opcode,
 
       for (; w < w_end; w++) {
          struct vtn_value *val = vtn_untyped_value(b, *w);
-         struct vtn_decoration *dec = rzalloc(b, struct vtn_decoration);
+         struct vtn_decoration *dec =
+            linear_zalloc_child(b->lin_ctx, sizeof(struct vtn_decoration));
 
          dec->group = group;
          if (opcode == SpvOpGroupDecorate) {
@@ -5824,6 +5826,7 @@ vtn_create_builder(const uint32_t *words, size_t word_count,
 
    b->value_id_bound = value_id_bound;
    b->values = rzalloc_array(b, struct vtn_value, value_id_bound);
+   b->lin_ctx = linear_zalloc_parent(b, 0);
 
    if (b->options->environment == NIR_SPIRV_VULKAN && b->version < 0x10400)
       b->vars_used_indirectly = _mesa_pointer_set_create(b);
@@ -6011,11 +6014,6 @@ spirv_to_nir(const uint32_t *words, size_t word_count,
 
    vtn_build_cfg(b, words, word_end);
 
-   if (!options->create_library) {
-      assert(b->entry_point->value_type == vtn_value_type_function);
-      b->entry_point->func->referenced = true;
-   }
-
    bool progress;
    do {
       progress = false;
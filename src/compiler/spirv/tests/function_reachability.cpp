@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include "helpers.h"
+
+TEST_F(spirv_test, unreachable_function_skipped)
+{
+   /*
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint GLCompute %3 "main"
+               OpExecutionMode %3 LocalSize 1 1 1
+          %1 = OpTypeVoid
+          %2 = OpTypeFunction %1
+          %3 = OpFunction %1 None %2
+          %6 = OpLabel
+          %7 = OpFunctionCall %1 %4
+               OpReturn
+               OpFunctionEnd
+          %4 = OpFunction %1 None %2
+          %8 = OpLabel
+               OpReturn
+               OpFunctionEnd
+
+               ; Never called, and its CFG isn't valid
+          %5 = OpFunction %1 None %2
+          %9 = OpLabel
+               OpBranch %9
+               OpFunctionEnd
+   */
+   static const uint32_t words[] = {
+      0x07230203, 0x00010000, 0x00000000, 0x0000000a, 0x00000000, 0x00020011,
+      0x00000001, 0x0003000e, 0x00000000, 0x00000001, 0x0005000f, 0x00000005,
+      0x00000003, 0x6e69616d, 0x00000000, 0x00060010, 0x00000003, 0x00000011,
+      0x00000001, 0x00000001, 0x00000001, 0x00020013, 0x00000001, 0x00030021,
+      0x00000002, 0x00000001, 0x00050036, 0x00000001, 0x00000003, 0x00000000,
+      0x00000002, 0x000200f8, 0x00000006, 0x00040039, 0x00000001, 0x00000007,
+      0x00000004, 0x000100fd, 0x00010038, 0x00050036, 0x00000001, 0x00000004,
+      0x00000000, 0x00000002, 0x000200f8, 0x00000008, 0x000100fd, 0x00010038,
+      0x00050036, 0x00000001, 0x00000005, 0x00000000, 0x00000002, 0x000200f8,
+      0x00000009, 0x000200f9, 0x00000009, 0x00010038,
+   };
+
+   get_nir(sizeof(words) / sizeof(words[0]), words);
+
+   ASSERT_NE(shader, nullptr);
+   EXPECT_NE(nir_shader_get_entrypoint(shader), nullptr);
+}
+
+TEST_F(spirv_test, indirectly_called_function_translated)
+{
+   /* Same as above, except that %4 calls %5, so translating fails. */
+   static const uint32_t words[] = {
+      0x07230203, 0x00010000, 0x00000000, 0x0000000b, 0x00000000, 0x00020011,
+      0x00000001, 0x0003000e, 0x00000000, 0x00000001, 0x0005000f, 0x00000005,
+      0x00000003, 0x6e69616d, 0x00000000, 0x00060010, 0x00000003, 0x00000011,
+      0x00000001, 0x00000001, 0x00000001, 0x00020013, 0x00000001, 0x00030021,
+      0x00000002, 0x00000001, 0x00050036, 0x00000001, 0x00000003, 0x00000000,
+      0x00000002, 0x000200f8, 0x00000006, 0x00040039, 0x00000001, 0x00000007,
+      0x00000004, 0x000100fd, 0x00010038, 0x00050036, 0x00000001, 0x00000004,
+      0x00000000, 0x00000002, 0x000200f8, 0x00000008, 0x00040039, 0x00000001,
+      0x0000000a, 0x00000005, 0x000100fd, 0x00010038, 0x00050036, 0x00000001,
+      0x00000005, 0x00000000, 0x00000002, 0x000200f8, 0x00000009, 0x000200f9,
+      0x00000009, 0x00010038,
+   };
+
+   get_nir(sizeof(words) / sizeof(words[0]), words);
+
+   EXPECT_EQ(shader, nullptr);
+}
@@ -160,6 +160,7 @@ vtn_cfg_handle_prepass_instruction(struct vtn_builder *b, SpvOp opcode,
       b->func->node.type = vtn_cf_node_type_function;
       b->func->node.parent = NULL;
       list_inithead(&b->func->body);
+      util_dynarray_init(&b->func->callees, b);
       b->func->control = w[3];
 
       UNUSED const struct glsl_type *result_type = vtn_get_type(b, w[1])->type;
@@ -277,6 +278,11 @@ vtn_cfg_handle_prepass_instruction(struct vtn_builder *b, SpvOp opcode,
       b->block = NULL;
       break;
 
+   case SpvOpFunctionCall:
+      vtn_assert(b->func);
+      util_dynarray_append(&b->func->callees, uint32_t, w[3]);
+      break;
+
    default:
       /* Continue on as per normal */
       return true;
@@ -285,6 +291,38 @@ vtn_cfg_handle_prepass_instruction(struct vtn_builder *b, SpvOp opcode,
    return true;
 }
 
+/* Marks the functions reachable from the entry point as referenced, so that
+ * only their CFGs get built and only their bodies get translated.  Modules
+ * such as shader libraries or OpenCL programs often contain a lot of
+ * functions the entry point never calls.
+ */
+static void
+vtn_mark_reachable_functions(struct vtn_builder *b)
+{
+   struct util_dynarray worklist;
+   util_dynarray_init(&worklist, NULL);
+
+   assert(b->entry_point->value_type == vtn_value_type_function);
+   b->entry_point->func->referenced = true;
+   util_dynarray_append(&worklist, struct vtn_function *, b->entry_point->func);
+
+   while (util_dynarray_num_elements(&worklist, struct vtn_function *)) {
+      struct vtn_function *func =
+         util_dynarray_pop(&worklist, struct vtn_function *);
+
+      util_dynarray_foreach(&func->callees, uint32_t, id) {
+         struct vtn_function *callee =
+            vtn_value(b, *id, vtn_value_type_function)->func;
+         if (!callee->referenced) {
+            callee->referenced = true;
+            util_dynarray_append(&worklist, struct vtn_function *, callee);
+         }
+      }
+   }
+
+   util_dynarray_fini(&worklist);
+}
+
 /* This function performs a depth-first search of the cases and puts them
  * in fall-through order.
  */
@@ -845,11 +883,16 @@ vtn_build_cfg(struct vtn_builder *b, const uint32_t *words, const uint32_t *end)
    vtn_foreach_instruction(b, words, end,
                            vtn_cfg_handle_prepass_instruction);
 
+   if (!b->options->create_library)
+      vtn_mark_reachable_functions(b);
+
    if (b->shader->info.stage == MESA_SHADER_KERNEL)
       return;
 
    vtn_foreach_cf_node(func_node, &b->functions) {
       struct vtn_function *func = vtn_cf_node_as_function(func_node);
+      if (!b->options->create_library && !func->referenced)
+         continue;
 
       /* We build the CFG for each function by doing a breadth-first search on
        * the control-flow graph.  We keep track of our state using a worklist.
@@ -271,6 +271,9 @@ struct vtn_function {
    nir_function *nir_func;
    struct vtn_block *start_block;
 
+   /* SPIR-V ids of the functions called, gathered by the CFG prepass */
+   struct util_dynarray callees;
+
    struct list_head body;
 
    const uint32_t *end;
@@ -691,6 +694,11 @@ struct vtn_builder {
    unsigned value_id_bound;
    struct vtn_value *values;
 
+   /* Linear allocator for the many small objects which live as long as the
+    * builder, such as decorations.
+    */
+   void *lin_ctx;
+
    /* Information on the origin of the SPIR-V */
    enum vtn_generator generator_id;
    SpvSourceLanguage source_lang;
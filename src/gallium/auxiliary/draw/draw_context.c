@@ -233,6 +233,7 @@ void draw_destroy( struct draw_context *draw )
    draw_pt_destroy( draw );
    draw_vs_destroy( draw );
    draw_gs_destroy( draw );
+   draw_tess_destroy( draw );
 #ifdef DRAW_LLVM_AVAILABLE
    if (draw->llvm)
       draw_llvm_destroy( draw->llvm );
@@ -49,6 +49,7 @@
 #ifdef DRAW_LLVM_AVAILABLE
 struct gallivm_state;
 #endif
+struct util_queue;
 
 
 /** Sum of frustum planes and user-defined planes */
@@ -332,6 +333,10 @@ struct draw_context
       struct draw_tess_eval_shader *tess_eval_shader;
       uint position_output;
 
+      /** Threads running the TES on parts of the patches, created on demand */
+      struct util_queue *queue;
+      boolean no_queue;
+
       /** Fields for TGSI interpreter / execution */
       struct {
          struct tgsi_exec_machine *machine;
@@ -460,6 +465,11 @@ boolean draw_gs_init( struct draw_context *draw );
 
 void draw_gs_destroy( struct draw_context *draw );
 
+/*******************************************************************************
+ * Tessellation code:
+ */
+void draw_tess_destroy( struct draw_context *draw );
+
 /*******************************************************************************
  * Common shading code:
  */
@@ -33,6 +33,9 @@
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/ralloc.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
+#include "util/u_queue.h"
 static inline int
 draw_tes_get_input_index(int semantic, int index,
                          const struct tgsi_shader_info *input_info)
@@ -216,12 +219,13 @@ int draw_tess_ctrl_shader_run(struct draw_tess_ctrl_shader *shader,
 #define DEBUG_INPUTS 0
 static void
 llvm_fetch_tes_input(struct draw_tess_eval_shader *shader,
+                     struct draw_tes_inputs *tes_input,
                      const struct draw_prim_info *input_prim_info,
                      unsigned prim_id,
                      unsigned num_vertices)
 {
    const float (*input_ptr)[4];
-   float (*input_data)[32][PIPE_MAX_SHADER_INPUTS][TGSI_NUM_CHANNELS] = &shader->tes_input->data;
+   float (*input_data)[32][PIPE_MAX_SHADER_INPUTS][TGSI_NUM_CHANNELS] = &tes_input->data;
    unsigned slot, i;
    int vs_slot;
    unsigned input_vertex_stride = shader->input_vertex_stride;
@@ -301,18 +305,140 @@ llvm_fetch_tess_factors(struct draw_tess_eval_shader *shader,
 
 static void
 llvm_tes_run(struct draw_tess_eval_shader *shader,
+             struct draw_tes_inputs *tes_input,
              uint32_t prim_id,
              uint32_t patch_vertices_in,
              struct pipe_tessellator_data *tess_data,
              struct pipe_tessellation_factors *tess_factors,
              struct vertex_header *output)
 {
-   shader->current_variant->jit_func(shader->jit_context, shader->tes_input->data, output, prim_id,
+   shader->current_variant->jit_func(shader->jit_context, tes_input->data, output, prim_id,
                                      tess_data->num_domain_points, tess_data->domain_points_u, tess_data->domain_points_v,
                                      tess_factors->outer_tf, tess_factors->inner_tf, patch_vertices_in,
                                      shader->draw->pt.user.viewid);
 }
+
+/* Jobs smaller than this aren't worth a thread */
+#define DRAW_TES_MIN_PATCHES_PER_JOB 16
+
+/**
+ * A range of patches tessellated and shaded by one thread. The output
+ * vertices and elements are merged in the order of the jobs afterwards.
+ */
+struct draw_tes_job {
+   struct draw_tess_eval_shader *shader;
+   const struct draw_prim_info *input_prim;
+   unsigned num_input_vertices_per_patch;
+   unsigned vertex_size;
+   unsigned slot;
+   unsigned start;
+   unsigned end;
+
+   struct vertex_header *verts;
+   unsigned vert_count;
+   ushort *elts;
+   unsigned elt_count;
+   uint64_t ds_invocations;
+
+   struct util_queue_fence fence;
+};
+
+static void
+draw_tes_run_patches(struct draw_tes_job *job)
+{
+   struct draw_tess_eval_shader *shader = job->shader;
+   struct pipe_tessellator *ptess = shader->ptess[job->slot];
+   struct draw_tes_inputs *tes_input = shader->tes_input[job->slot];
+   unsigned num_input_vertices_per_patch = job->num_input_vertices_per_patch;
+   struct pipe_tessellation_factors factors;
+   struct pipe_tessellator_data data = { 0 };
+
+   for (unsigned i = job->start; i < job->end; i++) {
+      uint32_t vert_start = job->vert_count;
+      uint32_t elt_start = job->elt_count;
+
+      llvm_fetch_tess_factors(shader, i, num_input_vertices_per_patch, &factors);
+
+      /* tessellate with the factors for this primitive */
+      p_tessellate(ptess, &factors, &data);
+
+      if (data.num_domain_points == 0)
+         continue;
+
+      uint32_t old_verts = vert_start;
+      uint32_t new_verts = vert_start + util_align_npot(data.num_domain_points, 4);
+      uint32_t old_size = job->vertex_size * old_verts;
+      uint32_t new_size = job->vertex_size * new_verts;
+      job->verts = REALLOC(job->verts, old_size, new_size);
+
+      job->vert_count += data.num_domain_points;
+
+      job->elt_count += data.num_indices;
+      job->elts = REALLOC(job->elts, elt_start * sizeof(uint16_t),
+                          job->elt_count * sizeof(uint16_t));
+
+      for (unsigned j = 0; j < data.num_indices; j++)
+         job->elts[elt_start + j] = vert_start + data.indices[j];
+
+      llvm_fetch_tes_input(shader, tes_input, job->input_prim, i, num_input_vertices_per_patch);
+      /* run once per primitive? */
+      char *output = (char *)job->verts;
+      output += vert_start * job->vertex_size;
+      llvm_tes_run(shader, tes_input, i, num_input_vertices_per_patch, &data, &factors, (struct vertex_header *)output);
+
+      job->ds_invocations += data.num_domain_points;
+   }
+}
+
+static void
+draw_tes_execute_job(void *data, int thread_index)
+{
+   draw_tes_run_patches((struct draw_tes_job *)data);
+}
+
+/**
+ * Number of jobs to split the patches in, creating the threads when they
+ * are needed for the first time. DRAW_TES_THREADS=0 runs all the patches
+ * on the draw thread.
+ */
+static unsigned
+draw_tes_num_jobs(struct draw_context *draw, unsigned num_patches)
+{
+   if (num_patches < 2 * DRAW_TES_MIN_PATCHES_PER_JOB || draw->tes.no_queue)
+      return 1;
+
+   if (!draw->tes.queue) {
+      int num_threads = debug_get_num_option("DRAW_TES_THREADS",
+                                             util_get_cpu_caps()->nr_cpus - 1);
+      num_threads = MIN2(num_threads, DRAW_TES_MAX_JOBS - 1);
+
+      if (num_threads > 0)
+         draw->tes.queue = CALLOC_STRUCT(util_queue);
+      if (!draw->tes.queue ||
+          !util_queue_init(draw->tes.queue, "draw_tes", DRAW_TES_MAX_JOBS,
+                           num_threads, 0)) {
+         FREE(draw->tes.queue);
+         draw->tes.queue = NULL;
+         draw->tes.no_queue = TRUE;
+         return 1;
+      }
+   }
+
+   return MIN2(num_patches / DRAW_TES_MIN_PATCHES_PER_JOB,
+               draw->tes.queue->num_threads + 1);
+}
+#endif
+
+void draw_tess_destroy(struct draw_context *draw)
+{
+#ifdef DRAW_LLVM_AVAILABLE
+   if (draw->tes.queue) {
+      util_queue_destroy(draw->tes.queue);
+      FREE(draw->tes.queue);
+      draw->tes.queue = NULL;
+   }
 #endif
+}
 
 /**
  * Execute tess eval shader.
@@ -352,59 +478,88 @@ int draw_tess_eval_shader_run(struct draw_tess_eval_shader *shader,
    shader->input_info = input_info;
 
 #ifdef DRAW_LLVM_AVAILABLE
-   struct pipe_tessellation_factors factors;
-   struct pipe_tessellator_data data = { 0 };
-   struct pipe_tessellator *ptess = p_tess_init(shader->prim_mode,
-                                                shader->spacing,
-                                                !shader->vertex_order_cw,
-                                                shader->point_mode);
-   for (unsigned i = 0; i < input_prim->primitive_count; i++) {
-      uint32_t vert_start = output_verts->count;
-      uint32_t prim_start = output_prims->primitive_count;
-      uint32_t elt_start = output_prims->count;
-
-      llvm_fetch_tess_factors(shader, i, num_input_vertices_per_patch, &factors);
-
-      /* tessellate with the factors for this primitive */
-      p_tessellate(ptess, &factors, &data);
-
-      if (data.num_domain_points == 0)
-         continue;
-
-      uint32_t old_verts = vert_start;
-      uint32_t new_verts = vert_start + util_align_npot(data.num_domain_points, 4);
-      uint32_t old_size = output_verts->vertex_size * old_verts;
-      uint32_t new_size = output_verts->vertex_size * new_verts;
-      output_verts->verts = REALLOC(output_verts->verts, old_size, new_size);
-
-      output_verts->count += data.num_domain_points;
+   struct draw_tes_job jobs[DRAW_TES_MAX_JOBS];
+   unsigned num_patches = input_prim->primitive_count;
+   unsigned num_jobs = draw_tes_num_jobs(shader->draw, num_patches);
+
+   for (unsigned j = 0; j < num_jobs; j++) {
+      struct draw_tes_job *job = &jobs[j];
+
+      if (!shader->ptess[j]) {
+         shader->ptess[j] = p_tess_init(shader->prim_mode,
+                                        shader->spacing,
+                                        !shader->vertex_order_cw,
+                                        shader->point_mode);
+         shader->tes_input[j] = align_malloc(sizeof(struct draw_tes_inputs), 16);
+         memset(shader->tes_input[j], 0, sizeof(struct draw_tes_inputs));
+      }
 
-      output_prims->count += data.num_indices;
-      elts = REALLOC(elts, elt_start * sizeof(uint16_t),
-                     output_prims->count * sizeof(uint16_t));
+      memset(job, 0, sizeof(*job));
+      job->shader = shader;
+      job->input_prim = input_prim;
+      job->num_input_vertices_per_patch = num_input_vertices_per_patch;
+      job->vertex_size = vertex_size;
+      job->slot = j;
+      job->start = num_patches * j / num_jobs;
+      job->end = num_patches * (j + 1) / num_jobs;
+   }
 
-      for (unsigned i = 0; i < data.num_indices; i++)
-         elts[elt_start + i] = vert_start + data.indices[i];
+   /* the first range of patches is handled by the draw thread */
+   for (unsigned j = 1; j < num_jobs; j++) {
+      util_queue_fence_init(&jobs[j].fence);
+      util_queue_add_job(shader->draw->tes.queue, &jobs[j], &jobs[j].fence,
+                         draw_tes_execute_job, NULL, 0);
+   }
+   draw_tes_run_patches(&jobs[0]);
+
+   output_verts->verts = jobs[0].verts;
+   output_verts->count = jobs[0].vert_count;
+   elts = jobs[0].elts;
+   output_prims->count = jobs[0].elt_count;
+   uint64_t ds_invocations = jobs[0].ds_invocations;
+
+   for (unsigned j = 1; j < num_jobs; j++) {
+      struct draw_tes_job *job = &jobs[j];
+
+      util_queue_fence_wait(&job->fence);
+      util_queue_fence_destroy(&job->fence);
+
+      if (job->vert_count) {
+         uint32_t vert_start = output_verts->count;
+         uint32_t elt_start = output_prims->count;
+         uint32_t new_verts = vert_start + util_align_npot(job->vert_count, 4);
+
+         output_verts->verts = REALLOC(output_verts->verts,
+                                       vertex_size * vert_start,
+                                       vertex_size * new_verts);
+         memcpy((char *)output_verts->verts + vertex_size * vert_start,
+                job->verts, vertex_size * job->vert_count);
+         output_verts->count += job->vert_count;
+
+         output_prims->count += job->elt_count;
+         elts = REALLOC(elts, elt_start * sizeof(uint16_t),
+                        output_prims->count * sizeof(uint16_t));
+         for (unsigned i = 0; i < job->elt_count; i++)
+            elts[elt_start + i] = vert_start + job->elts[i];
+      }
+      ds_invocations += job->ds_invocations;
 
-      llvm_fetch_tes_input(shader, input_prim, i, num_input_vertices_per_patch);
-      /* run once per primitive? */
-      char *output = (char *)output_verts->verts;
-      output += vert_start * vertex_size;
-      llvm_tes_run(shader, i, num_input_vertices_per_patch, &data, &factors, (struct vertex_header *)output);
+      FREE(job->verts);
+      FREE(job->elts);
+   }
 
-      if (shader->draw->collect_statistics) {
-         shader->draw->statistics.ds_invocations += data.num_domain_points;
-      }
+   if (shader->draw->collect_statistics) {
+      shader->draw->statistics.ds_invocations += ds_invocations;
+   }
 
-      uint32_t prim_len = u_prim_vertex_count(output_prims->prim)->min;
-      output_prims->primitive_count += data.num_indices / prim_len;
-      output_prims->primitive_lengths = REALLOC(output_prims->primitive_lengths, prim_start * sizeof(uint32_t),
-                                                output_prims->primitive_count * sizeof(uint32_t));
-      for (unsigned i = prim_start; i < output_prims->primitive_count; i++) {
+   uint32_t prim_len = u_prim_vertex_count(output_prims->prim)->min;
+   output_prims->primitive_count = output_prims->count / prim_len;
+   if (output_prims->primitive_count) {
+      output_prims->primitive_lengths = MALLOC(output_prims->primitive_count * sizeof(uint32_t));
+      for (unsigned i = 0; i < output_prims->primitive_count; i++) {
          output_prims->primitive_lengths[i] = prim_len;
       }
    }
-   p_tess_destroy(ptess);
 #endif
 
    *elts_out = elts;
@@ -574,9 +729,6 @@ draw_create_tess_eval_shader(struct draw_context *draw,
 #ifdef DRAW_LLVM_AVAILABLE
    if (use_llvm) {
 
-      tes->tes_input = align_malloc(sizeof(struct draw_tes_inputs), 16);
-      memset(tes->tes_input, 0, sizeof(struct draw_tes_inputs));
-
       tes->jit_context = &draw->llvm->tes_jit_context;
       llvm_tes->variant_key_size =
          draw_tes_llvm_variant_key_size(
@@ -619,7 +771,12 @@ void draw_delete_tess_eval_shader(struct draw_context *draw,
       }
 
       assert(shader->variants_cached == 0);
-      align_free(dtes->tes_input);
+      for (unsigned i = 0; i < DRAW_TES_MAX_JOBS; i++) {
+         if (dtes->ptess[i]) {
+            p_tess_destroy(dtes->ptess[i]);
+            align_free(dtes->tes_input[i]);
+         }
+      }
    }
 #endif
    if (dtes->state.ir.nir)
@@ -30,9 +30,14 @@
 #include "draw_private.h"
 
 struct draw_context;
+struct pipe_tessellator;
 #ifdef DRAW_LLVM_AVAILABLE
 
 #define NUM_PATCH_INPUTS 32
+
+/* The patches of a TES run are split in up to this many jobs, each using
+ * its own tessellator and input storage. */
+#define DRAW_TES_MAX_JOBS 16
 #define NUM_TCS_INPUTS (PIPE_MAX_SHADER_INPUTS - NUM_PATCH_INPUTS)
 
 struct draw_tcs_inputs {
@@ -92,9 +97,12 @@ struct draw_tess_eval_shader {
    const struct tgsi_shader_info *input_info;
 
 #ifdef DRAW_LLVM_AVAILABLE
-   struct draw_tes_inputs *tes_input;
+   struct draw_tes_inputs *tes_input[DRAW_TES_MAX_JOBS];
    struct draw_tes_jit_context *jit_context;
    struct draw_tes_llvm_variant *current_variant;
+
+   /* kept across draws, so that their cache of tessellation results is too */
+   struct pipe_tessellator *ptess[DRAW_TES_MAX_JOBS];
 #endif
 };
 
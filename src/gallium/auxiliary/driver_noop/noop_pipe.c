@@ -33,8 +33,11 @@
 #include "noop_public.h"
 
 DEBUG_GET_ONCE_BOOL_OPTION(noop, "GALLIUM_NOOP", false)
+DEBUG_GET_ONCE_BOOL_OPTION(noop_stats, "GALLIUM_NOOP_STATS", false)
 
 void noop_init_state_functions(struct pipe_context *ctx);
+struct pipe_context *noop_stats_create_context(void);
+void noop_stats_init_context(struct pipe_context *ctx);
 
 struct noop_pipe_screen {
    struct pipe_screen	pscreen;
@@ -351,7 +354,8 @@ static void noop_set_frontend_noop(struct pipe_context *ctx, bool enable)
 static struct pipe_context *noop_create_context(struct pipe_screen *screen,
                                                 void *priv, unsigned flags)
 {
-   struct pipe_context *ctx = CALLOC_STRUCT(pipe_context);
+   struct pipe_context *ctx = debug_get_option_noop_stats() ?
+      noop_stats_create_context() : CALLOC_STRUCT(pipe_context);
 
    if (!ctx)
       return NULL;
@@ -391,6 +395,9 @@ static struct pipe_context *noop_create_context(struct pipe_screen *screen,
    ctx->set_frontend_noop = noop_set_frontend_noop;
    noop_init_state_functions(ctx);
 
+   if (debug_get_option_noop_stats())
+      noop_stats_init_context(ctx);
+
    return ctx;
 }
 
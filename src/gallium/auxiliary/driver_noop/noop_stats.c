@@ -0,0 +1,380 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Overhead measurement for the noop driver, enabled with
+ * GALLIUM_NOOP_STATS=1 in addition to GALLIUM_NOOP=1.
+ *
+ * Every pipe_context entrypoint counts its calls and the bytes of data it
+ * is given. Since the noop driver does no work, the time between two calls
+ * into the driver is spent in the frontend; it is accounted to the
+ * entrypoint that ends it, so e.g. the state validation before a draw
+ * shows up as time of draw_vbo. A summary is printed when the context is
+ * destroyed.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "pipe/p_context.h"
+#include "pipe/p_state.h"
+#include "util/format/u_format.h"
+#include "util/os_time.h"
+#include "util/u_memory.h"
+
+#define NOOP_STATS_UNPACK(...) __VA_ARGS__
+
+/* The entrypoints set by the noop driver, except destroy:
+ *    V(name, (parameters), (arguments), bytes of data) for void ones and
+ *    R(return type, name, (parameters), (arguments), bytes of data)
+ * The context parameter is implicit.
+ */
+#define NOOP_STATS_FUNCS(V, R) \
+   V(flush, (struct pipe_fence_handle **fence, unsigned flags), \
+     (fence, flags), 0) \
+   V(clear, (unsigned buffers, const struct pipe_scissor_state *scissor_state, \
+             const union pipe_color_union *color, double depth, \
+             unsigned stencil), \
+     (buffers, scissor_state, color, depth, stencil), 0) \
+   V(clear_render_target, (struct pipe_surface *dst, \
+                           const union pipe_color_union *color, \
+                           unsigned dstx, unsigned dsty, \
+                           unsigned width, unsigned height, \
+                           bool render_condition_enabled), \
+     (dst, color, dstx, dsty, width, height, render_condition_enabled), 0) \
+   V(clear_depth_stencil, (struct pipe_surface *dst, unsigned clear_flags, \
+                           double depth, unsigned stencil, \
+                           unsigned dstx, unsigned dsty, \
+                           unsigned width, unsigned height, \
+                           bool render_condition_enabled), \
+     (dst, clear_flags, depth, stencil, dstx, dsty, width, height, \
+      render_condition_enabled), 0) \
+   V(resource_copy_region, (struct pipe_resource *dst, unsigned dst_level, \
+                            unsigned dstx, unsigned dsty, unsigned dstz, \
+                            struct pipe_resource *src, unsigned src_level, \
+                            const struct pipe_box *src_box), \
+     (dst, dst_level, dstx, dsty, dstz, src, src_level, src_box), \
+     box_bytes(src, src_box)) \
+   R(bool, generate_mipmap, (struct pipe_resource *resource, \
+                             enum pipe_format format, unsigned base_level, \
+                             unsigned last_level, unsigned first_layer, \
+                             unsigned last_layer), \
+     (resource, format, base_level, last_level, first_layer, last_layer), 0) \
+   V(blit, (const struct pipe_blit_info *info), (info), \
+     box_bytes(info->src.resource, &info->src.box)) \
+   V(flush_resource, (struct pipe_resource *resource), (resource), 0) \
+   R(struct pipe_query *, create_query, (unsigned query_type, unsigned index), \
+     (query_type, index), 0) \
+   V(destroy_query, (struct pipe_query *query), (query), 0) \
+   R(bool, begin_query, (struct pipe_query *query), (query), 0) \
+   R(bool, end_query, (struct pipe_query *query), (query), 0) \
+   R(bool, get_query_result, (struct pipe_query *query, bool wait, \
+                              union pipe_query_result *result), \
+     (query, wait, result), 0) \
+   V(set_active_query_state, (bool enable), (enable), 0) \
+   R(void *, transfer_map, (struct pipe_resource *resource, unsigned level, \
+                            unsigned usage, const struct pipe_box *box, \
+                            struct pipe_transfer **transfer), \
+     (resource, level, usage, box, transfer), box_bytes(resource, box)) \
+   V(transfer_flush_region, (struct pipe_transfer *transfer, \
+                             const struct pipe_box *box), \
+     (transfer, box), 0) \
+   V(transfer_unmap, (struct pipe_transfer *transfer), (transfer), 0) \
+   V(buffer_subdata, (struct pipe_resource *resource, unsigned usage, \
+                      unsigned offset, unsigned size, const void *data), \
+     (resource, usage, offset, size, data), size) \
+   V(texture_subdata, (struct pipe_resource *resource, unsigned level, \
+                       unsigned usage, const struct pipe_box *box, \
+                       const void *data, unsigned stride, \
+                       unsigned layer_stride), \
+     (resource, level, usage, box, data, stride, layer_stride), \
+     box_bytes(resource, box)) \
+   V(invalidate_resource, (struct pipe_resource *resource), (resource), 0) \
+   V(set_context_param, (enum pipe_context_param param, unsigned value), \
+     (param, value), 0) \
+   V(set_frontend_noop, (bool enable), (enable), 0) \
+   R(void *, create_blend_state, (const struct pipe_blend_state *state), \
+     (state), 0) \
+   R(void *, create_depth_stencil_alpha_state, \
+     (const struct pipe_depth_stencil_alpha_state *state), (state), 0) \
+   R(void *, create_rasterizer_state, \
+     (const struct pipe_rasterizer_state *state), (state), 0) \
+   R(void *, create_sampler_state, (const struct pipe_sampler_state *state), \
+     (state), 0) \
+   R(struct pipe_sampler_view *, create_sampler_view, \
+     (struct pipe_resource *texture, const struct pipe_sampler_view *state), \
+     (texture, state), 0) \
+   R(struct pipe_surface *, create_surface, \
+     (struct pipe_resource *texture, const struct pipe_surface *surf_tmpl), \
+     (texture, surf_tmpl), 0) \
+   R(void *, create_vertex_elements_state, \
+     (unsigned count, const struct pipe_vertex_element *state), \
+     (count, state), 0) \
+   R(void *, create_fs_state, (const struct pipe_shader_state *state), \
+     (state), 0) \
+   R(void *, create_vs_state, (const struct pipe_shader_state *state), \
+     (state), 0) \
+   R(void *, create_gs_state, (const struct pipe_shader_state *state), \
+     (state), 0) \
+   R(void *, create_tcs_state, (const struct pipe_shader_state *state), \
+     (state), 0) \
+   R(void *, create_tes_state, (const struct pipe_shader_state *state), \
+     (state), 0) \
+   R(void *, create_compute_state, (const struct pipe_compute_state *state), \
+     (state), 0) \
+   V(bind_blend_state, (void *state), (state), 0) \
+   V(bind_depth_stencil_alpha_state, (void *state), (state), 0) \
+   V(bind_rasterizer_state, (void *state), (state), 0) \
+   V(bind_vertex_elements_state, (void *state), (state), 0) \
+   V(bind_fs_state, (void *state), (state), 0) \
+   V(bind_vs_state, (void *state), (state), 0) \
+   V(bind_gs_state, (void *state), (state), 0) \
+   V(bind_tcs_state, (void *state), (state), 0) \
+   V(bind_tes_state, (void *state), (state), 0) \
+   V(bind_compute_state, (void *state), (state), 0) \
+   V(bind_sampler_states, (enum pipe_shader_type shader, unsigned start, \
+                           unsigned count, void **states), \
+     (shader, start, count, states), 0) \
+   V(delete_blend_state, (void *state), (state), 0) \
+   V(delete_depth_stencil_alpha_state, (void *state), (state), 0) \
+   V(delete_rasterizer_state, (void *state), (state), 0) \
+   V(delete_sampler_state, (void *state), (state), 0) \
+   V(delete_vertex_elements_state, (void *state), (state), 0) \
+   V(delete_fs_state, (void *state), (state), 0) \
+   V(delete_vs_state, (void *state), (state), 0) \
+   V(delete_gs_state, (void *state), (state), 0) \
+   V(delete_tcs_state, (void *state), (state), 0) \
+   V(delete_tes_state, (void *state), (state), 0) \
+   V(delete_compute_state, (void *state), (state), 0) \
+   V(set_blend_color, (const struct pipe_blend_color *state), (state), 0) \
+   V(set_clip_state, (const struct pipe_clip_state *state), (state), 0) \
+   V(set_constant_buffer, (enum pipe_shader_type shader, uint index, \
+                           bool take_ownership, \
+                           const struct pipe_constant_buffer *cb), \
+     (shader, index, take_ownership, cb), cb ? cb->buffer_size : 0) \
+   V(set_inlinable_constants, (enum pipe_shader_type shader, \
+                               uint num_values, uint32_t *values), \
+     (shader, num_values, values), num_values * 4) \
+   V(set_sampler_views, (enum pipe_shader_type shader, unsigned start, \
+                         unsigned count, unsigned unbind_num_trailing_slots, \
+                         struct pipe_sampler_view **views), \
+     (shader, start, count, unbind_num_trailing_slots, views), 0) \
+   V(set_framebuffer_state, (const struct pipe_framebuffer_state *state), \
+     (state), 0) \
+   V(set_polygon_stipple, (const struct pipe_poly_stipple *state), (state), 0) \
+   V(set_sample_mask, (unsigned sample_mask), (sample_mask), 0) \
+   V(set_scissor_states, (unsigned start_slot, unsigned num_scissors, \
+                          const struct pipe_scissor_state *state), \
+     (start_slot, num_scissors, state), 0) \
+   V(set_stencil_ref, (const struct pipe_stencil_ref state), (state), 0) \
+   V(set_vertex_buffers, (unsigned start_slot, unsigned count, \
+                          unsigned unbind_num_trailing_slots, \
+                          bool take_ownership, \
+                          const struct pipe_vertex_buffer *buffers), \
+     (start_slot, count, unbind_num_trailing_slots, take_ownership, buffers), \
+     0) \
+   V(set_viewport_states, (unsigned start_slot, unsigned num_viewports, \
+                           const struct pipe_viewport_state *state), \
+     (start_slot, num_viewports, state), 0) \
+   V(set_window_rectangles, (bool include, unsigned num_rectangles, \
+                             const struct pipe_scissor_state *rects), \
+     (include, num_rectangles, rects), 0) \
+   V(sampler_view_destroy, (struct pipe_sampler_view *view), (view), 0) \
+   V(surface_destroy, (struct pipe_surface *surface), (surface), 0) \
+   V(draw_vbo, (const struct pipe_draw_info *info, \
+                const struct pipe_draw_indirect_info *indirect, \
+                const struct pipe_draw_start_count *draws, \
+                unsigned num_draws), \
+     (info, indirect, draws, num_draws), 0) \
+   V(launch_grid, (const struct pipe_grid_info *info), (info), 0) \
+   R(struct pipe_stream_output_target *, create_stream_output_target, \
+     (struct pipe_resource *res, unsigned buffer_offset, \
+      unsigned buffer_size), \
+     (res, buffer_offset, buffer_size), 0) \
+   V(stream_output_target_destroy, \
+     (struct pipe_stream_output_target *target), (target), 0) \
+   V(set_stream_output_targets, (unsigned num_targets, \
+                                 struct pipe_stream_output_target **targets, \
+                                 const unsigned *offsets), \
+     (num_targets, targets, offsets), 0)
+
+enum noop_stats_func {
+#define NOOP_STATS_ENUM_V(name, params, args, bytes) NOOP_STATS_##name,
+#define NOOP_STATS_ENUM_R(ret, name, params, args, bytes) NOOP_STATS_##name,
+   NOOP_STATS_FUNCS(NOOP_STATS_ENUM_V, NOOP_STATS_ENUM_R)
+   NOOP_STATS_NUM_FUNCS
+};
+
+static const char *noop_stats_names[] = {
+#define NOOP_STATS_NAME_V(name, params, args, bytes) #name,
+#define NOOP_STATS_NAME_R(ret, name, params, args, bytes) #name,
+   NOOP_STATS_FUNCS(NOOP_STATS_NAME_V, NOOP_STATS_NAME_R)
+};
+
+struct noop_stats_counter {
+   enum noop_stats_func func;
+   uint64_t calls;
+   uint64_t bytes;
+   int64_t frontend_ns;
+};
+
+struct noop_stats_context {
+   struct pipe_context base;
+
+   /* The entrypoints of the noop driver that are wrapped */
+   struct pipe_context funcs;
+
+   int64_t create_time;
+   int64_t last_call_time;
+   struct noop_stats_counter counters[NOOP_STATS_NUM_FUNCS];
+};
+
+static inline struct noop_stats_context *
+noop_stats_context(struct pipe_context *ctx)
+{
+   return (struct noop_stats_context *)ctx;
+}
+
+static uint64_t
+box_bytes(const struct pipe_resource *resource, const struct pipe_box *box)
+{
+   if (!resource || !box)
+      return 0;
+   if (resource->target == PIPE_BUFFER)
+      return box->width;
+
+   return (uint64_t)util_format_get_nblocks(resource->format, box->width,
+                                            box->height) *
+          util_format_get_blocksize(resource->format) * box->depth;
+}
+
+static inline void
+noop_stats_record(struct pipe_context *ctx, enum noop_stats_func func,
+                  uint64_t bytes)
+{
+   struct noop_stats_context *sctx = noop_stats_context(ctx);
+   int64_t now = os_time_get_nano();
+   struct noop_stats_counter *counter = &sctx->counters[func];
+
+   counter->calls++;
+   counter->bytes += bytes;
+   counter->frontend_ns += now - sctx->last_call_time;
+   sctx->last_call_time = now;
+}
+
+#define NOOP_STATS_WRAP_V(name, params, args, bytes) \
+static void noop_stats_##name(struct pipe_context *ctx, \
+                              NOOP_STATS_UNPACK params) \
+{ \
+   noop_stats_record(ctx, NOOP_STATS_##name, bytes); \
+   noop_stats_context(ctx)->funcs.name(ctx, NOOP_STATS_UNPACK args); \
+}
+#define NOOP_STATS_WRAP_R(ret, name, params, args, bytes) \
+static ret noop_stats_##name(struct pipe_context *ctx, \
+                             NOOP_STATS_UNPACK params) \
+{ \
+   noop_stats_record(ctx, NOOP_STATS_##name, bytes); \
+   return noop_stats_context(ctx)->funcs.name(ctx, NOOP_STATS_UNPACK args); \
+}
+NOOP_STATS_FUNCS(NOOP_STATS_WRAP_V, NOOP_STATS_WRAP_R)
+
+static int
+compare_counters(const void *a, const void *b)
+{
+   int64_t ta = ((const struct noop_stats_counter *)a)->frontend_ns;
+   int64_t tb = ((const struct noop_stats_counter *)b)->frontend_ns;
+
+   return ta < tb ? 1 : (ta > tb ? -1 : 0);
+}
+
+static void
+noop_stats_print(struct noop_stats_context *sctx)
+{
+   int64_t lifetime = os_time_get_nano() - sctx->create_time;
+   uint64_t total_calls = 0;
+   int64_t total_ns = 0;
+
+   for (int i = 0; i < NOOP_STATS_NUM_FUNCS; i++) {
+      sctx->counters[i].func = i;
+      total_calls += sctx->counters[i].calls;
+      total_ns += sctx->counters[i].frontend_ns;
+   }
+   qsort(sctx->counters, NOOP_STATS_NUM_FUNCS, sizeof(sctx->counters[0]),
+         compare_counters);
+
+   fprintf(stderr, "noop: context %p, %.3f ms alive, %" PRIu64 " driver calls, "
+           "%.3f ms before them\n", (void *)sctx, lifetime / 1000000.0,
+           total_calls, total_ns / 1000000.0);
+   fprintf(stderr, "noop: %-34s %12s %14s %12s %10s\n", "entrypoint", "calls",
+           "bytes", "ms", "ns/call");
+
+   for (int i = 0; i < NOOP_STATS_NUM_FUNCS; i++) {
+      const struct noop_stats_counter *counter = &sctx->counters[i];
+
+      if (!counter->calls)
+         continue;
+
+      fprintf(stderr, "noop: %-34s %12" PRIu64 " %14" PRIu64 " %12.3f %10.1f\n",
+              noop_stats_names[counter->func], counter->calls, counter->bytes,
+              counter->frontend_ns / 1000000.0,
+              (double)counter->frontend_ns / counter->calls);
+   }
+}
+
+static void
+noop_stats_destroy(struct pipe_context *ctx)
+{
+   struct noop_stats_context *sctx = noop_stats_context(ctx);
+
+   noop_stats_print(sctx);
+   sctx->funcs.destroy(ctx);
+}
+
+struct pipe_context *noop_stats_create_context(void);
+void noop_stats_init_context(struct pipe_context *ctx);
+
+/* Allocate a context with room for the counters, the noop driver fills in
+ * the pipe_context part as usual.
+ */
+struct pipe_context *noop_stats_create_context(void)
+{
+   struct noop_stats_context *sctx = CALLOC_STRUCT(noop_stats_context);
+
+   return sctx ? &sctx->base : NULL;
+}
+
+/* Wrap the entrypoints of a context created by noop_stats_create_context
+ * after the noop driver has set them.
+ */
+void noop_stats_init_context(struct pipe_context *ctx)
+{
+   struct noop_stats_context *sctx = noop_stats_context(ctx);
+
+   sctx->funcs = sctx->base;
+   sctx->create_time = sctx->last_call_time = os_time_get_nano();
+
+   ctx->destroy = noop_stats_destroy;
+#define NOOP_STATS_INIT_V(name, params, args, bytes) \
+   ctx->name = noop_stats_##name;
+#define NOOP_STATS_INIT_R(ret, name, params, args, bytes) \
+   ctx->name = noop_stats_##name;
+   NOOP_STATS_FUNCS(NOOP_STATS_INIT_V, NOOP_STATS_INIT_R)
+}
@@ -87,4 +87,14 @@
 #define GALLIVM_HAVE_CORO 0
 #endif
 
+/*
+ * The ORC JIT backend (-Dllvm-orcjit=true) needs the JITDylib resource
+ * management of LLVM 13, MCJIT is used otherwise.
+ */
+#if defined(GALLIVM_ORCJIT) && LLVM_VERSION_MAJOR >= 13
+#define GALLIVM_USE_ORCJIT 1
+#else
+#define GALLIVM_USE_ORCJIT 0
+#endif
+
 #endif /* LP_BLD_H */
@@ -250,10 +250,15 @@ gallivm_free_code(struct gallivm_state *gallivm)
 {
    assert(!gallivm->module);
    assert(!gallivm->engine);
+#if GALLIVM_USE_ORCJIT
+   lp_jit_module_destroy(gallivm->jit_module);
+   gallivm->jit_module = NULL;
+#else
    lp_free_generated_code(gallivm->code);
    gallivm->code = NULL;
    lp_free_memory_manager(gallivm->memorymgr);
    gallivm->memorymgr = NULL;
+#endif
 }
 
 
@@ -272,6 +277,13 @@ init_gallivm_engine(struct gallivm_state *gallivm)
          optlevel = Default;
       }
 
+#if GALLIVM_USE_ORCJIT
+      ret = lp_build_create_jit_module(&gallivm->jit_module,
+                                       gallivm->cache,
+                                       gallivm->module,
+                                       (unsigned) optlevel,
+                                       &error);
+#else
       ret = lp_build_create_jit_compiler_for_module(&gallivm->engine,
                                                     &gallivm->code,
                                                     gallivm->cache,
@@ -279,6 +291,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
                                                     gallivm->memorymgr,
                                                     (unsigned) optlevel,
                                                     &error);
+#endif
       if (ret) {
          _debug_printf("%s\n", error);
          LLVMDisposeMessage(error);
@@ -286,7 +299,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
       }
    }
 
-   if (0) {
+   if (0 && gallivm->engine) {
        /*
         * Dump the data layout strings.
         */
@@ -351,9 +364,11 @@ init_gallivm_state(struct gallivm_state *gallivm, const char *name,
    if (!gallivm->builder)
       goto fail;
 
+#if !GALLIVM_USE_ORCJIT
    gallivm->memorymgr = lp_get_default_memory_manager();
    if (!gallivm->memorymgr)
       goto fail;
+#endif
 
    /* FIXME: MC-JIT only allows compiling one module at a time, and it must be
     * complete when MC-JIT is created. So defer the MC-JIT engine creation for
@@ -418,7 +433,9 @@ lp_build_init(void)
     * component is linked at buildtime, which is sufficient for its static
     * constructors to be called at load time.
     */
+#if !GALLIVM_USE_ORCJIT
    LLVMLinkInMCJIT();
+#endif
 
 #ifdef DEBUG
    gallivm_debug = debug_get_option_gallivm_debug();
@@ -562,6 +579,22 @@ gallivm_verify_function(struct gallivm_state *gallivm,
 }
 
 
+/**
+ * Look up the code of a function of a compiled module.
+ */
+static void *
+get_function_pointer(struct gallivm_state *gallivm, LLVMValueRef func)
+{
+#if GALLIVM_USE_ORCJIT
+   assert(gallivm->jit_module);
+   return lp_jit_module_lookup(gallivm->jit_module, LLVMGetValueName(func));
+#else
+   assert(gallivm->engine);
+   return LLVMGetPointerToGlobal(gallivm->engine, func);
+#endif
+}
+
+
 /**
  * Compile a module.
  * This does IR optimization on all functions in the module.
@@ -656,12 +689,12 @@ gallivm_compile_module(struct gallivm_state *gallivm)
    if (!init_gallivm_engine(gallivm)) {
       assert(0);
    }
-   assert(gallivm->engine);
+   assert(gallivm->engine || gallivm->jit_module);
 
    ++gallivm->compiled;
 
    if (gallivm->debug_printf_hook)
-      LLVMAddGlobalMapping(gallivm->engine, gallivm->debug_printf_hook, debug_printf);
+      gallivm_add_global_mapping(gallivm, gallivm->debug_printf_hook, debug_printf);
 
    if (gallivm_debug & GALLIVM_DEBUG_ASM) {
       LLVMValueRef llvm_func = LLVMGetFirstFunction(gallivm->module);
@@ -673,7 +706,7 @@ gallivm_compile_module(struct gallivm_state *gallivm)
           * LLVMGetPointerToGlobal() will abort otherwise.
           */
          if (!LLVMIsDeclaration(llvm_func)) {
-            void *func_code = LLVMGetPointerToGlobal(gallivm->engine, llvm_func);
+            void *func_code = get_function_pointer(gallivm, llvm_func);
             lp_disassemble(llvm_func, func_code);
          }
          llvm_func = LLVMGetNextFunction(llvm_func);
@@ -686,7 +719,7 @@ gallivm_compile_module(struct gallivm_state *gallivm)
 
       while (llvm_func) {
          if (!LLVMIsDeclaration(llvm_func)) {
-            void *func_code = LLVMGetPointerToGlobal(gallivm->engine, llvm_func);
+            void *func_code = get_function_pointer(gallivm, llvm_func);
             lp_profile(llvm_func, func_code);
          }
          llvm_func = LLVMGetNextFunction(llvm_func);
@@ -706,12 +739,11 @@ gallivm_jit_function(struct gallivm_state *gallivm,
    int64_t time_begin = 0;
 
    assert(gallivm->compiled);
-   assert(gallivm->engine);
 
    if (gallivm_debug & GALLIVM_DEBUG_PERF)
       time_begin = os_time_get();
 
-   code = LLVMGetPointerToGlobal(gallivm->engine, func);
+   code = get_function_pointer(gallivm, func);
    assert(code);
    jit_func = pointer_to_func(code);
 
@@ -729,3 +761,19 @@ unsigned gallivm_get_perf_flags(void)
 {
    return gallivm_perf;
 }
+
+/**
+ * Make calls to the declared function @func resolve to @addr.  Needs to be
+ * done after gallivm_compile_module() and before jitting any function.
+ */
+void
+gallivm_add_global_mapping(struct gallivm_state *gallivm,
+                           LLVMValueRef func, void *addr)
+{
+   assert(gallivm->compiled);
+#if GALLIVM_USE_ORCJIT
+   lp_jit_module_add_symbol(gallivm->jit_module, LLVMGetValueName(func), addr);
+#else
+   LLVMAddGlobalMapping(gallivm->engine, func, addr);
+#endif
+}
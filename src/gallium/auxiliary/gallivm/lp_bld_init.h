@@ -40,11 +40,13 @@ extern "C" {
 #endif
 
 struct lp_cached_code;
+struct lp_jit_module;
 struct gallivm_state
 {
    char *module_name;
    LLVMModuleRef module;
    LLVMExecutionEngineRef engine;
+   struct lp_jit_module *jit_module; /* with GALLIVM_USE_ORCJIT */
    LLVMTargetDataRef target;
    LLVMPassManagerRef passmgr;
    LLVMPassManagerRef cgpassmgr;
@@ -85,6 +87,10 @@ func_pointer
 gallivm_jit_function(struct gallivm_state *gallivm,
                      LLVMValueRef func);
 
+void
+gallivm_add_global_mapping(struct gallivm_state *gallivm,
+                           LLVMValueRef func, void *addr);
+
 unsigned gallivm_get_perf_flags(void);
 
 #ifdef __cplusplus
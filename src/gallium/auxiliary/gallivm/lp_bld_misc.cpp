@@ -91,6 +91,16 @@
 #include "lp_bld_misc.h"
 #include "lp_bld_debug.h"
 
+#if GALLIVM_USE_ORCJIT
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <atomic>
+#endif
+
 namespace {
 
 class LLVMEnsureMultithreaded {
@@ -321,61 +331,11 @@ public:
 };
 
 /**
- * Same as LLVMCreateJITCompilerForModule, but:
- * - allows using MCJIT and enabling AVX feature where available.
- * - set target options
- *
- * See also:
- * - llvm/lib/ExecutionEngine/ExecutionEngineBindings.cpp
- * - llvm/tools/lli/lli.cpp
- * - http://markmail.org/message/ttkuhvgj4cxxy2on#query:+page:1+mid:aju2dggerju3ivd3+state:results
+ * Get the target attributes matching the features of the host CPU.
  */
-extern "C"
-LLVMBool
-lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
-                                        lp_generated_code **OutCode,
-                                        struct lp_cached_code *cache_out,
-                                        LLVMModuleRef M,
-                                        LLVMMCJITMemoryManagerRef CMM,
-                                        unsigned OptLevel,
-                                        char **OutError)
+static void
+lp_get_host_mattrs(llvm::SmallVector<std::string, 16> &MAttrs)
 {
-   using namespace llvm;
-
-   std::string Error;
-   EngineBuilder builder(std::unique_ptr<Module>(unwrap(M)));
-
-   /**
-    * LLVM 3.1+ haven't more "extern unsigned llvm::StackAlignmentOverride" and
-    * friends for configuring code generation options, like stack alignment.
-    */
-   TargetOptions options;
-#if defined(PIPE_ARCH_X86)
-   options.StackAlignmentOverride = 4;
-#endif
-
-   builder.setEngineKind(EngineKind::JIT)
-          .setErrorStr(&Error)
-          .setTargetOptions(options)
-          .setOptLevel((CodeGenOpt::Level)OptLevel);
-
-#ifdef _WIN32
-    /*
-     * MCJIT works on Windows, but currently only through ELF object format.
-     *
-     * XXX: We could use `LLVM_HOST_TRIPLE "-elf"` but LLVM_HOST_TRIPLE has
-     * different strings for MinGW/MSVC, so better play it safe and be
-     * explicit.
-     */
-#  ifdef _WIN64
-    LLVMSetTarget(M, "x86_64-pc-win32-elf");
-#  else
-    LLVMSetTarget(M, "i686-pc-win32-elf");
-#  endif
-#endif
-
-   llvm::SmallVector<std::string, 16> MAttrs;
-
 #if LLVM_VERSION_MAJOR >= 4 && (defined(PIPE_ARCH_X86) || defined(PIPE_ARCH_X86_64) || defined(PIPE_ARCH_ARM))
    /* llvm-3.3+ implements sys::getHostCPUFeatures for Arm
     * and llvm-3.7+ for x86, which allows us to enable/disable
@@ -385,7 +345,7 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
    llvm::StringMap<bool> features;
    llvm::sys::getHostCPUFeatures(features);
 
-   for (StringMapIterator<bool> f = features.begin();
+   for (llvm::StringMapIterator<bool> f = features.begin();
         f != features.end();
         ++f) {
       MAttrs.push_back(((*f).second ? "+" : "-") + (*f).first().str());
@@ -464,8 +424,6 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
 #endif
 #endif
 
-   builder.setMAttrs(MAttrs);
-
    if (gallivm_debug & (GALLIVM_DEBUG_IR | GALLIVM_DEBUG_ASM | GALLIVM_DEBUG_DUMP_BC)) {
       int n = MAttrs.size();
       if (n > 0) {
@@ -475,8 +433,15 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
          debug_printf("\n");
       }
    }
+}
 
-   StringRef MCPU = llvm::sys::getHostCPUName();
+/**
+ * Get the name of the host CPU to generate code for.
+ */
+static std::string
+lp_get_host_mcpu(void)
+{
+   std::string MCPU = llvm::sys::getHostCPUName().str();
    /*
     * The cpu bits are no longer set automatically, so need to set mcpu manually.
     * Note that the MAttrs set above will be sort of ignored (since we should
@@ -491,17 +456,6 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
     */
 
 #ifdef PIPE_ARCH_PPC_64
-   /*
-    * Large programs, e.g. gnome-shell and firefox, may tax the addressability
-    * of the Medium code model once dynamically generated JIT-compiled shader
-    * programs are linked in and relocated.  Yet the default code model as of
-    * LLVM 8 is Medium or even Small.
-    * The cost of changing from Medium to Large is negligible:
-    * - an additional 8-byte pointer stored immediately before the shader entrypoint;
-    * - change an add-immediate (addis) instruction to a load (ld).
-    */
-   builder.setCodeModel(CodeModel::Large);
-
 #if UTIL_ARCH_LITTLE_ENDIAN
    /*
     * Versions of LLVM prior to 4.0 lacked a table entry for "POWER8NVL",
@@ -516,11 +470,101 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
       MCPU = "pwr8";
 #endif
 #endif
-   builder.setMCPU(MCPU);
    if (gallivm_debug & (GALLIVM_DEBUG_IR | GALLIVM_DEBUG_ASM | GALLIVM_DEBUG_DUMP_BC)) {
-      debug_printf("llc -mcpu option: %s\n", MCPU.str().c_str());
+      debug_printf("llc -mcpu option: %s\n", MCPU.c_str());
    }
 
+   return MCPU;
+}
+
+/**
+ * Describe the CPU and features the code is generated for, so that code
+ * cached on disk isn't loaded on a host which can't run it.
+ */
+extern "C" char *
+lp_build_get_host_target_id(void)
+{
+   llvm::SmallVector<std::string, 16> MAttrs;
+   std::string id = lp_get_host_mcpu();
+
+   lp_get_host_mattrs(MAttrs);
+   for (const std::string &attr : MAttrs)
+      id += "," + attr;
+   return strdup(id.c_str());
+}
+
+/**
+ * Same as LLVMCreateJITCompilerForModule, but:
+ * - allows using MCJIT and enabling AVX feature where available.
+ * - set target options
+ *
+ * See also:
+ * - llvm/lib/ExecutionEngine/ExecutionEngineBindings.cpp
+ * - llvm/tools/lli/lli.cpp
+ * - http://markmail.org/message/ttkuhvgj4cxxy2on#query:+page:1+mid:aju2dggerju3ivd3+state:results
+ */
+extern "C"
+LLVMBool
+lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
+                                        lp_generated_code **OutCode,
+                                        struct lp_cached_code *cache_out,
+                                        LLVMModuleRef M,
+                                        LLVMMCJITMemoryManagerRef CMM,
+                                        unsigned OptLevel,
+                                        char **OutError)
+{
+   using namespace llvm;
+
+   std::string Error;
+   EngineBuilder builder(std::unique_ptr<Module>(unwrap(M)));
+
+   /**
+    * LLVM 3.1+ haven't more "extern unsigned llvm::StackAlignmentOverride" and
+    * friends for configuring code generation options, like stack alignment.
+    */
+   TargetOptions options;
+#if defined(PIPE_ARCH_X86)
+   options.StackAlignmentOverride = 4;
+#endif
+
+   builder.setEngineKind(EngineKind::JIT)
+          .setErrorStr(&Error)
+          .setTargetOptions(options)
+          .setOptLevel((CodeGenOpt::Level)OptLevel);
+
+#ifdef _WIN32
+    /*
+     * MCJIT works on Windows, but currently only through ELF object format.
+     *
+     * XXX: We could use `LLVM_HOST_TRIPLE "-elf"` but LLVM_HOST_TRIPLE has
+     * different strings for MinGW/MSVC, so better play it safe and be
+     * explicit.
+     */
+#  ifdef _WIN64
+    LLVMSetTarget(M, "x86_64-pc-win32-elf");
+#  else
+    LLVMSetTarget(M, "i686-pc-win32-elf");
+#  endif
+#endif
+
+   llvm::SmallVector<std::string, 16> MAttrs;
+   lp_get_host_mattrs(MAttrs);
+   builder.setMAttrs(MAttrs);
+
+#ifdef PIPE_ARCH_PPC_64
+   /*
+    * Large programs, e.g. gnome-shell and firefox, may tax the addressability
+    * of the Medium code model once dynamically generated JIT-compiled shader
+    * programs are linked in and relocated.  Yet the default code model as of
+    * LLVM 8 is Medium or even Small.
+    * The cost of changing from Medium to Large is negligible:
+    * - an additional 8-byte pointer stored immediately before the shader entrypoint;
+    * - change an add-immediate (addis) instruction to a load (ld).
+    */
+   builder.setCodeModel(CodeModel::Large);
+#endif
+   builder.setMCPU(lp_get_host_mcpu());
+
    ShaderMemoryManager *MM = NULL;
    BaseMemoryManager* JMM = reinterpret_cast<BaseMemoryManager*>(CMM);
    MM = new ShaderMemoryManager(JMM);
@@ -555,6 +599,195 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
 }
 
 
+#if GALLIVM_USE_ORCJIT
+
+/*
+ * A single ORC LLJIT session is shared by all the gallivm modules of the
+ * process, instead of creating an MCJIT engine and memory manager for each
+ * of them.  Every module is linked into its own JITDylib, so that symbol
+ * names of different shader variants don't clash and the code can be freed
+ * together with the variant.
+ */
+struct lp_jit_module {
+   llvm::orc::JITDylib *dylib;
+};
+
+static std::unique_ptr<llvm::orc::LLJIT> lp_lljit;
+static std::unique_ptr<llvm::orc::JITTargetMachineBuilder> lp_jtmb;
+static std::atomic<unsigned> lp_jit_module_id;
+static once_flag init_lljit_once_flag = ONCE_FLAG_INIT;
+
+static void
+init_lljit(void)
+{
+   using namespace llvm;
+   using namespace llvm::orc;
+
+   lp_set_target_options();
+
+   std::unique_ptr<JITTargetMachineBuilder> jtmb(
+      new JITTargetMachineBuilder(Triple(sys::getProcessTriple())));
+
+#ifdef PIPE_ARCH_PPC_64
+   /* See lp_build_create_jit_compiler_for_module() */
+   jtmb->setCodeModel(CodeModel::Large);
+#endif
+
+   SmallVector<std::string, 16> MAttrs;
+   lp_get_host_mattrs(MAttrs);
+   jtmb->addFeatures(std::vector<std::string>(MAttrs.begin(), MAttrs.end()));
+   jtmb->setCPU(lp_get_host_mcpu());
+
+   Expected<std::unique_ptr<LLJIT>> jit =
+      LLJITBuilder().setJITTargetMachineBuilder(*jtmb).create();
+   if (!jit) {
+      _debug_printf("gallivm: failed to create the ORC JIT: %s\n",
+                    toString(jit.takeError()).c_str());
+      return;
+   }
+
+   lp_lljit = std::move(*jit);
+   lp_jtmb = std::move(jtmb);
+}
+
+/**
+ * Generate the code of @M and add it to the shared JIT session.  Linking
+ * is deferred until the first symbol of the module is looked up, so that
+ * lp_jit_module_add_symbol() can still be used until then.
+ */
+extern "C" int
+lp_build_create_jit_module(struct lp_jit_module **OutModule,
+                           struct lp_cached_code *cache_out,
+                           LLVMModuleRef M,
+                           unsigned OptLevel,
+                           char **OutError)
+{
+   using namespace llvm;
+   using namespace llvm::orc;
+
+   call_once(&init_lljit_once_flag, init_lljit);
+   if (!lp_lljit) {
+      *OutError = strdup("no ORC JIT session");
+      return 1;
+   }
+
+   /* Target machines are not thread-safe, use one per module. */
+   JITTargetMachineBuilder jtmb(*lp_jtmb);
+   jtmb.setCodeGenOptLevel((CodeGenOpt::Level)OptLevel);
+   Expected<std::unique_ptr<TargetMachine>> TM = jtmb.createTargetMachine();
+   if (!TM) {
+      *OutError = strdup(toString(TM.takeError()).c_str());
+      return 1;
+   }
+
+   Module *mod = unwrap(M);
+   mod->setDataLayout((*TM)->createDataLayout());
+   mod->setTargetTriple((*TM)->getTargetTriple().str());
+#if defined(PIPE_ARCH_X86)
+   mod->setOverrideStackAlignment(4);
+#endif
+
+   LPObjectCache *objcache = NULL;
+   if (cache_out) {
+      objcache = new LPObjectCache(cache_out);
+      cache_out->jit_obj_cache = (void *)objcache;
+   }
+
+   SimpleCompiler compile(**TM, objcache);
+   Expected<std::unique_ptr<MemoryBuffer>> obj = compile(*mod);
+   if (!obj) {
+      *OutError = strdup(toString(obj.takeError()).c_str());
+      return 1;
+   }
+
+   std::string name = "gallivm_" + std::to_string(lp_jit_module_id++);
+   Expected<JITDylib &> dylib = lp_lljit->createJITDylib(name);
+   if (!dylib) {
+      *OutError = strdup(toString(dylib.takeError()).c_str());
+      return 1;
+   }
+
+   /* Resolve the calls to libc and libm like MCJIT does. */
+   const DataLayout &DL = lp_lljit->getDataLayout();
+   dylib->addGenerator(cantFail(
+      DynamicLibrarySearchGenerator::GetForCurrentProcess(DL.getGlobalPrefix())));
+
+   /* Objects loaded from the shader cache point into the cached data,
+    * which is freed with the IR, so keep a copy of them.
+    */
+   std::unique_ptr<MemoryBuffer> buffer =
+      MemoryBuffer::getMemBufferCopy((*obj)->getBuffer(), name);
+   if (Error err = lp_lljit->addObjectFile(*dylib, std::move(buffer))) {
+      *OutError = strdup(toString(std::move(err)).c_str());
+      cantFail(dylib->clear());
+      return 1;
+   }
+
+   struct lp_jit_module *module = new lp_jit_module;
+   module->dylib = &*dylib;
+   *OutModule = module;
+   return 0;
+}
+
+extern "C" void
+lp_jit_module_add_symbol(struct lp_jit_module *module,
+                         const char *name, void *addr)
+{
+   using namespace llvm;
+   using namespace llvm::orc;
+
+   SymbolMap symbols;
+   JITSymbolFlags flags = JITSymbolFlags::Exported | JITSymbolFlags::Callable;
+#if LLVM_VERSION_MAJOR >= 17
+   symbols[lp_lljit->mangleAndIntern(name)] =
+      ExecutorSymbolDef(ExecutorAddr::fromPtr(addr), flags);
+#else
+   symbols[lp_lljit->mangleAndIntern(name)] =
+      JITEvaluatedSymbol(pointerToJITTargetAddress(addr), flags);
+#endif
+   if (Error err = module->dylib->define(absoluteSymbols(std::move(symbols))))
+      _debug_printf("gallivm: %s\n", toString(std::move(err)).c_str());
+}
+
+extern "C" void *
+lp_jit_module_lookup(struct lp_jit_module *module, const char *name)
+{
+   using namespace llvm;
+
+   auto sym = lp_lljit->lookup(*module->dylib, name);
+   if (!sym) {
+      _debug_printf("gallivm: %s\n", toString(sym.takeError()).c_str());
+      return NULL;
+   }
+#if LLVM_VERSION_MAJOR >= 15
+   return sym->toPtr<void *>();
+#else
+   return jitTargetAddressToPointer<void *>(sym->getAddress());
+#endif
+}
+
+extern "C" void
+lp_jit_module_destroy(struct lp_jit_module *module)
+{
+   using namespace llvm;
+
+   if (!module)
+      return;
+
+#if LLVM_VERSION_MAJOR >= 14
+   Error err = lp_lljit->getExecutionSession().removeJITDylib(*module->dylib);
+#else
+   /* The empty JITDylib stays around until the session is destroyed. */
+   Error err = module->dylib->clear();
+#endif
+   if (err)
+      _debug_printf("gallivm: %s\n", toString(std::move(err)).c_str());
+   delete module;
+}
+
+#endif /* GALLIVM_USE_ORCJIT */
+
+
 extern "C"
 void
 lp_free_generated_code(struct lp_generated_code *code)
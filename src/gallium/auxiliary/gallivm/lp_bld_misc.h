@@ -64,6 +64,9 @@ gallivm_dispose_target_library_info(LLVMTargetLibraryInfoRef library_info);
 extern void
 lp_set_target_options(void);
 
+extern char *
+lp_build_get_host_target_id(void);
+
 
 extern int
 lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
@@ -77,6 +80,27 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
 extern void
 lp_free_generated_code(struct lp_generated_code *code);
 
+#if GALLIVM_USE_ORCJIT
+struct lp_jit_module;
+
+extern int
+lp_build_create_jit_module(struct lp_jit_module **OutModule,
+                           struct lp_cached_code *cache_out,
+                           LLVMModuleRef M,
+                           unsigned OptLevel,
+                           char **OutError);
+
+extern void
+lp_jit_module_add_symbol(struct lp_jit_module *module,
+                         const char *name, void *addr);
+
+extern void *
+lp_jit_module_lookup(struct lp_jit_module *module, const char *name);
+
+extern void
+lp_jit_module_destroy(struct lp_jit_module *module);
+#endif
+
 extern LLVMMCJITMemoryManagerRef
 lp_get_default_memory_manager();
 
@@ -33,6 +33,24 @@
 
 namespace pipe_tessellator_wrap
 {
+   /// Number of tessellation results kept by each tessellator
+   static const uint32_t PATTERN_CACHE_SIZE = 8;
+
+   /// Tessellation result for one set of tess factors. The domain and the
+   /// partitioning are fixed for a tessellator, so the factors are the key.
+   struct tess_pattern
+   {
+      float    factors[6];
+      uint64_t last_use;
+      uint32_t num_domain_points;
+      uint32_t num_indices;
+      uint32_t max_domain_points;
+      uint32_t max_indices;
+      float    *domain_points_u;
+      float    *domain_points_v;
+      uint32_t *indices;
+   };
+
    /// Wrapper class for the CHWTessellator reference tessellator from MSFT
    /// This class will store data not originally stored in CHWTessellator
    class pipe_ts : private CHWTessellator
@@ -42,7 +60,106 @@ namespace pipe_tessellator_wrap
       enum pipe_prim_type    prim_mode;
       PIPE_ALIGN_VAR(32) float     domain_points_u[MAX_POINT_COUNT];
       PIPE_ALIGN_VAR(32) float     domain_points_v[MAX_POINT_COUNT];
-      uint32_t               num_domain_points;
+      int                    indices[MAX_INDEX_COUNT];
+      bool                   integer_spacing;
+      tess_pattern           patterns[PATTERN_CACHE_SIZE];
+      uint64_t               use_count;
+
+      /// With integer partitioning the tessellator clamps the factors to
+      /// [1, 64] and rounds them up before using them, so only the result
+      /// of that matters. Culled (!(f > 0), NaN included) factors are kept.
+      float QuantizeFactor(float factor) const
+      {
+         if (!integer_spacing || !(factor > 0))
+            return factor;
+         return ceilf(MIN2(MAX2(factor, 1.0f), 64.0f));
+      }
+
+      /// Gather the factors used by the domain. The isoline density isn't
+      /// rounded by the tessellator, so it is never quantized.
+      void GetKey(const struct pipe_tessellation_factors *tess_factors,
+                  float key[6]) const
+      {
+         memset(key, 0, 6 * sizeof(float));
+         switch (prim_mode) {
+         case PIPE_PRIM_QUADS:
+            for (unsigned i = 0; i < 4; i++)
+               key[i] = QuantizeFactor(tess_factors->outer_tf[i]);
+            key[4] = QuantizeFactor(tess_factors->inner_tf[0]);
+            key[5] = QuantizeFactor(tess_factors->inner_tf[1]);
+            break;
+         case PIPE_PRIM_TRIANGLES:
+            for (unsigned i = 0; i < 3; i++)
+               key[i] = QuantizeFactor(tess_factors->outer_tf[i]);
+            key[3] = QuantizeFactor(tess_factors->inner_tf[0]);
+            break;
+         case PIPE_PRIM_LINES:
+            key[0] = tess_factors->outer_tf[0];
+            key[1] = QuantizeFactor(tess_factors->outer_tf[1]);
+            break;
+         default:
+            break;
+         }
+      }
+
+      /// Run the tessellator for @key and copy its result into @pattern
+      void Generate(const float key[6], tess_pattern *pattern)
+      {
+         switch (prim_mode)
+            {
+            case PIPE_PRIM_QUADS:
+               SUPER::TessellateQuadDomain(key[0], key[1], key[2], key[3],
+                                           key[4], key[5]);
+               break;
+
+            case PIPE_PRIM_TRIANGLES:
+               SUPER::TessellateTriDomain(key[0], key[1], key[2], key[3]);
+               break;
+
+            case PIPE_PRIM_LINES:
+               SUPER::TessellateIsoLineDomain(key[0], key[1]);
+               break;
+
+            default:
+               assert(0);
+               return;
+            }
+
+         uint32_t num_domain_points = (uint32_t)SUPER::GetPointCount();
+         uint32_t num_indices = (uint32_t)SUPER::GetIndexCount();
+
+         /* the TES reads whole vectors of domain points, so leave room for
+          * the widest one past the last point */
+         if (num_domain_points > pattern->max_domain_points) {
+            uint32_t max_domain_points = align(num_domain_points, 16);
+            align_free(pattern->domain_points_u);
+            align_free(pattern->domain_points_v);
+            pattern->domain_points_u =
+               (float *)align_malloc(max_domain_points * sizeof(float), 32);
+            pattern->domain_points_v =
+               (float *)align_malloc(max_domain_points * sizeof(float), 32);
+            pattern->max_domain_points = max_domain_points;
+         }
+         if (num_indices > pattern->max_indices) {
+            FREE(pattern->indices);
+            pattern->indices = (uint32_t *)MALLOC(num_indices * sizeof(uint32_t));
+            pattern->max_indices = num_indices;
+         }
+
+         /* the tessellator wrote the points as u and v arrays already */
+         if (num_domain_points) {
+            memcpy(pattern->domain_points_u, domain_points_u,
+                   num_domain_points * sizeof(float));
+            memcpy(pattern->domain_points_v, domain_points_v,
+                   num_domain_points * sizeof(float));
+         }
+         if (num_indices)
+            memcpy(pattern->indices, indices, num_indices * sizeof(uint32_t));
+
+         memcpy(pattern->factors, key, sizeof(pattern->factors));
+         pattern->num_domain_points = num_domain_points;
+         pattern->num_indices = num_indices;
+      }
 
    public:
       void Init(enum pipe_prim_type tes_prim_mode,
@@ -65,61 +182,55 @@ namespace pipe_tessellator_wrap
          else
             out_prim = PIPE_TESSELLATOR_OUTPUT_TRIANGLE_CCW;
 
+         SUPER::SetOutputBuffers(domain_points_u, domain_points_v, indices);
          SUPER::Init(CVT_TS_D3D_PARTITIONING[ts_spacing],
                      out_prim);
 
          prim_mode          = tes_prim_mode;
-         num_domain_points = 0;
+         integer_spacing    = ts_spacing == PIPE_TESS_SPACING_EQUAL;
+         use_count          = 0;
+         memset(patterns, 0, sizeof(patterns));
+      }
+
+      void Destroy()
+      {
+         for (uint32_t i = 0; i < PATTERN_CACHE_SIZE; i++) {
+            align_free(patterns[i].domain_points_u);
+            align_free(patterns[i].domain_points_v);
+            FREE(patterns[i].indices);
+         }
       }
 
       void Tessellate(const struct pipe_tessellation_factors *tess_factors,
                       struct pipe_tessellator_data *tess_data)
       {
-         switch (prim_mode)
-            {
-            case PIPE_PRIM_QUADS:
-               SUPER::TessellateQuadDomain(
-                                           tess_factors->outer_tf[0],
-                                           tess_factors->outer_tf[1],
-                                           tess_factors->outer_tf[2],
-                                           tess_factors->outer_tf[3],
-                                           tess_factors->inner_tf[0],
-                                           tess_factors->inner_tf[1]);
-               break;
+         float key[6];
+         GetKey(tess_factors, key);
 
-            case PIPE_PRIM_TRIANGLES:
-               SUPER::TessellateTriDomain(
-                                          tess_factors->outer_tf[0],
-                                          tess_factors->outer_tf[1],
-                                          tess_factors->outer_tf[2],
-                                          tess_factors->inner_tf[0]);
+         /* Patches of a mesh mostly repeat a few factor sets, look for the
+          * result in the cache before running the tessellator. */
+         tess_pattern *pattern = NULL;
+         for (uint32_t i = 0; i < PATTERN_CACHE_SIZE; i++) {
+            tess_pattern *p = &patterns[i];
+            if (p->last_use && !memcmp(p->factors, key, sizeof(key))) {
+               pattern = p;
                break;
-
-            case PIPE_PRIM_LINES:
-               SUPER::TessellateIsoLineDomain(
-                                              tess_factors->outer_tf[0],
-                                              tess_factors->outer_tf[1]);
-               break;
-
-            default:
-               assert(0);
-               return;
             }
-
-         num_domain_points = (uint32_t)SUPER::GetPointCount();
-
-         DOMAIN_POINT *points = SUPER::GetPoints();
-         for (uint32_t i = 0; i < num_domain_points; i++) {
-            domain_points_u[i] = points[i].u;
-            domain_points_v[i] = points[i].v;
+            if (!pattern || p->last_use < pattern->last_use)
+               pattern = p;
          }
-         tess_data->num_domain_points = num_domain_points;
-         tess_data->domain_points_u = &domain_points_u[0];
-         tess_data->domain_points_v = &domain_points_v[0];
 
-         tess_data->num_indices = (uint32_t)SUPER::GetIndexCount();
+         if (!pattern->last_use ||
+             memcmp(pattern->factors, key, sizeof(key)))
+            Generate(key, pattern);
+         pattern->last_use = ++use_count;
+
+         tess_data->num_domain_points = pattern->num_domain_points;
+         tess_data->domain_points_u = pattern->domain_points_u;
+         tess_data->domain_points_v = pattern->domain_points_v;
 
-         tess_data->indices = (uint32_t*)SUPER::GetIndices();
+         tess_data->num_indices = pattern->num_indices;
+         tess_data->indices = pattern->indices;
       }
    };
 } // namespace Tessellator
@@ -148,6 +259,7 @@ void p_tess_destroy(struct pipe_tessellator *pipe_tess)
    using pipe_tessellator_wrap::pipe_ts;
    pipe_ts *tessellator = (pipe_ts*)pipe_tess;
 
+   tessellator->Destroy();
    tessellator->~pipe_ts();
    align_free(tessellator);
 }
@@ -432,8 +432,10 @@ FXP fxpFloor(const FXP& input)
 //---------------------------------------------------------------------------------------------------------------------------------
 CHWTessellator::CHWTessellator()
 {
-    m_Point = 0;
+    m_PointU = 0;
+    m_PointV = 0;
     m_Index = 0;
+    m_bOwnsOutput = false;
     m_NumPoints = 0;
     m_NumIndices = 0;
     m_bUsingPatchedIndices = false;
@@ -444,8 +446,23 @@ CHWTessellator::CHWTessellator()
 //---------------------------------------------------------------------------------------------------------------------------------
 CHWTessellator::~CHWTessellator()
 {
-    delete [] m_Point;
-    delete [] m_Index;
+    if( m_bOwnsOutput )
+    {
+        delete [] m_PointU;
+        delete [] m_PointV;
+        delete [] m_Index;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------------------
+// CHWTessellator::SetOutputBuffers
+// User calls this.
+//---------------------------------------------------------------------------------------------------------------------------------
+void CHWTessellator::SetOutputBuffers( float* pPointsU, float* pPointsV, int* pIndices )
+{
+    m_PointU = pPointsU;
+    m_PointV = pPointsV;
+    m_Index = pIndices;
 }
 
 //---------------------------------------------------------------------------------------------------------------------------------
@@ -456,13 +473,12 @@ void CHWTessellator::Init(
     PIPE_TESSELLATOR_PARTITIONING       partitioning,
     PIPE_TESSELLATOR_OUTPUT_PRIMITIVE   outputPrimitive)
 {
-    if( 0 == m_Point )
-    {
-        m_Point = new DOMAIN_POINT[MAX_POINT_COUNT];
-    }
-    if( 0 == m_Index )
+    if( 0 == m_PointU )
     {
+        m_PointU = new float[MAX_POINT_COUNT];
+        m_PointV = new float[MAX_POINT_COUNT];
         m_Index = new int[MAX_INDEX_COUNT];
+        m_bOwnsOutput = true;
     }
     m_partitioning = partitioning;
     m_originalPartitioning = partitioning;
@@ -1602,12 +1618,20 @@ int CHWTessellator::GetIndexCount()
 }
 
 //---------------------------------------------------------------------------------------------------------------------------------
-// CHWTessellator::GetPoints()
+// CHWTessellator::GetPointsU()
+// User calls this.
+//---------------------------------------------------------------------------------------------------------------------------------
+float* CHWTessellator::GetPointsU()
+{
+    return m_PointU;
+}
+//---------------------------------------------------------------------------------------------------------------------------------
+// CHWTessellator::GetPointsV()
 // User calls this.
 //---------------------------------------------------------------------------------------------------------------------------------
-DOMAIN_POINT* CHWTessellator::GetPoints()
+float* CHWTessellator::GetPointsV()
 {
-    return m_Point;
+    return m_PointV;
 }
 //---------------------------------------------------------------------------------------------------------------------------------
 // CHWTessellator::GetIndices()
@@ -1626,8 +1650,8 @@ int CHWTessellator::DefinePoint(FXP fxpU, FXP fxpV, int pointStorageOffset)
 //    WCHAR foo[80];
 //    StringCchPrintf(foo,80,L"off:%d, uv=(%f,%f)\n",pointStorageOffset,fixedToFloat(fxpU),fixedToFloat(fxpV));
 //    OutputDebugString(foo);
-    m_Point[pointStorageOffset].u = fixedToFloat(fxpU);
-    m_Point[pointStorageOffset].v = fixedToFloat(fxpV);
+    m_PointU[pointStorageOffset] = fixedToFloat(fxpU);
+    m_PointV[pointStorageOffset] = fixedToFloat(fxpV);
     return pointStorageOffset;
 }
 
@@ -1638,7 +1662,7 @@ void CHWTessellator::DefineIndex(int index, int indexStorageOffset)
 {
     index = PatchIndexValue(index);
 //    WCHAR foo[80];
-//    StringCchPrintf(foo,80,L"off:%d, idx=%d, uv=(%f,%f)\n",indexStorageOffset,index,m_Point[index].u,m_Point[index].v);
+//    StringCchPrintf(foo,80,L"off:%d, idx=%d, uv=(%f,%f)\n",indexStorageOffset,index,m_PointU[index],m_PointV[index]);
 //    OutputDebugString(foo);
     m_Index[indexStorageOffset] = index;
 }
@@ -37,9 +37,13 @@
 //               (3) Call C*Tessellator::Tessellate[IsoLine|Tri|Quad]Domain()
 //                      - Here you pass in TessFactors (how much to tessellate)
 //               (4) Call C*Tessellator::GetPointCount(), C*Tessellator::GetIndexCount() to see how much data was generated.
-//               (5) Call C*Tessellator::GetPoints() and C*Tessellator::GetIndices() to get pointers to the data.
+//               (5) Call C*Tessellator::GetPointsU(), C*Tessellator::GetPointsV() and C*Tessellator::GetIndices()
+//                   to get pointers to the data.  The points are stored as separate u and v arrays, so they can be
+//                   fed to a SIMD domain shader as they are.
 //                   The pointers are fixed for the lifetime of the object (storage for max tessellation),
 //                   so if you ::Tessellate again, the data in the buffers is overwritten.
+//                   Instead of the storage allocated by Init(), the data can be written to caller provided
+//                   buffers of MAX_POINT_COUNT and MAX_INDEX_COUNT elements, see SetOutputBuffers().
 //               (6) There are various other Get() methods to retrieve TessFactors that have been processed from
 //                   what you passed in at step 3.  You can retrieve separate TessFactors that the tessellator
 //                   produced after clamping but before rounding, and also after rounding (say in pow2 mode).
@@ -103,12 +107,6 @@ enum PIPE_TESSELLATOR_OUTPUT_PRIMITIVE
     PIPE_TESSELLATOR_OUTPUT_TRIANGLE_CCW,
 };
 
-typedef struct DOMAIN_POINT
-{
-    float u;
-    float v; // for tri, w = 1 - u - v;
-} DOMAIN_POINT;
-
 //=================================================================================================================================
 // CHWTessellator: D3D11 Tessellation Fixed Function Hardware Reference
 //=================================================================================================================================
@@ -140,11 +138,16 @@ public:
     int GetPointCount();
     int GetIndexCount();
 
-    DOMAIN_POINT* GetPoints(); // Get CHWTessellator owned pointer to vertices (UV values).
+    float* GetPointsU();        // Get CHWTessellator owned pointer to vertex U values.
+                               // Pointer is fixed for lifetime of CHWTessellator object.
+    float* GetPointsV();        // Get CHWTessellator owned pointer to vertex V values (for tri, w = 1 - u - v).
                                // Pointer is fixed for lifetime of CHWTessellator object.
     int* GetIndices();         // Get CHWTessellator owned pointer to vertex indices.
                                // Pointer is fixed for lifetime of CHWTessellator object.
 
+    // Write the output to caller owned storage, call before Init()
+    void SetOutputBuffers( float* pPointsU, float* pPointsV, int* pIndices );
+
     CHWTessellator();
     ~CHWTessellator();
 //---------------------------------------------------------------------------------------------------------------------------------
@@ -178,8 +181,10 @@ private:
     PIPE_TESSELLATOR_PARTITIONING       m_originalPartitioning; // user chosen partitioning
     PIPE_TESSELLATOR_PARTITIONING       m_partitioning; // current partitioning.  IsoLines overrides for line density
     PIPE_TESSELLATOR_OUTPUT_PRIMITIVE   m_outputPrimitive;
-    DOMAIN_POINT*                        m_Point; // array where we will store u/v's for the points we generate
+    float*                               m_PointU; // arrays where we will store u/v's for the points we generate
+    float*                               m_PointV;
     int*                                 m_Index; // array where we will store index topology
+    bool                                 m_bOwnsOutput; // the arrays above were allocated by Init()
     int                                  m_NumPoints;
     int                                  m_NumIndices;
     // PlacePointIn1D below is the workhorse for all position placement.
@@ -386,7 +391,9 @@ public:
     int GetPointCount() {return CHWTessellator::GetPointCount();};
     int GetIndexCount() {return CHWTessellator::GetIndexCount();}
 
-    DOMAIN_POINT* GetPoints() {return CHWTessellator::GetPoints();} // Get CHLSLTessellator owned pointer to vertices (UV values).
+    float* GetPointsU() {return CHWTessellator::GetPointsU();} // Get CHLSLTessellator owned pointer to vertex U values.
+                               // Pointer is fixed for lifetime of CHLSLTessellator object.
+    float* GetPointsV() {return CHWTessellator::GetPointsV();} // Get CHLSLTessellator owned pointer to vertex V values.
                                // Pointer is fixed for lifetime of CHLSLTessellator object.
     int* GetIndices() {return CHWTessellator::GetIndices();}         // Get CHLSLTessellator owned pointer to vertex indices.
                                // Pointer is fixed for lifetime of CHLSLTessellator object.
@@ -32,9 +32,41 @@
 #include "util/hash_table.h"
 #include "util/set.h"
 #include "util/u_inlines.h"
+#include "util/u_memory.h"
 
 #include <dxguids/dxguids.h>
 
+/* A descriptor table written to the batch's heaps, keyed by its kind and
+ * what it was written from. The data follows the struct. */
+struct d3d12_descriptor_table {
+   enum d3d12_descriptor_table_kind kind;
+   unsigned size;
+   const void *data;
+   D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle;
+};
+
+static uint32_t
+hash_descriptor_table(const void *key)
+{
+   const struct d3d12_descriptor_table *table = (const struct d3d12_descriptor_table *)key;
+   return _mesa_hash_data(table->data, table->size) ^ table->kind;
+}
+
+static bool
+equals_descriptor_table(const void *a, const void *b)
+{
+   const struct d3d12_descriptor_table *table_a = (const struct d3d12_descriptor_table *)a;
+   const struct d3d12_descriptor_table *table_b = (const struct d3d12_descriptor_table *)b;
+   return table_a->kind == table_b->kind && table_a->size == table_b->size &&
+          memcmp(table_a->data, table_b->data, table_a->size) == 0;
+}
+
+static void
+delete_descriptor_table(struct hash_entry *entry)
+{
+   FREE(entry->data);
+}
+
 bool
 d3d12_init_batch(struct d3d12_context *ctx, struct d3d12_batch *batch)
 {
@@ -50,7 +82,11 @@ d3d12_init_batch(struct d3d12_context *ctx, struct d3d12_batch *batch)
                                      _mesa_hash_pointer,
                                      _mesa_key_pointer_equal);
 
-   if (!batch->bos || !batch->sampler_views || !batch->surfaces || !batch->objects)
+   batch->descriptor_tables = _mesa_hash_table_create(NULL, hash_descriptor_table,
+                                                      equals_descriptor_table);
+
+   if (!batch->bos || !batch->sampler_views || !batch->surfaces || !batch->objects ||
+       !batch->descriptor_tables)
       return false;
 
    util_dynarray_init(&batch->zombie_samplers, NULL);
@@ -64,13 +100,13 @@ d3d12_init_batch(struct d3d12_context *ctx, struct d3d12_batch *batch)
       d3d12_descriptor_heap_new(screen->dev,
                                 D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER,
                                 D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE,
-                                128);
+                                D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE);
 
    batch->view_heap =
       d3d12_descriptor_heap_new(screen->dev,
                                 D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
                                 D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE,
-                                1024);
+                                16384);
 
    if (!batch->sampler_heap && !batch->view_heap)
       return false;
@@ -130,6 +166,7 @@ d3d12_reset_batch(struct d3d12_context *ctx, struct d3d12_batch *batch, uint64_t
 
    d3d12_descriptor_heap_clear(batch->view_heap);
    d3d12_descriptor_heap_clear(batch->sampler_heap);
+   _mesa_hash_table_clear(batch->descriptor_tables, delete_descriptor_table);
 
    if (FAILED(batch->cmdalloc->Reset())) {
       debug_printf("D3D12: resetting ID3D12CommandAllocator failed\n");
@@ -150,6 +187,7 @@ d3d12_destroy_batch(struct d3d12_context *ctx, struct d3d12_batch *batch)
    _mesa_set_destroy(batch->sampler_views, NULL);
    _mesa_set_destroy(batch->surfaces, NULL);
    _mesa_set_destroy(batch->objects, NULL);
+   _mesa_hash_table_destroy(batch->descriptor_tables, delete_descriptor_table);
    util_dynarray_fini(&batch->zombie_samplers);
 }
 
@@ -195,6 +233,10 @@ d3d12_end_batch(struct d3d12_context *ctx, struct d3d12_batch *batch)
 
    if (!ctx->queries_disabled)
       d3d12_suspend_queries(ctx);
+   d3d12_resolve_queries(ctx);
+
+   /* Split barriers can't span command lists */
+   d3d12_end_split_resource_states(ctx);
 
    if (FAILED(ctx->cmdlist->Close())) {
       debug_printf("D3D12: closing ID3D12GraphicsCommandList failed\n");
@@ -252,3 +294,53 @@ d3d12_batch_reference_object(struct d3d12_batch *batch,
       object->AddRef();
    }
 }
+
+/* Descriptor tables are only looked up within the batch that wrote them,
+ * until its heaps are reset. Views, samplers and resources referenced by
+ * the batch stay alive until then too, so tables written from the same
+ * CPU handles or CBV descriptions have the same contents. */
+bool
+d3d12_batch_find_descriptor_table(struct d3d12_batch *batch,
+                                  enum d3d12_descriptor_table_kind kind,
+                                  const void *data, unsigned size,
+                                  D3D12_GPU_DESCRIPTOR_HANDLE *gpu_handle)
+{
+   struct d3d12_descriptor_table key;
+   key.kind = kind;
+   key.size = size;
+   key.data = data;
+
+   struct hash_entry *entry = _mesa_hash_table_search(batch->descriptor_tables, &key);
+   if (!entry)
+      return false;
+
+   *gpu_handle = ((struct d3d12_descriptor_table *)entry->data)->gpu_handle;
+   return true;
+}
+
+void
+d3d12_batch_add_descriptor_table(struct d3d12_batch *batch,
+                                 enum d3d12_descriptor_table_kind kind,
+                                 const void *data, unsigned size,
+                                 D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle)
+{
+   struct d3d12_descriptor_table *table =
+      (struct d3d12_descriptor_table *)MALLOC(sizeof(*table) + size);
+   if (!table)
+      return;
+
+   memcpy(table + 1, data, size);
+   table->kind = kind;
+   table->size = size;
+   table->data = table + 1;
+   table->gpu_handle = gpu_handle;
+   _mesa_hash_table_insert(batch->descriptor_tables, table, table);
+}
+
+/* Forgets the tables written so far, for when a view was rewritten in place.
+ * They stay in the heaps for the commands already recorded. */
+void
+d3d12_batch_clear_descriptor_tables(struct d3d12_batch *batch)
+{
+   _mesa_hash_table_clear(batch->descriptor_tables, delete_descriptor_table);
+}
@@ -36,8 +36,15 @@
 
 struct d3d12_bo;
 struct d3d12_descriptor_heap;
+struct hash_table;
 struct d3d12_fence;
 
+enum d3d12_descriptor_table_kind {
+   D3D12_DESCRIPTOR_TABLE_CBV, /* keyed by D3D12_CONSTANT_BUFFER_VIEW_DESCs */
+   D3D12_DESCRIPTOR_TABLE_SRV, /* keyed by the views' CPU handles */
+   D3D12_DESCRIPTOR_TABLE_SAMPLER, /* keyed by the samplers' CPU handles */
+};
+
 struct d3d12_batch {
    struct d3d12_fence *fence;
 
@@ -51,6 +58,7 @@ struct d3d12_batch {
    ID3D12CommandAllocator *cmdalloc;
    struct d3d12_descriptor_heap *sampler_heap;
    struct d3d12_descriptor_heap *view_heap;
+   struct hash_table *descriptor_tables; /* tables written to the heaps */
    bool has_errors;
 };
 
@@ -89,4 +97,19 @@ void
 d3d12_batch_reference_object(struct d3d12_batch *batch,
                              ID3D12Object *object);
 
+bool
+d3d12_batch_find_descriptor_table(struct d3d12_batch *batch,
+                                  enum d3d12_descriptor_table_kind kind,
+                                  const void *data, unsigned size,
+                                  D3D12_GPU_DESCRIPTOR_HANDLE *gpu_handle);
+
+void
+d3d12_batch_add_descriptor_table(struct d3d12_batch *batch,
+                                 enum d3d12_descriptor_table_kind kind,
+                                 const void *data, unsigned size,
+                                 D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle);
+
+void
+d3d12_batch_clear_descriptor_tables(struct d3d12_batch *batch);
+
 #endif
@@ -85,7 +85,7 @@ resolve_supported(const struct pipe_blit_info *info)
    if (src->dxgi_format != dst->dxgi_format)
       return false;
 
-   if (util_format_is_pure_integer(src->base.format))
+   if (util_format_is_pure_integer(src->base.b.format))
       return false;
 
    // sizes needs to match
@@ -124,7 +124,7 @@ blit_resolve(struct d3d12_context *ctx, const struct pipe_blit_info *info)
    d3d12_batch_reference_resource(batch, src);
    d3d12_batch_reference_resource(batch, dst);
 
-   DXGI_FORMAT dxgi_format = d3d12_get_resource_srv_format(src->base.format, src->base.target);
+   DXGI_FORMAT dxgi_format = d3d12_get_resource_srv_format(src->base.b.format, src->base.b.target);
 
    assert(src->dxgi_format == dst->dxgi_format);
    ctx->cmdlist->ResolveSubresource(
@@ -271,16 +271,16 @@ copy_subregion_no_barriers(struct d3d12_context *ctx,
    D3D12_TEXTURE_COPY_LOCATION src_loc, dst_loc;
    unsigned src_z = psrc_box->z;
 
-   int src_subres_stride = src->base.last_level + 1;
-   int dst_subres_stride = dst->base.last_level + 1;
+   int src_subres_stride = src->base.b.last_level + 1;
+   int dst_subres_stride = dst->base.b.last_level + 1;
 
-   int src_array_size = src->base.array_size;
-   int dst_array_size = dst->base.array_size;
+   int src_array_size = src->base.b.array_size;
+   int dst_array_size = dst->base.b.array_size;
 
-   if (dst->base.target == PIPE_TEXTURE_CUBE)
+   if (dst->base.b.target == PIPE_TEXTURE_CUBE)
       dst_array_size *= 6;
 
-   if (src->base.target == PIPE_TEXTURE_CUBE)
+   if (src->base.b.target == PIPE_TEXTURE_CUBE)
       src_array_size *= 6;
 
    int stencil_src_res_offset = 1;
@@ -289,16 +289,16 @@ copy_subregion_no_barriers(struct d3d12_context *ctx,
    int src_nres = 1;
    int dst_nres = 1;
 
-   if (dst->base.format == PIPE_FORMAT_Z24_UNORM_S8_UINT ||
-       dst->base.format == PIPE_FORMAT_S8_UINT_Z24_UNORM ||
-       dst->base.format == PIPE_FORMAT_Z32_FLOAT_S8X24_UINT) {
+   if (dst->base.b.format == PIPE_FORMAT_Z24_UNORM_S8_UINT ||
+       dst->base.b.format == PIPE_FORMAT_S8_UINT_Z24_UNORM ||
+       dst->base.b.format == PIPE_FORMAT_Z32_FLOAT_S8X24_UINT) {
       stencil_dst_res_offset = dst_subres_stride * dst_array_size;
       src_nres = 2;
    }
 
-   if (src->base.format == PIPE_FORMAT_Z24_UNORM_S8_UINT ||
-       src->base.format == PIPE_FORMAT_S8_UINT_Z24_UNORM ||
-       dst->base.format == PIPE_FORMAT_Z32_FLOAT_S8X24_UINT) {
+   if (src->base.b.format == PIPE_FORMAT_Z24_UNORM_S8_UINT ||
+       src->base.b.format == PIPE_FORMAT_S8_UINT_Z24_UNORM ||
+       dst->base.b.format == PIPE_FORMAT_Z32_FLOAT_S8X24_UINT) {
       stencil_src_res_offset = src_subres_stride * src_array_size;
       dst_nres = 2;
    }
@@ -313,27 +313,27 @@ copy_subregion_no_barriers(struct d3d12_context *ctx,
          continue;
 
       src_loc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-      src_loc.SubresourceIndex = get_subresource_id(src->base.target, src_level, src_subres_stride, src_z, &src_z) +
+      src_loc.SubresourceIndex = get_subresource_id(src->base.b.target, src_level, src_subres_stride, src_z, &src_z) +
                                  subres * stencil_src_res_offset;
       src_loc.pResource = d3d12_resource_resource(src);
 
       dst_loc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-      dst_loc.SubresourceIndex = get_subresource_id(dst->base.target, dst_level, dst_subres_stride, dstz, &dstz) +
+      dst_loc.SubresourceIndex = get_subresource_id(dst->base.b.target, dst_level, dst_subres_stride, dstz, &dstz) +
                                  subres * stencil_dst_res_offset;
       dst_loc.pResource = d3d12_resource_resource(dst);
 
       if (psrc_box->x == 0 && psrc_box->y == 0 && psrc_box->z == 0 &&
-          psrc_box->width == (int)u_minify(src->base.width0, src_level) &&
-          psrc_box->height == (int)u_minify(src->base.height0, src_level) &&
-          psrc_box->depth == (int)u_minify(src->base.depth0, src_level)) {
+          psrc_box->width == (int)u_minify(src->base.b.width0, src_level) &&
+          psrc_box->height == (int)u_minify(src->base.b.height0, src_level) &&
+          psrc_box->depth == (int)u_minify(src->base.b.depth0, src_level)) {
 
          assert((dstx == 0 && dsty == 0 && dstz == 0) ||
                 screen->opts2.ProgrammableSamplePositionsTier !=
                 D3D12_PROGRAMMABLE_SAMPLE_POSITIONS_TIER_NOT_SUPPORTED ||
-                (!util_format_is_depth_or_stencil(dst->base.format) &&
-                 !util_format_is_depth_or_stencil(src->base.format) &&
-                  dst->base.nr_samples <= 1 &&
-                  src->base.nr_samples <= 1));
+                (!util_format_is_depth_or_stencil(dst->base.b.format) &&
+                 !util_format_is_depth_or_stencil(src->base.b.format) &&
+                  dst->base.b.nr_samples <= 1 &&
+                  src->base.b.nr_samples <= 1));
 
          ctx->cmdlist->CopyTextureRegion(&dst_loc, dstx, dsty, dstz,
                                          &src_loc, NULL);
@@ -341,18 +341,18 @@ copy_subregion_no_barriers(struct d3d12_context *ctx,
       } else {
          D3D12_BOX src_box;
          src_box.left = psrc_box->x;
-         src_box.right = MIN2(psrc_box->x + psrc_box->width, (int)u_minify(src->base.width0, src_level));
+         src_box.right = MIN2(psrc_box->x + psrc_box->width, (int)u_minify(src->base.b.width0, src_level));
          src_box.top = psrc_box->y;
-         src_box.bottom = MIN2(psrc_box->y + psrc_box->height, (int)u_minify(src->base.height0, src_level));
+         src_box.bottom = MIN2(psrc_box->y + psrc_box->height, (int)u_minify(src->base.b.height0, src_level));
          src_box.front = src_z;
          src_box.back = src_z + psrc_box->depth;
 
          assert((screen->opts2.ProgrammableSamplePositionsTier !=
                  D3D12_PROGRAMMABLE_SAMPLE_POSITIONS_TIER_NOT_SUPPORTED ||
-                 (!util_format_is_depth_or_stencil(dst->base.format) &&
-                  !util_format_is_depth_or_stencil(src->base.format))) &&
-                dst->base.nr_samples <= 1 &&
-                src->base.nr_samples <= 1);
+                 (!util_format_is_depth_or_stencil(dst->base.b.format) &&
+                  !util_format_is_depth_or_stencil(src->base.b.format))) &&
+                dst->base.b.nr_samples <= 1 &&
+                src->base.b.nr_samples <= 1);
 
          ctx->cmdlist->CopyTextureRegion(&dst_loc, dstx, dsty, dstz,
                                          &src_loc, &src_box);
@@ -372,11 +372,11 @@ copy_resource_y_flipped_no_barriers(struct d3d12_context *ctx,
 {
    if (D3D12_DEBUG_BLIT & d3d12_debug) {
       debug_printf("D3D12 BLIT as COPY: from %s@%d %dx%dx%d + %dx%dx%d\n",
-                   util_format_name(src->base.format), src_level,
+                   util_format_name(src->base.b.format), src_level,
                    psrc_box->x, psrc_box->y, psrc_box->z,
                    psrc_box->width, psrc_box->height, psrc_box->depth);
       debug_printf("      to   %s@%d %dx%dx%d\n",
-                   util_format_name(dst->base.format), dst_level,
+                   util_format_name(dst->base.b.format), dst_level,
                    pdst_box->x, pdst_box->y, pdst_box->z);
    }
 
@@ -409,9 +409,9 @@ d3d12_direct_copy(struct d3d12_context *ctx,
 {
    struct d3d12_batch *batch = d3d12_current_batch(ctx);
 
-   unsigned src_subres = get_subresource_id(src->base.target, src_level, src->base.last_level + 1,
+   unsigned src_subres = get_subresource_id(src->base.b.target, src_level, src->base.b.last_level + 1,
                                             psrc_box->z, nullptr);
-   unsigned dst_subres = get_subresource_id(dst->base.target, dst_level, dst->base.last_level + 1,
+   unsigned dst_subres = get_subresource_id(dst->base.b.target, dst_level, dst->base.b.last_level + 1,
                                             pdst_box->z, nullptr);
 
    if (D3D12_DEBUG_BLIT & d3d12_debug)
@@ -420,13 +420,13 @@ d3d12_direct_copy(struct d3d12_context *ctx,
 
 
    d3d12_transition_subresources_state(ctx, src, src_subres, 1, 0, 1,
-                                       d3d12_get_format_start_plane(src->base.format),
-                                       d3d12_get_format_num_planes(src->base.format),
+                                       d3d12_get_format_start_plane(src->base.b.format),
+                                       d3d12_get_format_num_planes(src->base.b.format),
                                        D3D12_RESOURCE_STATE_COPY_SOURCE);
 
    d3d12_transition_subresources_state(ctx, dst, dst_subres, 1, 0, 1,
-                                       d3d12_get_format_start_plane(dst->base.format),
-                                       d3d12_get_format_num_planes(dst->base.format),
+                                       d3d12_get_format_start_plane(dst->base.b.format),
+                                       d3d12_get_format_num_planes(dst->base.b.format),
                                        D3D12_RESOURCE_STATE_COPY_DEST);
 
    d3d12_apply_resource_states(ctx);
@@ -434,7 +434,7 @@ d3d12_direct_copy(struct d3d12_context *ctx,
    d3d12_batch_reference_resource(batch, src);
    d3d12_batch_reference_resource(batch, dst);
 
-   if (src->base.target == PIPE_BUFFER) {
+   if (src->base.b.target == PIPE_BUFFER) {
       copy_buffer_region_no_barriers(ctx, dst, pdst_box->x,
                                      src, psrc_box->x, psrc_box->width);
    } else if (psrc_box->height == pdst_box->height) {
@@ -457,6 +457,20 @@ is_same_resource(const struct pipe_blit_info *info)
           info->src.level == info->dst.level;
 }
 
+/* Layers of array textures are subresources of their own, so a copy between
+ * two different layers can be recorded directly.  The copies only transition
+ * the first layer of the box, so this is limited to single layers.
+ */
+static bool
+layers_overlap(enum pipe_texture_target target,
+               int src_z, int src_depth, int dst_z)
+{
+   if (!d3d12_subresource_id_uses_layer(target) || src_depth != 1)
+      return true;
+
+   return src_z == dst_z;
+}
+
 static struct pipe_resource *
 create_staging_resource(struct d3d12_context *ctx,
                         struct d3d12_resource *src,
@@ -476,7 +490,7 @@ create_staging_resource(struct d3d12_context *ctx,
             abs(src_box->width), abs(src_box->height), abs(src_box->depth),
             &copy_src);
 
-   templ.format = src->base.format;
+   templ.format = src->base.b.format;
    templ.width0 = copy_src.width;
    templ.height0 = copy_src.height;
    templ.depth0 = copy_src.depth;
@@ -485,7 +499,7 @@ create_staging_resource(struct d3d12_context *ctx,
    templ.nr_storage_samples = 1;
    templ.usage = PIPE_USAGE_STAGING;
    templ.bind = util_format_is_depth_or_stencil(templ.format) ? PIPE_BIND_DEPTH_STENCIL : PIPE_BIND_RENDER_TARGET;
-   templ.target = src->base.target;
+   templ.target = src->base.b.target;
 
    staging_res = ctx->base.screen->resource_create(ctx->base.screen, &templ);
 
@@ -921,7 +935,11 @@ d3d12_blit(struct pipe_context *pctx,
                    info->alpha_blend ? "blend" : "");
    }
 
-   if (is_same_resource(info))
+   if (is_same_resource(info) &&
+       (layers_overlap(info->src.resource->target, info->src.box.z,
+                       info->src.box.depth, info->dst.box.z) ||
+        !direct_copy_supported(d3d12_screen(pctx->screen), info,
+                               ctx->current_predication != nullptr)))
       blit_same_resource(ctx, info);
    else if (is_resolve(info)) {
       if (resolve_supported(info))
@@ -986,7 +1004,8 @@ d3d12_resource_copy_region(struct pipe_context *pctx,
    }
 
    /* Use an intermediate resource if copying from/to the same subresource */
-   if (d3d12_resource_resource(dst) == d3d12_resource_resource(src) && dst_level == src_level) {
+   if (d3d12_resource_resource(dst) == d3d12_resource_resource(src) && dst_level == src_level &&
+       layers_overlap(psrc->target, psrc_box->z, psrc_box->depth, dstz)) {
       staging_res = create_staging_resource(ctx, src, src_level, psrc_box, &staging_box, PIPE_MASK_RGBAZS);
       src = d3d12_resource(staging_res);
       src_level = 0;
@@ -95,7 +95,9 @@ d3d12_bo_new(ID3D12Device *dev, uint64_t size, const pb_desc *pb_desc)
    D3D12_RESOURCE_DESC res_desc;
    res_desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
    res_desc.Format = DXGI_FORMAT_UNKNOWN;
-   res_desc.Alignment = pb_desc->alignment;
+   /* Buffer resources are always 64KB aligned, which satisfies any
+    * alignment a pb_desc asks for */
+   res_desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
    res_desc.Width = size;
    res_desc.Height = 1;
    res_desc.DepthOrArraySize = 1;
@@ -286,7 +288,7 @@ d3d12_bufmgr_create_buffer(struct pb_manager *pmgr,
    size = align64(size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
 
    pipe_reference_init(&buf->base.reference, 1);
-   buf->base.alignment_log2 = util_logbase2(pb_desc->alignment);
+   buf->base.alignment_log2 = util_logbase2(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
    buf->base.usage = pb_desc->usage;
    buf->base.vtbl = &d3d12_buffer_vtbl;
    buf->base.size = size;
@@ -34,10 +34,15 @@
 #include "nir.h"
 #include "nir/nir_draw_helpers.h"
 #include "nir/tgsi_to_nir.h"
+#include "nir/nir_serialize.h"
 #include "compiler/nir/nir_builder.h"
 #include "tgsi/tgsi_from_mesa.h"
 #include "tgsi/tgsi_ureg.h"
 
+#include "util/blob.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
+#include "util/u_atomic.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
 #include "util/u_simple_shaders.h"
@@ -59,6 +64,7 @@ using Microsoft::WRL::ComPtr;
 struct d3d12_validation_tools
 {
    d3d12_validation_tools();
+   ~d3d12_validation_tools();
 
    bool validate_and_sign(struct blob *dxil);
 
@@ -81,6 +87,9 @@ struct d3d12_validation_tools
    ComPtr<IDxcCompiler> compiler;
    ComPtr<IDxcValidator> validator;
    ComPtr<IDxcLibrary> library;
+
+   /* Compile jobs of the same context may run on different threads */
+   mtx_t lock;
 };
 
 struct d3d12_validation_tools *d3d12_validator_create()
@@ -124,6 +133,20 @@ resource_dimension(enum glsl_sampler_dim dim)
    }
 }
 
+struct d3d12_compile_job {
+   struct d3d12_shader *shader;
+   nir_shader *nir;
+   struct nir_to_dxil_options opts;
+   struct d3d12_validation_tools *validation_tools;
+   struct disk_cache *disk_cache;
+};
+
+static void
+compile_dxil_job(void *data, int thread_index);
+
+static void
+free_compile_job(void *data, int thread_index);
+
 static struct d3d12_shader *
 compile_nir(struct d3d12_context *ctx, struct d3d12_shader_selector *sel,
             struct d3d12_shader_key *key, struct nir_shader *nir)
@@ -162,16 +185,141 @@ compile_nir(struct d3d12_context *ctx, struct d3d12_shader_selector *sel,
    NIR_PASS_V(nir, d3d12_lower_state_vars, shader);
    NIR_PASS_V(nir, d3d12_lower_bool_input);
 
-   struct nir_to_dxil_options opts = {};
-   opts.interpolate_at_vertex = screen->have_load_at_vertex;
-   opts.lower_int16 = !screen->opts4.Native16BitShaderOpsSupported;
-   opts.ubo_binding_offset = shader->has_default_ubo0 ? 0 : 1;
-   opts.provoking_vertex = key->fs.provoking_vertex;
+   /* The rest only produces the DXIL and the binding tables, which aren't
+    * needed before the variant is drawn with, so it runs on the compiler
+    * queue. The variant keeps the NIR, because the keys of the other stages
+    * are computed from it, so the job works on a copy.
+    */
+   struct d3d12_compile_job *job = CALLOC_STRUCT(d3d12_compile_job);
+   job->shader = shader;
+   job->nir = nir_shader_clone(NULL, nir);
+   job->validation_tools = ctx->validation_tools;
+   job->disk_cache = screen->disk_cache;
+   job->opts.interpolate_at_vertex = screen->have_load_at_vertex;
+   job->opts.lower_int16 = !screen->opts4.Native16BitShaderOpsSupported;
+   job->opts.ubo_binding_offset = shader->has_default_ubo0 ? 0 : 1;
+   job->opts.provoking_vertex = key->fs.provoking_vertex;
+
+   util_queue_fence_init(&shader->ready);
+   if (util_queue_is_initialized(&screen->compile_queue)) {
+      util_queue_add_job(&screen->compile_queue, job, &shader->ready,
+                         compile_dxil_job, free_compile_job, 0);
+   } else {
+      compile_dxil_job(job, 0);
+      free_compile_job(job, 0);
+   }
+   return shader;
+}
+
+/* The shader key holds type pointers, which don't survive the process, so
+ * the on-disk cache is keyed by the lowered NIR of the variant instead, which
+ * is all nir_to_dxil gets along with its options.
+ */
+static void
+compute_shader_disk_cache_key(struct d3d12_compile_job *job, cache_key key)
+{
+   struct mesa_sha1 sha1;
+   struct blob nir_blob;
+   bool validated = job->validation_tools != NULL;
+
+   blob_init(&nir_blob);
+   nir_serialize(&nir_blob, job->nir, true);
+
+   _mesa_sha1_init(&sha1);
+   _mesa_sha1_update(&sha1, nir_blob.data, nir_blob.size);
+   _mesa_sha1_update(&sha1, &job->opts, sizeof(job->opts));
+   _mesa_sha1_update(&sha1, &validated, sizeof(validated));
+   _mesa_sha1_final(&sha1, key);
+
+   blob_finish(&nir_blob);
+}
+
+/* Cache entries hold the binding tables that are read from the NIR after
+ * nir_to_dxil, followed by the (validated) DXIL.
+ */
+static bool
+load_cached_shader(struct d3d12_shader *shader, const void *data, size_t size)
+{
+   struct blob_reader reader;
+   blob_reader_init(&reader, data, size);
+
+   shader->num_srv_bindings = blob_read_uint32(&reader);
+   shader->num_cb_bindings = blob_read_uint32(&reader);
+   if (shader->num_srv_bindings > ARRAY_SIZE(shader->srv_bindings) ||
+       shader->num_cb_bindings > ARRAY_SIZE(shader->cb_bindings))
+      return false;
+   blob_copy_bytes(&reader, shader->srv_bindings,
+                   shader->num_srv_bindings * sizeof(shader->srv_bindings[0]));
+   blob_copy_bytes(&reader, shader->cb_bindings,
+                   shader->num_cb_bindings * sizeof(shader->cb_bindings[0]));
+
+   size_t bytecode_length = blob_read_uint32(&reader);
+   const void *bytecode = blob_read_bytes(&reader, bytecode_length);
+   if (reader.overrun || reader.current != reader.end)
+      return false;
+
+   shader->bytecode = malloc(bytecode_length);
+   if (!shader->bytecode)
+      return false;
+   memcpy(shader->bytecode, bytecode, bytecode_length);
+   shader->bytecode_length = bytecode_length;
+   return true;
+}
+
+static void
+store_cached_shader(struct disk_cache *cache, cache_key key,
+                    const struct d3d12_shader *shader)
+{
+   struct blob blob;
+   blob_init(&blob);
+
+   blob_write_uint32(&blob, shader->num_srv_bindings);
+   blob_write_uint32(&blob, shader->num_cb_bindings);
+   blob_write_bytes(&blob, shader->srv_bindings,
+                    shader->num_srv_bindings * sizeof(shader->srv_bindings[0]));
+   blob_write_bytes(&blob, shader->cb_bindings,
+                    shader->num_cb_bindings * sizeof(shader->cb_bindings[0]));
+   blob_write_uint32(&blob, shader->bytecode_length);
+   blob_write_bytes(&blob, shader->bytecode, shader->bytecode_length);
+
+   /* disk_cache_put() copies the blob and writes it from its own thread */
+   if (!blob.out_of_memory)
+      disk_cache_put(cache, key, blob.data, blob.size, NULL);
+   blob_finish(&blob);
+}
+
+static void
+compile_dxil_job(void *data, int thread_index)
+{
+   struct d3d12_compile_job *job = (struct d3d12_compile_job *)data;
+   struct d3d12_shader *shader = job->shader;
+   nir_shader *nir = job->nir;
+   const struct nir_to_dxil_options &opts = job->opts;
+
+   /* A hit skips both the compilation and the validation. Dumping the
+    * shaders needs them compiled though. */
+   cache_key key;
+   bool use_cache = job->disk_cache &&
+                    !(d3d12_debug & (D3D12_DEBUG_DXIL | D3D12_DEBUG_DISASS));
+   if (use_cache) {
+      compute_shader_disk_cache_key(job, key);
+
+      size_t cached_size;
+      void *cached = disk_cache_get(job->disk_cache, key, &cached_size);
+      if (cached) {
+         bool loaded = load_cached_shader(shader, cached, cached_size);
+         free(cached);
+         if (loaded)
+            return;
+         shader->num_srv_bindings = 0;
+         shader->num_cb_bindings = 0;
+      }
+   }
 
    struct blob tmp;
    if (!nir_to_dxil(nir, &opts, &tmp)) {
       debug_printf("D3D12: nir_to_dxil failed\n");
-      return NULL;
+      return;
    }
 
    // Non-ubo variables
@@ -196,26 +344,48 @@ compile_nir(struct d3d12_context *ctx, struct d3d12_shader_selector *sel,
          shader->cb_bindings[shader->num_cb_bindings++].binding = i;
       }
    }
-   if (ctx->validation_tools) {
-      ctx->validation_tools->validate_and_sign(&tmp);
+   bool valid = true;
+   if (job->validation_tools) {
+      /* The validator of a context is shared by all of its jobs */
+      mtx_lock(&job->validation_tools->lock);
+      valid = job->validation_tools->validate_and_sign(&tmp);
 
       if (d3d12_debug & D3D12_DEBUG_DISASS) {
-         ctx->validation_tools->disassemble(&tmp);
+         job->validation_tools->disassemble(&tmp);
       }
+      mtx_unlock(&job->validation_tools->lock);
    }
 
    blob_finish_get_buffer(&tmp, &shader->bytecode, &shader->bytecode_length);
 
+   if (use_cache && valid)
+      store_cached_shader(job->disk_cache, key, shader);
+
    if (d3d12_debug & D3D12_DEBUG_DXIL) {
       char buf[256];
       static int i;
-      snprintf(buf, sizeof(buf), "dump%02d.dxil", i++);
+      snprintf(buf, sizeof(buf), "dump%02d.dxil", p_atomic_inc_return(&i) - 1);
       FILE *fp = fopen(buf, "wb");
       fwrite(shader->bytecode, sizeof(char), shader->bytecode_length, fp);
       fclose(fp);
       fprintf(stderr, "wrote '%s'...\n", buf);
    }
-   return shader;
+}
+
+static void
+free_compile_job(void *data, int thread_index)
+{
+   struct d3d12_compile_job *job = (struct d3d12_compile_job *)data;
+   ralloc_free(job->nir);
+   FREE(job);
+}
+
+/* Waits for the DXIL of a variant, in case it's still being compiled */
+static void
+wait_shader_variant(struct d3d12_shader *shader)
+{
+   util_queue_fence_wait(&shader->ready);
+   assert(shader->bytecode);
 }
 
 struct d3d12_selection_context {
@@ -1130,6 +1300,25 @@ d3d12_select_shader_variants(struct d3d12_context *ctx, const struct pipe_draw_i
 
       select_shader_variant(&sel_ctx, sel, prev, next);
    }
+
+   /* Only the variants that are drawn with need to be ready, the others
+    * keep compiling in the background.
+    */
+   for (unsigned i = 0; i < ARRAY_SIZE(order); ++i) {
+      if (ctx->gfx_stages[order[i]])
+         wait_shader_variant(ctx->gfx_stages[order[i]]->current);
+   }
+}
+
+bool
+d3d12_shader_compile_finished(struct d3d12_shader_selector *sel)
+{
+   for (d3d12_shader *variant = sel->first; variant;
+        variant = variant->next_variant) {
+      if (!util_queue_fence_is_signalled(&variant->ready))
+         return false;
+   }
+   return true;
 }
 
 void
@@ -1137,6 +1326,8 @@ d3d12_shader_free(struct d3d12_shader_selector *sel)
 {
    auto shader = sel->first;
    while (shader) {
+      util_queue_fence_wait(&shader->ready);
+      util_queue_fence_destroy(&shader->ready);
       free(shader->bytecode);
       shader = shader->next_variant;
    }
@@ -1213,6 +1404,13 @@ d3d12_validation_tools::d3d12_validation_tools()
    } else if (d3d12_debug & D3D12_DEBUG_DISASS) {
       debug_printf("D3D12: Disassembly requested but compiler couldn't be loaded\n");
    }
+
+   mtx_init(&lock, mtx_plain);
+}
+
+d3d12_validation_tools::~d3d12_validation_tools()
+{
+   mtx_destroy(&lock);
 }
 
 d3d12_validation_tools::HModule::HModule():
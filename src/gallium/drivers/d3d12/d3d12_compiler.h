@@ -33,6 +33,7 @@
 #include "program/prog_statevars.h"
 
 #include "nir.h"
+#include "util/u_queue.h"
 
 struct pipe_screen;
 
@@ -117,6 +118,8 @@ struct d3d12_shader_key {
 };
 
 struct d3d12_shader {
+   /* signalled once the DXIL and the bindings below are filled in */
+   struct util_queue_fence ready;
    void *bytecode;
    size_t bytecode_length;
 
@@ -189,6 +192,9 @@ d3d12_create_shader(struct d3d12_context *ctx,
 void
 d3d12_shader_free(struct d3d12_shader_selector *shader);
 
+bool
+d3d12_shader_compile_finished(struct d3d12_shader_selector *sel);
+
 void
 d3d12_select_shader_variants(struct d3d12_context *ctx,
                              const struct pipe_draw_info *dinfo);
@@ -41,6 +41,7 @@
 #include "util/u_memory.h"
 #include "util/u_upload_mgr.h"
 #include "util/u_pstipple.h"
+#include "util/u_threaded_context.h"
 #include "util/u_dl.h"
 #include "nir_to_dxil.h"
 
@@ -58,21 +59,28 @@ static void
 d3d12_context_destroy(struct pipe_context *pctx)
 {
    struct d3d12_context *ctx = d3d12_context(pctx);
-   if (ctx->validation_tools)
+   struct d3d12_screen *screen = d3d12_screen(pctx->screen);
+   if (ctx->validation_tools) {
+      /* Pending compile jobs may still use the validator */
+      if (util_queue_is_initialized(&screen->compile_queue))
+         util_queue_finish(&screen->compile_queue);
       d3d12_validator_destroy(ctx->validation_tools);
+   }
 
    if (ctx->timestamp_query)
       pctx->destroy_query(pctx, ctx->timestamp_query);
 
    util_blitter_destroy(ctx->blitter);
    d3d12_end_batch(ctx, d3d12_current_batch(ctx));
-   for (unsigned i = 0; i < ARRAY_SIZE(ctx->batches); ++i)
+   for (unsigned i = 0; i < ctx->num_batches; ++i)
       d3d12_destroy_batch(ctx, &ctx->batches[i]);
+   FREE(ctx->batches);
    ctx->cmdlist->Release();
    ctx->cmdqueue_fence->Release();
    d3d12_descriptor_pool_free(ctx->sampler_pool);
    util_primconvert_destroy(ctx->primconvert);
    slab_destroy_child(&ctx->transfer_pool);
+   slab_destroy_child(&ctx->transfer_pool_unsync);
    d3d12_gs_variant_cache_destroy(ctx);
    d3d12_gfx_pipeline_state_cache_destroy(ctx);
    d3d12_root_signature_cache_destroy(ctx);
@@ -83,6 +91,8 @@ d3d12_context_destroy(struct pipe_context *pctx)
       u_upload_destroy(pctx->stream_uploader);
    if (pctx->const_uploader)
       u_upload_destroy(pctx->const_uploader);
+   if (ctx->transfer_uploader)
+      u_upload_destroy(ctx->transfer_uploader);
 
    delete ctx->resource_state_manager;
 
@@ -787,22 +797,13 @@ component_mapping(enum pipe_swizzle swizzle, D3D12_SHADER_COMPONENT_MAPPING id)
    }
 }
 
-static struct pipe_sampler_view *
-d3d12_create_sampler_view(struct pipe_context *pctx,
-                          struct pipe_resource *texture,
-                          const struct pipe_sampler_view *state)
+void
+d3d12_init_sampler_view_descriptor(struct d3d12_sampler_view *sampler_view)
 {
-   struct d3d12_screen *screen = d3d12_screen(pctx->screen);
+   const struct pipe_sampler_view *state = &sampler_view->base;
+   struct pipe_resource *texture = state->texture;
    struct d3d12_resource *res = d3d12_resource(texture);
-   struct d3d12_sampler_view *sampler_view = CALLOC_STRUCT(d3d12_sampler_view);
-
-   sampler_view->base = *state;
-   sampler_view->base.texture = NULL;
-   pipe_resource_reference(&sampler_view->base.texture, texture);
-   sampler_view->base.reference.count = 1;
-   sampler_view->base.context = pctx;
-   sampler_view->mip_levels = state->u.tex.last_level - state->u.tex.first_level + 1;
-   sampler_view->array_size = texture->array_size;
+   struct d3d12_screen *screen = d3d12_screen(texture->screen);
 
    D3D12_SHADER_RESOURCE_VIEW_DESC desc = {};
    struct d3d12_format_info format_info = d3d12_get_format_info(state->format, state->target);
@@ -909,12 +910,35 @@ d3d12_create_sampler_view(struct pipe_context *pctx,
       unreachable("Invalid SRV dimension");
    }
 
-   mtx_lock(&screen->descriptor_pool_mutex);
-   d3d12_descriptor_pool_alloc_handle(screen->view_pool, &sampler_view->handle);
-   mtx_unlock(&screen->descriptor_pool_mutex);
+   /* When the storage of a buffer was replaced, the view is recreated in
+    * place */
+   if (!sampler_view->handle.cpu_handle.ptr) {
+      mtx_lock(&screen->descriptor_pool_mutex);
+      d3d12_descriptor_pool_alloc_handle(screen->view_pool, &sampler_view->handle);
+      mtx_unlock(&screen->descriptor_pool_mutex);
+   }
 
    screen->dev->CreateShaderResourceView(d3d12_resource_resource(res), &desc,
                                          sampler_view->handle.cpu_handle);
+   sampler_view->texture_generation_id = res->generation_id;
+}
+
+static struct pipe_sampler_view *
+d3d12_create_sampler_view(struct pipe_context *pctx,
+                          struct pipe_resource *texture,
+                          const struct pipe_sampler_view *state)
+{
+   struct d3d12_sampler_view *sampler_view = CALLOC_STRUCT(d3d12_sampler_view);
+
+   sampler_view->base = *state;
+   sampler_view->base.texture = NULL;
+   pipe_resource_reference(&sampler_view->base.texture, texture);
+   sampler_view->base.reference.count = 1;
+   sampler_view->base.context = pctx;
+   sampler_view->mip_levels = state->u.tex.last_level - state->u.tex.first_level + 1;
+   sampler_view->array_size = texture->array_size;
+
+   d3d12_init_sampler_view_descriptor(sampler_view);
 
    return &sampler_view->base;
 }
@@ -1140,7 +1164,7 @@ d3d12_set_vertex_buffers(struct pipe_context *pctx,
       struct d3d12_resource *res = d3d12_resource(buf->buffer.resource);
       ctx->vbvs[i].BufferLocation = d3d12_resource_gpu_virtual_address(res) + buf->buffer_offset;
       ctx->vbvs[i].StrideInBytes = buf->stride;
-      ctx->vbvs[i].SizeInBytes = res->base.width0 - buf->buffer_offset;
+      ctx->vbvs[i].SizeInBytes = res->base.b.width0 - buf->buffer_offset;
    }
    ctx->state_dirty |= D3D12_DIRTY_VERTEX_BUFFERS;
 }
@@ -1240,6 +1264,30 @@ d3d12_set_constant_buffer(struct pipe_context *pctx,
    ctx->shader_dirty[shader] |= D3D12_SHADER_DIRTY_CONSTBUF;
 }
 
+static bool
+is_bound_for_sampling(struct d3d12_context *ctx, struct pipe_resource *pres)
+{
+   for (unsigned stage = 0; stage < PIPE_SHADER_TYPES; ++stage) {
+      for (unsigned i = 0; i < ctx->num_sampler_views[stage]; ++i) {
+         if (ctx->sampler_views[stage][i] &&
+             ctx->sampler_views[stage][i]->texture == pres)
+            return true;
+      }
+   }
+   return false;
+}
+
+static bool
+is_bound_in_framebuffer(const struct pipe_framebuffer_state *state,
+                        struct pipe_resource *pres)
+{
+   for (unsigned i = 0; i < state->nr_cbufs; ++i) {
+      if (state->cbufs[i] && state->cbufs[i]->texture == pres)
+         return true;
+   }
+   return state->zsbuf && state->zsbuf->texture == pres;
+}
+
 static void
 d3d12_set_framebuffer_state(struct pipe_context *pctx,
                             const struct pipe_framebuffer_state *state)
@@ -1247,6 +1295,18 @@ d3d12_set_framebuffer_state(struct pipe_context *pctx,
    struct d3d12_context *ctx = d3d12_context(pctx);
    int samples = -1;
 
+   /* Render targets that are unbound while they're bound for sampling will
+    * most likely be sampled next. Start their transition now, so that it can
+    * overlap whatever is recorded before that draw. */
+   for (unsigned i = 0; i < ctx->fb.nr_cbufs + 1; ++i) {
+      struct pipe_surface *psurf = i < ctx->fb.nr_cbufs ? ctx->fb.cbufs[i] : ctx->fb.zsbuf;
+      if (!psurf || !is_bound_for_sampling(ctx, psurf->texture) ||
+          is_bound_in_framebuffer(state, psurf->texture))
+         continue;
+      d3d12_begin_split_resource_state(ctx, d3d12_resource(psurf->texture),
+                                       D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+   }
+
    util_copy_framebuffer_state(&d3d12_context(pctx)->fb, state);
 
    ctx->gfx_pipeline_state.num_cbufs = state->nr_cbufs;
@@ -1389,6 +1449,45 @@ d3d12_set_stream_output_targets(struct pipe_context *pctx,
    ctx->state_dirty |= D3D12_DIRTY_STREAM_OUTPUT;
 }
 
+/* Called by the threaded context, in the driver thread, when it invalidated
+ * a buffer: dst takes over the storage of the new buffer src.
+ */
+static void
+d3d12_replace_buffer_storage(struct pipe_context *pctx,
+                             struct pipe_resource *pdst,
+                             struct pipe_resource *psrc)
+{
+   struct d3d12_context *ctx = d3d12_context(pctx);
+   struct d3d12_resource *dst = d3d12_resource(pdst);
+   struct d3d12_resource *src = d3d12_resource(psrc);
+
+   /* Batches referencing the old bo keep it alive */
+   d3d12_bo_unreference(dst->bo);
+   dst->bo = src->bo;
+   d3d12_bo_reference(dst->bo);
+   dst->generation_id++;
+
+   /* CBVs and the index buffer view are created at draw time, but the views
+    * below captured the GPU address of the old storage. Buffer sampler views
+    * are recreated once they see the new generation_id. */
+   for (unsigned i = 0; i < ctx->num_vbs; ++i) {
+      const struct pipe_vertex_buffer *buf = ctx->vbs + i;
+      if (buf->buffer.resource != pdst)
+         continue;
+      ctx->vbvs[i].BufferLocation = d3d12_resource_gpu_virtual_address(dst) + buf->buffer_offset;
+      ctx->state_dirty |= D3D12_DIRTY_VERTEX_BUFFERS;
+   }
+
+   for (unsigned i = 0; i < ctx->gfx_pipeline_state.num_so_targets; ++i) {
+      struct d3d12_stream_output_target *target =
+         (struct d3d12_stream_output_target *)ctx->so_targets[i];
+      if (!target || (target->base.buffer != pdst && target->fill_buffer != pdst))
+         continue;
+      fill_stream_output_buffer_view(&ctx->so_buffer_views[i], target);
+      ctx->state_dirty |= D3D12_DIRTY_STREAM_OUTPUT;
+   }
+}
+
 bool
 d3d12_enable_fake_so_buffers(struct d3d12_context *ctx, unsigned factor)
 {
@@ -1506,27 +1605,66 @@ d3d12_disable_fake_so_buffers(struct d3d12_context *ctx)
    return true;
 }
 
+/* Inserts a new batch at idx, moving the batches from idx on up by one.
+ * This moves the batches in memory, so pointers to them become invalid,
+ * but the ones before idx keep their index. */
+static bool
+insert_batch(struct d3d12_context *ctx, unsigned idx)
+{
+   struct d3d12_batch *batches =
+      (struct d3d12_batch *)REALLOC(ctx->batches,
+                                    ctx->num_batches * sizeof(struct d3d12_batch),
+                                    (ctx->num_batches + 1) * sizeof(struct d3d12_batch));
+   if (!batches)
+      return false;
+   ctx->batches = batches;
+
+   memmove(&batches[idx + 1], &batches[idx],
+           (ctx->num_batches - idx) * sizeof(struct d3d12_batch));
+   memset(&batches[idx], 0, sizeof(struct d3d12_batch));
+   if (!d3d12_init_batch(ctx, &batches[idx])) {
+      memmove(&batches[idx], &batches[idx + 1],
+              (ctx->num_batches - idx) * sizeof(struct d3d12_batch));
+      return false;
+   }
+
+   ctx->num_batches++;
+   return true;
+}
+
 void
 d3d12_flush_cmdlist(struct d3d12_context *ctx)
 {
    d3d12_end_batch(ctx, d3d12_current_batch(ctx));
 
-   ctx->current_batch_idx++;
-   if (ctx->current_batch_idx == ARRAY_SIZE(ctx->batches))
-      ctx->current_batch_idx = 0;
+   unsigned next = ctx->current_batch_idx + 1;
+   if (next == ctx->num_batches)
+      next = 0;
+
+   /* If the oldest batch is still in flight, add one in front of it rather
+    * than waiting for the GPU. When wrapping around, the new one goes at the
+    * end, so that the batches before it don't move. */
+   struct d3d12_batch *oldest = &ctx->batches[next];
+   if (oldest->fence && !d3d12_fence_finish(oldest->fence, 0) &&
+       ctx->num_batches < ctx->max_batches) {
+      unsigned idx = next ? next : ctx->num_batches;
+      if (insert_batch(ctx, idx))
+         next = idx;
+   }
 
+   ctx->current_batch_idx = next;
    d3d12_start_batch(ctx, d3d12_current_batch(ctx));
 }
 
 void
 d3d12_flush_cmdlist_and_wait(struct d3d12_context *ctx)
 {
-   struct d3d12_batch *batch = d3d12_current_batch(ctx);
+   unsigned batch_idx = ctx->current_batch_idx;
 
    d3d12_foreach_submitted_batch(ctx, old_batch)
       d3d12_reset_batch(ctx, old_batch, PIPE_TIMEOUT_INFINITE);
    d3d12_flush_cmdlist(ctx);
-   d3d12_reset_batch(ctx, batch, PIPE_TIMEOUT_INFINITE);
+   d3d12_reset_batch(ctx, &ctx->batches[batch_idx], PIPE_TIMEOUT_INFINITE);
 }
 
 void
@@ -1548,13 +1686,20 @@ d3d12_transition_subresources_state(struct d3d12_context *ctx,
 {
    TransitionableResourceState *xres = d3d12_resource_state(res);
 
+   /* Keep the resource tracked as a whole when all of it is transitioned */
+   if (start_level == 0 && start_layer == 0 && start_plane == 0 &&
+       num_levels * num_layers * num_planes == xres->NumSubresources()) {
+      ctx->resource_state_manager->TransitionResource(xres, state);
+      return;
+   }
+
    for (uint32_t l = 0; l < num_levels; l++) {
       const uint32_t level = start_level + l;
       for (uint32_t a = 0; a < num_layers; a++) {
          const uint32_t layer = start_layer + a;
          for( uint32_t p = 0; p < num_planes; p++) {
             const uint32_t plane = start_plane + p;
-            uint32_t subres_id = level + (layer * res->mip_levels) + plane * (res->mip_levels * res->base.array_size);
+            uint32_t subres_id = level + (layer * res->mip_levels) + plane * (res->mip_levels * res->base.b.array_size);
             assert(subres_id < xres->NumSubresources());
             ctx->resource_state_manager->TransitionSubresource(xres, subres_id, state);
          }
@@ -1568,6 +1713,26 @@ d3d12_apply_resource_states(struct d3d12_context *ctx)
    ctx->resource_state_manager->ApplyAllResourceTransitions(ctx->cmdlist, ctx->fence_value);
 }
 
+bool
+d3d12_begin_split_resource_state(struct d3d12_context *ctx,
+                                 struct d3d12_resource *res,
+                                 D3D12_RESOURCE_STATES state)
+{
+   TransitionableResourceState *xres = d3d12_resource_state(res);
+   if (!ctx->resource_state_manager->BeginSplitTransition(ctx->cmdlist, xres, state,
+                                                          ctx->fence_value))
+      return false;
+
+   d3d12_batch_reference_resource(d3d12_current_batch(ctx), res);
+   return true;
+}
+
+void
+d3d12_end_split_resource_states(struct d3d12_context *ctx)
+{
+   ctx->resource_state_manager->EndSplitTransitions(ctx->cmdlist, ctx->fence_value);
+}
+
 static void
 d3d12_clear_render_target(struct pipe_context *pctx,
                           struct pipe_surface *psurf,
@@ -1692,12 +1857,12 @@ d3d12_flush(struct pipe_context *pipe,
             unsigned flags)
 {
    struct d3d12_context *ctx = d3d12_context(pipe);
-   struct d3d12_batch *batch = d3d12_current_batch(ctx);
+   unsigned batch_idx = ctx->current_batch_idx;
 
    d3d12_flush_cmdlist(ctx);
 
    if (fence)
-      d3d12_fence_reference((struct d3d12_fence **)fence, batch->fence);
+      d3d12_fence_reference((struct d3d12_fence **)fence, ctx->batches[batch_idx].fence);
 }
 
 static void
@@ -1747,6 +1912,9 @@ d3d12_get_timestamp(struct pipe_context *pctx)
    return result.u64;
 }
 
+/* Number of batches that can be in flight before flushing waits for the GPU */
+DEBUG_GET_ONCE_NUM_OPTION(d3d12_max_batches, "D3D12_MAX_BATCHES_IN_FLIGHT", 16)
+
 struct pipe_context *
 d3d12_context_create(struct pipe_screen *pscreen, void *priv, unsigned flags)
 {
@@ -1830,9 +1998,12 @@ d3d12_context_create(struct pipe_screen *pscreen, void *priv, unsigned flags)
 
 
    slab_create_child(&ctx->transfer_pool, &d3d12_screen(pscreen)->transfer_pool);
+   slab_create_child(&ctx->transfer_pool_unsync, &d3d12_screen(pscreen)->transfer_pool);
 
    ctx->base.stream_uploader = u_upload_create_default(&ctx->base);
    ctx->base.const_uploader = u_upload_create_default(&ctx->base);
+   ctx->transfer_uploader = u_upload_create(&ctx->base, 1024 * 1024, 0,
+                                            PIPE_USAGE_STREAM, 0);
    u_suballocator_init(&ctx->so_allocator, &ctx->base, 4096, 0,
                        PIPE_USAGE_DEFAULT,
                        0, true);
@@ -1868,7 +2039,14 @@ d3d12_context_create(struct pipe_screen *pscreen, void *priv, unsigned flags)
       return NULL;
    }
 
-   for (unsigned i = 0; i < ARRAY_SIZE(ctx->batches); ++i) {
+   ctx->max_batches = MAX2(debug_get_option_d3d12_max_batches(), 1);
+   ctx->num_batches = MIN2(ctx->max_batches, 2);
+   ctx->batches = (struct d3d12_batch *)CALLOC(ctx->num_batches, sizeof(struct d3d12_batch));
+   if (!ctx->batches) {
+      FREE(ctx);
+      return NULL;
+   }
+   for (unsigned i = 0; i < ctx->num_batches; ++i) {
       if (!d3d12_init_batch(ctx, &ctx->batches[i])) {
          FREE(ctx);
          return NULL;
@@ -1899,7 +2077,14 @@ d3d12_context_create(struct pipe_screen *pscreen, void *priv, unsigned flags)
       return NULL;
    }
 
-   return &ctx->base;
+   if (!(flags & PIPE_CONTEXT_PREFER_THREADED) || flags & PIPE_CONTEXT_COMPUTE_ONLY)
+      return &ctx->base;
+
+   /* Without a create_fence callback, the threaded context syncs on deferred
+    * flushes that ask for a fence. */
+   return threaded_context_create(&ctx->base, &screen->transfer_pool,
+                                  d3d12_replace_buffer_storage,
+                                  NULL, NULL);
 }
 
 bool
@@ -113,6 +113,7 @@ struct d3d12_sampler_view {
    struct d3d12_descriptor_handle handle;
    unsigned mip_levels;
    unsigned array_size;
+   unsigned texture_generation_id;
    unsigned swizzle_override_r:3;         /**< PIPE_SWIZZLE_x for red component */
    unsigned swizzle_override_g:3;         /**< PIPE_SWIZZLE_x for green component */
    unsigned swizzle_override_b:3;         /**< PIPE_SWIZZLE_x for blue component */
@@ -148,15 +149,22 @@ class ResourceStateManager;
 struct d3d12_context {
    struct pipe_context base;
    struct slab_child_pool transfer_pool;
+   struct slab_child_pool transfer_pool_unsync;
    struct primconvert_context *primconvert;
    struct blitter_context *blitter;
    struct u_suballocator query_allocator;
+   struct u_upload_mgr *transfer_uploader;
    struct u_suballocator so_allocator;
    struct hash_table *pso_cache;
    struct hash_table *root_signature_cache;
    struct hash_table *gs_variant_cache;
 
-   struct d3d12_batch batches[4];
+   /* Ring of batches, oldest submitted first after the current one. It is
+    * grown up to max_batches instead of waiting for the oldest one to
+    * finish, see d3d12_flush_cmdlist(). */
+   struct d3d12_batch *batches;
+   unsigned num_batches;
+   unsigned max_batches;
    unsigned current_batch_idx;
 
    struct pipe_constant_buffer cbufs[PIPE_SHADER_TYPES][PIPE_MAX_CONSTANT_BUFFERS];
@@ -212,6 +220,7 @@ struct d3d12_context {
    ID3D12GraphicsCommandList *cmdlist;
 
    struct list_head active_queries;
+   struct list_head unresolved_queries;
    bool queries_disabled;
 
    struct d3d12_descriptor_pool *sampler_pool;
@@ -242,17 +251,17 @@ d3d12_context(struct pipe_context *context)
 static inline struct d3d12_batch *
 d3d12_current_batch(struct d3d12_context *ctx)
 {
-   assert(ctx->current_batch_idx < ARRAY_SIZE(ctx->batches));
+   assert(ctx->current_batch_idx < ctx->num_batches);
    return ctx->batches + ctx->current_batch_idx;
 }
 
 #define d3d12_foreach_submitted_batch(ctx, batch) \
-   unsigned oldest = (ctx->current_batch_idx + 1) % ARRAY_SIZE(ctx->batches); \
+   unsigned oldest = (ctx->current_batch_idx + 1) % ctx->num_batches; \
    while (ctx->batches[oldest].fence == NULL && oldest != ctx->current_batch_idx) \
-      oldest = (oldest + 1) % ARRAY_SIZE(ctx->batches); \
+      oldest = (oldest + 1) % ctx->num_batches; \
    struct d3d12_batch *batch = &ctx->batches[oldest]; \
    for (; oldest != ctx->current_batch_idx; \
-        oldest = (oldest + 1) % ARRAY_SIZE(ctx->batches), \
+        oldest = (oldest + 1) % ctx->num_batches, \
         batch = &ctx->batches[oldest])
 
 struct pipe_context *
@@ -287,6 +296,14 @@ d3d12_transition_subresources_state(struct d3d12_context *ctx,
 void
 d3d12_apply_resource_states(struct d3d12_context* ctx);
 
+bool
+d3d12_begin_split_resource_state(struct d3d12_context *ctx,
+                                 struct d3d12_resource *res,
+                                 D3D12_RESOURCE_STATES state);
+
+void
+d3d12_end_split_resource_states(struct d3d12_context *ctx);
+
 void
 d3d12_draw_vbo(struct pipe_context *pctx,
                const struct pipe_draw_info *dinfo,
@@ -304,4 +321,7 @@ d3d12_context_query_init(struct pipe_context *pctx);
 bool
 d3d12_need_zero_one_depth_range(struct d3d12_context *ctx);
 
+void
+d3d12_init_sampler_view_descriptor(struct d3d12_sampler_view *sampler_view);
+
 #endif
@@ -53,14 +53,16 @@ fill_cbv_descriptors(struct d3d12_context *ctx,
                      int stage)
 {
    struct d3d12_batch *batch = d3d12_current_batch(ctx);
-   struct d3d12_descriptor_handle table_start;
-   d2d12_descriptor_heap_get_next_handle(batch->view_heap, &table_start);
+   D3D12_CONSTANT_BUFFER_VIEW_DESC cbv_descs[PIPE_MAX_CONSTANT_BUFFERS];
+   unsigned size = shader->num_cb_bindings * sizeof(cbv_descs[0]);
 
    for (unsigned i = 0; i < shader->num_cb_bindings; i++) {
       unsigned binding = shader->cb_bindings[i].binding;
       struct pipe_constant_buffer *buffer = &ctx->cbufs[stage][binding];
 
-      D3D12_CONSTANT_BUFFER_VIEW_DESC cbv_desc = {};
+      /* cleared with memset, the descs are compared with memcmp */
+      D3D12_CONSTANT_BUFFER_VIEW_DESC &cbv_desc = cbv_descs[i];
+      memset(&cbv_desc, 0, sizeof(cbv_desc));
       if (buffer && buffer->buffer) {
          struct d3d12_resource *res = d3d12_resource(buffer->buffer);
          d3d12_transition_resource_state(ctx, res, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
@@ -69,12 +71,46 @@ fill_cbv_descriptors(struct d3d12_context *ctx,
             align(buffer->buffer_size, 256));
          d3d12_batch_reference_resource(batch, res);
       }
+   }
+
+   D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle;
+   if (d3d12_batch_find_descriptor_table(batch, D3D12_DESCRIPTOR_TABLE_CBV,
+                                         cbv_descs, size, &gpu_handle))
+      return gpu_handle;
+
+   struct d3d12_descriptor_handle table_start;
+   d2d12_descriptor_heap_get_next_handle(batch->view_heap, &table_start);
 
+   for (unsigned i = 0; i < shader->num_cb_bindings; i++) {
       struct d3d12_descriptor_handle handle;
       d3d12_descriptor_heap_alloc_handle(batch->view_heap, &handle);
-      d3d12_screen(ctx->base.screen)->dev->CreateConstantBufferView(&cbv_desc, handle.cpu_handle);
+      d3d12_screen(ctx->base.screen)->dev->CreateConstantBufferView(&cbv_descs[i], handle.cpu_handle);
    }
 
+   d3d12_batch_add_descriptor_table(batch, D3D12_DESCRIPTOR_TABLE_CBV,
+                                    cbv_descs, size, table_start.gpu_handle);
+   return table_start.gpu_handle;
+}
+
+/* Copies a table of descriptors to the batch's heap, unless the batch
+ * already has a table with the same ones. */
+static D3D12_GPU_DESCRIPTOR_HANDLE
+append_descriptor_table(struct d3d12_batch *batch,
+                        struct d3d12_descriptor_heap *heap,
+                        enum d3d12_descriptor_table_kind kind,
+                        D3D12_CPU_DESCRIPTOR_HANDLE *descs,
+                        unsigned num_descs)
+{
+   unsigned size = num_descs * sizeof(descs[0]);
+   D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle;
+   if (d3d12_batch_find_descriptor_table(batch, kind, descs, size, &gpu_handle))
+      return gpu_handle;
+
+   struct d3d12_descriptor_handle table_start;
+   d2d12_descriptor_heap_get_next_handle(heap, &table_start);
+   d3d12_descriptor_heap_append_handles(heap, descs, num_descs);
+
+   d3d12_batch_add_descriptor_table(batch, kind, descs, size, table_start.gpu_handle);
    return table_start.gpu_handle;
 }
 
@@ -86,9 +122,6 @@ fill_srv_descriptors(struct d3d12_context *ctx,
    struct d3d12_batch *batch = d3d12_current_batch(ctx);
    struct d3d12_screen *screen = d3d12_screen(ctx->base.screen);
    D3D12_CPU_DESCRIPTOR_HANDLE descs[PIPE_MAX_SHADER_SAMPLER_VIEWS];
-   struct d3d12_descriptor_handle table_start;
-
-   d2d12_descriptor_heap_get_next_handle(batch->view_heap, &table_start);
 
    for (unsigned i = 0; i < shader->num_srv_bindings; i++)
    {
@@ -102,6 +135,12 @@ fill_srv_descriptors(struct d3d12_context *ctx,
       }
 
       if (view != NULL) {
+         /* The storage of the buffer was replaced since the view was created */
+         if (view->texture_generation_id != d3d12_resource(view->base.texture)->generation_id) {
+            d3d12_init_sampler_view_descriptor(view);
+            d3d12_batch_clear_descriptor_tables(batch);
+         }
+
          descs[i] = view->handle.cpu_handle ;
          d3d12_batch_reference_sampler_view(batch, view);
 
@@ -124,9 +163,8 @@ fill_srv_descriptors(struct d3d12_context *ctx,
       }
    }
 
-   d3d12_descriptor_heap_append_handles(batch->view_heap, descs, shader->num_srv_bindings);
-
-   return table_start.gpu_handle;
+   return append_descriptor_table(batch, batch->view_heap, D3D12_DESCRIPTOR_TABLE_SRV,
+                                  descs, shader->num_srv_bindings);
 }
 
 static D3D12_GPU_DESCRIPTOR_HANDLE
@@ -137,9 +175,6 @@ fill_sampler_descriptors(struct d3d12_context *ctx,
    const struct d3d12_shader *shader = shader_sel->current;
    struct d3d12_batch *batch = d3d12_current_batch(ctx);
    D3D12_CPU_DESCRIPTOR_HANDLE descs[PIPE_MAX_SHADER_SAMPLER_VIEWS];
-   struct d3d12_descriptor_handle table_start;
-
-   d2d12_descriptor_heap_get_next_handle(batch->sampler_heap, &table_start);
 
    for (unsigned i = 0; i < shader->num_srv_bindings; i++)
    {
@@ -161,8 +196,8 @@ fill_sampler_descriptors(struct d3d12_context *ctx,
          descs[i] = ctx->null_sampler.cpu_handle;
    }
 
-   d3d12_descriptor_heap_append_handles(batch->sampler_heap, descs, shader->num_srv_bindings);
-   return table_start.gpu_handle;
+   return append_descriptor_table(batch, batch->sampler_heap, D3D12_DESCRIPTOR_TABLE_SAMPLER,
+                                  descs, shader->num_srv_bindings);
 }
 
 static unsigned
@@ -376,7 +411,7 @@ transition_surface_subresources_state(struct d3d12_context *ctx,
 {
    struct d3d12_resource *res = d3d12_resource(pres);
    unsigned start_layer, num_layers;
-   if (!d3d12_subresource_id_uses_layer(res->base.target)) {
+   if (!d3d12_subresource_id_uses_layer(res->base.b.target)) {
       start_layer = 0;
       num_layers = 1;
    } else {
@@ -636,7 +671,7 @@ d3d12_draw_vbo(struct pipe_context *pctx,
       D3D12_INDEX_BUFFER_VIEW ibv;
       struct d3d12_resource *res = d3d12_resource(index_buffer);
       ibv.BufferLocation = d3d12_resource_gpu_virtual_address(res) + index_offset;
-      ibv.SizeInBytes = res->base.width0 - index_offset;
+      ibv.SizeInBytes = res->base.b.width0 - index_offset;
       ibv.Format = ib_format(dinfo->index_size);
       d3d12_transition_resource_state(ctx, res, D3D12_RESOURCE_STATE_INDEX_BUFFER);
       if (ctx->cmdlist_dirty & D3D12_DIRTY_INDEX_BUFFER ||
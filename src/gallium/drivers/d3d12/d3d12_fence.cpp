@@ -27,6 +27,7 @@
 #include "d3d12_screen.h"
 
 #include "util/u_memory.h"
+#include "util/u_threaded_context.h"
 
 #ifdef _WIN32
 static void
@@ -79,7 +80,6 @@ wait_event(HANDLE event, int event_fd, uint64_t timeout_ns)
 static void
 destroy_fence(struct d3d12_fence *fence)
 {
-   close_event(fence->event, fence->event_fd);
    FREE(fence);
 }
 
@@ -92,20 +92,16 @@ d3d12_create_fence(struct d3d12_screen *screen, struct d3d12_context *ctx)
       return NULL;
    }
 
+   ret->screen = screen;
    ret->cmdqueue_fence = ctx->cmdqueue_fence;
    ret->value = ++ctx->fence_value;
-   ret->event = create_event(&ret->event_fd);
-   if (FAILED(ctx->cmdqueue_fence->SetEventOnCompletion(ret->value, ret->event)))
-      goto fail;
-   if (FAILED(screen->cmdqueue->Signal(ctx->cmdqueue_fence, ret->value)))
-      goto fail;
+   if (FAILED(screen->cmdqueue->Signal(ctx->cmdqueue_fence, ret->value))) {
+      destroy_fence(ret);
+      return NULL;
+   }
 
    pipe_reference_init(&ret->reference, 1);
    return ret;
-
-fail:
-   destroy_fence(ret);
-   return NULL;
 }
 
 void
@@ -132,8 +128,25 @@ d3d12_fence_finish(struct d3d12_fence *fence, uint64_t timeout_ns)
       return true;
    
    bool complete = fence->cmdqueue_fence->GetCompletedValue() >= fence->value;
-   if (!complete && timeout_ns)
-      complete = wait_event(fence->event, fence->event_fd, timeout_ns);
+   if (!complete && timeout_ns == PIPE_TIMEOUT_INFINITE) {
+      /* Infinite waits are serialized on the screen's event, so only one
+       * value is ever pending on it. */
+      struct d3d12_screen *screen = fence->screen;
+      mtx_lock(&screen->fence_wait_mutex);
+      if (SUCCEEDED(fence->cmdqueue_fence->SetEventOnCompletion(fence->value,
+                                                               screen->fence_event)))
+         complete = wait_event(screen->fence_event, screen->fence_event_fd,
+                               timeout_ns);
+      mtx_unlock(&screen->fence_wait_mutex);
+   } else if (!complete && timeout_ns) {
+      /* A wait that may time out leaves the value pending on its event, so it
+       * can't be shared. */
+      int event_fd;
+      HANDLE event = create_event(&event_fd);
+      if (SUCCEEDED(fence->cmdqueue_fence->SetEventOnCompletion(fence->value, event)))
+         complete = wait_event(event, event_fd, timeout_ns);
+      close_event(event, event_fd);
+   }
 
    fence->signaled = complete;
    return complete;
@@ -145,9 +158,17 @@ fence_finish(struct pipe_screen *pscreen, struct pipe_context *pctx,
 {
    bool ret = d3d12_fence_finish(d3d12_fence(pfence), timeout_ns);
    if (ret && pctx) {
+      pctx = threaded_context_unwrap_sync(pctx);
       struct d3d12_context *ctx = d3d12_context(pctx);
-      d3d12_foreach_submitted_batch(ctx, batch)
+
+      /* Batches are submitted in order, poll the timeline once for all of
+       * them. */
+      uint64_t completed = ctx->cmdqueue_fence->GetCompletedValue();
+      d3d12_foreach_submitted_batch(ctx, batch) {
+         if (batch->fence && batch->fence->value <= completed)
+            batch->fence->signaled = true;
          d3d12_reset_batch(ctx, batch, 0);
+      }
    }
    return ret;
 }
@@ -155,6 +176,20 @@ fence_finish(struct pipe_screen *pscreen, struct pipe_context *pctx,
 void
 d3d12_screen_fence_init(struct pipe_screen *pscreen)
 {
+   struct d3d12_screen *screen = d3d12_screen(pscreen);
+
    pscreen->fence_reference = fence_reference;
    pscreen->fence_finish = fence_finish;
+
+   mtx_init(&screen->fence_wait_mutex, mtx_plain);
+   screen->fence_event = create_event(&screen->fence_event_fd);
+}
+
+void
+d3d12_screen_fence_fini(struct pipe_screen *pscreen)
+{
+   struct d3d12_screen *screen = d3d12_screen(pscreen);
+
+   close_event(screen->fence_event, screen->fence_event_fd);
+   mtx_destroy(&screen->fence_wait_mutex);
 }
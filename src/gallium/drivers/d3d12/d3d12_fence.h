@@ -35,11 +35,13 @@
 struct pipe_screen;
 struct d3d12_screen;
 
+/* A fence is a point on the context's ID3D12Fence timeline. Waiting is done
+ * by polling the completed value, only waits that block get an event.
+ */
 struct d3d12_fence {
    struct pipe_reference reference;
+   struct d3d12_screen *screen;
    ID3D12Fence *cmdqueue_fence;
-   HANDLE event;
-   int event_fd;
    uint64_t value;
    bool signaled;
 };
@@ -62,4 +64,7 @@ d3d12_fence_finish(struct d3d12_fence *fence, uint64_t timeout_ns);
 void
 d3d12_screen_fence_init(struct pipe_screen *pscreen);
 
+void
+d3d12_screen_fence_fini(struct pipe_screen *pscreen);
+
 #endif
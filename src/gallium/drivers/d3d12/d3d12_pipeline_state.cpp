@@ -26,7 +26,9 @@
 #include "d3d12_context.h"
 #include "d3d12_screen.h"
 
+#include "util/disk_cache.h"
 #include "util/hash_table.h"
+#include "util/mesa-sha1.h"
 #include "util/set.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
@@ -193,6 +195,97 @@ d3d12_rtv_format(struct d3d12_context *ctx, unsigned index)
    return fmt;
 }
 
+static void
+hash_bytecode(struct mesa_sha1 *sha1, const D3D12_SHADER_BYTECODE *bytecode)
+{
+   _mesa_sha1_update(sha1, &bytecode->BytecodeLength, sizeof(bytecode->BytecodeLength));
+   if (bytecode->BytecodeLength)
+      _mesa_sha1_update(sha1, bytecode->pShaderBytecode, bytecode->BytecodeLength);
+}
+
+static void
+hash_semantic(struct mesa_sha1 *sha1, const char *name, UINT index)
+{
+   if (name)
+      _mesa_sha1_update(sha1, name, strlen(name) + 1);
+   _mesa_sha1_update(sha1, &index, sizeof(index));
+}
+
+static void
+hash_stencil_op(struct mesa_sha1 *sha1, const D3D12_DEPTH_STENCILOP_DESC *desc)
+{
+   _mesa_sha1_update(sha1, &desc->StencilFailOp, sizeof(desc->StencilFailOp));
+   _mesa_sha1_update(sha1, &desc->StencilDepthFailOp, sizeof(desc->StencilDepthFailOp));
+   _mesa_sha1_update(sha1, &desc->StencilPassOp, sizeof(desc->StencilPassOp));
+   _mesa_sha1_update(sha1, &desc->StencilFunc, sizeof(desc->StencilFunc));
+}
+
+/* The context's PSO cache is keyed by CSO and shader pointers, which don't
+ * survive the process. The on-disk cache needs a key built from what the
+ * pointers in the description point to instead. */
+static void
+compute_pso_disk_cache_key(const D3D12_GRAPHICS_PIPELINE_STATE_DESC *desc,
+                           cache_key key)
+{
+   struct mesa_sha1 sha1;
+   _mesa_sha1_init(&sha1);
+
+   hash_bytecode(&sha1, &desc->VS);
+   hash_bytecode(&sha1, &desc->PS);
+   hash_bytecode(&sha1, &desc->DS);
+   hash_bytecode(&sha1, &desc->HS);
+   hash_bytecode(&sha1, &desc->GS);
+
+   for (unsigned i = 0; i < desc->StreamOutput.NumEntries; ++i) {
+      const D3D12_SO_DECLARATION_ENTRY *entry = &desc->StreamOutput.pSODeclaration[i];
+      hash_semantic(&sha1, entry->SemanticName, entry->SemanticIndex);
+      _mesa_sha1_update(&sha1, &entry->Stream, sizeof(entry->Stream));
+      _mesa_sha1_update(&sha1, &entry->StartComponent, sizeof(entry->StartComponent));
+      _mesa_sha1_update(&sha1, &entry->ComponentCount, sizeof(entry->ComponentCount));
+      _mesa_sha1_update(&sha1, &entry->OutputSlot, sizeof(entry->OutputSlot));
+   }
+   _mesa_sha1_update(&sha1, desc->StreamOutput.pBufferStrides,
+                     desc->StreamOutput.NumStrides * sizeof(UINT));
+   _mesa_sha1_update(&sha1, &desc->StreamOutput.RasterizedStream,
+                     sizeof(desc->StreamOutput.RasterizedStream));
+
+   _mesa_sha1_update(&sha1, &desc->BlendState, sizeof(desc->BlendState));
+   _mesa_sha1_update(&sha1, &desc->SampleMask, sizeof(desc->SampleMask));
+   _mesa_sha1_update(&sha1, &desc->RasterizerState, sizeof(desc->RasterizerState));
+
+   /* the stencil masks leave padding in the depth stencil desc */
+   const D3D12_DEPTH_STENCIL_DESC *zsa = &desc->DepthStencilState;
+   _mesa_sha1_update(&sha1, &zsa->DepthEnable, sizeof(zsa->DepthEnable));
+   _mesa_sha1_update(&sha1, &zsa->DepthWriteMask, sizeof(zsa->DepthWriteMask));
+   _mesa_sha1_update(&sha1, &zsa->DepthFunc, sizeof(zsa->DepthFunc));
+   _mesa_sha1_update(&sha1, &zsa->StencilEnable, sizeof(zsa->StencilEnable));
+   _mesa_sha1_update(&sha1, &zsa->StencilReadMask, sizeof(zsa->StencilReadMask));
+   _mesa_sha1_update(&sha1, &zsa->StencilWriteMask, sizeof(zsa->StencilWriteMask));
+   hash_stencil_op(&sha1, &zsa->FrontFace);
+   hash_stencil_op(&sha1, &zsa->BackFace);
+
+   for (unsigned i = 0; i < desc->InputLayout.NumElements; ++i) {
+      const D3D12_INPUT_ELEMENT_DESC *elem = &desc->InputLayout.pInputElementDescs[i];
+      hash_semantic(&sha1, elem->SemanticName, elem->SemanticIndex);
+      _mesa_sha1_update(&sha1, &elem->Format, sizeof(elem->Format));
+      _mesa_sha1_update(&sha1, &elem->InputSlot, sizeof(elem->InputSlot));
+      _mesa_sha1_update(&sha1, &elem->AlignedByteOffset, sizeof(elem->AlignedByteOffset));
+      _mesa_sha1_update(&sha1, &elem->InputSlotClass, sizeof(elem->InputSlotClass));
+      _mesa_sha1_update(&sha1, &elem->InstanceDataStepRate, sizeof(elem->InstanceDataStepRate));
+   }
+
+   _mesa_sha1_update(&sha1, &desc->IBStripCutValue, sizeof(desc->IBStripCutValue));
+   _mesa_sha1_update(&sha1, &desc->PrimitiveTopologyType, sizeof(desc->PrimitiveTopologyType));
+   _mesa_sha1_update(&sha1, &desc->NumRenderTargets, sizeof(desc->NumRenderTargets));
+   _mesa_sha1_update(&sha1, desc->RTVFormats, desc->NumRenderTargets * sizeof(DXGI_FORMAT));
+   _mesa_sha1_update(&sha1, &desc->DSVFormat, sizeof(desc->DSVFormat));
+   _mesa_sha1_update(&sha1, &desc->SampleDesc, sizeof(desc->SampleDesc));
+   _mesa_sha1_update(&sha1, &desc->NodeMask, sizeof(desc->NodeMask));
+   _mesa_sha1_update(&sha1, &desc->Flags, sizeof(desc->Flags));
+
+   _mesa_sha1_final(&sha1, key);
+}
+
 static ID3D12PipelineState *
 create_gfx_pipeline_state(struct d3d12_context *ctx)
 {
@@ -277,11 +370,44 @@ create_gfx_pipeline_state(struct d3d12_context *ctx)
 
    pso_desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
 
-   ID3D12PipelineState *ret;
-   if (FAILED(screen->dev->CreateGraphicsPipelineState(&pso_desc,
-                                                       IID_PPV_ARGS(&ret)))) {
-      debug_printf("D3D12: CreateGraphicsPipelineState failed!\n");
-      return NULL;
+   /* A cached PSO from an earlier run lets the driver skip compiling the
+    * shaders. The runtime rejects blobs from another driver version or
+    * adapter, in which case we just create the PSO from scratch. */
+   cache_key key;
+   void *cached_blob = NULL;
+   size_t cached_blob_size = 0;
+   if (screen->disk_cache) {
+      compute_pso_disk_cache_key(&pso_desc, key);
+      cached_blob = disk_cache_get(screen->disk_cache, key, &cached_blob_size);
+   }
+
+   ID3D12PipelineState *ret = NULL;
+   if (cached_blob) {
+      pso_desc.CachedPSO.pCachedBlob = cached_blob;
+      pso_desc.CachedPSO.CachedBlobSizeInBytes = cached_blob_size;
+      if (FAILED(screen->dev->CreateGraphicsPipelineState(&pso_desc,
+                                                          IID_PPV_ARGS(&ret))))
+         ret = NULL;
+      free(cached_blob);
+
+      pso_desc.CachedPSO.pCachedBlob = NULL;
+      pso_desc.CachedPSO.CachedBlobSizeInBytes = 0;
+   }
+
+   if (!ret) {
+      if (FAILED(screen->dev->CreateGraphicsPipelineState(&pso_desc,
+                                                          IID_PPV_ARGS(&ret)))) {
+         debug_printf("D3D12: CreateGraphicsPipelineState failed!\n");
+         return NULL;
+      }
+
+      /* disk_cache_put() copies the blob and writes it from its own thread */
+      ID3DBlob *blob;
+      if (screen->disk_cache && SUCCEEDED(ret->GetCachedBlob(&blob))) {
+         disk_cache_put(screen->disk_cache, key, blob->GetBufferPointer(),
+                        blob->GetBufferSize(), NULL);
+         blob->Release();
+      }
    }
 
    return ret;
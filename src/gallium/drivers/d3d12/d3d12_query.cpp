@@ -22,6 +22,7 @@
  */
 
 #include "d3d12_query.h"
+#include "d3d12_bufmgr.h"
 #include "d3d12_context.h"
 #include "d3d12_resource.h"
 #include "d3d12_screen.h"
@@ -33,6 +34,7 @@
 #include <dxguids/dxguids.h>
 
 struct d3d12_query {
+   struct threaded_query base;
    enum pipe_query_type type;
 
    ID3D12QueryHeap *query_heap;
@@ -46,6 +48,14 @@ struct d3d12_query {
    unsigned buffer_offset;
    uint64_t fence_value;
 
+   /* The readback buffer stays mapped while the query lives */
+   void *results;
+
+   /* Slots from resolved_query to curr_query have ended in the current batch
+    * and get resolved in one go before it is submitted. */
+   unsigned resolved_query;
+   struct list_head unresolved_list;
+
    struct list_head active_list;
    struct d3d12_resource *predicate;
 };
@@ -122,6 +132,8 @@ d3d12_create_query(struct pipe_context *pctx,
       query->num_queries = 64;
 
    query->curr_query = 0;
+   query->resolved_query = 0;
+   list_inithead(&query->unresolved_list);
 
    switch (query->d3d12qtype) {
    case D3D12_QUERY_TYPE_PIPELINE_STATISTICS:
@@ -147,6 +159,23 @@ d3d12_create_query(struct pipe_context *pctx,
    size_t buffer_size = query->query_size * query->num_queries;
    u_suballocator_alloc(&ctx->query_allocator, buffer_size, 256,
                         &query->buffer_offset, &query->buffer);
+   if (!query->buffer) {
+      query->query_heap->Release();
+      FREE(query);
+      return NULL;
+   }
+
+   /* Readback heaps can stay mapped, the results are only read once the
+    * fence of the batch that resolved them has signaled. */
+   D3D12_RANGE range = { query->buffer_offset,
+                         query->buffer_offset + buffer_size };
+   query->results = d3d12_bo_map(d3d12_resource(query->buffer)->bo, &range);
+   if (!query->results) {
+      pipe_resource_reference(&query->buffer, NULL);
+      query->query_heap->Release();
+      FREE(query);
+      return NULL;
+   }
 
    return (struct pipe_query *)query;
 }
@@ -156,10 +185,15 @@ d3d12_destroy_query(struct pipe_context *pctx,
                     struct pipe_query *q)
 {
    struct d3d12_query *query = (struct d3d12_query *)q;
-   pipe_resource *predicate = &query->predicate->base;
+   pipe_resource *predicate = &query->predicate->base.b;
    if (query->subquery)
       d3d12_destroy_query(pctx, (struct pipe_query *)query->subquery);
    pipe_resource_reference(&predicate, NULL);
+   list_delinit(&query->unresolved_list);
+
+   D3D12_RANGE range = { 0, 0 };
+   d3d12_bo_unmap(d3d12_resource(query->buffer)->bo, &range);
+   pipe_resource_reference(&query->buffer, NULL);
    query->query_heap->Release();
    FREE(query);
 }
@@ -168,19 +202,11 @@ static bool
 accumulate_result(struct d3d12_context *ctx, struct d3d12_query *q,
                   union pipe_query_result *result, bool write)
 {
-   struct pipe_transfer *transfer = NULL;
    struct d3d12_screen *screen = d3d12_screen(ctx->base.screen);
-   unsigned access = PIPE_MAP_READ;
-   void *results;
+   void *results = q->results;
 
-   if (write)
-      access |= PIPE_MAP_WRITE;
-   results = pipe_buffer_map_range(&ctx->base, q->buffer, q->buffer_offset,
-                                   q->num_queries * q->query_size,
-                                   access, &transfer);
-
-   if (results == NULL)
-      return false;
+   /* Callers make sure the resolving batch has finished */
+   assert(list_is_empty(&q->unresolved_list));
 
    uint64_t *results_u64 = (uint64_t *)results;
    D3D12_QUERY_DATA_PIPELINE_STATISTICS *results_stats = (D3D12_QUERY_DATA_PIPELINE_STATISTICS *)results;
@@ -244,6 +270,7 @@ accumulate_result(struct d3d12_context *ctx, struct d3d12_query *q,
 
       accumulate_result(ctx, q->subquery, &subresult, false);
       q->subquery->curr_query = 0;
+      q->subquery->resolved_query = 0;
       if (q->type == PIPE_QUERY_PRIMITIVES_GENERATED)
          result->u64 += subresult.pipeline_statistics.ia_primitives;
    }
@@ -274,8 +301,6 @@ accumulate_result(struct d3d12_context *ctx, struct d3d12_query *q,
       }
    }
 
-   pipe_buffer_unmap(&ctx->base, transfer);
-
    if (q->type == PIPE_QUERY_TIME_ELAPSED ||
        q->type == PIPE_QUERY_TIMESTAMP)
       result->u64 = static_cast<uint64_t>(screen->timestamp_multiplier * result->u64);
@@ -288,6 +313,8 @@ begin_query(struct d3d12_context *ctx, struct d3d12_query *q, bool restart)
 {
    if (restart) {
       q->curr_query = 0;
+      q->resolved_query = 0;
+      list_delinit(&q->unresolved_list);
    } else if (q->curr_query == q->num_queries) {
       union pipe_query_result result;
 
@@ -295,6 +322,7 @@ begin_query(struct d3d12_context *ctx, struct d3d12_query *q, bool restart)
       d3d12_flush_cmdlist_and_wait(ctx);
       accumulate_result(ctx, q, &result, true);
       q->curr_query = 1;
+      q->resolved_query = 1;
    }
 
    if (q->subquery)
@@ -313,6 +341,8 @@ begin_timer_query(struct d3d12_context *ctx, struct d3d12_query *q, bool restart
 
    if (restart) {
       q->curr_query = 0;
+      q->resolved_query = 0;
+      list_delinit(&q->unresolved_list);
       query_index = 0;
    } else if (query_index == q->num_queries) {
       union pipe_query_result result;
@@ -321,6 +351,7 @@ begin_timer_query(struct d3d12_context *ctx, struct d3d12_query *q, bool restart
       d3d12_flush_cmdlist_and_wait(ctx);
       accumulate_result(ctx, q, &result, true);
       q->curr_query = 2;
+      q->resolved_query = 2;
    }
 
    ctx->cmdlist->EndQuery(q->query_heap, q->d3d12qtype, query_index);
@@ -346,27 +377,23 @@ d3d12_begin_query(struct pipe_context *pctx,
 }
 
 static void
-end_query(struct d3d12_context *ctx, struct d3d12_query *q)
+resolve_query(struct d3d12_context *ctx, struct d3d12_query *q)
 {
    uint64_t offset = 0;
    struct d3d12_batch *batch = d3d12_current_batch(ctx);
    struct d3d12_resource *res = (struct d3d12_resource *)q->buffer;
    ID3D12Resource *d3d12_res = d3d12_resource_underlying(res, &offset);
 
-   /* End subquery first so that we can use fence value from parent */
-   if (q->subquery)
-      end_query(ctx, q->subquery);
-
-   /* With QUERY_TIME_ELAPSED we have recorded one value at
-    * (2 * q->curr_query), and now we record a value at (2 * q->curr_query + 1)
-    * and when resolving the query we subtract the latter from the former */
+   list_delinit(&q->unresolved_list);
+   if (q->resolved_query == q->curr_query)
+      return;
 
-   unsigned resolve_count = q->type == PIPE_QUERY_TIME_ELAPSED ? 2 : 1;
-   unsigned resolve_index = resolve_count * q->curr_query;
-   unsigned end_index = resolve_index + resolve_count - 1;
+   /* With QUERY_TIME_ELAPSED every query uses two slots */
+   unsigned slots = q->type == PIPE_QUERY_TIME_ELAPSED ? 2 : 1;
+   unsigned resolve_index = slots * q->resolved_query;
+   unsigned resolve_count = slots * (q->curr_query - q->resolved_query);
 
    offset += q->buffer_offset + resolve_index * q->query_size;
-   ctx->cmdlist->EndQuery(q->query_heap, q->d3d12qtype, end_index);
    d3d12_transition_resource_state(ctx, res, D3D12_RESOURCE_STATE_COPY_DEST);
    d3d12_apply_resource_states(ctx);
    ctx->cmdlist->ResolveQueryData(q->query_heap, q->d3d12qtype, resolve_index,
@@ -375,6 +402,29 @@ end_query(struct d3d12_context *ctx, struct d3d12_query *q)
    d3d12_batch_reference_object(batch, q->query_heap);
    d3d12_batch_reference_resource(batch, res);
 
+   q->resolved_query = q->curr_query;
+}
+
+static void
+end_query(struct d3d12_context *ctx, struct d3d12_query *q)
+{
+   /* End subquery first so that we can use fence value from parent */
+   if (q->subquery)
+      end_query(ctx, q->subquery);
+
+   /* With QUERY_TIME_ELAPSED we have recorded one value at
+    * (2 * q->curr_query), and now we record a value at (2 * q->curr_query + 1)
+    * and when resolving the query we subtract the latter from the former */
+
+   unsigned end_index = q->type == PIPE_QUERY_TIME_ELAPSED ?
+      2 * q->curr_query + 1 : q->curr_query;
+   ctx->cmdlist->EndQuery(q->query_heap, q->d3d12qtype, end_index);
+
+   /* The resolve is recorded when the batch ends, together with this query's
+    * other slots ended in the same batch. */
+   if (list_is_empty(&q->unresolved_list))
+      list_addtail(&q->unresolved_list, &ctx->unresolved_queries);
+
    assert(q->curr_query < q->num_queries);
    q->curr_query++;
 }
@@ -392,7 +442,9 @@ d3d12_end_query(struct pipe_context *pctx,
        query->type != PIPE_QUERY_TIME_ELAPSED)
       list_delinit(&query->active_list);
 
-   query->fence_value = ctx->fence_value;
+   /* The results are resolved by the current batch, whose fence gets the
+    * next value. */
+   query->fence_value = ctx->fence_value + 1;
    return true;
 }
 
@@ -422,6 +474,15 @@ d3d12_suspend_queries(struct d3d12_context *ctx)
    }
 }
 
+void
+d3d12_resolve_queries(struct d3d12_context *ctx)
+{
+   list_for_each_entry_safe(struct d3d12_query, query, &ctx->unresolved_queries,
+                            unresolved_list) {
+      resolve_query(ctx, query);
+   }
+}
+
 void
 d3d12_resume_queries(struct d3d12_context *ctx)
 {
@@ -482,6 +543,9 @@ d3d12_render_condition(struct pipe_context *pctx,
       accumulate_result(ctx, (d3d12_query *)pquery, &result, true);
    }
 
+   /* The predicate is copied from the first slot by this command list */
+   resolve_query(ctx, query);
+
    struct d3d12_resource *res = (struct d3d12_resource *)query->buffer;
    d3d12_transition_resource_state(ctx, res, D3D12_RESOURCE_STATE_COPY_SOURCE);
    d3d12_transition_resource_state(ctx, query->predicate, D3D12_RESOURCE_STATE_COPY_DEST);
@@ -509,6 +573,7 @@ d3d12_context_query_init(struct pipe_context *pctx)
 {
    struct d3d12_context *ctx = d3d12_context(pctx);
    list_inithead(&ctx->active_queries);
+   list_inithead(&ctx->unresolved_queries);
 
    u_suballocator_init(&ctx->query_allocator, &ctx->base, 4096, 0, PIPE_USAGE_STAGING,
                          0, true);
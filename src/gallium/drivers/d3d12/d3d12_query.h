@@ -29,6 +29,9 @@ struct d3d12_context;
 void
 d3d12_suspend_queries(struct d3d12_context *ctx);
 
+void
+d3d12_resolve_queries(struct d3d12_context *ctx);
+
 void
 d3d12_resume_queries(struct d3d12_context *ctx);
 
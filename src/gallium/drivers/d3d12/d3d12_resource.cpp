@@ -34,6 +34,7 @@
 #include "util/format/u_format.h"
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
+#include "util/u_upload_mgr.h"
 #include "util/format/u_format_zs.h"
 
 #include "frontend/sw_winsys.h"
@@ -50,20 +51,12 @@ can_map_directly(struct pipe_resource *pres)
           pres->usage != PIPE_USAGE_IMMUTABLE;
 }
 
-static void
-init_valid_range(struct d3d12_resource *res)
-{
-   if (can_map_directly(&res->base))
-      util_range_init(&res->valid_buffer_range);
-}
-
 static void
 d3d12_resource_destroy(struct pipe_screen *pscreen,
                        struct pipe_resource *presource)
 {
    struct d3d12_resource *resource = d3d12_resource(presource);
-   if (can_map_directly(presource))
-      util_range_destroy(&resource->valid_buffer_range);
+   threaded_resource_deinit(presource);
    if (resource->bo)
       d3d12_bo_unreference(resource->bo);
    FREE(resource);
@@ -75,7 +68,7 @@ resource_is_busy(struct d3d12_context *ctx,
 {
    bool busy = false;
 
-   for (unsigned i = 0; i < ARRAY_SIZE(ctx->batches); i++)
+   for (unsigned i = 0; i < ctx->num_batches; i++)
       busy |= d3d12_batch_has_references(&ctx->batches[i], res->bo);
 
    return busy;
@@ -119,25 +112,32 @@ init_buffer(struct d3d12_screen *screen,
     * element state */
    assert(templ->format == d3d12_emulated_vtx_format(templ->format));
 
+   /* Buffers in the default heap aren't suballocated: the resource state
+    * is tracked for the whole D3D12 resource, so buffers sharing one would
+    * be transitioned together. Upload and readback heap buffers never
+    * change state, so they come from the slab managers, which only have to
+    * keep them aligned for use as CBVs. */
    switch (templ->usage) {
    case PIPE_USAGE_DEFAULT:
    case PIPE_USAGE_IMMUTABLE:
       bufmgr = screen->cache_bufmgr;
       buf_desc.usage = (pb_usage_flags)PB_USAGE_GPU_READ_WRITE;
+      buf_desc.alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
       break;
    case PIPE_USAGE_DYNAMIC:
    case PIPE_USAGE_STREAM:
       bufmgr = screen->slab_bufmgr;
       buf_desc.usage = (pb_usage_flags)(PB_USAGE_CPU_WRITE | PB_USAGE_GPU_READ);
+      buf_desc.alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
       break;
    case PIPE_USAGE_STAGING:
       bufmgr = screen->readback_slab_bufmgr;
       buf_desc.usage = (pb_usage_flags)(PB_USAGE_GPU_WRITE | PB_USAGE_CPU_READ_WRITE);
+      buf_desc.alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
       break;
    default:
       unreachable("Invalid pipe usage");
    }
-   buf_desc.alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
    res->dxgi_format = DXGI_FORMAT_UNKNOWN;
    buf = bufmgr->create_buffer(bufmgr, templ->width0, &buf_desc);
    if (!buf)
@@ -230,8 +230,8 @@ init_texture(struct d3d12_screen *screen,
    if (screen->winsys && (templ->bind & PIPE_BIND_DISPLAY_TARGET)) {
       struct sw_winsys *winsys = screen->winsys;
       res->dt = winsys->displaytarget_create(screen->winsys,
-                                             res->base.bind,
-                                             res->base.format,
+                                             res->base.b.bind,
+                                             res->base.b.format,
                                              templ->width0,
                                              templ->height0,
                                              64, NULL,
@@ -251,7 +251,7 @@ d3d12_resource_create(struct pipe_screen *pscreen,
    struct d3d12_resource *res = CALLOC_STRUCT(d3d12_resource);
    bool ret;
 
-   res->base = *templ;
+   res->base.b = *templ;
 
    if (D3D12_DEBUG_RESOURCE & d3d12_debug) {
       debug_printf("D3D12: Create %sresource %s@%d %dx%dx%d as:%d mip:%d\n",
@@ -261,8 +261,8 @@ d3d12_resource_create(struct pipe_screen *pscreen,
                    templ->array_size, templ->last_level);
    }
 
-   pipe_reference_init(&res->base.reference, 1);
-   res->base.screen = pscreen;
+   pipe_reference_init(&res->base.b.reference, 1);
+   res->base.b.screen = pscreen;
 
    if (templ->target == PIPE_BUFFER) {
       ret = init_buffer(screen, res, templ);
@@ -275,9 +275,9 @@ d3d12_resource_create(struct pipe_screen *pscreen,
       return NULL;
    }
 
-   init_valid_range(res);
+   threaded_resource_init(&res->base.b);
 
-   return &res->base;
+   return &res->base.b;
 }
 
 static struct pipe_resource *
@@ -292,14 +292,15 @@ d3d12_resource_from_handle(struct pipe_screen *pscreen,
    if (!res)
       return NULL;
 
-   res->base = *templ;
-   pipe_reference_init(&res->base.reference, 1);
-   res->base.screen = pscreen;
+   res->base.b = *templ;
+   pipe_reference_init(&res->base.b.reference, 1);
+   res->base.b.screen = pscreen;
    res->dxgi_format = templ->target == PIPE_BUFFER ? DXGI_FORMAT_UNKNOWN :
                  d3d12_get_format(templ->format);
    res->bo = d3d12_bo_wrap_res((ID3D12Resource *)handle->com_obj, templ->format);
-   init_valid_range(res);
-   return &res->base;
+   threaded_resource_init(&res->base.b);
+   res->base.is_shared = true;
+   return &res->base.b;
 }
 
 static bool
@@ -315,6 +316,7 @@ d3d12_resource_get_handle(struct pipe_screen *pscreen,
       return false;
 
    handle->com_obj = d3d12_resource_resource(res);
+   res->base.is_shared = true;
    return true;
 }
 
@@ -331,18 +333,18 @@ unsigned int
 get_subresource_id(struct d3d12_resource *res, unsigned resid,
                    unsigned z, unsigned base_level)
 {
-   unsigned resource_stride = res->base.last_level + 1;
-   if (res->base.target == PIPE_TEXTURE_1D_ARRAY ||
-       res->base.target == PIPE_TEXTURE_2D_ARRAY)
-      resource_stride *= res->base.array_size;
+   unsigned resource_stride = res->base.b.last_level + 1;
+   if (res->base.b.target == PIPE_TEXTURE_1D_ARRAY ||
+       res->base.b.target == PIPE_TEXTURE_2D_ARRAY)
+      resource_stride *= res->base.b.array_size;
 
-   if (res->base.target == PIPE_TEXTURE_CUBE)
+   if (res->base.b.target == PIPE_TEXTURE_CUBE)
       resource_stride *= 6;
 
-   if (res->base.target == PIPE_TEXTURE_CUBE_ARRAY)
-      resource_stride *= 6 * res->base.array_size;
+   if (res->base.b.target == PIPE_TEXTURE_CUBE_ARRAY)
+      resource_stride *= 6 * res->base.b.array_size;
 
-   unsigned layer_stride = res->base.last_level + 1;
+   unsigned layer_stride = res->base.b.last_level + 1;
 
    return resid * resource_stride + z * layer_stride +
          base_level;
@@ -353,7 +355,7 @@ fill_texture_location(struct d3d12_resource *res,
                       struct d3d12_transfer *trans, unsigned resid, unsigned z)
 {
    D3D12_TEXTURE_COPY_LOCATION tex_loc = {0};
-   int subres = get_subresource_id(res, resid, z, trans->base.level);
+   int subres = get_subresource_id(res, resid, z, trans->base.b.level);
 
    tex_loc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
    tex_loc.SubresourceIndex = subres;
@@ -375,22 +377,22 @@ fill_buffer_location(struct d3d12_context *ctx,
    auto descr = d3d12_resource_underlying(res, &offset)->GetDesc();
    ID3D12Device* dev = d3d12_screen(ctx->base.screen)->dev;
 
-   unsigned sub_resid = get_subresource_id(res, resid, z, trans->base.level);
+   unsigned sub_resid = get_subresource_id(res, resid, z, trans->base.b.level);
    dev->GetCopyableFootprints(&descr, sub_resid, 1, 0, &footprint, nullptr, nullptr, nullptr);
 
    buf_loc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
    buf_loc.pResource = d3d12_resource_underlying(staging_res, &offset);
    buf_loc.PlacedFootprint = footprint;
-   buf_loc.PlacedFootprint.Offset += offset;
+   buf_loc.PlacedFootprint.Offset += offset + trans->staging_offset;
 
-   buf_loc.PlacedFootprint.Footprint.Width = ALIGN(trans->base.box.width,
-                                                   util_format_get_blockwidth(res->base.format));
-   buf_loc.PlacedFootprint.Footprint.Height = ALIGN(trans->base.box.height,
-                                                    util_format_get_blockheight(res->base.format));
+   buf_loc.PlacedFootprint.Footprint.Width = ALIGN(trans->base.b.box.width,
+                                                   util_format_get_blockwidth(res->base.b.format));
+   buf_loc.PlacedFootprint.Footprint.Height = ALIGN(trans->base.b.box.height,
+                                                    util_format_get_blockheight(res->base.b.format));
    buf_loc.PlacedFootprint.Footprint.Depth = ALIGN(depth,
-                                                   util_format_get_blockdepth(res->base.format));
+                                                   util_format_get_blockdepth(res->base.b.format));
 
-   buf_loc.PlacedFootprint.Footprint.RowPitch = trans->base.stride;
+   buf_loc.PlacedFootprint.Footprint.RowPitch = trans->base.b.stride;
 
    return buf_loc;
 }
@@ -431,22 +433,22 @@ transfer_buf_to_image_part(struct d3d12_context *ctx,
 {
    if (D3D12_DEBUG_RESOURCE & d3d12_debug) {
       debug_printf("D3D12: Copy %dx%dx%d + %dx%dx%d from buffer %s to image %s\n",
-                   trans->base.box.x, trans->base.box.y, trans->base.box.z,
-                   trans->base.box.width, trans->base.box.height, trans->base.box.depth,
-                   util_format_name(staging_res->base.format),
-                   util_format_name(res->base.format));
+                   trans->base.b.box.x, trans->base.b.box.y, trans->base.b.box.z,
+                   trans->base.b.box.width, trans->base.b.box.height, trans->base.b.box.depth,
+                   util_format_name(staging_res->base.b.format),
+                   util_format_name(res->base.b.format));
    }
 
    struct copy_info copy_info;
    copy_info.src = staging_res;
    copy_info.src_loc = fill_buffer_location(ctx, res, staging_res, trans, depth, resid, z);
-   copy_info.src_loc.PlacedFootprint.Offset = (z  - start_z) * trans->base.layer_stride;
+   copy_info.src_loc.PlacedFootprint.Offset += (z  - start_z) * trans->base.b.layer_stride;
    copy_info.src_box = nullptr;
    copy_info.dst = res;
    copy_info.dst_loc = fill_texture_location(res, trans, resid, z);
-   copy_info.dst_x = trans->base.box.x;
-   copy_info.dst_y = trans->base.box.y;
-   copy_info.dst_z = res->base.target == PIPE_TEXTURE_CUBE ? 0 : dest_z;
+   copy_info.dst_x = trans->base.b.box.x;
+   copy_info.dst_y = trans->base.b.box.y;
+   copy_info.dst_z = res->base.b.target == PIPE_TEXTURE_CUBE ? 0 : dest_z;
    copy_info.src_box = nullptr;
 
    copy_texture_region(ctx, copy_info);
@@ -458,14 +460,14 @@ transfer_buf_to_image(struct d3d12_context *ctx,
                       struct d3d12_resource *staging_res,
                       struct d3d12_transfer *trans, int resid)
 {
-   if (res->base.target == PIPE_TEXTURE_3D) {
+   if (res->base.b.target == PIPE_TEXTURE_3D) {
       assert(resid == 0);
       transfer_buf_to_image_part(ctx, res, staging_res, trans,
-                                 0, trans->base.box.depth, 0,
-                                 trans->base.box.z, 0);
+                                 0, trans->base.b.box.depth, 0,
+                                 trans->base.b.box.z, 0);
    } else {
-      int num_layers = trans->base.box.depth;
-      int start_z = trans->base.box.z;
+      int num_layers = trans->base.b.box.depth;
+      int start_z = trans->base.b.box.z;
 
       for (int z = start_z; z < start_z + num_layers; ++z) {
          transfer_buf_to_image_part(ctx, res, staging_res, trans,
@@ -483,7 +485,7 @@ transfer_image_part_to_buf(struct d3d12_context *ctx,
                            unsigned resid, int z, int start_layer,
                            int start_box_z, int depth)
 {
-   struct pipe_box *box = &trans->base.box;
+   struct pipe_box *box = &trans->base.b.box;
    D3D12_BOX src_box = {};
 
    struct copy_info copy_info;
@@ -493,10 +495,10 @@ transfer_image_part_to_buf(struct d3d12_context *ctx,
    copy_info.dst = staging_res;
    copy_info.dst_loc = fill_buffer_location(ctx, res, staging_res, trans,
                                             depth, resid, z);
-   copy_info.dst_loc.PlacedFootprint.Offset = (z  - start_layer) * trans->base.layer_stride;
+   copy_info.dst_loc.PlacedFootprint.Offset += (z  - start_layer) * trans->base.b.layer_stride;
    copy_info.dst_x = copy_info.dst_y = copy_info.dst_z = 0;
 
-   if (!util_texrange_covers_whole_level(&res->base, trans->base.level,
+   if (!util_texrange_covers_whole_level(&res->base.b, trans->base.b.level,
                                          box->x, box->y, start_box_z,
                                          box->width, box->height, depth)) {
       src_box.left = box->x;
@@ -522,29 +524,29 @@ transfer_image_to_buf(struct d3d12_context *ctx,
    /* We only suppport loading from either an texture array
     * or a ZS texture, so either resid is zero, or num_layers == 1)
     */
-   assert(resid == 0 || trans->base.box.depth == 1);
+   assert(resid == 0 || trans->base.b.box.depth == 1);
 
    if (D3D12_DEBUG_RESOURCE & d3d12_debug) {
       debug_printf("D3D12: Copy %dx%dx%d + %dx%dx%d from %s@%d to %s\n",
-                   trans->base.box.x, trans->base.box.y, trans->base.box.z,
-                   trans->base.box.width, trans->base.box.height, trans->base.box.depth,
-                   util_format_name(res->base.format), resid,
-                   util_format_name(staging_res->base.format));
+                   trans->base.b.box.x, trans->base.b.box.y, trans->base.b.box.z,
+                   trans->base.b.box.width, trans->base.b.box.height, trans->base.b.box.depth,
+                   util_format_name(res->base.b.format), resid,
+                   util_format_name(staging_res->base.b.format));
    }
 
    struct pipe_resource *resolved_resource = nullptr;
-   if (res->base.nr_samples > 1) {
-      struct pipe_resource tmpl = res->base;
+   if (res->base.b.nr_samples > 1) {
+      struct pipe_resource tmpl = res->base.b;
       tmpl.nr_samples = 0;
       resolved_resource = d3d12_resource_create(ctx->base.screen, &tmpl);
       struct pipe_blit_info resolve_info = {};
-      struct pipe_box box = {0,0,0, (int)res->base.width0, (int16_t)res->base.height0, (int16_t)res->base.depth0};
+      struct pipe_box box = {0,0,0, (int)res->base.b.width0, (int16_t)res->base.b.height0, (int16_t)res->base.b.depth0};
       resolve_info.dst.resource = resolved_resource;
       resolve_info.dst.box = box;
-      resolve_info.dst.format = res->base.format;
-      resolve_info.src.resource = &res->base;
+      resolve_info.dst.format = res->base.b.format;
+      resolve_info.src.resource = &res->base.b;
       resolve_info.src.box = box;
-      resolve_info.src.format = res->base.format;
+      resolve_info.src.format = res->base.b.format;
       resolve_info.filter = PIPE_TEX_FILTER_NEAREST;
       resolve_info.mask = util_format_get_mask(tmpl.format);
 
@@ -555,12 +557,12 @@ transfer_image_to_buf(struct d3d12_context *ctx,
    }
 
 
-   if (res->base.target == PIPE_TEXTURE_3D) {
+   if (res->base.b.target == PIPE_TEXTURE_3D) {
       transfer_image_part_to_buf(ctx, res, staging_res, trans, resid,
-                                 0, 0, trans->base.box.z, trans->base.box.depth);
+                                 0, 0, trans->base.b.box.z, trans->base.b.box.depth);
    } else {
-      int start_layer = trans->base.box.z;
-      for (int z = start_layer; z < start_layer + trans->base.box.depth; ++z) {
+      int start_layer = trans->base.b.box.z;
+      for (int z = start_layer; z < start_layer + trans->base.b.box.depth; ++z) {
          transfer_image_part_to_buf(ctx, res, staging_res, trans, resid,
                                     z, start_layer, 0, 1);
       }
@@ -630,12 +632,13 @@ synchronize(struct d3d12_context *ctx,
             unsigned usage,
             D3D12_RANGE *range)
 {
-   assert(can_map_directly(&res->base));
+   assert(can_map_directly(&res->base.b));
 
-   /* Check whether that range contains valid data; if not, we might not need to sync */
-   if (!(usage & PIPE_MAP_UNSYNCHRONIZED) &&
+   /* Check whether that range contains valid data; if not, we might not need to sync.
+    * The threaded context does this itself and tells us not to. */
+   if (!(usage & (PIPE_MAP_UNSYNCHRONIZED | TC_TRANSFER_MAP_NO_INFER_UNSYNCHRONIZED)) &&
        usage & PIPE_MAP_WRITE &&
-       !util_ranges_intersect(&res->valid_buffer_range, range->Begin, range->End)) {
+       !util_ranges_intersect(&res->base.valid_buffer_range, range->Begin, range->End)) {
       usage |= PIPE_MAP_UNSYNCHRONIZED;
    }
 
@@ -647,7 +650,7 @@ synchronize(struct d3d12_context *ctx,
    }
 
    if (usage & PIPE_MAP_WRITE)
-      util_range_add(&res->base, &res->valid_buffer_range,
+      util_range_add(&res->base.b, &res->base.valid_buffer_range,
                      range->Begin, range->End);
 
    return true;
@@ -708,10 +711,10 @@ prepare_zs_layer_strides(struct d3d12_resource *res,
                          const struct pipe_box *box,
                          struct d3d12_transfer *trans)
 {
-   trans->base.stride = align(util_format_get_stride(res->base.format, box->width),
+   trans->base.b.stride = align(util_format_get_stride(res->base.b.format, box->width),
                               D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
-   trans->base.layer_stride = util_format_get_2d_size(res->base.format,
-                                                      trans->base.stride,
+   trans->base.b.layer_stride = util_format_get_2d_size(res->base.b.format,
+                                                      trans->base.b.stride,
                                                       box->height);
 }
 
@@ -731,7 +734,7 @@ read_zs_surface(struct d3d12_context *ctx, struct d3d12_resource *res,
    tmpl.bind = 0;
    tmpl.usage = PIPE_USAGE_STAGING;
    tmpl.flags = 0;
-   tmpl.width0 = trans->base.layer_stride;
+   tmpl.width0 = trans->base.b.layer_stride;
    tmpl.height0 = 1;
    tmpl.depth0 = 1;
    tmpl.array_size = 1;
@@ -770,26 +773,26 @@ read_zs_surface(struct d3d12_context *ctx, struct d3d12_resource *res,
       return NULL;
    }
 
-   uint8_t *buf = (uint8_t *)malloc(trans->base.layer_stride);
+   uint8_t *buf = (uint8_t *)malloc(trans->base.b.layer_stride);
    if (!buf)
       return NULL;
 
    trans->data = buf;
 
-   switch (res->base.format) {
+   switch (res->base.b.format) {
    case PIPE_FORMAT_Z24_UNORM_S8_UINT:
-      util_format_z24_unorm_s8_uint_pack_separate(buf, trans->base.stride,
-                                                  (uint32_t *)depth_ptr, trans->base.stride,
-                                                  stencil_ptr, trans->base.stride,
-                                                  trans->base.box.width, trans->base.box.height);
+      util_format_z24_unorm_s8_uint_pack_separate(buf, trans->base.b.stride,
+                                                  (uint32_t *)depth_ptr, trans->base.b.stride,
+                                                  stencil_ptr, trans->base.b.stride,
+                                                  trans->base.b.box.width, trans->base.b.box.height);
       break;
    case PIPE_FORMAT_Z32_FLOAT_S8X24_UINT:
-      util_format_z32_float_s8x24_uint_pack_z_float(buf, trans->base.stride,
-                                                    (float *)depth_ptr, trans->base.stride,
-                                                    trans->base.box.width, trans->base.box.height);
-      util_format_z32_float_s8x24_uint_pack_s_8uint(buf, trans->base.stride,
-                                                    stencil_ptr, trans->base.stride,
-                                                    trans->base.box.width, trans->base.box.height);
+      util_format_z32_float_s8x24_uint_pack_z_float(buf, trans->base.b.stride,
+                                                    (float *)depth_ptr, trans->base.b.stride,
+                                                    trans->base.b.box.width, trans->base.b.box.height);
+      util_format_z32_float_s8x24_uint_pack_s_8uint(buf, trans->base.b.stride,
+                                                    stencil_ptr, trans->base.b.stride,
+                                                    trans->base.b.box.width, trans->base.b.box.height);
       break;
    default:
       unreachable("Unsupported depth steancil format");
@@ -804,7 +807,7 @@ prepare_write_zs_surface(struct d3d12_resource *res,
                          struct d3d12_transfer *trans)
 {
    prepare_zs_layer_strides(res, box, trans);
-   uint32_t *buf = (uint32_t *)malloc(trans->base.layer_stride);
+   uint32_t *buf = (uint32_t *)malloc(trans->base.b.layer_stride);
    if (!buf)
       return NULL;
 
@@ -823,7 +826,7 @@ write_zs_surface(struct pipe_context *pctx, struct d3d12_resource *res,
    tmpl.bind = 0;
    tmpl.usage = PIPE_USAGE_STAGING;
    tmpl.flags = 0;
-   tmpl.width0 = trans->base.layer_stride;
+   tmpl.width0 = trans->base.b.layer_stride;
    tmpl.height0 = 1;
    tmpl.depth0 = 1;
    tmpl.array_size = 1;
@@ -852,22 +855,22 @@ write_zs_surface(struct pipe_context *pctx, struct d3d12_resource *res,
       return;
    }
 
-   switch (res->base.format) {
+   switch (res->base.b.format) {
    case PIPE_FORMAT_Z24_UNORM_S8_UINT:
-      util_format_z32_unorm_unpack_z_32unorm((uint32_t *)depth_ptr, trans->base.stride, (uint8_t*)trans->data,
-                                             trans->base.stride, trans->base.box.width,
-                                             trans->base.box.height);
-      util_format_z24_unorm_s8_uint_unpack_s_8uint(stencil_ptr, trans->base.stride, (uint8_t*)trans->data,
-                                                   trans->base.stride, trans->base.box.width,
-                                                   trans->base.box.height);
+      util_format_z32_unorm_unpack_z_32unorm((uint32_t *)depth_ptr, trans->base.b.stride, (uint8_t*)trans->data,
+                                             trans->base.b.stride, trans->base.b.box.width,
+                                             trans->base.b.box.height);
+      util_format_z24_unorm_s8_uint_unpack_s_8uint(stencil_ptr, trans->base.b.stride, (uint8_t*)trans->data,
+                                                   trans->base.b.stride, trans->base.b.box.width,
+                                                   trans->base.b.box.height);
       break;
    case PIPE_FORMAT_Z32_FLOAT_S8X24_UINT:
-      util_format_z32_float_s8x24_uint_unpack_z_float((float *)depth_ptr, trans->base.stride, (uint8_t*)trans->data,
-                                                      trans->base.stride, trans->base.box.width,
-                                                      trans->base.box.height);
-      util_format_z32_float_s8x24_uint_unpack_s_8uint(stencil_ptr, trans->base.stride, (uint8_t*)trans->data,
-                                                      trans->base.stride, trans->base.box.width,
-                                                      trans->base.box.height);
+      util_format_z32_float_s8x24_uint_unpack_z_float((float *)depth_ptr, trans->base.b.stride, (uint8_t*)trans->data,
+                                                      trans->base.b.stride, trans->base.b.box.width,
+                                                      trans->base.b.box.height);
+      util_format_z32_float_s8x24_uint_unpack_s_8uint(stencil_ptr, trans->base.b.stride, (uint8_t*)trans->data,
+                                                      trans->base.b.stride, trans->base.b.box.width,
+                                                      trans->base.b.box.height);
       break;
    default:
       unreachable("Unsupported depth steancil format");
@@ -896,8 +899,12 @@ d3d12_transfer_map(struct pipe_context *pctx,
    if (usage & PIPE_MAP_DIRECTLY || !res->bo)
       return NULL;
 
-   struct d3d12_transfer *trans = (struct d3d12_transfer *)slab_alloc(&ctx->transfer_pool);
-   struct pipe_transfer *ptrans = &trans->base;
+   /* Unsynchronized buffer maps are called from the application thread when
+    * the context is threaded, so they get their own pool. */
+   struct slab_child_pool *transfer_pool = (usage & TC_TRANSFER_MAP_THREADED_UNSYNC) ?
+      &ctx->transfer_pool_unsync : &ctx->transfer_pool;
+   struct d3d12_transfer *trans = (struct d3d12_transfer *)slab_alloc(transfer_pool);
+   struct pipe_transfer *ptrans = &trans->base.b;
    if (!trans)
       return NULL;
 
@@ -913,7 +920,7 @@ d3d12_transfer_map(struct pipe_context *pctx,
    range.Begin = 0;
 
    void *ptr;
-   if (can_map_directly(&res->base)) {
+   if (can_map_directly(&res->base.b)) {
       if (pres->target == PIPE_BUFFER) {
          ptrans->stride = 0;
          ptrans->layer_stride = 0;
@@ -944,12 +951,12 @@ d3d12_transfer_map(struct pipe_context *pctx,
                                                      ptrans->stride,
                                                      box->height);
 
-      if (res->base.target != PIPE_TEXTURE_3D)
+      if (res->base.b.target != PIPE_TEXTURE_3D)
          ptrans->layer_stride = align(ptrans->layer_stride,
                                       D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
 
       unsigned staging_res_size = ptrans->layer_stride * box->depth;
-      if (res->base.target == PIPE_BUFFER) {
+      if (res->base.b.target == PIPE_BUFFER) {
          /* To properly support ARB_map_buffer_alignment, we need to return a pointer
           * that's appropriately offset from a 64-byte-aligned base address.
           */
@@ -960,6 +967,25 @@ d3d12_transfer_map(struct pipe_context *pctx,
          range.Begin = aligned_x;
       }
 
+      /* Uploads are suballocated from a ring of mapped upload heap buffers.
+       * Filled buffers are released once the batches copying from them are
+       * done with them. The uploader can only be used from the driver
+       * thread.
+       */
+      if (!(usage & (PIPE_MAP_READ | TC_TRANSFER_MAP_THREADED_UNSYNC))) {
+         void *upload_ptr;
+         u_upload_alloc(ctx->transfer_uploader, 0, staging_res_size,
+                        D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT,
+                        &trans->staging_offset, &trans->staging_res,
+                        &upload_ptr);
+         if (!trans->staging_res)
+            return NULL;
+
+         trans->staging_uploaded = true;
+         *transfer = ptrans;
+         return (uint8_t *)upload_ptr + range.Begin;
+      }
+
       pipe_resource_usage staging_usage = (usage & (PIPE_MAP_READ | PIPE_MAP_READ_WRITE)) ?
          PIPE_USAGE_STAGING : PIPE_USAGE_STREAM;
 
@@ -972,6 +998,8 @@ d3d12_transfer_map(struct pipe_context *pctx,
       struct d3d12_resource *staging_res = d3d12_resource(trans->staging_res);
 
       if (usage & PIPE_MAP_READ) {
+         /* this records a copy, only the driver thread may do that */
+         assert(!(usage & TC_TRANSFER_MAP_THREADED_UNSYNC));
          bool ret = true;
          if (pres->target == PIPE_BUFFER) {
             uint64_t src_offset = box->x;
@@ -1002,25 +1030,29 @@ d3d12_transfer_unmap(struct pipe_context *pctx,
    D3D12_RANGE range = { 0, 0 };
 
    if (trans->data != nullptr) {
-      if (trans->base.usage & PIPE_MAP_WRITE)
+      if (trans->base.b.usage & PIPE_MAP_WRITE)
          write_zs_surface(pctx, res, trans);
       free(trans->data);
    } else if (trans->staging_res) {
       struct d3d12_resource *staging_res = d3d12_resource(trans->staging_res);
 
-      if (trans->base.usage & PIPE_MAP_WRITE) {
-         assert(ptrans->box.x >= 0);
-         range.Begin = res->base.target == PIPE_BUFFER ?
-            (unsigned)ptrans->box.x % BUFFER_MAP_ALIGNMENT : 0;
-         range.End = staging_res->base.width0 - range.Begin;
+      /* The uploader keeps its buffers mapped */
+      if (!trans->staging_uploaded) {
+         if (trans->base.b.usage & PIPE_MAP_WRITE) {
+            assert(ptrans->box.x >= 0);
+            range.Begin = res->base.b.target == PIPE_BUFFER ?
+               (unsigned)ptrans->box.x % BUFFER_MAP_ALIGNMENT : 0;
+            range.End = staging_res->base.b.width0 - range.Begin;
+         }
+         d3d12_bo_unmap(staging_res->bo, &range);
       }
-      d3d12_bo_unmap(staging_res->bo, &range);
 
-      if (trans->base.usage & PIPE_MAP_WRITE) {
+      if (trans->base.b.usage & PIPE_MAP_WRITE) {
          struct d3d12_context *ctx = d3d12_context(pctx);
-         if (res->base.target == PIPE_BUFFER) {
-            uint64_t dst_offset = trans->base.box.x;
-            uint64_t src_offset = dst_offset % BUFFER_MAP_ALIGNMENT;
+         if (res->base.b.target == PIPE_BUFFER) {
+            uint64_t dst_offset = trans->base.b.box.x;
+            uint64_t src_offset = trans->staging_offset +
+                                  dst_offset % BUFFER_MAP_ALIGNMENT;
             transfer_buf_to_buf(ctx, staging_res, res, src_offset, dst_offset, ptrans->box.width);
          } else
             transfer_buf_to_image(ctx, res, staging_res, trans, 0);
@@ -1028,7 +1060,7 @@ d3d12_transfer_unmap(struct pipe_context *pctx,
 
       pipe_resource_reference(&trans->staging_res, NULL);
    } else {
-      if (trans->base.usage & PIPE_MAP_WRITE) {
+      if (trans->base.b.usage & PIPE_MAP_WRITE) {
          range.Begin = ptrans->box.x;
          range.End = ptrans->box.x + ptrans->box.width;
       }
@@ -1036,7 +1068,10 @@ d3d12_transfer_unmap(struct pipe_context *pctx,
    }
 
    pipe_resource_reference(&ptrans->resource, NULL);
-   slab_free(&d3d12_context(pctx)->transfer_pool, ptrans);
+   if (ptrans->usage & TC_TRANSFER_MAP_THREADED_UNSYNC)
+      slab_free(&d3d12_context(pctx)->transfer_pool_unsync, ptrans);
+   else
+      slab_free(&d3d12_context(pctx)->transfer_pool, ptrans);
 }
 
 void
@@ -1055,13 +1090,13 @@ d3d12_resource_make_writeable(struct pipe_context *pctx,
                                                (pipe_resource_usage) pres->usage,
                                                pres->width0));
 
-   if (res->valid_buffer_range.end > res->valid_buffer_range.start) {
+   if (res->base.valid_buffer_range.end > res->base.valid_buffer_range.start) {
       struct pipe_box box;
 
-      box.x = res->valid_buffer_range.start;
+      box.x = res->base.valid_buffer_range.start;
       box.y = 0;
       box.z = 0;
-      box.width = res->valid_buffer_range.end - res->valid_buffer_range.start;
+      box.width = res->base.valid_buffer_range.end - res->base.valid_buffer_range.start;
       box.height = 1;
       box.depth = 1;
 
@@ -1072,8 +1107,9 @@ d3d12_resource_make_writeable(struct pipe_context *pctx,
    d3d12_bo_unreference(res->bo);
    res->bo = dup_res->bo;
    d3d12_bo_reference(res->bo);
+   res->generation_id++;
 
-   d3d12_resource_destroy(dup_res->base.screen, &dup_res->base);
+   d3d12_resource_destroy(dup_res->base.b.screen, &dup_res->base.b);
 }
 
 void
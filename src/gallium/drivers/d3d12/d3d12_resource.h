@@ -28,22 +28,27 @@ struct pipe_screen;
 #include "d3d12_bufmgr.h"
 #include "util/u_range.h"
 #include "util/u_transfer.h"
+#include "util/u_threaded_context.h"
 
 #include <directx/d3d12.h>
 
 struct d3d12_resource {
-   struct pipe_resource base;
+   struct threaded_resource base;
    struct d3d12_bo *bo;
    DXGI_FORMAT dxgi_format;
    unsigned mip_levels;
    struct sw_displaytarget *dt;
    unsigned dt_stride;
-   struct util_range valid_buffer_range;
+   /* bumped whenever the bo is replaced, so views of it can be recreated */
+   unsigned generation_id;
 };
 
 struct d3d12_transfer {
-   struct pipe_transfer base;
+   struct threaded_transfer base;
    struct pipe_resource *staging_res;
+   /* write-only staging comes from the context's transfer uploader */
+   unsigned staging_offset;
+   bool staging_uploaded;
    void *data;
 };
 
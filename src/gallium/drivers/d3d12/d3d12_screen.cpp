@@ -34,8 +34,11 @@
 
 #include "pipebuffer/pb_bufmgr.h"
 #include "util/debug.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_screen.h"
 #include "util/u_dl.h"
 
@@ -599,10 +602,29 @@ d3d12_is_format_supported(struct pipe_screen *pscreen,
    return true;
 }
 
+static void
+d3d12_set_max_shader_compiler_threads(struct pipe_screen *pscreen,
+                                      unsigned max_threads)
+{
+   struct d3d12_screen *screen = d3d12_screen(pscreen);
+   if (util_queue_is_initialized(&screen->compile_queue))
+      util_queue_adjust_num_threads(&screen->compile_queue, max_threads);
+}
+
+static bool
+d3d12_is_parallel_shader_compilation_finished(struct pipe_screen *pscreen,
+                                              void *shader,
+                                              enum pipe_shader_type shader_type)
+{
+   return d3d12_shader_compile_finished((struct d3d12_shader_selector *)shader);
+}
+
 static void
 d3d12_destroy_screen(struct pipe_screen *pscreen)
 {
    struct d3d12_screen *screen = d3d12_screen(pscreen);
+   if (util_queue_is_initialized(&screen->compile_queue))
+      util_queue_destroy(&screen->compile_queue);
    slab_destroy_parent(&screen->transfer_pool);
    d3d12_descriptor_pool_free(screen->rtv_pool);
    d3d12_descriptor_pool_free(screen->dsv_pool);
@@ -612,6 +634,8 @@ d3d12_destroy_screen(struct pipe_screen *pscreen)
    screen->cache_bufmgr->destroy(screen->cache_bufmgr);
    screen->bufmgr->destroy(screen->bufmgr);
    mtx_destroy(&screen->descriptor_pool_mutex);
+   d3d12_screen_fence_fini(pscreen);
+   disk_cache_destroy(screen->disk_cache);
    FREE(screen);
 }
 
@@ -860,6 +884,25 @@ d3d12_init_null_rtv(struct d3d12_screen *screen)
    screen->dev->CreateRenderTargetView(NULL, &rtv, screen->null_rtv.cpu_handle);
 }
 
+static void
+d3d12_disk_cache_create(struct d3d12_screen *screen)
+{
+   struct mesa_sha1 ctx;
+   unsigned char sha1[20];
+   char cache_id[20 * 2 + 1];
+
+   /* The runtime validates the driver and adapter that produced a cached
+    * PSO, so the id only has to change with the PSO descriptions and the
+    * DXIL we build, which both come from this binary. */
+   _mesa_sha1_init(&ctx);
+   if (!disk_cache_get_function_identifier((void *)d3d12_disk_cache_create, &ctx))
+      _mesa_sha1_update(&ctx, PACKAGE_VERSION, strlen(PACKAGE_VERSION));
+   _mesa_sha1_final(&ctx, sha1);
+   disk_cache_format_hex_id(cache_id, sha1, 20 * 2);
+
+   screen->disk_cache = disk_cache_create("d3d12", cache_id, 0);
+}
+
 bool
 d3d12_init_screen(struct d3d12_screen *screen, struct sw_winsys *winsys, IUnknown *adapter)
 {
@@ -997,12 +1040,19 @@ d3d12_init_screen(struct d3d12_screen *screen, struct sw_winsys *winsys, IUnknow
 
    screen->bufmgr = d3d12_bufmgr_create(screen);
    screen->cache_bufmgr = pb_cache_manager_create(screen->bufmgr, 0xfffff, 2, 0, 64 * 1024 * 1024);
-   screen->slab_bufmgr = pb_slab_range_manager_create(screen->cache_bufmgr, 16, 512,
-                                                      D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+
+   /* Small upload and readback buffers are suballocated from 256KB slabs,
+    * which saves creating a committed resource for each of them. The
+    * smallest size is the CBV placement alignment, so that every
+    * suballocation can be bound as a constant buffer. */
+   screen->slab_bufmgr = pb_slab_range_manager_create(screen->cache_bufmgr,
+                                                      D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT,
+                                                      16 * 1024, 256 * 1024,
                                                       &desc);
    desc.usage = (pb_usage_flags)(PB_USAGE_CPU_READ_WRITE | PB_USAGE_GPU_WRITE);
-   screen->readback_slab_bufmgr = pb_slab_range_manager_create(screen->cache_bufmgr, 16, 512,
-                                                               D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+   screen->readback_slab_bufmgr = pb_slab_range_manager_create(screen->cache_bufmgr,
+                                                               D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT,
+                                                               16 * 1024, 256 * 1024,
                                                                &desc);
 
    screen->rtv_pool = d3d12_descriptor_pool_new(screen,
@@ -1019,6 +1069,17 @@ d3d12_init_screen(struct d3d12_screen *screen, struct sw_winsys *winsys, IUnknow
    d3d12_init_null_rtv(screen);
 
    screen->have_load_at_vertex = can_attribute_at_vertex(screen);
+
+   d3d12_disk_cache_create(screen);
+
+   /* Variants are compiled synchronously if this fails */
+   util_cpu_detect();
+   unsigned num_threads = MAX2(util_get_cpu_caps()->nr_cpus - 1, 1);
+   util_queue_init(&screen->compile_queue, "d3d12sh", 64, num_threads,
+                   UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                   UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY);
+   screen->base.set_max_shader_compiler_threads = d3d12_set_max_shader_compiler_threads;
+   screen->base.is_parallel_shader_compilation_finished = d3d12_is_parallel_shader_compilation_finished;
    return true;
 
 failed:
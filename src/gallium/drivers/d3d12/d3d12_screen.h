@@ -27,6 +27,7 @@
 #include "pipe/p_screen.h"
 
 #include "util/slab.h"
+#include "util/u_queue.h"
 #include "d3d12_descriptor_pool.h"
 
 #ifndef _WIN32
@@ -54,6 +55,8 @@ enum resource_dimension
    RESOURCE_DIMENSION_COUNT
 };
 
+struct disk_cache;
+
 struct d3d12_screen {
    struct pipe_screen base;
    struct sw_winsys *winsys;
@@ -75,6 +78,17 @@ struct d3d12_screen {
    struct d3d12_descriptor_handle null_srvs[RESOURCE_DIMENSION_COUNT];
    struct d3d12_descriptor_handle null_rtv;
 
+   /* cached PSO blobs, see create_gfx_pipeline_state() */
+   struct disk_cache *disk_cache;
+
+   /* NIR to DXIL compilation of shader variants, see compile_nir() */
+   struct util_queue compile_queue;
+
+   /* shared by blocking fence waits, see d3d12_fence_finish() */
+   mtx_t fence_wait_mutex;
+   HANDLE fence_event;
+   int fence_event_fd;
+
    /* capabilities */
    D3D_FEATURE_LEVEL max_feature_level;
    D3D12_FEATURE_DATA_ARCHITECTURE architecture;
@@ -746,6 +746,9 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
    struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
    struct sw_winsys *winsys = screen->winsys;
 
+   if (util_queue_is_initialized(&screen->fs_compile_queue))
+      util_queue_destroy(&screen->fs_compile_queue);
+
    if (screen->cs_tpool)
       lp_cs_tpool_destroy(screen->cs_tpool);
 
@@ -821,6 +824,7 @@ static void lp_disk_cache_create(struct llvmpipe_screen *screen)
    unsigned gallivm_perf = gallivm_get_perf_flags();
    unsigned char sha1[20];
    char cache_id[20 * 2 + 1];
+   char *target_id;
    _mesa_sha1_init(&ctx);
 
    if (!disk_cache_get_function_identifier(lp_disk_cache_create, &ctx) ||
@@ -828,6 +832,19 @@ static void lp_disk_cache_create(struct llvmpipe_screen *screen)
       return;
 
    _mesa_sha1_update(&ctx, &gallivm_perf, sizeof(gallivm_perf));
+
+   /* The cache directory may be shared between different hosts, and with
+    * a statically linked LLVM the identifiers above don't cover its
+    * version.
+    */
+   _mesa_sha1_update(&ctx, MESA_LLVM_VERSION_STRING,
+                     strlen(MESA_LLVM_VERSION_STRING));
+   _mesa_sha1_update(&ctx, &lp_native_vector_width,
+                     sizeof(lp_native_vector_width));
+   target_id = lp_build_get_host_target_id();
+   _mesa_sha1_update(&ctx, target_id, strlen(target_id));
+   free(target_id);
+
    _mesa_sha1_final(&ctx, sha1);
    disk_cache_format_hex_id(cache_id, sha1, 20 * 2);
 
@@ -954,6 +971,14 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    }
    (void) mtx_init(&screen->cs_mutex, mtx_plain);
 
+   /* Leave most of the cores to the rasterizer.  Without a queue the
+    * variants are simply compiled synchronously.
+    */
+   if (screen->num_threads)
+      util_queue_init(&screen->fs_compile_queue, "lpfs", 64,
+                      MAX2(screen->num_threads / 4, 1),
+                      UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+
    lp_disk_cache_create(screen);
    return &screen->base;
 }
@@ -37,6 +37,7 @@
 #include "pipe/p_screen.h"
 #include "pipe/p_defines.h"
 #include "os/os_thread.h"
+#include "util/u_queue.h"
 #include "gallivm/lp_bld.h"
 #include "gallivm/lp_bld_misc.h"
 
@@ -61,6 +62,11 @@ struct llvmpipe_screen
    struct lp_cs_tpool *cs_tpool;
    mtx_t cs_mutex;
 
+   /* For compiling fragment shader variants in the background, only
+    * initialized when there are rasterizer threads.
+    */
+   struct util_queue fs_compile_queue;
+
    bool use_tgsi;
    bool allow_cl;
 
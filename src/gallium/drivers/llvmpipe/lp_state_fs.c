@@ -3456,7 +3456,8 @@ lp_debug_fs_variant(struct lp_fragment_shader_variant *variant)
 
 static void
 lp_fs_get_ir_cache_key(struct lp_fragment_shader_variant *variant,
-                            unsigned char ir_sha1_cache_key[20])
+                       unsigned partial_mask,
+                       unsigned char ir_sha1_cache_key[20])
 {
    struct blob blob = { 0 };
    unsigned ir_size;
@@ -3470,12 +3471,132 @@ lp_fs_get_ir_cache_key(struct lp_fragment_shader_variant *variant,
    struct mesa_sha1 ctx;
    _mesa_sha1_init(&ctx);
    _mesa_sha1_update(&ctx, &variant->key, variant->shader->variant_key_size);
+   _mesa_sha1_update(&ctx, &partial_mask, sizeof(partial_mask));
    _mesa_sha1_update(&ctx, ir_binary, ir_size);
    _mesa_sha1_final(&ctx, ir_sha1_cache_key);
 
    blob_finish(&blob);
 }
 
+struct lp_fs_whole_job {
+   struct llvmpipe_screen *screen;
+   struct lp_fragment_shader_variant *variant;
+   LLVMContextRef context;
+   struct gallivm_state *gallivm;
+   LLVMValueRef function;
+   struct lp_cached_code cached;
+   unsigned char ir_sha1_cache_key[20];
+   bool needs_caching;
+};
+
+static void
+compile_whole_variant(void *data, int thread_index)
+{
+   struct lp_fs_whole_job *job = data;
+   lp_jit_frag_func jit_func;
+
+   gallivm_compile_module(job->gallivm);
+
+   jit_func = (lp_jit_frag_func)gallivm_jit_function(job->gallivm,
+                                                     job->function);
+
+   if (job->needs_caching)
+      lp_disk_cache_insert_shader(job->screen, &job->cached,
+                                  job->ir_sha1_cache_key);
+
+   gallivm_free_ir(job->gallivm);
+   LLVMContextDispose(job->context);
+   job->context = NULL;
+
+   /* Scenes being rasterized may pick up the new function for their
+    * remaining tiles, which is fine as both produce the same results.
+    */
+   p_atomic_set(&job->variant->jit_function[RAST_WHOLE], jit_func);
+}
+
+static void
+free_whole_job(void *data, int thread_index)
+{
+   struct lp_fs_whole_job *job = data;
+
+   /* The job was dropped before it could run */
+   if (job->context) {
+      gallivm_free_ir(job->gallivm);
+      LLVMContextDispose(job->context);
+   }
+   FREE(job);
+}
+
+/**
+ * Build the RAST_WHOLE function of an opaque variant in a module and LLVM
+ * context of its own, and optimize and compile it in the background.  The
+ * variant can be used right away, the edge test function handles whole
+ * tiles until then.
+ */
+static void
+generate_whole_variant(struct llvmpipe_context *lp,
+                       struct lp_fragment_shader *shader,
+                       struct lp_fragment_shader_variant *variant,
+                       const char *module_name)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+   struct gallivm_state *gallivm = variant->gallivm;
+   LLVMTypeRef jit_context_ptr_type = variant->jit_context_ptr_type;
+   LLVMTypeRef jit_thread_data_ptr_type = variant->jit_thread_data_ptr_type;
+   struct lp_fs_whole_job *job;
+   char whole_name[64];
+
+   job = CALLOC_STRUCT(lp_fs_whole_job);
+   if (!job)
+      return;
+
+   job->screen = screen;
+   job->variant = variant;
+
+   if (shader->base.ir.nir) {
+      lp_fs_get_ir_cache_key(variant, RAST_WHOLE, job->ir_sha1_cache_key);
+
+      lp_disk_cache_find_shader(screen, &job->cached, job->ir_sha1_cache_key);
+      if (!job->cached.data_size)
+         job->needs_caching = true;
+   }
+
+   job->context = LLVMContextCreate();
+   snprintf(whole_name, sizeof(whole_name), "%s_whole", module_name);
+   job->gallivm = gallivm_create(whole_name, job->context, &job->cached);
+   if (!job->gallivm) {
+      LLVMContextDispose(job->context);
+      FREE(job);
+      return;
+   }
+
+   /* The JIT types are per LLVM context */
+   variant->gallivm = job->gallivm;
+   variant->jit_context_ptr_type = NULL;
+   variant->jit_thread_data_ptr_type = NULL;
+   lp_jit_init_types(variant);
+
+   generate_fragment(lp, shader, variant, RAST_WHOLE);
+   variant->nr_instrs += lp_build_count_ir_module(job->gallivm->module);
+   job->function = variant->function[RAST_WHOLE];
+
+   variant->gallivm = gallivm;
+   variant->jit_context_ptr_type = jit_context_ptr_type;
+   variant->jit_thread_data_ptr_type = jit_thread_data_ptr_type;
+   variant->function[RAST_WHOLE] = NULL;
+
+   variant->gallivm_whole = job->gallivm;
+   util_queue_fence_init(&variant->whole_ready);
+
+   if (util_queue_is_initialized(&screen->fs_compile_queue)) {
+      util_queue_add_job(&screen->fs_compile_queue, job, &variant->whole_ready,
+                         compile_whole_variant, free_whole_job, 0);
+   } else {
+      compile_whole_variant(job, 0);
+      free_whole_job(job, 0);
+   }
+}
+
 /**
  * Generate a new fragment shader variant from the shader code and
  * other state indicated by the key.
@@ -3507,7 +3628,7 @@ generate_variant(struct llvmpipe_context *lp,
    memcpy(&variant->key, key, shader->variant_key_size);
 
    if (shader->base.ir.nir) {
-      lp_fs_get_ir_cache_key(variant, ir_sha1_cache_key);
+      lp_fs_get_ir_cache_key(variant, RAST_EDGE_TEST, ir_sha1_cache_key);
 
       lp_disk_cache_find_shader(screen, &cached, ir_sha1_cache_key);
       if (!cached.data_size)
@@ -3552,16 +3673,8 @@ generate_variant(struct llvmpipe_context *lp,
    }
 
    lp_jit_init_types(variant);
-   
-   if (variant->jit_function[RAST_EDGE_TEST] == NULL)
-      generate_fragment(lp, shader, variant, RAST_EDGE_TEST);
-
-   if (variant->jit_function[RAST_WHOLE] == NULL) {
-      if (variant->opaque) {
-         /* Specialized shader, which doesn't need to read the color buffer. */
-         generate_fragment(lp, shader, variant, RAST_WHOLE);
-      }
-   }
+
+   generate_fragment(lp, shader, variant, RAST_EDGE_TEST);
 
    /*
     * Compile everything
@@ -3571,19 +3684,10 @@ generate_variant(struct llvmpipe_context *lp,
 
    variant->nr_instrs += lp_build_count_ir_module(variant->gallivm->module);
 
-   if (variant->function[RAST_EDGE_TEST]) {
-      variant->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
-            gallivm_jit_function(variant->gallivm,
-                                 variant->function[RAST_EDGE_TEST]);
-   }
-
-   if (variant->function[RAST_WHOLE]) {
-         variant->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
-               gallivm_jit_function(variant->gallivm,
-                                    variant->function[RAST_WHOLE]);
-   } else if (!variant->jit_function[RAST_WHOLE]) {
-      variant->jit_function[RAST_WHOLE] = variant->jit_function[RAST_EDGE_TEST];
-   }
+   variant->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
+         gallivm_jit_function(variant->gallivm,
+                              variant->function[RAST_EDGE_TEST]);
+   variant->jit_function[RAST_WHOLE] = variant->jit_function[RAST_EDGE_TEST];
 
    if (needs_caching) {
       lp_disk_cache_insert_shader(screen, &cached, ir_sha1_cache_key);
@@ -3591,6 +3695,11 @@ generate_variant(struct llvmpipe_context *lp,
 
    gallivm_free_ir(variant->gallivm);
 
+   if (variant->opaque) {
+      /* Specialized shader, which doesn't need to read the color buffer. */
+      generate_whole_variant(lp, shader, variant, module_name);
+   }
+
    return variant;
 }
 
@@ -3750,6 +3859,15 @@ void
 llvmpipe_destroy_shader_variant(struct llvmpipe_context *lp,
                                struct lp_fragment_shader_variant *variant)
 {
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+
+   if (variant->gallivm_whole) {
+      if (util_queue_is_initialized(&screen->fs_compile_queue))
+         util_queue_drop_job(&screen->fs_compile_queue, &variant->whole_ready);
+      util_queue_fence_destroy(&variant->whole_ready);
+      gallivm_destroy(variant->gallivm_whole);
+   }
+
    gallivm_destroy(variant->gallivm);
 
    lp_fs_reference(lp, &variant->shader, NULL);
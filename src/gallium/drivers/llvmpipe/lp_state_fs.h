@@ -37,6 +37,7 @@
 #include "gallivm/lp_bld_tgsi.h" /* for lp_tgsi_info */
 #include "lp_bld_interp.h" /* for struct lp_shader_input */
 #include "util/u_inlines.h"
+#include "util/u_queue.h"
 #include "lp_jit.h"
 
 struct tgsi_token;
@@ -150,6 +151,13 @@ struct lp_fragment_shader_variant
 
    lp_jit_frag_func jit_function[2];
 
+   /* The RAST_WHOLE function of opaque variants has a module of its own,
+    * which is compiled in the background.  Until it is ready, whole tiles
+    * are shaded with the RAST_EDGE_TEST function.
+    */
+   struct gallivm_state *gallivm_whole;
+   struct util_queue_fence whole_ready;
+
    /* Total number of LLVM instructions generated */
    unsigned nr_instrs;
 
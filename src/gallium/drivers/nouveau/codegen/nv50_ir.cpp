@@ -23,6 +23,7 @@
 #include "codegen/nv50_ir.h"
 #include "codegen/nv50_ir_target.h"
 #include "codegen/nv50_ir_driver.h"
+#include "util/os_time.h"
 
 extern "C" {
 #include "nouveau_debug.h"
@@ -582,6 +583,7 @@ void Instruction::init()
    ipa = 0;
    mask = 0;
    precise = 0;
+   alignLog2 = 0;
 
    lanes = 0xf;
 
@@ -606,6 +608,8 @@ Instruction::Instruction()
 }
 
 Instruction::Instruction(Function *fn, operation opr, DataType ty)
+   : defs(&fn->getProgram()->mem_Operands),
+     srcs(&fn->getProgram()->mem_Operands)
 {
    init();
 
@@ -771,6 +775,7 @@ Instruction::clone(ClonePolicy<Function>& pol, Instruction *i) const
    i->ipa = ipa;
    i->lanes = lanes;
    i->perPatch = perPatch;
+   i->alignLog2 = alignLog2;
 
    i->postFactor = postFactor;
 
@@ -1187,6 +1192,11 @@ Program::Program(Type type, Target *arch)
    binSize = 0;
 
    maxGPR = -1;
+   stalls = 0;
+   reuseHits = 0;
+   gprReads = 0;
+   spills = 0;
+   fills = 0;
    fp64 = false;
    persampleInvocation = false;
 
@@ -1201,6 +1211,13 @@ Program::Program(Type type, Target *arch)
 
 Program::~Program()
 {
+   // everything goes away at once, don't bother unlinking each reference
+   for (ArrayList::Iterator it = allRValues.iterator(); !it.end(); it.next()) {
+      Value *v = reinterpret_cast<Value *>(it.get());
+      v->uses.clear();
+      v->defs.clear();
+   }
+
    for (ArrayList::Iterator it = allFuncs.iterator(); !it.end(); it.next())
       delete reinterpret_cast<Function *>(it.get());
 
@@ -1274,11 +1291,22 @@ nv50_ir_init_prog_info(struct nv50_ir_prog_info *info,
    info_out->io.sampleMask = 0xff;
 }
 
+// Adds the time passed since @start to @phase, returns the current time.
+static int64_t
+nv50_ir_time_phase(struct nv50_ir_prog_info_out *info_out,
+                   enum nv50_ir_compile_phase phase, int64_t start)
+{
+   const int64_t now = os_time_get_nano();
+   info_out->bin.phaseUs[phase] += (now - start) / 1000;
+   return now;
+}
+
 int
 nv50_ir_generate_code(struct nv50_ir_prog_info *info,
                       struct nv50_ir_prog_info_out *info_out)
 {
    int ret = 0;
+   int64_t time = os_time_get_nano();
 
    nv50_ir::Program::Type type;
 
@@ -1329,6 +1357,7 @@ nv50_ir_generate_code(struct nv50_ir_prog_info *info,
       goto out;
    if (prog->dbgFlags & NV50_IR_DEBUG_VERBOSE)
       prog->print();
+   time = nv50_ir_time_phase(info_out, NV50_IR_PHASE_FRONTEND, time);
 
    targ->parseDriverInfo(info, info_out);
    prog->getTarget()->runLegalizePass(prog, nv50_ir::CG_STAGE_PRE_SSA);
@@ -1343,11 +1372,13 @@ nv50_ir_generate_code(struct nv50_ir_prog_info *info,
 
    if (prog->dbgFlags & NV50_IR_DEBUG_BASIC)
       prog->print();
+   time = nv50_ir_time_phase(info_out, NV50_IR_PHASE_OPT, time);
 
    if (!prog->registerAllocation()) {
       ret = -4;
       goto out;
    }
+   time = nv50_ir_time_phase(info_out, NV50_IR_PHASE_RA, time);
    prog->getTarget()->runLegalizePass(prog, nv50_ir::CG_STAGE_POST_RA);
 
    prog->optimizePostRA(info->optLevel);
@@ -1356,6 +1387,7 @@ nv50_ir_generate_code(struct nv50_ir_prog_info *info,
       ret = -5;
       goto out;
    }
+   nv50_ir_time_phase(info_out, NV50_IR_PHASE_EMIT, time);
 
 out:
    INFO_DBG(prog->dbgFlags, VERBOSE, "nv50_ir_generate_code: ret = %i\n", ret);
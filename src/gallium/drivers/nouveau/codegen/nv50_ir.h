@@ -939,6 +939,7 @@ public:
    unsigned mask       : 4; // for vector ops
    // prevent algebraic optimisations that aren't bit-for-bit identical
    unsigned precise    : 1;
+   unsigned alignLog2  : 3; // known alignment of the address of ld/st
 
    int8_t postFactor; // MUL/DIV(if < 0) by 1 << postFactor
 
@@ -951,8 +952,8 @@ public:
    BasicBlock *bb;
 
 protected:
-   std::deque<ValueDef> defs; // no gaps !
-   std::deque<ValueRef> srcs; // no gaps !
+   std::deque<ValueDef, PoolAllocator<ValueDef> > defs; // no gaps !
+   std::deque<ValueRef, PoolAllocator<ValueRef> > srcs; // no gaps !
 
    // instruction specific methods:
    // (don't want to subclass, would need more constructors and memory pools)
@@ -1319,6 +1320,7 @@ public:
    bool convertToSSA();
    bool optimizeSSA(int level);
    bool optimizePostRA(int level);
+   bool schedulePreRA();
    bool registerAllocation();
    bool emitBinary(struct nv50_ir_prog_info_out *);
 
@@ -1340,6 +1342,11 @@ public:
    uint32_t tlsSize; // size required for FILE_MEMORY_LOCAL
 
    int maxGPR;
+   uint32_t stalls; // sum of the issue delays chosen by the target
+   uint32_t reuseHits; // GPR sources read from the operand reuse cache
+   uint32_t gprReads; // GPR sources of instructions supporting reuse
+   uint32_t spills; // spill stores to FILE_MEMORY_LOCAL
+   uint32_t fills; // spill loads from FILE_MEMORY_LOCAL
    bool fp64;
    bool persampleInvocation;
 
@@ -1350,6 +1357,7 @@ public:
    MemoryPool mem_LValue;
    MemoryPool mem_Symbol;
    MemoryPool mem_ImmediateValue;
+   BlockPool mem_Operands; // instruction operand arrays
 
    uint32_t dbgFlags;
    uint8_t  optLevel;
@@ -61,6 +61,17 @@ Function::~Function()
    ins.clear();
    outs.clear();
 
+   // The instructions and values all die together, so drop the use and def
+   // lists up front instead of unlinking every operand one by one, and keep
+   // the instructions from removing themselves from their blocks.
+   for (ArrayList::Iterator it = allLValues.iterator(); !it.end(); it.next()) {
+      LValue *lval = reinterpret_cast<LValue *>(it.get());
+      lval->uses.clear();
+      lval->defs.clear();
+   }
+   for (ArrayList::Iterator it = allInsns.iterator(); !it.end(); it.next())
+      reinterpret_cast<Instruction *>(it.get())->bb = NULL;
+
    for (ArrayList::Iterator it = allInsns.iterator(); !it.end(); it.next())
       delete_Instruction(prog, reinterpret_cast<Instruction *>(it.get()));
 
@@ -131,6 +131,16 @@ struct nv50_ir_prog_info
    int (*assignSlots)(struct nv50_ir_prog_info_out *);
 };
 
+/* parts of nv50_ir_generate_code which are timed separately */
+enum nv50_ir_compile_phase
+{
+   NV50_IR_PHASE_FRONTEND, /* TGSI or NIR to nv50 IR */
+   NV50_IR_PHASE_OPT,      /* SSA construction and optimization */
+   NV50_IR_PHASE_RA,       /* register allocation, including spilling */
+   NV50_IR_PHASE_EMIT,     /* post-RA optimization, scheduling and emission */
+   NV50_IR_PHASE_COUNT
+};
+
 /* the produced binary with metadata */
 struct nv50_ir_prog_info_out
 {
@@ -145,6 +155,12 @@ struct nv50_ir_prog_info_out
       uint32_t *code;
       uint32_t codeSize;
       uint32_t instructions;
+      uint32_t stalls;    /* sum of stall counts, if scheduled in software */
+      uint32_t reuseHits; /* GPR sources read from the operand reuse cache */
+      uint32_t gprReads;  /* GPR sources of instructions supporting reuse */
+      uint32_t spills;    /* stores of spilled values to local memory */
+      uint32_t fills;     /* loads of spilled values from local memory */
+      uint32_t phaseUs[NV50_IR_PHASE_COUNT]; /* compile time, 0 if cached */
       void *relocData;
       void *fixupData;
    } bin;
@@ -199,6 +215,7 @@ struct nv50_ir_prog_info_out
       uint8_t globalAccess;      /* 1 for read, 2 for wr, 3 for rw */
       bool fp64;                 /* program uses fp64 math */
       bool layer_viewport_relative;
+      bool mul_zero_wins;        /* program wants for x*0 = 0 */
    } io;
 
    uint8_t numBarriers;
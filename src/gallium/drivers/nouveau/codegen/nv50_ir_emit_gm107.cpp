@@ -3869,6 +3869,51 @@ SchedDataCalculatorGM107::getWtDepBar(const Instruction *insn) const
    return (insn->sched & 0x01f800) >> 11;
 }
 
+// Return the mask of source slots of insn which can be kept in the operand
+// reuse cache for next. The next instruction has to read the same GPR id in
+// the same operand slot, and insn must not overwrite it.
+static unsigned int
+getReuseMask(const TargetGM107 *targ, const Instruction *insn,
+             const Instruction *next)
+{
+   unsigned int mask = 0;
+
+   if (!insn || !next || !targ->isReuseSupported(insn))
+      return 0;
+   if (typeSizeof(insn->sType) != 4)
+      return 0;
+
+   for (int s = 0; s < 4 && insn->srcExists(s); s++) {
+      const Value *src = insn->src(s).rep();
+      if (insn->src(s).getFile() != FILE_GPR || src->reg.data.id == 255)
+         continue;
+      if (!next->srcExists(s) || next->src(s).getFile() != FILE_GPR)
+         continue;
+      if (src->reg.data.id != next->getSrc(s)->reg.data.id)
+         continue;
+
+      bool written = false;
+      for (int d = 0; insn->defExists(d) && !written; ++d) {
+         const Value *def = insn->def(d).rep();
+         if (insn->def(d).getFile() != FILE_GPR)
+            continue;
+         if (typeSizeof(insn->dType) != 4 || def->reg.data.id == 255)
+            continue;
+         written = def->reg.data.id == src->reg.data.id;
+      }
+      if (!written)
+         mask |= 1 << s;
+   }
+   return mask;
+}
+
+static inline int
+getReuseCount(const TargetGM107 *targ, const Instruction *insn,
+              const Instruction *next)
+{
+   return util_bitcount(getReuseMask(targ, insn, next));
+}
+
 // Emit the reuse flag which allows to make use of the new memory hierarchy
 // introduced since Maxwell, the operand reuse cache.
 //
@@ -3879,36 +3924,29 @@ SchedDataCalculatorGM107::getWtDepBar(const Instruction *insn) const
 void
 SchedDataCalculatorGM107::setReuseFlag(Instruction *insn)
 {
-   Instruction *next = insn->next;
-   BitSet defs(255, 1);
+   const unsigned int mask = getReuseMask(targ, insn, insn->next);
 
-   if (!targ->isReuseSupported(insn))
-      return;
-
-   for (int d = 0; insn->defExists(d); ++d) {
-      const Value *def = insn->def(d).rep();
-      if (insn->def(d).getFile() != FILE_GPR)
-         continue;
-      if (typeSizeof(insn->dType) != 4 || def->reg.data.id == 255)
-         continue;
-      defs.set(def->reg.data.id);
+   for (int s = 0; s < 4; ++s) {
+      if (mask & (1 << s))
+         emitReuse(insn, s);
    }
+   insn->bb->getProgram()->reuseHits += util_bitcount(mask);
+}
 
-   for (int s = 0; insn->srcExists(s); s++) {
-      const Value *src = insn->src(s).rep();
-      if (insn->src(s).getFile() != FILE_GPR)
-         continue;
-      if (typeSizeof(insn->sType) != 4 || src->reg.data.id == 255)
-         continue;
-      if (defs.test(src->reg.data.id))
-         continue;
-      if (!next->srcExists(s) || next->src(s).getFile() != FILE_GPR)
-         continue;
-      if (src->reg.data.id != next->getSrc(s)->reg.data.id)
-         continue;
-      assert(s < 4);
-      emitReuse(insn, s);
+// Count the GPR sources which could be read from the operand reuse cache.
+int
+SchedDataCalculatorGM107::countGPRReads(const Instruction *insn) const
+{
+   int n = 0;
+
+   if (!targ->isReuseSupported(insn) || typeSizeof(insn->sType) != 4)
+      return 0;
+   for (int s = 0; s < 4 && insn->srcExists(s); ++s) {
+      if (insn->src(s).getFile() == FILE_GPR &&
+          insn->src(s).rep()->reg.data.id != 255)
+         ++n;
    }
+   return n;
 }
 
 void
@@ -4365,6 +4403,9 @@ SchedDataCalculatorGM107::visit(BasicBlock *bb)
          emitWtDepBar(start, b);
    }
 
+   for (insn = bb->getEntry(); insn; insn = insn->next)
+      bb->getProgram()->gprReads += countGPRReads(insn);
+
    for (insn = bb->getEntry(); insn && insn->next; insn = insn->next) {
       next = insn->next;
 
@@ -4428,10 +4469,192 @@ SchedDataCalculatorGM107::visit(BasicBlock *bb)
    setDelay(insn, bbDelay, next);
    cycle += getStall(insn);
 
+   // every stall count is at least one, so this is the number of cycles
+   // needed to issue the block without waiting on dependency barriers
+   bb->getProgram()->stalls += cycle;
+
    score->rebase(cycle); // common base for initializing out blocks' scores
    return true;
 }
 
+/*******************************************************************************
+ * operand reuse
+ ******************************************************************************/
+
+// Move independent instructions next to each other and pick the source order
+// of commutative ones, so that more operands can be read from the operand
+// reuse cache (see setReuseFlag). This runs after register allocation and
+// before the scheduling data is computed.
+class OperandReuseGM107 : public Pass
+{
+public:
+   OperandReuseGM107(const TargetGM107 *targ) : targ(targ) { }
+
+private:
+   virtual bool visit(BasicBlock *);
+
+   bool isMovable(const Instruction *) const;
+   bool isSwappable(const Instruction *) const;
+   int countAround(const Instruction *) const;
+
+   bool trySwap(Instruction *);
+   bool tryMoveUp(Instruction *);
+
+   const TargetGM107 *targ;
+};
+
+// how far ahead to look for an instruction sharing operands
+#define GM107_REUSE_WINDOW 4
+
+bool
+OperandReuseGM107::isMovable(const Instruction *insn) const
+{
+   if (insn->fixed || insn->join || insn->terminator || insn->asFlow())
+      return false;
+   if (!targ->isReuseSupported(insn) || targ->isBarrierRequired(insn))
+      return false;
+
+   for (int d = 0; insn->defExists(d); ++d) {
+      switch (insn->def(d).getFile()) {
+      case FILE_GPR:
+      case FILE_PREDICATE:
+      case FILE_FLAGS:
+         break;
+      default:
+         return false;
+      }
+   }
+   for (int s = 0; insn->srcExists(s); ++s) {
+      switch (insn->src(s).getFile()) {
+      case FILE_GPR:
+      case FILE_PREDICATE:
+      case FILE_FLAGS:
+      case FILE_IMMEDIATE:
+      case FILE_MEMORY_CONST:
+         break;
+      default:
+         return false;
+      }
+   }
+   return true;
+}
+
+// Only swap plain 32-bit GPR sources of operations which are symmetric in
+// their first two sources, so that the encoding does not change.
+bool
+OperandReuseGM107::isSwappable(const Instruction *insn) const
+{
+   switch (insn->op) {
+   case OP_ADD:
+   case OP_MUL:
+   case OP_MAD:
+   case OP_FMA:
+   case OP_AND:
+   case OP_OR:
+   case OP_XOR:
+   case OP_MIN:
+   case OP_MAX:
+      break;
+   default:
+      return false;
+   }
+   if (insn->subOp || typeSizeof(insn->sType) != 4)
+      return false;
+   if (insn->predSrc == 0 || insn->predSrc == 1 ||
+       insn->flagsSrc == 0 || insn->flagsSrc == 1)
+      return false;
+
+   for (int s = 0; s < 2; ++s) {
+      if (!insn->srcExists(s) || insn->src(s).getFile() != FILE_GPR)
+         return false;
+      if (insn->src(s).mod || insn->src(s).isIndirect(0))
+         return false;
+   }
+   return true;
+}
+
+int
+OperandReuseGM107::countAround(const Instruction *insn) const
+{
+   return getReuseCount(targ, insn->prev, insn) +
+          getReuseCount(targ, insn, insn->next);
+}
+
+bool
+OperandReuseGM107::trySwap(Instruction *insn)
+{
+   if (!isSwappable(insn))
+      return false;
+
+   const int count = countAround(insn);
+
+   insn->swapSources(0, 1);
+   if (countAround(insn) > count)
+      return true;
+   insn->swapSources(0, 1);
+   return false;
+}
+
+// If insn and its successor share no operands, look for a later instruction
+// which does and which can be moved in between.
+bool
+OperandReuseGM107::tryMoveUp(Instruction *insn)
+{
+   Instruction *next = insn->next;
+   Instruction *i;
+   int n;
+
+   if (!next || getReuseCount(targ, insn, next))
+      return false;
+
+   for (i = next->next, n = 0; i && n < GM107_REUSE_WINDOW; i = i->next, ++n) {
+      if (i->prev->fixed || i->prev->join || i->prev->asFlow())
+         break;
+      if (!isMovable(i))
+         continue;
+
+      const int gain = getReuseCount(targ, insn, i) +
+                       getReuseCount(targ, i, next) +
+                       getReuseCount(targ, i->prev, i->next) -
+                       getReuseCount(targ, i->prev, i) -
+                       getReuseCount(targ, i, i->next);
+      if (gain <= 0)
+         continue;
+
+      // don't make it wait for the result of insn
+      if (!insn->canCommuteDefSrc(i))
+         continue;
+
+      Instruction *k;
+      for (k = next; k != i; k = k->next) {
+         if (!k->isCommutationLegal(i))
+            break;
+      }
+      if (k != i)
+         continue;
+
+      insn->bb->remove(i);
+      insn->bb->insertAfter(insn, i);
+      return true;
+   }
+   return false;
+}
+
+bool
+OperandReuseGM107::visit(BasicBlock *bb)
+{
+   Instruction *insn;
+
+   for (insn = bb->getEntry(); insn; insn = insn->next) {
+      if (targ->isReuseSupported(insn))
+         tryMoveUp(insn);
+   }
+   for (insn = bb->getEntry(); insn; insn = insn->next)
+      trySwap(insn);
+
+   return true;
+}
+
 /*******************************************************************************
  * main
  ******************************************************************************/
@@ -4440,6 +4663,11 @@ void
 CodeEmitterGM107::prepareEmission(Function *func)
 {
    SchedDataCalculatorGM107 sched(targGM107);
+
+   if (func->getProgram()->optLevel >= 2) {
+      OperandReuseGM107 reuse(targGM107);
+      reuse.run(func, false, true);
+   }
    CodeEmitter::prepareEmission(func);
    sched.run(func, true, true);
 }
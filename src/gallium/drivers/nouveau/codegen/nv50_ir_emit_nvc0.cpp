@@ -3313,6 +3313,8 @@ SchedDataCalculator::visit(BasicBlock *bb)
    setDelay(insn, bbDelay, next);
    cycle += getCycles(insn, bbDelay);
 
+   bb->getProgram()->stalls += cycle;
+
    score->rebase(cycle); // common base for initializing out blocks' scores
    return true;
 }
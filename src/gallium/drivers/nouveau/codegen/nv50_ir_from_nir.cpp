@@ -113,6 +113,11 @@ private:
 
    uint32_t getSlotAddress(nir_intrinsic_instr *, uint8_t idx, uint8_t slot);
 
+   // passes the address alignment known for a memory intrinsic on to the
+   // loads and stores emitted for it after the given instruction
+   void setMemoryAlignment(nir_intrinsic_instr *, Instruction *pos,
+                           uint32_t offset);
+
    void setInterpolate(nv50_ir_varying *,
                        uint8_t,
                        bool centroid,
@@ -840,6 +845,25 @@ Converter::getIndirect(nir_intrinsic_instr *insn, uint8_t s, uint8_t c, Value *&
    return idx;
 }
 
+void
+Converter::setMemoryAlignment(nir_intrinsic_instr *insn, Instruction *pos,
+                              uint32_t offset)
+{
+   if (!nir_intrinsic_has_align(insn))
+      return;
+
+   const uint32_t align = nir_intrinsic_align(insn);
+
+   for (Instruction *i = pos ? pos->next : bb->getEntry(); i; i = i->next) {
+      if (i->op != OP_LOAD && i->op != OP_STORE)
+         continue;
+      // the accesses of components are relative to the address of insn
+      const uint32_t delta = i->getSrc(0)->reg.data.offset - offset;
+      const uint32_t a = delta ? MIN2(align, delta & -delta) : align;
+      i->alignLog2 = MIN2(util_logbase2(a), 7);
+   }
+}
+
 static void
 vert_attrib_to_tgsi_semantic(gl_vert_attrib slot, unsigned *name, unsigned *index)
 {
@@ -2014,6 +2038,7 @@ Converter::visit(nir_intrinsic_instr *insn)
       Value *indirectOffset;
       uint32_t buffer = getIndirect(&insn->src[1], 0, indirectBuffer);
       uint32_t offset = getIndirect(&insn->src[2], 0, indirectOffset);
+      Instruction *pos = bb->getExit();
 
       for (uint8_t i = 0u; i < nir_intrinsic_src_components(insn, 0); ++i) {
          if (!((1u << i) & nir_intrinsic_write_mask(insn)))
@@ -2023,6 +2048,7 @@ Converter::visit(nir_intrinsic_instr *insn)
          mkStore(OP_STORE, sType, sym, indirectOffset, getSrc(&insn->src[0], i))
             ->setIndirect(0, 1, indirectBuffer);
       }
+      setMemoryAlignment(insn, pos, offset);
       info_out->io.globalAccess |= 0x2;
       break;
    }
@@ -2033,10 +2059,12 @@ Converter::visit(nir_intrinsic_instr *insn)
       Value *indirectOffset;
       uint32_t buffer = getIndirect(&insn->src[0], 0, indirectBuffer);
       uint32_t offset = getIndirect(&insn->src[1], 0, indirectOffset);
+      Instruction *pos = bb->getExit();
 
       for (uint8_t i = 0u; i < dest_components; ++i)
          loadFrom(FILE_MEMORY_BUFFER, buffer, dType, newDefs[i], offset, i,
                   indirectOffset, indirectBuffer);
+      setMemoryAlignment(insn, pos, offset);
 
       info_out->io.globalAccess |= 0x1;
       break;
@@ -2282,6 +2310,7 @@ Converter::visit(nir_intrinsic_instr *insn)
       DataType sType = getSType(insn->src[0], false, false);
       Value *indirectOffset;
       uint32_t offset = getIndirect(&insn->src[1], 0, indirectOffset);
+      Instruction *pos = bb->getExit();
 
       for (uint8_t i = 0u; i < nir_intrinsic_src_components(insn, 0); ++i) {
          if (!((1u << i) & nir_intrinsic_write_mask(insn)))
@@ -2289,6 +2318,7 @@ Converter::visit(nir_intrinsic_instr *insn)
          Symbol *sym = mkSymbol(getFile(op), 0, sType, offset + i * typeSizeof(sType));
          mkStore(OP_STORE, sType, sym, indirectOffset, getSrc(&insn->src[0], i));
       }
+      setMemoryAlignment(insn, pos, offset);
       break;
    }
    case nir_intrinsic_load_kernel_input:
@@ -2298,9 +2328,11 @@ Converter::visit(nir_intrinsic_instr *insn)
       LValues &newDefs = convert(&insn->dest);
       Value *indirectOffset;
       uint32_t offset = getIndirect(&insn->src[0], 0, indirectOffset);
+      Instruction *pos = bb->getExit();
 
       for (uint8_t i = 0u; i < dest_components; ++i)
          loadFrom(getFile(op), 0, dType, newDefs[i], offset, i, indirectOffset);
+      setMemoryAlignment(insn, pos, offset);
 
       break;
    }
@@ -2338,15 +2370,18 @@ Converter::visit(nir_intrinsic_instr *insn)
       LValues &newDefs = convert(&insn->dest);
       Value *indirectOffset;
       uint32_t offset = getIndirect(&insn->src[0], 0, indirectOffset);
+      Instruction *pos = bb->getExit();
 
       for (auto i = 0u; i < dest_components; ++i)
          loadFrom(FILE_MEMORY_GLOBAL, 0, dType, newDefs[i], offset, i, indirectOffset);
+      setMemoryAlignment(insn, pos, offset);
 
       info_out->io.globalAccess |= 0x1;
       break;
    }
    case nir_intrinsic_store_global: {
       DataType sType = getSType(insn->src[0], false, false);
+      Instruction *pos = bb->getExit();
 
       for (auto i = 0u; i < nir_intrinsic_src_components(insn, 0); ++i) {
          if (!((1u << i) & nir_intrinsic_write_mask(insn)))
@@ -2365,6 +2400,7 @@ Converter::visit(nir_intrinsic_instr *insn)
             mkStore(OP_STORE, sType, sym, getSrc(&insn->src[1], 0), getSrc(&insn->src[0], i));
          }
       }
+      setMemoryAlignment(insn, pos, 0);
 
       info_out->io.globalAccess |= 0x2;
       break;
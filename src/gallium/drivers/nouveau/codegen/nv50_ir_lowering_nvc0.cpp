@@ -3331,7 +3331,11 @@ TargetNVC0::runLegalizePass(Program *prog, CGStage stage) const
    } else
    if (stage == CG_STAGE_SSA) {
       NVC0LegalizeSSA pass;
-      return pass.run(prog, false, true);
+      if (!pass.run(prog, false, true))
+         return false;
+      if (prog->optLevel >= 3)
+         return prog->schedulePreRA();
+      return true;
    }
    return false;
 }
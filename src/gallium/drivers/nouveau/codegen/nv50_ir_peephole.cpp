@@ -28,6 +28,8 @@ extern "C" {
 #include "util/u_math.h"
 }
 
+#include <algorithm>
+
 namespace nv50_ir {
 
 bool
@@ -370,6 +372,9 @@ public:
 private:
    virtual bool visit(BasicBlock *);
 
+   /* true if i was deleted */
+   bool fold(Instruction *i);
+
    void expr(Instruction *, ImmediateValue&, ImmediateValue&);
    void expr(Instruction *, ImmediateValue&, ImmediateValue&, ImmediateValue&);
    /* true if i was deleted */
@@ -385,20 +390,46 @@ private:
    bool createMul(DataType ty, Value *def, Value *a, int64_t b, Value *c);
 
    unsigned int foldCount;
+   unsigned int insnCount;
+
+   // values whose definitions were folded, their uses need to be revisited
+   std::deque<Value *> changed;
+   std::vector<Value *> foldDefs;
 
    BuildUtil bld;
 };
 
-// TODO: remember generated immediates and only revisit these
+// Fold everything once, then only revisit the users of values whose defining
+// instruction changed, since only those can have gained immediate sources.
 bool
 ConstantFolding::foldAll(Program *prog)
 {
-   unsigned int iterCount = 0;
-   do {
-      foldCount = 0;
-      if (!run(prog))
-         return false;
-   } while (foldCount && ++iterCount < 2);
+   std::vector<Instruction *> users;
+
+   foldCount = 0;
+   insnCount = 0;
+   changed.clear();
+   if (!run(prog))
+      return false;
+
+   // the only instruction a fold may delete is the one being folded, and
+   // values stay alive until their function is destroyed
+   unsigned int budget = insnCount;
+   while (!changed.empty() && budget) {
+      Value *val = changed.front();
+      changed.pop_front();
+
+      users.clear();
+      for (Value::UseIterator u = val->uses.begin(); u != val->uses.end(); ++u) {
+         Instruction *insn = (*u)->getInsn();
+         if (insn->bb &&
+             std::find(users.begin(), users.end(), insn) == users.end())
+            users.push_back(insn);
+      }
+
+      for (size_t n = 0; n < users.size() && budget; ++n, --budget)
+         fold(users[n]);
+   }
    return true;
 }
 
@@ -409,33 +440,49 @@ ConstantFolding::visit(BasicBlock *bb)
 
    for (i = bb->getEntry(); i; i = next) {
       next = i->next;
-      if (i->op == OP_MOV || i->op == OP_CALL)
-         continue;
+      ++insnCount;
+      fold(i);
+   }
+   return true;
+}
 
-      ImmediateValue src0, src1, src2;
+bool
+ConstantFolding::fold(Instruction *i)
+{
+   if (i->op == OP_MOV || i->op == OP_CALL)
+      return false;
 
-      if (i->srcExists(2) &&
-          i->src(0).getImmediate(src0) &&
-          i->src(1).getImmediate(src1) &&
-          i->src(2).getImmediate(src2)) {
-         expr(i, src0, src1, src2);
-      } else
-      if (i->srcExists(1) &&
-          i->src(0).getImmediate(src0) && i->src(1).getImmediate(src1)) {
-         expr(i, src0, src1);
-      } else
-      if (i->srcExists(0) && i->src(0).getImmediate(src0)) {
-         if (opnd(i, src0, 0))
-            continue;
-      } else
-      if (i->srcExists(1) && i->src(1).getImmediate(src1)) {
-         if (opnd(i, src1, 1))
-            continue;
-      }
-      if (i->srcExists(2) && i->src(2).getImmediate(src2))
-         opnd3(i, src2);
+   foldDefs.clear();
+   for (int d = 0; i->defExists(d); ++d)
+      foldDefs.push_back(i->getDef(d));
+
+   const unsigned int count = foldCount;
+   bool deleted = false;
+
+   ImmediateValue src0, src1, src2;
+
+   if (i->srcExists(2) &&
+       i->src(0).getImmediate(src0) &&
+       i->src(1).getImmediate(src1) &&
+       i->src(2).getImmediate(src2)) {
+      expr(i, src0, src1, src2);
+   } else
+   if (i->srcExists(1) &&
+       i->src(0).getImmediate(src0) && i->src(1).getImmediate(src1)) {
+      expr(i, src0, src1);
+   } else
+   if (i->srcExists(0) && i->src(0).getImmediate(src0)) {
+      deleted = opnd(i, src0, 0);
+   } else
+   if (i->srcExists(1) && i->src(1).getImmediate(src1)) {
+      deleted = opnd(i, src1, 1);
    }
-   return true;
+   if (!deleted && i->srcExists(2) && i->src(2).getImmediate(src2))
+      opnd3(i, src2);
+
+   if (foldCount != count)
+      changed.insert(changed.end(), foldDefs.begin(), foldDefs.end());
+   return deleted;
 }
 
 CmpInstruction *
@@ -2731,6 +2778,10 @@ private:
    void lockStores(Instruction *const ld);
    void reset();
 
+   BasicBlock *getIfHead(BasicBlock *join) const;
+   bool writesMemory(const BasicBlock *) const;
+   void addHeadLoads(BasicBlock *head);
+
 private:
    Record *prevRecord;
 };
@@ -2762,6 +2813,14 @@ MemoryOpt::reset()
    }
 }
 
+// Whether an access of @size bytes is naturally aligned, given the known
+// alignment of its address. 12 byte accesses need 16 byte alignment.
+static inline bool
+isAccessAligned(unsigned int alignLog2, int size)
+{
+   return (1 << alignLog2) >= (size == 12 ? 16 : size);
+}
+
 bool
 MemoryOpt::combineLd(Record *rec, Instruction *ld)
 {
@@ -2770,6 +2829,8 @@ MemoryOpt::combineLd(Record *rec, Instruction *ld)
    int sizeRc = rec->size;
    int sizeLd = typeSizeof(ld->dType);
    int size = sizeRc + sizeLd;
+   unsigned int alignLog2 =
+      offLd < offRc ? ld->alignLog2 : rec->insn->alignLog2;
    int d, j;
 
    if (!prog->getTarget()->
@@ -2779,8 +2840,10 @@ MemoryOpt::combineLd(Record *rec, Instruction *ld)
    if (((size == 0x8) && (MIN2(offLd, offRc) & 0x7)) ||
        ((size == 0xc) && (MIN2(offLd, offRc) & 0xf)))
       return false;
-   // for compute indirect loads are not guaranteed to be aligned
-   if (prog->getType() == Program::TYPE_COMPUTE && rec->rel[0])
+   // for compute indirect loads are not guaranteed to be aligned, unless
+   // the frontend told us about the alignment of the address
+   if (prog->getType() == Program::TYPE_COMPUTE && rec->rel[0] &&
+       !isAccessAligned(alignLog2, size))
       return false;
 
    assert(sizeRc + sizeLd <= 16 && offRc != offLd);
@@ -2816,6 +2879,7 @@ MemoryOpt::combineLd(Record *rec, Instruction *ld)
    rec->size = size;
    rec->insn->getSrc(0)->reg.size = size;
    rec->insn->setType(typeOfSize(size));
+   rec->insn->alignLog2 = alignLog2;
 
    delete_Instruction(prog, ld);
 
@@ -2831,6 +2895,8 @@ MemoryOpt::combineSt(Record *rec, Instruction *st)
    int sizeSt = typeSizeof(st->dType);
    int s = sizeSt / 4;
    int size = sizeRc + sizeSt;
+   unsigned int alignLog2 =
+      offSt < offRc ? st->alignLog2 : rec->insn->alignLog2;
    int j, k;
    Value *src[4]; // no modifiers in ValueRef allowed for st
    Value *extra[3];
@@ -2841,8 +2907,10 @@ MemoryOpt::combineSt(Record *rec, Instruction *st)
    // no unaligned stores
    if (size == 8 && MIN2(offRc, offSt) & 0x7)
       return false;
-   // for compute indirect stores are not guaranteed to be aligned
-   if (prog->getType() == Program::TYPE_COMPUTE && rec->rel[0])
+   // for compute indirect stores are not guaranteed to be aligned, unless
+   // the frontend told us about the alignment of the address
+   if (prog->getType() == Program::TYPE_COMPUTE && rec->rel[0] &&
+       !isAccessAligned(alignLog2, size))
       return false;
 
    // There's really no great place to put this in a generic manner. Seemingly
@@ -2893,6 +2961,7 @@ MemoryOpt::combineSt(Record *rec, Instruction *st)
    rec->size = size;
    rec->insn->getSrc(0)->reg.size = size;
    rec->insn->setType(typeOfSize(size));
+   rec->insn->alignLog2 = alignLog2;
    return true;
 }
 
@@ -3152,6 +3221,100 @@ MemoryOpt::visit(BasicBlock *bb)
    return ret;
 }
 
+static bool
+writesMemory(const Instruction *insn)
+{
+   switch (insn->op) {
+   case OP_STORE:
+   case OP_EXPORT:
+   case OP_ATOM:
+   case OP_SUSTB:
+   case OP_SUSTP:
+   case OP_SUREDB:
+   case OP_SUREDP:
+   case OP_CALL:
+   case OP_BAR:
+   case OP_MEMBAR:
+   case OP_CCTL:
+   case OP_EMIT:
+   case OP_RESTART:
+      return true;
+   default:
+      return insn->fixed;
+   }
+}
+
+bool
+MemoryOpt::writesMemory(const BasicBlock *bb) const
+{
+   for (Instruction *i = bb->getEntry(); i; i = i->next)
+      if (nv50_ir::writesMemory(i))
+         return true;
+   return false;
+}
+
+// If @join is the block where the sides of an if or if/else without any
+// nested control flow meet, return the block with the conditional branch.
+BasicBlock *
+MemoryOpt::getIfHead(BasicBlock *join) const
+{
+   BasicBlock *pred[2];
+   int n = 0;
+
+   for (Graph::EdgeIterator ei = join->cfg.incident(); !ei.end(); ei.next()) {
+      if (ei.getType() == Graph::Edge::BACK || n == 2)
+         return NULL;
+      pred[n++] = BasicBlock::get(ei.getNode());
+   }
+   if (n != 2)
+      return NULL;
+
+   for (int p = 0; p < 2; ++p) {
+      BasicBlock *side = pred[p];
+      BasicBlock *other = pred[!p];
+
+      if (side->cfg.incidentCount() != 1 || side->cfg.outgoingCount() != 1)
+         continue;
+      BasicBlock *head = BasicBlock::get(side->cfg.incident().getNode());
+      if (head->cfg.outgoingCount() != 2)
+         continue;
+      if (other == head)
+         return head;
+      if (other->cfg.incidentCount() == 1 && other->cfg.outgoingCount() == 1 &&
+          BasicBlock::get(other->cfg.incident().getNode()) == head)
+         return head;
+   }
+   return NULL;
+}
+
+// Record the loads of @head that are still valid at its end, so that the
+// ones after the if can be combined with them. Loads from buffers are left
+// alone, their bounds checks must stay with the access they were made for.
+void
+MemoryOpt::addHeadLoads(BasicBlock *head)
+{
+   for (Instruction *ld = head->getEntry(); ld; ld = ld->next) {
+      if (nv50_ir::writesMemory(ld)) {
+         purgeRecords(NULL, FILE_MEMORY_GLOBAL);
+         purgeRecords(NULL, FILE_MEMORY_SHARED);
+         purgeRecords(NULL, FILE_MEMORY_CONST);
+         continue;
+      }
+      if (ld->op != OP_LOAD || ld->getPredicate() || ld->perPatch ||
+          ld->cache == CACHE_CV)
+         continue;
+      switch (ld->src(0).getFile()) {
+      case FILE_MEMORY_GLOBAL:
+      case FILE_MEMORY_SHARED:
+      case FILE_MEMORY_CONST:
+         addRecord(ld);
+         break;
+      default:
+         break;
+      }
+   }
+}
+
 bool
 MemoryOpt::runOpt(BasicBlock *bb)
 {
@@ -3159,6 +3322,20 @@ MemoryOpt::runOpt(BasicBlock *bb)
    Record *rec;
    bool isAdjacent = true;
 
+   // loads after an if may be combined with the ones before it, as long as
+   // nothing on either side writes memory
+   BasicBlock *head = getIfHead(bb);
+   if (head) {
+      bool written = false;
+      for (Graph::EdgeIterator ei = bb->cfg.incident(); !ei.end(); ei.next()) {
+         BasicBlock *side = BasicBlock::get(ei.getNode());
+         if (side != head)
+            written = written || writesMemory(side);
+      }
+      if (!written)
+         addHeadLoads(head);
+   }
+
    for (ldst = bb->getEntry(); ldst; ldst = next) {
       bool keep = true;
       bool isLoad = true;
@@ -40,7 +40,7 @@ enum TextStyle
    TXT_INSN
 };
 
-static const char *_colour[8] =
+static const char *const _colour[8] =
 {
    "\x1b[00m",
    "\x1b[34m",
@@ -52,22 +52,21 @@ static const char *_colour[8] =
    "\x1b[32m"
 };
 
-static const char *_nocolour[8] =
+static const char *const _nocolour[8] =
 {
       "", "", "", "", "", "", "", ""
 };
 
-static const char **colour;
-
-static void init_colours()
+// Chosen once, so that printing from several compiler threads doesn't race
+// and instructions can be printed before the whole program was.
+static const char *const *colour()
 {
-   if (getenv("NV50_PROG_DEBUG_NO_COLORS") != NULL)
-      colour = _nocolour;
-   else
-      colour = _colour;
+   static const char *const *const table =
+      getenv("NV50_PROG_DEBUG_NO_COLORS") != NULL ? _nocolour : _colour;
+   return table;
 }
 
-const char *operationStr[OP_LAST + 1] =
+static const char *const operationStr[OP_LAST + 1] =
 {
    "nop",
    "phi",
@@ -204,57 +203,57 @@ const char *operationStr[OP_LAST + 1] =
    "(invalid)"
 };
 
-static const char *atomSubOpStr[] =
+static const char *const atomSubOpStr[] =
 {
    "add", "min", "max", "inc", "dec", "and", "or", "xor", "cas", "exch"
 };
 
-static const char *ldstSubOpStr[] =
+static const char *const ldstSubOpStr[] =
 {
    "", "lock", "unlock"
 };
 
-static const char *subfmOpStr[] =
+static const char *const subfmOpStr[] =
 {
    "", "3d"
 };
 
-static const char *shflOpStr[] =
+static const char *const shflOpStr[] =
 {
   "idx", "up", "down", "bfly"
 };
 
-static const char *pixldOpStr[] =
+static const char *const pixldOpStr[] =
 {
    "count", "covmask", "covered", "offset", "cent_offset", "sampleid"
 };
 
-static const char *rcprsqOpStr[] =
+static const char *const rcprsqOpStr[] =
 {
    "", "64h"
 };
 
-static const char *emitOpStr[] =
+static const char *const emitOpStr[] =
 {
    "", "restart"
 };
 
-static const char *cctlOpStr[] =
+static const char *const cctlOpStr[] =
 {
    "", "", "", "", "", "iv", "ivall"
 };
 
-static const char *barOpStr[] =
+static const char *const barOpStr[] =
 {
    "sync", "arrive", "red and", "red or", "red popc"
 };
 
-static const char *xmadOpCModeStr[] =
+static const char *const xmadOpCModeStr[] =
 {
    "clo", "chi", "csfu", "cbcc"
 };
 
-static const char *DataTypeStr[] =
+static const char *const DataTypeStr[] =
 {
    "-",
    "u8", "s8",
@@ -265,12 +264,12 @@ static const char *DataTypeStr[] =
    "b96", "b128"
 };
 
-static const char *RoundModeStr[] =
+static const char *const RoundModeStr[] =
 {
    "", "rm", "rz", "rp", "rni", "rmi", "rzi", "rpi"
 };
 
-static const char *CondCodeStr[] =
+static const char *const CondCodeStr[] =
 {
    "never",
    "lt",
@@ -298,7 +297,7 @@ static const char *CondCodeStr[] =
    "o"
 };
 
-static const char *SemanticStr[] =
+static const char *const SemanticStr[] =
 {
    "POSITION",
    "VERTEX_ID",
@@ -416,7 +415,7 @@ int Modifier::print(char *buf, size_t size) const
    size_t pos = 0;
 
    if (bits)
-      PRINT("%s", colour[TXT_INSN]);
+      PRINT("%s", colour()[TXT_INSN]);
 
    size_t base = pos;
 
@@ -482,7 +481,7 @@ int LValue::print(char *buf, size_t size, DataType ty) const
       break;
    }
 
-   PRINT("%s%c%c%i%s", colour[col], p, r, idx, postFix);
+   PRINT("%s%c%c%i%s", colour()[col], p, r, idx, postFix);
 
    return pos;
 }
@@ -491,7 +490,7 @@ int ImmediateValue::print(char *buf, size_t size, DataType ty) const
 {
    size_t pos = 0;
 
-   PRINT("%s", colour[TXT_IMMD]);
+   PRINT("%s", colour()[TXT_IMMD]);
 
    switch (ty) {
    case TYPE_F32: PRINT("%f", reg.data.f32); break;
@@ -528,14 +527,14 @@ int Symbol::print(char *buf, size_t size,
       ty = typeOfSize(reg.size);
 
    if (reg.file == FILE_SYSTEM_VALUE) {
-      PRINT("%ssv[%s%s:%i%s", colour[TXT_MEM],
-            colour[TXT_REGISTER],
-            SemanticStr[reg.data.sv.sv], reg.data.sv.index, colour[TXT_MEM]);
+      PRINT("%ssv[%s%s:%i%s", colour()[TXT_MEM],
+            colour()[TXT_REGISTER],
+            SemanticStr[reg.data.sv.sv], reg.data.sv.index, colour()[TXT_MEM]);
       if (rel) {
-         PRINT("%s+", colour[TXT_DEFAULT]);
+         PRINT("%s+", colour()[TXT_DEFAULT]);
          pos += rel->print(&buf[pos], size - pos);
       }
-      PRINT("%s]", colour[TXT_MEM]);
+      PRINT("%s]", colour()[TXT_MEM]);
       return pos;
    }
 
@@ -554,22 +553,22 @@ int Symbol::print(char *buf, size_t size,
    }
 
    if (c == 'c')
-      PRINT("%s%c%i[", colour[TXT_MEM], c, reg.fileIndex);
+      PRINT("%s%c%i[", colour()[TXT_MEM], c, reg.fileIndex);
    else
-      PRINT("%s%c[", colour[TXT_MEM], c);
+      PRINT("%s%c[", colour()[TXT_MEM], c);
 
    if (dimRel) {
       pos += dimRel->print(&buf[pos], size - pos, TYPE_S32);
-      PRINT("%s][", colour[TXT_MEM]);
+      PRINT("%s][", colour()[TXT_MEM]);
    }
 
    if (rel) {
       pos += rel->print(&buf[pos], size - pos);
-      PRINT("%s%c", colour[TXT_DEFAULT], (reg.data.offset < 0) ? '-' : '+');
+      PRINT("%s%c", colour()[TXT_DEFAULT], (reg.data.offset < 0) ? '-' : '+');
    } else {
       assert(reg.data.offset >= 0);
    }
-   PRINT("%s0x%x%s]", colour[TXT_IMMD], abs(reg.data.offset), colour[TXT_MEM]);
+   PRINT("%s0x%x%s]", colour()[TXT_IMMD], abs(reg.data.offset), colour()[TXT_MEM]);
 
    return pos;
 }
@@ -584,7 +583,7 @@ void Instruction::print() const
    int s, d;
    size_t pos = 0;
 
-   PRINT("%s", colour[TXT_INSN]);
+   PRINT("%s", colour()[TXT_INSN]);
 
    if (join)
       PRINT("join ");
@@ -600,7 +599,7 @@ void Instruction::print() const
       if (pos > pre)
          SPACE();
       pos += getSrc(predSrc)->print(&buf[pos], BUFSZ - pos);
-      PRINT(" %s", colour[TXT_INSN]);
+      PRINT(" %s", colour()[TXT_INSN]);
    }
 
    if (saturate)
@@ -613,15 +612,15 @@ void Instruction::print() const
       if (asFlow()->absolute)
          PRINT(" abs");
       if (op == OP_CALL && asFlow()->builtin) {
-         PRINT(" %sBUILTIN:%i", colour[TXT_BRA], asFlow()->target.builtin);
+         PRINT(" %sBUILTIN:%i", colour()[TXT_BRA], asFlow()->target.builtin);
       } else
       if (op == OP_CALL && asFlow()->target.fn) {
-         PRINT(" %s%s:%i", colour[TXT_BRA],
+         PRINT(" %s%s:%i", colour()[TXT_BRA],
                asFlow()->target.fn->getName(),
                asFlow()->target.fn->getLabel());
       } else
       if (asFlow()->target.bb)
-         PRINT(" %sBB:%i", colour[TXT_BRA], asFlow()->target.bb->getId());
+         PRINT(" %sBB:%i", colour()[TXT_BRA], asFlow()->target.bb->getId());
    } else {
       if (asTex())
          PRINT("%s%s ", operationStr[op], asTex()->tex.scalar ? "s" : "");
@@ -692,10 +691,10 @@ void Instruction::print() const
          PRINT("patch ");
       if (asTex()) {
          PRINT("%s %s$r%u $s%u ", asTex()->tex.target.getName(),
-               colour[TXT_MEM], asTex()->tex.r, asTex()->tex.s);
+               colour()[TXT_MEM], asTex()->tex.r, asTex()->tex.s);
          if (op == OP_TXG)
             PRINT("%s ", gatherCompStr[asTex()->tex.gatherComp]);
-         PRINT("%s %s", texMaskStr[asTex()->tex.mask], colour[TXT_INSN]);
+         PRINT("%s %s", texMaskStr[asTex()->tex.mask], colour()[TXT_INSN]);
       }
 
       if (postFactor)
@@ -713,16 +712,16 @@ void Instruction::print() const
       pos += getDef(d)->print(&buf[pos], size - pos);
    }
    if (d > 1)
-      PRINT(" %s}", colour[TXT_INSN]);
+      PRINT(" %s}", colour()[TXT_INSN]);
    else
    if (!d && !asFlow())
-      PRINT(" %s#", colour[TXT_INSN]);
+      PRINT(" %s#", colour()[TXT_INSN]);
 
    if (asCmp())
-      PRINT(" %s%s", colour[TXT_INSN], CondCodeStr[asCmp()->setCond]);
+      PRINT(" %s%s", colour()[TXT_INSN], CondCodeStr[asCmp()->setCond]);
 
    if (sType != dType)
-      PRINT(" %s%s", colour[TXT_INSN], DataTypeStr[sType]);
+      PRINT(" %s%s", colour()[TXT_INSN], DataTypeStr[sType]);
 
    for (s = 0; srcExists(s); ++s) {
       if (s == predSrc || src(s).usedAsPtr)
@@ -740,9 +739,9 @@ void Instruction::print() const
          pos += getSrc(s)->print(&buf[pos], BUFSZ - pos, sType);
    }
    if (exit)
-      PRINT("%s exit", colour[TXT_INSN]);
+      PRINT("%s exit", colour()[TXT_INSN]);
 
-   PRINT("%s", colour[TXT_DEFAULT]);
+   PRINT("%s", colour()[TXT_DEFAULT]);
 
    buf[MIN2(pos, BUFSZ - 1)] = 0;
 
@@ -780,14 +779,14 @@ PrintPass::visit(Function *fn)
    }
 
    if (!fn->ins.empty())
-      INFO("%s%sin", colour[TXT_DEFAULT], fn->outs.empty() ? "" : ", ");
+      INFO("%s%sin", colour()[TXT_DEFAULT], fn->outs.empty() ? "" : ", ");
    for (std::deque<ValueDef>::iterator it = fn->ins.begin();
         it != fn->ins.end();
         ++it) {
       it->get()->print(str, sizeof(str), typeOfSize(it->get()->reg.size));
       INFO(" %s", str);
    }
-   INFO("%s)\n", colour[TXT_DEFAULT]);
+   INFO("%s)\n", colour()[TXT_DEFAULT]);
 
    return true;
 }
@@ -844,7 +843,6 @@ void
 Program::print()
 {
    PrintPass pass(driver->omitLineNum);
-   init_colours();
    pass.run(this, true, false);
 }
 
@@ -880,6 +878,11 @@ nv50_ir_prog_info_out_print(struct nv50_ir_prog_info_out *info_out)
    INFO("      \"smemSize\":\"%d\",\n", info_out->bin.smemSize);
    INFO("      \"codeSize\":\"%d\",\n", info_out->bin.codeSize);
    INFO("      \"instructions\":\"%d\",\n", info_out->bin.instructions);
+   INFO("      \"stalls\":\"%d\",\n", info_out->bin.stalls);
+   INFO("      \"reuseHits\":\"%d\",\n", info_out->bin.reuseHits);
+   INFO("      \"gprReads\":\"%d\",\n", info_out->bin.gprReads);
+   INFO("      \"spills\":\"%d\",\n", info_out->bin.spills);
+   INFO("      \"fills\":\"%d\",\n", info_out->bin.fills);
 
    // RelocInfo
    INFO("      \"RelocInfo\":");
@@ -1011,6 +1014,7 @@ nv50_ir_prog_info_out_print(struct nv50_ir_prog_info_out *info_out)
    INFO("      \"globalAccess\":\"%d\"\n", info_out->io.globalAccess);
    INFO("      \"fp64\":\"%s\"\n", info_out->io.fp64 ? "true" : "false");
    INFO("      \"layer_viewport_relative\":\"%s\"\n", info_out->io.layer_viewport_relative ? "true" : "false");
+   INFO("      \"mul_zero_wins\":\"%s\"\n", info_out->io.mul_zero_wins ? "true" : "false");
    INFO("   \"}\n");
    INFO("   \"numBarriers\":\"%d\"\n", info_out->numBarriers);
    INFO("   \"driverPriv\":\"%p\"\n", info_out->driverPriv);
@@ -44,6 +44,10 @@ using std::tr1::unordered_map;
 
 #define MAX_REGISTER_FILE_SIZE 256
 
+// Functions with at least this many instructions are allocated with a linear
+// scan over the live intervals instead of graph colouring.
+DEBUG_GET_ONCE_NUM_OPTION(ra_linear_scan, "NV50_PROG_RA_LINEAR_SCAN", 10000)
+
 class RegisterSet
 {
 public:
@@ -224,7 +228,7 @@ RegisterSet::release(DataFile f, int32_t reg, unsigned int size)
 class RegAlloc
 {
 public:
-   RegAlloc(Program *program) : prog(program), func(NULL), sequence(0) { }
+   RegAlloc(Program *program) : prog(program), func(NULL) { }
 
    bool exec();
    bool execFunc();
@@ -282,7 +286,7 @@ private:
       const Target *targ;
    };
 
-   bool buildLiveSets(BasicBlock *);
+   bool buildLiveSets(Function *);
 
 private:
    Program *prog;
@@ -290,8 +294,6 @@ private:
 
    // instructions in control flow / chronological order
    ArrayList insns;
-
-   int sequence; // for manual passes through CFG
 };
 
 typedef std::pair<Value *, Value *> ValuePair;
@@ -597,64 +599,84 @@ RegAlloc::ArgumentMovesPass::visit(BasicBlock *bb)
 }
 
 // Build the set of live-in variables of bb.
+// Live-in sets are computed with a worklist. Blocks start out in post-order,
+// so that most successors are done before their predecessors, and a block is
+// only revisited when the live-in set of one of its successors has grown.
+// Since the sets only ever grow, a block's live-in set can be updated in place
+// and a change detected by comparing the number of live values.
 bool
-RegAlloc::buildLiveSets(BasicBlock *bb)
+RegAlloc::buildLiveSets(Function *f)
 {
-   Function *f = bb->getFunction();
+   const unsigned int lvalCount = f->allLValues.getSize();
+   std::deque<BasicBlock *> worklist;
+   // 0 for unreachable blocks, 1 for reachable ones, 2 while in the worklist
+   std::vector<uint8_t> state(f->allBBlocks.getSize(), 0);
+   BasicBlock *exit = BasicBlock::get(f->cfgExit);
    BasicBlock *bn;
    Instruction *i;
    unsigned int s, d;
 
-   INFO_DBG(prog->dbgFlags, REG_ALLOC, "buildLiveSets(BB:%i)\n", bb->getId());
+   for (IteratorRef it = f->cfg.iteratorDFS(false); !it->end(); it->next()) {
+      BasicBlock *bb =
+         BasicBlock::get(reinterpret_cast<Graph::Node *>(it->get()));
+      if (!bb->liveSet.allocate(lvalCount, true))
+         return false;
+      worklist.push_back(bb);
+      state[bb->getId()] = 2;
+   }
 
-   bb->liveSet.allocate(func->allLValues.getSize(), false);
+   while (!worklist.empty()) {
+      BasicBlock *bb = worklist.front();
+      worklist.pop_front();
+      state[bb->getId()] = 1;
 
-   int n = 0;
-   for (Graph::EdgeIterator ei = bb->cfg.outgoing(); !ei.end(); ei.next()) {
-      bn = BasicBlock::get(ei.getNode());
-      if (bn == bb)
-         continue;
-      if (bn->cfg.visit(sequence))
-         if (!buildLiveSets(bn))
-            return false;
-      if (n++ || bb->liveSet.marker)
-         bb->liveSet |= bn->liveSet;
-      else
-         bb->liveSet = bn->liveSet;
-   }
-   if (!n && !bb->liveSet.marker)
-      bb->liveSet.fill(0);
-   bb->liveSet.marker = true;
+      INFO_DBG(prog->dbgFlags, REG_ALLOC, "buildLiveSets(BB:%i)\n", bb->getId());
 
-   if (prog->dbgFlags & NV50_IR_DEBUG_REG_ALLOC) {
-      INFO("BB:%i live set of out blocks:\n", bb->getId());
-      bb->liveSet.print();
-   }
+      const unsigned int liveCount = bb->liveSet.popCount();
+
+      for (Graph::EdgeIterator ei = bb->cfg.outgoing(); !ei.end(); ei.next()) {
+         bn = BasicBlock::get(ei.getNode());
+         if (bn != bb)
+            bb->liveSet |= bn->liveSet;
+      }
 
-   // if (!bb->getEntry())
-   //   return true;
+      if (prog->dbgFlags & NV50_IR_DEBUG_REG_ALLOC) {
+         INFO("BB:%i live set of out blocks:\n", bb->getId());
+         bb->liveSet.print();
+      }
 
-   if (bb == BasicBlock::get(f->cfgExit)) {
-      for (std::deque<ValueRef>::iterator it = f->outs.begin();
-           it != f->outs.end(); ++it) {
-         assert(it->get()->asLValue());
-         bb->liveSet.set(it->get()->id);
+      if (bb == exit) {
+         for (std::deque<ValueRef>::iterator it = f->outs.begin();
+              it != f->outs.end(); ++it) {
+            assert(it->get()->asLValue());
+            bb->liveSet.set(it->get()->id);
+         }
       }
-   }
 
-   for (i = bb->getExit(); i && i != bb->getEntry()->prev; i = i->prev) {
-      for (d = 0; i->defExists(d); ++d)
-         bb->liveSet.clr(i->getDef(d)->id);
-      for (s = 0; i->srcExists(s); ++s)
-         if (i->getSrc(s)->asLValue())
-            bb->liveSet.set(i->getSrc(s)->id);
-   }
-   for (i = bb->getPhi(); i && i->op == OP_PHI; i = i->next)
-      bb->liveSet.clr(i->getDef(0)->id);
+      for (i = bb->getExit(); i && i != bb->getEntry()->prev; i = i->prev) {
+         for (d = 0; i->defExists(d); ++d)
+            bb->liveSet.clr(i->getDef(d)->id);
+         for (s = 0; i->srcExists(s); ++s)
+            if (i->getSrc(s)->asLValue())
+               bb->liveSet.set(i->getSrc(s)->id);
+      }
+      for (i = bb->getPhi(); i && i->op == OP_PHI; i = i->next)
+         bb->liveSet.clr(i->getDef(0)->id);
 
-   if (prog->dbgFlags & NV50_IR_DEBUG_REG_ALLOC) {
-      INFO("BB:%i live set after propagation:\n", bb->getId());
-      bb->liveSet.print();
+      if (prog->dbgFlags & NV50_IR_DEBUG_REG_ALLOC) {
+         INFO("BB:%i live set after propagation:\n", bb->getId());
+         bb->liveSet.print();
+      }
+
+      if (bb->liveSet.popCount() == liveCount)
+         continue;
+      for (Graph::EdgeIterator ei = bb->cfg.incident(); !ei.end(); ei.next()) {
+         bn = BasicBlock::get(ei.getNode());
+         if (state[bn->getId()] != 1)
+            continue;
+         worklist.push_back(bn);
+         state[bn->getId()] = 2;
+      }
    }
 
    return true;
@@ -818,6 +840,8 @@ private:
    void calculateSpillWeights();
    bool simplify();
    bool selectRegisters();
+   bool linearScan(ArrayList&);
+   void setRegisterIds();
    void cleanup(const bool success);
 
    void simplifyEdge(RIG_Node *, RIG_Node *);
@@ -828,6 +852,7 @@ private:
    void makeCompound(Instruction *, bool isSplit);
 
    inline void checkInterference(const RIG_Node *, Graph::EdgeIterator&);
+   void checkInterference(const RIG_Node *, const RIG_Node *);
 
    inline void insertOrderedTail(std::list<RIG_Node *>&, RIG_Node *);
    void checkList(std::list<RIG_Node *>&);
@@ -1409,8 +1434,12 @@ GCRA::simplify()
 void
 GCRA::checkInterference(const RIG_Node *node, Graph::EdgeIterator& ei)
 {
-   const RIG_Node *intf = RIG_Node::get(ei);
+   checkInterference(node, RIG_Node::get(ei));
+}
 
+void
+GCRA::checkInterference(const RIG_Node *node, const RIG_Node *intf)
+{
    if (intf->reg < 0)
       return;
    LValue *vA = node->getValue();
@@ -1508,12 +1537,140 @@ GCRA::selectRegisters()
    }
    if (!mustSpill.empty())
       return false;
+   setRegisterIds();
+   return true;
+}
+
+void
+GCRA::setRegisterIds()
+{
    for (unsigned int i = 0; i < nodeCount; ++i) {
       LValue *lval = nodes[i].getValue();
       if (nodes[i].reg >= 0 && nodes[i].colors > 0)
          lval->reg.data.id =
             regs.unitsToId(nodes[i].f, nodes[i].reg, lval->reg.size);
    }
+}
+
+// Fast path for very large functions: instead of building the interference
+// graph, walk the (coalesced) live intervals in order of their start and
+// give each one the first register range which isn't used by an overlapping
+// interval that already has one. Values which don't fit are spilled, the
+// cheapest one among the current value and those occupying its registers.
+bool
+GCRA::linearScan(ArrayList& insns)
+{
+   std::list<RIG_Node *> values, active;
+   std::vector<RIG_Node *> fixed;
+
+   INFO_DBG(prog->dbgFlags, REG_ALLOC, "\nLINEAR SCAN\n");
+
+   for (std::deque<ValueDef>::iterator it = func->ins.begin();
+        it != func->ins.end(); ++it)
+      insertOrderedTail(values, getNode(it->get()->asLValue()));
+
+   for (int i = 0; i < insns.getSize(); ++i) {
+      Instruction *insn = reinterpret_cast<Instruction *>(insns.get(i));
+      for (int d = 0; insn->defExists(d); ++d)
+         if (insn->getDef(d)->rep() == insn->getDef(d))
+            insertOrderedTail(values, getNode(insn->getDef(d)->asLValue()));
+   }
+   checkList(values);
+
+   for (std::list<RIG_Node *>::iterator it = values.begin();
+        it != values.end(); ++it) {
+      RIG_Node *node = *it;
+      if (!node->colors)
+         continue;
+      if (node->reg >= 0) {
+         // update max reg
+         regs.occupy(node->f, node->reg, node->colors);
+         fixed.push_back(node);
+         continue;
+      }
+      LValue *val = node->getValue();
+      if (!val->noSpill) {
+         int rc = 0;
+         for (ValueDef *def : mergedDefs(val))
+            rc += def->get()->refCount();
+         node->weight = (float)rc * (float)rc / (float)node->livei.extent();
+      }
+   }
+
+   for (; !values.empty(); values.pop_front()) {
+      RIG_Node *cur = values.front();
+
+      for (std::list<RIG_Node *>::iterator it = active.begin();
+           it != active.end();) {
+         if ((*it)->livei.end() <= cur->livei.begin())
+            it = active.erase(it);
+         else
+            ++it;
+      }
+      if (!cur->colors || cur->reg >= 0)
+         continue;
+
+      for (;;) {
+         RIG_Node *victim = NULL;
+
+         regs.reset(cur->f);
+         for (std::list<RIG_Node *>::iterator it = active.begin();
+              it != active.end(); ++it) {
+            RIG_Node *node = *it;
+            if (node->f == cur->f && node->livei.overlaps(cur->livei)) {
+               checkInterference(cur, node);
+               if (!victim || node->weight < victim->weight)
+                  victim = node;
+            }
+         }
+         for (size_t i = 0; i < fixed.size(); ++i)
+            if (fixed[i]->f == cur->f && fixed[i]->livei.overlaps(cur->livei))
+               checkInterference(cur, fixed[i]);
+
+         for (std::list<RIG_Node *>::const_iterator it = cur->prefRegs.begin();
+              it != cur->prefRegs.end();
+              ++it) {
+            if ((*it)->reg >= 0 &&
+                regs.testOccupy(cur->f, (*it)->reg, cur->colors)) {
+               cur->reg = (*it)->reg;
+               break;
+            }
+         }
+         if (cur->reg >= 0 ||
+             regs.assign(cur->reg, cur->f, cur->colors, cur->maxReg)) {
+            INFO_DBG(prog->dbgFlags, REG_ALLOC, "%%%i: assigned reg %i\n",
+                     cur->getValue()->id, cur->reg);
+            cur->getValue()->compMask = cur->getCompMask();
+            active.push_back(cur);
+            break;
+         }
+
+         if (!victim || cur->weight <= victim->weight)
+            victim = cur;
+         if (isinf(victim->weight)) {
+            ERROR("no viable spill candidates left\n");
+            mustSpill.clear();
+            return false;
+         }
+
+         LValue *lval = victim->getValue();
+         INFO_DBG(prog->dbgFlags, REG_ALLOC, "must spill: %%%i (size %u)\n",
+                  lval->id, lval->reg.size);
+         Symbol *slot = NULL;
+         if (lval->reg.file == FILE_GPR)
+            slot = spill.assignSlot(victim->livei, lval->reg.size);
+         mustSpill.push_back(ValuePair(lval, slot));
+
+         if (victim == cur)
+            break;
+         victim->reg = -1;
+         active.remove(victim);
+      }
+   }
+
+   if (!mustSpill.empty())
+      return false;
+   setRegisterIds();
    return true;
 }
 
@@ -1577,13 +1734,19 @@ GCRA::allocateRegisters(ArrayList& insns)
    if (func->getProgram()->dbgFlags & NV50_IR_DEBUG_REG_ALLOC)
       func->printLiveIntervals();
 
-   buildRIG(insns);
-   calculateSpillWeights();
-   ret = simplify();
-   if (!ret)
-      goto out;
+   if (insns.getSize() >= debug_get_option_ra_linear_scan()) {
+      ret = linearScan(insns);
+      if (!ret && mustSpill.empty())
+         goto out;
+   } else {
+      buildRIG(insns);
+      calculateSpillWeights();
+      ret = simplify();
+      if (!ret)
+         goto out;
 
-   ret = selectRegisters();
+      ret = selectRegisters();
+   }
    if (!ret) {
       INFO_DBG(prog->dbgFlags, REG_ALLOC,
                "selectRegisters failed, inserting spill code ...\n");
@@ -1709,6 +1872,7 @@ SpillCodeInserter::spill(Instruction *defi, Value *slot, LValue *lval)
    Instruction *st;
    if (slot->reg.file == FILE_MEMORY_LOCAL) {
       lval->noSpill = 1;
+      func->getProgram()->spills++;
       if (ty != TYPE_B96) {
          st = new_Instruction(func, OP_STORE, ty);
          st->setSrc(0, slot);
@@ -1751,6 +1915,7 @@ SpillCodeInserter::unspill(Instruction *usei, LValue *lval, Value *slot)
    Instruction *ld;
    if (slot->reg.file == FILE_MEMORY_LOCAL) {
       lval->noSpill = 1;
+      func->getProgram()->fills++;
       if (ty != TYPE_B96) {
          ld = new_Instruction(func, OP_LOAD, ty);
       } else {
@@ -1903,7 +2068,7 @@ RegAlloc::execFunc()
 
    GCRA gcra(func, insertSpills, mergedDefs);
 
-   unsigned int i, retries;
+   unsigned int retries;
    bool ret;
 
    if (!func->ins.empty()) {
@@ -1933,15 +2098,7 @@ RegAlloc::execFunc()
          func->print();
 
       // spilling to registers may add live ranges, need to rebuild everything
-      ret = true;
-      for (sequence = func->cfg.nextSequence(), i = 0;
-           ret && i <= func->loopNestingBound;
-           sequence = func->cfg.nextSequence(), ++i)
-         ret = buildLiveSets(BasicBlock::get(func->cfg.getRoot()));
-      // reset marker
-      for (ArrayList::Iterator bi = func->allBBlocks.iterator();
-           !bi.end(); bi.next())
-         BasicBlock::get(bi)->liveSet.marker = false;
+      ret = buildLiveSets(func);
       if (!ret)
          break;
       func->orderInstructions(this->insns);
@@ -0,0 +1,458 @@
+#include "codegen/nv50_ir.h"
+#include "codegen/nv50_ir_target.h"
+
+#include <algorithm>
+#include <vector>
+#if __cplusplus >= 201103L
+#include <unordered_map>
+#else
+#include <tr1/unordered_map>
+#endif
+
+namespace nv50_ir {
+
+#if __cplusplus >= 201103L
+using std::unordered_map;
+#else
+using std::tr1::unordered_map;
+#endif
+
+// Pre-RA list scheduler.
+//
+// Basic blocks are split into regions at instructions which must keep their
+// position (control flow, side effects, non-SSA values, ...). Inside a region
+// the only ordering constraints are the SSA def -> use edges, weighted with
+// the latency of the producer. Instructions are then issued one per cycle,
+// picking the ready one with the longest latency-weighted path to the end of
+// the region, so that texture fetches and memory loads are started as early
+// as possible and their consumers are moved behind independent work.
+//
+// Hoisting loads increases the number of live values, so the number of GPRs
+// which are live inside the region is tracked while scheduling. As soon as
+// the limit is reached, instructions which free registers are preferred. The
+// new order is only kept if it is estimated to be faster than the old one
+// without needing more registers.
+class PreRAScheduler : public Pass
+{
+public:
+   PreRAScheduler(const Target *targ) : targ(targ) { }
+
+private:
+   struct Node
+   {
+      Instruction *insn;
+      std::vector<int> succs;
+      int latency;
+      int priority; // latency-weighted path length to the end of the region
+      int numPreds; // number of unscheduled predecessors
+      int ready;    // earliest cycle in which all sources are available
+      int regDelta; // change in GPR pressure when defs are allocated
+      bool done;
+   };
+
+   virtual bool visit(BasicBlock *);
+
+   void scheduleRegion(BasicBlock *, Instruction *start, Instruction *end);
+   void buildDAG(Instruction *start, Instruction *end);
+   int simulate(const std::vector<int>& order) const;
+   int getPressure(const std::vector<int>& order) const;
+   int getRegSize(const Value *) const;
+   int getLatency(const Instruction *) const;
+   bool isBarrier(const Instruction *) const;
+
+   int pickNext(int cycle, int pressure, int limit) const;
+   bool isBetter(int a, int b, int cycle, int pressure, int limit) const;
+   int getFreedRegs(int n) const;
+
+   const Target *targ;
+
+   std::vector<Node> nodes;
+   unordered_map<const Instruction *, int> nodeIdx;
+   // remaining number of unscheduled uses in the region of GPR values defined
+   // inside of it, or -1 if the value is also used outside of the region
+   unordered_map<const Value *, int> uses;
+};
+
+// Regions with fewer instructions than this are left alone, longer ones are
+// split to bound the quadratic cost of picking instructions.
+#define PRERA_SCHED_MIN_INSNS 4
+#define PRERA_SCHED_MAX_INSNS 256
+
+// Below this number of live GPRs, occupancy is not a concern.
+#define PRERA_SCHED_MIN_GPR_LIMIT 32
+
+int
+PreRAScheduler::getRegSize(const Value *v) const
+{
+   if (!v || v->reg.file != FILE_GPR)
+      return 0;
+   return (v->reg.size + 3) / 4;
+}
+
+// The target latencies describe the fixed latency pipelines. Texture and
+// memory accesses complete asynchronously, use rough estimates for those.
+int
+PreRAScheduler::getLatency(const Instruction *insn) const
+{
+   int latency = targ->getLatency(insn);
+
+   switch (Target::getOpClass(insn->op)) {
+   case OPCLASS_TEXTURE:
+   case OPCLASS_SURFACE:
+      return MAX2(latency, 200);
+   case OPCLASS_LOAD:
+      switch (insn->src(0).getFile()) {
+      case FILE_MEMORY_CONST:
+         return latency;
+      case FILE_MEMORY_SHARED:
+         return MAX2(latency, 30);
+      case FILE_SHADER_INPUT:
+         return MAX2(latency, 50);
+      default:
+         return MAX2(latency, 200);
+      }
+   default:
+      return latency;
+   }
+}
+
+bool
+PreRAScheduler::isBarrier(const Instruction *insn) const
+{
+   if (insn->fixed || insn->terminator || insn->join || insn->exit ||
+       insn->asFlow())
+      return true;
+
+   switch (insn->op) {
+   case OP_NOP:
+   case OP_PHI:
+   case OP_UNION:
+   case OP_CONSTRAINT:
+   case OP_STORE:
+   case OP_EXPORT:
+   case OP_ATOM:
+   case OP_SUSTB:
+   case OP_SUSTP:
+   case OP_SUREDB:
+   case OP_SUREDP:
+   case OP_MEMBAR:
+   case OP_BAR:
+   case OP_EMIT:
+   case OP_RESTART:
+   case OP_FINAL:
+   case OP_DISCARD:
+   case OP_QUADON:
+   case OP_QUADPOP:
+   case OP_WRSV:
+   case OP_TEXBAR:
+   case OP_CCTL:
+   case OP_WARPSYNC:
+      return true;
+   case OP_LOAD:
+   case OP_SULDB:
+   case OP_SULDP:
+      // volatile and locked loads must stay where they are
+      if (insn->cache == CACHE_CV || insn->subOp)
+         return true;
+      break;
+   case OP_RDSV:
+      if (insn->getSrc(0)->reg.data.sv.sv == SV_CLOCK)
+         return true;
+      break;
+   default:
+      break;
+   }
+
+   // Only values with a single definition can be treated as SSA values, and
+   // values with a pre-assigned register may conflict with each other.
+   for (int d = 0; insn->defExists(d); ++d) {
+      const Value *v = insn->getDef(d);
+      if (v->defs.size() > 1 || v->reg.data.id >= 0)
+         return true;
+   }
+   for (int s = 0; insn->srcExists(s); ++s) {
+      const Value *v = insn->getSrc(s);
+      if (v->asSym() || v->asImm())
+         continue;
+      if (v->defs.size() > 1 || v->reg.data.id >= 0)
+         return true;
+   }
+   return false;
+}
+
+void
+PreRAScheduler::buildDAG(Instruction *start, Instruction *end)
+{
+   nodes.clear();
+   nodeIdx.clear();
+   uses.clear();
+
+   for (Instruction *insn = start; insn != end; insn = insn->next) {
+      Node node;
+
+      node.insn = insn;
+      node.latency = getLatency(insn);
+      node.priority = node.latency;
+      node.numPreds = 0;
+      node.ready = 0;
+      node.regDelta = 0;
+      node.done = false;
+
+      nodeIdx[insn] = nodes.size();
+      nodes.push_back(node);
+   }
+
+   for (size_t n = 0; n < nodes.size(); ++n) {
+      Instruction *insn = nodes[n].insn;
+
+      for (int s = 0; insn->srcExists(s); ++s) {
+         Value *v = insn->getSrc(s);
+         Instruction *defi = v->getUniqueInsn();
+         if (!defi || defi->bb != insn->bb || !nodeIdx.count(defi))
+            continue;
+         const int p = nodeIdx[defi];
+         // the same value may be used more than once (vector sources)
+         if (std::find(nodes[p].succs.begin(), nodes[p].succs.end(), (int)n) ==
+             nodes[p].succs.end()) {
+            nodes[p].succs.push_back(n);
+            nodes[n].numPreds++;
+         }
+      }
+
+      for (int d = 0; insn->defExists(d); ++d) {
+         const Value *v = insn->getDef(d);
+         const int size = getRegSize(v);
+         if (!size)
+            continue;
+         int count = 0;
+         for (Value::UseCIterator u = v->uses.begin(); u != v->uses.end(); ++u) {
+            const Instruction *usei = (*u)->getInsn();
+            if (usei->bb != insn->bb || !nodeIdx.count(usei)) {
+               count = -1;
+               break;
+            }
+            ++count;
+         }
+         uses[v] = count;
+         if (count)
+            nodes[n].regDelta += size;
+      }
+   }
+
+   // successors always come later in the original order
+   for (int n = nodes.size() - 1; n >= 0; --n) {
+      Node &node = nodes[n];
+      for (size_t s = 0; s < node.succs.size(); ++s)
+         node.priority = MAX2(node.priority,
+                              nodes[node.succs[s]].priority + node.latency);
+   }
+}
+
+// Returns the cycle in which the last instruction of @order issues, assuming
+// a single instruction is issued per cycle.
+int
+PreRAScheduler::simulate(const std::vector<int>& order) const
+{
+   std::vector<int> issued(nodes.size(), 0);
+   int cycle = -1;
+
+   for (size_t i = 0; i < order.size(); ++i) {
+      const Node &node = nodes[order[i]];
+      cycle = MAX2(cycle + 1, issued[order[i]]);
+      for (size_t s = 0; s < node.succs.size(); ++s)
+         issued[node.succs[s]] = MAX2(issued[node.succs[s]],
+                                      cycle + node.latency);
+   }
+   return cycle;
+}
+
+// Returns the maximum number of GPRs defined and still needed in the region.
+int
+PreRAScheduler::getPressure(const std::vector<int>& order) const
+{
+   unordered_map<const Value *, int> remaining(uses);
+   int pressure = 0, maxPressure = 0;
+
+   for (size_t i = 0; i < order.size(); ++i) {
+      const Instruction *insn = nodes[order[i]].insn;
+
+      pressure += nodes[order[i]].regDelta;
+      maxPressure = MAX2(maxPressure, pressure);
+
+      for (int s = 0; insn->srcExists(s); ++s) {
+         const Value *v = insn->getSrc(s);
+         if (!remaining.count(v) || remaining[v] <= 0)
+            continue;
+         if (--remaining[v] == 0)
+            pressure -= getRegSize(v);
+      }
+   }
+   return maxPressure;
+}
+
+// Returns the number of GPRs released once node @n is scheduled.
+int
+PreRAScheduler::getFreedRegs(int n) const
+{
+   const Instruction *insn = nodes[n].insn;
+   int freed = 0;
+
+   for (int s = 0; insn->srcExists(s); ++s) {
+      const Value *v = insn->getSrc(s);
+      unordered_map<const Value *, int>::const_iterator it = uses.find(v);
+      if (it == uses.end() || it->second <= 0)
+         continue;
+
+      int count = 1;
+      bool first = true;
+      for (int t = 0; insn->srcExists(t); ++t) {
+         if (t == s || insn->getSrc(t) != v)
+            continue;
+         if (t < s)
+            first = false;
+         ++count;
+      }
+      if (first && count == it->second)
+         freed += getRegSize(v);
+   }
+   return freed;
+}
+
+// Returns whether node @a should be scheduled before node @b.
+bool
+PreRAScheduler::isBetter(int a, int b, int cycle, int pressure,
+                         int limit) const
+{
+   const Node &na = nodes[a];
+   const Node &nb = nodes[b];
+   const int deltaA = na.regDelta - getFreedRegs(a);
+   const int deltaB = nb.regDelta - getFreedRegs(b);
+   const bool overA = pressure + deltaA > limit;
+   const bool overB = pressure + deltaB > limit;
+
+   if (overA || overB) {
+      if (overA != overB)
+         return overB;
+      if (deltaA != deltaB)
+         return deltaA < deltaB;
+   }
+
+   const bool availA = na.ready <= cycle;
+   const bool availB = nb.ready <= cycle;
+   if (availA != availB)
+      return availA;
+
+   // nothing can issue yet, take whatever becomes ready first
+   if (!availA && na.ready != nb.ready)
+      return na.ready < nb.ready;
+
+   if (na.priority != nb.priority)
+      return na.priority > nb.priority;
+   return a < b;
+}
+
+int
+PreRAScheduler::pickNext(int cycle, int pressure, int limit) const
+{
+   int best = -1;
+
+   for (size_t n = 0; n < nodes.size(); ++n) {
+      if (nodes[n].done || nodes[n].numPreds)
+         continue;
+      if (best < 0 || isBetter(n, best, cycle, pressure, limit))
+         best = n;
+   }
+   return best;
+}
+
+void
+PreRAScheduler::scheduleRegion(BasicBlock *bb, Instruction *start,
+                               Instruction *end)
+{
+   buildDAG(start, end);
+
+   if (nodes.size() < PRERA_SCHED_MIN_INSNS)
+      return;
+
+   std::vector<int> orig(nodes.size());
+   for (size_t n = 0; n < nodes.size(); ++n)
+      orig[n] = n;
+
+   const int origPressure = getPressure(orig);
+   const int limit = MAX2(origPressure, PRERA_SCHED_MIN_GPR_LIMIT);
+
+   std::vector<int> order;
+   int cycle = 0, pressure = 0;
+
+   order.reserve(nodes.size());
+   while (order.size() < nodes.size()) {
+      const int n = pickNext(cycle, pressure, limit);
+      assert(n >= 0);
+      Node &node = nodes[n];
+
+      cycle = MAX2(cycle, node.ready);
+      pressure += node.regDelta - getFreedRegs(n);
+      node.done = true;
+      order.push_back(n);
+
+      for (int s = 0; node.insn->srcExists(s); ++s) {
+         const Value *v = node.insn->getSrc(s);
+         if (uses.count(v) && uses[v] > 0)
+            --uses[v];
+      }
+      for (size_t s = 0; s < node.succs.size(); ++s) {
+         Node &succ = nodes[node.succs[s]];
+         succ.numPreds--;
+         succ.ready = MAX2(succ.ready, cycle + node.latency);
+      }
+      ++cycle;
+   }
+
+   if (order == orig)
+      return;
+
+   // uses[] has been consumed, recompute it for the pressure check
+   buildDAG(start, end);
+   if (simulate(order) >= simulate(orig) || getPressure(order) > limit)
+      return;
+
+   for (size_t n = 0; n < nodes.size(); ++n)
+      bb->remove(nodes[n].insn);
+   for (size_t i = 0; i < order.size(); ++i) {
+      if (end)
+         bb->insertBefore(end, nodes[order[i]].insn);
+      else
+         bb->insertTail(nodes[order[i]].insn);
+   }
+}
+
+bool
+PreRAScheduler::visit(BasicBlock *bb)
+{
+   Instruction *start = bb->getEntry();
+
+   while (start) {
+      while (start && isBarrier(start))
+         start = start->next;
+      if (!start)
+         break;
+
+      Instruction *end = start->next;
+      for (int n = 1; end && n < PRERA_SCHED_MAX_INSNS && !isBarrier(end); ++n)
+         end = end->next;
+
+      scheduleRegion(bb, start, end);
+
+      start = end;
+   }
+   return true;
+}
+
+bool
+Program::schedulePreRA()
+{
+   PreRAScheduler sched(getTarget());
+   return sched.run(this, false, true);
+}
+
+} // namespace nv50_ir
@@ -125,6 +125,7 @@ private:
    inline int getWtDepBar(const Instruction *) const;
 
    void setReuseFlag(Instruction *);
+   int countGPRReads(const Instruction *) const;
 
    inline void printSchedInfo(int, const Instruction *) const;
 
@@ -71,6 +71,11 @@ nv50_ir_prog_info_out_serialize(struct blob *blob,
    blob_write_uint32(blob, info_out->bin.codeSize);
    blob_write_bytes(blob, info_out->bin.code, info_out->bin.codeSize);
    blob_write_uint32(blob, info_out->bin.instructions);
+   blob_write_uint32(blob, info_out->bin.stalls);
+   blob_write_uint32(blob, info_out->bin.reuseHits);
+   blob_write_uint32(blob, info_out->bin.gprReads);
+   blob_write_uint32(blob, info_out->bin.spills);
+   blob_write_uint32(blob, info_out->bin.fills);
 
    if (!info_out->bin.relocData) {
       blob_write_uint32(blob, 0); // reloc count 0
@@ -170,6 +175,11 @@ nv50_ir_prog_info_out_deserialize(void *data, size_t size, size_t offset,
    info_out->bin.code = (uint32_t *)MALLOC(info_out->bin.codeSize);
    blob_copy_bytes(&reader, info_out->bin.code, info_out->bin.codeSize);
    info_out->bin.instructions = blob_read_uint32(&reader);
+   info_out->bin.stalls = blob_read_uint32(&reader);
+   info_out->bin.reuseHits = blob_read_uint32(&reader);
+   info_out->bin.gprReads = blob_read_uint32(&reader);
+   info_out->bin.spills = blob_read_uint32(&reader);
+   info_out->bin.fills = blob_read_uint32(&reader);
 
    info_out->bin.relocData = NULL;
    /*  Check if data contains RelocInfo */
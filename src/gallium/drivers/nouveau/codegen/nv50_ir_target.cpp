@@ -387,6 +387,11 @@ Program::emitBinary(struct nv50_ir_prog_info_out *info)
          }
       }
    }
+   info->bin.stalls = stalls;
+   info->bin.reuseHits = reuseHits;
+   info->bin.gprReads = gprReads;
+   info->bin.spills = spills;
+   info->bin.fills = fills;
    info->io.fp64 |= fp64;
    info->bin.relocData = emit->getRelocInfo();
    info->bin.fixupData = emit->getFixupInfo();
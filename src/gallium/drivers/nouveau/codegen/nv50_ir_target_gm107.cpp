@@ -353,7 +353,11 @@ TargetGM107::runLegalizePass(Program *prog, CGStage stage) const
    } else
    if (stage == CG_STAGE_SSA) {
       GM107LegalizeSSA pass;
-      return pass.run(prog, false, true);
+      if (!pass.run(prog, false, true))
+         return false;
+      if (prog->optLevel >= 3)
+         return prog->schedulePreRA();
+      return true;
    }
    return false;
 }
@@ -103,7 +103,7 @@ struct opInfo {
 #define MOD_NA   (MOD_NEG | MOD_ABS)
 
 #define OPINFO(O,SA,MA,SB,MB,SC,MC)                                            \
-static struct opInfo                                                           \
+static const struct opInfo                                                     \
 opInfo_##O = {                                                                 \
    .src = { { SRC_##SA, MOD_##MA },                                            \
             { SRC_##SB, MOD_##MB },                                            \
@@ -514,7 +514,7 @@ void
 TargetGV100::getBuiltinCode(const uint32_t **code, uint32_t *size) const
 {
    //XXX: find out why gv100 (tu1xx is fine) hangs without this
-   static uint32_t builtin[] = {
+   static const uint32_t builtin[] = {
       0x0000794d, 0x00000000, 0x03800000, 0x03ffde00,
       0x0000794d, 0x00000000, 0x03800000, 0x03ffde00,
       0x0000794d, 0x00000000, 0x03800000, 0x03ffde00,
@@ -565,7 +565,11 @@ TargetGV100::runLegalizePass(Program *prog, CGStage stage) const
    } else
    if (stage == CG_STAGE_SSA) {
       GV100LegalizeSSA pass(prog);
-      return pass.run(prog, false, true);
+      if (!pass.run(prog, false, true))
+         return false;
+      if (prog->optLevel >= 3)
+         return prog->schedulePreRA();
+      return true;
    } else
    if (stage == CG_STAGE_POST_RA) {
       NVC0LegalizePostRA pass(prog);
@@ -674,6 +674,124 @@ private:
    const unsigned int objStepLog2;
 };
 
+// Backing store for the small, variably sized allocations made by the STL
+// containers embedded in IR objects. Released blocks are kept in per-size
+// free lists and all memory is returned at once when the pool is destroyed.
+class BlockPool
+{
+public:
+   BlockPool() : chunks(NULL), pos(NULL), end(NULL)
+   {
+      memset(released, 0, sizeof(released));
+   }
+
+   ~BlockPool()
+   {
+      while (chunks) {
+         void *next = *(void **)chunks;
+         FREE(chunks);
+         chunks = next;
+      }
+   }
+
+   void *allocate(size_t size)
+   {
+      const size_t c = sizeClass(size);
+      void *ret;
+
+      if (c >= BLOCK_CLASSES)
+         return MALLOC(size);
+
+      if (released[c]) {
+         ret = released[c];
+         released[c] = *(void **)ret;
+         return ret;
+      }
+
+      size = (c + 1) * BLOCK_ALIGN;
+      if (pos + size > end) {
+         uint8_t *const mem = (uint8_t *)MALLOC(CHUNK_SIZE);
+         if (!mem)
+            return NULL;
+         *(void **)mem = chunks;
+         chunks = mem;
+         pos = mem + BLOCK_ALIGN;
+         end = mem + CHUNK_SIZE;
+      }
+      ret = pos;
+      pos += size;
+      return ret;
+   }
+
+   void release(void *ptr, size_t size)
+   {
+      const size_t c = sizeClass(size);
+
+      if (c >= BLOCK_CLASSES) {
+         FREE(ptr);
+         return;
+      }
+      *(void **)ptr = released[c];
+      released[c] = ptr;
+   }
+
+private:
+   static const size_t BLOCK_ALIGN = 16;
+   static const size_t BLOCK_CLASSES = 64; // blocks of up to 1 KiB
+   static const size_t CHUNK_SIZE = 64 << 10;
+
+   static inline size_t sizeClass(size_t size)
+   {
+      return size ? (size - 1) / BLOCK_ALIGN : 0;
+   }
+
+   void *chunks; // list of MALLOC allocations
+   uint8_t *pos;
+   uint8_t *end;
+
+   void *released[BLOCK_CLASSES]; // lists of released blocks, per size
+};
+
+// STL allocator drawing from a BlockPool, or from the heap if there is none.
+template<typename T>
+class PoolAllocator
+{
+public:
+   typedef T value_type;
+
+   PoolAllocator(BlockPool *pool = NULL) : pool(pool) { }
+   template<typename U>
+   PoolAllocator(const PoolAllocator<U>& that) : pool(that.pool) { }
+
+   T *allocate(size_t n)
+   {
+      if (pool)
+         return reinterpret_cast<T *>(pool->allocate(n * sizeof(T)));
+      return reinterpret_cast<T *>(MALLOC(n * sizeof(T)));
+   }
+
+   void deallocate(T *ptr, size_t n)
+   {
+      if (pool)
+         pool->release(ptr, n * sizeof(T));
+      else
+         FREE(ptr);
+   }
+
+   template<typename U>
+   bool operator==(const PoolAllocator<U>& that) const
+   {
+      return pool == that.pool;
+   }
+   template<typename U>
+   bool operator!=(const PoolAllocator<U>& that) const
+   {
+      return pool != that.pool;
+   }
+
+   BlockPool *pool;
+};
+
 /**
  *  Composite object cloning policy.
  *
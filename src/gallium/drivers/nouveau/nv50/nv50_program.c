@@ -23,6 +23,7 @@
 #include "pipe/p_defines.h"
 
 #include "compiler/nir/nir.h"
+#include "util/blob.h"
 
 #include "nv50/nv50_program.h"
 #include "nv50/nv50_context.h"
@@ -323,11 +324,16 @@ nv50_program_create_strmout_state(const struct nv50_ir_prog_info_out *info,
 
 bool
 nv50_program_translate(struct nv50_program *prog, uint16_t chipset,
+                       struct disk_cache *disk_shader_cache,
                        struct pipe_debug_callback *debug)
 {
+   struct blob blob;
+   size_t cache_size;
    struct nv50_ir_prog_info *info;
    struct nv50_ir_prog_info_out info_out = {};
-   int i, ret;
+   int i, ret = 0;
+   cache_key key;
+   bool shader_loaded = false;
    const uint8_t map_undef = (prog->type == PIPE_SHADER_VERTEX) ? 0x40 : 0x80;
 
    info = CALLOC_STRUCT(nv50_ir_prog_info);
@@ -387,11 +393,50 @@ nv50_program_translate(struct nv50_program *prog, uint16_t chipset,
    info->optLevel = 3;
 #endif
 
-   ret = nv50_ir_generate_code(info, &info_out);
-   if (ret) {
-      NOUVEAU_ERR("shader translation failed: %i\n", ret);
-      goto out;
+   blob_init(&blob);
+
+   if (disk_shader_cache) {
+      if (nv50_ir_prog_info_serialize(&blob, info)) {
+         void *cached_data = NULL;
+
+         disk_cache_compute_key(disk_shader_cache, blob.data, blob.size, key);
+         cached_data = disk_cache_get(disk_shader_cache, key, &cache_size);
+
+         if (cached_data && cache_size >= blob.size) { // blob.size is the size of serialized "info"
+            /* Blob contains only "info". In disk cache, "info_out" comes right after it */
+            size_t offset = blob.size;
+            if (nv50_ir_prog_info_out_deserialize(cached_data, cache_size, offset, &info_out)) {
+               /* the varying slots are assigned while generating code */
+               info_out.driverPriv = prog;
+               if (nv50_program_assign_varying_slots(&info_out) == 0)
+                  shader_loaded = true;
+            } else {
+               debug_printf("WARNING: Couldn't deserialize shaders");
+            }
+         }
+         free(cached_data);
+      } else {
+         debug_printf("WARNING: Couldn't serialize input shaders");
+      }
+   }
+   if (!shader_loaded) {
+      cache_size = 0;
+      ret = nv50_ir_generate_code(info, &info_out);
+      if (ret) {
+         NOUVEAU_ERR("shader translation failed: %i\n", ret);
+         blob_finish(&blob);
+         goto out;
+      }
+      if (disk_shader_cache) {
+         if (nv50_ir_prog_info_out_serialize(&blob, &info_out)) {
+            disk_cache_put(disk_shader_cache, key, blob.data, blob.size, NULL);
+            cache_size = blob.size;
+         } else {
+            debug_printf("WARNING: Couldn't serialize shaders");
+         }
+      }
    }
+   blob_finish(&blob);
 
    prog->code = info_out.bin.code;
    prog->code_size = info_out.bin.codeSize;
@@ -400,7 +445,7 @@ nv50_program_translate(struct nv50_program *prog, uint16_t chipset,
    prog->max_gpr = MAX2(4, (info_out.bin.maxGPR >> 1) + 1);
    prog->tls_space = info_out.bin.tlsSpace;
    prog->cp.smem_size = info_out.bin.smemSize;
-   prog->mul_zero_wins = info->io.mul_zero_wins;
+   prog->mul_zero_wins = info_out.io.mul_zero_wins;
    prog->vp.need_vertex_id = info_out.io.vertexId < PIPE_MAX_SHADER_INPUTS;
 
    prog->vp.clip_enable = (1 << info_out.io.clipDistances) - 1;
@@ -440,10 +485,17 @@ nv50_program_translate(struct nv50_program *prog, uint16_t chipset,
                                                    &prog->pipe.stream_output);
 
    pipe_debug_message(debug, SHADER_INFO,
-                      "type: %d, local: %d, shared: %d, gpr: %d, inst: %d, bytes: %d",
+                      "type: %d, local: %d, shared: %d, gpr: %d, inst: %d, bytes: %d, cached: %zd, spills: %u, fills: %u",
                       prog->type, info_out.bin.tlsSpace, info_out.bin.smemSize,
                       prog->max_gpr, info_out.bin.instructions,
-                      info_out.bin.codeSize);
+                      info_out.bin.codeSize, cache_size,
+                      info_out.bin.spills, info_out.bin.fills);
+   pipe_debug_message(debug, PERF_INFO,
+                      "compile time: frontend: %u us, opt: %u us, ra: %u us, emit: %u us",
+                      info_out.bin.phaseUs[NV50_IR_PHASE_FRONTEND],
+                      info_out.bin.phaseUs[NV50_IR_PHASE_OPT],
+                      info_out.bin.phaseUs[NV50_IR_PHASE_RA],
+                      info_out.bin.phaseUs[NV50_IR_PHASE_EMIT]);
 
 out:
    if (info->bin.sourceRep == PIPE_SHADER_IR_NIR)
@@ -752,10 +752,18 @@ nvc0_program_translate(struct nvc0_program *prog, uint16_t chipset,
                                                 &prog->pipe.stream_output);
 
    pipe_debug_message(debug, SHADER_INFO,
-                      "type: %d, local: %d, shared: %d, gpr: %d, inst: %d, bytes: %d, cached: %zd",
+                      "type: %d, local: %d, shared: %d, gpr: %d, inst: %d, bytes: %d, cached: %zd, stalls: %u, reuse: %u/%u, spills: %u, fills: %u",
                       prog->type, info_out.bin.tlsSpace, info_out.bin.smemSize,
                       prog->num_gprs, info_out.bin.instructions,
-                      info_out.bin.codeSize, cache_size);
+                      info_out.bin.codeSize, cache_size, info_out.bin.stalls,
+                      info_out.bin.reuseHits, info_out.bin.gprReads,
+                      info_out.bin.spills, info_out.bin.fills);
+   pipe_debug_message(debug, PERF_INFO,
+                      "compile time: frontend: %u us, opt: %u us, ra: %u us, emit: %u us",
+                      info_out.bin.phaseUs[NV50_IR_PHASE_FRONTEND],
+                      info_out.bin.phaseUs[NV50_IR_PHASE_OPT],
+                      info_out.bin.phaseUs[NV50_IR_PHASE_RA],
+                      info_out.bin.phaseUs[NV50_IR_PHASE_EMIT]);
 
 #ifndef NDEBUG
    if (debug_get_option("NV50_PROG_CHIPSET", NULL) && info->dbgFlags)
@@ -990,6 +998,8 @@ nvc0_program_destroy(struct nvc0_context *nvc0, struct nvc0_program *prog)
    const struct pipe_shader_state pipe = prog->pipe;
    const ubyte type = prog->type;
 
+   util_queue_fence_wait(&prog->ready);
+
    if (prog->mem)
       nouveau_heap_free(&prog->mem);
    FREE(prog->code); /* may be 0 for hardcoded shaders */
@@ -1001,7 +1011,7 @@ nvc0_program_destroy(struct nvc0_context *nvc0, struct nvc0_program *prog)
       FREE(prog->tfb);
    }
 
-   memset(prog, 0, sizeof(*prog));
+   memset(prog, 0, offsetof(struct nvc0_program, ready));
 
    prog->pipe = pipe;
    prog->type = type;
@@ -3,6 +3,7 @@
 #define __NVC0_PROGRAM_H__
 
 #include "pipe/p_state.h"
+#include "util/u_queue.h"
 
 #define NVC0_CAP_MAX_PROGRAM_TEMPS 128
 
@@ -71,6 +72,11 @@ struct nvc0_program {
    struct nvc0_transform_feedback_state *tfb;
 
    struct nouveau_heap *mem;
+
+   /* Signalled when the translation scheduled at state creation is done.
+    * Keep this last, nvc0_program_destroy resets everything before it.
+    */
+   struct util_queue_fence ready;
 };
 
 void
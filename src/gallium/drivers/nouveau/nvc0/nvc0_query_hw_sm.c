@@ -2472,6 +2472,7 @@ nvc0_hw_sm_get_program(struct nvc0_screen *screen)
 
    prog->type = PIPE_SHADER_COMPUTE;
    prog->translated = true;
+   util_queue_fence_init(&prog->ready);
    prog->parm_size = 12;
 
    if (screen->base.class_3d >= GM107_3D_CLASS) {
@@ -20,6 +20,7 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <unistd.h>
 #include <xf86drm.h>
 #include <nouveau_drm.h>
 #include <nvif/class.h>
@@ -692,6 +693,9 @@ nvc0_screen_destroy(struct pipe_screen *pscreen)
    if (!nouveau_drm_screen_unref(&screen->base))
       return;
 
+   if (util_queue_is_initialized(&screen->shader_compiler_queue))
+      util_queue_destroy(&screen->shader_compiler_queue);
+
    nouveau_fence_cleanup(&screen->base);
 
    if (screen->base.pushbuf)
@@ -702,6 +706,7 @@ nvc0_screen_destroy(struct pipe_screen *pscreen)
    if (screen->pm.prog) {
       screen->pm.prog->code = NULL; /* hardcoded, don't FREE */
       nvc0_program_destroy(NULL, screen->pm.prog);
+      util_queue_fence_destroy(&screen->pm.prog->ready);
       FREE(screen->pm.prog);
    }
 
@@ -1025,6 +1030,7 @@ nvc0_screen_create(struct nouveau_device *dev)
    uint64_t value;
    uint32_t obj_class;
    uint32_t flags;
+   long hw_threads;
    int ret;
    unsigned i;
 
@@ -1551,6 +1557,16 @@ nvc0_screen_create(struct nouveau_device *dev)
 
    nouveau_fence_new(&screen->base, &screen->base.fence.current);
 
+   /* Shaders are translated on this queue when their state is created, if
+    * it can't be set up they are translated synchronously instead.
+    */
+   hw_threads = sysconf(_SC_NPROCESSORS_ONLN);
+   if (!util_queue_init(&screen->shader_compiler_queue, "nvc0sh", 64,
+                        CLAMP(hw_threads - 1, 1, 8),
+                        UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                        UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY))
+      NOUVEAU_ERR("failed to create the shader compiler queue\n");
+
    return &screen->base;
 
 fail:
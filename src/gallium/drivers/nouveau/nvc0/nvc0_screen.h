@@ -6,6 +6,8 @@
 #include "nouveau_fence.h"
 #include "nouveau_heap.h"
 
+#include "util/u_queue.h"
+
 #include "nv_object.xml.h"
 
 #include "nvc0/nvc0_winsys.h"
@@ -89,6 +91,8 @@ struct nvc0_screen {
 
    struct nvc0_blitter *blitter;
 
+   struct util_queue shader_compiler_queue; /* initial program translation */
+
    struct {
       void **entries;
       int next;
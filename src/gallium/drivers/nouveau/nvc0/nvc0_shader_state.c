@@ -49,6 +49,8 @@ nvc0_program_update_context_state(struct nvc0_context *nvc0,
 static inline bool
 nvc0_program_validate(struct nvc0_context *nvc0, struct nvc0_program *prog)
 {
+   util_queue_fence_wait(&prog->ready);
+
    if (prog->mem)
       return true;
 
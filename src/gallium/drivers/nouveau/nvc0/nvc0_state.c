@@ -586,6 +586,63 @@ nvc0_set_sampler_views(struct pipe_context *pipe, enum pipe_shader_type shader,
 /* ============================= SHADERS =======================================
  */
 
+struct nvc0_compile_job {
+   struct nvc0_program *prog;
+   uint16_t chipset;
+   struct disk_cache *disk_shader_cache;
+   struct pipe_debug_callback debug;
+};
+
+static void
+nvc0_compile_job_execute(void *data, int thread_index)
+{
+   struct nvc0_compile_job *job = data;
+
+   job->prog->translated = nvc0_program_translate(
+      job->prog, job->chipset, job->disk_shader_cache, &job->debug);
+}
+
+static void
+nvc0_compile_job_cleanup(void *data, int thread_index)
+{
+   FREE(data);
+}
+
+/* Start translating a new program on the screen's shader queue, so that it is
+ * usually done by the time the program is first used. Binding or validating
+ * the program waits for the translation to finish.
+ */
+static void
+nvc0_program_schedule_translate(struct pipe_context *pipe,
+                                struct nvc0_program *prog)
+{
+   struct nvc0_screen *screen = nvc0_context(pipe)->screen;
+   struct pipe_debug_callback *debug = &nouveau_context(pipe)->debug;
+   struct nvc0_compile_job *job = NULL;
+
+   util_queue_fence_init(&prog->ready);
+
+   /* shader info messages may only be sent from our threads if allowed */
+   if (util_queue_is_initialized(&screen->shader_compiler_queue) &&
+       (!debug->debug_message || debug->async))
+      job = CALLOC_STRUCT(nvc0_compile_job);
+
+   if (!job) {
+      prog->translated = nvc0_program_translate(
+         prog, screen->base.device->chipset,
+         screen->base.disk_shader_cache, debug);
+      return;
+   }
+
+   job->prog = prog;
+   job->chipset = screen->base.device->chipset;
+   job->disk_shader_cache = screen->base.disk_shader_cache;
+   job->debug = *debug;
+
+   util_queue_add_job(&screen->shader_compiler_queue, job, &prog->ready,
+                      nvc0_compile_job_execute, nvc0_compile_job_cleanup, 0);
+}
+
 static void *
 nvc0_sp_state_create(struct pipe_context *pipe,
                      const struct pipe_shader_state *cso, unsigned type)
@@ -615,10 +672,7 @@ nvc0_sp_state_create(struct pipe_context *pipe,
    if (cso->stream_output.num_outputs)
       prog->pipe.stream_output = cso->stream_output;
 
-   prog->translated = nvc0_program_translate(
-      prog, nvc0_context(pipe)->screen->base.device->chipset,
-      nvc0_context(pipe)->screen->base.disk_shader_cache,
-      &nouveau_context(pipe)->debug);
+   nvc0_program_schedule_translate(pipe, prog);
 
    return (void *)prog;
 }
@@ -627,8 +681,12 @@ static void
 nvc0_sp_state_delete(struct pipe_context *pipe, void *hwcso)
 {
    struct nvc0_program *prog = (struct nvc0_program *)hwcso;
+   struct nvc0_screen *screen = nvc0_context(pipe)->screen;
 
+   if (util_queue_is_initialized(&screen->shader_compiler_queue))
+      util_queue_drop_job(&screen->shader_compiler_queue, &prog->ready);
    nvc0_program_destroy(nvc0_context(pipe), prog);
+   util_queue_fence_destroy(&prog->ready);
 
    if (prog->pipe.type == PIPE_SHADER_IR_TGSI)
       FREE((void *)prog->pipe.tokens);
@@ -649,6 +707,8 @@ nvc0_vp_state_bind(struct pipe_context *pipe, void *hwcso)
 {
     struct nvc0_context *nvc0 = nvc0_context(pipe);
 
+    if (hwcso)
+       util_queue_fence_wait(&((struct nvc0_program *)hwcso)->ready);
     nvc0->vertprog = hwcso;
     nvc0->dirty_3d |= NVC0_NEW_3D_VERTPROG;
 }
@@ -665,6 +725,8 @@ nvc0_fp_state_bind(struct pipe_context *pipe, void *hwcso)
 {
     struct nvc0_context *nvc0 = nvc0_context(pipe);
 
+    if (hwcso)
+       util_queue_fence_wait(&((struct nvc0_program *)hwcso)->ready);
     nvc0->fragprog = hwcso;
     nvc0->dirty_3d |= NVC0_NEW_3D_FRAGPROG;
 }
@@ -681,6 +743,8 @@ nvc0_gp_state_bind(struct pipe_context *pipe, void *hwcso)
 {
     struct nvc0_context *nvc0 = nvc0_context(pipe);
 
+    if (hwcso)
+       util_queue_fence_wait(&((struct nvc0_program *)hwcso)->ready);
     nvc0->gmtyprog = hwcso;
     nvc0->dirty_3d |= NVC0_NEW_3D_GMTYPROG;
 }
@@ -697,6 +761,8 @@ nvc0_tcp_state_bind(struct pipe_context *pipe, void *hwcso)
 {
     struct nvc0_context *nvc0 = nvc0_context(pipe);
 
+    if (hwcso)
+       util_queue_fence_wait(&((struct nvc0_program *)hwcso)->ready);
     nvc0->tctlprog = hwcso;
     nvc0->dirty_3d |= NVC0_NEW_3D_TCTLPROG;
 }
@@ -713,6 +779,8 @@ nvc0_tep_state_bind(struct pipe_context *pipe, void *hwcso)
 {
     struct nvc0_context *nvc0 = nvc0_context(pipe);
 
+    if (hwcso)
+       util_queue_fence_wait(&((struct nvc0_program *)hwcso)->ready);
     nvc0->tevlprog = hwcso;
     nvc0->dirty_3d |= NVC0_NEW_3D_TEVLPROG;
 }
@@ -755,10 +823,7 @@ nvc0_cp_state_create(struct pipe_context *pipe,
       return NULL;
    }
 
-   prog->translated = nvc0_program_translate(
-      prog, nvc0_context(pipe)->screen->base.device->chipset,
-      nvc0_context(pipe)->screen->base.disk_shader_cache,
-      &nouveau_context(pipe)->debug);
+   nvc0_program_schedule_translate(pipe, prog);
 
    return (void *)prog;
 }
@@ -768,6 +833,8 @@ nvc0_cp_state_bind(struct pipe_context *pipe, void *hwcso)
 {
     struct nvc0_context *nvc0 = nvc0_context(pipe);
 
+    if (hwcso)
+       util_queue_fence_wait(&((struct nvc0_program *)hwcso)->ready);
     nvc0->compprog = hwcso;
     nvc0->dirty_cp |= NVC0_NEW_CP_PROGRAM;
 }
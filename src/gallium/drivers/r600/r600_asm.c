@@ -2084,6 +2084,7 @@ void r600_bytecode_disasm(struct r600_bytecode *bc)
 	unsigned i, id, ngr = 0, last;
 	uint32_t literal[4];
 	unsigned nliteral;
+	unsigned nalu_cf = 0, ntex_cf = 0, nvtx_cf = 0;
 	char chip = '6';
 
 	switch (bc->chip_class) {
@@ -2105,6 +2106,19 @@ void r600_bytecode_disasm(struct r600_bytecode *bc)
 	        bc->ndw, bc->ngpr, bc->nstack);
 	fprintf(stderr, "shader %d -- %c\n", index++, chip);
 
+	LIST_FOR_EACH_ENTRY(cf, &bc->cf, list) {
+		if (cf->op == CF_NATIVE)
+			continue;
+		if (r600_isa_cf(cf->op)->flags & CF_ALU)
+			nalu_cf++;
+		else if (cf->op == CF_OP_TEX)
+			ntex_cf++;
+		else if (cf->op == CF_OP_VTX || cf->op == CF_OP_VTX_TC)
+			nvtx_cf++;
+	}
+	fprintf(stderr, "clauses %d cf -- %d alu -- %d tex -- %d vtx\n",
+	        bc->ncf, nalu_cf, ntex_cf, nvtx_cf);
+
 	LIST_FOR_EACH_ENTRY(cf, &bc->cf, list) {
 		id = cf->id;
 		if (cf->op == CF_NATIVE) {
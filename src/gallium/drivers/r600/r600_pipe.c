@@ -36,6 +36,7 @@
 #include "util/u_simple_shaders.h"
 #include "util/u_upload_mgr.h"
 #include "util/u_math.h"
+#include "util/u_cpu_detect.h"
 #include "vl/vl_decoder.h"
 #include "vl/vl_video_buffer.h"
 #include "radeon_video.h"
@@ -55,6 +56,7 @@ static const struct debug_named_value r600_debug_options[] = {
 	{ "sbnofallback", DBG_SB_NO_FALLBACK, "Abort on errors instead of fallback" },
 	{ "sbdisasm", DBG_SB_DISASM, "Use sb disassembler for shader dumps" },
 	{ "sbsafemath", DBG_SB_SAFEMATH, "Disable unsafe math optimizations" },
+	{ "sbtime", DBG_SB_TIME, "Print the time spent in each sb pass" },
         { "nirsb", DBG_NIR_SB, "Enable NIR with SB optimizer"},
 
 	DEBUG_NAMED_VALUE_END /* must be last */
@@ -697,6 +699,9 @@ static void r600_destroy_screen(struct pipe_screen* pscreen)
 		compute_memory_pool_delete(rscreen->global_pool);
 	}
 
+	if (util_queue_is_initialized(&rscreen->shader_compiler_queue))
+		util_queue_destroy(&rscreen->shader_compiler_queue);
+
 	r600_destroy_common_screen(&rscreen->b);
 }
 
@@ -806,6 +811,17 @@ struct pipe_screen *r600_screen_create(struct radeon_winsys *ws,
 	/* Create the auxiliary context. This must be done last. */
 	rscreen->b.aux_context = rscreen->b.b.context_create(&rscreen->b.b, NULL, 0);
 
+	/* The shaders are precompiled on the auxiliary context, so the queue
+	 * is only created once it exists. With a single CPU there is nothing
+	 * to gain from compiling in the background. */
+	util_cpu_detect();
+	if (rscreen->b.aux_context && util_get_cpu_caps()->nr_cpus > 1 &&
+	    !util_queue_init(&rscreen->shader_compiler_queue, "r600sh", 64, 1,
+			     UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+			     UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY)) {
+		fprintf(stderr, "r600: Failed to create the shader compiler queue\n");
+	}
+
 	rscreen->has_atomics = rscreen->b.info.drm_minor >= 44;
 #if 0 /* This is for testing whether aux_context and buffer clearing work correctly. */
 	struct pipe_resource templ = {};
@@ -35,6 +35,7 @@
 #include "util/list.h"
 #include "util/u_transfer.h"
 #include "util/u_memory.h"
+#include "util/u_queue.h"
 
 #include "tgsi/tgsi_scan.h"
 
@@ -268,6 +269,7 @@ struct r600_gs_rings_state {
 #define DBG_SB_NO_FALLBACK	(1 << 26)
 #define DBG_SB_DISASM	(1 << 27)
 #define DBG_SB_SAFEMATH	(1 << 28)
+#define DBG_SB_TIME		(1 << 29)
 #define DBG_NIR_SB	(1 << 28)
 
 #define DBG_NIR_PREFERRED (DBG_NIR_SB | DBG_NIR)
@@ -283,6 +285,9 @@ struct r600_screen {
 	 * XXX: Not sure if this is the best place for global_pool.  Also,
 	 * it's not thread safe, so it won't work with multiple contexts. */
 	struct compute_memory_pool *global_pool;
+
+	/* Compiles the first variant of new shaders on the auxiliary context */
+	struct util_queue		shader_compiler_queue;
 };
 
 struct r600_pipe_sampler_view {
@@ -345,6 +350,13 @@ struct r600_pipe_shader;
 struct r600_pipe_shader_selector {
 	struct r600_pipe_shader *current;
 
+	struct r600_screen	*screen;
+	/* signalled once the variant compiled at creation is done */
+	struct util_queue_fence	ready;
+
+	/* hash of the IR and stream output info, for the disk cache */
+	unsigned char		ir_sha1[20];
+
 	struct tgsi_token       *tokens;
         struct nir_shader       *nir;
 	struct pipe_stream_output_info  so;
@@ -744,6 +756,7 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
 			    union r600_shader_key key);
 
 void r600_pipe_shader_destroy(struct pipe_context *ctx, struct r600_pipe_shader *shader);
+void r600_shader_selector_hash(struct r600_pipe_shader_selector *sel);
 
 /* r600_state.c */
 struct pipe_sampler_view *
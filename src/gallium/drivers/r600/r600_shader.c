@@ -39,6 +39,10 @@
 #include "nir/tgsi_to_nir.h"
 #include "nir/nir_to_tgsi_info.h"
 #include "compiler/nir/nir.h"
+#include "compiler/nir/nir_serialize.h"
+#include "util/blob.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
 #include "util/u_bitcast.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
@@ -163,6 +167,171 @@ static int store_shader(struct pipe_context *ctx,
 	return 0;
 }
 
+/* Debug flags that change the generated code */
+#define R600_SHADER_CACHE_DEBUG_FLAGS (DBG_NO_SB | DBG_NIR | DBG_NIR_SB | \
+				       DBG_SB_SAFEMATH)
+
+void r600_shader_selector_hash(struct r600_pipe_shader_selector *sel)
+{
+	struct mesa_sha1 ctx;
+
+	_mesa_sha1_init(&ctx);
+	_mesa_sha1_update(&ctx, &sel->type, sizeof(sel->type));
+	_mesa_sha1_update(&ctx, &sel->ir_type, sizeof(sel->ir_type));
+	if (sel->ir_type == PIPE_SHADER_IR_TGSI) {
+		_mesa_sha1_update(&ctx, sel->tokens,
+				  tgsi_num_tokens(sel->tokens) * sizeof(struct tgsi_token));
+	} else {
+		struct blob blob;
+
+		blob_init(&blob);
+		nir_serialize(&blob, sel->nir, true);
+		_mesa_sha1_update(&ctx, blob.data, blob.size);
+		blob_finish(&blob);
+	}
+	_mesa_sha1_update(&ctx, &sel->so, sizeof(sel->so));
+	_mesa_sha1_final(&ctx, sel->ir_sha1);
+}
+
+static bool r600_shader_cache_key(struct r600_context *rctx,
+				  struct r600_pipe_shader_selector *sel,
+				  const union r600_shader_key *key,
+				  cache_key cache_key)
+{
+	struct r600_screen *rscreen = rctx->screen;
+	struct {
+		unsigned char ir_sha1[20];
+		union r600_shader_key key;
+		uint64_t debug_flags;
+		unsigned drm_minor;
+	} data;
+
+	/* TGSI shaders are translated to NIR in place when NIR is preferred,
+	 * replacing the shader info, so always compile them. Compute shaders
+	 * are not hashed. */
+	if (!rscreen->b.disk_shader_cache ||
+	    sel->type == PIPE_SHADER_COMPUTE ||
+	    (sel->ir_type == PIPE_SHADER_IR_TGSI &&
+	     (rscreen->b.debug_flags & DBG_NIR_PREFERRED)))
+		return false;
+
+	memset(&data, 0, sizeof(data));
+	memcpy(data.ir_sha1, sel->ir_sha1, sizeof(data.ir_sha1));
+	data.key = *key;
+	data.debug_flags = rscreen->b.debug_flags & R600_SHADER_CACHE_DEBUG_FLAGS;
+	/* the kernel version decides about some of the hw features used */
+	data.drm_minor = rscreen->b.info.drm_minor;
+
+	disk_cache_compute_key(rscreen->b.disk_shader_cache, &data, sizeof(data),
+			       cache_key);
+	return true;
+}
+
+/* Only the results of the compilation are stored: the shader info and the
+ * final bytecode along with what the hw state setup needs. */
+static void r600_write_pipe_shader(struct blob *blob,
+				   const struct r600_pipe_shader *shader)
+{
+	struct r600_shader info = shader->shader;
+	const struct r600_bytecode *bc = &shader->shader.bc;
+
+	memset(&info.bc, 0, sizeof(info.bc));
+	info.arrays = NULL;
+	info.num_arrays = 0;
+	info.max_arrays = 0;
+	blob_write_bytes(blob, &info, sizeof(info));
+
+	blob_write_uint32(blob, bc->ngpr);
+	blob_write_uint32(blob, bc->nstack);
+	blob_write_uint32(blob, bc->nlds_dw);
+	blob_write_uint32(blob, bc->ndw);
+	blob_write_bytes(blob, bc->bytecode, bc->ndw * 4);
+
+	blob_write_uint32(blob, shader->scratch_space_needed);
+	blob_write_uint32(blob, shader->enabled_stream_buffers_mask);
+}
+
+static bool r600_read_pipe_shader(struct r600_context *rctx,
+				  struct blob_reader *blob,
+				  struct r600_pipe_shader *shader)
+{
+	struct r600_bytecode *bc = &shader->shader.bc;
+
+	blob_copy_bytes(blob, &shader->shader, sizeof(shader->shader));
+	memset(bc, 0, sizeof(*bc));
+	r600_bytecode_init(bc, rctx->b.chip_class, rctx->b.family,
+			   rctx->screen->has_compressed_msaa_texturing);
+	bc->isa = rctx->isa;
+
+	bc->ngpr = blob_read_uint32(blob);
+	bc->nstack = blob_read_uint32(blob);
+	bc->nlds_dw = blob_read_uint32(blob);
+	bc->ndw = blob_read_uint32(blob);
+	if (blob->overrun || bc->ndw > (blob->end - blob->current) / 4)
+		return false;
+	bc->bytecode = malloc(bc->ndw * 4);
+	if (!bc->bytecode)
+		return false;
+	blob_copy_bytes(blob, bc->bytecode, bc->ndw * 4);
+
+	shader->scratch_space_needed = blob_read_uint32(blob);
+	shader->enabled_stream_buffers_mask = blob_read_uint32(blob);
+	return !blob->overrun;
+}
+
+static void r600_shader_cache_store(struct r600_context *rctx,
+				    struct r600_pipe_shader *shader,
+				    const cache_key cache_key)
+{
+	struct blob blob;
+
+	blob_init(&blob);
+	r600_write_pipe_shader(&blob, shader);
+	blob_write_uint8(&blob, shader->gs_copy_shader != NULL);
+	if (shader->gs_copy_shader)
+		r600_write_pipe_shader(&blob, shader->gs_copy_shader);
+
+	if (!blob.out_of_memory)
+		disk_cache_put(rctx->screen->b.disk_shader_cache, cache_key,
+			       blob.data, blob.size, NULL);
+	blob_finish(&blob);
+}
+
+static bool r600_shader_cache_load(struct r600_context *rctx,
+				   struct r600_pipe_shader *shader,
+				   const cache_key cache_key)
+{
+	struct blob_reader blob;
+	size_t size;
+	void *data;
+	bool ok;
+
+	data = disk_cache_get(rctx->screen->b.disk_shader_cache, cache_key, &size);
+	if (!data)
+		return false;
+
+	blob_reader_init(&blob, data, size);
+	ok = r600_read_pipe_shader(rctx, &blob, shader);
+	if (ok && blob_read_uint8(&blob)) {
+		shader->gs_copy_shader = CALLOC_STRUCT(r600_pipe_shader);
+		ok = shader->gs_copy_shader &&
+		     r600_read_pipe_shader(rctx, &blob, shader->gs_copy_shader);
+	}
+	ok &= !blob.overrun && blob.current == blob.end;
+	free(data);
+
+	if (!ok) {
+		if (shader->gs_copy_shader) {
+			r600_pipe_shader_destroy(&rctx->b.b, shader->gs_copy_shader);
+			FREE(shader->gs_copy_shader);
+			shader->gs_copy_shader = NULL;
+		}
+		r600_pipe_shader_destroy(&rctx->b.b, shader);
+		memset(&shader->shader, 0, sizeof(shader->shader));
+	}
+	return ok;
+}
+
 extern const struct nir_shader_compiler_options r600_nir_options;
 static int nshader = 0;
 int r600_pipe_shader_create(struct pipe_context *ctx,
@@ -183,8 +352,14 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
                           (rctx->screen->b.debug_flags & DBG_NIR_SB);
 	unsigned sb_disasm;
 	unsigned export_shader;
+	cache_key cache_key;
+	bool use_cache;
 	
 	shader->shader.bc.isa = rctx->isa;
+
+	use_cache = !dump && r600_shader_cache_key(rctx, sel, &key, cache_key);
+	if (use_cache && r600_shader_cache_load(rctx, shader, cache_key))
+		goto store;
 	
 	if (!(rscreen->b.debug_flags & DBG_NIR_PREFERRED)) {
 		assert(sel->ir_type == PIPE_SHADER_IR_TGSI);
@@ -305,6 +480,10 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
            fclose(f);
         }
 
+	if (use_cache)
+		r600_shader_cache_store(rctx, shader, cache_key);
+
+store:
 	if (shader->gs_copy_shader) {
 		if (dump) {
 			// dump copy shader
@@ -185,6 +185,9 @@ struct r600_pipe_shader {
 	unsigned		ps_depth_export;
 	unsigned		enabled_stream_buffers_mask;
 	unsigned		scratch_space_needed; /* size of scratch space (if > 0) counted in vec4 */
+	/* built on the auxiliary context, the state that depends on the
+	 * context state must be updated on first use */
+	bool			precompiled;
 };
 
 /* return the table index 0-5 for TGSI_INTERPOLATE_LINEAR/PERSPECTIVE and
@@ -857,6 +857,22 @@ static inline void r600_shader_selector_key(const struct pipe_context *ctx,
 	}
 }
 
+/* Variants compiled ahead of time were built without the state of the
+ * context that uses them, redo the parts of the hw state that depend on it */
+static void r600_update_precompiled_shader(struct pipe_context *ctx,
+					   struct r600_pipe_shader *shader)
+{
+	struct r600_context *rctx = (struct r600_context *)ctx;
+
+	if (shader->selector->type == PIPE_SHADER_FRAGMENT) {
+		if (rctx->b.chip_class >= EVERGREEN)
+			evergreen_update_ps_state(ctx, shader);
+		else
+			r600_update_ps_state(ctx, shader);
+	}
+	shader->precompiled = false;
+}
+
 /* Select the hw shader variant depending on the current state.
  * (*dirty) is set to 1 if current variant was changed */
 int r600_shader_select(struct pipe_context *ctx,
@@ -867,6 +883,10 @@ int r600_shader_select(struct pipe_context *ctx,
 	struct r600_pipe_shader * shader = NULL;
 	int r;
 
+	/* The variant compiled at creation is usually done by the time the
+	 * shader is first used, only wait if it isn't. */
+	util_queue_fence_wait(&sel->ready);
+
 	r600_shader_selector_key(ctx, sel, &key);
 
 	/* Check if we don't need to change anything.
@@ -874,6 +894,11 @@ int r600_shader_select(struct pipe_context *ctx,
 	 * variants, it will cost just a computation of the key and this
 	 * test. */
 	if (likely(sel->current && memcmp(&sel->current->key, &key, sizeof(key)) == 0)) {
+		if (unlikely(sel->current->precompiled)) {
+			r600_update_precompiled_shader(ctx, sel->current);
+			if (dirty)
+				*dirty = true;
+		}
 		return 0;
 	}
 
@@ -889,6 +914,8 @@ int r600_shader_select(struct pipe_context *ctx,
 		if (c) {
 			p->next_variant = c->next_variant;
 			shader = c;
+			if (unlikely(shader->precompiled))
+				r600_update_precompiled_shader(ctx, shader);
 		}
 	}
 
@@ -933,6 +960,8 @@ struct r600_pipe_shader_selector *r600_create_shader_state_tokens(struct pipe_co
 {
 	struct r600_pipe_shader_selector *sel = CALLOC_STRUCT(r600_pipe_shader_selector);
 
+	sel->screen = (struct r600_screen *)ctx->screen;
+	util_queue_fence_init(&sel->ready);
 	sel->type = pipe_shader_type;
 	if (ir == PIPE_SHADER_IR_TGSI) {
 		sel->tokens = tgsi_dup_tokens((const struct tgsi_token *)prog);
@@ -944,6 +973,84 @@ struct r600_pipe_shader_selector *r600_create_shader_state_tokens(struct pipe_co
 	return sel;
 }
 
+/* Guess the key of the first variant that will be used without looking at
+ * the context state: a non-multisampled draw to a single color buffer with
+ * no atomic counters, and the vertex stages running as the hw VS. */
+static bool r600_precompile_key(const struct r600_pipe_shader_selector *sel,
+				union r600_shader_key *key)
+{
+	memset(key, 0, sizeof(*key));
+
+	switch (sel->type) {
+	case PIPE_SHADER_FRAGMENT:
+		/* the image size constants depend on the bound sampler views */
+		if (sel->info.images_declared)
+			return false;
+		key->ps.nr_cbufs = 1;
+		key->ps.apply_sample_id_mask = 1;
+		return true;
+	case PIPE_SHADER_VERTEX:
+	case PIPE_SHADER_GEOMETRY:
+	case PIPE_SHADER_TESS_EVAL:
+		return true;
+	default:
+		/* the TCS key depends on the TES that is bound with it */
+		return false;
+	}
+}
+
+static void r600_precompile_shader_job(void *job, int thread_index)
+{
+	struct r600_pipe_shader_selector *sel = job;
+	struct r600_screen *rscreen = sel->screen;
+	struct r600_pipe_shader *shader;
+	union r600_shader_key key;
+	int r;
+
+	if (!r600_precompile_key(sel, &key))
+		return;
+
+	shader = CALLOC(1, sizeof(struct r600_pipe_shader));
+	shader->selector = sel;
+
+	mtx_lock(&rscreen->b.aux_context_lock);
+	r = r600_pipe_shader_create(rscreen->b.aux_context, shader, key);
+	mtx_unlock(&rscreen->b.aux_context_lock);
+
+	if (r) {
+		/* the variant will be built and the error reported on first use */
+		FREE(shader);
+		return;
+	}
+
+	if (sel->type == PIPE_SHADER_FRAGMENT)
+		sel->nr_ps_max_color_exports = shader->shader.nr_ps_max_color_exports;
+
+	memcpy(&shader->key, &key, sizeof(key));
+	shader->precompiled = true;
+	sel->current = shader;
+	sel->num_shaders = 1;
+}
+
+/* Compile the variant that is most likely to be used first in the
+ * background, so that the first draw with the shader doesn't have to. */
+static void r600_precompile_shader(struct pipe_context *ctx,
+				   struct r600_pipe_shader_selector *sel)
+{
+	struct r600_screen *rscreen = sel->screen;
+
+	/* The auxiliary context can't wait for a job that needs its lock, and
+	 * the shaders it creates itself are only used for internal blits */
+	if (!rscreen->b.aux_context || ctx == rscreen->b.aux_context)
+		return;
+
+	if (util_queue_is_initialized(&rscreen->shader_compiler_queue))
+		util_queue_add_job(&rscreen->shader_compiler_queue, sel, &sel->ready,
+				   r600_precompile_shader_job, NULL, 0);
+	else if (rscreen->b.debug_flags & DBG_PRECOMPILE)
+		r600_precompile_shader_job(sel, 0);
+}
+
 static void *r600_create_shader_state(struct pipe_context *ctx,
 			       const struct pipe_shader_state *state,
 			       unsigned pipe_shader_type)
@@ -961,6 +1068,9 @@ static void *r600_create_shader_state(struct pipe_context *ctx,
 	sel->ir_type = state->type;
 	sel->so = state->stream_output;
 
+	if (sel->screen->b.disk_shader_cache)
+		r600_shader_selector_hash(sel);
+
 	switch (pipe_shader_type) {
 	case PIPE_SHADER_GEOMETRY:
 		sel->gs_output_prim =
@@ -996,6 +1106,7 @@ static void *r600_create_shader_state(struct pipe_context *ctx,
 		break;
 	}
 
+	r600_precompile_shader(ctx, sel);
 	return sel;
 }
 
@@ -1109,7 +1220,13 @@ static void r600_bind_tes_state(struct pipe_context *ctx, void *state)
 void r600_delete_shader_selector(struct pipe_context *ctx,
 				 struct r600_pipe_shader_selector *sel)
 {
-	struct r600_pipe_shader *p = sel->current, *c;
+	struct r600_pipe_shader *p, *c;
+
+	if (util_queue_is_initialized(&sel->screen->shader_compiler_queue))
+		util_queue_drop_job(&sel->screen->shader_compiler_queue, &sel->ready);
+	util_queue_fence_destroy(&sel->ready);
+
+	p = sel->current;
 	while (p) {
 		c = p->next_variant;
 		r600_pipe_shader_destroy(ctx, p);
@@ -686,6 +686,7 @@ public:
 	static unsigned dry_run;
 	static unsigned no_fallback;
 	static unsigned safe_math;
+	static unsigned time_passes;
 
 	static unsigned dskip_start;
 	static unsigned dskip_end;
@@ -62,6 +62,7 @@ sb_context *r600_sb_context_create(struct r600_context *rctx) {
 	sb_context::dry_run = df & DBG_SB_DRY_RUN;
 	sb_context::no_fallback = df & DBG_SB_NO_FALLBACK;
 	sb_context::safe_math = df & DBG_SB_SAFEMATH;
+	sb_context::time_passes = df & DBG_SB_TIME;
 
 	sb_context::dskip_start = debug_get_num_option("R600_SB_DSKIP_START", 0);
 	sb_context::dskip_end = debug_get_num_option("R600_SB_DSKIP_END", 0);
@@ -101,7 +102,7 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 	}
 
 	int64_t time_start = 0;
-	if (sb_context::dump_stat) {
+	if (sb_context::dump_stat || sb_context::time_passes) {
 		time_start = os_time_get_nano();
 	}
 
@@ -157,9 +158,16 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 
 	SB_DUMP_PASS( sblog << "\n\n###### after parse\n"; sh->dump_ir(); );
 
+	int64_t pass_start = 0;
+
 #define SB_RUN_PASS(n, dump) \
 	do { \
+		if (sb_context::time_passes) \
+			pass_start = os_time_get_nano(); \
 		r = n(*sh).run(); \
+		if (sb_context::time_passes) \
+			sblog << "sb: shader " << shader_id << " " << #n << " pass: " \
+				<< (unsigned)((os_time_get_nano() - pass_start) / 1000) << " us\n"; \
 		if (r) { \
 			sblog << "sb: error (" << r << ") in the " << #n << " pass.\n"; \
 			if (sb_context::no_fallback) \
@@ -266,6 +274,11 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 		SB_DUMP_STAT( sblog << "sb: dry run: optimized bytecode is not used\n"; );
 	}
 
+	if (sb_context::time_passes && !sb_context::dump_stat) {
+		sblog << "sb: shader " << shader_id << " total: "
+				<< (unsigned)((os_time_get_nano() - time_start) / 1000) << " us\n";
+	}
+
 	if (sb_context::dump_stat) {
 		int64_t t = os_time_get_nano() - time_start;
 
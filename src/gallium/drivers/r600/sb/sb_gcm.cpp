@@ -698,7 +698,7 @@ unsigned gcm::get_uc_vec(vvec &vv) {
 	return c;
 }
 
-void gcm::init_use_count(nuc_map& m, container_node &s) {
+void gcm::init_use_count(count_map& m, container_node &s) {
 	m.clear();
 	for (node_iterator I = s.begin(), E = s.end(); I != E; ++I) {
 		node *n = *I;
@@ -748,7 +748,7 @@ void gcm::bu_release_val(value* v) {
 
 }
 
-void gcm::init_def_count(nuc_map& m, container_node& s) {
+void gcm::init_def_count(count_map& m, container_node& s) {
 	m.clear();
 	for (node_iterator I = s.begin(), E = s.end(); I != E; ++I) {
 		node *n = *I;
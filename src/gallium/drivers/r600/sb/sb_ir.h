@@ -193,13 +193,7 @@ public:
 	void clear() { set.clear(); }
 
 	V& operator[](const K& key) {
-		datatype P = std::make_pair(key, V());
-		iterator F = set.find(P);
-		if (F == set.end()) {
-			return (*(set.insert(P).first)).second;
-		} else {
-			return (*F).second;
-		}
+		return (*(set.insert(std::make_pair(key, V())).first)).second;
 	}
 
 	std::pair<iterator, bool> insert(const datatype& d) {
@@ -232,6 +226,7 @@ public:
 	bool get(unsigned id);
 	void set(unsigned id, bool bit = true);
 	bool set_chk(unsigned id, bool bit = true);
+	bool add_chk(const sb_bitset &bs2);
 
 	void clear();
 	void resize(unsigned size);
@@ -642,6 +637,8 @@ class value_table {
 
 	unsigned cnt;
 
+	void grow();
+
 public:
 
 	value_table(expr_handler &ex, unsigned size_bits = 10)
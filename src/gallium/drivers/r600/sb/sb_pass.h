@@ -28,6 +28,7 @@
 #define SB_PASS_H_
 
 #include <stack>
+#include <unordered_map>
 
 namespace r600_sb {
 
@@ -232,12 +233,15 @@ class gcm : public pass {
 		op_info() : top_bb(), bottom_bb() {}
 	};
 
-	typedef std::map<node*, op_info> op_info_map;
+	typedef std::unordered_map<node*, op_info> op_info_map;
 
+	// the per level use counts are merged in order, the total use counts
+	// are only looked up
 	typedef std::map<node*, unsigned> nuc_map;
+	typedef std::unordered_map<node*, unsigned> count_map;
 
 	op_info_map op_map;
-	nuc_map uses;
+	count_map uses;
 
 	typedef std::vector<nuc_map> nuc_stack;
 
@@ -295,8 +299,8 @@ private:
 	void push_uc_stack();
 	void pop_uc_stack();
 
-	void init_def_count(nuc_map &m, container_node &s);
-	void init_use_count(nuc_map &m, container_node &s);
+	void init_def_count(count_map &m, container_node &s);
+	void init_use_count(count_map &m, container_node &s);
 	unsigned get_uc_vec(vvec &vv);
 	unsigned get_dc_vec(vvec &vv, bool src);
 
@@ -30,6 +30,7 @@
 #include <list>
 #include <string>
 #include <map>
+#include <unordered_map>
 
 #include "sb_ir.h"
 #include "sb_expr.h"
@@ -250,7 +251,9 @@ class shader {
 
 	sb_context &ctx;
 
-	typedef sb_map<uint32_t, value*> value_map;
+	// keyed lookups only, a hash map avoids the shifting on insertion of
+	// the sorted sb_map with the large number of values in big shaders
+	typedef std::unordered_map<uint32_t, value*> value_map;
 	value_map reg_values;
 
 	// read-only values
@@ -142,6 +142,10 @@ void value_table::add_value(value* v) {
 		dump::dump_val(v);
 	);
 
+	// keep the buckets short, gvn scans the whole bucket for every value
+	if (cnt >= size * 4)
+		grow();
+
 	value_hash hash = v->hash();
 	vt_item & vti = hashtable[hash & size_mask];
 	vti.push_back(v);
@@ -201,6 +205,24 @@ value_hash value::rel_hash() {
 	return h;
 }
 
+// Values with the same hash stay in the same order in their bucket, so the
+// first equal value that is found doesn't change.
+void value_table::grow() {
+	vt_table old(size * 2);
+	old.swap(hashtable);
+
+	++size_bits;
+	size <<= 1;
+	size_mask = size - 1;
+
+	for (vt_table::iterator I = old.begin(), E = old.end(); I != E; ++I) {
+		for (vt_item::iterator VI = I->begin(), VE = I->end(); VI != VE; ++VI) {
+			value *v = *VI;
+			hashtable[v->hash() & size_mask].push_back(v);
+		}
+	}
+}
+
 bool value_table::expr_equal(value* l, value* r) {
 	return ex.equal(l, r);
 }
@@ -401,9 +423,9 @@ void sb_bitset::set(unsigned id, bool bit) {
 		data.resize(w + 1);
 
 	if (bit)
-		data[w] |= (1 << b);
+		data[w] |= ((basetype)1 << b);
 	else
-		data[w] &= ~(1 << b);
+		data[w] &= ~((basetype)1 << b);
 }
 
 inline bool sb_bitset::set_chk(unsigned id, bool bit) {
@@ -411,12 +433,26 @@ inline bool sb_bitset::set_chk(unsigned id, bool bit) {
 	unsigned w = id / bt_bits;
 	unsigned b = id % bt_bits;
 	basetype d = data[w];
-	basetype dn = (d & ~(1 << b)) | (bit << b);
+	basetype dn = (d & ~((basetype)1 << b)) | ((basetype)bit << b);
 	bool r = (d != dn);
 	data[w] = r ? dn : data[w];
 	return r;
 }
 
+// in-place union, returns true if any bit was added
+bool sb_bitset::add_chk(const sb_bitset &bs2) {
+	if (bit_size < bs2.bit_size)
+		resize(bs2.bit_size);
+
+	basetype added = 0;
+	for (unsigned i = 0, c = std::min(data.size(), bs2.data.size()); i < c;
+			++i) {
+		added |= bs2.data[i] & ~data[i];
+		data[i] |= bs2.data[i];
+	}
+	return added != 0;
+}
+
 void sb_bitset::clear() {
 	std::fill(data.begin(), data.end(), 0);
 }
@@ -462,14 +498,7 @@ sb_value_set::iterator::iterator(shader& sh, sb_value_set* s, unsigned nb)
 	: vp(sh.get_value_pool()), s(s), nb(nb) {}
 
 bool sb_value_set::add_set_checked(sb_value_set& s2) {
-	if (bs.size() < s2.bs.size())
-		bs.resize(s2.bs.size());
-	sb_bitset nbs = bs | s2.bs;
-	if (bs != nbs) {
-		bs.swap(nbs);
-		return true;
-	}
-	return false;
+	return bs.add_chk(s2.bs);
 }
 
 void r600_sb::sb_value_set::remove_set(sb_value_set& s2) {
@@ -559,7 +588,7 @@ sb_bitset& sb_bitset::mask(const sb_bitset& bs2) {
 		resize(bs2.bit_size);
 	}
 
-	for (unsigned i = 0, c = data.size(); i < c;
+	for (unsigned i = 0, c = std::min(data.size(), bs2.data.size()); i < c;
 			++i) {
 		data[i] &= ~bs2.data[i];
 	}
@@ -0,0 +1,367 @@
+/* -*- mesa-c++  -*-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sfn_alu_scheduler.h"
+#include "sfn_debug.h"
+#include "sfn_value_gpr.h"
+
+#include <algorithm>
+
+namespace r600 {
+
+/* Limit the number of groups that are considered together, this bounds the
+ * quadratic dependency evaluation and how far the live ranges of registers
+ * can be extended by moving instructions. */
+static const size_t max_window = 32;
+
+/* An instruction group can reference at most four literal values */
+static const size_t max_literals = 4;
+
+/* Keep the number of constant buffer lines a bundle references low, so that
+ * merging groups doesn't force the assembler to start new ALU clauses */
+static const size_t max_kcache_lines = 2;
+
+AluGroupScheduler::AluGroupScheduler(bool has_trans_slot):
+   m_has_trans_slot(has_trans_slot)
+{
+}
+
+void AluGroupScheduler::run(std::vector<InstructionBlock>& ir)
+{
+   for (auto& block : ir)
+      run(block);
+}
+
+void AluGroupScheduler::run(InstructionBlock& block)
+{
+   auto region_start = block.end();
+   bool in_group = false;
+
+   for (auto i = block.begin(); i != block.end(); ++i) {
+      bool movable = false;
+
+      if ((*i)->type() == Instruction::alu) {
+         auto& alu = static_cast<AluInstruction&>(**i);
+         /* only groups that consist of a single instruction are moved */
+         movable = !in_group && alu.is_last() && is_movable(alu);
+         in_group = !alu.is_last();
+      } else {
+         in_group = false;
+      }
+
+      if (movable) {
+         if (region_start == block.end())
+            region_start = i;
+         else if (i - region_start == max_window) {
+            schedule(region_start, i);
+            region_start = i;
+         }
+      } else if (region_start != block.end()) {
+         schedule(region_start, i);
+         region_start = block.end();
+      }
+   }
+   if (region_start != block.end())
+      schedule(region_start, block.end());
+}
+
+bool AluGroupScheduler::is_movable(const AluInstruction& alu) const
+{
+   if (alu.flag(alu_update_exec) || alu.flag(alu_update_pred) ||
+       alu.flag(alu_dst_rel) || alu.flag(alu_src0_rel) ||
+       alu.flag(alu_src1_rel) || alu.flag(alu_src2_rel))
+      return false;
+
+   if (alu.cf_type() != cf_alu)
+      return false;
+
+   switch (alu.opcode()) {
+   case op0_nop:
+   case op0_group_barrier:
+   case op0_group_seq_begin:
+   case op0_group_seq_end:
+   case op2_set_mode:
+   case op1_set_cf_idx0:
+   case op1_set_cf_idx1:
+   case op2_set_lds_size:
+   case op1_mova_int:
+   case op0_store_flags:
+   case op1_load_store_flags:
+   case op0_lds_1a:
+   case op0_lds_1a1d:
+   case op0_lds_2a:
+   case op3_lds_idx_op:
+   case op2_kille:
+   case op2_killgt:
+   case op2_killge:
+   case op2_killne:
+   case op2_killgt_uint:
+   case op2_killge_uint:
+   case op2_kille_int:
+   case op2_killgt_int:
+   case op2_killge_int:
+   case op2_killne_int:
+   case op2_interp_xy:
+   case op2_interp_zw:
+   case op2_interp_x:
+   case op2_interp_z:
+   case op1_interp_load_p0:
+   case op1_interp_load_p10:
+   case op1_interp_load_p20:
+   /* these read the result of the previous instruction slot */
+   case op1_bcnt_accum_prev_int:
+   case op1_mbcnt_32lo_accum_prev_int:
+   case op2_sad_accum_prev_uint:
+   case op2_mul_prev:
+   case op2_mul_ieee_prev:
+   case op2_add_prev:
+   case op2_muladd_prev:
+   case op2_muladd_ieee_prev:
+   /* these occupy more than one slot */
+   case op2_dot4:
+   case op2_dot4_ieee:
+   case op2_dot:
+   case op2_dot_ieee:
+   case op2_cube:
+   case op1_max4:
+   case op1_flt_to_uint4:
+   case op2_mul_64:
+   case OP2V_MUL_64:
+   case op2_add_64:
+   case op1_flt64_to_flt32:
+   case op1_flt32_to_flt64:
+   case op1v_flt64_to_flt32:
+   case op1v_flt32_to_flt64:
+   case op1_recip_64:
+   case op1_recip_clamped_64:
+   case op1_recipsqrt_64:
+   case op1_recipsqrt_clamped_64:
+   case op1_sqrt_64:
+   case op2_sete_64:
+   case op2_setne_64:
+   case op2_setgt_64:
+   case op2_setge_64:
+   case op2_min_64:
+   case op2_max_64:
+   case op1_frexp_64:
+   case op1_ldexp_64:
+   case op1_fract_64:
+   case op2_pred_setgt_64:
+   case op2_pred_setge_64:
+   case op3_cndne_64:
+   case op3_fma_64:
+      return false;
+   default:
+      break;
+   }
+
+   /* the slot restrictions are needed to place the instruction */
+   return alu_ops.find(alu.opcode()) != alu_ops.end();
+}
+
+bool AluGroupScheduler::add_value(Unit& unit, const Value& v, bool is_dest) const
+{
+   switch (v.type()) {
+   case Value::gpr: {
+      int key = v.sel() * 4 + v.chan();
+      if (is_dest)
+         unit.writes.push_back(key);
+      else
+         unit.reads.push_back(key);
+      return true;
+   }
+   case Value::kconst: {
+      auto& c = static_cast<const UniformValue&>(v);
+      if (c.addr())
+         return false;
+      int line = (c.kcache_bank() << 16) | (c.sel() >> 4);
+      if (std::find(unit.kcache_lines.begin(), unit.kcache_lines.end(), line) ==
+          unit.kcache_lines.end())
+         unit.kcache_lines.push_back(line);
+      return true;
+   }
+   case Value::literal: {
+      uint32_t value = static_cast<const LiteralValue&>(v).value();
+      if (std::find(unit.literals.begin(), unit.literals.end(), value) ==
+          unit.literals.end())
+         unit.literals.push_back(value);
+      return true;
+   }
+   case Value::cinline:
+      /* PV and PS refer to the previous group, and the LDS queue must be
+       * read in order */
+      return (v.sel() < ALU_SRC_LDS_OQ_A || v.sel() > ALU_SRC_LDS_DIRECT_B) &&
+             v.sel() != ALU_SRC_PV && v.sel() != ALU_SRC_PS;
+   default:
+      return false;
+   }
+}
+
+/* List scheduling of the groups in [begin, end) into bundles: a group can
+ * go into a bundle only after the groups whose results it reads or whose
+ * destinations it overwrites, and no earlier than the groups that read the
+ * register it writes, because a bundle reads all its sources before the
+ * results are written. Within a bundle the original order is kept, so that
+ * the assembler sees readers before writers of a register.
+ *
+ * Groups that only read constant buffer lines already used by earlier
+ * bundles are preferred, so that the accesses to a line end up next to each
+ * other and the assembler needs fewer clause breaks to lock new lines. */
+void AluGroupScheduler::schedule(std::vector<PInstruction>::iterator begin,
+                                 std::vector<PInstruction>::iterator end)
+{
+   const int n = end - begin;
+   if (n < 2)
+      return;
+
+   std::vector<Unit> units(n);
+   for (int i = 0; i < n; ++i) {
+      Unit& u = units[i];
+      u.instr = begin[i];
+      u.alu = static_cast<AluInstruction *>(begin[i].get());
+
+      bool ok = true;
+      if (u.alu->dest() && u.alu->write())
+         ok = add_value(u, *u.alu->dest(), true);
+      for (unsigned s = 0; ok && s < u.alu->n_sources(); ++s)
+         ok = add_value(u, u.alu->src(s), false);
+
+      int unit_mask = alu_ops.at(u.alu->opcode()).unit_mask;
+      int chan = u.alu->dest() ? u.alu->dest()->chan() : 0;
+      u.slot_mask = unit_mask & (1 << chan);
+      if (m_has_trans_slot)
+         u.slot_mask |= unit_mask & AluOp::t;
+
+      if (!ok || !u.slot_mask) {
+         /* split the region at groups we can't reason about */
+         schedule(begin, begin + i);
+         schedule(begin + i + 1, end);
+         return;
+      }
+   }
+
+   /* hard dependencies need an earlier bundle, soft ones allow the same */
+   std::vector<std::vector<int>> hard(n), soft(n);
+   for (int j = 1; j < n; ++j) {
+      for (int i = 0; i < j; ++i) {
+         const Unit& a = units[i];
+         const Unit& b = units[j];
+         bool is_hard = false, is_soft = false;
+         for (int w : a.writes) {
+            is_hard |= std::find(b.reads.begin(), b.reads.end(), w) != b.reads.end();
+            is_hard |= std::find(b.writes.begin(), b.writes.end(), w) != b.writes.end();
+         }
+         for (int r : a.reads)
+            is_soft |= std::find(b.writes.begin(), b.writes.end(), r) != b.writes.end();
+         if (is_hard)
+            hard[j].push_back(i);
+         else if (is_soft)
+            soft[j].push_back(i);
+      }
+   }
+
+   std::vector<int> bundle(n, -1);
+   std::vector<int> order;
+   order.reserve(n);
+   std::vector<int> locked_lines;
+
+   for (int cur = 0; (int)order.size() < n; ++cur) {
+      int used_slots = 0;
+      std::vector<uint32_t> literals;
+      std::vector<int> kcache_lines;
+      size_t bundle_start = order.size();
+
+      for (int c = 0; c < 2 * n; ++c) {
+         int j = c % n;
+         if (bundle[j] >= 0)
+            continue;
+
+         /* in the first round only take groups that don't need new lines */
+         if (c < n && !locked_lines.empty()) {
+            bool new_lines = false;
+            for (auto v : units[j].kcache_lines)
+               new_lines |= std::find(locked_lines.begin(), locked_lines.end(), v) ==
+                            locked_lines.end();
+            if (new_lines)
+               continue;
+         }
+
+         bool ready = true;
+         for (int i : hard[j])
+            ready &= bundle[i] >= 0 && bundle[i] < cur;
+         for (int i : soft[j])
+            ready &= bundle[i] >= 0;
+         if (!ready)
+            continue;
+
+         const Unit& u = units[j];
+         int slot = u.slot_mask & ~used_slots;
+         /* prefer the vector slot, keep the trans slot for others */
+         if (slot & AluOp::v)
+            slot &= AluOp::v;
+         if (!slot)
+            continue;
+
+         std::vector<uint32_t> l = literals;
+         for (auto v : u.literals)
+            if (std::find(l.begin(), l.end(), v) == l.end())
+               l.push_back(v);
+         std::vector<int> k = kcache_lines;
+         for (auto v : u.kcache_lines)
+            if (std::find(k.begin(), k.end(), v) == k.end())
+               k.push_back(v);
+         if (used_slots &&
+             (l.size() > max_literals || k.size() > max_kcache_lines))
+            continue;
+
+         used_slots |= slot;
+         literals.swap(l);
+         kcache_lines.swap(k);
+         bundle[j] = cur;
+         order.push_back(j);
+      }
+
+      std::sort(order.begin() + bundle_start, order.end());
+      for (auto v : kcache_lines)
+         if (std::find(locked_lines.begin(), locked_lines.end(), v) ==
+             locked_lines.end())
+            locked_lines.push_back(v);
+      if (locked_lines.size() > max_kcache_lines)
+         locked_lines.erase(locked_lines.begin(),
+                            locked_lines.end() - max_kcache_lines);
+   }
+
+   bool changed = false;
+   for (int i = 0; i < n; ++i) {
+      changed |= order[i] != i;
+      begin[i] = units[order[i]].instr;
+   }
+
+   if (changed && sfn_log.has_debug_flag(SfnLog::schedule)) {
+      sfn_log << SfnLog::schedule << "Scheduled " << n << " ALU groups:\n";
+      for (int i = 0; i < n; ++i)
+         sfn_log << SfnLog::schedule << "  " << bundle[order[i]] << ": "
+                 << *begin[i] << "\n";
+   }
+}
+
+}
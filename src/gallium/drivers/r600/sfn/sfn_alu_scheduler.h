@@ -0,0 +1,71 @@
+/* -*- mesa-c++  -*-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SFN_ALU_SCHEDULER_H
+#define SFN_ALU_SCHEDULER_H
+
+#include "sfn_instruction_block.h"
+#include "sfn_instruction_alu.h"
+
+#include <vector>
+
+namespace r600 {
+
+/* Reorders the single slot ALU instruction groups within runs of ALU
+ * instructions, so that groups that don't depend on each other and use
+ * different slots follow each other. The assembler merges such adjacent
+ * groups into one VLIW bundle after checking the read port, literal and
+ * dependency constraints, so the scheduler only has to make that merge
+ * possible, and the code stays correct if a merge is rejected.
+ */
+class AluGroupScheduler {
+public:
+   /* Cayman only has the four vector slots, older chips also have the
+    * trans slot */
+   AluGroupScheduler(bool has_trans_slot);
+
+   void run(std::vector<InstructionBlock>& ir);
+
+private:
+   struct Unit {
+      AluInstruction *alu;
+      PInstruction instr;
+      std::vector<int> reads;
+      std::vector<int> writes;
+      std::vector<uint32_t> literals;
+      std::vector<int> kcache_lines;
+      int slot_mask;
+   };
+
+   void run(InstructionBlock& block);
+   void schedule(std::vector<PInstruction>::iterator begin,
+                 std::vector<PInstruction>::iterator end);
+
+   bool is_movable(const AluInstruction& alu) const;
+   bool add_value(Unit& unit, const Value& v, bool is_dest) const;
+
+   bool m_has_trans_slot;
+};
+
+}
+
+#endif // SFN_ALU_SCHEDULER_H
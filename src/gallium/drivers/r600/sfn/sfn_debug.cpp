@@ -71,6 +71,8 @@ static const struct debug_named_value sfn_debug_options[] = {
    {"nomerge", SfnLog::nomerge, "Skip register merge step"},
    {"tex", SfnLog::tex, "Log texture ops"},
    {"trans", SfnLog::trans, "Log generic translation messages"},
+   {"sched", SfnLog::schedule, "Log ALU group scheduling"},
+   {"nosched", SfnLog::nosched, "Skip ALU group scheduling"},
    DEBUG_NAMED_VALUE_END
 };
 
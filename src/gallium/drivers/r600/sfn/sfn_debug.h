@@ -54,8 +54,10 @@ public:
       merge = 1 << 10,
       tex = 1 << 11,
       trans = 1 << 12,
-      all = (1 << 13) - 1,
+      schedule = 1 << 13,
+      all = (1 << 14) - 1,
       nomerge = 1 << 16,
+      nosched = 1 << 17,
    };
 
    SfnLog();
@@ -0,0 +1,221 @@
+/* -*- mesa-c++  -*-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sfn_fetch_scheduler.h"
+#include "sfn_debug.h"
+#include "sfn_instruction_alu.h"
+#include "sfn_instruction_fetch.h"
+#include "sfn_instruction_tex.h"
+
+#include <algorithm>
+
+namespace r600 {
+
+/* Moving a fetch up extends the live range of its destination, so limit
+ * the number of ALU groups it may be moved over to keep the register
+ * pressure in check. */
+static const int max_hoist_groups = 16;
+
+FetchGroupScheduler::FetchGroupScheduler(unsigned max_clause_size):
+   m_max_clause_size(max_clause_size)
+{
+}
+
+void FetchGroupScheduler::run(std::vector<InstructionBlock>& ir)
+{
+   for (auto& block : ir)
+      run(block);
+}
+
+void FetchGroupScheduler::run(InstructionBlock& block)
+{
+   /* the position after the last fetch of the current clause */
+   auto clause_end = block.end();
+   auto clause_type = Instruction::unknown;
+   unsigned clause_size = 0;
+   int crossed_groups = 0;
+
+   for (auto i = block.begin(); i != block.end(); ++i) {
+      auto type = (*i)->type();
+
+      if (type == Instruction::tex || type == Instruction::vtx) {
+         std::vector<int> reads, writes;
+         bool ok = add_fetch(reads, writes, **i);
+
+         if (clause_end != block.end() && type == clause_type) {
+            if (i == clause_end) {
+               ++clause_size;
+               ++clause_end;
+               continue;
+            }
+            if (ok && clause_size < m_max_clause_size &&
+                crossed_groups <= max_hoist_groups &&
+                is_independent(reads, writes)) {
+               sfn_log << SfnLog::schedule << "Move fetch " << **i
+                       << " over " << crossed_groups << " ALU groups\n";
+               std::rotate(clause_end, i, i + 1);
+               ++clause_end;
+               ++clause_size;
+               continue;
+            }
+         }
+
+         /* start a new clause */
+         clause_end = i + 1;
+         clause_type = type;
+         clause_size = 1;
+         crossed_groups = 0;
+         m_alu_reads.clear();
+         m_alu_writes.clear();
+         continue;
+      }
+
+      if (clause_end != block.end() && type == Instruction::alu && add_alu(**i)) {
+         if (static_cast<const AluInstruction&>(**i).is_last())
+            ++crossed_groups;
+         continue;
+      }
+
+      clause_end = block.end();
+   }
+}
+
+bool FetchGroupScheduler::add_value(std::vector<int>& regs, const Value& v) const
+{
+   switch (v.type()) {
+   case Value::gpr:
+      if (v.chan() < 4)
+         regs.push_back(v.sel() * 4 + v.chan());
+      return true;
+   case Value::kconst: {
+      auto& c = static_cast<const UniformValue&>(v);
+      return !c.addr() || add_value(regs, *c.addr());
+   }
+   case Value::literal:
+   case Value::cinline:
+      return true;
+   default:
+      return false;
+   }
+}
+
+bool FetchGroupScheduler::add_fetch(std::vector<int>& reads, std::vector<int>& writes,
+                                    const Instruction& instr) const
+{
+   if (instr.type() == Instruction::tex) {
+      auto& tex = static_cast<const TexInstruction&>(instr);
+
+      /* the gradients and offsets are state of the fetch clause */
+      switch (tex.opcode()) {
+      case TexInstruction::get_gradient_h:
+      case TexInstruction::get_gradient_v:
+      case TexInstruction::set_offsets:
+      case TexInstruction::keep_gradients:
+      case TexInstruction::set_gradient_h:
+      case TexInstruction::set_gradient_v:
+      case TexInstruction::sample_g:
+      case TexInstruction::sample_g_lb:
+      case TexInstruction::sample_c_g:
+      case TexInstruction::sample_c_g_lb:
+         return false;
+      default:
+         break;
+      }
+
+      if (tex.sampler_offset() && !add_value(reads, *tex.sampler_offset()))
+         return false;
+
+      for (int i = 0; i < 4; ++i) {
+         if (tex.src().reg_i(i) && !add_value(reads, *tex.src().reg_i(i)))
+            return false;
+         if (tex.dst().reg_i(i) && !add_value(writes, *tex.dst().reg_i(i)))
+            return false;
+      }
+      return true;
+   }
+
+   auto& fetch = static_cast<const FetchInstruction&>(instr);
+   if (fetch.has_prelude())
+      return false;
+
+   if (!add_value(reads, fetch.src()))
+      return false;
+
+   if (fetch.buffer_offset() && !add_value(reads, *fetch.buffer_offset()))
+      return false;
+
+   for (int i = 0; i < 4; ++i)
+      if (fetch.dst().reg_i(i) && !add_value(writes, *fetch.dst().reg_i(i)))
+         return false;
+
+   return true;
+}
+
+bool FetchGroupScheduler::add_alu(const Instruction& instr)
+{
+   auto& alu = static_cast<const AluInstruction&>(instr);
+
+   if (alu.cf_type() != cf_alu || alu.flag(alu_update_exec) ||
+       alu.flag(alu_update_pred))
+      return false;
+
+   switch (alu.opcode()) {
+   case op0_group_barrier:
+   case op1_mova_int:
+   case op1_set_cf_idx0:
+   case op1_set_cf_idx1:
+      return false;
+   default:
+      break;
+   }
+
+   if (alu.dest() && !add_value(m_alu_writes, *alu.dest()))
+      return false;
+
+   for (unsigned s = 0; s < alu.n_sources(); ++s)
+      if (!add_value(m_alu_reads, alu.src(s)))
+         return false;
+
+   return true;
+}
+
+/* A fetch can be moved over the ALU groups if it doesn't read what they
+ * write, and doesn't write what they access. */
+bool FetchGroupScheduler::is_independent(const std::vector<int>& reads,
+                                         const std::vector<int>& writes) const
+{
+   auto contains = [](const std::vector<int>& set, int reg) {
+      return std::find(set.begin(), set.end(), reg) != set.end();
+   };
+
+   for (int r : reads)
+      if (contains(m_alu_writes, r))
+         return false;
+
+   for (int w : writes)
+      if (contains(m_alu_writes, w) || contains(m_alu_reads, w))
+         return false;
+
+   return true;
+}
+
+}
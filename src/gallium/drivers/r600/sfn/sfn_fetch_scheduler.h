@@ -0,0 +1,64 @@
+/* -*- mesa-c++  -*-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SFN_FETCH_SCHEDULER_H
+#define SFN_FETCH_SCHEDULER_H
+
+#include "sfn_instruction_block.h"
+
+#include <vector>
+
+namespace r600 {
+
+/* Moves texture and vertex fetches up past independent ALU groups, so that
+ * they directly follow the previous fetch of the same kind. The assembler
+ * puts consecutive fetches into one clause, hence this reduces the number
+ * of fetch clauses and the switches between ALU and fetch clauses, and the
+ * ALU work that was skipped over now hides the latency of the fetch.
+ */
+class FetchGroupScheduler {
+public:
+   /* R600 fetch clauses take up to 8 instructions, later chips 16 */
+   FetchGroupScheduler(unsigned max_clause_size);
+
+   void run(std::vector<InstructionBlock>& ir);
+
+private:
+   void run(InstructionBlock& block);
+
+   bool add_value(std::vector<int>& regs, const Value& v) const;
+   bool add_fetch(std::vector<int>& reads, std::vector<int>& writes,
+                  const Instruction& instr) const;
+   bool add_alu(const Instruction& instr);
+   bool is_independent(const std::vector<int>& reads,
+                       const std::vector<int>& writes) const;
+
+   unsigned m_max_clause_size;
+
+   /* registers accessed by the ALU groups a fetch would be moved over */
+   std::vector<int> m_alu_reads;
+   std::vector<int> m_alu_writes;
+};
+
+}
+
+#endif // SFN_FETCH_SCHEDULER_H
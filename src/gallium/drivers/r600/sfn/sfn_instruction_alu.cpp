@@ -52,11 +52,11 @@ AluInstruction::AluInstruction(EAluOp opcode, PValue dest,
                                const std::set<AluModifiers>& flags):
    Instruction (Instruction::alu),
    m_opcode(opcode),
-   m_dest(dest),
+   m_dest(std::move(dest)),
    m_bank_swizzle(alu_vec_unknown),
    m_cf_type(cf_alu)
 {
-   assert(dest);
+   assert(m_dest);
    m_src.swap(src);
    for (auto f : flags)
       m_flags.set(f);
@@ -72,24 +72,53 @@ AluInstruction::AluInstruction(EAluOp opcode, PValue dest,
 
 AluInstruction::AluInstruction(EAluOp opcode, PValue dest, PValue src0,
                                const std::set<AluModifiers>& flags):
-   AluInstruction(opcode, dest, std::vector<PValue>{src0}, flags)
+   AluInstruction(opcode, std::move(dest), make_src(std::move(src0)), flags)
 {
 }
 
 AluInstruction::AluInstruction(EAluOp opcode, PValue dest,
                                PValue src0, PValue src1,
                                const std::set<AluModifiers> &m_flags):
-   AluInstruction(opcode, dest, {src0, src1}, m_flags)
+   AluInstruction(opcode, std::move(dest),
+                  make_src(std::move(src0), std::move(src1)), m_flags)
 {
 }
 
 AluInstruction::AluInstruction(EAluOp opcode, PValue dest, PValue src0,
                                PValue src1, PValue src2,
                                const std::set<AluModifiers> &flags):
-   AluInstruction(opcode, dest, {src0, src1, src2}, flags)
+   AluInstruction(opcode, std::move(dest),
+                  make_src(std::move(src0), std::move(src1), std::move(src2)),
+                  flags)
 {
 }
 
+/* Brace initialized vectors copy their elements out of the initializer list,
+ * the sources are moved instead to avoid the reference count updates */
+std::vector<PValue> AluInstruction::make_src(PValue src0)
+{
+   std::vector<PValue> src(1);
+   src[0] = std::move(src0);
+   return src;
+}
+
+std::vector<PValue> AluInstruction::make_src(PValue src0, PValue src1)
+{
+   std::vector<PValue> src(2);
+   src[0] = std::move(src0);
+   src[1] = std::move(src1);
+   return src;
+}
+
+std::vector<PValue> AluInstruction::make_src(PValue src0, PValue src1, PValue src2)
+{
+   std::vector<PValue> src(3);
+   src[0] = std::move(src0);
+   src[1] = std::move(src1);
+   src[2] = std::move(src2);
+   return src;
+}
+
 bool AluInstruction::is_equal_to(const Instruction& lhs) const
 {
    assert(lhs.type() == alu);
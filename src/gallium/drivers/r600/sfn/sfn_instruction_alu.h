@@ -103,7 +103,7 @@ public:
    void set_flag(AluModifiers flag);
    unsigned n_sources() const;
 
-   PValue dest() {return m_dest;}
+   const PValue& dest() {return m_dest;}
    EAluOp opcode() const {return m_opcode;}
    const Value *dest() const {return m_dest.get();}
    Value& src(unsigned i) const {assert(i < m_src.size() && m_src[i]); return *m_src[i];}
@@ -123,6 +123,10 @@ public:
 
 private:
 
+   static std::vector<PValue> make_src(PValue src0);
+   static std::vector<PValue> make_src(PValue src0, PValue src1);
+   static std::vector<PValue> make_src(PValue src0, PValue src1, PValue src2);
+
    bool is_equal_to(const Instruction& lhs) const override;
    void do_print(std::ostream& os) const override;
    PValue remap_one_registers(PValue reg, std::vector<rename_reg_pair>& map,
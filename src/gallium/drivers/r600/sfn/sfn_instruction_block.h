@@ -47,6 +47,13 @@ public:
            return m_block.end();
         }
 
+        std::vector<PInstruction>::iterator begin() {
+           return m_block.begin();
+        }
+        std::vector<PInstruction>::iterator end() {
+           return m_block.end();
+        }
+
         void remap_registers(ValueRemapper& map);
 
         size_t size() const {
@@ -77,8 +77,20 @@ prog_scope::prog_scope(prog_scope *parent, prog_scope_type type, int id,
    scope_begin(scope_begin),
    scope_end(-1),
    break_loop_line(numeric_limits<int>::max()),
-   parent_scope(parent)
-{
+   parent_scope(parent),
+   parent_loop(nullptr),
+   parent_outer_loop(nullptr),
+   parent_ifelse(nullptr),
+   parent_else(nullptr),
+   parent_conditional(nullptr)
+{
+   if (parent) {
+      parent_loop = parent->is_loop() ? parent : parent->parent_loop;
+      parent_outer_loop = parent->outermost_loop();
+      parent_ifelse = parent->in_ifelse_scope();
+      parent_else = parent->in_else_scope();
+      parent_conditional = parent->enclosing_conditional();
+   }
 }
 
 prog_scope::prog_scope():
@@ -108,13 +120,7 @@ bool prog_scope::is_loop() const
 
 bool prog_scope::is_in_loop() const
 {
-   if (scope_type == loop_body)
-      return true;
-
-   if (parent_scope)
-      return parent_scope->is_in_loop();
-
-   return false;
+   return scope_type == loop_body || parent_loop;
 }
 
 const prog_scope *prog_scope::innermost_loop() const
@@ -122,24 +128,15 @@ const prog_scope *prog_scope::innermost_loop() const
    if (scope_type == loop_body)
       return this;
 
-   if (parent_scope)
-      return parent_scope->innermost_loop();
-
-   return nullptr;
+   return parent_loop;
 }
 
 const prog_scope *prog_scope::outermost_loop() const
 {
-   const prog_scope *loop = nullptr;
-   const prog_scope *p = this;
+   if (parent_outer_loop)
+      return parent_outer_loop;
 
-   do {
-      if (p->type() == loop_body)
-         loop = p;
-      p = p->parent();
-   } while (p);
-
-   return loop;
+   return scope_type == loop_body ? this : nullptr;
 }
 
 bool prog_scope::is_child_of_ifelse_id_sibling(const prog_scope *scope) const
@@ -173,10 +170,7 @@ const prog_scope *prog_scope::enclosing_conditional() const
    if (is_conditional())
       return this;
 
-   if (parent_scope)
-      return parent_scope->enclosing_conditional();
-
-   return nullptr;
+   return parent_conditional;
 }
 
 bool prog_scope::contains_range_of(const prog_scope& other) const
@@ -197,18 +191,12 @@ const prog_scope *prog_scope::in_else_scope() const
    if (scope_type == else_branch)
       return this;
 
-   if (parent_scope)
-      return parent_scope->in_else_scope();
-
-   return nullptr;
+   return parent_else;
 }
 
 const prog_scope *prog_scope::in_parent_ifelse_scope() const
 {
-        if (parent_scope)
-                return parent_scope->in_ifelse_scope();
-        else
-                return nullptr;
+   return parent_ifelse;
 }
 
 const prog_scope *prog_scope::in_ifelse_scope() const
@@ -217,10 +205,7 @@ const prog_scope *prog_scope::in_ifelse_scope() const
        scope_type == else_branch)
       return this;
 
-   if (parent_scope)
-      return parent_scope->in_ifelse_scope();
-
-   return nullptr;
+   return parent_ifelse;
 }
 
 bool prog_scope::is_switchcase_scope_in_loop() const
@@ -269,12 +254,10 @@ void prog_scope::set_end(int end)
 
 void prog_scope::set_loop_break_line(int line)
 {
-   if (scope_type == loop_body) {
+   if (scope_type == loop_body)
       break_loop_line = MIN2(break_loop_line, line);
-   } else {
-      if (parent_scope)
-         parent()->set_loop_break_line(line);
-   }
+   else if (parent_loop)
+      parent_loop->break_loop_line = MIN2(parent_loop->break_loop_line, line);
 }
 
 int prog_scope::loop_break_line() const
@@ -103,6 +103,17 @@ private:
    int scope_end;
    int break_loop_line;
    prog_scope *parent_scope;
+
+   /* The enclosing scopes of the parent are resolved when the scope is
+    * created, so that the queries issued for every register access don't
+    * have to walk the scope chain. Only the parent's values are stored,
+    * because the scope is copied into its storage slot after construction.
+    */
+   prog_scope *parent_loop;
+   const prog_scope *parent_outer_loop;
+   const prog_scope *parent_ifelse;
+   const prog_scope *parent_else;
+   const prog_scope *parent_conditional;
 };
 
 /* Some storage class to encapsulate the prog_scope (de-)allocations */
@@ -40,6 +40,8 @@
 #include "sfn_shader_tess_eval.h"
 #include "sfn_nir_lower_fs_out_to_vector.h"
 #include "sfn_ir_to_assembly.h"
+#include "sfn_alu_scheduler.h"
+#include "sfn_fetch_scheduler.h"
 
 #include <vector>
 
@@ -169,6 +171,13 @@ bool ShaderFromNir::lower(const nir_shader *shader, r600_pipe_shader *pipe_shade
    sfn_log << SfnLog::trans << "Finalize\n";
    impl->finalize();
 
+   if (!sfn_log.has_debug_flag(SfnLog::nosched)) {
+      sfn_log << SfnLog::trans << "Schedule fetches\n";
+      FetchGroupScheduler(chip_class == R600 ? 8 : 16).run(impl->m_output);
+      sfn_log << SfnLog::trans << "Schedule ALU groups\n";
+      AluGroupScheduler(chip_class != CAYMAN).run(impl->m_output);
+   }
+
    impl->get_array_info(pipe_shader->shader);
 
    if (!sfn_log.has_debug_flag(SfnLog::nomerge)) {
@@ -112,7 +112,7 @@ GPRVector::GPRVector(uint32_t sel, std::array<uint32_t,4> swizzle):
    m_valid(true)
 {
    for (int i = 0; i < 4; ++i)
-      m_elms[i] = PValue(new GPRValue(sel, swizzle[i]));
+      m_elms[i] = std::make_shared<GPRValue>(sel, swizzle[i]);
 }
 
 GPRVector::GPRVector(const GPRVector& orig, const std::array<uint8_t,4>& swizzle)
@@ -47,6 +47,41 @@ ValuePool::ValuePool():
 
 PValue ValuePool::m_undef = Value::zero;
 
+static const PValue no_value;
+
+int ValuePool::lookup_ssa_register(unsigned ssa_index) const
+{
+   return ssa_index < m_ssa_register_map.size() ?
+            m_ssa_register_map[ssa_index] : -1;
+}
+
+int ValuePool::lookup_local_register(unsigned reg_index) const
+{
+   return reg_index < m_local_register_map.size() ?
+            m_local_register_map[reg_index] : -1;
+}
+
+void ValuePool::map_ssa_register(unsigned ssa_index, int index)
+{
+   if (ssa_index >= m_ssa_register_map.size())
+      m_ssa_register_map.resize(ssa_index + 1, -1);
+   m_ssa_register_map[ssa_index] = index;
+}
+
+void ValuePool::map_local_register(unsigned reg_index, int index)
+{
+   if (reg_index >= m_local_register_map.size())
+      m_local_register_map.resize(reg_index + 1, -1);
+   m_local_register_map[reg_index] = index;
+}
+
+void ValuePool::set_register(unsigned idx, const PValue& reg)
+{
+   if (idx >= m_registers.size())
+      m_registers.resize(idx + 1);
+   m_registers[idx] = reg;
+}
+
 GPRVector ValuePool::vec_from_nir(const nir_dest& dst, int num_components)
 {
    std::array<PValue, 4> result;
@@ -101,14 +136,14 @@ PValue ValuePool::from_nir(const nir_src& v, unsigned component, unsigned swizzl
 
    unsigned index = v.ssa->index;
    /* For undefs we use zero and let ()yet to be implemeneted dce deal with it */
-   if (m_ssa_undef.find(index) != m_ssa_undef.end())
+   if (index < m_ssa_undef.size() && m_ssa_undef[index])
       return Value::zero;
 
 
    int idx = lookup_register_index(v);
    sfn_log << SfnLog::reg << "  -> got index " <<  idx << "\n";
    if (idx >= 0) {
-      auto reg = lookup_register(idx, swizzled, false);
+      const auto& reg = lookup_register(idx, swizzled, false);
       if (reg)
          return reg;
    }
@@ -118,13 +153,13 @@ PValue ValuePool::from_nir(const nir_src& v, unsigned component, unsigned swizzl
       assert(v.is_ssa);
       switch (v.ssa->bit_size) {
       case 1:
-         return PValue(new LiteralValue(literal_val[swizzled].b ? 0xffffffff : 0, component));
+         return std::make_shared<LiteralValue>(literal_val[swizzled].b ? 0xffffffff : 0, component);
       case 32:
          return literal(literal_val[swizzled].u32);
       default:
          sfn_log << SfnLog::reg << "Unsupported bit size " << v.ssa->bit_size
                  << " fall back to 32\n";
-         return PValue(new LiteralValue(literal_val[swizzled].u32, component));
+         return std::make_shared<LiteralValue>(literal_val[swizzled].u32, component);
       }
    }
 
@@ -202,11 +237,9 @@ int ValuePool::lookup_register_index(const nir_src& src) const
 
    sfn_log << SfnLog::reg << " LIDX:" << index;
 
-   auto r = m_register_map.find(index);
-   if (r == m_register_map.end()) {
+   if (index < 0 || static_cast<unsigned>(index) >= m_register_map.size())
       return -1;
-   }
-   return static_cast<int>(r->second.index);
+   return m_register_map[index].index;
 }
 
 
@@ -247,10 +280,12 @@ ValueMap ValuePool::get_temp_registers() const
    ValueMap result;
 
    for (auto& v : m_registers) {
-      if (v.second->type() == Value::gpr)
-         result.insert(v.second);
-      else if (v.second->type() == Value::gpr_vector) {
-         auto& array = static_cast<GPRArray&>(*v.second);
+      if (!v)
+         continue;
+      if (v->type() == Value::gpr)
+         result.insert(v);
+      else if (v->type() == Value::gpr_vector) {
+         auto& array = static_cast<GPRArray&>(*v);
          array.collect_registers(result);
       }
    }
@@ -263,8 +298,8 @@ PValue ValuePool::create_register(unsigned sel, unsigned swizzle)
 {
    sfn_log << SfnLog::reg
            <<"Create register " << sel  << '.' << swz[swizzle] << "\n";
-   auto retval = PValue(new GPRValue(sel, swizzle));
-   m_registers[(sel << 3) + swizzle] = retval;
+   PValue retval = std::make_shared<GPRValue>(sel, swizzle);
+   set_register((sel << 3) + swizzle, retval);
    return retval;
 }
 
@@ -274,11 +309,11 @@ bool ValuePool::inject_register(unsigned sel, unsigned swizzle,
    uint32_t ssa_index = sel;
 
    if (map) {
-      auto pos = m_ssa_register_map.find(sel);
-      if (pos == m_ssa_register_map.end())
+      int pos = lookup_ssa_register(sel);
+      if (pos < 0)
          ssa_index = m_next_register_index++;
       else
-         ssa_index = pos->second;
+         ssa_index = pos;
    }
 
    sfn_log << SfnLog::reg
@@ -286,19 +321,19 @@ bool ValuePool::inject_register(unsigned sel, unsigned swizzle,
            << " at index " <<  ssa_index << " ...";
 
    if (map)
-      m_ssa_register_map[sel] = ssa_index;
+      map_ssa_register(sel, ssa_index);
 
    allocate_with_mask(ssa_index, swizzle, true);
 
    unsigned idx = (ssa_index << 3) + swizzle;
-   auto p = m_registers.find(idx);
-   if ( (p != m_registers.end()) && *p->second != *reg) {
+   if (idx < m_registers.size() && m_registers[idx] &&
+       *m_registers[idx] != *reg) {
       std::cerr << "Register location (" << ssa_index << ", " << swizzle << ") was already reserved\n";
       assert(0);
       return false;
    }
    sfn_log << SfnLog::reg << " at idx:" << idx << " to " << *reg << "\n";
-   m_registers[idx] = reg;
+   set_register(idx, reg);
 
    if (m_next_register_index <= ssa_index)
       m_next_register_index = ssa_index + 1;
@@ -306,20 +341,17 @@ bool ValuePool::inject_register(unsigned sel, unsigned swizzle,
 }
 
 
-PValue ValuePool::lookup_register(unsigned sel, unsigned swizzle,
-                                  bool required)
+const PValue& ValuePool::lookup_register(unsigned sel, unsigned swizzle,
+                                         bool required)
 {
-
-   PValue retval;
+   unsigned idx = (sel << 3) + swizzle;
    sfn_log << SfnLog::reg
            << "lookup register " << sel  << '.' << swz[swizzle] << "("
-           << ((sel << 3) + swizzle) << ")...";
-
+           << idx << ")...";
 
-   auto reg = m_registers.find((sel << 3) + swizzle);
-   if (reg != m_registers.end()) {
-      sfn_log << SfnLog::reg << " -> Found " << *reg->second << "\n";
-      retval = reg->second;
+   if (idx < m_registers.size() && m_registers[idx]) {
+      sfn_log << SfnLog::reg << " -> Found " << *m_registers[idx] << "\n";
+      return m_registers[idx];
    } else if (swizzle == 7) {
       PValue retval = create_register(sel, swizzle);
       sfn_log << SfnLog::reg << " -> Created " << *retval << "\n";
@@ -329,7 +361,7 @@ PValue ValuePool::lookup_register(unsigned sel, unsigned swizzle,
       assert(0 && "Unallocated register value requested\n");
    }
    sfn_log << SfnLog::reg << " -> Not required and not  allocated\n";
-   return retval;
+   return no_value;
 }
 
 unsigned ValuePool::get_dst_ssa_register_index(const nir_ssa_def& ssa)
@@ -337,15 +369,15 @@ unsigned ValuePool::get_dst_ssa_register_index(const nir_ssa_def& ssa)
    sfn_log << SfnLog::reg << __func__ << ": search dst ssa "
            << ssa.index;
 
-   auto pos = m_ssa_register_map.find(ssa.index);
-   if (pos == m_ssa_register_map.end()) {
+   int pos = lookup_ssa_register(ssa.index);
+   if (pos < 0) {
       sfn_log << SfnLog::reg << " Need to allocate ...";
       allocate_ssa_register(ssa);
-      pos = m_ssa_register_map.find(ssa.index);
-      assert(pos != m_ssa_register_map.end());
+      pos = lookup_ssa_register(ssa.index);
+      assert(pos >= 0);
    }
-   sfn_log << SfnLog::reg << "... got " << pos->second << "\n";
-   return pos->second;
+   sfn_log << SfnLog::reg << "... got " << pos << "\n";
+   return pos;
 }
 
 unsigned ValuePool::get_ssa_register_index(const nir_ssa_def& ssa) const
@@ -353,39 +385,36 @@ unsigned ValuePool::get_ssa_register_index(const nir_ssa_def& ssa) const
    sfn_log << SfnLog::reg << __func__ << ": search ssa "
            << ssa.index;
 
-   auto pos = m_ssa_register_map.find(ssa.index);
-   sfn_log << SfnLog::reg << " got " << pos->second<< "\n";
-   if (pos == m_ssa_register_map.end()) {
+   int pos = lookup_ssa_register(ssa.index);
+   sfn_log << SfnLog::reg << " got " << pos << "\n";
+   if (pos < 0) {
       sfn_log << SfnLog::reg << __func__ << ": ssa register "
               << ssa.index << " lookup failed\n";
       return -1;
    }
-   return pos->second;
+   return pos;
 }
 
 unsigned ValuePool::get_local_register_index(const nir_register& reg)
 {
-   unsigned index = reg.index | 0x80000000;
-
-   auto pos = m_ssa_register_map.find(index);
-   if (pos == m_ssa_register_map.end()) {
+   int pos = lookup_local_register(reg.index);
+   if (pos < 0) {
       allocate_local_register(reg);
-      pos = m_ssa_register_map.find(index);
-      assert(pos != m_ssa_register_map.end());
+      pos = lookup_local_register(reg.index);
+      assert(pos >= 0);
    }
-   return pos->second;
+   return pos;
 }
 
 unsigned ValuePool::get_local_register_index(const nir_register& reg) const
 {
-   unsigned index = reg.index | 0x80000000;
-   auto pos = m_ssa_register_map.find(index);
-   if (pos == m_ssa_register_map.end()) {
+   int pos = lookup_local_register(reg.index);
+   if (pos < 0) {
       sfn_log << SfnLog::err << __func__ << ": local register "
               << reg.index << " lookup failed";
       return -1;
    }
-   return pos->second;
+   return pos;
 }
 
 void ValuePool::allocate_ssa_register(const nir_ssa_def& ssa)
@@ -393,7 +422,7 @@ void ValuePool::allocate_ssa_register(const nir_ssa_def& ssa)
    sfn_log << SfnLog::reg << "ValuePool: Allocate ssa register " << ssa.index
            << " as " << m_next_register_index << "\n";
    int index = m_next_register_index++;
-   m_ssa_register_map[ssa.index] = index;
+   map_ssa_register(ssa.index, index);
    allocate_with_mask(index, 0xf, true);
 }
 
@@ -430,12 +459,14 @@ void ValuePool::allocate_arrays(array_list& arrays)
               << " of size " << a.length << " with " << a.ncomponents
               << " components, mask " << mask << "\n";
 
-      m_ssa_register_map[a.index | 0x80000000] = current_index + instance;
+      map_local_register(a.index, current_index + instance);
 
       for (unsigned  i = 0; i < a.ncomponents; ++i)
-         m_registers[((current_index  + instance) << 3) + i] = array;
+         set_register(((current_index  + instance) << 3) + i, array);
 
-      VRec next_reg = {current_index + instance, mask, mask};
+      VRec next_reg = {current_index + static_cast<int>(instance), mask, mask};
+      if (m_register_map.size() <= current_index + instance)
+         m_register_map.resize(current_index + instance + 1, {-1, 0, 0});
       m_register_map[current_index + instance] = next_reg;
 
       ncomponents += a.ncomponents;
@@ -446,13 +477,13 @@ void ValuePool::allocate_arrays(array_list& arrays)
 void ValuePool::allocate_local_register(const nir_register& reg)
 {
    int index = m_next_register_index++;
-   m_ssa_register_map[reg.index | 0x80000000] = index;
+   map_local_register(reg.index, index);
    allocate_with_mask(index, 0xf, true);
 
    /* Create actual register and map it */;
    for (int i = 0; i < 4; ++i) {
       int k = (index << 3) + i;
-      m_registers[k] = std::make_shared<GPRValue>(index, i);
+      set_register(k, std::make_shared<GPRValue>(index, i));
    }
 }
 
@@ -471,39 +502,44 @@ void ValuePool::allocate_local_register(const nir_register& reg, array_list& arr
 
 bool ValuePool::create_undef(nir_ssa_undef_instr* instr)
 {
-   m_ssa_undef.insert(instr->def.index);
+   unsigned index = instr->def.index;
+   if (index >= m_ssa_undef.size())
+      m_ssa_undef.resize(index + 1, false);
+   m_ssa_undef[index] = true;
    return true;
 }
 
 int ValuePool::allocate_with_mask(unsigned index, unsigned mask, bool pre_alloc)
 {
    int retval;
-   VRec next_register = { index, mask };
+   VRec next_register = { static_cast<int>(index), mask, 0 };
 
    sfn_log << SfnLog::reg << (pre_alloc ? "Pre-alloc" : "Allocate")
            << " register (" << index << ", " << mask << ")\n";
    retval = index;
-   auto r = m_register_map.find(index);
+   if (index >= m_register_map.size())
+      m_register_map.resize(index + 1, {-1, 0, 0});
+   auto& r = m_register_map[index];
 
-   if (r != m_register_map.end()) {
-      if ((r->second.mask & next_register.mask) &&
-          !(r->second.pre_alloc_mask & next_register.mask)) {
+   if (r.index >= 0) {
+      if ((r.mask & next_register.mask) &&
+          !(r.pre_alloc_mask & next_register.mask)) {
          std::cerr << "r600 ERR: register ("
                    << index << ", " << mask
-                   << ") already allocated as (" << r->second.index << ", "
-                   << r->second.mask << ", " << r->second.pre_alloc_mask
+                   << ") already allocated as (" << r.index << ", "
+                   << r.mask << ", " << r.pre_alloc_mask
                    << ") \n";
          retval = -1;
       } else {
-         r->second.mask |= next_register.mask;
+         r.mask |= next_register.mask;
          if (pre_alloc)
-            r->second.pre_alloc_mask |= next_register.mask;
-         retval = r->second.index;
+            r.pre_alloc_mask |= next_register.mask;
+         retval = r.index;
       }
    } else  {
       if (pre_alloc)
          next_register.pre_alloc_mask = mask;
-      m_register_map[index] = next_register;
+      r = next_register;
       retval = next_register.index;
    }
 
@@ -515,12 +551,10 @@ int ValuePool::allocate_with_mask(unsigned index, unsigned mask, bool pre_alloc)
 
 PValue ValuePool::literal(uint32_t value)
 {
-   auto l = m_literals.find(value);
-   if (l != m_literals.end())
-      return l->second;
-
-   m_literals[value] = PValue(new LiteralValue(value));
-   return m_literals[value];
+   auto& l = m_literals[value];
+   if (!l)
+      l = std::make_shared<LiteralValue>(value);
+   return l;
 }
 
 }
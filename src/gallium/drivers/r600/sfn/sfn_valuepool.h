@@ -33,6 +33,7 @@
 
 #include <set>
 #include <queue>
+#include <unordered_map>
 
 namespace r600 {
 
@@ -150,7 +151,9 @@ public:
 
    ValueMap get_temp_registers() const;
 
-   PValue lookup_register(unsigned sel, unsigned swizzle, bool required);
+   /** The returned reference stays valid until the next register is
+    * created, copy it if it is kept around */
+   const PValue& lookup_register(unsigned sel, unsigned swizzle, bool required);
 
    size_t register_count() const {return m_next_register_index;}
 
@@ -213,25 +216,37 @@ private:
     *                 false: return nullptr on failure
     */
 
-   std::set<unsigned> m_ssa_undef;
+   int lookup_ssa_register(unsigned ssa_index) const;
+   int lookup_local_register(unsigned reg_index) const;
+   void map_ssa_register(unsigned ssa_index, int index);
+   void map_local_register(unsigned reg_index, int index);
+   void set_register(unsigned idx, const PValue& reg);
 
-   std::map<unsigned, unsigned> m_ssa_register_map;
+   /* NIR SSA and register indices as well as the r600 register indices are
+    * dense, so the lookup tables are indexed directly, with -1 or an empty
+    * value marking entries that are not mapped. */
+   std::vector<bool> m_ssa_undef;
 
-   std::map<unsigned, PValue> m_registers;
+   std::vector<int> m_ssa_register_map;
+
+   std::vector<int> m_local_register_map;
+
+   /* indexed by (sel << 3) + swizzle */
+   std::vector<PValue> m_registers;
 
    static PValue m_undef;
 
    struct VRec {
-      unsigned index;
+      int index;
       unsigned mask;
       unsigned pre_alloc_mask;
    };
-   std::map<unsigned, VRec> m_register_map;
+   std::vector<VRec> m_register_map;
 
    unsigned m_next_register_index;
 
 
-   std::map<uint32_t, PValue> m_literals;
+   std::unordered_map<uint32_t, PValue> m_literals;
 
    int current_temp_reg_index;
    int next_temp_reg_comp;
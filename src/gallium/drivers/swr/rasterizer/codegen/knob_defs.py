@@ -144,11 +144,24 @@ KNOBS = [
         'category'  : 'perf_adv',
     }],
 
+    ['BUCKETS_TRACE', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Also write the per thread timelines of the buckets data to rdtsc.json,',
+                       'in the Chrome trace event format used by chrome://tracing and Perfetto.',
+                       'Each entry has the draw id, and the macrotile for backend work.',
+                       '',
+                       'NOTE: KNOB_ENABLE_RDTSC must be enabled in core/knobs.h',
+                       'for this to have an effect.'],
+        'category'  : 'perf_adv',
+    }],
+
     ['WORKER_SPIN_LOOP_COUNT', {
         'type'      : 'uint32_t',
         'default'   : '5000',
-        'desc'      : ['Number of spin-loop iterations worker threads will perform',
-                       'before going to sleep when waiting for work'],
+        'desc'      : ['Maximum number of spin-loop iterations worker threads will perform',
+                       'before going to sleep when waiting for work. Workers that keep',
+                       'waiting longer than that spin for less, down to 1/32 of it.'],
         'category'  : 'perf_adv',
     }],
 
@@ -188,11 +201,22 @@ KNOBS = [
 
     ['JIT_ENABLE_CACHE', {
         'type'      : 'bool',
-        'default'   : 'false',
-        'desc'      : ['Enables caching of compiled shaders'],
+        'default'   : 'true',
+        'desc'      : ['Enables caching of compiled shaders in the mesa shader disk cache.',
+                       'The cache location and size are controlled by the MESA_SHADER_CACHE_*',
+                       'environment variables.'],
         'category'  : 'debug_adv',
     }],
 
+    ['JIT_TIERED_COMPILATION', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Jits fetch, blend and streamout functions without codegen optimizations',
+                       'first and swaps in optimized code compiled on a background thread.',
+                       'Reduces the stalls on state changes.'],
+        'category'  : 'perf',
+    }],
+
     ['JIT_OPTIMIZATION_LEVEL', {
         'type'      : 'int',
         'default'   : '-1',
@@ -228,13 +252,6 @@ KNOBS = [
         ],
     }],
 
-    ['JIT_CACHE_DIR', {
-        'type'      : 'std::string',
-        'default'   : r'%TEMP%\SWR\JitCache' if sys.platform == 'win32' else '${HOME}/.swr/jitcache',
-        'desc'      : ['Cache directory for compiled shaders.'],
-        'category'  : 'debug',
-    }],
-
     ['TOSS_DRAW', {
         'type'      : 'bool',
         'default'   : 'false',
@@ -173,12 +173,73 @@ void BucketManager::PrintReport(const std::string& filename)
 }
 
 
-void BucketManager::StartCapture()
+void BucketManager::PrintTrace(const std::string& filename)
+{
+    FILE* f = fopen(filename.c_str(), "w");
+    if (!f)
+    {
+        return;
+    }
+
+    // the rdtsc rate over the capture converts the timestamps to microseconds
+    double elapsedUs = std::chrono::duration<double, std::micro>(mCaptureEndTime -
+                                                                 mCaptureStartTime).count();
+    double ticksPerUs = elapsedUs > 0.0 ? (mCaptureEndTsc - mCaptureStartTsc) / elapsedUs : 1.0;
+
+    const char* separator = "";
+    fprintf(f, "{\"traceEvents\":[\n");
+
+    mThreadMutex.lock();
+    for (const BUCKET_THREAD& thread : mThreads)
+    {
+        fprintf(f,
+                "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,"
+                "\"args\":{\"name\":\"%s %u\"}}",
+                separator,
+                thread.id,
+                thread.name.c_str(),
+                thread.id);
+        separator = ",\n";
+
+        for (const TRACE_EVENT& event : thread.trace)
+        {
+            if (!event.end || event.start < mCaptureStartTsc)
+            {
+                continue;
+            }
+
+            fprintf(f,
+                    "%s{\"name\":\"%s\",\"cat\":\"swr\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,"
+                    "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"draw\":%" PRIu64 ",\"count\":%u",
+                    separator,
+                    mBuckets[event.bucketId].name.c_str(),
+                    thread.id,
+                    (event.start - mCaptureStartTsc) / ticksPerUs,
+                    (event.end - event.start) / ticksPerUs,
+                    event.drawId,
+                    event.count);
+            if (event.tileX >= 0)
+            {
+                fprintf(f, ",\"tile_x\":%d,\"tile_y\":%d", event.tileX, event.tileY);
+            }
+            fprintf(f, "}}");
+        }
+    }
+    mThreadMutex.unlock();
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+}
+
+void BucketManager::StartCapture(bool trace)
 {
 
     printf("Capture Starting\n");
 
-    mCapturing = true;
+    mTracing         = trace;
+    mCaptureStartTsc = __rdtsc();
+    mCaptureStartTime = std::chrono::steady_clock::now();
+    mCapturing       = true;
 }
 
 void BucketManager_StartBucket(BucketManager* pBucketMgr, uint32_t id)
@@ -33,6 +33,7 @@
 #include <vector>
 #include <mutex>
 #include <sstream>
+#include <chrono>
 
 #include "rdtsc_buckets_shared.h"
 
@@ -90,9 +91,13 @@ public:
     // print report
     void PrintReport(const std::string& filename);
 
+    // write the recorded trace in the Chrome trace event format, which
+    // chrome://tracing and Perfetto can open
+    void PrintTrace(const std::string& filename);
 
     // start capturing
-    void StartCapture();
+    // @param trace - also record each invocation of the threadviz buckets
+    void StartCapture(bool trace = false);
 
     // stop capturing
     INLINE void StopCapture()
@@ -115,12 +120,15 @@ public:
         }
 
         mDoneCapturing = true;
+        mCaptureEndTsc = __rdtsc();
+        mCaptureEndTime = std::chrono::steady_clock::now();
         printf("Capture Stopped\n");
     }
 
     // start a bucket
     // @param id generated by RegisterBucket
-    INLINE void StartBucket(UINT id)
+    // @param drawId - draw the work belongs to, for the trace
+    INLINE void StartBucket(UINT id, uint64_t drawId = 0)
     {
         if (!mCapturing)
             return;
@@ -141,6 +149,13 @@ public:
             child.id      = id;
             child.start   = tsc;
 
+            child.traceEvent = -1;
+            if (mTracing && mBuckets[id].enableThreadViz)
+            {
+                child.traceEvent = (int64_t)bt.trace.size();
+                bt.trace.push_back({id, 0, drawId, tsc, 0, -1, -1});
+            }
+
             // update thread's currently executing bucket
             bt.pCurrent = &child;
         }
@@ -150,7 +165,8 @@ public:
     }
 
     // stop the currently executing bucket
-    INLINE void StopBucket(UINT id)
+    // @param count - amount of work done, for the trace
+    INLINE void StopBucket(UINT id, uint32_t count = 0)
     {
         SWR_ASSERT(tlsThreadId < mThreads.size());
         BUCKET_THREAD& bt = mThreads[tlsThreadId];
@@ -170,6 +186,14 @@ public:
             bt.pCurrent->elapsed += (tsc - bt.pCurrent->start);
             bt.pCurrent->count++;
 
+            if (bt.pCurrent->traceEvent >= 0)
+            {
+                TRACE_EVENT& event = bt.trace[bt.pCurrent->traceEvent];
+                event.end   = tsc;
+                event.count = count;
+                bt.pCurrent->traceEvent = -1;
+            }
+
             // pop to parent
             bt.pCurrent = bt.pCurrent->pParent;
         }
@@ -177,6 +201,23 @@ public:
         bt.level--;
     }
 
+    // tag the currently executing bucket with the macrotile it works on
+    INLINE void SetTraceTile(uint32_t x, uint32_t y)
+    {
+        if (!mCapturing)
+            return;
+
+        SWR_ASSERT(tlsThreadId < mThreads.size());
+        BUCKET_THREAD& bt = mThreads[tlsThreadId];
+
+        if (bt.level > 0 && bt.pCurrent->traceEvent >= 0)
+        {
+            TRACE_EVENT& event = bt.trace[bt.pCurrent->traceEvent];
+            event.tileX = (int32_t)x;
+            event.tileY = (int32_t)y;
+        }
+    }
+
     INLINE void AddEvent(uint32_t id, uint32_t count)
     {
         if (!mCapturing)
@@ -216,6 +257,15 @@ private:
     // has capturing completed
     volatile bool mDoneCapturing{false};
 
+    // are the threadviz buckets traced
+    bool mTracing{false};
+
+    // used to convert the timestamps of the trace
+    uint64_t                              mCaptureStartTsc{0};
+    uint64_t                              mCaptureEndTsc{0};
+    std::chrono::steady_clock::time_point mCaptureStartTime;
+    std::chrono::steady_clock::time_point mCaptureEndTime;
+
     std::mutex mThreadMutex;
 
     std::string mThreadVizDir;
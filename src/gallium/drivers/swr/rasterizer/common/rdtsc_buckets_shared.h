@@ -39,10 +39,25 @@ struct BUCKET
     uint64_t elapsed{0};
     uint32_t count{0};
 
+    // index of the open trace event of this bucket, or -1
+    int64_t traceEvent{-1};
+
     BUCKET*             pParent{nullptr};
     std::vector<BUCKET> children;
 };
 
+// a single bucket invocation, recorded for the trace
+struct TRACE_EVENT
+{
+    uint32_t bucketId;
+    uint32_t count;
+    uint64_t drawId;
+    uint64_t start;
+    uint64_t end;
+    int32_t  tileX;
+    int32_t  tileY;
+};
+
 struct BUCKET_DESC
 {
     // name of bucket, used in reports
@@ -79,6 +94,9 @@ struct BUCKET_THREAD
     // threadviz file object
     FILE* vizFile{nullptr};
 
+    // invocations of the threadviz buckets, when tracing
+    std::vector<TRACE_EVENT> trace;
+
 
     BUCKET_THREAD() {}
     BUCKET_THREAD(const BUCKET_THREAD& that)
@@ -88,6 +106,7 @@ struct BUCKET_THREAD
         root     = that.root;
         pCurrent = &root;
         vizFile  = that.vizFile;
+        trace    = that.trace;
     }
 };
 
@@ -228,9 +228,69 @@ HANDLE SwrCreateContext(SWR_CREATECONTEXT_INFO* pCreateInfo)
     return (HANDLE)pContext;
 }
 
-void CopyState(DRAW_STATE& dst, const DRAW_STATE& src)
+//////////////////////////////////////////////////////////////////////////
+/// @brief Splits API_STATE into ranges, in member order. Each range ends where
+///        the next one starts, the last one at the end of API_STATE.
+struct API_STATE_RANGE
+{
+    uint32_t          offset;
+    API_STATE_SECTION section;
+};
+
+static const API_STATE_RANGE gApiStateRanges[] = {
+    {offsetof(API_STATE, vertexBuffers), API_STATE_VERTEX_BUFFERS},
+    {offsetof(API_STATE, gsState), API_STATE_VERTEX_PIPE},
+    {offsetof(API_STATE, pfnCsFunc), API_STATE_COMPUTE},
+    {offsetof(API_STATE, frontendState), API_STATE_FRONTEND},
+    {offsetof(API_STATE, pfnSoFunc), API_STATE_STREAMOUT},
+    {offsetof(API_STATE, soBuffer), API_STATE_ALWAYS},
+    {offsetof(API_STATE, pfnHsFunc), API_STATE_TESSELLATION},
+    {offsetof(API_STATE, feNumAttributes), API_STATE_ALWAYS},
+    {offsetof(API_STATE, rastState), API_STATE_RASTERIZER},
+    {offsetof(API_STATE, samplePos), API_STATE_ALWAYS},
+    {offsetof(API_STATE, vp), API_STATE_VIEWPORTS},
+    {offsetof(API_STATE, scissorRects), API_STATE_SCISSORS},
+    {offsetof(API_STATE, scissorsInFixedPoint), API_STATE_ALWAYS},
+    {offsetof(API_STATE, backendState), API_STATE_BACKEND},
+    {offsetof(API_STATE, depthBoundsState), API_STATE_DEPTH_BOUNDS},
+    {offsetof(API_STATE, psState), API_STATE_PIXEL_SHADER},
+    {offsetof(API_STATE, depthStencilState), API_STATE_DEPTH_STENCIL},
+    {offsetof(API_STATE, blendState), API_STATE_BLEND},
+    {offsetof(API_STATE, pfnBlendFunc) + sizeof(API_STATE::pfnBlendFunc), API_STATE_ALWAYS},
+};
+
+static_assert(offsetof(API_STATE, vertexBuffers) == 0, "API_STATE ranges must start at 0");
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Copies the previous draw state to a new one. Sections the new draw
+///        state already holds the same version of are skipped.
+/// @return Number of bytes copied.
+uint32_t CopyState(DRAW_STATE& dst, const DRAW_STATE& src)
 {
-    memcpy((void*)&dst.state, (void*)&src.state, sizeof(API_STATE));
+    const uint32_t numRanges = sizeof(gApiStateRanges) / sizeof(gApiStateRanges[0]);
+    uint32_t       numBytes  = 0;
+
+    for (uint32_t i = 0; i < numRanges; ++i)
+    {
+        API_STATE_SECTION section = gApiStateRanges[i].section;
+        if (section != API_STATE_ALWAYS)
+        {
+            if (dst.sectionVersion[section] == src.sectionVersion[section])
+            {
+                continue;
+            }
+            dst.sectionVersion[section] = src.sectionVersion[section];
+        }
+
+        uint32_t offset = gApiStateRanges[i].offset;
+        uint32_t end =
+            (i + 1 < numRanges) ? gApiStateRanges[i + 1].offset : (uint32_t)sizeof(API_STATE);
+
+        memcpy((uint8_t*)&dst.state + offset, (const uint8_t*)&src.state + offset, end - offset);
+        numBytes += end - offset;
+    }
+
+    return numBytes;
 }
 
 template <bool IsDraw>
@@ -344,6 +404,7 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT* pContext, bool isSplitDraw = false)
         pCurDrawContext->pState = &pContext->dsRing[dsIndex];
 
         // Copy previous state to current state.
+        uint32_t stateCopyBytes = 0;
         if (pContext->pPrevDrawContext)
         {
             DRAW_CONTEXT* pPrevDrawContext = pContext->pPrevDrawContext;
@@ -353,7 +414,7 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT* pContext, bool isSplitDraw = false)
             // draw can receive the state.
             if (isSplitDraw == false)
             {
-                CopyState(*pCurDrawContext->pState, *pPrevDrawContext->pState);
+                stateCopyBytes = CopyState(*pCurDrawContext->pState, *pPrevDrawContext->pState);
 
                 // Should have been cleaned up previously
                 SWR_ASSERT(pCurDrawContext->pState->pArena->IsEmpty() == true);
@@ -391,6 +452,7 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT* pContext, bool isSplitDraw = false)
         pCurDrawContext->retireCallback.pfnCallbackFunc = nullptr;
 
         pCurDrawContext->dynState.Reset(pContext->NumWorkerThreads);
+        pCurDrawContext->dynState.statsFE.StateCopyBytes = stateCopyBytes;
 
         // Assign unique drawId for this DC
         pCurDrawContext->drawId = pContext->dcRing.GetHead();
@@ -406,11 +468,27 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT* pContext, bool isSplitDraw = false)
     return pContext->pCurDrawContext;
 }
 
-API_STATE* GetDrawState(SWR_CONTEXT* pContext)
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the API state of the current draw.
+/// @param dirtySections - Mask of the API_STATE_SECTIONs the caller is going to
+///        write, which get a new version.
+API_STATE* GetDrawState(SWR_CONTEXT* pContext, uint32_t dirtySections)
 {
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
     SWR_ASSERT(pDC->pState != nullptr);
 
+    if (dirtySections)
+    {
+        uint64_t version = ++pContext->stateVersion;
+        for (uint32_t i = 0; i < API_STATE_NUM_SECTIONS; ++i)
+        {
+            if (dirtySections & (1 << i))
+            {
+                pDC->pState->sectionVersion[i] = version;
+            }
+        }
+    }
+
     return &pDC->pState->state;
 }
 
@@ -477,7 +555,7 @@ void SwrBindApiThread(HANDLE hContext, uint32_t apiThreadId)
 void SWR_API SwrSaveState(HANDLE hContext, void* pOutputStateBlock, size_t memSize)
 {
     SWR_CONTEXT* pContext = GetContext(hContext);
-    auto         pSrc     = GetDrawState(pContext);
+    auto         pSrc     = GetDrawState(pContext, 0);
     assert(pOutputStateBlock && memSize >= sizeof(*pSrc));
 
     memcpy(pOutputStateBlock, pSrc, sizeof(*pSrc));
@@ -486,7 +564,7 @@ void SWR_API SwrSaveState(HANDLE hContext, void* pOutputStateBlock, size_t memSi
 void SWR_API SwrRestoreState(HANDLE hContext, const void* pStateBlock, size_t memSize)
 {
     SWR_CONTEXT* pContext = GetContext(hContext);
-    auto         pDst     = GetDrawState(pContext);
+    auto         pDst     = GetDrawState(pContext, API_STATE_ALL_SECTIONS);
     assert(pStateBlock && memSize >= sizeof(*pDst));
 
     memcpy((void*)pDst, (void*)pStateBlock, sizeof(*pDst));
@@ -494,7 +572,8 @@ void SWR_API SwrRestoreState(HANDLE hContext, const void* pStateBlock, size_t me
 
 void SetupDefaultState(SWR_CONTEXT* pContext)
 {
-    API_STATE* pState = GetDrawState(pContext);
+    API_STATE* pState =
+        GetDrawState(pContext, (1 << API_STATE_RASTERIZER) | (1 << API_STATE_DEPTH_BOUNDS));
 
     pState->rastState.cullMode     = SWR_CULLMODE_NONE;
     pState->rastState.frontWinding = SWR_FRONTWINDING_CCW;
@@ -574,7 +653,7 @@ void SwrSetVertexBuffers(HANDLE                         hContext,
                          uint32_t                       numBuffers,
                          const SWR_VERTEX_BUFFER_STATE* pVertexBuffers)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_VERTEX_BUFFERS);
 
     for (uint32_t i = 0; i < numBuffers; ++i)
     {
@@ -585,21 +664,21 @@ void SwrSetVertexBuffers(HANDLE                         hContext,
 
 void SwrSetIndexBuffer(HANDLE hContext, const SWR_INDEX_BUFFER_STATE* pIndexBuffer)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_VERTEX_PIPE);
 
     pState->indexBuffer = *pIndexBuffer;
 }
 
 void SwrSetFetchFunc(HANDLE hContext, PFN_FETCH_FUNC pfnFetchFunc)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_VERTEX_PIPE);
 
     pState->pfnFetchFunc = pfnFetchFunc;
 }
 
 void SwrSetSoFunc(HANDLE hContext, PFN_SO_FUNC pfnSoFunc, uint32_t streamIndex)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_STREAMOUT);
 
     SWR_ASSERT(streamIndex < MAX_SO_STREAMS);
 
@@ -608,14 +687,14 @@ void SwrSetSoFunc(HANDLE hContext, PFN_SO_FUNC pfnSoFunc, uint32_t streamIndex)
 
 void SwrSetSoState(HANDLE hContext, SWR_STREAMOUT_STATE* pSoState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_STREAMOUT);
 
     pState->soState = *pSoState;
 }
 
 void SwrSetSoBuffers(HANDLE hContext, SWR_STREAMOUT_BUFFER* pSoBuffer, uint32_t slot)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 0);
 
     SWR_ASSERT((slot < MAX_SO_STREAMS), "There are only 4 SO buffer slots [0, 3]\nSlot requested: %d", slot);
 
@@ -632,26 +711,26 @@ void SwrSetSoBuffers(HANDLE hContext, SWR_STREAMOUT_BUFFER* pSoBuffer, uint32_t
 
 void SwrSetVertexFunc(HANDLE hContext, PFN_VERTEX_FUNC pfnVertexFunc)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_VERTEX_PIPE);
 
     pState->pfnVertexFunc = pfnVertexFunc;
 }
 
 void SwrSetFrontendState(HANDLE hContext, SWR_FRONTEND_STATE* pFEState)
 {
-    API_STATE* pState     = GetDrawState(GetContext(hContext));
+    API_STATE* pState     = GetDrawState(GetContext(hContext), 1 << API_STATE_FRONTEND);
     pState->frontendState = *pFEState;
 }
 
 void SwrSetGsState(HANDLE hContext, SWR_GS_STATE* pGSState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_VERTEX_PIPE);
     pState->gsState   = *pGSState;
 }
 
 void SwrSetGsFunc(HANDLE hContext, PFN_GS_FUNC pfnGsFunc)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_VERTEX_PIPE);
     pState->pfnGsFunc = pfnGsFunc;
 }
 
@@ -662,7 +741,8 @@ void SwrSetCsFunc(HANDLE      hContext,
                   uint32_t    scratchSpaceSizePerWarp,
                   uint32_t    numWarps)
 {
-    API_STATE* pState               = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_COMPUTE);
+
     pState->pfnCsFunc               = pfnCsFunc;
     pState->totalThreadsInGroup     = totalThreadsInGroup;
     pState->totalSpillFillSize      = totalSpillFillSize;
@@ -672,59 +752,60 @@ void SwrSetCsFunc(HANDLE      hContext,
 
 void SwrSetTsState(HANDLE hContext, SWR_TS_STATE* pState)
 {
-    API_STATE* pApiState = GetDrawState(GetContext(hContext));
+    API_STATE* pApiState = GetDrawState(GetContext(hContext), 1 << API_STATE_TESSELLATION);
     pApiState->tsState   = *pState;
 }
 
 void SwrSetHsFunc(HANDLE hContext, PFN_HS_FUNC pfnFunc)
 {
-    API_STATE* pApiState = GetDrawState(GetContext(hContext));
+    API_STATE* pApiState = GetDrawState(GetContext(hContext), 1 << API_STATE_TESSELLATION);
     pApiState->pfnHsFunc = pfnFunc;
 }
 
 void SwrSetDsFunc(HANDLE hContext, PFN_DS_FUNC pfnFunc)
 {
-    API_STATE* pApiState = GetDrawState(GetContext(hContext));
+    API_STATE* pApiState = GetDrawState(GetContext(hContext), 1 << API_STATE_TESSELLATION);
     pApiState->pfnDsFunc = pfnFunc;
 }
 
 void SwrSetDepthStencilState(HANDLE hContext, SWR_DEPTH_STENCIL_STATE* pDSState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_DEPTH_STENCIL);
 
     pState->depthStencilState = *pDSState;
 }
 
 void SwrSetBackendState(HANDLE hContext, SWR_BACKEND_STATE* pBEState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_BACKEND);
 
     pState->backendState = *pBEState;
 }
 
 void SwrSetDepthBoundsState(HANDLE hContext, SWR_DEPTH_BOUNDS_STATE* pDBState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_DEPTH_BOUNDS);
 
     pState->depthBoundsState = *pDBState;
 }
 
 void SwrSetPixelShaderState(HANDLE hContext, SWR_PS_STATE* pPSState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_PIXEL_SHADER);
     pState->psState   = *pPSState;
 }
 
 void SwrSetBlendState(HANDLE hContext, SWR_BLEND_STATE* pBlendState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_BLEND);
     memcpy(&pState->blendState, pBlendState, sizeof(SWR_BLEND_STATE));
 }
 
 void SwrSetBlendFunc(HANDLE hContext, uint32_t renderTarget, PFN_BLEND_JIT_FUNC pfnBlendFunc)
 {
     SWR_ASSERT(renderTarget < SWR_NUM_RENDERTARGETS);
-    API_STATE* pState                  = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_BLEND);
+
     pState->pfnBlendFunc[renderTarget] = pfnBlendFunc;
 }
 
@@ -746,7 +827,7 @@ void updateGuardbands(API_STATE* pState)
 void SwrSetRastState(HANDLE hContext, const SWR_RASTSTATE* pRastState)
 {
     SWR_CONTEXT* pContext = GetContext(hContext);
-    API_STATE*   pState   = GetDrawState(pContext);
+    API_STATE*   pState   = GetDrawState(pContext, 1 << API_STATE_RASTERIZER);
 
     memcpy((void*)&pState->rastState, (void*)pRastState, sizeof(SWR_RASTSTATE));
 }
@@ -759,7 +840,7 @@ void SwrSetViewports(HANDLE                       hContext,
     SWR_ASSERT(numViewports <= KNOB_NUM_VIEWPORTS_SCISSORS, "Invalid number of viewports.");
 
     SWR_CONTEXT* pContext = GetContext(hContext);
-    API_STATE*   pState   = GetDrawState(pContext);
+    API_STATE*   pState   = GetDrawState(pContext, 1 << API_STATE_VIEWPORTS);
 
     memcpy(&pState->vp[0], pViewports, sizeof(SWR_VIEWPORT) * numViewports);
     // @todo Faster to copy portions of the SOA or just copy all of it?
@@ -770,7 +851,7 @@ void SwrSetScissorRects(HANDLE hContext, uint32_t numScissors, const SWR_RECT* p
 {
     SWR_ASSERT(numScissors <= KNOB_NUM_VIEWPORTS_SCISSORS, "Invalid number of scissor rects.");
 
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    API_STATE* pState = GetDrawState(GetContext(hContext), 1 << API_STATE_SCISSORS);
     memcpy(&pState->scissorRects[0], pScissors, numScissors * sizeof(pScissors[0]));
 };
 
@@ -1127,6 +1208,12 @@ uint32_t MaxVertsPerDraw(DRAW_CONTEXT* pDC, uint32_t totalVerts, PRIMITIVE_TOPOL
         vertsPerDraw = KNOB_MAX_PRIMS_PER_DRAW;
         break;
 
+    case TOP_LINE_LIST:
+        // Lines of a list are independent like points and triangles, only make sure no line
+        // gets split between two draws.
+        vertsPerDraw = KNOB_MAX_PRIMS_PER_DRAW & ~1U;
+        break;
+
     case TOP_PATCHLIST_1:
     case TOP_PATCHLIST_2:
     case TOP_PATCHLIST_3:
@@ -66,6 +66,17 @@ public:
             AlignedFree(pMem);
         }
     }
+
+    // Frees a list of blocks linked through pNext
+    void FreeList(ArenaBlock* pList)
+    {
+        while (pList)
+        {
+            ArenaBlock* pNext = pList->pNext;
+            Free(pList);
+            pList = pNext;
+        }
+    }
 };
 
 // Caching Allocator for Arena
@@ -114,9 +125,11 @@ struct CachingAllocatorT : DefaultAllocator
                 pPrevBlock->pNext = pBlock->pNext;
                 pBlock->pNext     = nullptr;
 
+                m_numHits++;
                 return pBlock;
             }
 
+            m_numMisses++;
             m_totalAllocated += size;
 
 #if 0
@@ -147,6 +160,34 @@ struct CachingAllocatorT : DefaultAllocator
         }
     }
 
+    // Caches a list of blocks linked through pNext, taking the lock once
+    void FreeList(ArenaBlock* pList)
+    {
+        if (!pList)
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> l(m_mutex);
+        while (pList)
+        {
+            ArenaBlock* pNext = pList->pNext;
+            pList->pNext      = nullptr;
+            InsertCachedBlock(GetBucketId(pList->blockSize), pList);
+            pList = pNext;
+        }
+    }
+
+    // Number of blocks allocated from the cache and from the system, and
+    // the size of the cached blocks
+    void GetStats(uint64_t& numHits, uint64_t& numMisses, uint64_t& cachedSize)
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        numHits    = m_numHits;
+        numMisses  = m_numMisses;
+        cachedSize = m_cachedSize + m_oldCachedSize;
+    }
+
     void FreeOldBlocks()
     {
         if (!m_cachedSize)
@@ -364,6 +405,9 @@ private:
 
     size_t m_cachedSize    = 0;
     size_t m_oldCachedSize = 0;
+
+    uint64_t m_numHits   = 0;
+    uint64_t m_numMisses = 0;
 };
 typedef CachingAllocatorT<> CachingAllocator;
 
@@ -445,6 +489,13 @@ public:
         return pAlloc;
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Frees all allocations.
+    /// @param removeAll - Also return the last block to the allocator.
+    ///        Otherwise the arena keeps it for the next allocations, unless
+    ///        it is larger than the default block size, so that an arena
+    ///        which is reset and reused for each draw normally doesn't
+    ///        have to go through the allocator at all.
     void Reset(bool removeAll = false)
     {
         m_offset = ARENA_BLOCK_ALIGN;
@@ -453,19 +504,15 @@ public:
         {
             ArenaBlock* pUsedBlocks = m_pCurBlock->pNext;
             m_pCurBlock->pNext      = nullptr;
-            while (pUsedBlocks)
-            {
-                ArenaBlock* pBlock = pUsedBlocks;
-                pUsedBlocks        = pBlock->pNext;
 
-                m_allocator.Free(pBlock);
-            }
-
-            if (removeAll)
+            if (removeAll || m_pCurBlock->blockSize > BlockSizeT)
             {
-                m_allocator.Free(m_pCurBlock);
-                m_pCurBlock = nullptr;
+                m_pCurBlock->pNext = pUsedBlocks;
+                pUsedBlocks        = m_pCurBlock;
+                m_pCurBlock        = nullptr;
             }
+
+            m_allocator.FreeList(pUsedBlocks);
         }
     }
 
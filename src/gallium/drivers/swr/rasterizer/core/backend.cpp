@@ -169,8 +169,9 @@ void ProcessStoreTileBE(DRAW_CONTEXT*               pDC,
                           pDesc->rect);
         }
 
-        if (pHotTile->state == HOTTILE_DIRTY ||
-            pDesc->postStoreTileState == (SWR_TILE_STATE)HOTTILE_DIRTY)
+        // tiles that were only cleared have no memory and nothing else to store
+        if (pHotTile->pBuffer && (pHotTile->state == HOTTILE_DIRTY ||
+                                  pDesc->postStoreTileState == (SWR_TILE_STATE)HOTTILE_DIRTY))
         {
             int32_t destX = KNOB_MACROTILE_X_DIM * x;
             int32_t destY = KNOB_MACROTILE_Y_DIM * y;
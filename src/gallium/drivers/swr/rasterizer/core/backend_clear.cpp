@@ -152,7 +152,23 @@ INLINE void ClearMacroTile(DRAW_CONTEXT*               pDC,
         pRasterTileRow += macroTileRowStep;
     }
 
-    pHotTile->state = HOTTILE_DIRTY;
+    pHotTile->state        = HOTTILE_DIRTY;
+    pHotTile->hiZValidMask = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if the clear rect covers the whole macrotile. Only those
+///        can be deferred by just recording the clear value, a partially
+///        covered macrotile keeps its contents outside of the rect.
+static INLINE bool IsMacroTileCovered(uint32_t macroTile, const SWR_RECT& rect)
+{
+    uint32_t tileX, tileY;
+    MacroTileMgr::getTileIndices(macroTile, tileX, tileY);
+
+    return rect.xmin <= int32_t(tileX * KNOB_MACROTILE_X_DIM) &&
+           rect.ymin <= int32_t(tileY * KNOB_MACROTILE_Y_DIM) &&
+           rect.xmax >= int32_t((tileX + 1) * KNOB_MACROTILE_X_DIM) &&
+           rect.ymax >= int32_t((tileY + 1) * KNOB_MACROTILE_Y_DIM);
 }
 
 void ProcessClearBE(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile, void* pUserData)
@@ -160,7 +176,7 @@ void ProcessClearBE(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile, vo
     SWR_CONTEXT* pContext           = pDC->pContext;
     HANDLE       hWorkerPrivateData = pContext->threadPool.pThreadData[workerId].pWorkerPrivateData;
 
-    if (KNOB_FAST_CLEAR)
+    if (KNOB_FAST_CLEAR && IsMacroTileCovered(macroTile, ((CLEAR_DESC*)pUserData)->rect))
     {
         CLEAR_DESC*           pClear      = (CLEAR_DESC*)pUserData;
         SWR_MULTISAMPLE_COUNT sampleCount = pDC->pState->state.rastState.sampleCount;
@@ -179,14 +195,13 @@ void ProcessClearBE(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile, vo
                 mask &= ~(1 << rt);
 
                 HOTTILE* pHotTile =
-                    pContext->pHotTileMgr->GetHotTile(pContext,
-                                                      pDC,
-                                                      hWorkerPrivateData,
-                                                      macroTile,
-                                                      (SWR_RENDERTARGET_ATTACHMENT)rt,
-                                                      true,
-                                                      numSamples,
-                                                      pClear->renderTargetArrayIndex);
+                    pContext->pHotTileMgr->GetHotTileForClear(pContext,
+                                                              pDC,
+                                                              hWorkerPrivateData,
+                                                              macroTile,
+                                                              (SWR_RENDERTARGET_ATTACHMENT)rt,
+                                                              numSamples,
+                                                              pClear->renderTargetArrayIndex);
 
                 // All we want to do here is to mark the hot tile as being in a "needs clear" state.
                 pHotTile->clearData[0] = *(uint32_t*)&(pClear->clearRTColor[0]);
@@ -199,28 +214,28 @@ void ProcessClearBE(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile, vo
 
         if (pClear->attachmentMask & SWR_ATTACHMENT_DEPTH_BIT)
         {
-            HOTTILE* pHotTile      = pContext->pHotTileMgr->GetHotTile(pContext,
-                                                                  pDC,
-                                                                  hWorkerPrivateData,
-                                                                  macroTile,
-                                                                  SWR_ATTACHMENT_DEPTH,
-                                                                  true,
-                                                                  numSamples,
-                                                                  pClear->renderTargetArrayIndex);
+            HOTTILE* pHotTile =
+                pContext->pHotTileMgr->GetHotTileForClear(pContext,
+                                                          pDC,
+                                                          hWorkerPrivateData,
+                                                          macroTile,
+                                                          SWR_ATTACHMENT_DEPTH,
+                                                          numSamples,
+                                                          pClear->renderTargetArrayIndex);
             pHotTile->clearData[0] = *(uint32_t*)&pClear->clearDepth;
             pHotTile->state        = HOTTILE_CLEAR;
         }
 
         if (pClear->attachmentMask & SWR_ATTACHMENT_STENCIL_BIT)
         {
-            HOTTILE* pHotTile = pContext->pHotTileMgr->GetHotTile(pContext,
-                                                                  pDC,
-                                                                  hWorkerPrivateData,
-                                                                  macroTile,
-                                                                  SWR_ATTACHMENT_STENCIL,
-                                                                  true,
-                                                                  numSamples,
-                                                                  pClear->renderTargetArrayIndex);
+            HOTTILE* pHotTile =
+                pContext->pHotTileMgr->GetHotTileForClear(pContext,
+                                                          pDC,
+                                                          hWorkerPrivateData,
+                                                          macroTile,
+                                                          SWR_ATTACHMENT_STENCIL,
+                                                          numSamples,
+                                                          pClear->renderTargetArrayIndex);
 
             pHotTile->clearData[0] = pClear->clearStencil;
             pHotTile->state        = HOTTILE_CLEAR;
@@ -230,7 +245,7 @@ void ProcessClearBE(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile, vo
     }
     else
     {
-        // Legacy clear
+        // Legacy clear, also used for the macrotiles only partially covered by the clear rect
         CLEAR_DESC* pClear = (CLEAR_DESC*)pUserData;
         RDTSC_BEGIN(pDC->pContext->pBucketMgr, BEClear, pDC->drawId);
 
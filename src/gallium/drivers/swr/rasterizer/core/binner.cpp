@@ -674,6 +674,7 @@ void SIMDCALL BinTrianglesImpl(DRAW_CONTEXT*          pDC,
                                Integer<SIMD_T> const& rtIdx)
 {
     const uint32_t* aRTAI = reinterpret_cast<const uint32_t*>(&rtIdx);
+    const uint32_t  inputTriMask = triMask;
 
     RDTSC_BEGIN(pDC->pContext->pBucketMgr, FEBinTriangles, pDC->drawId);
 
@@ -1030,6 +1031,7 @@ void SIMDCALL BinTrianglesImpl(DRAW_CONTEXT*          pDC,
 
             if (!triMask)
             {
+                UPDATE_STAT_FE(BinTrivialRejects, _mm_popcnt_u32(inputTriMask));
                 RDTSC_END(pDC->pContext->pBucketMgr, FEBinTriangles, 1);
                 return;
             }
@@ -1039,6 +1041,7 @@ void SIMDCALL BinTrianglesImpl(DRAW_CONTEXT*          pDC,
 
 endBinTriangles:
 
+    UPDATE_STAT_FE(BinTrivialRejects, _mm_popcnt_u32(inputTriMask & ~triMask));
 
     if (!triMask)
     {
@@ -1121,14 +1124,45 @@ endBinTriangles:
     TransposeVertices(vHorizZ, tri[0].z, tri[1].z, tri[2].z);
     TransposeVertices(vHorizW, vRecipW0, vRecipW1, vRecipW2);
 
+    // Small triangles often all land in the same macrotile. Their work items are
+    // then collected and queued with a single enqueue.
+    uint32_t singleTileMask =
+        triMask & SIMD_T::movemask_ps(SIMD_T::castsi_ps(
+                      SIMD_T::and_si(SIMD_T::cmpeq_epi32(bbox.xmin, bbox.xmax),
+                                     SIMD_T::cmpeq_epi32(bbox.ymin, bbox.ymax))));
+
+    UPDATE_STAT_FE(BinSingleTileTris, _mm_popcnt_u32(singleTileMask));
+    UPDATE_STAT_FE(BinMultiTileTris, _mm_popcnt_u32(triMask & ~singleTileMask));
+
+    bool     bSameTile = false;
+    uint32_t tileX     = 0;
+    uint32_t tileY     = 0;
+    if (singleTileMask == triMask)
+    {
+        uint32_t firstTri;
+        _BitScanForward((unsigned long*)&firstTri, triMask);
+        tileX = aMTLeft[firstTri];
+        tileY = aMTTop[firstTri];
+
+        Integer<SIMD_T> vSameTile =
+            SIMD_T::and_si(SIMD_T::cmpeq_epi32(bbox.xmin, SIMD_T::set1_epi32(tileX)),
+                           SIMD_T::cmpeq_epi32(bbox.ymin, SIMD_T::set1_epi32(tileY)));
+
+        bSameTile = (triMask & ~SIMD_T::movemask_ps(SIMD_T::castsi_ps(vSameTile))) == 0;
+    }
+
+    BE_WORK  aTileWork[SIMD_WIDTH];
+    uint32_t numTileWork = 0;
+
     // scan remaining valid triangles and bin each separately
     while (_BitScanForward((unsigned long*)&triIndex, triMask))
     {
         uint32_t linkageCount     = state.backendState.numAttributes;
         uint32_t numScalarAttribs = linkageCount * 4;
 
-        BE_WORK work;
-        work.type = DRAW;
+        BE_WORK  localWork;
+        BE_WORK& work = bSameTile ? aTileWork[numTileWork++] : localWork;
+        work.type     = DRAW;
 
         bool isDegenerate;
         if (CT::IsConservativeT::value)
@@ -1191,6 +1225,13 @@ endBinTriangles:
                 state.backendState, pa, triIndex, &desc.pTriBuffer[12], desc.pUserClipBuffer);
         }
 
+        triMask &= ~(1 << triIndex);
+
+        if (bSameTile)
+        {
+            continue;
+        }
+
         for (uint32_t y = aMTTop[triIndex]; y <= aMTBottom[triIndex]; ++y)
         {
             for (uint32_t x = aMTLeft[triIndex]; x <= aMTRight[triIndex]; ++x)
@@ -1203,8 +1244,16 @@ endBinTriangles:
                 }
             }
         }
+    }
 
-        triMask &= ~(1 << triIndex);
+    if (numTileWork)
+    {
+#if KNOB_ENABLE_TOSS_POINTS
+        if (!KNOB_TOSS_SETUP_TRIS)
+#endif
+        {
+            pTileMgr->enqueue(tileX, tileY, aTileWork, numTileWork);
+        }
     }
 
     RDTSC_END(pDC->pContext->pBucketMgr, FEBinTriangles, 1);
@@ -392,10 +392,42 @@ struct BACKEND_FUNCS
 };
 
 // Draw State
+//////////////////////////////////////////////////////////////////////////
+/// @brief Groups of API_STATE members that are set by the same API calls.
+///        Each DRAW_STATE records the version of every section it holds, so
+///        a new draw state only copies the sections that changed since its
+///        ring entry was last used. Members that the core derives per draw or
+///        that the workers update are not part of a section and always copied.
+enum API_STATE_SECTION
+{
+    API_STATE_VERTEX_BUFFERS, // vertexBuffers
+    API_STATE_VERTEX_PIPE,    // gsState through indexBuffer
+    API_STATE_COMPUTE,        // pfnCsFunc through scratchSpaceNumWarps
+    API_STATE_FRONTEND,       // frontendState
+    API_STATE_STREAMOUT,      // pfnSoFunc, soState
+    API_STATE_TESSELLATION,   // pfnHsFunc, pfnDsFunc, tsState
+    API_STATE_RASTERIZER,     // rastState
+    API_STATE_VIEWPORTS,      // vp, vpMatrices
+    API_STATE_SCISSORS,       // scissorRects
+    API_STATE_BACKEND,        // backendState
+    API_STATE_DEPTH_BOUNDS,   // depthBoundsState
+    API_STATE_PIXEL_SHADER,   // psState
+    API_STATE_DEPTH_STENCIL,  // depthStencilState
+    API_STATE_BLEND,          // blendState, pfnBlendFunc
+
+    API_STATE_NUM_SECTIONS,
+    API_STATE_ALWAYS = API_STATE_NUM_SECTIONS
+};
+
+#define API_STATE_ALL_SECTIONS ((1 << API_STATE_NUM_SECTIONS) - 1)
+
 struct DRAW_STATE
 {
     API_STATE state;
 
+    // Version of each API_STATE_SECTION in state, unique per API call that set it.
+    uint64_t sectionVersion[API_STATE_NUM_SECTIONS];
+
     void* pPrivateState; // Its required the driver sets this up for each draw.
 
     // pipeline function pointers, filled in by API thread when setting up the draw
@@ -512,6 +544,7 @@ struct SWR_CONTEXT
     RingBuffer<DRAW_STATE> dsRing;
 
     uint32_t curStateId; // Current index to the next available entry in the DS ring.
+    uint64_t stateVersion; // Last version assigned to an API_STATE_SECTION.
 
     uint32_t NumWorkerThreads;
     uint32_t NumFEThreads;
@@ -585,7 +618,7 @@ struct SWR_CONTEXT
 #define AR_API_CTX pDC->pContext->pArContext[pContext->NumWorkerThreads]
 
 #ifdef KNOB_ENABLE_RDTSC
-#define RDTSC_BEGIN(pBucketMgr, type, drawid) RDTSC_START(pBucketMgr, type)
+#define RDTSC_BEGIN(pBucketMgr, type, drawid) RDTSC_START_DRAW(pBucketMgr, type, drawid)
 #define RDTSC_END(pBucketMgr, type, count) RDTSC_STOP(pBucketMgr, type, count, 0)
 #else
 #define RDTSC_BEGIN(pBucketMgr, type, drawid)
@@ -315,6 +315,12 @@ void RasterizeSimplePoint(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTi
     RDTSC_BEGIN(pDC->pContext->pBucketMgr, BEPixelBackend, pDC->drawId);
     backendFuncs.pfnBackend(pDC, workerId, tileAlignedX, tileAlignedY, triDesc, renderBuffers);
     RDTSC_END(pDC->pContext->pBucketMgr, BEPixelBackend, 0);
+
+    // points don't keep the hierarchical Z of the tile up to date
+    if (GetApiState(pDC).depthHottileEnable)
+    {
+        renderBuffers.pDepthHotTile->hiZValidMask = 0;
+    }
 }
 
 void RasterizeTriPoint(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile, void* pData)
@@ -535,6 +535,59 @@ ComputeDepthBias(const SWR_RASTSTATE* pState, const SWR_TRIANGLE_DESC* pTri, con
     return bias;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the largest depth value of a single sampled raster tile
+INLINE float ComputeRasterTileMaxZ(const uint8_t* pDepthBuffer)
+{
+    static_assert(KNOB_DEPTH_HOT_TILE_FORMAT == R32_FLOAT, "Unsupported depth hot tile format");
+
+    const float* pZ   = reinterpret_cast<const float*>(pDepthBuffer);
+    simdscalar   vMax = _simd_load_ps(pZ);
+    for (uint32_t i = KNOB_SIMD_WIDTH; i < KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM; i += KNOB_SIMD_WIDTH)
+    {
+        vMax = _simd_max_ps(vMax, _simd_load_ps(pZ + i));
+    }
+
+    OSALIGNSIMD(float) aMax[KNOB_SIMD_WIDTH];
+    _simd_store_ps(aMax, vMax);
+
+    float maxZ = aMax[0];
+    for (uint32_t i = 1; i < KNOB_SIMD_WIDTH; ++i)
+    {
+        maxZ = std::max(maxZ, aMax[i]);
+    }
+    return maxZ;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Hierarchical Z can reject raster tiles with a less or less equal
+///        depth test, if nothing but depth depends on the pixels that fail
+///        the test.
+INLINE bool CanUseHiZ(const API_STATE& state)
+{
+    const SWR_DEPTH_STENCIL_STATE& dsState = state.depthStencilState;
+
+    return state.depthHottileEnable && dsState.depthTestEnable && !dsState.stencilTestEnable &&
+           (dsState.depthTestFunc == ZFUNC_LT || dsState.depthTestFunc == ZFUNC_LE) &&
+           !state.psState.writesODepth && !state.psState.usesUAV;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the smallest depth the backend can compute for a pixel of
+///        the triangle, after quantization and viewport clamping
+/// @param minZ - smallest vertex depth, including the depth bias
+INLINE float ComputeHiZTriangleMinZ(const API_STATE& state, uint32_t viewportIndex, float minZ)
+{
+    // back off for the rounding of the depth plane interpolation
+    minZ -= (1.0f + fabsf(minZ)) * (1.0f / (1 << 20));
+
+    OSALIGNSIMD(float) aZ[KNOB_SIMD_WIDTH];
+    _simd_store_ps(aZ, state.pfnQuantizeDepth(_simd_set1_ps(minZ)));
+
+    const SWR_VIEWPORT& vp = state.vp[viewportIndex];
+    return std::min(vp.maxZ, std::max(vp.minZ, aZ[0]));
+}
+
 // Prevent DCE by writing coverage mask from rasterizer to volatile
 #if KNOB_ENABLE_TOSS_POINTS
 __declspec(thread) volatile uint64_t gToss;
@@ -1055,7 +1108,22 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
     triDesc.Z[2] = a[2];
 
     // add depth bias
-    triDesc.Z[2] += ComputeDepthBias(&rastState, &triDesc, workDesc.pTriBuffer + 8);
+    float depthBias = ComputeDepthBias(&rastState, &triDesc, workDesc.pTriBuffer + 8);
+    triDesc.Z[2] += depthBias;
+
+    // Hierarchical Z. A raster tile whose farthest depth is in front of the nearest
+    // pixel of the triangle fails the depth test everywhere and can be skipped.
+    const bool bHiZ = (RT::MT::numSamples == 1) && !RT::IsConservativeT::value && CanUseHiZ(state);
+    const bool bUpdateHiZ = (RT::MT::numSamples == 1) && state.depthHottileEnable &&
+                            state.depthStencilState.depthWriteEnable;
+    const bool bHiZStrict = state.depthStencilState.depthTestFunc == ZFUNC_LE;
+    float      hiZMinZ    = 0.0f;
+    if (bHiZ)
+    {
+        hiZMinZ = ComputeHiZTriangleMinZ(state,
+                                         workDesc.triFlags.viewportIndex,
+                                         std::min(std::min(a[0], a[1]), a[2]) + depthBias);
+    }
 
     // Calc bounding box of triangle
     OSALIGNSIMD(SWR_RECT) bbox;
@@ -1249,6 +1317,11 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
                                           triDesc.triFlags.renderTargetArrayIndex);
     currentRenderBufferRow = renderBuffers;
 
+    HOTTILE* pDepthHotTile = renderBuffers.pDepthHotTile;
+    float*   pHiZ          = (bHiZ || bUpdateHiZ)
+                          ? pDC->pContext->pHotTileMgr->GetHiZ(pDepthHotTile)
+                          : nullptr;
+
     // rasterize and generate coverage masks per sample
     for (uint32_t tileY = tY; tileY <= maxY; ++tileY)
     {
@@ -1386,17 +1459,37 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
                     UnrollerL<1, RT::MT::numSamples, 1>::step(copyCoverage);
                 }
 
-                // Track rasterized subspans
-                AR_EVENT(RasterTileCount(pDC->drawId, 1));
-
-                RDTSC_BEGIN(pDC->pContext->pBucketMgr, BEPixelBackend, pDC->drawId);
-                backendFuncs.pfnBackend(pDC,
-                                        workerId,
-                                        tileX << KNOB_TILE_X_DIM_SHIFT,
-                                        tileY << KNOB_TILE_Y_DIM_SHIFT,
-                                        triDesc,
-                                        renderBuffers);
-                RDTSC_END(pDC->pContext->pBucketMgr, BEPixelBackend, 0);
+                uint32_t hiZIndex =
+                    (tileY - macroY * KNOB_MACROTILE_Y_DIM_IN_TILES) * KNOB_MACROTILE_X_DIM_IN_TILES +
+                    (tileX - macroX * KNOB_MACROTILE_X_DIM_IN_TILES);
+                bool hiZReject = bHiZ && (pDepthHotTile->hiZValidMask & (1 << hiZIndex)) &&
+                                 (bHiZStrict ? hiZMinZ > pHiZ[hiZIndex]
+                                             : hiZMinZ >= pHiZ[hiZIndex]);
+
+                if (hiZReject)
+                {
+                    RDTSC_EVENT(pDC->pContext->pBucketMgr, BETrivialReject, 1, 0);
+                }
+                else
+                {
+                    // Track rasterized subspans
+                    AR_EVENT(RasterTileCount(pDC->drawId, 1));
+
+                    RDTSC_BEGIN(pDC->pContext->pBucketMgr, BEPixelBackend, pDC->drawId);
+                    backendFuncs.pfnBackend(pDC,
+                                            workerId,
+                                            tileX << KNOB_TILE_X_DIM_SHIFT,
+                                            tileY << KNOB_TILE_Y_DIM_SHIFT,
+                                            triDesc,
+                                            renderBuffers);
+                    RDTSC_END(pDC->pContext->pBucketMgr, BEPixelBackend, 0);
+
+                    if (bUpdateHiZ)
+                    {
+                        pHiZ[hiZIndex] = ComputeRasterTileMaxZ(renderBuffers.pDepth);
+                        pDepthHotTile->hiZValidMask |= 1 << hiZIndex;
+                    }
+                }
             }
 
             // step to the next tile in X
@@ -1480,6 +1573,12 @@ void GetRenderHotTiles(DRAW_CONTEXT*        pDC,
                                                             true,
                                                             numSamples,
                                                             renderTargetArrayIndex);
+        // the rasterizer only keeps the hierarchical Z of single sampled depth up to date,
+        // and a tile that wasn't dirty was just clean or loaded
+        if (pDepth->state != HOTTILE_DIRTY || numSamples > 1)
+        {
+            pDepth->hiZValidMask = 0;
+        }
         pDepth->state   = HOTTILE_DIRTY;
         SWR_ASSERT(pDepth->pBuffer != nullptr);
         renderBuffers.pDepth = pDepth->pBuffer + offset;
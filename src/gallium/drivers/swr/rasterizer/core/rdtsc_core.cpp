@@ -62,7 +62,9 @@ BUCKET_DESC gCoreBuckets[] = {
     {"FEProcessStoreTiles", "", true, 0xff39c864},
     {"FEProcessInvalidateTiles", "", true, 0xffffffff},
     {"WorkerWorkOnFifoBE", "", false, 0xff40261c},
-    {"WorkerFoundWork", "", false, 0xff573326},
+    {"WorkerFoundWork", "", true, 0xff573326},
+    {"WorkerSpin", "", false, 0xff8c6e5a},
+    {"WorkerPark", "", false, 0xffb3a398},
     {"BELoadTiles", "", true, 0xffb0e2ff},
     {"BEDispatch", "", true, 0xff00a2ff},
     {"BEClear", "", true, 0xff00ccbb},
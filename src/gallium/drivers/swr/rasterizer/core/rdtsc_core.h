@@ -71,6 +71,8 @@ enum CORE_BUCKETS
     FEProcessInvalidateTiles,
     WorkerWorkOnFifoBE,
     WorkerFoundWork,
+    WorkerSpin,
+    WorkerPark,
     BELoadTiles,
     BEDispatch,
     BEClear,
@@ -102,24 +104,29 @@ enum CORE_BUCKETS
 
 void rdtscReset(BucketManager* pBucketMgr);
 void rdtscInit(BucketManager* pBucketMgr, int threadId);
-void rdtscStart(BucketManager* pBucketMgr, uint32_t bucketId);
+void rdtscStart(BucketManager* pBucketMgr, uint32_t bucketId, uint64_t drawId);
 void rdtscStop(BucketManager* pBucketMgr, uint32_t bucketId, uint32_t count, uint64_t drawId);
 void rdtscEvent(BucketManager* pBucketMgr, uint32_t bucketId, uint32_t count1, uint32_t count2);
+void rdtscTile(BucketManager* pBucketMgr, uint32_t x, uint32_t y);
 void rdtscEndFrame(BucketManager* pBucketMgr);
 
 #ifdef KNOB_ENABLE_RDTSC
 #define RDTSC_RESET(pBucketMgr) rdtscReset(pBucketMgr)
 #define RDTSC_INIT(pBucketMgr, threadId) rdtscInit(pBucketMgr,threadId)
-#define RDTSC_START(pBucketMgr, bucket) rdtscStart(pBucketMgr, bucket)
+#define RDTSC_START(pBucketMgr, bucket) rdtscStart(pBucketMgr, bucket, 0)
+#define RDTSC_START_DRAW(pBucketMgr, bucket, draw) rdtscStart(pBucketMgr, bucket, draw)
 #define RDTSC_STOP(pBucketMgr, bucket, count, draw) rdtscStop(pBucketMgr, bucket, count, draw)
 #define RDTSC_EVENT(pBucketMgr, bucket, count1, count2) rdtscEvent(pBucketMgr, bucket, count1, count2)
+#define RDTSC_TILE(pBucketMgr, x, y) rdtscTile(pBucketMgr, x, y)
 #define RDTSC_ENDFRAME(pBucketMgr) rdtscEndFrame(pBucketMgr)
 #else
 #define RDTSC_RESET(pBucketMgr)
 #define RDTSC_INIT(pBucketMgr, threadId)
 #define RDTSC_START(pBucketMgr, bucket)
+#define RDTSC_START_DRAW(pBucketMgr, bucket, draw)
 #define RDTSC_STOP(pBucketMgr, bucket, count, draw)
 #define RDTSC_EVENT(pBucketMgr, bucket, count1, count2)
+#define RDTSC_TILE(pBucketMgr, x, y)
 #define RDTSC_ENDFRAME(pBucketMgr)
 #endif
 
@@ -148,16 +155,16 @@ INLINE void rdtscInit(BucketManager* pBucketMgr, int threadId)
     pBucketMgr->RegisterThread(name);
 }
 
-INLINE void rdtscStart(BucketManager* pBucketMgr, uint32_t bucketId)
+INLINE void rdtscStart(BucketManager* pBucketMgr, uint32_t bucketId, uint64_t drawId)
 {
     uint32_t id = pBucketMgr->mBucketMap[bucketId];
-    pBucketMgr->StartBucket(id);
+    pBucketMgr->StartBucket(id, drawId);
 }
 
 INLINE void rdtscStop(BucketManager* pBucketMgr, uint32_t bucketId, uint32_t count, uint64_t drawId)
 {
     uint32_t id = pBucketMgr->mBucketMap[bucketId];
-    pBucketMgr->StopBucket(id);
+    pBucketMgr->StopBucket(id, count);
 }
 
 INLINE void rdtscEvent(BucketManager* pBucketMgr, uint32_t bucketId, uint32_t count1, uint32_t count2)
@@ -166,6 +173,11 @@ INLINE void rdtscEvent(BucketManager* pBucketMgr, uint32_t bucketId, uint32_t co
     pBucketMgr->AddEvent(id, count1);
 }
 
+INLINE void rdtscTile(BucketManager* pBucketMgr, uint32_t x, uint32_t y)
+{
+    pBucketMgr->SetTraceTile(x, y);
+}
+
 INLINE void rdtscEndFrame(BucketManager* pBucketMgr)
 {
     pBucketMgr->mCurrentFrame++;
@@ -173,7 +185,7 @@ INLINE void rdtscEndFrame(BucketManager* pBucketMgr)
     if (pBucketMgr->mCurrentFrame == KNOB_BUCKETS_START_FRAME &&
         KNOB_BUCKETS_START_FRAME < KNOB_BUCKETS_END_FRAME)
     {
-        pBucketMgr->StartCapture();
+        pBucketMgr->StartCapture(KNOB_BUCKETS_TRACE);
     }
 
     if (pBucketMgr->mCurrentFrame == KNOB_BUCKETS_END_FRAME &&
@@ -181,5 +193,9 @@ INLINE void rdtscEndFrame(BucketManager* pBucketMgr)
     {
         pBucketMgr->StopCapture();
         pBucketMgr->PrintReport("rdtsc.txt");
+        if (KNOB_BUCKETS_TRACE)
+        {
+            pBucketMgr->PrintTrace("rdtsc.json");
+        }
     }
 }
@@ -614,6 +614,10 @@ OSALIGNLINE(struct) SWR_STATS
     uint64_t PsInvocations; // Number of Pixel Shader invocations
     uint64_t CsInvocations; // Number of Compute Shader invocations
 
+    // Arena block cache, totals for the context when the draw completed
+    uint64_t ArenaCacheHits;   // Number of blocks reused from the cache
+    uint64_t ArenaCacheMisses; // Number of blocks allocated from the system
+    uint64_t ArenaCachedBytes; // Size of the blocks kept in the cache
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -636,6 +640,14 @@ OSALIGNLINE(struct) SWR_STATS_FE
     // Streamout Stats
     uint64_t SoPrimStorageNeeded[4];
     uint64_t SoNumPrimsWritten[4];
+
+    // Binner Stats
+    uint64_t BinTrivialRejects; // Number of triangles culled by the binner
+    uint64_t BinSingleTileTris; // Number of binned triangles within one macrotile
+    uint64_t BinMultiTileTris;  // Number of binned triangles spanning macrotiles
+
+    // API Stats
+    uint64_t StateCopyBytes; // Number of API state bytes copied from the previous draw
 };
 
     //////////////////////////////////////////////////////////////////////////
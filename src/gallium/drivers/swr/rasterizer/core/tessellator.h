@@ -50,6 +50,54 @@ namespace Tessellator
         uint32_t               NumDomainPoints;
         OSALIGNSIMD(uint32_t)  Indices[3][MAX_INDEX_COUNT / 3];
         uint32_t               NumIndices;
+        uint32_t               NumPrimitives;
+        SWR_TESSELLATION_FACTORS LastTessFactors;
+        bool                   bHaveLastResult;
+
+        //////////////////////////////////////////////////////////////////////////
+        /// @brief Copy the AoS points of the reference tessellator into the SoA
+        ///        arrays, a SIMD width at a time.
+        void StorePoints(const DOMAIN_POINT* pPoints)
+        {
+            const simdscalari vOffsets = _simd_set_epi32(14, 12, 10, 8, 6, 4, 2, 0);
+            const float* pSrc = (const float*)pPoints;
+
+            uint32_t i = 0;
+            for (; i + KNOB_SIMD_WIDTH <= NumDomainPoints; i += KNOB_SIMD_WIDTH)
+            {
+                _simd_store_ps(&DomainPointsU[i], _simd_i32gather_ps(&pSrc[2 * i], vOffsets, 4));
+                _simd_store_ps(&DomainPointsV[i], _simd_i32gather_ps(&pSrc[2 * i + 1], vOffsets, 4));
+            }
+            for (; i < NumDomainPoints; i++)
+            {
+                DomainPointsU[i] = pPoints[i].u;
+                DomainPointsV[i] = pPoints[i].v;
+            }
+        }
+
+        //////////////////////////////////////////////////////////////////////////
+        /// @brief Split the interleaved primitive indices into one array per
+        ///        primitive vertex, a SIMD width of primitives at a time.
+        void StoreIndices(const uint32_t* pIndices, uint32_t indexDiv)
+        {
+            const int32_t     d        = (int32_t)indexDiv;
+            const simdscalari vOffsets = _simd_set_epi32(7 * d, 6 * d, 5 * d, 4 * d, 3 * d, 2 * d, d, 0);
+            const float* pSrc = (const float*)pIndices;
+
+            uint32_t p = 0;
+            for (; p + KNOB_SIMD_WIDTH <= NumPrimitives; p += KNOB_SIMD_WIDTH)
+            {
+                for (uint32_t v = 0; v < indexDiv; v++)
+                {
+                    simdscalar vIndices = _simd_i32gather_ps(&pSrc[indexDiv * p + v], vOffsets, 4);
+                    _simd_store_si((simdscalari*)&Indices[v][p], _simd_castps_si(vIndices));
+                }
+            }
+            for (uint32_t i = p * indexDiv; i < NumIndices; i++)
+            {
+                Indices[i % indexDiv][i / indexDiv] = pIndices[i];
+            }
+        }
 
     public:
         void Init(SWR_TS_DOMAIN          tsDomain,
@@ -76,11 +124,27 @@ namespace Tessellator
             Domain          = tsDomain;
             NumDomainPoints = 0;
             NumIndices      = 0;
+            NumPrimitives   = 0;
+            bHaveLastResult = false;
         }
 
         void Tessellate(const SWR_TESSELLATION_FACTORS& tsTessFactors,
                         SWR_TS_TESSELLATED_DATA&        tsTessellatedData)
         {
+            // Patches of a draw often share their tess factors, the SoA data of
+            // the previous patch is still here in that case
+            if (bHaveLastResult &&
+                !memcmp(LastTessFactors.OuterTessFactors,
+                        tsTessFactors.OuterTessFactors,
+                        sizeof(tsTessFactors.OuterTessFactors)) &&
+                !memcmp(LastTessFactors.InnerTessFactors,
+                        tsTessFactors.InnerTessFactors,
+                        sizeof(tsTessFactors.InnerTessFactors)))
+            {
+                GetResult(tsTessellatedData);
+                return;
+            }
+
             uint32_t IndexDiv = 0;
             switch (Domain)
             {
@@ -117,25 +181,27 @@ namespace Tessellator
             }
 
             NumDomainPoints = (uint32_t)SUPER::GetPointCount();
-
-            DOMAIN_POINT* pPoints = SUPER::GetPoints();
-            for (uint32_t i = 0; i < NumDomainPoints; i++) {
-                DomainPointsU[i] = pPoints[i].u;
-                DomainPointsV[i] = pPoints[i].v;
-            }
-            tsTessellatedData.NumDomainPoints = NumDomainPoints;
-            tsTessellatedData.pDomainPointsU  = &DomainPointsU[0];
-            tsTessellatedData.pDomainPointsV  = &DomainPointsV[0];
+            StorePoints(SUPER::GetPoints());
 
             NumIndices = (uint32_t)SUPER::GetIndexCount();
 
             assert(NumIndices % IndexDiv == 0);
-            tsTessellatedData.NumPrimitives = NumIndices / IndexDiv;
+            NumPrimitives = NumIndices / IndexDiv;
+            StoreIndices((uint32_t*)SUPER::GetIndices(), IndexDiv);
 
-            uint32_t* pIndices = (uint32_t*)SUPER::GetIndices();
-            for (uint32_t i = 0; i < NumIndices; i++) {
-                Indices[i % IndexDiv][i / IndexDiv] = pIndices[i];
-            }
+            LastTessFactors = tsTessFactors;
+            bHaveLastResult = true;
+
+            GetResult(tsTessellatedData);
+        }
+
+        void GetResult(SWR_TS_TESSELLATED_DATA& tsTessellatedData)
+        {
+            tsTessellatedData.NumDomainPoints = NumDomainPoints;
+            tsTessellatedData.pDomainPointsU  = &DomainPointsU[0];
+            tsTessellatedData.pDomainPointsV  = &DomainPointsV[0];
+
+            tsTessellatedData.NumPrimitives = NumPrimitives;
 
             tsTessellatedData.ppIndices[0] = &Indices[0][0];
             tsTessellatedData.ppIndices[1] = &Indices[1][0];
@@ -29,6 +29,7 @@
 #include <utility>
 #include <fstream>
 #include <string>
+#include <mutex>
 
 #if defined(__linux__) || defined(__gnu_linux__) || defined(__APPLE__)
 #include <pthread.h>
@@ -422,6 +423,9 @@ INLINE void UpdateClientStats(SWR_CONTEXT* pContext, uint32_t workerId, DRAW_CON
 
     }
 
+    pContext->cachingArenaAllocator.GetStats(
+        stats.ArenaCacheHits, stats.ArenaCacheMisses, stats.ArenaCachedBytes);
+
 
     pContext->pfnUpdateStats(GetPrivateState(pDC), &stats);
 }
@@ -455,15 +459,16 @@ INLINE int32_t CompleteDrawContextInl(SWR_CONTEXT* pContext, uint32_t workerId,
         ExecuteCallbacks(pContext, workerId, pDC);
 
 
-        // Cleanup memory allocations
-        pDC->pArena->Reset(true);
+        // Cleanup memory allocations, the arenas keep a block for the next
+        // draw that uses this context
+        pDC->pArena->Reset();
         if (!pDC->isCompute)
         {
             pDC->pTileMgr->initialize();
         }
         if (pDC->cleanupState)
         {
-            pDC->pState->pArena->Reset(true);
+            pDC->pState->pArena->Reset();
         }
 
         _ReadWriteBarrier();
@@ -577,16 +582,31 @@ bool WorkOnFifoBE(SWR_CONTEXT* pContext,
         }
 
         // Grab the list of all dirty macrotiles. A tile is dirty if it has work queued to it.
-        auto& macroTiles = pDC->pTileMgr->getDirtyTiles();
+        auto&    macroTiles = pDC->pTileMgr->getDirtyTiles();
+        uint32_t numTiles   = (uint32_t)macroTiles.size();
+
+        // Workers start at different tiles so that they don't all contend for the same ones.
+        // Tiles of the other numa nodes are only visited in a second pass, if this worker
+        // couldn't lock any tile of its own node.
+        uint32_t start     = numTiles ? workerId % numTiles : 0;
+        uint32_t numPasses = numaMask ? 2 : 1;
+        bool     foundWork = false;
 
-        for (auto tile : macroTiles)
+        for (uint32_t n = 0; n < numTiles * numPasses; ++n)
         {
-            uint32_t tileID = tile->mId;
+            bool steal = n >= numTiles;
+            if (steal && foundWork)
+            {
+                break;
+            }
+
+            MacroTileQueue* tile   = macroTiles[(start + n) % numTiles];
+            uint32_t        tileID = tile->mId;
 
-            // Only work on tiles for this numa node
+            // Work on tiles for this numa node first
             uint32_t x, y;
             pDC->pTileMgr->getTileIndices(tileID, x, y);
-            if (((x ^ y) & numaMask) != numaNode)
+            if ((((x ^ y) & numaMask) != numaNode) != steal)
             {
                 _mm_pause();
                 continue;
@@ -609,7 +629,10 @@ bool WorkOnFifoBE(SWR_CONTEXT* pContext,
             {
                 BE_WORK* pWork;
 
+                foundWork = true;
+
                 RDTSC_BEGIN(pContext->pBucketMgr, WorkerFoundWork, pDC->drawId);
+                RDTSC_TILE(pContext->pBucketMgr, x, y);
 
                 uint32_t numWorkItems = tile->getNumQueued();
                 SWR_ASSERT(numWorkItems);
@@ -816,13 +839,20 @@ void WorkOnCompute(SWR_CONTEXT* pContext, uint32_t workerId, uint32_t& curDrawBE
         // Is there any work remaining?
         if (queue.getNumQueued() > 0)
         {
+            // The spill fill and scratch buffers are allocated on the first
+            // thread group and reused for all the groups this worker runs.
             void*    pSpillFillBuffer = nullptr;
             void*    pScratchSpace    = nullptr;
             uint32_t threadGroupId    = 0;
-            while (queue.getWork(threadGroupId))
+            uint32_t numThreadGroups  = 0;
+            while (queue.getWork(pContext->NumWorkerThreads, threadGroupId, numThreadGroups))
             {
-                queue.dispatch(pDC, workerId, threadGroupId, pSpillFillBuffer, pScratchSpace);
-                queue.finishedWork();
+                for (uint32_t i = 0; i < numThreadGroups; ++i)
+                {
+                    queue.dispatch(
+                        pDC, workerId, threadGroupId + i, pSpillFillBuffer, pScratchSpace);
+                }
+                queue.finishedWork(numThreadGroups);
             }
 
             // Ensure all streaming writes are globally visible before moving onto the next draw
@@ -919,6 +949,14 @@ DWORD workerThreadMain(LPVOID pData)
 
     bool bShutdown = false;
 
+    // Idle workers spin for up to spinLimit iterations before going to sleep. The limit is
+    // halved every time no work showed up for longer than the longest spin would have lasted,
+    // and doubled when the worker got woken up before that, so mostly idle workers don't burn
+    // CPU while workers of bursty workloads stay awake.
+    const uint32_t maxSpinLimit = KNOB_WORKER_SPIN_LOOP_COUNT;
+    const uint32_t minSpinLimit = std::max(maxSpinLimit / 32, 1U);
+    uint32_t       spinLimit    = maxSpinLimit;
+
     while (true)
     {
         if (bShutdown && !threadHasWork(curDrawBE))
@@ -926,11 +964,16 @@ DWORD workerThreadMain(LPVOID pData)
             break;
         }
 
-        uint32_t loop = 0;
-        while (loop++ < KNOB_WORKER_SPIN_LOOP_COUNT && !threadHasWork(curDrawBE))
+        uint64_t spinStart = __rdtsc();
+        uint32_t loop      = 0;
+
+        RDTSC_BEGIN(pContext->pBucketMgr, WorkerSpin, 0);
+        while (loop < spinLimit && !threadHasWork(curDrawBE))
         {
             _mm_pause();
+            ++loop;
         }
+        RDTSC_END(pContext->pBucketMgr, WorkerSpin, loop);
 
         if (!threadHasWork(curDrawBE))
         {
@@ -943,8 +986,27 @@ DWORD workerThreadMain(LPVOID pData)
                 continue;
             }
 
+            uint64_t parkStart = __rdtsc();
+
+            RDTSC_BEGIN(pContext->pBucketMgr, WorkerPark, 0);
             pContext->FifosNotEmpty.wait(lock);
+            RDTSC_END(pContext->pBucketMgr, WorkerPark, 0);
             lock.unlock();
+
+            if (maxSpinLimit)
+            {
+                uint64_t maxSpinCycles =
+                    (parkStart - spinStart) / std::max(loop, 1U) * maxSpinLimit;
+
+                if (__rdtsc() - parkStart < maxSpinCycles)
+                {
+                    spinLimit = std::min(spinLimit * 2, maxSpinLimit);
+                }
+                else
+                {
+                    spinLimit = std::max(spinLimit / 2, minSpinLimit);
+                }
+            }
         }
 
         if (IsBEThread)
@@ -1006,6 +1068,22 @@ static void InitPerThreadStats(SWR_CONTEXT* pContext, uint32_t numThreads)
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the processor topology, which only gets calculated for
+///        the first context of the process.
+static void GetProcessorTopology(CPUNumaNodes& out_nodes, uint32_t& out_numThreadsPerProcGroup)
+{
+    static std::once_flag s_topologyOnce;
+    static CPUNumaNodes   s_nodes;
+    static uint32_t       s_numThreadsPerProcGroup = 0;
+
+    std::call_once(s_topologyOnce,
+                   [] { CalculateProcessorTopology(s_nodes, s_numThreadsPerProcGroup); });
+
+    out_nodes                  = s_nodes;
+    out_numThreadsPerProcGroup = s_numThreadsPerProcGroup;
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Creates thread pool info but doesn't launch threads.
 /// @param pContext - pointer to context
@@ -1014,7 +1092,7 @@ void CreateThreadPool(SWR_CONTEXT* pContext, THREAD_POOL* pPool)
 {
     CPUNumaNodes nodes;
     uint32_t     numThreadsPerProcGroup = 0;
-    CalculateProcessorTopology(nodes, numThreadsPerProcGroup);
+    GetProcessorTopology(nodes, numThreadsPerProcGroup);
     assert(numThreadsPerProcGroup > 0);
 
     // Assumption, for asymmetric topologies, multi-threaded cores will appear
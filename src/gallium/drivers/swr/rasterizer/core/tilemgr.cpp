@@ -35,7 +35,13 @@
 
 MacroTileMgr::MacroTileMgr(CachingArena& arena) : mArena(arena) {}
 
-void MacroTileMgr::enqueue(uint32_t x, uint32_t y, BE_WORK* pWork)
+//////////////////////////////////////////////////////////////////////////
+/// @brief Queues an array of work items for one macrotile
+/// @param x - macrotile x coordinate
+/// @param y - macrotile y coordinate
+/// @param pWork - work items, copied into the macrotile queue
+/// @param numWork - number of work items in pWork
+void MacroTileMgr::enqueue(uint32_t x, uint32_t y, BE_WORK* pWork, uint32_t numWork)
 {
     // Should not enqueue more then what we have backing for in the hot tile manager.
     SWR_ASSERT(x < KNOB_NUM_HOT_TILES_X);
@@ -58,17 +64,20 @@ void MacroTileMgr::enqueue(uint32_t x, uint32_t y, BE_WORK* pWork)
     {
         pTile = mTiles[id] = new MacroTileQueue();
     }
-    pTile->mWorkItemsFE++;
+    pTile->mWorkItemsFE += numWork;
     pTile->mId = id;
 
-    if (pTile->mWorkItemsFE == 1)
+    if (pTile->mWorkItemsFE == numWork)
     {
         pTile->clear(mArena);
         mDirtyTiles.push_back(pTile);
     }
 
-    mWorkItemsProduced++;
-    pTile->enqueue_try_nosync(mArena, pWork);
+    mWorkItemsProduced += numWork;
+    for (uint32_t i = 0; i < numWork; ++i)
+    {
+        pTile->enqueue_try_nosync(mArena, &pWork[i]);
+    }
 }
 
 void MacroTileMgr::markTileComplete(uint32_t id)
@@ -105,11 +114,21 @@ HOTTILE* HotTileMgr::GetHotTile(SWR_CONTEXT*                pContext,
 
     HotTileSet& tile    = mHotTiles[x][y];
     HOTTILE&    hotTile = tile.Attachment[attachment];
+    if (hotTile.pBuffer == NULL && hotTile.state == HOTTILE_CLEAR && create)
+    {
+        // allocate the memory of a tile that was only cleared so far, the clear itself is still
+        // pending and gets handled below like for any other tile
+        uint32_t size     = GetHotTileAllocSize(attachment, hotTile.numSamples);
+        uint32_t numaNode = ((x ^ y) & pContext->threadPool.numaMask);
+        hotTile.pBuffer =
+            (uint8_t*)AllocHotTileMem(size, 64, numaNode + pContext->threadInfo.BASE_NUMA_NODE);
+    }
+
     if (hotTile.pBuffer == NULL)
     {
         if (create)
         {
-            uint32_t size     = numSamples * mHotTileSize[attachment];
+            uint32_t size     = GetHotTileAllocSize(attachment, numSamples);
             uint32_t numaNode = ((x ^ y) & pContext->threadPool.numaMask);
             hotTile.pBuffer =
                 (uint8_t*)AllocHotTileMem(size, 64, numaNode + pContext->threadInfo.BASE_NUMA_NODE);
@@ -133,7 +152,7 @@ HOTTILE* HotTileMgr::GetHotTile(SWR_CONTEXT*                pContext,
                        (hotTile.state == HOTTILE_CLEAR));
             FreeHotTileMem(hotTile.pBuffer);
 
-            uint32_t size     = numSamples * mHotTileSize[attachment];
+            uint32_t size     = GetHotTileAllocSize(attachment, numSamples);
             uint32_t numaNode = ((x ^ y) & pContext->threadPool.numaMask);
             hotTile.pBuffer =
                 (uint8_t*)AllocHotTileMem(size, 64, numaNode + pContext->threadInfo.BASE_NUMA_NODE);
@@ -227,9 +246,18 @@ HOTTILE* HotTileMgr::GetHotTileNoLoad(SWR_CONTEXT*                pContext,
     HOTTILE&    hotTile = tile.Attachment[attachment];
     if (hotTile.pBuffer == NULL)
     {
-        if (create)
+        if (hotTile.state == HOTTILE_CLEAR)
+        {
+            // tile with a pending clear that hasn't been allocated yet
+            if (create)
+            {
+                uint32_t size   = GetHotTileAllocSize(attachment, hotTile.numSamples);
+                hotTile.pBuffer = (uint8_t*)AlignedMalloc(size, 64);
+            }
+        }
+        else if (create)
         {
-            uint32_t size                  = numSamples * mHotTileSize[attachment];
+            uint32_t size                  = GetHotTileAllocSize(attachment, numSamples);
             hotTile.pBuffer                = (uint8_t*)AlignedMalloc(size, 64);
             hotTile.state                  = HOTTILE_INVALID;
             hotTile.numSamples             = numSamples;
@@ -244,6 +272,54 @@ HOTTILE* HotTileMgr::GetHotTileNoLoad(SWR_CONTEXT*                pContext,
     return &hotTile;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the hot tile a fast clear records its clear value in. Tiles that have no
+///        memory yet don't get any until something is rendered to them, so that render targets
+///        that are cleared and stored don't need hot tile memory. The caller sets the state to
+///        HOTTILE_CLEAR, tiles without memory don't hold any data in the other states.
+HOTTILE* HotTileMgr::GetHotTileForClear(SWR_CONTEXT*                pContext,
+                                        DRAW_CONTEXT*               pDC,
+                                        HANDLE                      hWorkerPrivateData,
+                                        uint32_t                    macroID,
+                                        SWR_RENDERTARGET_ATTACHMENT attachment,
+                                        uint32_t                    numSamples,
+                                        uint32_t                    renderTargetArrayIndex)
+{
+    uint32_t x, y;
+    MacroTileMgr::getTileIndices(macroID, x, y);
+
+    SWR_ASSERT(x < KNOB_NUM_HOT_TILES_X);
+    SWR_ASSERT(y < KNOB_NUM_HOT_TILES_Y);
+
+    HOTTILE& hotTile = mHotTiles[x][y].Attachment[attachment];
+    if (hotTile.pBuffer == NULL)
+    {
+        if (hotTile.state != HOTTILE_CLEAR)
+        {
+            hotTile.numSamples             = numSamples;
+            hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
+            return &hotTile;
+        }
+
+        // a pending clear of the same slice is simply replaced, one of another slice has to
+        // reach memory first
+        if (hotTile.renderTargetArrayIndex == renderTargetArrayIndex)
+        {
+            hotTile.numSamples = std::max(hotTile.numSamples, numSamples);
+            return &hotTile;
+        }
+    }
+
+    return GetHotTile(pContext,
+                      pDC,
+                      hWorkerPrivateData,
+                      macroID,
+                      attachment,
+                      true,
+                      numSamples,
+                      renderTargetArrayIndex);
+}
+
 void HotTileMgr::ClearColorHotTile(
     const HOTTILE* pHotTile) // clear a macro tile from float4 clear data.
 {
@@ -409,7 +485,8 @@ void HotTileMgr::InitializeHotTiles(SWR_CONTEXT*  pContext,
                                   y,
                                   pHotTile->renderTargetArrayIndex,
                                   pHotTile->pBuffer);
-            pHotTile->state = HOTTILE_DIRTY;
+            pHotTile->state        = HOTTILE_DIRTY;
+            pHotTile->hiZValidMask = 0;
             RDTSC_END(pContext->pBucketMgr, BELoadTiles, 0);
         }
         else if (pHotTile->state == HOTTILE_CLEAR)
@@ -418,6 +495,16 @@ void HotTileMgr::InitializeHotTiles(SWR_CONTEXT*  pContext,
             // Clear the tile.
             ClearDepthHotTile(pHotTile);
             pHotTile->state = HOTTILE_DIRTY;
+
+            // all raster tiles are at the clear depth now
+            float* pHiZ = GetHiZ(pHotTile);
+            for (uint32_t i = 0; i < KNOB_MACROTILE_X_DIM_IN_TILES * KNOB_MACROTILE_Y_DIM_IN_TILES;
+                 ++i)
+            {
+                pHiZ[i] = *(float*)pHotTile->clearData;
+            }
+            pHotTile->hiZValidMask =
+                (1 << (KNOB_MACROTILE_X_DIM_IN_TILES * KNOB_MACROTILE_Y_DIM_IN_TILES)) - 1;
             RDTSC_END(pContext->pBucketMgr, BELoadTiles, 0);
         }
     }
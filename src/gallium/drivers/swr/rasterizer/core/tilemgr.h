@@ -115,7 +115,7 @@ public:
 
     INLINE bool isWorkComplete() { return mWorkItemsProduced == mWorkItemsConsumed; }
 
-    void enqueue(uint32_t x, uint32_t y, BE_WORK* pWork);
+    void enqueue(uint32_t x, uint32_t y, BE_WORK* pWork, uint32_t numWork = 1);
 
     static INLINE void getTileIndices(uint32_t tileID, uint32_t& x, uint32_t& y)
     {
@@ -177,16 +177,25 @@ public:
     uint32_t getNumQueued() { return (mTasksAvailable > 0) ? mTasksAvailable : 0; }
 
     //////////////////////////////////////////////////////////////////////////
-    /// @brief Atomically decrement the work available count. If the result
-    //         is greater than 0 then we can on the associated thread group.
-    //         Otherwise, there is no more work to do.
-    bool getWork(uint32_t& groupId)
+    /// @brief Atomically claim a range of thread groups by subtracting from the
+    //         work available count. The range size scales with the work that
+    //         is left, so that workers take few trips through the atomic on
+    //         big dispatches while the last groups are still spread out.
+    //         Returns false if there is no more work to do.
+    /// @param numWorkers - number of workers sharing this dispatch
+    /// @param groupId - first thread group of the claimed range
+    /// @param numGroups - number of thread groups in the claimed range
+    bool getWork(uint32_t numWorkers, uint32_t& groupId, uint32_t& numGroups)
     {
-        long result = InterlockedDecrement(&mTasksAvailable);
+        long chunk = mTasksAvailable / (long)(numWorkers * 4);
+        chunk      = (chunk > MAX_TASKS_PER_CHUNK) ? MAX_TASKS_PER_CHUNK : std::max(chunk, 1L);
 
-        if (result >= 0)
+        long result = InterlockedAdd(&mTasksAvailable, -chunk);
+
+        if (result + chunk > 0)
         {
-            groupId = result;
+            groupId   = (uint32_t)std::max(result, 0L);
+            numGroups = (uint32_t)(result + chunk - groupId);
             return true;
         }
 
@@ -197,9 +206,9 @@ public:
     /// @brief Atomically decrement the outstanding count. A worker is notifying
     ///        us that he just finished some work. Also, return true if we're
     ///        the last worker to complete this dispatch.
-    bool finishedWork()
+    bool finishedWork(uint32_t numTasks)
     {
-        long result = InterlockedDecrement(&mTasksOutstanding);
+        long result = InterlockedAdd(&mTasksOutstanding, -(long)numTasks);
         SWR_ASSERT(result >= 0, "Should never oversubscribe work");
 
         return (result == 0) ? true : false;
@@ -231,6 +240,8 @@ public:
 
     OSALIGNLINE(volatile long) mTasksAvailable{0};
     OSALIGNLINE(volatile long) mTasksOutstanding{0};
+
+    static const long MAX_TASKS_PER_CHUNK = 64;
 };
 
 /// @note this enum needs to be kept in sync with SWR_TILE_STATE!
@@ -251,6 +262,7 @@ struct HOTTILE
                         // alignment?
     uint32_t numSamples;
     uint32_t renderTargetArrayIndex; // current render target array index loaded
+    uint32_t hiZValidMask; // depth only, raster tiles with a known max depth, see GetHiZ
 };
 
 union HotTileSet
@@ -318,14 +330,46 @@ public:
                               bool                        create,
                               uint32_t                    numSamples = 1);
 
+    HOTTILE* GetHotTileForClear(SWR_CONTEXT*                pContext,
+                                DRAW_CONTEXT*               pDC,
+                                HANDLE                      hWorkerData,
+                                uint32_t                    macroID,
+                                SWR_RENDERTARGET_ATTACHMENT attachment,
+                                uint32_t                    numSamples,
+                                uint32_t                    renderTargetArrayIndex);
+
     static void ClearColorHotTile(const HOTTILE* pHotTile);
     static void ClearDepthHotTile(const HOTTILE* pHotTile);
     static void ClearStencilHotTile(const HOTTILE* pHotTile);
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns the max depth of each raster tile of a depth hot tile,
+    ///        stored after the samples. Entries are only meaningful for the
+    ///        bits set in hiZValidMask, which the rasterizer maintains for
+    ///        single sampled depth. Anything else changing the depth contents
+    ///        must clear the mask.
+    INLINE float* GetHiZ(const HOTTILE* pHotTile)
+    {
+        static_assert(KNOB_MACROTILE_X_DIM_IN_TILES * KNOB_MACROTILE_Y_DIM_IN_TILES < 32,
+                      "Too many raster tiles per macrotile for hiZValidMask");
+        return (float*)(pHotTile->pBuffer +
+                        pHotTile->numSamples * mHotTileSize[SWR_ATTACHMENT_DEPTH]);
+    }
+
 private:
     HotTileSet mHotTiles[KNOB_NUM_HOT_TILES_X][KNOB_NUM_HOT_TILES_Y];
     uint32_t   mHotTileSize[SWR_NUM_ATTACHMENTS];
 
+    uint32_t GetHotTileAllocSize(SWR_RENDERTARGET_ATTACHMENT attachment, uint32_t numSamples)
+    {
+        uint32_t size = numSamples * mHotTileSize[attachment];
+        if (attachment == SWR_ATTACHMENT_DEPTH)
+        {
+            size += KNOB_MACROTILE_X_DIM_IN_TILES * KNOB_MACROTILE_Y_DIM_IN_TILES * sizeof(float);
+        }
+        return size;
+    }
+
     void* AllocHotTileMem(size_t size, uint32_t align, uint32_t numaNode)
     {
         void* p = nullptr;
@@ -37,6 +37,9 @@
 
 #include "gen_state_llvm.h"
 
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
+
 #include <sstream>
 #if defined(_WIN32)
 #include <psapi.h>
@@ -48,7 +51,6 @@
 #endif // _WIN32
 
 #if defined(__APPLE__) || defined(FORCE_LINUX) || defined(__linux__) || defined(__gnu_linux__)
-#include <pwd.h>
 #include <sys/stat.h>
 #endif
 
@@ -129,6 +131,9 @@ JitManager::JitManager(uint32_t simdWidth, const char* arch, const char* core) :
         mOptLevel = CodeGenOpt::Level(KNOB_JIT_OPTIMIZATION_LEVEL);
     }
 
+    // Nothing to gain from tiering if the final code isn't optimized either.
+    mTieredCompilation = KNOB_JIT_TIERED_COMPILATION && mOptLevel != CodeGenOpt::None;
+
     if (KNOB_JIT_ENABLE_CACHE)
     {
         mCache.Init(this, mHostCpuName, mOptLevel);
@@ -178,7 +183,9 @@ JitManager::JitManager(uint32_t simdWidth, const char* arch, const char* core) :
 #endif
 }
 
-void JitManager::CreateExecEngine(std::unique_ptr<Module> pModule)
+static ExecutionEngine* CreateEngine(std::unique_ptr<Module> pModule,
+                                     CodeGenOpt::Level       optLevel,
+                                     StringRef               cpuName)
 {
     TargetOptions tOpts;
     tOpts.AllowFPOpFusion = FPOpFusion::Fast;
@@ -188,22 +195,32 @@ void JitManager::CreateExecEngine(std::unique_ptr<Module> pModule)
 
     // tOpts.PrintMachineCode    = true;
 
-    mpExec = EngineBuilder(std::move(pModule))
-                 .setTargetOptions(tOpts)
-                 .setOptLevel(mOptLevel)
-                 .setMCPU(mHostCpuName)
-                 .create();
-
-    if (KNOB_JIT_ENABLE_CACHE)
-    {
-        mpExec->setObjectCache(&mCache);
-    }
+    ExecutionEngine* pExec = EngineBuilder(std::move(pModule))
+                                 .setTargetOptions(tOpts)
+                                 .setOptLevel(optLevel)
+                                 .setMCPU(cpuName)
+                                 .create();
 
 #if LLVM_USE_INTEL_JITEVENTS
     JITEventListener* vTune = JITEventListener::createIntelJITEventListener();
-    mpExec->RegisterJITEventListener(vTune);
+    pExec->RegisterJITEventListener(vTune);
 #endif
 
+    return pExec;
+}
+
+void JitManager::CreateExecEngine(std::unique_ptr<Module> pModule)
+{
+    // With tiered compilation the object cache is only used for the
+    // optimized code, see TieredCompileThread().
+    mpExec = CreateEngine(
+        std::move(pModule), mTieredCompilation ? CodeGenOpt::None : mOptLevel, mHostCpuName);
+
+    if (KNOB_JIT_ENABLE_CACHE && !mTieredCompilation)
+    {
+        mpExec->setObjectCache(&mCache);
+    }
+
     mvExecEngines.push_back(mpExec);
 }
 
@@ -220,6 +237,179 @@ void JitManager::SetupNewModule()
     mIsModuleFinalized = false;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Jit the current module and return the address of pFunction.
+///        With tiered compilation this is the address of a stub which
+///        calls the unoptimized code until the optimized code is ready.
+void* JitManager::GetFunctionAddress(const Function* pFunction)
+{
+    std::string funcName = pFunction->getName().str();
+
+    if (!mTieredCompilation)
+    {
+        return (void*)mpExec->getFunctionAddress(funcName);
+    }
+
+    // Snapshot the module for the background compile before the stub is
+    // added to it.
+    TieredJob job;
+    job.moduleId = mpCurrentModule->getModuleIdentifier();
+    job.funcName = funcName;
+    {
+        raw_string_ostream bitcodeStream(job.bitcode);
+#if LLVM_VERSION_MAJOR >= 7
+        llvm::WriteBitcodeToFile(*mpCurrentModule, bitcodeStream);
+#else
+        llvm::WriteBitcodeToFile(mpCurrentModule, bitcodeStream);
+#endif
+        bitcodeStream.flush();
+    }
+
+    mTieredTargets.emplace_back(new std::atomic<void*>(nullptr));
+    job.pTarget = mTieredTargets.back().get();
+
+    Function* pStub = CreateTieredStub(pFunction, job.pTarget);
+
+    job.pTarget->store((void*)mpExec->getFunctionAddress(funcName), std::memory_order_release);
+    void* pfnStub = (void*)mpExec->getFunctionAddress(pStub->getName().str());
+
+    {
+        std::lock_guard<std::mutex> lock(mTieredMutex);
+        if (!mTieredThread.joinable())
+        {
+            mTieredThread = std::thread(&JitManager::TieredCompileThread, this);
+        }
+        mTieredJobs.push_back(std::move(job));
+    }
+    mTieredCond.notify_one();
+
+    return pfnStub;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Create a function with the signature of pFunction which
+///        forwards its arguments to the function pointer in pTarget.
+Function* JitManager::CreateTieredStub(const Function* pFunction, std::atomic<void*>* pTarget)
+{
+    FunctionType* pFuncTy = pFunction->getFunctionType();
+    Function*     pStub   = Function::Create(pFuncTy,
+                                       GlobalValue::ExternalLinkage,
+                                       pFunction->getName() + "_tiered",
+                                       mpCurrentModule);
+    pStub->setCallingConv(pFunction->getCallingConv());
+    pStub->setAttributes(pFunction->getAttributes());
+
+    IRBuilder<> builder(BasicBlock::Create(mContext, "entry", pStub));
+
+    Type*  pTargetTy  = PointerType::get(pFuncTy, 0);
+    Value* pTargetPtr = ConstantExpr::getIntToPtr(builder.getInt64((uint64_t)pTarget),
+                                                  PointerType::get(pTargetTy, 0));
+
+    LoadInst* pfnTarget = builder.CreateLoad(pTargetTy, pTargetPtr);
+    pfnTarget->setAtomic(AtomicOrdering::Acquire);
+#if LLVM_VERSION_MAJOR >= 11
+    pfnTarget->setAlignment(Align(sizeof(void*)));
+#elif LLVM_VERSION_MAJOR >= 10
+    pfnTarget->setAlignment(MaybeAlign(sizeof(void*)));
+#else
+    pfnTarget->setAlignment(sizeof(void*));
+#endif
+
+    std::vector<Value*> args;
+    for (auto& arg : pStub->args())
+    {
+        args.push_back(&arg);
+    }
+
+    CallInst* pCall = builder.CreateCall(pFuncTy, pfnTarget, args);
+    pCall->setCallingConv(pFunction->getCallingConv());
+    pCall->setTailCall();
+
+    if (pFuncTy->getReturnType()->isVoidTy())
+    {
+        builder.CreateRetVoid();
+    }
+    else
+    {
+        builder.CreateRet(pCall);
+    }
+
+    return pStub;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Background thread compiling the optimized versions of the
+///        functions handed out by GetFunctionAddress().
+void JitManager::TieredCompileThread()
+{
+    // The optimized code has to stay around as long as the JitManager, so
+    // the context and engines only go away once the thread is stopped.
+    LLVMContext                   context;
+    std::vector<ExecutionEngine*> vExecEngines;
+
+    std::unique_lock<std::mutex> lock(mTieredMutex);
+    while (true)
+    {
+        mTieredCond.wait(lock, [this] { return mTieredExit || !mTieredJobs.empty(); });
+        if (mTieredExit)
+        {
+            break;
+        }
+
+        TieredJob job = std::move(mTieredJobs.front());
+        mTieredJobs.pop_front();
+        lock.unlock();
+
+        auto pModule = parseBitcodeFile(MemoryBufferRef(job.bitcode, job.moduleId), context);
+        if (pModule)
+        {
+            ExecutionEngine* pExec = CreateEngine(std::move(*pModule), mOptLevel, mHostCpuName);
+
+            // Only this thread uses the object cache in tiered mode.
+            if (KNOB_JIT_ENABLE_CACHE)
+            {
+                pExec->setObjectCache(&mCache);
+            }
+            vExecEngines.push_back(pExec);
+
+            void* pfnOptimized = (void*)pExec->getFunctionAddress(job.funcName);
+            if (pfnOptimized)
+            {
+                job.pTarget->store(pfnOptimized, std::memory_order_release);
+            }
+        }
+        else
+        {
+            // Keep using the unoptimized code.
+            consumeError(pModule.takeError());
+        }
+
+        lock.lock();
+    }
+    lock.unlock();
+
+    for (auto* pExec : vExecEngines)
+    {
+        delete pExec;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Stop the background compile thread, dropping pending jobs.
+void JitManager::StopTieredCompilation()
+{
+    if (!mTieredThread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mTieredMutex);
+        mTieredExit = true;
+    }
+    mTieredCond.notify_one();
+    mTieredThread.join();
+}
 
 DIType*
 JitManager::CreateDebugStructType(StructType*                                          pType,
@@ -555,194 +745,81 @@ void JITCALL JitDestroyContext(HANDLE hJitContext)
 /// JitCache
 //////////////////////////////////////////////////////////////////////////
 
-//////////////////////////////////////////////////////////////////////////
-/// JitCacheFileHeader
-//////////////////////////////////////////////////////////////////////////
-struct JitCacheFileHeader
+int ExecUnhookedProcess(const std::string& CmdLine, std::string* pStdOut, std::string* pStdErr)
 {
-    void Init(uint32_t           llCRC,
-              uint32_t           objCRC,
-              const std::string& moduleID,
-              const std::string& cpu,
-              uint32_t           optLevel,
-              uint64_t           objSize)
-    {
-        m_objSize = objSize;
-        m_llCRC   = llCRC;
-        m_objCRC  = objCRC;
-        strncpy(m_ModuleID, moduleID.c_str(), JC_STR_MAX_LEN - 1);
-        m_ModuleID[JC_STR_MAX_LEN - 1] = 0;
-        strncpy(m_Cpu, cpu.c_str(), JC_STR_MAX_LEN - 1);
-        m_Cpu[JC_STR_MAX_LEN - 1] = 0;
-        m_optLevel                = optLevel;
-    }
-
-
-    bool
-    IsValid(uint32_t llCRC, const std::string& moduleID, const std::string& cpu, uint32_t optLevel)
-    {
-        if ((m_MagicNumber != JC_MAGIC_NUMBER) || (m_llCRC != llCRC) ||
-            (m_platformKey != JC_PLATFORM_KEY) || (m_optLevel != optLevel))
-        {
-            return false;
-        }
-
-        m_ModuleID[JC_STR_MAX_LEN - 1] = 0;
-        if (strncmp(moduleID.c_str(), m_ModuleID, JC_STR_MAX_LEN - 1))
-        {
-            return false;
-        }
 
-        m_Cpu[JC_STR_MAX_LEN - 1] = 0;
-        if (strncmp(cpu.c_str(), m_Cpu, JC_STR_MAX_LEN - 1))
-        {
-            return false;
-        }
-
-        return true;
-    }
+    return ExecCmd(CmdLine, nullptr, pStdOut, pStdErr);
+}
 
-    uint64_t GetObjectSize() const { return m_objSize; }
-    uint64_t GetObjectCRC() const { return m_objCRC; }
-
-private:
-    static const uint64_t JC_MAGIC_NUMBER = 0xfedcba9876543210ULL + 7;
-    static const size_t   JC_STR_MAX_LEN  = 32;
-    static const uint32_t JC_PLATFORM_KEY = (LLVM_VERSION_MAJOR << 24) |
-                                            (LLVM_VERSION_MINOR << 16) | (LLVM_VERSION_PATCH << 8) |
-                                            ((sizeof(void*) > sizeof(uint32_t)) ? 1 : 0);
-
-    uint64_t m_MagicNumber              = JC_MAGIC_NUMBER;
-    uint64_t m_objSize                  = 0;
-    uint32_t m_llCRC                    = 0;
-    uint32_t m_platformKey              = JC_PLATFORM_KEY;
-    uint32_t m_objCRC                   = 0;
-    uint32_t m_optLevel                 = 0;
-    char     m_ModuleID[JC_STR_MAX_LEN] = {};
-    char     m_Cpu[JC_STR_MAX_LEN]      = {};
-};
-
-static inline uint32_t ComputeModuleCRC(const llvm::Module* M)
+static inline void ComputeModuleKey(struct disk_cache* pCache,
+                                    const llvm::Module* M,
+                                    cache_key           key)
 {
     std::string        bitcodeBuffer;
     raw_string_ostream bitcodeStream(bitcodeBuffer);
 
+    // The identifier isn't part of the bitcode
+    bitcodeStream << M->getModuleIdentifier();
+    bitcodeStream << '\0';
+
 #if LLVM_VERSION_MAJOR >= 7
     llvm::WriteBitcodeToFile(*M, bitcodeStream);
 #else
     llvm::WriteBitcodeToFile(M, bitcodeStream);
 #endif
-    // M->print(bitcodeStream, nullptr, false);
 
     bitcodeStream.flush();
 
-    return ComputeCRC(0, bitcodeBuffer.data(), bitcodeBuffer.size());
+    disk_cache_compute_key(pCache, bitcodeBuffer.data(), bitcodeBuffer.size(), key);
 }
 
-/// constructor
-JitCache::JitCache()
+/// Initialize the cache for the given target cpu and optimization level.
+void JitCache::Init(JitManager* pJitMgr, const llvm::StringRef& cpu, llvm::CodeGenOpt::Level level)
 {
-#if defined(__APPLE__) || defined(FORCE_LINUX) || defined(__linux__) || defined(__gnu_linux__)
-    if (strncmp(KNOB_JIT_CACHE_DIR.c_str(), "~/", 2) == 0)
-    {
-        char* homedir;
-        if (!(homedir = getenv("HOME")))
-        {
-            homedir = getpwuid(getuid())->pw_dir;
-        }
-        mCacheDir = homedir;
-        mCacheDir += (KNOB_JIT_CACHE_DIR.c_str() + 1);
-    }
-    else
-#endif
-    {
-        mCacheDir = KNOB_JIT_CACHE_DIR;
-    }
+    mCpu      = cpu.str();
+    mpJitMgr  = pJitMgr;
+    mOptLevel = level;
+
+    // Objects from a different driver build, LLVM or target are never
+    // valid, so make them part of the cache id instead of each key.
+    struct mesa_sha1 ctx;
+    uint8_t          sha1[20];
+    char             cacheId[20 * 2 + 1];
 
-    // Create cache dir at startup to allow jitter to write debug.ll files
-    // to that directory.
-    if (!llvm::sys::fs::exists(mCacheDir.str()) &&
-        llvm::sys::fs::create_directories(mCacheDir.str()))
+    _mesa_sha1_init(&ctx);
+    if (!disk_cache_get_function_identifier((void*)JitCreateContext, &ctx))
     {
-        SWR_INVALID("Unable to create directory: %s", mCacheDir.c_str());
+        return;
     }
 
-}
-
-int ExecUnhookedProcess(const std::string& CmdLine, std::string* pStdOut, std::string* pStdErr)
-{
+    const uint32_t llvmVersion = (LLVM_VERSION_MAJOR << 24) | (LLVM_VERSION_MINOR << 16) |
+                                 (LLVM_VERSION_PATCH << 8);
+    const uint32_t optLevel    = mOptLevel;
+    _mesa_sha1_update(&ctx, &llvmVersion, sizeof(llvmVersion));
+    _mesa_sha1_update(&ctx, mCpu.c_str(), mCpu.size() + 1);
+    _mesa_sha1_update(&ctx, &optLevel, sizeof(optLevel));
+    _mesa_sha1_final(&ctx, sha1);
+    disk_cache_format_hex_id(cacheId, sha1, 20 * 2);
 
-    return ExecCmd(CmdLine, nullptr, pStdOut, pStdErr);
+    mpDiskCache = disk_cache_create("swr", cacheId, 0);
 }
 
-/// Calculate actual directory where module will be cached.
-/// This is always a subdirectory of mCacheDir.  Full absolute
-/// path name will be stored in mCurrentModuleCacheDir
-void JitCache::CalcModuleCacheDir()
+/// destructor
+JitCache::~JitCache()
 {
-    mModuleCacheDir.clear();
-
-    llvm::SmallString<MAX_PATH> moduleDir = mCacheDir;
-
-    // Create 4 levels of directory hierarchy based on CRC, 256 entries each
-    uint8_t* pCRC = (uint8_t*)&mCurrentModuleCRC;
-    for (uint32_t i = 0; i < 4; ++i)
-    {
-        llvm::sys::path::append(moduleDir, std::to_string((int)pCRC[i]));
-    }
-
-    mModuleCacheDir = moduleDir;
+    disk_cache_destroy(mpDiskCache);
 }
 
 /// notifyObjectCompiled - Provides a pointer to compiled code for Module M.
 void JitCache::notifyObjectCompiled(const llvm::Module* M, llvm::MemoryBufferRef Obj)
 {
-    const std::string& moduleID = M->getModuleIdentifier();
-    if (!moduleID.length())
-    {
-        return;
-    }
-
-    if (!mModuleCacheDir.size())
-    {
-        SWR_INVALID("Unset module cache directory");
-        return;
-    }
-
-    if (!llvm::sys::fs::exists(mModuleCacheDir.str()) &&
-        llvm::sys::fs::create_directories(mModuleCacheDir.str()))
+    if (!mHaveModuleKey)
     {
-        SWR_INVALID("Unable to create directory: %s", mModuleCacheDir.c_str());
         return;
     }
 
-    JitCacheFileHeader header;
-
-    llvm::SmallString<MAX_PATH> filePath = mModuleCacheDir;
-    llvm::sys::path::append(filePath, moduleID);
-
-    llvm::SmallString<MAX_PATH> objPath = filePath;
-    objPath += JIT_OBJ_EXT;
-
-    {
-        std::error_code      err;
-        llvm::raw_fd_ostream fileObj(objPath.c_str(), err, llvm::sys::fs::F_None);
-        fileObj << Obj.getBuffer();
-        fileObj.flush();
-    }
-
-
-    {
-        std::error_code      err;
-        llvm::raw_fd_ostream fileObj(filePath.c_str(), err, llvm::sys::fs::F_None);
-
-        uint32_t objcrc = ComputeCRC(0, Obj.getBufferStart(), Obj.getBufferSize());
-
-        header.Init(mCurrentModuleCRC, objcrc, moduleID, mCpu, mOptLevel, Obj.getBufferSize());
-
-        fileObj.write((const char*)&header, sizeof(header));
-        fileObj.flush();
-    }
+    disk_cache_put(mpDiskCache, mCurrentModuleKey, Obj.getBufferStart(), Obj.getBufferSize(), nullptr);
+    mHaveModuleKey = false;
 }
 
 /// Returns a pointer to a newly allocated MemoryBuffer that contains the
@@ -750,81 +827,26 @@ void JitCache::notifyObjectCompiled(const llvm::Module* M, llvm::MemoryBufferRef
 /// available.
 std::unique_ptr<llvm::MemoryBuffer> JitCache::getObject(const llvm::Module* M)
 {
-    const std::string& moduleID = M->getModuleIdentifier();
-    mCurrentModuleCRC           = ComputeModuleCRC(M);
-
-    if (!moduleID.length())
-    {
-        return nullptr;
-    }
-
-    CalcModuleCacheDir();
+    mHaveModuleKey = false;
 
-    if (!llvm::sys::fs::exists(mModuleCacheDir))
+    if (!mpDiskCache || !M->getModuleIdentifier().length())
     {
         return nullptr;
     }
 
-    llvm::SmallString<MAX_PATH> filePath = mModuleCacheDir;
-    llvm::sys::path::append(filePath, moduleID);
+    ComputeModuleKey(mpDiskCache, M, mCurrentModuleKey);
+    mHaveModuleKey = true;
 
-    llvm::SmallString<MAX_PATH> objFilePath = filePath;
-    objFilePath += JIT_OBJ_EXT;
-
-    FILE* fpObjIn = nullptr;
-    FILE* fpIn    = fopen(filePath.c_str(), "rb");
-    if (!fpIn)
+    size_t size;
+    void*  pData = disk_cache_get(mpDiskCache, mCurrentModuleKey, &size);
+    if (!pData)
     {
         return nullptr;
     }
 
-    std::unique_ptr<llvm::MemoryBuffer> pBuf = nullptr;
-    do
-    {
-        JitCacheFileHeader header;
-        if (!fread(&header, sizeof(header), 1, fpIn))
-        {
-            break;
-        }
-
-        if (!header.IsValid(mCurrentModuleCRC, moduleID, mCpu, mOptLevel))
-        {
-            break;
-        }
-
-        fpObjIn = fopen(objFilePath.c_str(), "rb");
-        if (!fpObjIn)
-        {
-            break;
-        }
-
-#if LLVM_VERSION_MAJOR < 6
-        pBuf = llvm::MemoryBuffer::getNewUninitMemBuffer(size_t(header.GetObjectSize()));
-#else
-        pBuf = llvm::WritableMemoryBuffer::getNewUninitMemBuffer(size_t(header.GetObjectSize()));
-#endif
-        if (!fread(const_cast<char*>(pBuf->getBufferStart()), header.GetObjectSize(), 1, fpObjIn))
-        {
-            pBuf = nullptr;
-            break;
-        }
-
-        if (header.GetObjectCRC() != ComputeCRC(0, pBuf->getBufferStart(), pBuf->getBufferSize()))
-        {
-            SWR_TRACE("Invalid object cache file, ignoring: %s", filePath.c_str());
-            pBuf = nullptr;
-            break;
-        }
-
-    } while (0);
-
-    fclose(fpIn);
-
-    if (fpObjIn)
-    {
-        fclose(fpObjIn);
-    }
-
+    std::unique_ptr<llvm::MemoryBuffer> pBuf =
+        llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef((const char*)pData, size));
+    free(pData);
 
     return pBuf;
 }
@@ -33,6 +33,10 @@
 #include "common/isa.hpp"
 #include <llvm/IR/AssemblyAnnotationWriter.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
 
 //////////////////////////////////////////////////////////////////////////
 /// JitInstructionSet
@@ -86,21 +90,23 @@ struct JitLLVMContext : llvm::LLVMContext
 
 //////////////////////////////////////////////////////////////////////////
 /// JitCache
+/// @brief Object cache for the jitted modules, stored in the mesa shader
+///        disk cache so that it is shared between processes and bounded
+///        in size.  Entries are keyed by the module bitcode, which is
+///        generated from the state the module was compiled for, and the
+///        cache itself is specific to the driver build, LLVM version,
+///        target cpu and optimization level.
 //////////////////////////////////////////////////////////////////////////
 struct JitManager; // Forward Decl
+struct disk_cache; // Forward Decl
 class JitCache : public llvm::ObjectCache
 {
 public:
     /// constructor
-    JitCache();
-    virtual ~JitCache() {}
+    JitCache() {}
+    virtual ~JitCache();
 
-    void Init(JitManager* pJitMgr, const llvm::StringRef& cpu, llvm::CodeGenOpt::Level level)
-    {
-        mCpu      = cpu.str();
-        mpJitMgr  = pJitMgr;
-        mOptLevel = level;
-    }
+    void Init(JitManager* pJitMgr, const llvm::StringRef& cpu, llvm::CodeGenOpt::Level level);
 
     /// notifyObjectCompiled - Provides a pointer to compiled code for Module M.
     void notifyObjectCompiled(const llvm::Module* M, llvm::MemoryBufferRef Obj) override;
@@ -110,20 +116,20 @@ public:
     /// available.
     std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* M) override;
 
-    const char* GetModuleCacheDir() { return mModuleCacheDir.c_str(); }
+    /// Disk cache backing the object cache, also used for the shaders
+    /// compiled through gallivm.  nullptr if caching is disabled.
+    struct disk_cache* GetDiskCache() { return mpDiskCache; }
 
 private:
-    std::string                 mCpu;
-    llvm::SmallString<MAX_PATH> mCacheDir;
-    llvm::SmallString<MAX_PATH> mModuleCacheDir;
-    uint32_t                    mCurrentModuleCRC = 0;
-    JitManager*                 mpJitMgr          = nullptr;
-    llvm::CodeGenOpt::Level     mOptLevel         = llvm::CodeGenOpt::None;
-
-    /// Calculate actual directory where module will be cached.
-    /// This is always a subdirectory of mCacheDir.  Full absolute
-    /// path name will be stored in mCurrentModuleCacheDir
-    void CalcModuleCacheDir();
+    std::string             mCpu;
+    JitManager*             mpJitMgr    = nullptr;
+    llvm::CodeGenOpt::Level mOptLevel   = llvm::CodeGenOpt::None;
+    struct disk_cache*      mpDiskCache = nullptr;
+
+    /// Key of the module last passed to getObject, used to store the
+    /// object of that module if it had to be compiled.
+    uint8_t mCurrentModuleKey[20] = {};
+    bool    mHaveModuleKey        = false;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -134,6 +140,8 @@ struct JitManager
     JitManager(uint32_t w, const char* arch, const char* core);
     ~JitManager()
     {
+        StopTieredCompilation();
+
         for (auto* pExec : mvExecEngines)
         {
             delete pExec;
@@ -165,9 +173,35 @@ struct JitManager
     // Debugging support
     std::unordered_map<llvm::StructType*, llvm::DIType*> mDebugStructMap;
 
+    // Tiered compilation: functions are first jitted without codegen
+    // optimizations and called through a stub, the optimized version is
+    // compiled on a background thread and swapped in once it is ready.
+    struct TieredJob
+    {
+        std::string         moduleId;
+        std::string         bitcode;
+        std::string         funcName;
+        std::atomic<void*>* pTarget;
+    };
+
+    bool                                            mTieredCompilation = false;
+    std::deque<std::unique_ptr<std::atomic<void*>>> mTieredTargets;
+    std::deque<TieredJob>                           mTieredJobs;
+    std::mutex                                      mTieredMutex;
+    std::condition_variable                         mTieredCond;
+    std::thread                                     mTieredThread;
+    bool                                            mTieredExit = false;
+
     void CreateExecEngine(std::unique_ptr<llvm::Module> M);
     void SetupNewModule();
 
+    void* GetFunctionAddress(const llvm::Function* pFunction);
+
+    llvm::Function* CreateTieredStub(const llvm::Function* pFunction,
+                                     std::atomic<void*>*   pTarget);
+    void            TieredCompileThread();
+    void            StopTieredCompilation();
+
     void               DumpAsm(llvm::Function* pFunction, const char* fileName);
     static void        DumpToFile(llvm::Function* f, const char* fileName);
     static void        DumpToFile(llvm::Module*                   M,
@@ -898,7 +898,7 @@ PFN_BLEND_JIT_FUNC JitBlendFunc(HANDLE hJitMgr, const HANDLE hFunc)
     const llvm::Function* func    = (const llvm::Function*)hFunc;
     JitManager*           pJitMgr = reinterpret_cast<JitManager*>(hJitMgr);
     PFN_BLEND_JIT_FUNC    pfnBlend;
-    pfnBlend = (PFN_BLEND_JIT_FUNC)(pJitMgr->mpExec->getFunctionAddress(func->getName().str()));
+    pfnBlend = (PFN_BLEND_JIT_FUNC)(pJitMgr->GetFunctionAddress(func));
     // MCJIT finalizes modules the first time you JIT code from them. After finalized, you cannot
     // add new IR to the module
     pJitMgr->mIsModuleFinalized = true;
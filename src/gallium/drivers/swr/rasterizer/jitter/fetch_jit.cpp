@@ -106,6 +106,12 @@ struct FetchJit : public BuilderGfxMem
                            Value*                     vIndices,
                            Value*                     pVtxOut);
 
+    Value* IsSequentialFetch(Value* vIndices, Value* vMask);
+    void   JitLoadSequentialVertices(Value*   xpVertex,
+                                     Value*   stride,
+                                     uint32_t numComps,
+                                     Value*   result[4]);
+
     bool IsOddFormat(SWR_FORMAT format);
     bool IsUniformFormat(SWR_FORMAT format);
     void UnpackComponents(SWR_FORMAT format, Value* vInput, Value* result[4]);
@@ -532,6 +538,85 @@ void FetchJit::ConvertFormat(SWR_FORMAT format, Value* texels[4])
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Checks at runtime whether a SIMD of vertices can be fetched with
+///        contiguous loads instead of gathers
+/// @param vIndices - vector of vertex indices
+/// @param vMask - vector of lanes that are in bounds
+/// @return i1 that is true if all lanes are in bounds and the indices are
+///         consecutive, starting at the index of lane 0
+Value* FetchJit::IsSequentialFetch(Value* vIndices, Value* vMask)
+{
+    std::vector<uint32_t> laneOffsets;
+    for (uint32_t lane = 0; lane < mVWidth; ++lane)
+    {
+        laneOffsets.push_back(lane);
+    }
+
+    Value* vSequential = ADD(VBROADCAST(VEXTRACT(vIndices, C(0))), C(laneOffsets));
+    Value* vValid      = AND(ICMP_EQ(vIndices, vSequential), vMask);
+
+    return ICMP_EQ(VMOVMSK(vValid), C((uint32_t)((1ULL << mVWidth) - 1)));
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Loads the 32bpc float components of a SIMD of consecutive vertices,
+///        with one load per vertex, and transposes them into one SIMD per
+///        component
+/// @param xpVertex - gfx address of the element in the first vertex
+/// @param stride - vertex stride in bytes
+/// @param numComps - number of components of the element format
+/// @param result - SIMD per component, only the first numComps are written
+void FetchJit::JitLoadSequentialVertices(Value*   xpVertex,
+                                         Value*   stride,
+                                         uint32_t numComps,
+                                         Value*   result[4])
+{
+    // the vertex elements aren't necessarily 16 byte aligned, and for less
+    // than 4 components the masked off lanes must not touch memory
+    Type*  pVertexTy = PointerType::get(getVectorType(mFP32Ty, 4), 0);
+    Value* vLoadMask = C<bool>({true, numComps > 1, numComps > 2, numComps > 3});
+    Value* stride64  = Z_EXT(stride, mInt64Ty);
+
+    std::vector<Value*> vVertices;
+    for (uint32_t lane = 0; lane < mVWidth; ++lane)
+    {
+        Value* xpLane = ADD(xpVertex, MUL(stride64, C((int64_t)lane)));
+        vVertices.push_back(MASKED_LOAD(
+            xpLane, 4, vLoadMask, nullptr, "", pVertexTy, MEM_CLIENT::GFX_MEM_CLIENT_FETCH));
+    }
+
+    // concatenate the vertices into one xyzw xyzw ... vector
+    uint32_t numElts = 4;
+    while (vVertices.size() > 1)
+    {
+        std::vector<uint32_t> concat;
+        for (uint32_t i = 0; i < 2 * numElts; ++i)
+        {
+            concat.push_back(i);
+        }
+
+        std::vector<Value*> vMerged;
+        for (uint32_t i = 0; i < vVertices.size(); i += 2)
+        {
+            vMerged.push_back(VSHUFFLE(vVertices[i], vVertices[i + 1], C(concat)));
+        }
+        vVertices = vMerged;
+        numElts *= 2;
+    }
+
+    // and pick every 4th element for each component
+    for (uint32_t c = 0; c < numComps; ++c)
+    {
+        std::vector<uint32_t> transpose;
+        for (uint32_t lane = 0; lane < mVWidth; ++lane)
+        {
+            transpose.push_back(lane * 4 + c);
+        }
+        result[c] = VSHUFFLE(vVertices[0], vVertices[0], C(transpose));
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Loads attributes from memory using AVX2 GATHER(s)
 /// @param fetchState - info about attributes to be fetched from memory
@@ -793,33 +878,100 @@ void FetchJit::JitGatherVertices(const FETCH_COMPILE_STATE& fetchState,
             break;
             case 32:
             {
+                Value* vComponents[4] = {nullptr, nullptr, nullptr, nullptr};
+
+                // Consecutive, fully in bounds vertices don't need gathers. Load
+                // each vertex with a single load and transpose in registers instead.
+                bool bSequentialLoad = !ied.InstanceEnable && !ied.InstanceStrideEnable;
+                bool bStoreSrc       = false;
                 for (uint32_t i = 0; i < 4; i += 1)
                 {
-                    if (isComponentEnabled(compMask, i))
+                    if (isComponentEnabled(compMask, i) && compCtrl[i] == StoreSrc)
                     {
-                        // if we need to gather the component
-                        if (compCtrl[i] == StoreSrc)
+                        bStoreSrc = true;
+                        if (i >= info.numComps)
                         {
-                            // Gather a SIMD of vertices
-                            // APIs allow a 4GB range for offsets
-                            // However, GATHERPS uses signed 32-bit offsets, so +/- 2GB range :(
-                            // Add 2GB to the base pointer and 2GB to the offsets.  This makes
-                            // "negative" (large) offsets into positive offsets and small offsets
-                            // into negative offsets.
-                            Value* vNewOffsets = ADD(vOffsets, VIMMED1(0x80000000));
-                            vVertexElements[currentVertexElement++] =
-                                GATHERPS(gatherSrc,
-                                         ADD(pStreamBaseGFX, C((uintptr_t)0x80000000U)),
-                                         vNewOffsets,
-                                         vGatherMask,
-                                         1,
-                                         MEM_CLIENT::GFX_MEM_CLIENT_FETCH);
+                            bSequentialLoad = false;
                         }
-                        else
+                    }
+                }
+                bSequentialLoad = bSequentialLoad && bStoreSrc;
+
+                Value*      vSequentialComps[4] = {nullptr, nullptr, nullptr, nullptr};
+                BasicBlock* pSequentialEndBB = nullptr;
+                BasicBlock* pEndFetchBB      = nullptr;
+                if (bSequentialLoad)
+                {
+                    BasicBlock* pCurrentBB = IRB()->GetInsertBlock();
+                    BasicBlock* pSequentialBB =
+                        BasicBlock::Create(JM()->mContext, "SequentialFetch", pCurrentBB->getParent());
+                    BasicBlock* pGatherBB =
+                        BasicBlock::Create(JM()->mContext, "GatherFetch", pCurrentBB->getParent());
+                    pEndFetchBB =
+                        BasicBlock::Create(JM()->mContext, "EndFetch", pCurrentBB->getParent());
+
+                    COND_BR(IsSequentialFetch(vCurIndices, vGatherMask), pSequentialBB, pGatherBB);
+
+                    JM()->mBuilder.SetInsertPoint(pSequentialBB);
+                    Value* firstVertex = Z_EXT(VEXTRACT(vCurIndices, C(0)), mInt64Ty);
+                    Value* xpVertex    = ADD(pStreamBaseGFX, MUL(firstVertex, Z_EXT(stride, mInt64Ty)));
+                    xpVertex           = ADD(xpVertex, C((int64_t)ied.AlignedByteOffset));
+                    JitLoadSequentialVertices(xpVertex, stride, info.numComps, vSequentialComps);
+                    pSequentialEndBB = IRB()->GetInsertBlock();
+                    BR(pEndFetchBB);
+
+                    JM()->mBuilder.SetInsertPoint(pGatherBB);
+                }
+
+                for (uint32_t i = 0; i < 4; i += 1)
+                {
+                    // if we need to gather the component
+                    if (isComponentEnabled(compMask, i) && compCtrl[i] == StoreSrc)
+                    {
+                        // Gather a SIMD of vertices
+                        // APIs allow a 4GB range for offsets
+                        // However, GATHERPS uses signed 32-bit offsets, so +/- 2GB range :(
+                        // Add 2GB to the base pointer and 2GB to the offsets.  This makes
+                        // "negative" (large) offsets into positive offsets and small offsets
+                        // into negative offsets.
+                        Value* vNewOffsets = ADD(vOffsets, VIMMED1(0x80000000));
+                        vComponents[i] = GATHERPS(gatherSrc,
+                                                  ADD(pStreamBaseGFX, C((uintptr_t)0x80000000U)),
+                                                  vNewOffsets,
+                                                  vGatherMask,
+                                                  1,
+                                                  MEM_CLIENT::GFX_MEM_CLIENT_FETCH);
+                    }
+
+                    // offset base to the next component in the vertex to gather
+                    pStreamBaseGFX = ADD(pStreamBaseGFX, C((int64_t)4));
+                }
+
+                if (bSequentialLoad)
+                {
+                    BasicBlock* pGatherEndBB = IRB()->GetInsertBlock();
+                    BR(pEndFetchBB);
+
+                    JM()->mBuilder.SetInsertPoint(pEndFetchBB);
+                    for (uint32_t i = 0; i < 4; i += 1)
+                    {
+                        if (vComponents[i])
                         {
-                            vVertexElements[currentVertexElement++] =
-                                GenerateCompCtrlVector(compCtrl[i]);
+                            PHINode* pComponentPhi = PHI(mSimdFP32Ty, 2);
+                            pComponentPhi->addIncoming(vSequentialComps[i], pSequentialEndBB);
+                            pComponentPhi->addIncoming(vComponents[i], pGatherEndBB);
+                            vComponents[i] = pComponentPhi;
                         }
+                    }
+                }
+
+                for (uint32_t i = 0; i < 4; i += 1)
+                {
+                    if (isComponentEnabled(compMask, i))
+                    {
+                        vVertexElements[currentVertexElement++] =
+                            compCtrl[i] == StoreSrc ? vComponents[i]
+                                                    : GenerateCompCtrlVector(compCtrl[i]);
 
                         if (currentVertexElement > 3)
                         {
@@ -828,9 +980,6 @@ void FetchJit::JitGatherVertices(const FETCH_COMPILE_STATE& fetchState,
                             currentVertexElement = 0;
                         }
                     }
-
-                    // offset base to the next component in the vertex to gather
-                    pStreamBaseGFX = ADD(pStreamBaseGFX, C((int64_t)4));
                 }
             }
             break;
@@ -2294,7 +2443,7 @@ PFN_FETCH_FUNC JitFetchFunc(HANDLE hJitMgr, const HANDLE hFunc)
     PFN_FETCH_FUNC        pfnFetch;
 
     gFetchCodegenMutex.lock();
-    pfnFetch = (PFN_FETCH_FUNC)(pJitMgr->mpExec->getFunctionAddress(func->getName().str()));
+    pfnFetch = (PFN_FETCH_FUNC)(pJitMgr->GetFunctionAddress(func));
     // MCJIT finalizes modules the first time you JIT code from them. After finalized, you cannot
     // add new IR to the module
     pJitMgr->mIsModuleFinalized = true;
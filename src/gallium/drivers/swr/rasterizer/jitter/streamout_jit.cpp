@@ -176,6 +176,98 @@ struct StreamOutJit : public BuilderGfxMem
         }
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    // @brief number of dwords streamed per vertex to the given buffer, or 0 if
+    //        the buffer has holes, which must leave the buffer contents untouched
+    uint32_t packedVertexSize(const STREAMOUT_STREAM& streamState, uint32_t buffer)
+    {
+        uint32_t numDwords = 0;
+        for (uint32_t d = 0; d < streamState.numDecls; ++d)
+        {
+            const STREAMOUT_DECL& decl = streamState.decl[d];
+            if (decl.bufferIndex != buffer)
+            {
+                continue;
+            }
+            if (decl.hole)
+            {
+                return 0;
+            }
+            numDwords += _mm_popcnt_u32(decl.componentMask);
+        }
+        return numDwords;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // @brief writes all the vertices of the prim to a buffer whose pitch is the
+    //        packed vertex size, so they form one contiguous run of dwords.
+    //        The run is assembled in registers and written with full SIMD
+    //        width stores, only the last one is masked.
+    // @param pStreamData - pointer to the src stream data of the first vertex
+    // @param pOutBuffer - pointer to the buffer location of the first vertex
+    void buildPackedBuffer(const STREAMOUT_COMPILE_STATE& state,
+                           Value*                         pStreamData,
+                           Value*                         pOutBuffer,
+                           uint32_t                       buffer)
+    {
+        const STREAMOUT_STREAM& streamState = state.stream;
+        Type*                   simd4Ty     = getVectorType(IRB()->getFloatTy(), 4);
+        Type*                   chunkTy     = getVectorType(IRB()->getFloatTy(), mVWidth);
+
+        // gather the components in output order, loading each attrib once
+        std::vector<Value*> components;
+        for (uint32_t v = 0; v < state.numVertsPerPrim; ++v)
+        {
+            for (uint32_t d = 0; d < streamState.numDecls; ++d)
+            {
+                const STREAMOUT_DECL& decl = streamState.decl[d];
+                if (decl.bufferIndex != buffer)
+                {
+                    continue;
+                }
+
+                Value* pAttrib = GEP(pStreamData, C(4 * decl.attribSlot));
+                Value* vattrib = LOAD(BITCAST(pAttrib, PointerType::get(simd4Ty, 0)));
+
+                unsigned long comp;
+                uint32_t      mask = decl.componentMask;
+                while (_BitScanForward(&comp, mask))
+                {
+                    components.push_back(VEXTRACT(vattrib, C((int)comp)));
+                    mask &= ~(1 << comp);
+                }
+            }
+
+            // stream verts are always 32*4 dwords apart
+            pStreamData = GEP(pStreamData, C(SWR_VTX_NUM_SLOTS * 4));
+        }
+
+        for (uint32_t base = 0; base < components.size(); base += mVWidth)
+        {
+            uint32_t numElems = std::min<uint32_t>(mVWidth, components.size() - base);
+
+            Value*                 chunk = VUNDEF(IRB()->getFloatTy(), mVWidth);
+            std::vector<Constant*> mask;
+            for (uint32_t e = 0; e < mVWidth; ++e)
+            {
+                if (e < numElems)
+                {
+                    chunk = VINSERT(chunk, components[base + e], C(e));
+                }
+                mask.push_back(C(e < numElems));
+            }
+
+            // a masked store with an all set mask becomes a plain unaligned store
+            Value* pOut = BITCAST(GEP(pOutBuffer, C(base)), PointerType::get(chunkTy, 0));
+            MASKED_STORE(chunk,
+                         pOut,
+                         4,
+                         ConstantVector::get(mask),
+                         PointerType::get(chunkTy, 0),
+                         MEM_CLIENT::GFX_MEM_CLIENT_STREAMOUT);
+        }
+    }
+
     void buildStream(const STREAMOUT_COMPILE_STATE& state,
                      const STREAMOUT_STREAM&        streamState,
                      Value*                         pSoCtx,
@@ -229,8 +321,39 @@ struct StreamOutJit : public BuilderGfxMem
             outBufferPitch[b] = LOAD(pBuf, {0, SWR_STREAMOUT_BUFFER_pitch});
         }
 
-        // loop over the vertices of the prim
         Value* pStreamData = LOAD(pSoCtx, {0, SWR_STREAMOUT_CONTEXT_pPrimData});
+
+        // When every buffer of the prim has no holes and a pitch of exactly the
+        // packed vertex size, its vertices are contiguous and are written as a
+        // whole instead of one masked store per decl and vertex.
+        bool   canPack = true;
+        Value* isPacked = C(true);
+        for (uint32_t b : activeSOBuffers)
+        {
+            uint32_t vertexSize = packedVertexSize(streamState, b);
+            canPack &= vertexSize != 0;
+            isPacked = AND(isPacked, ICMP_EQ(outBufferPitch[b], C(vertexSize)));
+        }
+
+        BasicBlock* doneBB = nullptr;
+        if (canPack)
+        {
+            BasicBlock* packedBB    = BasicBlock::Create(JM()->mContext, "packed", soFunc);
+            BasicBlock* scatteredBB = BasicBlock::Create(JM()->mContext, "scattered", soFunc);
+            doneBB                  = BasicBlock::Create(JM()->mContext, "written", soFunc);
+            COND_BR(isPacked, packedBB, scatteredBB);
+
+            IRB()->SetInsertPoint(packedBB);
+            for (uint32_t b : activeSOBuffers)
+            {
+                buildPackedBuffer(state, pStreamData, pOutBuffer[b], b);
+            }
+            BR(doneBB);
+
+            IRB()->SetInsertPoint(scatteredBB);
+        }
+
+        // loop over the vertices of the prim
         for (uint32_t v = 0; v < state.numVertsPerPrim; ++v)
         {
             buildVertex(streamState, pStreamData, pOutBuffer);
@@ -247,6 +370,12 @@ struct StreamOutJit : public BuilderGfxMem
             }
         }
 
+        if (doneBB)
+        {
+            BR(doneBB);
+            IRB()->SetInsertPoint(doneBB);
+        }
+
         // update each active buffer's streamOffset
         for (uint32_t b : activeSOBuffers)
         {
@@ -341,7 +470,7 @@ PFN_SO_FUNC JitStreamoutFunc(HANDLE hJitMgr, const HANDLE hFunc)
     llvm::Function* func    = (llvm::Function*)hFunc;
     JitManager*     pJitMgr = reinterpret_cast<JitManager*>(hJitMgr);
     PFN_SO_FUNC     pfnStreamOut;
-    pfnStreamOut = (PFN_SO_FUNC)(pJitMgr->mpExec->getFunctionAddress(func->getName().str()));
+    pfnStreamOut = (PFN_SO_FUNC)(pJitMgr->GetFunctionAddress(func));
     // MCJIT finalizes modules the first time you JIT code from them. After finalized, you cannot
     // add new IR to the module
     pJitMgr->mIsModuleFinalized = true;
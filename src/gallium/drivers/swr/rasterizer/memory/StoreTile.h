@@ -1817,6 +1817,108 @@ struct StoreMacroTile
 
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Whether the macrotile can be stored with StoreStreaming.
+    /// @param pDstSurface - Destination surface state
+    /// @param x, y - Coordinates to macro tile
+    /// @param dstSurfAddress - Address of the lod and slice of the macro tile
+    static bool CanStoreStreaming(
+        const SWR_SURFACE_STATE* pDstSurface,
+        uint32_t x, uint32_t y, size_t dstSurfAddress)
+    {
+        // R24_UNORM_X8 stores merge with the stencil bits of the destination
+        if (TTraits::TileMode != SWR_TILE_NONE || FormatTraits<DstFormat>::bpp != 32 ||
+            DstFormat == R24_UNORM_X8_TYPELESS ||
+            !pDstSurface->bStreamingStores || pDstSurface->numSamples != 1 ||
+            pDstSurface->bInterleavedSamples || pDstSurface->xpAuxBaseAddress ||
+            KNOB_USE_GENERIC_STORETILE)
+        {
+            return false;
+        }
+
+        uint32_t lodWidth = std::max(pDstSurface->width >> pDstSurface->lod, 1U);
+        uint32_t lodHeight = std::max(pDstSurface->height >> pDstSurface->lod, 1U);
+
+        if (x + KNOB_MACROTILE_X_DIM > lodWidth || y + KNOB_MACROTILE_Y_DIM > lodHeight)
+        {
+            return false;
+        }
+
+        // Each row of the macro tile has to start on a simd16 boundary
+        size_t dstAddress = dstSurfAddress + x * (FormatTraits<DstFormat>::bpp / 8);
+        return ((dstAddress | pDstSurface->pitch) & (KNOB_SIMD16_BYTES - 1)) == 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Stores a full, unsampled macrotile to a linear 32bpp surface.
+    ///        Each band of raster tiles is converted into a small buffer that
+    ///        stays in the cache and then written with non-temporal stores,
+    ///        so whole cache lines are written without reading them first
+    ///        and without evicting the hot tiles.
+    /// @param pSrc - Pointer to macro tile.
+    /// @param pDstSurface - Destination surface state
+    /// @param x, y - Coordinates to macro tile
+    static void StoreStreaming(
+        uint8_t *pSrcHotTile,
+        SWR_SURFACE_STATE* pDstSurface,
+        uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex)
+    {
+        static const size_t SRC_BYTES_PER_PIXEL = FormatTraits<SrcFormat>::bpp / 8;
+        static const size_t DST_BYTES_PER_PIXEL = FormatTraits<DstFormat>::bpp / 8;
+        static const uint32_t BAND_PITCH = KNOB_MACROTILE_X_DIM * DST_BYTES_PER_PIXEL;
+
+        static_assert(BAND_PITCH % KNOB_SIMD16_BYTES == 0, "Invalid macrotile x dim");
+
+        OSALIGNSIMD16(uint8_t) band[BAND_PITCH * KNOB_TILE_Y_DIM];
+
+        uint8_t *pDst = (uint8_t*)ComputeSurfaceAddress<false, false>(x, y, pDstSurface->arrayIndex + renderTargetArrayIndex,
+            pDstSurface->arrayIndex + renderTargetArrayIndex, 0, pDstSurface->lod, pDstSurface);
+
+        const uint32_t dx = SIMD16_TILE_X_DIM * DST_BYTES_PER_PIXEL;
+
+        for (uint32_t row = 0; row < KNOB_MACROTILE_Y_DIM; row += KNOB_TILE_Y_DIM)
+        {
+            // Convert the raster tiles of this band to the surface format
+            for (uint32_t col = 0; col < KNOB_MACROTILE_X_DIM; col += KNOB_TILE_X_DIM)
+            {
+                for (uint32_t yy = 0; yy < KNOB_TILE_Y_DIM; yy += SIMD16_TILE_Y_DIM)
+                {
+                    for (uint32_t xx = 0; xx < KNOB_TILE_X_DIM; xx += SIMD16_TILE_X_DIM)
+                    {
+                        uint8_t *pBand = &band[yy * BAND_PITCH + (col + xx) * DST_BYTES_PER_PIXEL];
+                        uint8_t* ppDsts[] =
+                        {
+                            pBand,                                  // row 0, col 0
+                            pBand + BAND_PITCH,                     // row 1, col 0
+                            pBand + dx / 2,                         // row 0, col 1
+                            pBand + BAND_PITCH + dx / 2             // row 1, col 1
+                        };
+
+                        ConvertPixelsSOAtoAOS<SrcFormat, DstFormat>::Convert(pSrcHotTile, ppDsts);
+
+                        pSrcHotTile += KNOB_SIMD16_WIDTH * SRC_BYTES_PER_PIXEL;
+                    }
+                }
+            }
+
+            // Stream the band to the surface
+            for (uint32_t yy = 0; yy < KNOB_TILE_Y_DIM; ++yy)
+            {
+                const float *pBandRow = reinterpret_cast<const float*>(&band[yy * BAND_PITCH]);
+                float *pDstRow = reinterpret_cast<float*>(pDst + (row + yy) * pDstSurface->pitch);
+
+                for (uint32_t i = 0; i < BAND_PITCH / sizeof(float); i += KNOB_SIMD16_WIDTH)
+                {
+                    SIMD512::stream_ps(pDstRow + i, SIMD512::load_ps(pBandRow + i));
+                }
+            }
+        }
+
+        // Streaming stores are weakly ordered, make them visible before the
+        // tile is reported as resolved
+        _mm_sfence();
+    }
+
     typedef void(*PFN_STORE_TILES_INTERNAL)(uint8_t*, SWR_SURFACE_STATE*, uint32_t, uint32_t, uint32_t, uint32_t);
     //////////////////////////////////////////////////////////////////////////
     /// @brief Stores a macrotile to the destination surface.
@@ -1846,6 +1948,11 @@ struct StoreMacroTile
                 (pDstSurface->bInterleavedSamples);
 
             pfnStore[sampleNum] = (bForceGeneric || KNOB_USE_GENERIC_STORETILE) ? StoreRasterTile<TTraits, SrcFormat, DstFormat>::Store : OptStoreRasterTile<TTraits, SrcFormat, DstFormat>::Store;
+
+            if (CanStoreStreaming(pDstSurface, x, y, dstSurfAddress))
+            {
+                return StoreStreaming(pSrcHotTile, pDstSurface, x, y, renderTargetArrayIndex);
+            }
         }
 
         // Save original for pSrcHotTile resolve.
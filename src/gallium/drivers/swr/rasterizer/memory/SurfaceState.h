@@ -63,4 +63,5 @@ struct SWR_SURFACE_STATE
 
 
     bool bInterleavedSamples; // are MSAA samples stored interleaved or planar
+    bool bStreamingStores;    // store tiles with non-temporal stores, for surfaces that aren't sampled
 };
\ No newline at end of file
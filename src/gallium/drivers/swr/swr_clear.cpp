@@ -24,6 +24,16 @@
 #include "swr_context.h"
 #include "swr_query.h"
 
+#include "util/u_math.h"
+
+static bool
+swr_surface_matches_fb(const struct pipe_surface *sf,
+                       const struct pipe_framebuffer_state *fb)
+{
+   return u_minify(sf->texture->width0, sf->u.tex.level) == fb->width &&
+          u_minify(sf->texture->height0, sf->u.tex.level) == fb->height;
+}
+
 static void
 swr_clear(struct pipe_context *pipe,
           unsigned buffers,
@@ -75,6 +85,21 @@ swr_clear(struct pipe_context *pipe,
     */
    SWR_RECT clear_rect = {0, 0, (int32_t)fb->width, (int32_t)fb->height};
 
+   /* The backend only defers the clears of macrotiles fully covered by the
+    * rect. When the cleared surfaces end with the framebuffer, the part of
+    * the edge macrotiles past it is never stored, so let the rect cover it
+    * too. */
+   bool aligned_rect = true;
+   for (unsigned i = 0; i < fb->nr_cbufs; ++i)
+      if (clearMask & (SWR_ATTACHMENT_COLOR0_BIT << i))
+         aligned_rect &= swr_surface_matches_fb(fb->cbufs[i], fb);
+   if (clearMask & (SWR_ATTACHMENT_DEPTH_BIT | SWR_ATTACHMENT_STENCIL_BIT))
+      aligned_rect &= swr_surface_matches_fb(fb->zsbuf, fb);
+   if (aligned_rect) {
+      clear_rect.xmax = align(clear_rect.xmax, KNOB_MACROTILE_X_DIM);
+      clear_rect.ymax = align(clear_rect.ymax, KNOB_MACROTILE_Y_DIM);
+   }
+
    for (unsigned i = 0; i < layers; ++i) {
       swr_update_draw_context(ctx);
       ctx->api.pfnSwrClearRenderTarget(ctx->swrContext, clearMask, i,
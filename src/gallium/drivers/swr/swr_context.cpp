@@ -472,6 +472,10 @@ swr_UpdateStatsFE(HANDLE hPrivateContext, const SWR_STATS_FE *pStats)
    p_atomic_add(&pSwrStats->CInvocations, pStats->CInvocations);
    p_atomic_add(&pSwrStats->CPrimitives, pStats->CPrimitives);
    p_atomic_add(&pSwrStats->GsPrimitives, pStats->GsPrimitives);
+   p_atomic_add(&pSwrStats->BinTrivialRejects, pStats->BinTrivialRejects);
+   p_atomic_add(&pSwrStats->BinSingleTileTris, pStats->BinSingleTileTris);
+   p_atomic_add(&pSwrStats->BinMultiTileTris, pStats->BinMultiTileTris);
+   p_atomic_add(&pSwrStats->StateCopyBytes, pStats->StateCopyBytes);
 
    for (unsigned i = 0; i < 4; i++) {
       p_atomic_add(&pSwrStats->SoPrimStorageNeeded[i],
@@ -707,6 +707,11 @@ swr_texture_layout(struct swr_screen *screen,
    res->swr.format = mesa_to_swr_format(fmt);
    res->swr.numSamples = std::max(1u, pt->nr_samples);
 
+   /* Surfaces that are never sampled are usually only read back or
+    * displayed, let the backend store their tiles without polluting the
+    * caches. */
+   res->swr.bStreamingStores = !(pt->bind & PIPE_BIND_SAMPLER_VIEW);
+
    if (pt->bind & (PIPE_BIND_RENDER_TARGET | PIPE_BIND_DEPTH_STENCIL)) {
       res->swr.halign = KNOB_MACROTILE_X_DIM;
       res->swr.valign = KNOB_MACROTILE_Y_DIM;
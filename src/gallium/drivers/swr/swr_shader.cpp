@@ -43,6 +43,7 @@
 #include "builder.h"
 #include "functionpasses/passes.h"
 
+#include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_strings.h"
 #include "util/format/u_format.h"
 #include "util/u_prim.h"
@@ -53,6 +54,7 @@
 #include "gallivm/lp_bld_const.h"
 #include "gallivm/lp_bld_printf.h"
 #include "gallivm/lp_bld_logic.h"
+#include "gallivm/lp_bld_misc.h"
 
 #include "swr_context.h"
 #include "gen_surf_state_llvm.h"
@@ -70,6 +72,8 @@
 #include "util/u_debug.h"
 #include "util/u_memory.h"
 #include "util/u_string.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
 
 #include "gallivm/lp_bld_type.h"
 
@@ -323,15 +327,45 @@ swr_generate_tes_key(struct swr_jit_tes_key &key,
 }
 
 struct BuilderSWR : public Builder {
-   BuilderSWR(JitManager *pJitMgr, const char *pName)
+   /* The object code of the variant is looked up in and stored to the disk
+    * cache of the jit manager, using the shader tokens and the variant key
+    * as the cache key. */
+   BuilderSWR(JitManager *pJitMgr, const char *pName,
+              const struct tgsi_token *tokens, const void *key,
+              size_t key_size)
       : Builder(pJitMgr)
    {
+      struct disk_cache *disk_cache = pJitMgr->mCache.GetDiskCache();
+      struct lp_cached_code *cache = NULL;
+
+      if (disk_cache) {
+         struct mesa_sha1 ctx;
+         unsigned char sha1[20];
+
+         _mesa_sha1_init(&ctx);
+         _mesa_sha1_update(&ctx, pName, strlen(pName) + 1);
+         _mesa_sha1_update(&ctx, tokens,
+                           tgsi_num_tokens(tokens) * sizeof(struct tgsi_token));
+         _mesa_sha1_update(&ctx, key, key_size);
+         _mesa_sha1_final(&ctx, sha1);
+         disk_cache_compute_key(disk_cache, sha1, sizeof(sha1), cached_key);
+
+         cached.data = disk_cache_get(disk_cache, cached_key, &cached.data_size);
+         if (!cached.data)
+            cached.data_size = 0;
+         needs_caching = !cached.data_size;
+         cache = &cached;
+      }
+
       pJitMgr->SetupNewModule();
-      gallivm = gallivm_create(pName, wrap(&JM()->mContext), NULL);
+      gallivm = gallivm_create(pName, wrap(&JM()->mContext), cache);
       pJitMgr->mpCurrentModule = unwrap(gallivm->module);
    }
 
    ~BuilderSWR() {
+      if (needs_caching && cached.data_size)
+         disk_cache_put(JM()->mCache.GetDiskCache(), cached_key,
+                        cached.data, cached.data_size, NULL);
       gallivm_free_ir(gallivm);
    }
 
@@ -339,6 +373,10 @@ struct BuilderSWR : public Builder {
                 unsigned slot, unsigned channel);
 
    struct gallivm_state *gallivm;
+   struct lp_cached_code cached = {};
+   cache_key cached_key;
+   bool needs_caching = false;
+
    PFN_VERTEX_FUNC CompileVS(struct swr_context *ctx, swr_jit_vs_key &key);
    PFN_PIXEL_KERNEL CompileFS(struct swr_context *ctx, swr_jit_fs_key &key);
    PFN_GS_FUNC CompileGS(struct swr_context *ctx, swr_jit_gs_key &key);
@@ -2257,7 +2295,7 @@ swr_compile_gs(struct swr_context *ctx, swr_jit_gs_key &key)
 {
    BuilderSWR builder(
       reinterpret_cast<JitManager *>(swr_screen(ctx->pipe.screen)->hJitMgr),
-      "GS");
+      "GS", ctx->gs->pipe.tokens, &key, sizeof(key));
    PFN_GS_FUNC func = builder.CompileGS(ctx, key);
 
    ctx->gs->map.insert(std::make_pair(key, std::unique_ptr<VariantGS>(new VariantGS(builder.gallivm, func))));
@@ -2269,7 +2307,7 @@ swr_compile_tcs(struct swr_context *ctx, swr_jit_tcs_key &key)
 {
    BuilderSWR builder(
       reinterpret_cast<JitManager *>(swr_screen(ctx->pipe.screen)->hJitMgr),
-      "TCS");
+      "TCS", ctx->tcs->pipe.tokens, &key, sizeof(key));
    PFN_TCS_FUNC func = builder.CompileTCS(ctx, key);
 
    ctx->tcs->map.insert(
@@ -2283,7 +2321,7 @@ swr_compile_tes(struct swr_context *ctx, swr_jit_tes_key &key)
 {
    BuilderSWR builder(
       reinterpret_cast<JitManager *>(swr_screen(ctx->pipe.screen)->hJitMgr),
-      "TES");
+      "TES", ctx->tes->pipe.tokens, &key, sizeof(key));
    PFN_TES_FUNC func = builder.CompileTES(ctx, key);
 
    ctx->tes->map.insert(
@@ -2561,7 +2599,7 @@ swr_compile_vs(struct swr_context *ctx, swr_jit_vs_key &key)
 
    BuilderSWR builder(
       reinterpret_cast<JitManager *>(swr_screen(ctx->pipe.screen)->hJitMgr),
-      "VS");
+      "VS", ctx->vs->pipe.tokens, &key, sizeof(key));
    PFN_VERTEX_FUNC func = builder.CompileVS(ctx, key);
 
    ctx->vs->map.insert(std::make_pair(key, std::unique_ptr<VariantVS>(new VariantVS(builder.gallivm, func))));
@@ -3032,7 +3070,7 @@ swr_compile_fs(struct swr_context *ctx, swr_jit_fs_key &key)
 
    BuilderSWR builder(
       reinterpret_cast<JitManager *>(swr_screen(ctx->pipe.screen)->hJitMgr),
-      "FS");
+      "FS", ctx->fs->pipe.tokens, &key, sizeof(key));
    PFN_PIXEL_KERNEL func = builder.CompileFS(ctx, key);
 
    ctx->fs->map.insert(std::make_pair(key, std::unique_ptr<VariantFS>(new VariantFS(builder.gallivm, func))));
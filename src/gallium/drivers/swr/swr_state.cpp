@@ -1752,6 +1752,17 @@ swr_update_derived(struct pipe_context *pipe,
       }
       SWR_PS_STATE psState = {0};
       psState.pfnPixelShader = func;
+
+      /* Without color buffers, a fragment shader that has no other visible
+       * effect than the coverage can be skipped altogether, and the core uses
+       * its depth/stencil only backend. */
+      if (!ctx->framebuffer.nr_cbufs &&
+          !ctx->fs->info.base.uses_kill &&
+          !ctx->fs->info.base.writes_z &&
+          !ctx->fs->info.base.writes_samplemask &&
+          !ctx->fs->info.base.writes_memory &&
+          !key.poly_stipple_enable)
+         psState.pfnPixelShader = NULL;
       psState.killsPixel = ctx->fs->info.base.uses_kill;
       psState.inputCoverage = SWR_INPUT_COVERAGE_NORMAL;
       psState.writesODepth = ctx->fs->info.base.writes_z;
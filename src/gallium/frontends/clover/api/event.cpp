@@ -22,6 +22,7 @@
 
 #include "api/util.hpp"
 #include "core/event.hpp"
+#include "core/trace.hpp"
 
 using namespace clover;
 
@@ -192,7 +193,8 @@ clEnqueueMarkerWithWaitList(cl_command_queue d_q, cl_uint num_deps,
 
    // Create a hard event that depends on the events in the wait list:
    // previous commands in the same queue are implicitly serialized
-   // with respect to it -- hard events always are.
+   // with respect to it -- hard events always are, except on
+   // out-of-order queues if the wait list isn't empty.
    auto hev = create<hard_event>(q, CL_COMMAND_MARKER, deps);
 
    ret_object(rd_ev, hev);
@@ -204,9 +206,12 @@ clEnqueueMarkerWithWaitList(cl_command_queue d_q, cl_uint num_deps,
 
 CLOVER_API cl_int
 clEnqueueBarrier(cl_command_queue d_q) try {
-   obj(d_q);
+   auto &q = obj(d_q);
 
-   // No need to do anything, q preserves data ordering strictly.
+   // No need to do anything for in-order queues, q preserves data
+   // ordering strictly.
+   if (q.props() & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)
+      create<hard_event>(q, CL_COMMAND_BARRIER, ref_vector<event> {});
 
    return CL_SUCCESS;
 
@@ -297,12 +302,17 @@ clFinish(cl_command_queue d_q) try {
    auto &q = obj(d_q);
 
    // Create a temporary hard event -- it implicitly depends on all
-   // the previously queued hard events.
+   // the previously queued hard events, even on out-of-order queues.
    auto hev = create<hard_event>(q, 0, ref_vector<event> {});
 
    // And wait on it.
    hev().wait();
 
+   // The output of the kernels is complete too once clFinish() returns.
+   q.finish_printf();
+
+   trace::flush();
+
    return CL_SUCCESS;
 
 } catch (error &e) {
@@ -23,6 +23,7 @@
 #include "api/util.hpp"
 #include "core/kernel.hpp"
 #include "core/event.hpp"
+#include "core/trace.hpp"
 
 using namespace clover;
 
@@ -336,6 +337,8 @@ clEnqueueNDRangeKernel(cl_command_queue d_q, cl_kernel d_kern,
          kern.launch(q, grid_offset, grid_size, block_size);
       });
 
+   trace::record(hev, kern.name(), grid_size, block_size);
+
    ret_object(rd_ev, hev);
    return CL_SUCCESS;
 
@@ -359,6 +362,8 @@ clEnqueueTask(cl_command_queue d_q, cl_kernel d_kern,
          kern.launch(q, { 0 }, { 1 }, { 1 });
       });
 
+   trace::record(hev, kern.name(), { 1 }, { 1 });
+
    ret_object(rd_ev, hev);
    return CL_SUCCESS;
 
@@ -28,6 +28,7 @@
 #include "api/util.hpp"
 #include "core/event.hpp"
 #include "core/memory.hpp"
+#include "core/trace.hpp"
 
 using namespace clover;
 
@@ -65,6 +66,15 @@ namespace {
          return dot(pitch, region - vector_t{ 0, 1, 1 });
    }
 
+   ///
+   /// Number of bytes transferred for a region of elements of \a
+   /// elem_size bytes.
+   ///
+   size_t
+   transfer_size(const vector_t &region, size_t elem_size = 1) {
+      return elem_size * region[0] * region[1] * region[2];
+   }
+
    ///
    /// Common argument checking shared by memory transfer commands.
    ///
@@ -338,6 +348,50 @@ namespace {
                                       src_obj->resource_in(q), src_orig);
       };
    }
+
+   ///
+   /// Hardware copy of a rectangular region from  src_obj to 
+   /// dst_obj.  Buffers are one-dimensional resources, so the region
+   /// is copied one row at a time, unless the rows or slices are
+   /// contiguous on both sides and can be copied at once.
+   ///
+   std::function<void (event &)>
+   hard_rect_copy_op(command_queue &q,
+                     buffer *dst_obj, const vector_t &dst_orig,
+                     const vector_t &dst_pitch,
+                     buffer *src_obj, const vector_t &src_orig,
+                     const vector_t &src_pitch,
+                     const vector_t &region) {
+      return [=, &q](event &) {
+         auto &dst_res = dst_obj->resource_in(q);
+         auto &src_res = src_obj->resource_in(q);
+         const size_t dst_base = dot(dst_pitch, dst_orig);
+         const size_t src_base = dot(src_pitch, src_orig);
+         vector_t size = region;
+
+         if (dst_pitch[1] == size[0] && src_pitch[1] == size[0]) {
+            size[0] *= size[1];
+            size[1] = 1;
+
+            if (dst_pitch[2] == size[0] && src_pitch[2] == size[0]) {
+               size[0] *= size[2];
+               size[2] = 1;
+            }
+         }
+
+         for (size_t z = 0; z < size[2]; ++z) {
+            for (size_t y = 0; y < size[1]; ++y) {
+               const vector_t dst_row = {{ dst_base + y * dst_pitch[1] +
+                                           z * dst_pitch[2] }};
+               const vector_t src_row = {{ src_base + y * src_pitch[1] +
+                                           z * src_pitch[2] }};
+
+               dst_res.copy(q, dst_row, {{ size[0], 1, 1 }},
+                            src_res, src_row);
+            }
+         }
+      };
+   }
 }
 
 CLOVER_API cl_int
@@ -363,6 +417,8 @@ clEnqueueReadBuffer(cl_command_queue d_q, cl_mem d_mem, cl_bool blocking,
                    &mem, obj_origin, obj_pitch,
                    region));
 
+   trace::record(hev, transfer_size(region));
+
    if (blocking)
        hev().wait_signalled();
 
@@ -396,6 +452,8 @@ clEnqueueWriteBuffer(cl_command_queue d_q, cl_mem d_mem, cl_bool blocking,
                    ptr, {}, obj_pitch,
                    region));
 
+   trace::record(hev, transfer_size(region));
+
    if (blocking)
        hev().wait_signalled();
 
@@ -436,6 +494,8 @@ clEnqueueReadBufferRect(cl_command_queue d_q, cl_mem d_mem, cl_bool blocking,
                    &mem, obj_origin, obj_pitch,
                    region));
 
+   trace::record(hev, transfer_size(region));
+
    if (blocking)
        hev().wait_signalled();
 
@@ -476,6 +536,8 @@ clEnqueueWriteBufferRect(cl_command_queue d_q, cl_mem d_mem, cl_bool blocking,
                    ptr, host_origin, host_pitch,
                    region));
 
+   trace::record(hev, transfer_size(region));
+
    if (blocking)
        hev().wait_signalled();
 
@@ -523,6 +585,8 @@ clEnqueueFillBuffer(cl_command_queue d_queue, cl_mem d_mem,
          mem.resource_in(q).clear(q, origin, region, data);
       });
 
+   trace::record(hev, transfer_size(region));
+
    ret_object(rd_ev, hev);
    return CL_SUCCESS;
 
@@ -556,6 +620,8 @@ clEnqueueCopyBuffer(cl_command_queue d_q, cl_mem d_src_mem, cl_mem d_dst_mem,
       hard_copy_op(q, &dst_mem, dst_origin,
                    &src_mem, src_origin, region));
 
+   trace::record(hev, transfer_size(region));
+
    ret_object(rd_ev, hev);
    return CL_SUCCESS;
 
@@ -590,9 +656,11 @@ clEnqueueCopyBufferRect(cl_command_queue d_q, cl_mem d_src_mem,
 
    auto hev = create<hard_event>(
       q, CL_COMMAND_COPY_BUFFER_RECT, deps,
-      soft_copy_op(q, &dst_mem, dst_origin, dst_pitch,
-                   &src_mem, src_origin, src_pitch,
-                   region));
+      hard_rect_copy_op(q, &dst_mem, dst_origin, dst_pitch,
+                        &src_mem, src_origin, src_pitch,
+                        region));
+
+   trace::record(hev, transfer_size(region));
 
    ret_object(rd_ev, hev);
    return CL_SUCCESS;
@@ -628,6 +696,8 @@ clEnqueueReadImage(cl_command_queue d_q, cl_mem d_mem, cl_bool blocking,
                    &img, src_origin, src_pitch,
                    region));
 
+   trace::record(hev, transfer_size(region, img.pixel_size()));
+
    if (blocking)
        hev().wait_signalled();
 
@@ -665,6 +735,8 @@ clEnqueueWriteImage(cl_command_queue d_q, cl_mem d_mem, cl_bool blocking,
                    ptr, {}, src_pitch,
                    region));
 
+   trace::record(hev, transfer_size(region, img.pixel_size()));
+
    if (blocking)
        hev().wait_signalled();
 
@@ -700,6 +772,8 @@ clEnqueueFillImage(cl_command_queue d_queue, cl_mem d_mem,
          img.resource_in(q).clear(q, origin, region, data);
       });
 
+   trace::record(hev, transfer_size(region, img.pixel_size()));
+
    ret_object(rd_ev, hev);
    return CL_SUCCESS;
 
@@ -732,6 +806,8 @@ clEnqueueCopyImage(cl_command_queue d_q, cl_mem d_src_mem, cl_mem d_dst_mem,
                    &src_img, src_origin,
                    region));
 
+   trace::record(hev, transfer_size(region, src_img.pixel_size()));
+
    ret_object(rd_ev, hev);
    return CL_SUCCESS;
 
@@ -768,6 +844,8 @@ clEnqueueCopyImageToBuffer(cl_command_queue d_q,
                    &src_img, src_origin, src_pitch,
                    region));
 
+   trace::record(hev, transfer_size(region, src_img.pixel_size()));
+
    ret_object(rd_ev, hev);
    return CL_SUCCESS;
 
@@ -804,6 +882,8 @@ clEnqueueCopyBufferToImage(cl_command_queue d_q,
                    &src_mem, src_origin, src_pitch,
                    region));
 
+   trace::record(hev, transfer_size(region, dst_img.pixel_size()));
+
    ret_object(rd_ev, hev);
    return CL_SUCCESS;
 
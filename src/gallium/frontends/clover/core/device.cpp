@@ -30,6 +30,7 @@
 #include "util/u_debug.h"
 #include "spirv/invocation.hpp"
 #include "nir/invocation.hpp"
+#include "llvm/invocation.hpp"
 #include <fstream>
 
 using namespace clover;
@@ -48,7 +49,7 @@ namespace {
 }
 
 device::device(clover::platform &platform, pipe_loader_device *ldev) :
-   platform(platform), clc_cache(NULL), ldev(ldev) {
+   platform(platform), clc_cache(NULL), llvm_cache(NULL), ldev(ldev) {
    unsigned major = 1, minor = 1;
    debug_get_version_option("CLOVER_DEVICE_VERSION_OVERRIDE", &major, &minor);
    version = CL_MAKE_VERSION(major, minor, 0);
@@ -59,13 +60,16 @@ device::device(clover::platform &platform, pipe_loader_device *ldev) :
 
    pipe = pipe_loader_create_screen(ldev);
    if (pipe && pipe->get_param(pipe, PIPE_CAP_COMPUTE)) {
-      if (supports_ir(PIPE_SHADER_IR_NATIVE))
+      if (supports_ir(PIPE_SHADER_IR_NATIVE)) {
+         llvm_cache = llvm::create_llvm_disk_cache();
          return;
+      }
 #ifdef HAVE_CLOVER_SPIRV
       if (supports_ir(PIPE_SHADER_IR_NIR_SERIALIZED)) {
          nir::check_for_libclc(*this);
          clc_cache = nir::create_clc_disk_cache();
          clc_nir = lazy<std::shared_ptr<nir_shader>>([&] () { std::string log; return std::shared_ptr<nir_shader>(nir::load_libclc_nir(*this, log), ralloc_free); });
+         clc_nir_hash = lazy<std::string>([&] () { return nir::hash_libclc_nir(*this); });
          return;
       }
 #endif
@@ -78,6 +82,8 @@ device::device(clover::platform &platform, pipe_loader_device *ldev) :
 device::~device() {
    if (clc_cache)
       disk_cache_destroy(clc_cache);
+   if (llvm_cache)
+      disk_cache_destroy(llvm_cache);
    if (pipe)
       pipe->destroy(pipe);
    if (ldev)
@@ -270,6 +276,12 @@ device::svm_support() const {
    return 0;
 }
 
+bool
+device::allows_persistent_maps() const {
+   return has_unified_memory() &&
+          pipe->get_param(pipe, PIPE_CAP_BUFFER_MAP_PERSISTENT_COHERENT);
+}
+
 bool
 device::allows_user_pointers() const {
    return pipe->get_param(pipe, PIPE_CAP_RESOURCE_FROM_USER_MEMORY) ||
@@ -78,6 +78,7 @@ namespace clover {
       bool has_halves() const;
       bool has_int64_atomics() const;
       bool has_unified_memory() const;
+      bool allows_persistent_maps() const;
       size_t mem_base_addr_align() const;
       cl_device_svm_capabilities svm_support() const;
       bool allows_user_pointers() const;
@@ -117,7 +118,9 @@ namespace clover {
       }
 
       lazy<std::shared_ptr<nir_shader>> clc_nir;
+      lazy<std::string> clc_nir_hash;
       disk_cache *clc_cache;
+      disk_cache *llvm_cache;
       cl_version version;
       cl_version clc_version;
    private:
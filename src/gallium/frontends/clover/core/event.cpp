@@ -21,6 +21,7 @@
 //
 
 #include "core/event.hpp"
+#include "core/trace.hpp"
 #include "pipe/p_screen.h"
 
 using namespace clover;
@@ -131,7 +132,7 @@ hard_event::hard_event(command_queue &q, cl_command_type command,
                        const ref_vector<event> &deps, action action) :
    event(q.context(), deps, profile(q, action), [](event &ev){}),
    _queue(q), _command(command), _fence(NULL) {
-   if (q.profiling_enabled())
+   if (q.profiling_enabled() || trace::enabled())
       _time_queued = timestamp::current(q);
 
    q.sequence(*this);
@@ -176,7 +177,9 @@ hard_event::wait() const {
 
    event::wait();
 
-   if (status() == CL_QUEUED)
+   // Flush only if the event isn't part of a submitted batch yet, no need
+   // to poll the fence that is waited on right after.
+   if (!_fence)
       queue()->flush();
 
    if (!_fence ||
@@ -214,7 +217,7 @@ hard_event::fence(pipe_fence_handle *fence) {
 
 event::action
 hard_event::profile(command_queue &q, const action &action) const {
-   if (q.profiling_enabled()) {
+   if (q.profiling_enabled() || trace::enabled()) {
       return [&q, action] (event &ev) {
          auto &hev = static_cast<hard_event &>(ev);
 
@@ -64,7 +64,7 @@ kernel::launch(command_queue &q,
                const std::vector<size_t> &grid_offset,
                const std::vector<size_t> &grid_size,
                const std::vector<size_t> &block_size) {
-   const auto m = program().build(q.device()).binary;
+   const auto &m = program().build(q.device()).binary;
    const auto reduced_grid_size =
       map(divides(), grid_size, block_size);
    void *st = exec.bind(&q, grid_offset);
@@ -76,19 +76,29 @@ kernel::launch(command_queue &q,
          return (uint32_t *)&exec.input[h];
       }, exec.g_handles);
 
-   q.pipe->bind_compute_state(q.pipe, st);
-   q.pipe->bind_sampler_states(q.pipe, PIPE_SHADER_COMPUTE,
-                               0, exec.samplers.size(),
-                               exec.samplers.data());
-
-   q.pipe->set_sampler_views(q.pipe, PIPE_SHADER_COMPUTE, 0,
-                             exec.sviews.size(), 0, exec.sviews.data());
-   q.pipe->set_shader_images(q.pipe, PIPE_SHADER_COMPUTE, 0,
-                             exec.iviews.size(), 0, exec.iviews.data());
-   q.pipe->set_compute_resources(q.pipe, 0, exec.resources.size(),
-                                 exec.resources.data());
-   q.pipe->set_global_binding(q.pipe, 0, exec.g_buffers.size(),
-                              exec.g_buffers.data(), g_handles.data());
+   // Only the compute state outlives the launch, the other objects are
+   // created by exec_context::bind() and destroyed again by unbind(), so
+   // they have to be unbound below, but empty ranges can be skipped.
+   if (q.bound_cs != st) {
+      q.pipe->bind_compute_state(q.pipe, st);
+      q.bound_cs = st;
+   }
+   if (!exec.samplers.empty())
+      q.pipe->bind_sampler_states(q.pipe, PIPE_SHADER_COMPUTE,
+                                  0, exec.samplers.size(),
+                                  exec.samplers.data());
+   if (!exec.sviews.empty())
+      q.pipe->set_sampler_views(q.pipe, PIPE_SHADER_COMPUTE, 0,
+                                exec.sviews.size(), 0, exec.sviews.data());
+   if (!exec.iviews.empty())
+      q.pipe->set_shader_images(q.pipe, PIPE_SHADER_COMPUTE, 0,
+                                exec.iviews.size(), 0, exec.iviews.data());
+   if (!exec.resources.empty())
+      q.pipe->set_compute_resources(q.pipe, 0, exec.resources.size(),
+                                    exec.resources.data());
+   if (!exec.g_buffers.empty())
+      q.pipe->set_global_binding(q.pipe, 0, exec.g_buffers.size(),
+                                 exec.g_buffers.data(), g_handles.data());
 
    // Fill information for the launch_grid() call.
    info.work_dim = grid_size.size();
@@ -99,14 +109,19 @@ kernel::launch(command_queue &q,
 
    q.pipe->launch_grid(q.pipe, &info);
 
-   q.pipe->set_global_binding(q.pipe, 0, exec.g_buffers.size(), NULL, NULL);
-   q.pipe->set_compute_resources(q.pipe, 0, exec.resources.size(), NULL);
-   q.pipe->set_shader_images(q.pipe, PIPE_SHADER_COMPUTE, 0,
-                             0, exec.iviews.size(), NULL);
-   q.pipe->set_sampler_views(q.pipe, PIPE_SHADER_COMPUTE, 0,
-                             0, exec.sviews.size(), NULL);
-   q.pipe->bind_sampler_states(q.pipe, PIPE_SHADER_COMPUTE, 0,
-                               exec.samplers.size(), NULL);
+   if (!exec.g_buffers.empty())
+      q.pipe->set_global_binding(q.pipe, 0, exec.g_buffers.size(), NULL, NULL);
+   if (!exec.resources.empty())
+      q.pipe->set_compute_resources(q.pipe, 0, exec.resources.size(), NULL);
+   if (!exec.iviews.empty())
+      q.pipe->set_shader_images(q.pipe, PIPE_SHADER_COMPUTE, 0,
+                                0, exec.iviews.size(), NULL);
+   if (!exec.sviews.empty())
+      q.pipe->set_sampler_views(q.pipe, PIPE_SHADER_COMPUTE, 0,
+                                0, exec.sviews.size(), NULL);
+   if (!exec.samplers.empty())
+      q.pipe->bind_sampler_states(q.pipe, PIPE_SHADER_COMPUTE, 0,
+                                  exec.samplers.size(), NULL);
 
    q.pipe->memory_barrier(q.pipe, PIPE_BARRIER_GLOBAL_BUFFER);
    exec.unbind();
@@ -173,12 +188,16 @@ kernel::module(const command_queue &q) const {
 }
 
 kernel::exec_context::exec_context(kernel &kern) :
-   kern(kern), q(NULL), print_handler(), mem_local(0), st(NULL), cs() {
+   kern(kern), q(NULL), print_handler(), spare_print_handler(),
+   mem_local(0), st(NULL), cs() {
 }
 
 kernel::exec_context::~exec_context() {
-   if (st)
+   if (st) {
+      if (q->bound_cs == st)
+         q->bound_cs = NULL;
       q->pipe->delete_compute_state(q->pipe, st);
+   }
 }
 
 void *
@@ -187,10 +206,12 @@ kernel::exec_context::bind(intrusive_ptr<command_queue> _q,
    std::swap(q, _q);
 
    // Bind kernel arguments.
-   auto &m = kern.program().build(q->device()).binary;
-   auto msym = find(name_equals(kern.name()), m.syms);
-   auto margs = msym.args;
-   auto msec = find(id_type_equals(msym.section, module::section::text_executable), m.secs);
+   const auto &m = kern.program().build(q->device()).binary;
+   const auto &msym = find(name_equals(kern.name()), m.syms);
+   const auto &margs = msym.args;
+   const auto &msec = find(id_type_equals(msym.section,
+                                          module::section::text_executable),
+                           m.secs);
    auto explicit_arg = kern._args.begin();
 
    for (auto &marg : margs) {
@@ -201,19 +222,12 @@ kernel::exec_context::bind(intrusive_ptr<command_queue> _q,
 
       case module::argument::grid_dimension: {
          const cl_uint dimension = grid_offset.size();
-         auto arg = argument::create(marg);
-
-         arg->set(sizeof(dimension), &dimension);
-         arg->bind(*this, marg);
+         bind_scalar(marg, &dimension, sizeof(dimension));
          break;
       }
       case module::argument::grid_offset: {
-         for (cl_uint x : pad_vector(*q, grid_offset, 0)) {
-            auto arg = argument::create(marg);
-
-            arg->set(sizeof(x), &x);
-            arg->bind(*this, marg);
-         }
+         for (cl_uint x : pad_vector(*q, grid_offset, 0))
+            bind_scalar(marg, &x, sizeof(x));
          break;
       }
       case module::argument::image_size: {
@@ -222,12 +236,8 @@ kernel::exec_context::bind(intrusive_ptr<command_queue> _q,
                static_cast<cl_uint>(img->width()),
                static_cast<cl_uint>(img->height()),
                static_cast<cl_uint>(img->depth())};
-         for (auto x : image_size) {
-            auto arg = argument::create(marg);
-
-            arg->set(sizeof(x), &x);
-            arg->bind(*this, marg);
-         }
+         for (auto x : image_size)
+            bind_scalar(marg, &x, sizeof(x));
          break;
       }
       case module::argument::image_format: {
@@ -236,12 +246,8 @@ kernel::exec_context::bind(intrusive_ptr<command_queue> _q,
          std::vector<cl_uint> image_format{
                static_cast<cl_uint>(fmt.image_channel_data_type),
                static_cast<cl_uint>(fmt.image_channel_order)};
-         for (auto x : image_format) {
-            auto arg = argument::create(marg);
-
-            arg->set(sizeof(x), &x);
-            arg->bind(*this, marg);
-         }
+         for (auto x : image_format)
+            bind_scalar(marg, &x, sizeof(x));
          break;
       }
       case module::argument::constant_buffer: {
@@ -252,9 +258,15 @@ kernel::exec_context::bind(intrusive_ptr<command_queue> _q,
          break;
       }
       case module::argument::printf_buffer: {
-         print_handler = printf_handler::create(q, m.printf_infos,
-                                                m.printf_strings_in_buffer,
-                                                q->device().max_printf_buffer_size());
+         // Alternate between two buffers, the output of the previous
+         // launch may still be printed while this one runs.
+         std::swap(print_handler, spare_print_handler);
+         if (print_handler && print_handler->compatible(*q))
+            print_handler->wait();
+         else
+            print_handler = printf_handler::create(q, m.printf_infos,
+                                                   m.printf_strings_in_buffer,
+                                                   q->device().max_printf_buffer_size());
          cl_mem print_mem = print_handler->get_mem();
 
          auto arg = argument::create(marg);
@@ -269,8 +281,11 @@ kernel::exec_context::bind(intrusive_ptr<command_queue> _q,
    if (!st || q != _q ||
        cs.req_local_mem != mem_local ||
        cs.req_input_mem != input.size()) {
-      if (st)
+      if (st) {
+         if (_q->bound_cs == st)
+            _q->bound_cs = NULL;
          _q->pipe->delete_compute_state(_q->pipe, st);
+      }
 
       cs.ir_type = q->device().ir_format();
       cs.prog = &(msec.data[0]);
@@ -439,12 +454,27 @@ kernel::scalar_argument::set(size_t size, const void *value) {
 void
 kernel::scalar_argument::bind(exec_context &ctx,
                               const module::argument &marg) {
-   auto w = v;
+   ctx.bind_scalar(marg, v.data(), v.size());
+}
+
+void
+kernel::exec_context::bind_scalar(const module::argument &marg,
+                                  const void *value, size_t size) {
+   auto p = static_cast<const uint8_t *>(value);
 
+   align(input, marg.target_align);
+
+   // Most arguments are passed as they are, avoid the temporary then.
+   if (size == marg.target_size &&
+       q->device().endianness() == PIPE_ENDIAN_NATIVE) {
+      input.insert(input.end(), p, p + size);
+      return;
+   }
+
+   std::vector<uint8_t> w = { p, p + size };
    extend(w, marg.ext_type, marg.target_size);
-   byteswap(w, ctx.q->device().endianness());
-   align(ctx.input, marg.target_align);
-   insert(ctx.input, w);
+   byteswap(w, q->device().endianness());
+   insert(input, w);
 }
 
 void
@@ -52,9 +52,14 @@ namespace clover {
                     const std::vector<size_t> &grid_offset);
          void unbind();
 
+         /// Append a scalar argument value to the input buffer.
+         void bind_scalar(const module::argument &marg,
+                          const void *value, size_t size);
+
          kernel &kern;
          intrusive_ptr<command_queue> q;
          std::unique_ptr<printf_handler> print_handler;
+         std::unique_ptr<printf_handler> spare_print_handler;
 
          std::vector<uint8_t> input;
          std::vector<void *> samplers;
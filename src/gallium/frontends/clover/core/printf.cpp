@@ -27,6 +27,8 @@
 
 #include "util/u_math.h"
 #include "core/printf.hpp"
+#include "core/queue.hpp"
+#include "pipe/p_screen.h"
 
 #include "util/u_printf.h"
 using namespace clover;
@@ -186,7 +188,10 @@ printf_handler::printf_handler(const intrusive_ptr<command_queue> &q,
                                const std::vector<module::printf_info> &infos,
                                bool strings_in_buffer,
                                cl_uint size) :
-   _q(q), _formatters(infos), _strings_in_buffer(strings_in_buffer), _size(size), _buffer() {
+   _q(q), _formatters(infos), _strings_in_buffer(strings_in_buffer), _size(size), _buffer(),
+   _map(), _fence(NULL) {
+
+   util_queue_fence_init(&_printed);
 
    if (_size) {
       std::string data;
@@ -197,41 +202,88 @@ printf_handler::printf_handler(const intrusive_ptr<command_queue> &q,
       header[1] = _size;
 
       data.append((char *)header, (char *)(header+hdr_dwords));
+
+      // Host accessible memory is mapped persistently where possible, so
+      // the output can be read back by the printf worker of the queue.
       _buffer = std::unique_ptr<root_buffer>(new root_buffer(_q->context,
                                              std::vector<cl_mem_properties>(),
-                                             CL_MEM_COPY_HOST_PTR,
+                                             CL_MEM_COPY_HOST_PTR |
+                                             CL_MEM_ALLOC_HOST_PTR,
                                              _size, (char*)data.data()));
+
+      auto &r = _buffer->resource_in(*_q);
+      if (r.pipe->flags & PIPE_RESOURCE_FLAG_MAP_PERSISTENT)
+         _map = std::unique_ptr<mapping>(
+            new mapping(*_q, r, CL_MAP_READ | CL_MAP_WRITE, false,
+                        {{ 0 }}, {{ _size, 1, 1 }}));
    }
 }
 
+printf_handler::~printf_handler() {
+   wait();
+   util_queue_fence_destroy(&_printed);
+}
+
 cl_mem
 printf_handler::get_mem() {
    return (cl_mem)(_buffer.get());
 }
 
-void
-printf_handler::print() {
-   if (!_buffer)
-      return;
-
-   mapping src = { *_q, _buffer->resource_in(*_q), CL_MAP_READ, true,
-                  {{ 0 }}, {{ _size, 1, 1 }} };
+bool
+printf_handler::compatible(const command_queue &q) const {
+   return &*_q == &q;
+}
 
+void
+printf_handler::drain(char *data) {
    cl_uint header[2] = { 0 };
-   std::memcpy(header,
-               static_cast<const char *>(src),
-               initial_buffer_offset);
+   std::memcpy(header, data, initial_buffer_offset);
 
    cl_uint buffer_size = header[0];
    buffer_size -= initial_buffer_offset;
-   std::vector<char> buf;
-   buf.resize(buffer_size);
+   std::vector<char> buf(data + initial_buffer_offset,
+                         data + initial_buffer_offset + buffer_size);
 
-   std::memcpy(buf.data(),
-               static_cast<const char *>(src) + initial_buffer_offset,
-               buffer_size);
+   // Rewind the buffer for the next launch.
+   header[0] = initial_buffer_offset;
+   std::memcpy(data, header, sizeof(cl_uint));
 
    // mixed endian isn't going to work, sort it out if anyone cares later.
    assert(_q->device().endianness() == PIPE_ENDIAN_NATIVE);
    print_formatted(_formatters, _strings_in_buffer, buf);
 }
+
+void
+printf_handler::print_job(void *data, int thread_index) {
+   auto h = static_cast<printf_handler *>(data);
+   pipe_screen *screen = h->_q->pipe->screen;
+
+   screen->fence_finish(screen, NULL, h->_fence, PIPE_TIMEOUT_INFINITE);
+   screen->fence_reference(screen, &h->_fence, NULL);
+
+   h->drain(static_cast<char *>(*h->_map));
+}
+
+void
+printf_handler::print() {
+   if (!_buffer)
+      return;
+
+   if (_map) {
+      // The kernel output is read directly from the mapping once its fence
+      // signals, without stalling the queue.
+      _q->pipe->flush(_q->pipe, &_fence, 0);
+      util_queue_add_job(&_q->printf_worker(), this, &_printed,
+                         print_job, NULL, 0);
+      return;
+   }
+
+   mapping src = { *_q, _buffer->resource_in(*_q), CL_MAP_READ | CL_MAP_WRITE,
+                   true, {{ 0 }}, {{ _size, 1, 1 }} };
+   drain(static_cast<char *>(src));
+}
+
+void
+printf_handler::wait() {
+   util_queue_fence_wait(&_printed);
+}
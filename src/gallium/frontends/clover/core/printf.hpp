@@ -26,6 +26,10 @@
 #include <memory>
 
 #include "core/memory.hpp"
+#include "core/resource.hpp"
+#include "util/u_queue.h"
+
+struct pipe_fence_handle;
 
 namespace clover {
    class printf_handler {
@@ -39,21 +43,44 @@ namespace clover {
       printf_handler &
       operator=(const printf_handler &arg) = delete;
 
-      ~printf_handler() {};
+      ~printf_handler();
 
       cl_mem get_mem();
+
+      ///
+      /// Print the output of the last launch.  With a persistently
+      /// mapped buffer this only queues the job on the printf worker of
+      /// the command queue.
+      ///
       void print();
 
+      ///
+      /// Wait for the output of the last launch to be printed, after
+      /// which the buffer can be passed to the next launch.
+      ///
+      void wait();
+
+      bool
+      compatible(const command_queue &q) const;
+
    private:
       printf_handler(const intrusive_ptr<command_queue> &q,
                      const std::vector<module::printf_info> &infos,
                      bool strings_in_buffer, cl_uint size);
 
+      static void print_job(void *data, int thread_index);
+      void drain(char *data);
+
       intrusive_ptr<command_queue> _q;
       std::vector<module::printf_info> _formatters;
       bool _strings_in_buffer;
       cl_uint _size;
       std::unique_ptr<root_buffer> _buffer;
+
+      // Persistent mapping of the buffer, if the device supports it.
+      std::unique_ptr<mapping> _map;
+      pipe_fence_handle *_fence;
+      util_queue_fence _printed;
    };
 }
 
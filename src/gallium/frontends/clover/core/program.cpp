@@ -23,8 +23,51 @@
 #include "core/compiler.hpp"
 #include "core/program.hpp"
 
+#include <exception>
+#include <thread>
+
 using namespace clover;
 
+namespace {
+   ///
+   /// Call \a f for each device in \a devs.  Builds for different devices
+   /// are independent, so with more than one device each call gets its own
+   /// thread.  The first exception thrown is rethrown once all are done.
+   ///
+   template<typename F>
+   void
+   for_each_device(const ref_vector<device> &devs, F &&f) {
+      if (devs.size() < 2) {
+         for (auto &dev : devs)
+            f(dev);
+         return;
+      }
+
+      std::vector<std::exception_ptr> errors(devs.size());
+      std::vector<std::thread> threads;
+      unsigned i = 0;
+
+      for (auto &dev : devs) {
+         threads.emplace_back([&f, &errors, &dev, i]() {
+               try {
+                  f(dev);
+               } catch (...) {
+                  errors[i] = std::current_exception();
+               }
+            });
+         i++;
+      }
+
+      for (auto &t : threads)
+         t.join();
+
+      for (auto &e : errors) {
+         if (e)
+            std::rethrow_exception(e);
+      }
+   }
+}
+
 program::program(clover::context &ctx, std::string &&source,
                  enum il_type il_type) :
    context(ctx), _devices(ctx.devices()), _source(std::move(source)),
@@ -48,7 +91,11 @@ program::compile(const ref_vector<device> &devs, const std::string &opts,
    if (_il_type != il_type::none) {
       _devices = devs;
 
-      for (auto &dev : devs) {
+      // Create the entries up front, the threads only assign them.
+      for (auto &dev : devs)
+         _builds[&dev];
+
+      for_each_device(devs, [&](device &dev) {
          std::string log;
 
          try {
@@ -59,7 +106,7 @@ program::compile(const ref_vector<device> &devs, const std::string &opts,
             _builds[&dev] = { module(), opts, log };
             throw;
          }
-      }
+      });
    }
 }
 
@@ -68,7 +115,10 @@ program::link(const ref_vector<device> &devs, const std::string &opts,
               const ref_vector<program> &progs) {
    _devices = devs;
 
-   for (auto &dev : devs) {
+   for (auto &dev : devs)
+      _builds[&dev];
+
+   for_each_device(devs, [&](device &dev) {
       const std::vector<module> ms = map([&](const program &prog) {
          return prog.build(dev).binary;
          }, progs);
@@ -81,7 +131,7 @@ program::link(const ref_vector<device> &devs, const std::string &opts,
          _builds[&dev] = { module(), opts, log };
          throw;
       }
-   }
+   });
 }
 
 enum program::il_type
@@ -26,6 +26,8 @@
 #include "pipe/p_context.h"
 #include "pipe/p_state.h"
 
+#include <algorithm>
+
 using namespace clover;
 
 namespace {
@@ -86,6 +88,8 @@ command_queue::command_queue(clover::context &ctx, clover::device &dev,
 }
 
 command_queue::~command_queue() {
+   if (util_queue_is_initialized(&printf_queue))
+      util_queue_destroy(&printf_queue);
    pipe->destroy(pipe);
 }
 
@@ -100,14 +104,36 @@ command_queue::flush_unlocked() {
    pipe_screen *screen = device().pipe;
    pipe_fence_handle *fence = NULL;
 
-   if (!queued_events.empty()) {
+   // Events of an in-order queue are chained, so if the oldest one hasn't
+   // been signalled yet none of them has submitted any work and there
+   // would be no event to hand the fence to.
+   auto is_signalled = [](const intrusive_ref<hard_event> &ev) {
+      return ev().signalled();
+   };
+   auto first = (_props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE ?
+                 std::find_if(queued_events.begin(), queued_events.end(),
+                              is_signalled) :
+                 queued_events.begin());
+
+   if (first != queued_events.end() && (*first)().signalled()) {
       pipe->flush(pipe, &fence, 0);
 
-      while (!queued_events.empty() &&
-             queued_events.front()().signalled()) {
-         queued_events.front()().fence(fence);
-         queued_events.pop_front();
+      // The events that are still waiting for their dependencies stay
+      // queued, in their original order.
+      auto last = first;
+      for (auto it = first; it != queued_events.end(); ++it) {
+         if ((*it)().signalled()) {
+            (*it)().fence(fence);
+            if (&(*it)() == last_barrier)
+               last_barrier = NULL;
+         } else if (_props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
+            *last++ = *it;
+         } else {
+            last = std::move(it, queued_events.end(), last);
+            break;
+         }
       }
+      queued_events.erase(last, queued_events.end());
 
       screen->fence_reference(screen, &fence, NULL);
    }
@@ -117,7 +143,9 @@ void
 command_queue::svm_migrate(const std::vector<void const*> &svm_pointers,
                            const std::vector<size_t> &sizes,
                            cl_mem_migration_flags flags) {
-   if (!pipe->svm_migrate)
+   // SVM allocations are plain system memory, with unified memory the
+   // device accesses them in place and there is nothing to migrate.
+   if (!pipe->svm_migrate || device().has_unified_memory())
       return;
 
    bool to_device = !(flags & CL_MIGRATE_MEM_OBJECT_HOST);
@@ -141,11 +169,49 @@ command_queue::profiling_enabled() const {
    return _props & CL_QUEUE_PROFILING_ENABLE;
 }
 
+util_queue &
+command_queue::printf_worker() {
+   std::call_once(printf_worker_once, [&]() {
+         // A single thread keeps the output of consecutive kernels in
+         // order.
+         if (!util_queue_init(&printf_queue, "clprintf", 32, 1,
+                              UTIL_QUEUE_INIT_RESIZE_IF_FULL))
+            throw error(CL_OUT_OF_HOST_MEMORY);
+      });
+   return printf_queue;
+}
+
+void
+command_queue::finish_printf() {
+   if (util_queue_is_initialized(&printf_queue))
+      util_queue_finish(&printf_queue);
+}
+
 void
 command_queue::sequence(hard_event &ev) {
    std::lock_guard<std::mutex> lock(queued_events_mutex);
-   if (!queued_events.empty())
-      queued_events.back()().chain(ev);
+
+   if (!(_props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)) {
+      if (!queued_events.empty())
+         queued_events.back()().chain(ev);
+
+   } else if (ev.command() == CL_COMMAND_BARRIER ||
+              (ev.deps.empty() && (ev.command() == CL_COMMAND_MARKER ||
+                                   !ev.command()))) {
+      // Barriers, markers without a wait list and the events used to
+      // implement clFinish() wait for all the previous commands that
+      // haven't been signalled yet, signalled ones have already run.
+      for (auto &q_ev : queued_events) {
+         if (!q_ev().signalled())
+            q_ev().chain(ev);
+      }
+
+      if (ev.command() == CL_COMMAND_BARRIER)
+         last_barrier = &ev;
+
+   } else if (last_barrier) {
+      last_barrier->chain(ev);
+   }
 
    queued_events.push_back(ev);
 
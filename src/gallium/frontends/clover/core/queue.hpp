@@ -30,6 +30,7 @@
 #include "core/context.hpp"
 #include "core/timestamp.hpp"
 #include "pipe/p_context.h"
+#include "util/u_queue.h"
 
 namespace clover {
    class resource;
@@ -57,6 +58,10 @@ namespace clover {
       std::vector<cl_queue_properties> properties() const;
       bool profiling_enabled() const;
 
+      /// Wait until the output of the kernels launched so far has been
+      /// printed.
+      void finish_printf();
+
       const intrusive_ref<clover::context> context;
       const intrusive_ref<clover::device> device;
 
@@ -66,21 +71,38 @@ namespace clover {
       friend class hard_event;
       friend class sampler;
       friend class kernel;
+      friend class printf_handler;
       friend class clover::timestamp::query;
       friend class clover::timestamp::current;
 
    private:
       /// Serialize a hardware event with respect to the previous ones,
-      /// and push it to the pending list.
+      /// and push it to the pending list.  On out-of-order queues only
+      /// barriers and markers without a wait list are serialized with
+      /// the previous events, the rest of the events only wait for the
+      /// last barrier and their own wait list.
       void sequence(hard_event &ev);
       // Use this instead of flush() if `queued_events_mutex` is acquired.
       void flush_unlocked();
 
+      /// Thread that formats the printf output of kernels, started with
+      /// the first kernel that uses printf.
+      util_queue &printf_worker();
+
       std::vector<cl_queue_properties> _properties;
       cl_command_queue_properties _props;
       pipe_context *pipe;
       std::mutex queued_events_mutex;
       std::deque<intrusive_ref<hard_event>> queued_events;
+      // Last barrier of an out-of-order queue that is still queued.
+      hard_event *last_barrier = NULL;
+
+      // Compute state left bound by the last kernel launch, so that
+      // consecutive launches of the same kernel don't bind it again.
+      void *bound_cs = NULL;
+
+      std::once_flag printf_worker_once;
+      util_queue printf_queue = {};
    };
 }
 
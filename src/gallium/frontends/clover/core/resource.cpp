@@ -186,9 +186,19 @@ root_resource::root_resource(clover::device &dev, memory_obj &obj,
 
    if (obj.flags() & (CL_MEM_ALLOC_HOST_PTR | CL_MEM_USE_HOST_PTR)) {
       info.usage = PIPE_USAGE_STAGING;
+
+      // Host accessible buffers in shared memory can be mapped directly,
+      // without staging copies.
+      if (info.target == PIPE_BUFFER && dev.allows_persistent_maps())
+         info.flags = PIPE_RESOURCE_FLAG_MAP_PERSISTENT |
+                      PIPE_RESOURCE_FLAG_MAP_COHERENT;
    }
 
    pipe = dev.pipe->resource_create(dev.pipe, &info);
+   if (!pipe && info.flags) {
+      info.flags = 0;
+      pipe = dev.pipe->resource_create(dev.pipe, &info);
+   }
    if (!pipe)
       throw error(CL_OUT_OF_RESOURCES);
 
@@ -233,6 +243,9 @@ mapping::mapping(command_queue &q, resource &r,
                       PIPE_MAP_DISCARD_RANGE : 0) |
                      (!blocking ? PIPE_MAP_UNSYNCHRONIZED : 0));
 
+   if (r.pipe->flags & PIPE_RESOURCE_FLAG_MAP_PERSISTENT)
+      usage |= PIPE_MAP_PERSISTENT | PIPE_MAP_COHERENT;
+
    p = pctx->transfer_map(pctx, r.pipe, 0, usage,
                           box(origin + r.offset, region), &pxfer);
    if (!p) {
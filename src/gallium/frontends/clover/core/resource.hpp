@@ -64,6 +64,7 @@ namespace clover {
       friend class sub_resource;
       friend class mapping;
       friend class kernel;
+      friend class printf_handler;
 
    protected:
       resource(clover::device &dev, memory_obj &obj);
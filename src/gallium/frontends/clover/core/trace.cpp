@@ -0,0 +1,238 @@
+//
+// Copyright 2021 The Mesa Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "core/trace.hpp"
+#include "core/event.hpp"
+#include "core/queue.hpp"
+#include "util/u_debug.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <unistd.h>
+
+using namespace clover;
+
+namespace {
+   struct entry {
+      intrusive_ref<hard_event> ev;
+      std::string name;
+      const char *category;
+      std::string args;
+   };
+
+   class recorder {
+   public:
+      recorder(const char *path) :
+         file(path ? std::fopen(path, "w") : NULL), first(true) {
+         if (file)
+            std::fputs("[\n", file);
+      }
+
+      ~recorder() {
+         if (!file)
+            return;
+
+         write_completed();
+
+         // The commands still running are leaked, their queues may
+         // have no device to talk to at this point.
+         for (auto &e : pending)
+            e.ev().retain();
+
+         std::fputs("\n]\n", file);
+         std::fclose(file);
+      }
+
+      recorder(const recorder &) = delete;
+      recorder &
+      operator=(const recorder &) = delete;
+
+      void
+      push(entry &&e) {
+         std::lock_guard<std::mutex> lock(mutex);
+         pending.push_back(std::move(e));
+
+         // Commands mostly complete in submission order, only check
+         // the oldest ones here to keep the overhead low.
+         while (!pending.empty() && write(pending.front()))
+            pending.pop_front();
+      }
+
+      void
+      flush() {
+         std::lock_guard<std::mutex> lock(mutex);
+         write_completed();
+         std::fflush(file);
+      }
+
+      FILE *const file;
+
+   private:
+      void
+      write_completed() {
+         auto last = pending.begin();
+
+         for (auto it = pending.begin(); it != pending.end(); ++it) {
+            if (!write(*it))
+               *last++ = std::move(*it);
+         }
+
+         pending.erase(last, pending.end());
+      }
+
+      ///
+      /// Write \a e out if it's done, returns false if it's still
+      /// running.
+      ///
+      bool
+      write(const entry &e) {
+         const hard_event &ev = e.ev();
+         const cl_int status = ev.status();
+
+         if (status < 0)
+            return true;
+         else if (status != CL_COMPLETE)
+            return false;
+
+         try {
+            const cl_ulong queued = ev.time_queued();
+            const cl_ulong submit = ev.time_submit();
+            const cl_ulong start = ev.time_start();
+            const cl_ulong end = ev.time_end();
+            const auto id = queue_ids.emplace(ev.queue(),
+                                              queue_ids.size()).first->second;
+
+            std::fprintf(file, "%s{\"name\": \"%s\", \"cat\": \"%s\", "
+                         "\"ph\": \"X\", \"pid\": %d, \"tid\": %u, "
+                         "\"ts\": %.3f, \"dur\": %.3f, \"args\": {"
+                         "\"queued\": %" PRIu64 ", \"submit\": %" PRIu64
+                         ", \"start\": %" PRIu64 ", \"end\": %" PRIu64 "%s}}",
+                         first ? "" : ",\n", e.name.c_str(), e.category,
+                         (int)getpid(), id, start / 1000.0,
+                         (end - start) / 1000.0, (uint64_t)queued,
+                         (uint64_t)submit, (uint64_t)start, (uint64_t)end,
+                         e.args.c_str());
+            first = false;
+
+         } catch (error &) {
+            // The timestamps aren't available, drop the command.
+         }
+
+         return true;
+      }
+
+      std::mutex mutex;
+      std::deque<entry> pending;
+      std::map<const command_queue *, unsigned> queue_ids;
+      bool first;
+   };
+
+   recorder &
+   get_recorder() {
+      static recorder r(debug_get_option("CLOVER_TRACE_FILE", NULL));
+      return r;
+   }
+
+   const char *
+   command_name(cl_command_type command) {
+      switch (command) {
+      case CL_COMMAND_READ_BUFFER:
+         return "read_buffer";
+      case CL_COMMAND_WRITE_BUFFER:
+         return "write_buffer";
+      case CL_COMMAND_COPY_BUFFER:
+         return "copy_buffer";
+      case CL_COMMAND_FILL_BUFFER:
+         return "fill_buffer";
+      case CL_COMMAND_READ_BUFFER_RECT:
+         return "read_buffer_rect";
+      case CL_COMMAND_WRITE_BUFFER_RECT:
+         return "write_buffer_rect";
+      case CL_COMMAND_COPY_BUFFER_RECT:
+         return "copy_buffer_rect";
+      case CL_COMMAND_READ_IMAGE:
+         return "read_image";
+      case CL_COMMAND_WRITE_IMAGE:
+         return "write_image";
+      case CL_COMMAND_COPY_IMAGE:
+         return "copy_image";
+      case CL_COMMAND_FILL_IMAGE:
+         return "fill_image";
+      case CL_COMMAND_COPY_IMAGE_TO_BUFFER:
+         return "copy_image_to_buffer";
+      case CL_COMMAND_COPY_BUFFER_TO_IMAGE:
+         return "copy_buffer_to_image";
+      default:
+         return "transfer";
+      }
+   }
+
+   std::string
+   format_size(const char *name, const std::vector<size_t> &size) {
+      std::ostringstream s;
+
+      s << ", \"" << name << "\": [";
+      for (size_t i = 0; i < size.size(); ++i)
+         s << (i ? ", " : "") << size[i];
+      s << "]";
+
+      return s.str();
+   }
+}
+
+bool
+trace::enabled() {
+   return get_recorder().file;
+}
+
+void
+trace::record(hard_event &ev, const std::string &kernel,
+              const std::vector<size_t> &grid_size,
+              const std::vector<size_t> &block_size) {
+   if (!enabled())
+      return;
+
+   get_recorder().push({ ev, kernel, "kernel",
+                         format_size("global_size", grid_size) +
+                         format_size("local_size", block_size) });
+}
+
+void
+trace::record(hard_event &ev, size_t size) {
+   if (!enabled())
+      return;
+
+   get_recorder().push({ ev, command_name(ev.command()), "transfer",
+                         ", \"bytes\": " + std::to_string(size) });
+}
+
+void
+trace::flush() {
+   if (!enabled())
+      return;
+
+   get_recorder().flush();
+}
@@ -0,0 +1,64 @@
+//
+// Copyright 2021 The Mesa Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef CLOVER_CORE_TRACE_HPP
+#define CLOVER_CORE_TRACE_HPP
+
+#include <string>
+#include <vector>
+
+namespace clover {
+   class hard_event;
+
+   ///
+   /// Recorder of the commands executed by every command queue of the
+   /// process.  If CLOVER_TRACE_FILE is set the commands are written
+   /// as Chrome trace events to the given file as soon as they
+   /// complete, along with their GPU timestamps.
+   ///
+   namespace trace {
+      ///
+      /// Whether the trace is being recorded.  Event timestamps are
+      /// collected for every command queue in that case.
+      ///
+      bool enabled();
+
+      ///
+      /// Record the execution of \a kernel by \a ev.
+      ///
+      void record(hard_event &ev, const std::string &kernel,
+                  const std::vector<size_t> &grid_size,
+                  const std::vector<size_t> &block_size);
+
+      ///
+      /// Record a transfer of \a size bytes executed by \a ev.
+      ///
+      void record(hard_event &ev, size_t size);
+
+      ///
+      /// Write out the recorded commands that have completed so far.
+      ///
+      void flush();
+   }
+}
+
+#endif
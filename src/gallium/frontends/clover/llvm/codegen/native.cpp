@@ -27,12 +27,15 @@
 /// executable code as an ELF object file.
 ///
 
+#include <future>
+
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Support/TargetRegistry.h>
 #include <llvm/Transforms/Utils/Cloning.h>
 
 #include "llvm/codegen.hpp"
 #include "llvm/compat.hpp"
+#include "llvm/metadata.hpp"
 #include "llvm/util.hpp"
 #include "core/error.hpp"
 
@@ -88,6 +91,10 @@ namespace {
          unsigned i = 0;
 
          while (GElf_Sym *s = gelf_getsym(symtab_data, i++, &symbol)) {
+            // Functions defined in other parts of a split module.
+            if (s->st_shndx == SHN_UNDEF)
+               continue;
+
             const char *name = elf_strptr(elf, header.sh_link, s->st_name);
             symbol_offsets[name] = s->st_value;
          }
@@ -141,12 +148,90 @@ namespace {
 
       return { data.begin(), data.end() };
    }
+
+   ///
+   /// Number of parts the module should be split into for concurrent code
+   /// generation, or one if it should be compiled as a whole.
+   ///
+   unsigned
+   get_codegen_parts(const ::llvm::Module &mod) {
+      static const unsigned threads =
+         debug_get_num_option("CLOVER_CODEGEN_THREADS", 1);
+      const auto kernels = get_kernels(mod);
+
+      // A kernel called by another one could end up in a different part
+      // than its caller, and nothing would resolve the call.
+      for (auto f : kernels) {
+         if (!f->use_empty())
+            return 1;
+      }
+
+      return std::max(1u, std::min<unsigned>(threads, kernels.size()));
+   }
+
+   ///
+   /// Split the module into \a n parts holding disjoint sets of kernels
+   /// and generate code for them concurrently.  Each part ends up in its
+   /// own text section of the resulting module.
+   ///
+   module
+   build_module_split(::llvm::Module &mod, unsigned n, const target &target,
+                      const clang::CompilerInstance &c, std::string &r_log) {
+      // LLVM contexts can't be shared across threads, so the parts are
+      // passed around as bitcode and parsed again by each thread.
+      std::vector<module> parts;
+      compat::split_module(mod, n, [&](std::unique_ptr< ::llvm::Module> part) {
+            if (any_of([](const ::llvm::Function *f) {
+                     return !f->isDeclaration();
+                  }, get_kernels(*part)))
+               parts.push_back(build_module_library(
+                                  *part, module::section::text_intermediate));
+         });
+
+      std::vector<std::string> logs(parts.size());
+      std::vector<std::future<std::vector<char>>> codes;
+      for (unsigned i = 0; i < parts.size(); i++) {
+         codes.push_back(std::async(std::launch::async, [&, i]() {
+                  ::llvm::LLVMContext ctx;
+                  auto part = parse_module_library(parts[i], ctx, logs[i]);
+                  return emit_code(*part, target, compat::CGFT_ObjectFile,
+                                   logs[i]);
+               }));
+      }
+
+      module m;
+      for (unsigned i = 0; i < parts.size(); i++) {
+         std::vector<char> code;
+         try {
+            code = codes[i].get();
+         } catch (...) {
+            r_log += logs[i];
+            throw;
+         }
+         r_log += logs[i];
+
+         auto mpart = build_module_common(mod, code,
+                                          get_symbol_offsets(code, r_log), c);
+         for (auto &sym : mpart.syms) {
+            sym.section = i;
+            m.syms.push_back(sym);
+         }
+         mpart.secs[0].id = i;
+         m.secs.push_back(mpart.secs[0]);
+      }
+
+      return m;
+   }
 }
 
 module
 clover::llvm::build_module_native(::llvm::Module &mod, const target &target,
                                   const clang::CompilerInstance &c,
                                   std::string &r_log) {
+   const unsigned n = get_codegen_parts(mod);
+   if (n > 1)
+      return build_module_split(mod, n, target, c, r_log);
+
    const auto code = emit_code(mod, target,
                                compat::CGFT_ObjectFile, r_log);
    return build_module_common(mod, code, get_symbol_offsets(code, r_log), c);
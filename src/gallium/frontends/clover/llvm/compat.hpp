@@ -47,6 +47,7 @@
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Transforms/IPO.h>
 #include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
 
 #include <clang/Basic/TargetInfo.h>
 #include <clang/Frontend/CompilerInstance.h>
@@ -132,6 +133,16 @@ namespace clover {
             return ::llvm::cast<::llvm::FixedVectorType>(type)->getNumElements();
 #else
             return ((::llvm::VectorType*)type)->getNumElements();
+#endif
+         }
+
+         template<typename F> inline void
+         split_module(::llvm::Module &mod, unsigned n, F &&f)
+         {
+#if LLVM_VERSION_MAJOR >= 13
+            ::llvm::SplitModule(mod, n, f, true);
+#else
+            ::llvm::SplitModule(::llvm::CloneModule(mod), n, f, true);
 #endif
          }
       }
@@ -59,6 +59,10 @@
 #endif
 #include "util/algorithm.hpp"
 
+#include <mutex>
+#include <sstream>
+#include <sys/stat.h>
+
 
 using clover::module;
 using clover::device;
@@ -112,15 +116,15 @@ namespace {
 
    void
    init_targets() {
-      static bool targets_initialized = false;
-      if (!targets_initialized) {
+      // Programs may be built for several devices at once.
+      static std::once_flag targets_initialized;
+      std::call_once(targets_initialized, []() {
          LLVMInitializeAllTargets();
          LLVMInitializeAllTargetInfos();
          LLVMInitializeAllTargetMCs();
          LLVMInitializeAllAsmParsers();
          LLVMInitializeAllAsmPrinters();
-         targets_initialized = true;
-      }
+      });
    }
 
    void
@@ -368,12 +372,104 @@ namespace {
 #endif
 }
 
+namespace {
+   ///
+   /// Incrementally built description of a compilation, used to compute
+   /// the disk cache key of its result.
+   ///
+   class cache_key_builder {
+   public:
+      cache_key_builder(const char *stage, const device &dev) {
+         add(stage);
+         add(dev.ir_target());
+         add(dev.device_name());
+         add(dev.device_version_as_string());
+         add(dev.device_clc_version_as_string());
+         add(dev.supported_extensions_as_string());
+         add(dev.image_support() ? "images" : "");
+      }
+
+      void
+      add(const std::string &s) {
+         os << s.size() << ':' << s;
+      }
+
+      void
+      compute(struct disk_cache *cache, cache_key key) const {
+         const std::string s = os.str();
+         disk_cache_compute_key(cache, s.data(), s.size(), key);
+      }
+
+   private:
+      std::ostringstream os;
+   };
+
+   bool
+   use_cache(const device &dev) {
+      // The cached results would bypass the dumps.
+      return dev.llvm_cache && !has_flag(debug::clc) &&
+         !has_flag(debug::llvm) && !has_flag(debug::native);
+   }
+
+   bool
+   load_cached_module(const device &dev, const cache_key key, module &m) {
+      size_t size;
+      void *data = disk_cache_get(dev.llvm_cache, key, &size);
+      if (!data)
+         return false;
+
+      bool found = true;
+      try {
+         std::istringstream is(std::string(static_cast<char *>(data), size));
+         m = module::deserialize(is);
+      } catch (...) {
+         found = false;
+      }
+      free(data);
+      return found;
+   }
+
+   void
+   store_cached_module(const device &dev, const cache_key key,
+                       const module &m) {
+      std::ostringstream os;
+      m.serialize(os);
+      const std::string s = os.str();
+      disk_cache_put(dev.llvm_cache, key, s.data(), s.size(), NULL);
+   }
+}
+
 module
 clover::llvm::compile_program(const std::string &source,
                               const header_map &headers,
                               const device &dev,
                               const std::string &opts,
                               std::string &r_log) {
+   cache_key key;
+   const bool cached = use_cache(dev);
+   if (cached) {
+      cache_key_builder kb("compile", dev);
+      kb.add(opts);
+      kb.add(source);
+      for (auto &header : headers) {
+         kb.add(header.first);
+         kb.add(header.second);
+      }
+
+      // libclc is linked in here, so the result depends on its version.
+      const std::string libclc = LIBCLC_LIBEXECDIR + dev.ir_target() + ".bc";
+      struct stat st;
+      kb.add(libclc);
+      if (!stat(libclc.c_str(), &st))
+         kb.add(std::to_string(st.st_mtime) + "-" + std::to_string(st.st_size));
+
+      kb.compute(dev.llvm_cache, key);
+
+      module m;
+      if (load_cached_module(dev, key, m))
+         return m;
+   }
+
    if (has_flag(debug::clc))
       debug::log(".cl", "// Options: " + opts + '\n' + source);
 
@@ -386,7 +482,12 @@ clover::llvm::compile_program(const std::string &source,
    if (has_flag(debug::llvm))
       debug::log(".ll", print_module_bitcode(*mod));
 
-   return build_module_library(*mod, module::section::text_intermediate);
+   const module m = build_module_library(*mod,
+                                         module::section::text_intermediate);
+   if (cached)
+      store_cached_module(dev, key, m);
+
+   return m;
 }
 
 namespace {
@@ -444,6 +545,23 @@ module
 clover::llvm::link_program(const std::vector<module> &modules,
                            const device &dev, const std::string &opts,
                            std::string &r_log) {
+   cache_key key;
+   const bool cached = use_cache(dev);
+   if (cached) {
+      cache_key_builder kb("link", dev);
+      kb.add(opts);
+      for (auto &m : modules) {
+         std::ostringstream os;
+         m.serialize(os);
+         kb.add(os.str());
+      }
+      kb.compute(dev.llvm_cache, key);
+
+      module m;
+      if (load_cached_module(dev, key, m))
+         return m;
+   }
+
    std::vector<std::string> options = tokenize(opts + " input.cl");
    const bool create_library = count("-create-library", options);
    erase_if(equals("-create-library"), options);
@@ -461,18 +579,44 @@ clover::llvm::link_program(const std::vector<module> &modules,
    if (has_flag(debug::llvm))
       debug::log(id + ".ll", print_module_bitcode(*mod));
 
+   module m;
    if (create_library) {
-      return build_module_library(*mod, module::section::text_library);
+      m = build_module_library(*mod, module::section::text_library);
 
    } else if (dev.ir_format() == PIPE_SHADER_IR_NATIVE) {
       if (has_flag(debug::native))
          debug::log(id +  ".asm", print_module_native(*mod, dev.ir_target()));
 
-      return build_module_native(*mod, dev.ir_target(), *c, r_log);
+      m = build_module_native(*mod, dev.ir_target(), *c, r_log);
 
    } else {
       unreachable("Unsupported IR.");
    }
+
+   if (cached)
+      store_cached_module(dev, key, m);
+
+   return m;
+}
+
+struct disk_cache *
+clover::llvm::create_llvm_disk_cache(void) {
+   struct mesa_sha1 ctx;
+   unsigned char sha1[20];
+   char cache_id[20 * 2 + 1];
+   _mesa_sha1_init(&ctx);
+
+   if (!disk_cache_get_function_identifier(
+          (void *)clover::llvm::create_llvm_disk_cache, &ctx))
+      return NULL;
+
+   // LLVM may be a shared library updated independently of Mesa.
+   const std::string llvm_version = LLVM_VERSION_STRING;
+   _mesa_sha1_update(&ctx, llvm_version.data(), llvm_version.size());
+   _mesa_sha1_final(&ctx, sha1);
+
+   disk_cache_format_hex_id(cache_id, sha1, 20 * 2);
+   return disk_cache_create("clover-llvm", cache_id, 0);
 }
 
 #ifdef HAVE_CLOVER_SPIRV
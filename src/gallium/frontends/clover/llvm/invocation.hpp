@@ -27,6 +27,7 @@
 #include "core/module.hpp"
 #include "core/program.hpp"
 #include "pipe/p_defines.h"
+#include <util/disk_cache.h>
 
 namespace clover {
    namespace llvm {
@@ -41,6 +42,9 @@ namespace clover {
                           const std::string &opts,
                           std::string &r_log);
 
+      // cache for the results of compile_program() and link_program()
+      struct disk_cache *create_llvm_disk_cache(void);
+
 #ifdef HAVE_CLOVER_SPIRV
       module compile_to_spirv(const std::string &source,
                               const header_map &headers,
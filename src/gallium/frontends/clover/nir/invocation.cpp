@@ -22,6 +22,7 @@
 
 #include "invocation.hpp"
 
+#include <sstream>
 #include <tuple>
 
 #include "core/device.hpp"
@@ -35,6 +36,7 @@
 #include <compiler/nir/nir_builder.h>
 #include <compiler/nir/nir_serialize.h>
 #include <compiler/spirv/nir_spirv.h>
+#include <util/mesa-sha1.h>
 #include <util/u_math.h>
 
 using namespace clover;
@@ -396,9 +398,80 @@ nir_shader *clover::nir::load_libclc_nir(const device &dev, std::string &r_log)
 				 &spirv_options, compiler_options);
 }
 
+std::string clover::nir::hash_libclc_nir(const device &dev)
+{
+   std::shared_ptr<nir_shader> nir = dev.clc_nir;
+   unsigned char sha1[20];
+   char hash[20 * 2 + 1];
+
+   struct blob blob;
+   blob_init(&blob);
+   nir_serialize(&blob, nir.get(), false);
+   _mesa_sha1_compute(blob.data, blob.size, sha1);
+   blob_finish(&blob);
+
+   disk_cache_format_hex_id(hash, sha1, 20 * 2);
+   return hash;
+}
+
+static void
+compute_module_key(const module &mod, const device &dev, cache_key key)
+{
+   std::ostringstream os;
+
+   // Everything the translation below depends on besides the SPIR-V itself.
+   os << "spirv_to_nir" << '\0' << dev.device_name() << '\0'
+      << dev.ir_target() << '\0' << dev.address_bits() << '\0'
+      << dev.image_support() << dev.has_int64_atomics() << '\0'
+      << std::string(dev.clc_nir_hash) << '\0';
+   mod.serialize(os);
+
+   const std::string s = os.str();
+   disk_cache_compute_key(dev.clc_cache, s.data(), s.size(), key);
+}
+
+static bool
+load_cached_module(const device &dev, const cache_key key, module &m)
+{
+   size_t size;
+   void *data = disk_cache_get(dev.clc_cache, key, &size);
+   if (!data)
+      return false;
+
+   bool found = true;
+   try {
+      std::istringstream is(std::string(static_cast<char *>(data), size));
+      m = module::deserialize(is);
+   } catch (...) {
+      found = false;
+   }
+   free(data);
+   return found;
+}
+
+static void
+store_cached_module(const device &dev, const cache_key key, const module &m)
+{
+   std::ostringstream os;
+   m.serialize(os);
+   const std::string s = os.str();
+   disk_cache_put(dev.clc_cache, key, s.data(), s.size(), NULL);
+}
+
 module clover::nir::spirv_to_nir(const module &mod, const device &dev,
                                  std::string &r_log)
 {
+   // The result only holds the serialized nir of each kernel, so a previous
+   // translation of the same module can be reused as is.
+   cache_key key;
+   if (dev.clc_cache) {
+      compute_module_key(mod, dev, key);
+
+      module m;
+      if (load_cached_module(dev, key, m))
+         return m;
+   }
+
    spirv_to_nir_options spirv_options = create_spirv_options(dev, r_log);
    std::shared_ptr<nir_shader> nir = dev.clc_nir;
    spirv_options.clc_shader = nir.get();
@@ -586,6 +659,10 @@ module clover::nir::spirv_to_nir(const module &mod, const device &dev,
       m.secs.push_back(text);
       section_id++;
    }
+
+   if (dev.clc_cache)
+      store_cached_module(dev, key, m);
+
    return m;
 }
 #else
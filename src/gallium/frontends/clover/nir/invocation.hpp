@@ -38,6 +38,10 @@ namespace clover {
 
       struct disk_cache *create_clc_disk_cache(void);
 
+      // hashes the libclc nir of the device, so that cached spirv_to_nir()
+      // results are invalidated along with it
+      std::string hash_libclc_nir(const device &dev);
+
       // converts a given spirv module to nir
       module spirv_to_nir(const module &mod, const device &dev, std::string &r_log);
    }
@@ -22,6 +22,7 @@
 
 #include "invocation.hpp"
 
+#include <sstream>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -37,6 +38,7 @@
 #include "llvm/util.hpp"
 #include "pipe/p_state.h"
 #include "util/algorithm.hpp"
+#include "util/disk_cache.h"
 #include "util/functional.hpp"
 #include "util/u_math.h"
 
@@ -747,6 +749,35 @@ clover::spirv::compile_program(const std::string &binary,
                                    dev.address_bits() == 32 ? 4u : 8u, r_log);
 }
 
+namespace {
+   bool
+   load_cached_module(const device &dev, const cache_key key, module &m) {
+      size_t size;
+      void *data = disk_cache_get(dev.clc_cache, key, &size);
+      if (!data)
+         return false;
+
+      bool found = true;
+      try {
+         std::istringstream is(std::string(static_cast<char *>(data), size));
+         m = module::deserialize(is);
+      } catch (...) {
+         found = false;
+      }
+      free(data);
+      return found;
+   }
+
+   void
+   store_cached_module(const device &dev, const cache_key key,
+                       const module &m) {
+      std::ostringstream os;
+      m.serialize(os);
+      const std::string s = os.str();
+      disk_cache_put(dev.clc_cache, key, s.data(), s.size(), NULL);
+   }
+}
+
 module
 clover::spirv::link_program(const std::vector<module> &modules,
                             const device &dev, const std::string &opts,
@@ -768,6 +799,24 @@ clover::spirv::link_program(const std::vector<module> &modules,
             + "\n";
    }
 
+   // The linked binary only depends on the input modules and on whether a
+   // library is created.  A cached result would bypass the SPIR-V dump.
+   cache_key key;
+   const bool cached = dev.clc_cache && !has_flag(llvm::debug::spirv);
+   if (cached) {
+      std::ostringstream os;
+      os << "link" << '\0' << dev.device_version() << '\0' << create_library;
+      for (const auto &mod : modules)
+         mod.serialize(os);
+
+      const std::string s = os.str();
+      disk_cache_compute_key(dev.clc_cache, s.data(), s.size(), key);
+
+      module m;
+      if (load_cached_module(dev, key, m))
+         return m;
+   }
+
    spvtools::LinkerOptions linker_options;
    linker_options.SetCreateLibrary(create_library);
 
@@ -833,6 +882,9 @@ clover::spirv::link_program(const std::vector<module> &modules,
 
    m.secs.emplace_back(make_text_section(final_binary, section_type));
 
+   if (cached)
+      store_cached_module(dev, key, m);
+
    return m;
 }
 
@@ -0,0 +1,303 @@
+/*
+ * Copyright © 2021 Mesa contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Measures the CPU cost of clover's launch path: kernel enqueues, kernel
+ * argument setup, small buffer transfers and event waits.
+ *
+ * Run it against the noop driver (or llvmpipe) so that the device doesn't
+ * do any real work:
+ *
+ *    GALLIUM_NOOP=1 LD_LIBRARY_PATH=<build>/src/gallium/targets/opencl \
+ *    ./cl-overhead [iterations] [filter]
+ *
+ * The results are printed as CSV, one line per benchmark, with the time per
+ * iteration both wall-clock and CPU time of the process, the latter also
+ * includes the threads of the driver and of clover.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <CL/cl.h>
+
+#include "util/os_time.h"
+
+/* Pending commands are flushed every so often, so that the queue doesn't
+ * grow unbounded in the enqueue-only benchmarks.
+ */
+#define FINISH_INTERVAL 1024
+
+#define SMALL_SIZE 16
+
+struct bench_state {
+   cl_context ctx;
+   cl_command_queue q;
+   cl_kernel empty;
+   cl_kernel args;
+   cl_mem buf;
+   char data[SMALL_SIZE];
+};
+
+struct bench {
+   const char *name;
+   void (*run)(struct bench_state *s, unsigned i);
+   /* Whether the benchmark leaves work in the queue. */
+   bool enqueues;
+};
+
+static const char *source =
+   "kernel void empty(void) {}\n"
+   "kernel void args(global int *p, int x, float4 v) {}\n";
+
+static const size_t global_size = 1;
+
+static cl_int errors;
+
+static void
+check(cl_int err)
+{
+   if (err != CL_SUCCESS)
+      errors++;
+}
+
+static bool
+create_context(struct bench_state *s)
+{
+   cl_platform_id platform;
+   cl_device_id dev;
+   char name[256];
+   cl_int err;
+
+   if (clGetPlatformIDs(1, &platform, NULL) != CL_SUCCESS ||
+       clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 1, &dev,
+                      NULL) != CL_SUCCESS) {
+      fprintf(stderr, "no OpenCL device available\n");
+      return false;
+   }
+
+   clGetDeviceInfo(dev, CL_DEVICE_NAME, sizeof(name), name, NULL);
+   fprintf(stderr, "CL_DEVICE_NAME: %s\n", name);
+
+   s->ctx = clCreateContext(NULL, 1, &dev, NULL, NULL, &err);
+   if (err != CL_SUCCESS)
+      return false;
+
+   s->q = clCreateCommandQueue(s->ctx, dev, 0, &err);
+   if (err != CL_SUCCESS)
+      return false;
+
+   cl_program prog = clCreateProgramWithSource(s->ctx, 1, &source, NULL,
+                                               &err);
+   if (err != CL_SUCCESS ||
+       clBuildProgram(prog, 1, &dev, NULL, NULL, NULL) != CL_SUCCESS) {
+      char log[4096] = "";
+      clGetProgramBuildInfo(prog, dev, CL_PROGRAM_BUILD_LOG, sizeof(log),
+                            log, NULL);
+      fprintf(stderr, "failed to build the kernels:\n%s\n", log);
+      return false;
+   }
+
+   s->empty = clCreateKernel(prog, "empty", &err);
+   if (err != CL_SUCCESS)
+      return false;
+
+   s->args = clCreateKernel(prog, "args", &err);
+   if (err != CL_SUCCESS)
+      return false;
+
+   clReleaseProgram(prog);
+
+   s->buf = clCreateBuffer(s->ctx, CL_MEM_READ_WRITE, SMALL_SIZE, NULL, &err);
+   if (err != CL_SUCCESS)
+      return false;
+
+   const cl_int x = 0;
+   const cl_float v[4] = { 0 };
+   return clSetKernelArg(s->args, 0, sizeof(s->buf), &s->buf) == CL_SUCCESS &&
+          clSetKernelArg(s->args, 1, sizeof(x), &x) == CL_SUCCESS &&
+          clSetKernelArg(s->args, 2, sizeof(v), v) == CL_SUCCESS;
+}
+
+static void
+run_enqueue_empty(struct bench_state *s, unsigned i)
+{
+   check(clEnqueueNDRangeKernel(s->q, s->empty, 1, NULL, &global_size, NULL,
+                                0, NULL, NULL));
+}
+
+static void
+run_enqueue_args(struct bench_state *s, unsigned i)
+{
+   check(clEnqueueNDRangeKernel(s->q, s->args, 1, NULL, &global_size, NULL,
+                                0, NULL, NULL));
+}
+
+static void
+run_set_arg_scalar(struct bench_state *s, unsigned i)
+{
+   const cl_int x = i;
+   check(clSetKernelArg(s->args, 1, sizeof(x), &x));
+}
+
+static void
+run_set_arg_vector(struct bench_state *s, unsigned i)
+{
+   const cl_float v[4] = { (cl_float)i, 0, 0, 0 };
+   check(clSetKernelArg(s->args, 2, sizeof(v), v));
+}
+
+static void
+run_set_arg_buffer(struct bench_state *s, unsigned i)
+{
+   check(clSetKernelArg(s->args, 0, sizeof(s->buf), &s->buf));
+}
+
+static void
+run_set_arg_enqueue(struct bench_state *s, unsigned i)
+{
+   const cl_int x = i;
+   check(clSetKernelArg(s->args, 1, sizeof(x), &x));
+   check(clEnqueueNDRangeKernel(s->q, s->args, 1, NULL, &global_size, NULL,
+                                0, NULL, NULL));
+}
+
+static void
+run_write_small(struct bench_state *s, unsigned i)
+{
+   check(clEnqueueWriteBuffer(s->q, s->buf, CL_TRUE, 0, SMALL_SIZE, s->data,
+                              0, NULL, NULL));
+}
+
+static void
+run_read_small(struct bench_state *s, unsigned i)
+{
+   check(clEnqueueReadBuffer(s->q, s->buf, CL_TRUE, 0, SMALL_SIZE, s->data,
+                             0, NULL, NULL));
+}
+
+static void
+run_map_small(struct bench_state *s, unsigned i)
+{
+   cl_int err;
+   void *p = clEnqueueMapBuffer(s->q, s->buf, CL_TRUE, CL_MAP_WRITE, 0,
+                                SMALL_SIZE, 0, NULL, NULL, &err);
+   check(err);
+   if (p)
+      check(clEnqueueUnmapMemObject(s->q, s->buf, p, 0, NULL, NULL));
+}
+
+static void
+run_event_wait(struct bench_state *s, unsigned i)
+{
+   cl_event ev;
+   check(clEnqueueNDRangeKernel(s->q, s->empty, 1, NULL, &global_size, NULL,
+                                0, NULL, &ev));
+   check(clWaitForEvents(1, &ev));
+   clReleaseEvent(ev);
+}
+
+static void
+run_finish(struct bench_state *s, unsigned i)
+{
+   check(clEnqueueNDRangeKernel(s->q, s->empty, 1, NULL, &global_size, NULL,
+                                0, NULL, NULL));
+   check(clFinish(s->q));
+}
+
+static const struct bench benches[] = {
+   { "enqueue_empty",     run_enqueue_empty,   true },
+   { "enqueue_args",      run_enqueue_args,    true },
+   { "set_arg_scalar",    run_set_arg_scalar,  false },
+   { "set_arg_vector",    run_set_arg_vector,  false },
+   { "set_arg_buffer",    run_set_arg_buffer,  false },
+   { "set_arg+enqueue",   run_set_arg_enqueue, true },
+   { "write_small",       run_write_small,     false },
+   { "read_small",        run_read_small,      false },
+   { "map_unmap_small",   run_map_small,       true },
+   { "event_wait",        run_event_wait,      false },
+   { "enqueue+finish",    run_finish,          false },
+};
+
+static int64_t
+cpu_time_nano(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+   return ts.tv_sec * INT64_C(1000000000) + ts.tv_nsec;
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned iterations = argc > 1 ? atoi(argv[1]) : 100000;
+   const char *filter = argc > 2 ? argv[2] : NULL;
+   struct bench_state s = { 0 };
+
+   if (!iterations || !create_context(&s))
+      return 1;
+
+   printf("benchmark,iterations,ns_per_iter,cpu_ns_per_iter,errors\n");
+
+   for (unsigned b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+      const struct bench *bench = &benches[b];
+
+      if (filter && !strstr(bench->name, filter))
+         continue;
+
+      /* Warm up, so that the kernels get their compute states and the
+       * transfer paths their staging buffers before measuring.
+       */
+      for (unsigned i = 0; i < 64; i++)
+         bench->run(&s, i);
+      clFinish(s.q);
+      errors = 0;
+
+      int64_t cpu_start = cpu_time_nano();
+      int64_t start = os_time_get_nano();
+      for (unsigned i = 0; i < iterations; i++) {
+         bench->run(&s, i);
+         if (bench->enqueues && (i + 1) % FINISH_INTERVAL == 0)
+            clFinish(s.q);
+      }
+      clFinish(s.q);
+      int64_t elapsed = os_time_get_nano() - start;
+      int64_t cpu_elapsed = cpu_time_nano() - cpu_start;
+
+      printf("%s,%u,%.1f,%.1f,%d\n", bench->name, iterations,
+             (double)elapsed / iterations, (double)cpu_elapsed / iterations,
+             errors);
+   }
+
+   clReleaseMemObject(s.buf);
+   clReleaseKernel(s.args);
+   clReleaseKernel(s.empty);
+   clReleaseCommandQueue(s.q);
+   clReleaseContext(s.ctx);
+
+   return 0;
+}
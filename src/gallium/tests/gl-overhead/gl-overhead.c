@@ -0,0 +1,484 @@
+/*
+ * Copyright © 2021 Mesa contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Measures the CPU overhead of the GL frontend and the state tracker, i.e.
+ * _mesa_update_state, st_validate_state, the uniform, buffer and vertex
+ * array paths, for draw calls with different kinds of state changes.
+ *
+ * Run it with the noop driver so that the driver doesn't do any work:
+ *
+ *    GALLIUM_NOOP=1 EGL_PLATFORM=surfaceless \
+ *    LIBGL_DRIVERS_PATH=<build>/src/gallium/targets/dri \
+ *    LD_LIBRARY_PATH=<build>/src/egl ./gl-overhead [iterations] [filter]
+ *
+ * For every benchmark the time per iteration and per GL call is printed,
+ * both wall-clock and CPU time of the process, the latter also includes
+ * driver threads.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "util/os_time.h"
+
+#define NUM_PROGRAMS 2
+#define NUM_TEXTURES 2
+#define NUM_VAOS 2
+#define NUM_UBOS 2
+
+#define GL_FUNCS(X) \
+   X(void, AttachShader, (GLuint program, GLuint shader)) \
+   X(void, BindBuffer, (GLenum target, GLuint buffer)) \
+   X(void, BindBufferBase, (GLenum target, GLuint index, GLuint buffer)) \
+   X(void, BindFramebuffer, (GLenum target, GLuint framebuffer)) \
+   X(void, BindRenderbuffer, (GLenum target, GLuint renderbuffer)) \
+   X(void, BindTexture, (GLenum target, GLuint texture)) \
+   X(void, BindVertexArray, (GLuint array)) \
+   X(void, BlendFunc, (GLenum sfactor, GLenum dfactor)) \
+   X(void, BufferData, (GLenum target, GLsizeiptr size, const void *data, \
+                        GLenum usage)) \
+   X(void, BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, \
+                           const void *data)) \
+   X(GLenum, CheckFramebufferStatus, (GLenum target)) \
+   X(void, CompileShader, (GLuint shader)) \
+   X(GLuint, CreateProgram, (void)) \
+   X(GLuint, CreateShader, (GLenum type)) \
+   X(void, DepthFunc, (GLenum func)) \
+   X(void, Disable, (GLenum cap)) \
+   X(void, DrawArrays, (GLenum mode, GLint first, GLsizei count)) \
+   X(void, Enable, (GLenum cap)) \
+   X(void, EnableVertexAttribArray, (GLuint index)) \
+   X(void, Finish, (void)) \
+   X(void, FramebufferRenderbuffer, (GLenum target, GLenum attachment, \
+                                     GLenum renderbuffertarget, \
+                                     GLuint renderbuffer)) \
+   X(void, GenBuffers, (GLsizei n, GLuint *buffers)) \
+   X(void, GenFramebuffers, (GLsizei n, GLuint *framebuffers)) \
+   X(void, GenRenderbuffers, (GLsizei n, GLuint *renderbuffers)) \
+   X(void, GenTextures, (GLsizei n, GLuint *textures)) \
+   X(void, GenVertexArrays, (GLsizei n, GLuint *arrays)) \
+   X(GLenum, GetError, (void)) \
+   X(void, GetProgramiv, (GLuint program, GLenum pname, GLint *params)) \
+   X(const GLubyte *, GetString, (GLenum name)) \
+   X(GLuint, GetUniformBlockIndex, (GLuint program, \
+                                    const GLchar *uniformBlockName)) \
+   X(GLint, GetUniformLocation, (GLuint program, const GLchar *name)) \
+   X(void, LinkProgram, (GLuint program)) \
+   X(void, RenderbufferStorage, (GLenum target, GLenum internalformat, \
+                                 GLsizei width, GLsizei height)) \
+   X(void, ShaderSource, (GLuint shader, GLsizei count, \
+                          const GLchar *const *string, const GLint *length)) \
+   X(void, TexImage2D, (GLenum target, GLint level, GLint internalformat, \
+                        GLsizei width, GLsizei height, GLint border, \
+                        GLenum format, GLenum type, const void *pixels)) \
+   X(void, TexParameteri, (GLenum target, GLenum pname, GLint param)) \
+   X(void, Uniform1i, (GLint location, GLint v0)) \
+   X(void, Uniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, \
+                       GLfloat v3)) \
+   X(void, Uniform4fv, (GLint location, GLsizei count, const GLfloat *value)) \
+   X(void, UniformBlockBinding, (GLuint program, GLuint uniformBlockIndex, \
+                                 GLuint uniformBlockBinding)) \
+   X(void, UseProgram, (GLuint program)) \
+   X(void, VertexAttribPointer, (GLuint index, GLint size, GLenum type, \
+                                 GLboolean normalized, GLsizei stride, \
+                                 const void *pointer)) \
+   X(void, Viewport, (GLint x, GLint y, GLsizei width, GLsizei height))
+
+static struct {
+#define DECLARE_GL_FUNC(ret, name, args) ret (APIENTRY *name) args;
+   GL_FUNCS(DECLARE_GL_FUNC)
+#undef DECLARE_GL_FUNC
+} gl;
+
+struct bench_state {
+   GLuint programs[NUM_PROGRAMS];
+   GLint color_loc[NUM_PROGRAMS];
+   GLuint textures[NUM_TEXTURES];
+   GLuint vaos[NUM_VAOS];
+   GLuint ubos[NUM_UBOS];
+   float color[4];
+};
+
+struct bench {
+   const char *name;
+   /* Number of GL calls done by one iteration */
+   unsigned calls;
+   void (*run)(struct bench_state *s, unsigned i);
+};
+
+static const char *vs_source =
+   "#version 140\n"
+   "in vec4 pos;\n"
+   "void main() { gl_Position = pos; }\n";
+
+static const char *fs_source =
+   "#version 140\n"
+   "uniform vec4 color;\n"
+   "uniform sampler2D tex;\n"
+   "uniform block { vec4 scale; };\n"
+   "out vec4 frag_color;\n"
+   "void main() {\n"
+   "   frag_color = color * scale * texture(tex, gl_FragCoord.xy / 64.0);\n"
+   "}\n";
+
+static bool
+load_gl_funcs(void)
+{
+   bool ok = true;
+
+#define LOAD_GL_FUNC(ret, name, args) \
+   gl.name = (ret (APIENTRY *) args) eglGetProcAddress("gl" #name); \
+   if (!gl.name) { \
+      fprintf(stderr, "gl" #name " is not available\n"); \
+      ok = false; \
+   }
+   GL_FUNCS(LOAD_GL_FUNC)
+#undef LOAD_GL_FUNC
+
+   return ok;
+}
+
+static bool
+create_context(void)
+{
+   PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+      eglGetProcAddress("eglGetPlatformDisplayEXT");
+   EGLDisplay dpy = EGL_NO_DISPLAY;
+   EGLint major, minor;
+
+   if (get_platform_display)
+      dpy = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                 EGL_DEFAULT_DISPLAY, NULL);
+   if (dpy == EGL_NO_DISPLAY)
+      dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+   if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, &major, &minor)) {
+      fprintf(stderr, "failed to initialize EGL\n");
+      return false;
+   }
+
+   if (!eglBindAPI(EGL_OPENGL_API)) {
+      fprintf(stderr, "desktop GL is not supported\n");
+      return false;
+   }
+
+   static const EGLint context_attribs[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 3,
+      EGL_CONTEXT_MINOR_VERSION, 1,
+      EGL_NONE
+   };
+   EGLContext ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT,
+                                     context_attribs);
+   if (ctx == EGL_NO_CONTEXT ||
+       !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+      fprintf(stderr, "failed to create a GL 3.1 context\n");
+      return false;
+   }
+
+   printf("EGL %d.%d, %s, %s\n", major, minor,
+          eglQueryString(dpy, EGL_VENDOR), eglQueryString(dpy, EGL_VERSION));
+   return true;
+}
+
+static GLuint
+create_program(void)
+{
+   GLuint prog = gl.CreateProgram();
+   GLuint vs = gl.CreateShader(GL_VERTEX_SHADER);
+   GLuint fs = gl.CreateShader(GL_FRAGMENT_SHADER);
+   GLint status;
+
+   gl.ShaderSource(vs, 1, &vs_source, NULL);
+   gl.CompileShader(vs);
+   gl.ShaderSource(fs, 1, &fs_source, NULL);
+   gl.CompileShader(fs);
+   gl.AttachShader(prog, vs);
+   gl.AttachShader(prog, fs);
+   gl.LinkProgram(prog);
+   gl.GetProgramiv(prog, GL_LINK_STATUS, &status);
+   return status ? prog : 0;
+}
+
+static bool
+init_state(struct bench_state *s)
+{
+   static const float verts[] = { -1, -1, 0, 1,  3, -1, 0, 1,  -1, 3, 0, 1 };
+   static const float scale[4] = { 1, 1, 1, 1 };
+   static const uint32_t texel = 0xffffffff;
+   GLuint fb, rb, vbo;
+
+   /* Surfaceless contexts have no window system framebuffer. */
+   gl.GenRenderbuffers(1, &rb);
+   gl.BindRenderbuffer(GL_RENDERBUFFER, rb);
+   gl.RenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 64, 64);
+   gl.GenFramebuffers(1, &fb);
+   gl.BindFramebuffer(GL_FRAMEBUFFER, fb);
+   gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, rb);
+   if (gl.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+      return false;
+   gl.Viewport(0, 0, 64, 64);
+
+   for (unsigned i = 0; i < NUM_PROGRAMS; i++) {
+      s->programs[i] = create_program();
+      if (!s->programs[i])
+         return false;
+
+      gl.UseProgram(s->programs[i]);
+      s->color_loc[i] = gl.GetUniformLocation(s->programs[i], "color");
+      gl.Uniform1i(gl.GetUniformLocation(s->programs[i], "tex"), 0);
+      gl.UniformBlockBinding(s->programs[i],
+                             gl.GetUniformBlockIndex(s->programs[i], "block"),
+                             0);
+      gl.Uniform4f(s->color_loc[i], 1, 1, 1, 1);
+   }
+   gl.UseProgram(s->programs[0]);
+
+   gl.GenTextures(NUM_TEXTURES, s->textures);
+   for (unsigned i = 0; i < NUM_TEXTURES; i++) {
+      gl.BindTexture(GL_TEXTURE_2D, s->textures[i]);
+      gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      gl.TexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA,
+                    GL_UNSIGNED_BYTE, &texel);
+   }
+   gl.BindTexture(GL_TEXTURE_2D, s->textures[0]);
+
+   gl.GenBuffers(NUM_UBOS, s->ubos);
+   for (unsigned i = 0; i < NUM_UBOS; i++) {
+      gl.BindBuffer(GL_UNIFORM_BUFFER, s->ubos[i]);
+      gl.BufferData(GL_UNIFORM_BUFFER, sizeof(scale), scale, GL_DYNAMIC_DRAW);
+   }
+   gl.BindBufferBase(GL_UNIFORM_BUFFER, 0, s->ubos[0]);
+
+   gl.GenBuffers(1, &vbo);
+   gl.BindBuffer(GL_ARRAY_BUFFER, vbo);
+   gl.BufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+   gl.GenVertexArrays(NUM_VAOS, s->vaos);
+   for (unsigned i = 0; i < NUM_VAOS; i++) {
+      gl.BindVertexArray(s->vaos[i]);
+      gl.VertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, NULL);
+      gl.EnableVertexAttribArray(0);
+   }
+   gl.BindVertexArray(s->vaos[0]);
+
+   return gl.GetError() == GL_NO_ERROR;
+}
+
+static void
+draw(void)
+{
+   gl.DrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static void
+run_draw(struct bench_state *s, unsigned i)
+{
+   draw();
+}
+
+static void
+run_draw_blend(struct bench_state *s, unsigned i)
+{
+   if (i & 1)
+      gl.Enable(GL_BLEND);
+   else
+      gl.Disable(GL_BLEND);
+   draw();
+}
+
+static void
+run_draw_depth_func(struct bench_state *s, unsigned i)
+{
+   gl.DepthFunc(i & 1 ? GL_LESS : GL_LEQUAL);
+   draw();
+}
+
+static void
+run_draw_blend_func(struct bench_state *s, unsigned i)
+{
+   gl.BlendFunc(GL_ONE, i & 1 ? GL_ONE : GL_ZERO);
+   draw();
+}
+
+static void
+run_draw_program(struct bench_state *s, unsigned i)
+{
+   gl.UseProgram(s->programs[i % NUM_PROGRAMS]);
+   draw();
+}
+
+static void
+run_draw_texture(struct bench_state *s, unsigned i)
+{
+   gl.BindTexture(GL_TEXTURE_2D, s->textures[i % NUM_TEXTURES]);
+   draw();
+}
+
+static void
+run_draw_vao(struct bench_state *s, unsigned i)
+{
+   gl.BindVertexArray(s->vaos[i % NUM_VAOS]);
+   draw();
+}
+
+static void
+run_draw_ubo(struct bench_state *s, unsigned i)
+{
+   gl.BindBufferBase(GL_UNIFORM_BUFFER, 0, s->ubos[i % NUM_UBOS]);
+   draw();
+}
+
+static void
+run_draw_uniform(struct bench_state *s, unsigned i)
+{
+   gl.Uniform4f(s->color_loc[0], (float)(i & 1), 1, 1, 1);
+   draw();
+}
+
+static void
+run_uniform(struct bench_state *s, unsigned i)
+{
+   gl.Uniform4f(s->color_loc[0], (float)(i & 1), 1, 1, 1);
+}
+
+static void
+run_uniform_same(struct bench_state *s, unsigned i)
+{
+   gl.Uniform4fv(s->color_loc[0], 1, s->color);
+}
+
+static void
+run_buffer_sub_data(struct bench_state *s, unsigned i)
+{
+   gl.BufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(s->color), s->color);
+   draw();
+}
+
+static void
+run_draw_all(struct bench_state *s, unsigned i)
+{
+   gl.UseProgram(s->programs[i % NUM_PROGRAMS]);
+   gl.Uniform4f(s->color_loc[i % NUM_PROGRAMS], (float)(i & 1), 1, 1, 1);
+   gl.BindTexture(GL_TEXTURE_2D, s->textures[i % NUM_TEXTURES]);
+   gl.BindVertexArray(s->vaos[i % NUM_VAOS]);
+   gl.BindBufferBase(GL_UNIFORM_BUFFER, 0, s->ubos[i % NUM_UBOS]);
+   draw();
+}
+
+static const struct bench benches[] = {
+   { "draw",                 1, run_draw },
+   { "draw+blend_enable",    2, run_draw_blend },
+   { "draw+depth_func",      2, run_draw_depth_func },
+   { "draw+blend_func",      2, run_draw_blend_func },
+   { "draw+use_program",     2, run_draw_program },
+   { "draw+bind_texture",    2, run_draw_texture },
+   { "draw+bind_vao",        2, run_draw_vao },
+   { "draw+bind_ubo",        2, run_draw_ubo },
+   { "draw+uniform",         2, run_draw_uniform },
+   { "draw+buffer_sub_data", 2, run_buffer_sub_data },
+   { "draw+all",             6, run_draw_all },
+   { "uniform",              1, run_uniform },
+   { "uniform_unchanged",    1, run_uniform_same },
+};
+
+static int64_t
+cpu_time_nano(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+   return ts.tv_sec * INT64_C(1000000000) + ts.tv_nsec;
+}
+
+static void
+reset_state(struct bench_state *s)
+{
+   gl.UseProgram(s->programs[0]);
+   gl.BindTexture(GL_TEXTURE_2D, s->textures[0]);
+   gl.BindVertexArray(s->vaos[0]);
+   gl.BindBufferBase(GL_UNIFORM_BUFFER, 0, s->ubos[0]);
+   gl.BindBuffer(GL_UNIFORM_BUFFER, s->ubos[0]);
+   gl.Disable(GL_BLEND);
+   gl.Finish();
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned iterations = argc > 1 ? atoi(argv[1]) : 200000;
+   const char *filter = argc > 2 ? argv[2] : NULL;
+   struct bench_state s = { .color = { 1, 1, 1, 1 } };
+
+   if (!iterations || !create_context() || !load_gl_funcs())
+      return 1;
+
+   printf("GL_RENDERER: %s\n", (const char *)gl.GetString(GL_RENDERER));
+   if (!init_state(&s)) {
+      fprintf(stderr, "failed to set up the GL state\n");
+      return 1;
+   }
+
+   printf("%-22s %10s %10s %10s %10s %10s\n", "benchmark", "calls",
+          "ns/iter", "ns/call", "cpu ns/call", "errors");
+
+   for (unsigned b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+      const struct bench *bench = &benches[b];
+
+      if (filter && !strstr(bench->name, filter))
+         continue;
+
+      reset_state(&s);
+
+      /* Warm up, so that all variants are compiled and the caches are
+       * populated before measuring.
+       */
+      for (unsigned i = 0; i < 64; i++)
+         bench->run(&s, i);
+      gl.Finish();
+
+      int64_t cpu_start = cpu_time_nano();
+      int64_t start = os_time_get_nano();
+      for (unsigned i = 0; i < iterations; i++)
+         bench->run(&s, i);
+      gl.Finish();
+      int64_t elapsed = os_time_get_nano() - start;
+      int64_t cpu_elapsed = cpu_time_nano() - cpu_start;
+
+      uint64_t calls = (uint64_t)iterations * bench->calls;
+      printf("%-22s %10" PRIu64 " %10.1f %10.1f %10.1f %10s\n", bench->name,
+             calls, (double)elapsed / iterations, (double)elapsed / calls,
+             (double)cpu_elapsed / calls,
+             gl.GetError() == GL_NO_ERROR ? "none" : "yes");
+   }
+
+   return 0;
+}
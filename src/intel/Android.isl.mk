@@ -259,6 +259,29 @@ include $(MESA_COMMON_MK)
 include $(BUILD_STATIC_LIBRARY)
 endif
 
+# ---------------------------------------
+# Build libmesa_isl_tiled_memcpy_avx2
+# ---------------------------------------
+
+ifeq ($(ARCH_X86_HAVE_AVX2),true)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := libmesa_isl_tiled_memcpy_avx2
+
+LOCAL_C_INCLUDES := \
+	$(MESA_TOP)/src/gallium/include \
+	$(MESA_TOP)/src/mapi \
+	$(MESA_TOP)/src/mesa
+
+LOCAL_SRC_FILES := $(ISL_TILED_MEMCPY_AVX2_FILES)
+
+LOCAL_CFLAGS += \
+        -DUSE_SSE41 -msse4.1 -mavx2 -mstackrealign
+
+include $(MESA_COMMON_MK)
+include $(BUILD_STATIC_LIBRARY)
+endif
+
 # ---------------------------------------
 # Build libmesa_isl
 # ---------------------------------------
@@ -299,6 +322,13 @@ LOCAL_WHOLE_STATIC_LIBRARIES += \
         libmesa_isl_tiled_memcpy_sse41
 endif
 
+ifeq ($(ARCH_X86_HAVE_AVX2),true)
+LOCAL_CFLAGS += \
+        -DUSE_AVX2
+LOCAL_WHOLE_STATIC_LIBRARIES += \
+        libmesa_isl_tiled_memcpy_avx2
+endif
+
 # Autogenerated sources
 
 LOCAL_MODULE_CLASS := STATIC_LIBRARIES
@@ -104,6 +104,10 @@ brw_compiler_create(void *mem_ctx, const struct gen_device_info *devinfo)
    brw_vec4_alloc_reg_set(compiler);
 
    compiler->precise_trig = env_var_as_boolean("INTEL_PRECISE_TRIG", false);
+   compiler->parallel_simd_nir =
+      env_var_as_boolean("INTEL_PARALLEL_SIMD_NIR", false);
+   compiler->pipelined_loop_scheduling =
+      env_var_as_boolean("INTEL_LOOP_SCHEDULING", false);
 
    compiler->use_tcs_8_patch =
       devinfo->ver >= 12 ||
@@ -213,6 +217,7 @@ brw_get_compiler_config_value(const struct brw_compiler *compiler)
 {
    uint64_t config = 0;
    insert_u64_bit(&config, compiler->precise_trig);
+   insert_u64_bit(&config, compiler->pipelined_loop_scheduling);
    if (compiler->devinfo->ver >= 8 && compiler->devinfo->ver < 10) {
       insert_u64_bit(&config, compiler->scalar_stage[MESA_SHADER_VERTEX]);
       insert_u64_bit(&config, compiler->scalar_stage[MESA_SHADER_TESS_CTRL]);
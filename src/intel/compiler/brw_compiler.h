@@ -104,6 +104,19 @@ struct brw_compiler {
     */
    bool precise_trig;
 
+   /**
+    * Lower the NIR for the different SIMD widths of compute shaders on
+    * separate threads. This doesn't change the generated code.
+    */
+   bool parallel_simd_nir;
+
+   /**
+    * Schedule the bodies of small innermost loops after register allocation
+    * taking into account the latency of the values carried to the next
+    * iteration.
+    */
+   bool pipelined_loop_scheduling;
+
    /**
     * Is 3DSTATE_CONSTANT_*'s Constant Buffer 0 relative to Dynamic State
     * Base Address?  (If not, it's a normal GPU address.)
@@ -82,6 +82,7 @@
 #include "brw_shader.h"
 #include "brw_disasm_info.h"
 #include "dev/gen_debug.h"
+#include "c11/threads.h"
 
 static const uint32_t g45_control_index_table[32] = {
    0b00000000000000000,
@@ -953,6 +954,101 @@ static const uint32_t gfx12_3src_subreg_table[32] = {
    0b01000000000010000000, /* .0  .4  .0  .8  */
 };
 
+/* Compacting an instruction looks each of its uncompacted fields up in the
+ * tables above. Rather than searching them linearly, every table gets an
+ * open-addressed hash mapping a value to its index. With 64 slots for at most
+ * 32 entries almost every lookup is resolved by the first probe.
+ */
+#define COMPACT_HASH_SIZE 64
+
+struct compact_table_hash {
+   uint64_t key[COMPACT_HASH_SIZE];
+   int8_t index[COMPACT_HASH_SIZE]; /* -1 for an empty slot */
+};
+
+static inline unsigned
+compact_hash_slot(uint64_t value)
+{
+   /* Fibonacci hashing, keeping the top 6 bits */
+   return (value * 0x9e3779b97f4a7c15ull) >> 58;
+}
+
+static void
+compact_table_hash_insert(struct compact_table_hash *hash,
+                          uint64_t key, int index)
+{
+   for (unsigned s = compact_hash_slot(key);; s = (s + 1) % COMPACT_HASH_SIZE) {
+      if (hash->index[s] < 0) {
+         hash->key[s] = key;
+         hash->index[s] = index;
+         return;
+      }
+
+      /* Keep the first index of a duplicated entry, like a linear search
+       * would have found.
+       */
+      if (hash->key[s] == key)
+         return;
+   }
+}
+
+/* Returns the table index of \p key, or -1 if it isn't in the table. */
+static inline int
+compact_table_hash_lookup(const struct compact_table_hash *hash, uint64_t key)
+{
+   for (unsigned s = compact_hash_slot(key);; s = (s + 1) % COMPACT_HASH_SIZE) {
+      if (hash->index[s] < 0 || hash->key[s] == key)
+         return hash->index[s];
+   }
+}
+
+#define COMPACTION_TABLES(X) \
+   X(g45_control_index_table) \
+   X(g45_datatype_table) \
+   X(g45_subreg_table) \
+   X(g45_src_index_table) \
+   X(gfx6_control_index_table) \
+   X(gfx6_datatype_table) \
+   X(gfx6_subreg_table) \
+   X(gfx6_src_index_table) \
+   X(gfx7_control_index_table) \
+   X(gfx7_datatype_table) \
+   X(gfx7_subreg_table) \
+   X(gfx7_src_index_table) \
+   X(gfx8_control_index_table) \
+   X(gfx8_datatype_table) \
+   X(gfx8_subreg_table) \
+   X(gfx8_src_index_table) \
+   X(gfx11_datatype_table) \
+   X(gfx12_control_index_table) \
+   X(gfx12_datatype_table) \
+   X(gfx12_subreg_table) \
+   X(gfx12_src0_index_table) \
+   X(gfx12_src1_index_table) \
+   X(gfx8_3src_control_index_table) \
+   X(gfx8_3src_source_index_table) \
+   X(gfx12_3src_control_index_table) \
+   X(gfx12_3src_source_index_table) \
+   X(gfx12_3src_subreg_table)
+
+#define DECLARE_TABLE_HASH(table) \
+   static struct compact_table_hash table##_hash;
+COMPACTION_TABLES(DECLARE_TABLE_HASH)
+#undef DECLARE_TABLE_HASH
+
+static once_flag compaction_hashes_once_flag = ONCE_FLAG_INIT;
+
+static void
+init_compaction_hashes(void)
+{
+#define INIT_TABLE_HASH(table)                                     \
+   memset(table##_hash.index, -1, sizeof(table##_hash.index));     \
+   for (unsigned i = 0; i < ARRAY_SIZE(table); i++)                \
+      compact_table_hash_insert(&table##_hash, table[i], i);
+   COMPACTION_TABLES(INIT_TABLE_HASH)
+#undef INIT_TABLE_HASH
+}
+
 struct compaction_state {
    const struct gen_device_info *devinfo;
    const uint32_t *control_index_table;
@@ -960,6 +1056,11 @@ struct compaction_state {
    const uint16_t *subreg_table;
    const uint16_t *src0_index_table;
    const uint16_t *src1_index_table;
+   const struct compact_table_hash *control_index_hash;
+   const struct compact_table_hash *datatype_hash;
+   const struct compact_table_hash *subreg_hash;
+   const struct compact_table_hash *src0_index_hash;
+   const struct compact_table_hash *src1_index_hash;
 };
 
 static void compaction_state_init(struct compaction_state *c,
@@ -1000,14 +1101,12 @@ set_control_index(const struct compaction_state *c,
          uncompacted |= brw_inst_bits(src, 90, 89) << 17; /* 2b */
    }
 
-   for (int i = 0; i < 32; i++) {
-      if (c->control_index_table[i] == uncompacted) {
-         brw_compact_inst_set_control_index(devinfo, dst, i);
-	 return true;
-      }
-   }
+   int index = compact_table_hash_lookup(c->control_index_hash, uncompacted);
+   if (index < 0)
+      return false;
 
-   return false;
+   brw_compact_inst_set_control_index(devinfo, dst, index);
+   return true;
 }
 
 static bool
@@ -1043,14 +1142,12 @@ set_datatype_index(const struct compaction_state *c, brw_compact_inst *dst,
                     (brw_inst_bits(src, 46, 32));        /* 15b */
    }
 
-   for (int i = 0; i < 32; i++) {
-      if (c->datatype_table[i] == uncompacted) {
-         brw_compact_inst_set_datatype_index(devinfo, dst, i);
-	 return true;
-      }
-   }
+   int index = compact_table_hash_lookup(c->datatype_hash, uncompacted);
+   if (index < 0)
+      return false;
 
-   return false;
+   brw_compact_inst_set_datatype_index(devinfo, dst, index);
+   return true;
 }
 
 static bool
@@ -1074,14 +1171,12 @@ set_subreg_index(const struct compaction_state *c, brw_compact_inst *dst,
          uncompacted |= brw_inst_bits(src, 100, 96) << 10; /* 5b */
    }
 
-   for (int i = 0; i < 32; i++) {
-      if (c->subreg_table[i] == uncompacted) {
-         brw_compact_inst_set_subreg_index(devinfo, dst, i);
-	 return true;
-      }
-   }
+   int index = compact_table_hash_lookup(c->subreg_hash, uncompacted);
+   if (index < 0)
+      return false;
 
-   return false;
+   brw_compact_inst_set_subreg_index(devinfo, dst, index);
+   return true;
 }
 
 static bool
@@ -1090,28 +1185,23 @@ set_src0_index(const struct compaction_state *c, brw_compact_inst *dst,
 {
    const struct gen_device_info *devinfo = c->devinfo;
    uint16_t uncompacted; /* 12b */
-   int table_len;
 
    if (devinfo->ver >= 12) {
-      table_len = ARRAY_SIZE(gfx12_src0_index_table);
       uncompacted = (brw_inst_bits(src, 87, 84) << 8) | /*  4b */
                     (brw_inst_bits(src, 83, 81) << 5) | /*  3b */
                     (brw_inst_bits(src, 80, 80) << 4) | /*  1b */
                     (brw_inst_bits(src, 65, 64) << 2) | /*  2b */
                     (brw_inst_bits(src, 45, 44));       /*  2b */
    } else {
-      table_len = ARRAY_SIZE(gfx8_src_index_table);
       uncompacted = brw_inst_bits(src, 88, 77);         /* 12b */
    }
 
-   for (int i = 0; i < table_len; i++) {
-      if (c->src0_index_table[i] == uncompacted) {
-         brw_compact_inst_set_src0_index(devinfo, dst, i);
-	 return true;
-      }
-   }
+   int index = compact_table_hash_lookup(c->src0_index_hash, uncompacted);
+   if (index < 0)
+      return false;
 
-   return false;
+   brw_compact_inst_set_src0_index(devinfo, dst, index);
+   return true;
 }
 
 static bool
@@ -1130,29 +1220,24 @@ set_src1_index(const struct compaction_state *c, brw_compact_inst *dst,
       return true;
    } else {
       uint16_t uncompacted; /* 12b */
-      int table_len;
 
       if (devinfo->ver >= 12) {
-         table_len = ARRAY_SIZE(gfx12_src0_index_table);
          uncompacted = (brw_inst_bits(src, 121, 120) << 10) | /*  2b */
                        (brw_inst_bits(src, 119, 116) <<  6) | /*  4b */
                        (brw_inst_bits(src, 115, 113) <<  3) | /*  3b */
                        (brw_inst_bits(src, 112, 112) <<  2) | /*  1b */
                        (brw_inst_bits(src,  97,  96));        /*  2b */
       } else {
-         table_len = ARRAY_SIZE(gfx8_src_index_table);
          uncompacted = brw_inst_bits(src, 120, 109);          /* 12b */
       }
 
-      for (int i = 0; i < table_len; i++) {
-         if (c->src1_index_table[i] == uncompacted) {
-            brw_compact_inst_set_src1_index(devinfo, dst, i);
-            return true;
-         }
-      }
-   }
+      int index = compact_table_hash_lookup(c->src1_index_hash, uncompacted);
+      if (index < 0)
+         return false;
 
-   return false;
+      brw_compact_inst_set_src1_index(devinfo, dst, index);
+      return true;
+   }
 }
 
 static bool
@@ -1182,11 +1267,11 @@ set_3src_control_index(const struct gen_device_info *devinfo,
          (brw_inst_bits(src, 21, 19) <<  3) | /*  3b */
          (brw_inst_bits(src, 18, 16));        /*  3b */
 
-      for (unsigned i = 0; i < ARRAY_SIZE(gfx12_3src_control_index_table); i++) {
-         if (gfx12_3src_control_index_table[i] == uncompacted) {
-            brw_compact_inst_set_3src_control_index(devinfo, dst, i);
-            return true;
-         }
+      int index = compact_table_hash_lookup(&gfx12_3src_control_index_table_hash,
+                                            uncompacted);
+      if (index >= 0) {
+         brw_compact_inst_set_3src_control_index(devinfo, dst, index);
+         return true;
       }
    } else {
       uint32_t uncompacted = /* 24b/BDW; 26b/CHV/SKL+ */
@@ -1198,11 +1283,11 @@ set_3src_control_index(const struct gen_device_info *devinfo,
             brw_inst_bits(src, 36, 35) << 24;  /*  2b */
       }
 
-      for (unsigned i = 0; i < ARRAY_SIZE(gfx8_3src_control_index_table); i++) {
-         if (gfx8_3src_control_index_table[i] == uncompacted) {
-            brw_compact_inst_set_3src_control_index(devinfo, dst, i);
-            return true;
-         }
+      int index = compact_table_hash_lookup(&gfx8_3src_control_index_table_hash,
+                                            uncompacted);
+      if (index >= 0) {
+         brw_compact_inst_set_3src_control_index(devinfo, dst, index);
+         return true;
       }
    }
 
@@ -1233,11 +1318,11 @@ set_3src_source_index(const struct gen_device_info *devinfo,
          (brw_inst_bits(src,  43,  43) <<  1) | /*  1b */
          (brw_inst_bits(src,  35,  35));        /*  1b */
 
-      for (unsigned i = 0; i < ARRAY_SIZE(gfx12_3src_source_index_table); i++) {
-         if (gfx12_3src_source_index_table[i] == uncompacted) {
-            brw_compact_inst_set_3src_source_index(devinfo, dst, i);
-            return true;
-         }
+      int index = compact_table_hash_lookup(&gfx12_3src_source_index_table_hash,
+                                            uncompacted);
+      if (index >= 0) {
+         brw_compact_inst_set_3src_source_index(devinfo, dst, index);
+         return true;
       }
    } else {
       uint64_t uncompacted =    /* 46b/BDW; 49b/CHV/SKL+ */
@@ -1258,11 +1343,11 @@ set_3src_source_index(const struct gen_device_info *devinfo,
             (brw_inst_bits(src, 104, 104) << 44);  /* 1b */
       }
 
-      for (unsigned i = 0; i < ARRAY_SIZE(gfx8_3src_source_index_table); i++) {
-         if (gfx8_3src_source_index_table[i] == uncompacted) {
-            brw_compact_inst_set_3src_source_index(devinfo, dst, i);
-            return true;
-         }
+      int index = compact_table_hash_lookup(&gfx8_3src_source_index_table_hash,
+                                            uncompacted);
+      if (index >= 0) {
+         brw_compact_inst_set_3src_source_index(devinfo, dst, index);
+         return true;
       }
    }
 
@@ -1281,14 +1366,13 @@ set_3src_subreg_index(const struct gen_device_info *devinfo,
       (brw_inst_bits(src,  71,  67) <<  5) | /*  5b */
       (brw_inst_bits(src,  55,  51));        /*  5b */
 
-   for (unsigned i = 0; i < ARRAY_SIZE(gfx12_3src_subreg_table); i++) {
-      if (gfx12_3src_subreg_table[i] == uncompacted) {
-         brw_compact_inst_set_3src_subreg_index(devinfo, dst, i);
-	 return true;
-      }
-   }
+   int index = compact_table_hash_lookup(&gfx12_3src_subreg_table_hash,
+                                         uncompacted);
+   if (index < 0)
+      return false;
 
-   return false;
+   brw_compact_inst_set_3src_subreg_index(devinfo, dst, index);
+   return true;
 }
 
 static bool
@@ -2214,51 +2298,83 @@ compaction_state_init(struct compaction_state *c,
    assert(gfx12_src0_index_table[ARRAY_SIZE(gfx12_src0_index_table) - 1] != 0);
    assert(gfx12_src1_index_table[ARRAY_SIZE(gfx12_src1_index_table) - 1] != 0);
 
+   call_once(&compaction_hashes_once_flag, init_compaction_hashes);
+
    c->devinfo = devinfo;
    switch (devinfo->ver) {
    case 12:
-      c->control_index_table = gfx12_control_index_table;;
+      c->control_index_table = gfx12_control_index_table;
+      c->control_index_hash = &gfx12_control_index_table_hash;
       c->datatype_table = gfx12_datatype_table;
+      c->datatype_hash = &gfx12_datatype_table_hash;
       c->subreg_table = gfx12_subreg_table;
+      c->subreg_hash = &gfx12_subreg_table_hash;
       c->src0_index_table = gfx12_src0_index_table;
+      c->src0_index_hash = &gfx12_src0_index_table_hash;
       c->src1_index_table = gfx12_src1_index_table;
+      c->src1_index_hash = &gfx12_src1_index_table_hash;
       break;
    case 11:
       c->control_index_table = gfx8_control_index_table;
+      c->control_index_hash = &gfx8_control_index_table_hash;
       c->datatype_table = gfx11_datatype_table;
+      c->datatype_hash = &gfx11_datatype_table_hash;
       c->subreg_table = gfx8_subreg_table;
+      c->subreg_hash = &gfx8_subreg_table_hash;
       c->src0_index_table = gfx8_src_index_table;
+      c->src0_index_hash = &gfx8_src_index_table_hash;
       c->src1_index_table = gfx8_src_index_table;
+      c->src1_index_hash = &gfx8_src_index_table_hash;
       break;
    case 9:
    case 8:
       c->control_index_table = gfx8_control_index_table;
+      c->control_index_hash = &gfx8_control_index_table_hash;
       c->datatype_table = gfx8_datatype_table;
+      c->datatype_hash = &gfx8_datatype_table_hash;
       c->subreg_table = gfx8_subreg_table;
+      c->subreg_hash = &gfx8_subreg_table_hash;
       c->src0_index_table = gfx8_src_index_table;
+      c->src0_index_hash = &gfx8_src_index_table_hash;
       c->src1_index_table = gfx8_src_index_table;
+      c->src1_index_hash = &gfx8_src_index_table_hash;
       break;
    case 7:
       c->control_index_table = gfx7_control_index_table;
+      c->control_index_hash = &gfx7_control_index_table_hash;
       c->datatype_table = gfx7_datatype_table;
+      c->datatype_hash = &gfx7_datatype_table_hash;
       c->subreg_table = gfx7_subreg_table;
+      c->subreg_hash = &gfx7_subreg_table_hash;
       c->src0_index_table = gfx7_src_index_table;
+      c->src0_index_hash = &gfx7_src_index_table_hash;
       c->src1_index_table = gfx7_src_index_table;
+      c->src1_index_hash = &gfx7_src_index_table_hash;
       break;
    case 6:
       c->control_index_table = gfx6_control_index_table;
+      c->control_index_hash = &gfx6_control_index_table_hash;
       c->datatype_table = gfx6_datatype_table;
+      c->datatype_hash = &gfx6_datatype_table_hash;
       c->subreg_table = gfx6_subreg_table;
+      c->subreg_hash = &gfx6_subreg_table_hash;
       c->src0_index_table = gfx6_src_index_table;
+      c->src0_index_hash = &gfx6_src_index_table_hash;
       c->src1_index_table = gfx6_src_index_table;
+      c->src1_index_hash = &gfx6_src_index_table_hash;
       break;
    case 5:
    case 4:
       c->control_index_table = g45_control_index_table;
+      c->control_index_hash = &g45_control_index_table_hash;
       c->datatype_table = g45_datatype_table;
+      c->datatype_hash = &g45_datatype_table_hash;
       c->subreg_table = g45_subreg_table;
+      c->subreg_hash = &g45_subreg_table_hash;
       c->src0_index_table = g45_src_index_table;
+      c->src0_index_hash = &g45_src_index_table_hash;
       c->src1_index_table = g45_src_index_table;
+      c->src1_index_hash = &g45_src_index_table_hash;
       break;
    default:
       unreachable("unknown generation");
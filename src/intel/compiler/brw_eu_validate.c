@@ -138,17 +138,54 @@ inst_dst_type(const struct gen_device_info *devinfo, const brw_inst *inst)
       brw_inst_dst_type(devinfo, inst) : BRW_REGISTER_TYPE_D;
 }
 
+/**
+ * The fields of a register operand, in their hardware encoding (except for
+ * the type).
+ */
+struct operand_info {
+   enum brw_reg_file file;
+   enum brw_reg_type type;
+   unsigned address_mode;
+   unsigned nr;
+   unsigned subnr;
+   unsigned vstride;
+   unsigned width;
+   unsigned hstride;
+};
+
+/**
+ * The parts of an instruction that most of the checks look at.
+ *
+ * They are decoded once per instruction, rather than through the brw_inst
+ * accessors (and the hardware type tables) by every check that needs them.
+ * The operands are decoded using the two-source instruction layout, so they
+ * are meaningless for three-source instructions.
+ */
+struct inst_info {
+   enum opcode opcode;
+   const struct opcode_desc *desc;
+   unsigned num_sources;
+   unsigned exec_size;
+   unsigned access_mode;
+   bool is_send;
+   bool is_split_send;
+
+   struct operand_info dst;
+   struct operand_info src[2];
+};
+
 static bool
-inst_is_raw_move(const struct gen_device_info *devinfo, const brw_inst *inst)
+inst_is_raw_move(const struct gen_device_info *devinfo, const brw_inst *inst,
+                 const struct inst_info *info)
 {
-   unsigned dst_type = signed_type(inst_dst_type(devinfo, inst));
-   unsigned src_type = signed_type(brw_inst_src0_type(devinfo, inst));
+   unsigned dst_type = signed_type(info->dst.type);
+   unsigned src_type = signed_type(info->src[0].type);
 
-   if (brw_inst_src0_reg_file(devinfo, inst) == BRW_IMMEDIATE_VALUE) {
+   if (info->src[0].file == BRW_IMMEDIATE_VALUE) {
       /* FIXME: not strictly true */
-      if (brw_inst_src0_type(devinfo, inst) == BRW_REGISTER_TYPE_VF ||
-          brw_inst_src0_type(devinfo, inst) == BRW_REGISTER_TYPE_UV ||
-          brw_inst_src0_type(devinfo, inst) == BRW_REGISTER_TYPE_V) {
+      if (info->src[0].type == BRW_REGISTER_TYPE_VF ||
+          info->src[0].type == BRW_REGISTER_TYPE_UV ||
+          info->src[0].type == BRW_REGISTER_TYPE_V) {
          return false;
       }
    } else if (brw_inst_src0_negate(devinfo, inst) ||
@@ -156,61 +193,38 @@ inst_is_raw_move(const struct gen_device_info *devinfo, const brw_inst *inst)
       return false;
    }
 
-   return brw_inst_opcode(devinfo, inst) == BRW_OPCODE_MOV &&
+   return info->opcode == BRW_OPCODE_MOV &&
           brw_inst_saturate(devinfo, inst) == 0 &&
           dst_type == src_type;
 }
 
 static bool
-dst_is_null(const struct gen_device_info *devinfo, const brw_inst *inst)
-{
-   return brw_inst_dst_reg_file(devinfo, inst) == BRW_ARCHITECTURE_REGISTER_FILE &&
-          brw_inst_dst_da_reg_nr(devinfo, inst) == BRW_ARF_NULL;
-}
-
-static bool
-src0_is_null(const struct gen_device_info *devinfo, const brw_inst *inst)
-{
-   return brw_inst_src0_address_mode(devinfo, inst) == BRW_ADDRESS_DIRECT &&
-          brw_inst_src0_reg_file(devinfo, inst) == BRW_ARCHITECTURE_REGISTER_FILE &&
-          brw_inst_src0_da_reg_nr(devinfo, inst) == BRW_ARF_NULL;
-}
-
-static bool
-src1_is_null(const struct gen_device_info *devinfo, const brw_inst *inst)
-{
-   return brw_inst_src1_reg_file(devinfo, inst) == BRW_ARCHITECTURE_REGISTER_FILE &&
-          brw_inst_src1_da_reg_nr(devinfo, inst) == BRW_ARF_NULL;
-}
-
-static bool
-src0_is_acc(const struct gen_device_info *devinfo, const brw_inst *inst)
+reg_is_null(const struct operand_info *reg)
 {
-   return brw_inst_src0_reg_file(devinfo, inst) == BRW_ARCHITECTURE_REGISTER_FILE &&
-          (brw_inst_src0_da_reg_nr(devinfo, inst) & 0xF0) == BRW_ARF_ACCUMULATOR;
+   return reg->file == BRW_ARCHITECTURE_REGISTER_FILE &&
+          reg->nr == BRW_ARF_NULL;
 }
 
 static bool
-src1_is_acc(const struct gen_device_info *devinfo, const brw_inst *inst)
+src0_is_null(const struct inst_info *info)
 {
-   return brw_inst_src1_reg_file(devinfo, inst) == BRW_ARCHITECTURE_REGISTER_FILE &&
-          (brw_inst_src1_da_reg_nr(devinfo, inst) & 0xF0) == BRW_ARF_ACCUMULATOR;
+   return info->src[0].address_mode == BRW_ADDRESS_DIRECT &&
+          reg_is_null(&info->src[0]);
 }
 
 static bool
-src0_has_scalar_region(const struct gen_device_info *devinfo, const brw_inst *inst)
+reg_is_acc(const struct operand_info *reg)
 {
-   return brw_inst_src0_vstride(devinfo, inst) == BRW_VERTICAL_STRIDE_0 &&
-          brw_inst_src0_width(devinfo, inst) == BRW_WIDTH_1 &&
-          brw_inst_src0_hstride(devinfo, inst) == BRW_HORIZONTAL_STRIDE_0;
+   return reg->file == BRW_ARCHITECTURE_REGISTER_FILE &&
+          (reg->nr & 0xF0) == BRW_ARF_ACCUMULATOR;
 }
 
 static bool
-src1_has_scalar_region(const struct gen_device_info *devinfo, const brw_inst *inst)
+reg_has_scalar_region(const struct operand_info *reg)
 {
-   return brw_inst_src1_vstride(devinfo, inst) == BRW_VERTICAL_STRIDE_0 &&
-          brw_inst_src1_width(devinfo, inst) == BRW_WIDTH_1 &&
-          brw_inst_src1_hstride(devinfo, inst) == BRW_HORIZONTAL_STRIDE_0;
+   return reg->vstride == BRW_VERTICAL_STRIDE_0 &&
+          reg->width == BRW_WIDTH_1 &&
+          reg->hstride == BRW_HORIZONTAL_STRIDE_0;
 }
 
 static unsigned
@@ -268,10 +282,54 @@ num_sources_from_inst(const struct gen_device_info *devinfo,
    }
 }
 
+static void
+decode_inst(const struct gen_device_info *devinfo, const brw_inst *inst,
+            struct inst_info *info)
+{
+   memset(info, 0, sizeof(*info));
+
+   info->opcode = brw_inst_opcode(devinfo, inst);
+   info->desc = brw_opcode_desc(devinfo, info->opcode);
+   info->num_sources = num_sources_from_inst(devinfo, inst);
+   info->exec_size = 1 << brw_inst_exec_size(devinfo, inst);
+   info->access_mode = brw_inst_access_mode(devinfo, inst);
+   info->is_send = inst_is_send(devinfo, inst);
+   info->is_split_send = inst_is_split_send(devinfo, inst);
+
+   if (info->num_sources == 3)
+      return;
+
+   info->dst = (struct operand_info) {
+      .file = brw_inst_dst_reg_file(devinfo, inst),
+      .type = inst_dst_type(devinfo, inst),
+      .address_mode = brw_inst_dst_address_mode(devinfo, inst),
+      .nr = brw_inst_dst_da_reg_nr(devinfo, inst),
+      .subnr = brw_inst_dst_da1_subreg_nr(devinfo, inst),
+      .hstride = brw_inst_dst_hstride(devinfo, inst),
+   };
+
+#define DO_SRC(n)                                                              \
+   info->src[n] = (struct operand_info) {                                      \
+      .file = brw_inst_src ## n ## _reg_file(devinfo, inst),                   \
+      .type = brw_inst_src ## n ## _type(devinfo, inst),                       \
+      .address_mode = brw_inst_src ## n ## _address_mode(devinfo, inst),       \
+      .nr = brw_inst_src ## n ## _da_reg_nr(devinfo, inst),                    \
+      .subnr = brw_inst_src ## n ## _da1_subreg_nr(devinfo, inst),             \
+      .vstride = brw_inst_src ## n ## _vstride(devinfo, inst),                 \
+      .width = brw_inst_src ## n ## _width(devinfo, inst),                     \
+      .hstride = brw_inst_src ## n ## _hstride(devinfo, inst),                 \
+   }
+
+   DO_SRC(0);
+   DO_SRC(1);
+#undef DO_SRC
+}
+
 static struct string
-invalid_values(const struct gen_device_info *devinfo, const brw_inst *inst)
+invalid_values(const struct gen_device_info *devinfo, const brw_inst *inst,
+               const struct inst_info *info)
 {
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
+   unsigned num_sources = info->num_sources;
    struct string error_msg = { .str = NULL, .len = 0 };
 
    switch ((enum brw_execution_size) brw_inst_exec_size(devinfo, inst)) {
@@ -287,7 +345,7 @@ invalid_values(const struct gen_device_info *devinfo, const brw_inst *inst)
       break;
    }
 
-   if (inst_is_send(devinfo, inst))
+   if (info->is_send)
       return error_msg;
 
    if (num_sources == 3) {
@@ -298,11 +356,9 @@ invalid_values(const struct gen_device_info *devinfo, const brw_inst *inst)
        */
    } else {
       if (devinfo->ver > 6) {
-         ERROR_IF(brw_inst_dst_reg_file(devinfo, inst) == MRF ||
-                  (num_sources > 0 &&
-                   brw_inst_src0_reg_file(devinfo, inst) == MRF) ||
-                  (num_sources > 1 &&
-                   brw_inst_src1_reg_file(devinfo, inst) == MRF),
+         ERROR_IF(info->dst.file == MRF ||
+                  (num_sources > 0 && info->src[0].file == MRF) ||
+                  (num_sources > 1 && info->src[1].file == MRF),
                   "invalid register file encoding");
       }
    }
@@ -311,7 +367,7 @@ invalid_values(const struct gen_device_info *devinfo, const brw_inst *inst)
       return error_msg;
 
    if (num_sources == 3) {
-      if (brw_inst_access_mode(devinfo, inst) == BRW_ALIGN_1) {
+      if (info->access_mode == BRW_ALIGN_1) {
          if (devinfo->ver >= 10) {
             ERROR_IF(brw_inst_3src_a1_dst_type (devinfo, inst) == INVALID_REG_TYPE ||
                      brw_inst_3src_a1_src0_type(devinfo, inst) == INVALID_REG_TYPE ||
@@ -327,11 +383,9 @@ invalid_values(const struct gen_device_info *devinfo, const brw_inst *inst)
                   "invalid register type encoding");
       }
    } else {
-      ERROR_IF(brw_inst_dst_type (devinfo, inst) == INVALID_REG_TYPE ||
-               (num_sources > 0 &&
-                brw_inst_src0_type(devinfo, inst) == INVALID_REG_TYPE) ||
-               (num_sources > 1 &&
-                brw_inst_src1_type(devinfo, inst) == INVALID_REG_TYPE),
+      ERROR_IF(info->dst.type == INVALID_REG_TYPE ||
+               (num_sources > 0 && info->src[0].type == INVALID_REG_TYPE) ||
+               (num_sources > 1 && info->src[1].type == INVALID_REG_TYPE),
                "invalid register type encoding");
    }
 
@@ -340,9 +394,9 @@ invalid_values(const struct gen_device_info *devinfo, const brw_inst *inst)
 
 static struct string
 sources_not_null(const struct gen_device_info *devinfo,
-                 const brw_inst *inst)
+                 const brw_inst *inst, const struct inst_info *info)
 {
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
+   unsigned num_sources = info->num_sources;
    struct string error_msg = { .str = NULL, .len = 0 };
 
    /* Nothing to test. 3-src instructions can only have GRF sources, and
@@ -354,35 +408,35 @@ sources_not_null(const struct gen_device_info *devinfo,
    /* Nothing to test.  Split sends can only encode a file in sources that are
     * allowed to be NULL.
     */
-   if (inst_is_split_send(devinfo, inst))
+   if (info->is_split_send)
       return (struct string){};
 
-   if (num_sources >= 1 && brw_inst_opcode(devinfo, inst) != BRW_OPCODE_SYNC)
-      ERROR_IF(src0_is_null(devinfo, inst), "src0 is null");
+   if (num_sources >= 1 && info->opcode != BRW_OPCODE_SYNC)
+      ERROR_IF(src0_is_null(info), "src0 is null");
 
    if (num_sources == 2)
-      ERROR_IF(src1_is_null(devinfo, inst), "src1 is null");
+      ERROR_IF(reg_is_null(&info->src[1]), "src1 is null");
 
    return error_msg;
 }
 
 static struct string
 alignment_supported(const struct gen_device_info *devinfo,
-                    const brw_inst *inst)
+                    const brw_inst *inst, const struct inst_info *info)
 {
    struct string error_msg = { .str = NULL, .len = 0 };
 
-   ERROR_IF(devinfo->ver >= 11 && brw_inst_access_mode(devinfo, inst) == BRW_ALIGN_16,
+   ERROR_IF(devinfo->ver >= 11 && info->access_mode == BRW_ALIGN_16,
             "Align16 not supported");
 
    return error_msg;
 }
 
 static bool
-inst_uses_src_acc(const struct gen_device_info *devinfo, const brw_inst *inst)
+inst_uses_src_acc(const struct inst_info *info)
 {
    /* Check instructions that use implicit accumulator sources */
-   switch (brw_inst_opcode(devinfo, inst)) {
+   switch (info->opcode) {
    case BRW_OPCODE_MAC:
    case BRW_OPCODE_MACH:
    case BRW_OPCODE_SADA2:
@@ -392,25 +446,24 @@ inst_uses_src_acc(const struct gen_device_info *devinfo, const brw_inst *inst)
    }
 
    /* FIXME: support 3-src instructions */
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
-   assert(num_sources < 3);
+   assert(info->num_sources < 3);
 
-   return src0_is_acc(devinfo, inst) || (num_sources > 1 && src1_is_acc(devinfo, inst));
+   return reg_is_acc(&info->src[0]) ||
+          (info->num_sources > 1 && reg_is_acc(&info->src[1]));
 }
 
 static struct string
 send_restrictions(const struct gen_device_info *devinfo,
-                  const brw_inst *inst)
+                  const brw_inst *inst, const struct inst_info *info)
 {
    struct string error_msg = { .str = NULL, .len = 0 };
 
-   if (inst_is_split_send(devinfo, inst)) {
+   if (info->is_split_send) {
       ERROR_IF(brw_inst_send_src1_reg_file(devinfo, inst) == BRW_ARCHITECTURE_REGISTER_FILE &&
                brw_inst_send_src1_reg_nr(devinfo, inst) != BRW_ARF_NULL,
                "src1 of split send must be a GRF or NULL");
 
-      ERROR_IF(brw_inst_eot(devinfo, inst) &&
-               brw_inst_src0_da_reg_nr(devinfo, inst) < 112,
+      ERROR_IF(brw_inst_eot(devinfo, inst) && info->src[0].nr < 112,
                "send with EOT must use g112-g127");
       ERROR_IF(brw_inst_eot(devinfo, inst) &&
                brw_inst_send_src1_reg_file(devinfo, inst) == BRW_GENERAL_REGISTER_FILE &&
@@ -430,7 +483,7 @@ send_restrictions(const struct gen_device_info *devinfo,
             const uint32_t ex_desc = brw_inst_sends_ex_desc(devinfo, inst);
             ex_mlen = brw_message_ex_desc_ex_mlen(devinfo, ex_desc);
          }
-         const unsigned src0_reg_nr = brw_inst_src0_da_reg_nr(devinfo, inst);
+         const unsigned src0_reg_nr = info->src[0].nr;
          const unsigned src1_reg_nr = brw_inst_send_src1_reg_nr(devinfo, inst);
          ERROR_IF((src0_reg_nr <= src1_reg_nr &&
                    src1_reg_nr < src0_reg_nr + mlen) ||
@@ -438,25 +491,22 @@ send_restrictions(const struct gen_device_info *devinfo,
                    src0_reg_nr < src1_reg_nr + ex_mlen),
                    "split send payloads must not overlap");
       }
-   } else if (inst_is_send(devinfo, inst)) {
-      ERROR_IF(brw_inst_src0_address_mode(devinfo, inst) != BRW_ADDRESS_DIRECT,
+   } else if (info->is_send) {
+      ERROR_IF(info->src[0].address_mode != BRW_ADDRESS_DIRECT,
                "send must use direct addressing");
 
       if (devinfo->ver >= 7) {
          ERROR_IF(brw_inst_send_src0_reg_file(devinfo, inst) != BRW_GENERAL_REGISTER_FILE,
                   "send from non-GRF");
-         ERROR_IF(brw_inst_eot(devinfo, inst) &&
-                  brw_inst_src0_da_reg_nr(devinfo, inst) < 112,
+         ERROR_IF(brw_inst_eot(devinfo, inst) && info->src[0].nr < 112,
                   "send with EOT must use g112-g127");
       }
 
       if (devinfo->ver >= 8) {
-         ERROR_IF(!dst_is_null(devinfo, inst) &&
-                  (brw_inst_dst_da_reg_nr(devinfo, inst) +
-                   brw_inst_rlen(devinfo, inst) > 127) &&
-                  (brw_inst_src0_da_reg_nr(devinfo, inst) +
-                   brw_inst_mlen(devinfo, inst) >
-                   brw_inst_dst_da_reg_nr(devinfo, inst)),
+         ERROR_IF(!reg_is_null(&info->dst) &&
+                  (info->dst.nr + brw_inst_rlen(devinfo, inst) > 127) &&
+                  (info->src[0].nr + brw_inst_mlen(devinfo, inst) >
+                   info->dst.nr),
                   "r127 must not be used for return address when there is "
                   "a src and dest overlap");
       }
@@ -519,24 +569,25 @@ execution_type_for_type(enum brw_reg_type type)
  * Returns the execution type of an instruction \p inst
  */
 static enum brw_reg_type
-execution_type(const struct gen_device_info *devinfo, const brw_inst *inst)
+execution_type(const struct gen_device_info *devinfo,
+               const struct inst_info *info)
 {
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
+   unsigned num_sources = info->num_sources;
    enum brw_reg_type src0_exec_type, src1_exec_type;
 
    /* Execution data type is independent of destination data type, except in
     * mixed F/HF instructions.
     */
-   enum brw_reg_type dst_exec_type = inst_dst_type(devinfo, inst);
+   enum brw_reg_type dst_exec_type = info->dst.type;
 
-   src0_exec_type = execution_type_for_type(brw_inst_src0_type(devinfo, inst));
+   src0_exec_type = execution_type_for_type(info->src[0].type);
    if (num_sources == 1) {
       if (src0_exec_type == BRW_REGISTER_TYPE_HF)
          return dst_exec_type;
       return src0_exec_type;
    }
 
-   src1_exec_type = execution_type_for_type(brw_inst_src1_type(devinfo, inst));
+   src1_exec_type = execution_type_for_type(info->src[1].type);
    if (types_are_mixed_float(src0_exec_type, src1_exec_type) ||
        types_are_mixed_float(src0_exec_type, dst_exec_type) ||
        types_are_mixed_float(src1_exec_type, dst_exec_type)) {
@@ -602,19 +653,16 @@ is_packed(unsigned vstride, unsigned width, unsigned hstride)
  * to/from half-float.
  */
 static bool
-is_half_float_conversion(const struct gen_device_info *devinfo,
-                         const brw_inst *inst)
+is_half_float_conversion(const struct inst_info *info)
 {
-   enum brw_reg_type dst_type = brw_inst_dst_type(devinfo, inst);
-
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
-   enum brw_reg_type src0_type = brw_inst_src0_type(devinfo, inst);
+   enum brw_reg_type dst_type = info->dst.type;
+   enum brw_reg_type src0_type = info->src[0].type;
 
    if (dst_type != src0_type &&
        (dst_type == BRW_REGISTER_TYPE_HF || src0_type == BRW_REGISTER_TYPE_HF)) {
       return true;
-   } else if (num_sources > 1) {
-      enum brw_reg_type src1_type = brw_inst_src1_type(devinfo, inst);
+   } else if (info->num_sources > 1) {
+      enum brw_reg_type src1_type = info->src[1].type;
       return dst_type != src1_type &&
             (dst_type == BRW_REGISTER_TYPE_HF ||
              src1_type == BRW_REGISTER_TYPE_HF);
@@ -627,30 +675,28 @@ is_half_float_conversion(const struct gen_device_info *devinfo,
  * Returns whether an instruction is using mixed float operation mode
  */
 static bool
-is_mixed_float(const struct gen_device_info *devinfo, const brw_inst *inst)
+is_mixed_float(const struct gen_device_info *devinfo,
+               const struct inst_info *info)
 {
    if (devinfo->ver < 8)
       return false;
 
-   if (inst_is_send(devinfo, inst))
+   if (info->is_send)
       return false;
 
-   unsigned opcode = brw_inst_opcode(devinfo, inst);
-   const struct opcode_desc *desc = brw_opcode_desc(devinfo, opcode);
-   if (desc->ndst == 0)
+   if (info->desc->ndst == 0)
       return false;
 
    /* FIXME: support 3-src instructions */
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
-   assert(num_sources < 3);
+   assert(info->num_sources < 3);
 
-   enum brw_reg_type dst_type = brw_inst_dst_type(devinfo, inst);
-   enum brw_reg_type src0_type = brw_inst_src0_type(devinfo, inst);
+   enum brw_reg_type dst_type = info->dst.type;
+   enum brw_reg_type src0_type = info->src[0].type;
 
-   if (num_sources == 1)
+   if (info->num_sources == 1)
       return types_are_mixed_float(src0_type, dst_type);
 
-   enum brw_reg_type src1_type = brw_inst_src1_type(devinfo, inst);
+   enum brw_reg_type src1_type = info->src[1].type;
 
    return types_are_mixed_float(src0_type, src1_type) ||
           types_are_mixed_float(src0_type, dst_type) ||
@@ -662,19 +708,16 @@ is_mixed_float(const struct gen_device_info *devinfo, const brw_inst *inst)
  * to/from byte.
  */
 static bool
-is_byte_conversion(const struct gen_device_info *devinfo,
-                   const brw_inst *inst)
+is_byte_conversion(const struct inst_info *info)
 {
-   enum brw_reg_type dst_type = brw_inst_dst_type(devinfo, inst);
-
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
-   enum brw_reg_type src0_type = brw_inst_src0_type(devinfo, inst);
+   enum brw_reg_type dst_type = info->dst.type;
+   enum brw_reg_type src0_type = info->src[0].type;
 
    if (dst_type != src0_type &&
        (type_sz(dst_type) == 1 || type_sz(src0_type) == 1)) {
       return true;
-   } else if (num_sources > 1) {
-      enum brw_reg_type src1_type = brw_inst_src1_type(devinfo, inst);
+   } else if (info->num_sources > 1) {
+      enum brw_reg_type src1_type = info->src[1].type;
       return dst_type != src1_type &&
             (type_sz(dst_type) == 1 || type_sz(src1_type) == 1);
    }
@@ -688,15 +731,15 @@ is_byte_conversion(const struct gen_device_info *devinfo,
  */
 static struct string
 general_restrictions_based_on_operand_types(const struct gen_device_info *devinfo,
-                                            const brw_inst *inst)
+                                            const brw_inst *inst,
+                                            const struct inst_info *info)
 {
-   const struct opcode_desc *desc =
-      brw_opcode_desc(devinfo, brw_inst_opcode(devinfo, inst));
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
-   unsigned exec_size = 1 << brw_inst_exec_size(devinfo, inst);
+   const struct opcode_desc *desc = info->desc;
+   unsigned num_sources = info->num_sources;
+   unsigned exec_size = info->exec_size;
    struct string error_msg = { .str = NULL, .len = 0 };
 
-   if (inst_is_send(devinfo, inst))
+   if (info->is_send)
       return error_msg;
 
    if (devinfo->ver >= 11) {
@@ -707,7 +750,7 @@ general_restrictions_based_on_operand_types(const struct gen_device_info *devinf
                   "byte broadcast as well.");
       }
       if (num_sources == 2) {
-         ERROR_IF(brw_reg_type_to_size(brw_inst_src1_type(devinfo, inst)) == 1,
+         ERROR_IF(brw_reg_type_to_size(info->src[1].type) == 1,
                   "Byte data type is not supported for src1 register regioning. This includes "
                   "byte broadcast as well.");
       }
@@ -737,21 +780,21 @@ general_restrictions_based_on_operand_types(const struct gen_device_info *devinf
     * In fact, checking it would weaken testing of the other rules.
     */
 
-   unsigned dst_stride = STRIDE(brw_inst_dst_hstride(devinfo, inst));
-   enum brw_reg_type dst_type = inst_dst_type(devinfo, inst);
+   unsigned dst_stride = STRIDE(info->dst.hstride);
+   enum brw_reg_type dst_type = info->dst.type;
    bool dst_type_is_byte =
-      inst_dst_type(devinfo, inst) == BRW_REGISTER_TYPE_B ||
-      inst_dst_type(devinfo, inst) == BRW_REGISTER_TYPE_UB;
+      dst_type == BRW_REGISTER_TYPE_B ||
+      dst_type == BRW_REGISTER_TYPE_UB;
 
    if (dst_type_is_byte) {
       if (is_packed(exec_size * dst_stride, exec_size, dst_stride)) {
-         if (!inst_is_raw_move(devinfo, inst))
+         if (!inst_is_raw_move(devinfo, inst, info))
             ERROR("Only raw MOV supports a packed-byte destination");
          return error_msg;
       }
    }
 
-   unsigned exec_type = execution_type(devinfo, inst);
+   unsigned exec_type = execution_type(devinfo, info);
    unsigned exec_type_size = brw_reg_type_to_size(exec_type);
    unsigned dst_type_size = brw_reg_type_to_size(dst_type);
 
@@ -763,7 +806,7 @@ general_restrictions_based_on_operand_types(const struct gen_device_info *devinf
        exec_type_size == 8 && dst_type_size == 4)
       dst_type_size = 8;
 
-   if (is_byte_conversion(devinfo, inst)) {
+   if (is_byte_conversion(info)) {
       /* From the BDW+ PRM, Volume 2a, Command Reference, Instructions - MOV:
        *
        *    "There is no direct conversion from B/UB to DF or DF to B/UB.
@@ -773,9 +816,8 @@ general_restrictions_based_on_operand_types(const struct gen_device_info *devinf
        * validate this more generally, since there is the possibility
        * of implicit conversions from other instructions.
        */
-      enum brw_reg_type src0_type = brw_inst_src0_type(devinfo, inst);
-      enum brw_reg_type src1_type = num_sources > 1 ?
-                                    brw_inst_src1_type(devinfo, inst) : 0;
+      enum brw_reg_type src0_type = info->src[0].type;
+      enum brw_reg_type src1_type = num_sources > 1 ? info->src[1].type : 0;
 
       ERROR_IF(type_sz(dst_type) == 1 &&
                (type_sz(src0_type) == 8 ||
@@ -788,7 +830,7 @@ general_restrictions_based_on_operand_types(const struct gen_device_info *devinf
                "There are no direct conversions between 64-bit types and B/UB");
    }
 
-   if (is_half_float_conversion(devinfo, inst)) {
+   if (is_half_float_conversion(info)) {
       /**
        * A helper to validate used in the validation of the following restriction
        * from the BDW+ PRM, Volume 2a, Command Reference, Instructions - MOV:
@@ -801,9 +843,8 @@ general_restrictions_based_on_operand_types(const struct gen_device_info *devinf
        * of implicit conversions from other instructions, such us implicit
        * conversion from integer to HF with the ADD instruction in SKL+.
        */
-      enum brw_reg_type src0_type = brw_inst_src0_type(devinfo, inst);
-      enum brw_reg_type src1_type = num_sources > 1 ?
-                                    brw_inst_src1_type(devinfo, inst) : 0;
+      enum brw_reg_type src0_type = info->src[0].type;
+      enum brw_reg_type src1_type = num_sources > 1 ? info->src[1].type : 0;
       ERROR_IF(dst_type == BRW_REGISTER_TYPE_HF &&
                (type_sz(src0_type) == 8 ||
                 (num_sources > 1 && type_sz(src1_type) == 8)),
@@ -844,7 +885,7 @@ general_restrictions_based_on_operand_types(const struct gen_device_info *devinf
        * requires packed destinations, so these restrictions can't possibly
        * apply to Align16 mode.
        */
-      if (brw_inst_access_mode(devinfo, inst) == BRW_ALIGN_1) {
+      if (info->access_mode == BRW_ALIGN_1) {
          if ((dst_type == BRW_REGISTER_TYPE_HF &&
               (brw_reg_type_is_integer(src0_type) ||
                (num_sources > 1 && brw_reg_type_is_integer(src1_type)))) ||
@@ -855,16 +896,14 @@ general_restrictions_based_on_operand_types(const struct gen_device_info *devinf
                      "Conversions between integer and half-float must be "
                      "strided by a DWord on the destination");
 
-            unsigned subreg = brw_inst_dst_da1_subreg_nr(devinfo, inst);
-            ERROR_IF(subreg % 4 != 0,
+            ERROR_IF(info->dst.subnr % 4 != 0,
                      "Conversions between integer and half-float must be "
                      "aligned to a DWord on the destination");
          } else if ((devinfo->is_cherryview || devinfo->ver >= 9) &&
                     dst_type == BRW_REGISTER_TYPE_HF) {
-            unsigned subreg = brw_inst_dst_da1_subreg_nr(devinfo, inst);
             ERROR_IF(dst_stride != 2 &&
-                     !(is_mixed_float(devinfo, inst) &&
-                       dst_stride == 1 && subreg % 16 == 0),
+                     !(is_mixed_float(devinfo, info) &&
+                       dst_stride == 1 && info->dst.subnr % 16 == 0),
                      "Conversions to HF must have either all words in even "
                      "word locations or all words in odd word locations or "
                      "be mixed-float with Oword-aligned packed destination");
@@ -877,21 +916,21 @@ general_restrictions_based_on_operand_types(const struct gen_device_info *devinf
     * and the execution type. We will add validation for those in a later patch.
     */
    bool validate_dst_size_and_exec_size_ratio =
-      !is_mixed_float(devinfo, inst) ||
+      !is_mixed_float(devinfo, info) ||
       !(devinfo->is_cherryview || devinfo->ver >= 9);
 
    if (validate_dst_size_and_exec_size_ratio &&
        exec_type_size > dst_type_size) {
-      if (!(dst_type_is_byte && inst_is_raw_move(devinfo, inst))) {
+      if (!(dst_type_is_byte && inst_is_raw_move(devinfo, inst, info))) {
          ERROR_IF(dst_stride * dst_type_size != exec_type_size,
                   "Destination stride must be equal to the ratio of the sizes "
                   "of the execution data type to the destination type");
       }
 
-      unsigned subreg = brw_inst_dst_da1_subreg_nr(devinfo, inst);
+      unsigned subreg = info->dst.subnr;
 
-      if (brw_inst_access_mode(devinfo, inst) == BRW_ALIGN_1 &&
-          brw_inst_dst_address_mode(devinfo, inst) == BRW_ADDRESS_DIRECT) {
+      if (info->access_mode == BRW_ALIGN_1 &&
+          info->dst.address_mode == BRW_ADDRESS_DIRECT) {
          /* The i965 PRM says:
           *
           *    Implementation Restriction: The relaxed alignment rule for byte
@@ -920,12 +959,12 @@ general_restrictions_based_on_operand_types(const struct gen_device_info *devinf
  */
 static struct string
 general_restrictions_on_region_parameters(const struct gen_device_info *devinfo,
-                                          const brw_inst *inst)
+                                          const brw_inst *inst,
+                                          const struct inst_info *info)
 {
-   const struct opcode_desc *desc =
-      brw_opcode_desc(devinfo, brw_inst_opcode(devinfo, inst));
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
-   unsigned exec_size = 1 << brw_inst_exec_size(devinfo, inst);
+   const struct opcode_desc *desc = info->desc;
+   unsigned num_sources = info->num_sources;
+   unsigned exec_size = info->exec_size;
    struct string error_msg = { .str = NULL, .len = 0 };
 
    if (num_sources == 3)
@@ -934,40 +973,27 @@ general_restrictions_on_region_parameters(const struct gen_device_info *devinfo,
    /* Split sends don't have the bits in the instruction to encode regions so
     * there's nothing to check.
     */
-   if (inst_is_split_send(devinfo, inst))
+   if (info->is_split_send)
       return (struct string){};
 
-   if (brw_inst_access_mode(devinfo, inst) == BRW_ALIGN_16) {
-      if (desc->ndst != 0 && !dst_is_null(devinfo, inst))
-         ERROR_IF(brw_inst_dst_hstride(devinfo, inst) != BRW_HORIZONTAL_STRIDE_1,
+   if (info->access_mode == BRW_ALIGN_16) {
+      if (desc->ndst != 0 && !reg_is_null(&info->dst))
+         ERROR_IF(info->dst.hstride != BRW_HORIZONTAL_STRIDE_1,
                   "Destination Horizontal Stride must be 1");
 
-      if (num_sources >= 1) {
-         if (devinfo->is_haswell || devinfo->ver >= 8) {
-            ERROR_IF(brw_inst_src0_reg_file(devinfo, inst) != BRW_IMMEDIATE_VALUE &&
-                     brw_inst_src0_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_0 &&
-                     brw_inst_src0_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_2 &&
-                     brw_inst_src0_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_4,
-                     "In Align16 mode, only VertStride of 0, 2, or 4 is allowed");
-         } else {
-            ERROR_IF(brw_inst_src0_reg_file(devinfo, inst) != BRW_IMMEDIATE_VALUE &&
-                     brw_inst_src0_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_0 &&
-                     brw_inst_src0_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_4,
-                     "In Align16 mode, only VertStride of 0 or 4 is allowed");
-         }
-      }
+      for (unsigned i = 0; i < num_sources; i++) {
+         const struct operand_info *src = &info->src[i];
 
-      if (num_sources == 2) {
          if (devinfo->is_haswell || devinfo->ver >= 8) {
-            ERROR_IF(brw_inst_src1_reg_file(devinfo, inst) != BRW_IMMEDIATE_VALUE &&
-                     brw_inst_src1_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_0 &&
-                     brw_inst_src1_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_2 &&
-                     brw_inst_src1_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_4,
+            ERROR_IF(src->file != BRW_IMMEDIATE_VALUE &&
+                     src->vstride != BRW_VERTICAL_STRIDE_0 &&
+                     src->vstride != BRW_VERTICAL_STRIDE_2 &&
+                     src->vstride != BRW_VERTICAL_STRIDE_4,
                      "In Align16 mode, only VertStride of 0, 2, or 4 is allowed");
          } else {
-            ERROR_IF(brw_inst_src1_reg_file(devinfo, inst) != BRW_IMMEDIATE_VALUE &&
-                     brw_inst_src1_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_0 &&
-                     brw_inst_src1_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_4,
+            ERROR_IF(src->file != BRW_IMMEDIATE_VALUE &&
+                     src->vstride != BRW_VERTICAL_STRIDE_0 &&
+                     src->vstride != BRW_VERTICAL_STRIDE_4,
                      "In Align16 mode, only VertStride of 0 or 4 is allowed");
          }
       }
@@ -976,27 +1002,16 @@ general_restrictions_on_region_parameters(const struct gen_device_info *devinfo,
    }
 
    for (unsigned i = 0; i < num_sources; i++) {
-      unsigned vstride, width, hstride, element_size, subreg;
-      enum brw_reg_type type;
+      const struct operand_info *src = &info->src[i];
 
-#define DO_SRC(n)                                                              \
-      if (brw_inst_src ## n ## _reg_file(devinfo, inst) ==                     \
-          BRW_IMMEDIATE_VALUE)                                                 \
-         continue;                                                             \
-                                                                               \
-      vstride = STRIDE(brw_inst_src ## n ## _vstride(devinfo, inst));          \
-      width = WIDTH(brw_inst_src ## n ## _width(devinfo, inst));               \
-      hstride = STRIDE(brw_inst_src ## n ## _hstride(devinfo, inst));          \
-      type = brw_inst_src ## n ## _type(devinfo, inst);                        \
-      element_size = brw_reg_type_to_size(type);                               \
-      subreg = brw_inst_src ## n ## _da1_subreg_nr(devinfo, inst)
-
-      if (i == 0) {
-         DO_SRC(0);
-      } else {
-         DO_SRC(1);
-      }
-#undef DO_SRC
+      if (src->file == BRW_IMMEDIATE_VALUE)
+         continue;
+
+      unsigned vstride = STRIDE(src->vstride);
+      unsigned width = WIDTH(src->width);
+      unsigned hstride = STRIDE(src->hstride);
+      unsigned element_size = brw_reg_type_to_size(src->type);
+      unsigned subreg = src->subnr;
 
       /* On IVB/BYT, region parameters and execution size for DF are in terms of
        * 32-bit elements, so they are doubled. For evaluating the validity of an
@@ -1069,8 +1084,8 @@ general_restrictions_on_region_parameters(const struct gen_device_info *devinfo,
    }
 
    /* Dst.HorzStride must not be 0. */
-   if (desc->ndst != 0 && !dst_is_null(devinfo, inst)) {
-      ERROR_IF(brw_inst_dst_hstride(devinfo, inst) == BRW_HORIZONTAL_STRIDE_0,
+   if (desc->ndst != 0 && !reg_is_null(&info->dst)) {
+      ERROR_IF(info->dst.hstride == BRW_HORIZONTAL_STRIDE_0,
                "Destination Horizontal Stride must not be 0");
    }
 
@@ -1079,27 +1094,27 @@ general_restrictions_on_region_parameters(const struct gen_device_info *devinfo,
 
 static struct string
 special_restrictions_for_mixed_float_mode(const struct gen_device_info *devinfo,
-                                          const brw_inst *inst)
+                                          const brw_inst *inst,
+                                          const struct inst_info *info)
 {
    struct string error_msg = { .str = NULL, .len = 0 };
 
-   const unsigned opcode = brw_inst_opcode(devinfo, inst);
-   const unsigned num_sources = num_sources_from_inst(devinfo, inst);
+   const unsigned opcode = info->opcode;
+   const unsigned num_sources = info->num_sources;
    if (num_sources >= 3)
       return error_msg;
 
-   if (!is_mixed_float(devinfo, inst))
+   if (!is_mixed_float(devinfo, info))
       return error_msg;
 
-   unsigned exec_size = 1 << brw_inst_exec_size(devinfo, inst);
-   bool is_align16 = brw_inst_access_mode(devinfo, inst) == BRW_ALIGN_16;
+   unsigned exec_size = info->exec_size;
+   bool is_align16 = info->access_mode == BRW_ALIGN_16;
 
-   enum brw_reg_type src0_type = brw_inst_src0_type(devinfo, inst);
-   enum brw_reg_type src1_type = num_sources > 1 ?
-                                 brw_inst_src1_type(devinfo, inst) : 0;
-   enum brw_reg_type dst_type = brw_inst_dst_type(devinfo, inst);
+   enum brw_reg_type src0_type = info->src[0].type;
+   enum brw_reg_type src1_type = num_sources > 1 ? info->src[1].type : 0;
+   enum brw_reg_type dst_type = info->dst.type;
 
-   unsigned dst_stride = STRIDE(brw_inst_dst_hstride(devinfo, inst));
+   unsigned dst_stride = STRIDE(info->dst.hstride);
    bool dst_is_packed = is_packed(exec_size * dst_stride, exec_size, dst_stride);
 
    /* From the SKL PRM, Special Restrictions for Handling Mixed Mode
@@ -1108,9 +1123,9 @@ special_restrictions_for_mixed_float_mode(const struct gen_device_info *devinfo,
     *    "Indirect addressing on source is not supported when source and
     *     destination data types are mixed float."
     */
-   ERROR_IF(brw_inst_src0_address_mode(devinfo, inst) != BRW_ADDRESS_DIRECT ||
+   ERROR_IF(info->src[0].address_mode != BRW_ADDRESS_DIRECT ||
             (num_sources > 1 &&
-             brw_inst_src1_address_mode(devinfo, inst) != BRW_ADDRESS_DIRECT),
+             info->src[1].address_mode != BRW_ADDRESS_DIRECT),
             "Indirect addressing on source is not supported when source and "
             "destination data types are mixed float");
 
@@ -1136,11 +1151,11 @@ special_restrictions_for_mixed_float_mode(const struct gen_device_info *devinfo,
        * it means that vertical stride must always be 4, since 0 and 2 would
        * lead to replicated data, and any other value is disallowed in Align16.
        */
-      ERROR_IF(brw_inst_src0_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_4,
+      ERROR_IF(info->src[0].vstride != BRW_VERTICAL_STRIDE_4,
                "Align16 mixed float mode assumes packed data (vstride must be 4");
 
       ERROR_IF(num_sources >= 2 &&
-               brw_inst_src1_vstride(devinfo, inst) != BRW_VERTICAL_STRIDE_4,
+               info->src[1].vstride != BRW_VERTICAL_STRIDE_4,
                "Align16 mixed float mode assumes packed data (vstride must be 4");
 
       /* From the SKL PRM, Special Restrictions for Handling Mixed Mode
@@ -1183,7 +1198,7 @@ special_restrictions_for_mixed_float_mode(const struct gen_device_info *devinfo,
        *
        *    "No accumulator read access for Align16 mixed float."
        */
-      ERROR_IF(inst_uses_src_acc(devinfo, inst),
+      ERROR_IF(inst_uses_src_acc(info),
                "No accumulator read access for Align16 mixed float");
    } else {
       assert(!is_align16);
@@ -1207,12 +1222,12 @@ special_restrictions_for_mixed_float_mode(const struct gen_device_info *devinfo,
        */
       if (opcode == BRW_OPCODE_MATH) {
          if (src0_type == BRW_REGISTER_TYPE_HF) {
-            ERROR_IF(STRIDE(brw_inst_src0_hstride(devinfo, inst)) <= 1,
+            ERROR_IF(STRIDE(info->src[0].hstride) <= 1,
                      "Align1 mixed mode math needs strided half-float inputs");
          }
 
          if (num_sources >= 2 && src1_type == BRW_REGISTER_TYPE_HF) {
-            ERROR_IF(STRIDE(brw_inst_src1_hstride(devinfo, inst)) <= 1,
+            ERROR_IF(STRIDE(info->src[1].hstride) <= 1,
                      "Align1 mixed mode math needs strided half-float inputs");
          }
       }
@@ -1230,8 +1245,8 @@ special_restrictions_for_mixed_float_mode(const struct gen_device_info *devinfo,
           * aligned data means that execution size is limited to 8.
           */
          unsigned subreg;
-         if (brw_inst_dst_address_mode(devinfo, inst) == BRW_ADDRESS_DIRECT)
-            subreg = brw_inst_dst_da1_subreg_nr(devinfo, inst);
+         if (info->dst.address_mode == BRW_ADDRESS_DIRECT)
+            subreg = info->dst.subnr;
          else
             subreg = brw_inst_dst_ia_subreg_nr(devinfo, inst);
          ERROR_IF(subreg % 16 != 0,
@@ -1251,20 +1266,20 @@ special_restrictions_for_mixed_float_mode(const struct gen_device_info *devinfo,
           * Align16 mixed float mode doesn't allow accumulator access on sources,
           * so we only need to check this for Align1.
           */
-         if (src0_is_acc(devinfo, inst) &&
+         if (reg_is_acc(&info->src[0]) &&
              (src0_type == BRW_REGISTER_TYPE_F ||
               src0_type == BRW_REGISTER_TYPE_HF)) {
-            ERROR_IF(brw_inst_src0_da1_subreg_nr(devinfo, inst) != 0,
+            ERROR_IF(info->src[0].subnr != 0,
                      "Mixed float mode requires register-aligned accumulator "
                      "source reads when destination is packed half-float");
 
          }
 
          if (num_sources > 1 &&
-             src1_is_acc(devinfo, inst) &&
+             reg_is_acc(&info->src[1]) &&
              (src1_type == BRW_REGISTER_TYPE_F ||
               src1_type == BRW_REGISTER_TYPE_HF)) {
-            ERROR_IF(brw_inst_src1_da1_subreg_nr(devinfo, inst) != 0,
+            ERROR_IF(info->src[1].subnr != 0,
                      "Mixed float mode requires register-aligned accumulator "
                      "source reads when destination is packed half-float");
          }
@@ -1283,7 +1298,7 @@ special_restrictions_for_mixed_float_mode(const struct gen_device_info *devinfo,
        *        validate the explicit implication, which is clearly described.
        */
       if (dst_type == BRW_REGISTER_TYPE_HF &&
-          inst_uses_src_acc(devinfo, inst)) {
+          inst_uses_src_acc(info)) {
          ERROR_IF(dst_stride != 2,
                   "Mixed float mode with implicit/explicit accumulator "
                   "source and half-float destination requires a stride "
@@ -1337,13 +1352,14 @@ align1_access_mask(uint64_t access_mask[static 32],
 
 /**
  * Returns the number of registers accessed according to the \p access_mask
+ * of an \p exec_size instruction
  */
 static int
-registers_read(const uint64_t access_mask[static 32])
+registers_read(const uint64_t access_mask[static 32], unsigned exec_size)
 {
    int regs_read = 0;
 
-   for (unsigned i = 0; i < 32; i++) {
+   for (unsigned i = 0; i < exec_size; i++) {
       if (access_mask[i] > 0xFFFFFFFF) {
          return 2;
       } else if (access_mask[i]) {
@@ -1360,61 +1376,52 @@ registers_read(const uint64_t access_mask[static 32])
  */
 static struct string
 region_alignment_rules(const struct gen_device_info *devinfo,
-                       const brw_inst *inst)
+                       const brw_inst *inst, const struct inst_info *info)
 {
-   const struct opcode_desc *desc =
-      brw_opcode_desc(devinfo, brw_inst_opcode(devinfo, inst));
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
-   unsigned exec_size = 1 << brw_inst_exec_size(devinfo, inst);
-   uint64_t dst_access_mask[32], src0_access_mask[32], src1_access_mask[32];
+   const struct opcode_desc *desc = info->desc;
+   unsigned num_sources = info->num_sources;
+   unsigned exec_size = info->exec_size;
+   uint64_t dst_access_mask[32], src_access_mask[2][32];
+   unsigned src_regs[2] = { 0, 0 };
    struct string error_msg = { .str = NULL, .len = 0 };
 
    if (num_sources == 3)
       return (struct string){};
 
-   if (brw_inst_access_mode(devinfo, inst) == BRW_ALIGN_16)
+   if (info->access_mode == BRW_ALIGN_16)
       return (struct string){};
 
-   if (inst_is_send(devinfo, inst))
+   if (info->is_send)
       return (struct string){};
 
-   memset(dst_access_mask, 0, sizeof(dst_access_mask));
-   memset(src0_access_mask, 0, sizeof(src0_access_mask));
-   memset(src1_access_mask, 0, sizeof(src1_access_mask));
+   /* Only the first exec_size elements of an access mask are ever looked
+    * at.
+    */
+   memset(dst_access_mask, 0, exec_size * sizeof(uint64_t));
 
    for (unsigned i = 0; i < num_sources; i++) {
-      unsigned vstride, width, hstride, element_size, subreg;
-      enum brw_reg_type type;
+      const struct operand_info *src = &info->src[i];
 
       /* In Direct Addressing mode, a source cannot span more than 2 adjacent
        * GRF registers.
        */
+      if (src->address_mode != BRW_ADDRESS_DIRECT)
+         continue;
 
-#define DO_SRC(n)                                                              \
-      if (brw_inst_src ## n ## _address_mode(devinfo, inst) !=                 \
-          BRW_ADDRESS_DIRECT)                                                  \
-         continue;                                                             \
-                                                                               \
-      if (brw_inst_src ## n ## _reg_file(devinfo, inst) ==                     \
-          BRW_IMMEDIATE_VALUE)                                                 \
-         continue;                                                             \
-                                                                               \
-      vstride = STRIDE(brw_inst_src ## n ## _vstride(devinfo, inst));          \
-      width = WIDTH(brw_inst_src ## n ## _width(devinfo, inst));               \
-      hstride = STRIDE(brw_inst_src ## n ## _hstride(devinfo, inst));          \
-      type = brw_inst_src ## n ## _type(devinfo, inst);                        \
-      element_size = brw_reg_type_to_size(type);                               \
-      subreg = brw_inst_src ## n ## _da1_subreg_nr(devinfo, inst);             \
-      align1_access_mask(src ## n ## _access_mask,                             \
-                         exec_size, element_size, subreg,                      \
-                         vstride, width, hstride)
-
-      if (i == 0) {
-         DO_SRC(0);
-      } else {
-         DO_SRC(1);
-      }
-#undef DO_SRC
+      if (src->file == BRW_IMMEDIATE_VALUE)
+         continue;
+
+      unsigned vstride = STRIDE(src->vstride);
+      unsigned width = WIDTH(src->width);
+      unsigned hstride = STRIDE(src->hstride);
+      unsigned element_size = brw_reg_type_to_size(src->type);
+      unsigned subreg = src->subnr;
+
+      memset(src_access_mask[i], 0, exec_size * sizeof(uint64_t));
+      align1_access_mask(src_access_mask[i],
+                         exec_size, element_size, subreg,
+                         vstride, width, hstride);
+      src_regs[i] = registers_read(src_access_mask[i], exec_size);
 
       unsigned num_vstride = exec_size / width;
       unsigned num_hstride = width;
@@ -1426,13 +1433,13 @@ region_alignment_rules(const struct gen_device_info *devinfo,
                "A source cannot span more than 2 adjacent GRF registers");
    }
 
-   if (desc->ndst == 0 || dst_is_null(devinfo, inst))
+   if (desc->ndst == 0 || reg_is_null(&info->dst))
       return error_msg;
 
-   unsigned stride = STRIDE(brw_inst_dst_hstride(devinfo, inst));
-   enum brw_reg_type dst_type = inst_dst_type(devinfo, inst);
+   unsigned stride = STRIDE(info->dst.hstride);
+   enum brw_reg_type dst_type = info->dst.type;
    unsigned element_size = brw_reg_type_to_size(dst_type);
-   unsigned subreg = brw_inst_dst_da1_subreg_nr(devinfo, inst);
+   unsigned subreg = info->dst.subnr;
    unsigned offset = ((exec_size - 1) * stride * element_size) + subreg;
    ERROR_IF(offset >= 64,
             "A destination cannot span more than 2 adjacent GRF registers");
@@ -1453,9 +1460,7 @@ region_alignment_rules(const struct gen_device_info *devinfo,
                       exec_size == 1 ? 1 : exec_size,
                       exec_size == 1 ? 0 : stride);
 
-   unsigned dst_regs = registers_read(dst_access_mask);
-   unsigned src0_regs = registers_read(src0_access_mask);
-   unsigned src1_regs = registers_read(src1_access_mask);
+   unsigned dst_regs = registers_read(dst_access_mask, exec_size);
 
    /* The SNB, IVB, HSW, BDW, and CHV PRMs say:
     *
@@ -1472,7 +1477,7 @@ region_alignment_rules(const struct gen_device_info *devinfo,
     *          of a register.
     */
    if (devinfo->ver <= 8) {
-      if (dst_regs == 1 && (src0_regs == 2 || src1_regs == 2)) {
+      if (dst_regs == 1 && (src_regs[0] == 2 || src_regs[1] == 2)) {
          unsigned upper_oword_writes = 0, lower_oword_writes = 0;
 
          for (unsigned i = 0; i < exec_size; i++) {
@@ -1515,8 +1520,7 @@ region_alignment_rules(const struct gen_device_info *devinfo,
     * It is not known whether this restriction applies to KBL other Gens after
     * SKL.
     */
-   if (devinfo->ver <= 8 ||
-       brw_inst_opcode(devinfo, inst) == BRW_OPCODE_MATH) {
+   if (devinfo->ver <= 8 || info->opcode == BRW_OPCODE_MATH) {
 
       /* Nothing explicitly states that on Gen < 8 elements must be evenly
        * split between two destination registers in the two exceptional
@@ -1573,40 +1577,33 @@ region_alignment_rules(const struct gen_device_info *devinfo,
     */
    if (devinfo->ver <= 7 && dst_regs == 2) {
       for (unsigned i = 0; i < num_sources; i++) {
-#define DO_SRC(n)                                                             \
-         if (src ## n ## _regs <= 1)                                          \
-            continue;                                                         \
-                                                                              \
-         for (unsigned i = 0; i < exec_size; i++) {                           \
-            if ((dst_access_mask[i] > 0xFFFFFFFF) !=                          \
-                (src ## n ## _access_mask[i] > 0xFFFFFFFF)) {                 \
-               ERROR("Each destination register must be entirely derived "    \
-                     "from one source register");                             \
-               break;                                                         \
-            }                                                                 \
-         }                                                                    \
-                                                                              \
-         unsigned offset_0 =                                                  \
-            brw_inst_src ## n ## _da1_subreg_nr(devinfo, inst);               \
-         unsigned offset_1 = offset_0;                                        \
-                                                                              \
-         for (unsigned i = 0; i < exec_size; i++) {                           \
-            if (src ## n ## _access_mask[i] > 0xFFFFFFFF) {                   \
-               offset_1 = __builtin_ctzll(src ## n ## _access_mask[i]) - 32;  \
-               break;                                                         \
-            }                                                                 \
-         }                                                                    \
-                                                                              \
-         ERROR_IF(num_sources == 2 && offset_0 != offset_1,                   \
-                  "The offset from the two source registers "                 \
-                  "must be the same")
-
-         if (i == 0) {
-            DO_SRC(0);
-         } else {
-            DO_SRC(1);
+         const uint64_t *src_mask = src_access_mask[i];
+
+         if (src_regs[i] <= 1)
+            continue;
+
+         for (unsigned j = 0; j < exec_size; j++) {
+            if ((dst_access_mask[j] > 0xFFFFFFFF) !=
+                (src_mask[j] > 0xFFFFFFFF)) {
+               ERROR("Each destination register must be entirely derived "
+                     "from one source register");
+               break;
+            }
          }
-#undef DO_SRC
+
+         unsigned offset_0 = info->src[i].subnr;
+         unsigned offset_1 = offset_0;
+
+         for (unsigned j = 0; j < exec_size; j++) {
+            if (src_mask[j] > 0xFFFFFFFF) {
+               offset_1 = __builtin_ctzll(src_mask[j]) - 32;
+               break;
+            }
+         }
+
+         ERROR_IF(num_sources == 2 && offset_0 != offset_1,
+                  "The offset from the two source registers "
+                  "must be the same");
       }
    }
 
@@ -1637,35 +1634,24 @@ region_alignment_rules(const struct gen_device_info *devinfo,
     * is that the size of the destination type is 4 bytes.
     */
    if (devinfo->ver <= 7 && dst_regs == 2) {
-      enum brw_reg_type dst_type = inst_dst_type(devinfo, inst);
       bool dst_is_packed_dword =
          is_packed(exec_size * stride, exec_size, stride) &&
          brw_reg_type_to_size(dst_type) == 4;
 
       for (unsigned i = 0; i < num_sources; i++) {
-#define DO_SRC(n)                                                                  \
-         unsigned vstride, width, hstride;                                         \
-         vstride = STRIDE(brw_inst_src ## n ## _vstride(devinfo, inst));           \
-         width = WIDTH(brw_inst_src ## n ## _width(devinfo, inst));                \
-         hstride = STRIDE(brw_inst_src ## n ## _hstride(devinfo, inst));           \
-         bool src ## n ## _is_packed_word =                                        \
-            is_packed(vstride, width, hstride) &&                                  \
-            (brw_inst_src ## n ## _type(devinfo, inst) == BRW_REGISTER_TYPE_W ||   \
-             brw_inst_src ## n ## _type(devinfo, inst) == BRW_REGISTER_TYPE_UW);   \
-                                                                                   \
-         ERROR_IF(src ## n ## _regs == 1 &&                                        \
-                  !src ## n ## _has_scalar_region(devinfo, inst) &&                \
-                  !(dst_is_packed_dword && src ## n ## _is_packed_word),           \
-                  "When the destination spans two registers, the source must "     \
-                  "span two registers\n" ERROR_INDENT "(exceptions for scalar "    \
-                  "source and packed-word to packed-dword expansion)")
-
-         if (i == 0) {
-            DO_SRC(0);
-         } else {
-            DO_SRC(1);
-         }
-#undef DO_SRC
+         const struct operand_info *src = &info->src[i];
+         bool src_is_packed_word =
+            is_packed(STRIDE(src->vstride), WIDTH(src->width),
+                      STRIDE(src->hstride)) &&
+            (src->type == BRW_REGISTER_TYPE_W ||
+             src->type == BRW_REGISTER_TYPE_UW);
+
+         ERROR_IF(src_regs[i] == 1 &&
+                  !reg_has_scalar_region(src) &&
+                  !(dst_is_packed_dword && src_is_packed_word),
+                  "When the destination spans two registers, the source must "
+                  "span two registers\n" ERROR_INDENT "(exceptions for scalar "
+                  "source and packed-word to packed-dword expansion)");
       }
    }
 
@@ -1674,28 +1660,25 @@ region_alignment_rules(const struct gen_device_info *devinfo,
 
 static struct string
 vector_immediate_restrictions(const struct gen_device_info *devinfo,
-                              const brw_inst *inst)
+                              const brw_inst *inst,
+                              const struct inst_info *info)
 {
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
+   unsigned num_sources = info->num_sources;
    struct string error_msg = { .str = NULL, .len = 0 };
 
    if (num_sources == 3 || num_sources == 0)
       return (struct string){};
 
-   unsigned file = num_sources == 1 ?
-                   brw_inst_src0_reg_file(devinfo, inst) :
-                   brw_inst_src1_reg_file(devinfo, inst);
-   if (file != BRW_IMMEDIATE_VALUE)
+   const struct operand_info *src = &info->src[num_sources - 1];
+   if (src->file != BRW_IMMEDIATE_VALUE)
       return (struct string){};
 
-   enum brw_reg_type dst_type = inst_dst_type(devinfo, inst);
+   enum brw_reg_type dst_type = info->dst.type;
    unsigned dst_type_size = brw_reg_type_to_size(dst_type);
-   unsigned dst_subreg = brw_inst_access_mode(devinfo, inst) == BRW_ALIGN_1 ?
-                         brw_inst_dst_da1_subreg_nr(devinfo, inst) : 0;
-   unsigned dst_stride = STRIDE(brw_inst_dst_hstride(devinfo, inst));
-   enum brw_reg_type type = num_sources == 1 ?
-                            brw_inst_src0_type(devinfo, inst) :
-                            brw_inst_src1_type(devinfo, inst);
+   unsigned dst_subreg = info->access_mode == BRW_ALIGN_1 ?
+                         info->dst.subnr : 0;
+   unsigned dst_stride = STRIDE(info->dst.hstride);
+   enum brw_reg_type type = src->type;
 
    /* The PRMs say:
     *
@@ -1736,68 +1719,56 @@ vector_immediate_restrictions(const struct gen_device_info *devinfo,
 static struct string
 special_requirements_for_handling_double_precision_data_types(
                                        const struct gen_device_info *devinfo,
-                                       const brw_inst *inst)
+                                       const brw_inst *inst,
+                                       const struct inst_info *info)
 {
-   unsigned num_sources = num_sources_from_inst(devinfo, inst);
+   unsigned num_sources = info->num_sources;
    struct string error_msg = { .str = NULL, .len = 0 };
 
    if (num_sources == 3 || num_sources == 0)
       return (struct string){};
 
    /* Split sends don't have types so there's no doubles there. */
-   if (inst_is_split_send(devinfo, inst))
+   if (info->is_split_send)
       return (struct string){};
 
-   enum brw_reg_type exec_type = execution_type(devinfo, inst);
+   enum brw_reg_type exec_type = execution_type(devinfo, info);
    unsigned exec_type_size = brw_reg_type_to_size(exec_type);
 
-   enum brw_reg_file dst_file = brw_inst_dst_reg_file(devinfo, inst);
-   enum brw_reg_type dst_type = inst_dst_type(devinfo, inst);
+   enum brw_reg_file dst_file = info->dst.file;
+   enum brw_reg_type dst_type = info->dst.type;
    unsigned dst_type_size = brw_reg_type_to_size(dst_type);
-   unsigned dst_hstride = STRIDE(brw_inst_dst_hstride(devinfo, inst));
-   unsigned dst_reg = brw_inst_dst_da_reg_nr(devinfo, inst);
-   unsigned dst_subreg = brw_inst_dst_da1_subreg_nr(devinfo, inst);
-   unsigned dst_address_mode = brw_inst_dst_address_mode(devinfo, inst);
+   unsigned dst_hstride = STRIDE(info->dst.hstride);
+   unsigned dst_reg = info->dst.nr;
+   unsigned dst_subreg = info->dst.subnr;
+   unsigned dst_address_mode = info->dst.address_mode;
 
    bool is_integer_dword_multiply =
       devinfo->ver >= 8 &&
-      brw_inst_opcode(devinfo, inst) == BRW_OPCODE_MUL &&
-      (brw_inst_src0_type(devinfo, inst) == BRW_REGISTER_TYPE_D ||
-       brw_inst_src0_type(devinfo, inst) == BRW_REGISTER_TYPE_UD) &&
-      (brw_inst_src1_type(devinfo, inst) == BRW_REGISTER_TYPE_D ||
-       brw_inst_src1_type(devinfo, inst) == BRW_REGISTER_TYPE_UD);
+      info->opcode == BRW_OPCODE_MUL &&
+      (info->src[0].type == BRW_REGISTER_TYPE_D ||
+       info->src[0].type == BRW_REGISTER_TYPE_UD) &&
+      (info->src[1].type == BRW_REGISTER_TYPE_D ||
+       info->src[1].type == BRW_REGISTER_TYPE_UD);
 
    if (dst_type_size != 8 && exec_type_size != 8 && !is_integer_dword_multiply)
       return (struct string){};
 
    for (unsigned i = 0; i < num_sources; i++) {
-      unsigned vstride, width, hstride, type_size, reg, subreg, address_mode;
-      bool is_scalar_region;
-      enum brw_reg_file file;
-      enum brw_reg_type type;
+      const struct operand_info *src = &info->src[i];
 
-#define DO_SRC(n)                                                              \
-      if (brw_inst_src ## n ## _reg_file(devinfo, inst) ==                     \
-          BRW_IMMEDIATE_VALUE)                                                 \
-         continue;                                                             \
-                                                                               \
-      is_scalar_region = src ## n ## _has_scalar_region(devinfo, inst);        \
-      vstride = STRIDE(brw_inst_src ## n ## _vstride(devinfo, inst));          \
-      width = WIDTH(brw_inst_src ## n ## _width(devinfo, inst));               \
-      hstride = STRIDE(brw_inst_src ## n ## _hstride(devinfo, inst));          \
-      file = brw_inst_src ## n ## _reg_file(devinfo, inst);                    \
-      type = brw_inst_src ## n ## _type(devinfo, inst);                        \
-      type_size = brw_reg_type_to_size(type);                                  \
-      reg = brw_inst_src ## n ## _da_reg_nr(devinfo, inst);                    \
-      subreg = brw_inst_src ## n ## _da1_subreg_nr(devinfo, inst);             \
-      address_mode = brw_inst_src ## n ## _address_mode(devinfo, inst)
-
-      if (i == 0) {
-         DO_SRC(0);
-      } else {
-         DO_SRC(1);
-      }
-#undef DO_SRC
+      if (src->file == BRW_IMMEDIATE_VALUE)
+         continue;
+
+      bool is_scalar_region = reg_has_scalar_region(src);
+      unsigned vstride = STRIDE(src->vstride);
+      unsigned width = WIDTH(src->width);
+      unsigned hstride = STRIDE(src->hstride);
+      enum brw_reg_file file = src->file;
+      unsigned type_size = brw_reg_type_to_size(src->type);
+      unsigned reg = src->nr;
+      unsigned subreg = src->subnr;
+      unsigned address_mode = src->address_mode;
 
       /* The PRMs say that for CHV, BXT:
        *
@@ -1812,7 +1783,7 @@ special_requirements_for_handling_double_precision_data_types(
        *
        * We assume that the restriction applies to GLK as well.
        */
-      if (brw_inst_access_mode(devinfo, inst) == BRW_ALIGN_1 &&
+      if (info->access_mode == BRW_ALIGN_1 &&
           (devinfo->is_cherryview || gen_device_info_is_9lp(devinfo))) {
          unsigned src_stride = hstride * type_size;
          unsigned dst_stride = dst_hstride * dst_type_size;
@@ -1857,7 +1828,7 @@ special_requirements_for_handling_double_precision_data_types(
        * We assume that the restriction does not apply to the null register.
        */
       if (devinfo->is_cherryview || gen_device_info_is_9lp(devinfo)) {
-         ERROR_IF(brw_inst_opcode(devinfo, inst) == BRW_OPCODE_MAC ||
+         ERROR_IF(info->opcode == BRW_OPCODE_MAC ||
                   brw_inst_acc_wr_control(devinfo, inst) ||
                   (BRW_ARCHITECTURE_REGISTER_FILE == file &&
                    reg != BRW_ARF_NULL) ||
@@ -1876,16 +1847,16 @@ special_requirements_for_handling_double_precision_data_types(
     * We assume that the restriction applies to all Gfx8+ parts.
     */
    if (devinfo->ver >= 8) {
-      enum brw_reg_type src0_type = brw_inst_src0_type(devinfo, inst);
+      enum brw_reg_type src0_type = info->src[0].type;
       enum brw_reg_type src1_type =
-         num_sources > 1 ? brw_inst_src1_type(devinfo, inst) : src0_type;
+         num_sources > 1 ? info->src[1].type : src0_type;
       unsigned src0_type_size = brw_reg_type_to_size(src0_type);
       unsigned src1_type_size = brw_reg_type_to_size(src1_type);
 
-      ERROR_IF(brw_inst_access_mode(devinfo, inst) == BRW_ALIGN_16 &&
+      ERROR_IF(info->access_mode == BRW_ALIGN_16 &&
                dst_type_size == 8 &&
                (src0_type_size != 8 || src1_type_size != 8) &&
-               brw_inst_exec_size(devinfo, inst) > BRW_EXECUTE_2,
+               info->exec_size > 2,
                "In Align16 exec size cannot exceed 2 with a QWord destination "
                "and a non-QWord source");
    }
@@ -1908,7 +1879,7 @@ special_requirements_for_handling_double_precision_data_types(
 
 static struct string
 instruction_restrictions(const struct gen_device_info *devinfo,
-                         const brw_inst *inst)
+                         const brw_inst *inst, const struct inst_info *info)
 {
    struct string error_msg = { .str = NULL, .len = 0 };
 
@@ -1917,15 +1888,14 @@ instruction_restrictions(const struct gen_device_info *devinfo,
     * "When multiplying a DW and any lower precision integer, source modifier
     *  is not supported."
     */
-   if (devinfo->ver >= 12 &&
-       brw_inst_opcode(devinfo, inst) == BRW_OPCODE_MUL) {
-      enum brw_reg_type exec_type = execution_type(devinfo, inst);
-      const bool src0_valid = type_sz(brw_inst_src0_type(devinfo, inst)) == 4 ||
-         brw_inst_src0_reg_file(devinfo, inst) == BRW_IMMEDIATE_VALUE ||
+   if (devinfo->ver >= 12 && info->opcode == BRW_OPCODE_MUL) {
+      enum brw_reg_type exec_type = execution_type(devinfo, info);
+      const bool src0_valid = type_sz(info->src[0].type) == 4 ||
+         info->src[0].file == BRW_IMMEDIATE_VALUE ||
          !(brw_inst_src0_negate(devinfo, inst) ||
            brw_inst_src0_abs(devinfo, inst));
-      const bool src1_valid = type_sz(brw_inst_src1_type(devinfo, inst)) == 4 ||
-         brw_inst_src1_reg_file(devinfo, inst) == BRW_IMMEDIATE_VALUE ||
+      const bool src1_valid = type_sz(info->src[1].type) == 4 ||
+         info->src[1].file == BRW_IMMEDIATE_VALUE ||
          !(brw_inst_src1_negate(devinfo, inst) ||
            brw_inst_src1_abs(devinfo, inst));
 
@@ -1935,8 +1905,8 @@ instruction_restrictions(const struct gen_device_info *devinfo,
                "modifier is not supported.");
    }
 
-   if (brw_inst_opcode(devinfo, inst) == BRW_OPCODE_CMP ||
-       brw_inst_opcode(devinfo, inst) == BRW_OPCODE_CMPN) {
+   if (info->opcode == BRW_OPCODE_CMP ||
+       info->opcode == BRW_OPCODE_CMPN) {
       if (devinfo->ver <= 7) {
          /* Page 166 of the Ivy Bridge PRM Volume 4 part 3 (Execution Unit
           * ISA) says:
@@ -1952,8 +1922,8 @@ instruction_restrictions(const struct gen_device_info *devinfo,
           *    For the cmp and cmpn instructions, remove the accumulator
           *    restrictions.
           */
-         ERROR_IF(brw_inst_dst_reg_file(devinfo, inst) == BRW_ARCHITECTURE_REGISTER_FILE &&
-                  brw_inst_dst_da_reg_nr(devinfo, inst) != BRW_ARF_NULL,
+         ERROR_IF(info->dst.file == BRW_ARCHITECTURE_REGISTER_FILE &&
+                  info->dst.nr != BRW_ARF_NULL,
                   "Accumulator cannot be destination, implicit or explicit.");
       }
 
@@ -1966,7 +1936,7 @@ instruction_restrictions(const struct gen_device_info *devinfo,
        * Page 77 of the Haswell PRM Volume 2b contains the same text.
        */
       if (devinfo->ver == 7) {
-         ERROR_IF(dst_is_null(devinfo, inst) &&
+         ERROR_IF(reg_is_null(&info->dst) &&
                   brw_inst_thread_control(devinfo, inst) != BRW_THREAD_SWITCH,
                   "If the destination is the null register, the {Switch} "
                   "instruction option must be used.");
@@ -1986,19 +1956,22 @@ brw_validate_instruction(const struct gen_device_info *devinfo,
    if (is_unsupported_inst(devinfo, inst)) {
       ERROR("Instruction not supported on this Gen");
    } else {
-      CHECK(invalid_values);
+      struct inst_info info;
+      decode_inst(devinfo, inst, &info);
+
+      CHECK(invalid_values, &info);
 
       if (error_msg.str == NULL) {
-         CHECK(sources_not_null);
-         CHECK(send_restrictions);
-         CHECK(alignment_supported);
-         CHECK(general_restrictions_based_on_operand_types);
-         CHECK(general_restrictions_on_region_parameters);
-         CHECK(special_restrictions_for_mixed_float_mode);
-         CHECK(region_alignment_rules);
-         CHECK(vector_immediate_restrictions);
-         CHECK(special_requirements_for_handling_double_precision_data_types);
-         CHECK(instruction_restrictions);
+         CHECK(sources_not_null, &info);
+         CHECK(send_restrictions, &info);
+         CHECK(alignment_supported, &info);
+         CHECK(general_restrictions_based_on_operand_types, &info);
+         CHECK(general_restrictions_on_region_parameters, &info);
+         CHECK(special_restrictions_for_mixed_float_mode, &info);
+         CHECK(region_alignment_rules, &info);
+         CHECK(vector_immediate_restrictions, &info);
+         CHECK(special_requirements_for_handling_double_precision_data_types, &info);
+         CHECK(instruction_restrictions, &info);
       }
    }
 
@@ -40,7 +40,11 @@
 #include "compiler/glsl_types.h"
 #include "compiler/nir/nir_builder.h"
 #include "program/prog_parameter.h"
+#include "util/os_time.h"
 #include "util/u_math.h"
+#include "c11/threads.h"
+
+#include <time.h>
 
 using namespace brw;
 
@@ -1213,7 +1217,8 @@ fs_reg::fs_reg(enum brw_reg_file file, int nr, enum brw_reg_type type)
 }
 
 /* For SIMD16, we need to follow from the uniform setup of SIMD8 dispatch.
- * This brings in those uniform definitions
+ * This brings in those uniform definitions, along with the rest of the state
+ * which doesn't depend on the dispatch width.
  */
 void
 fs_visitor::import_uniforms(fs_visitor *v)
@@ -1224,6 +1229,12 @@ fs_visitor::import_uniforms(fs_visitor *v)
    this->subgroup_id = v->subgroup_id;
    for (unsigned i = 0; i < ARRAY_SIZE(this->group_size); i++)
       this->group_size[i] = v->group_size[i];
+
+   /* Compute shaders are lowered separately for each width, so only reuse
+    * the NIR scan when both variants were compiled from the same shader.
+    */
+   if (v->nir == this->nir)
+      this->nir_system_values_used = v->nir_system_values_used;
 }
 
 void
@@ -7817,6 +7828,105 @@ fs_visitor::invalidate_analysis(brw::analysis_dependency_class c)
    backend_shader::invalidate_analysis(c);
    live_analysis.invalidate(c);
    regpressure_analysis.invalidate(c);
+
+   if (c != DEPENDENCY_NOTHING) {
+      ir_generation++;
+      invalidated_analyses = invalidated_analyses | c;
+   }
+}
+
+/**
+ * Looks up the book-keeping of an optimization pass before running it.
+ * Returns NULL if the pass can be skipped because it made no progress the
+ * last time it ran and the IR hasn't changed since.
+ */
+opt_pass_info *
+fs_visitor::begin_opt_pass(const char *name)
+{
+   opt_pass_info *info = NULL;
+   for (unsigned i = 0; i < num_opt_passes; i++) {
+      if (opt_passes[i].name == name || !strcmp(opt_passes[i].name, name)) {
+         info = &opt_passes[i];
+         break;
+      }
+   }
+
+   if (!info) {
+      opt_passes = reralloc(mem_ctx, opt_passes, opt_pass_info,
+                            num_opt_passes + 1);
+      info = &opt_passes[num_opt_passes++];
+      memset(info, 0, sizeof(*info));
+      info->name = name;
+      info->clean_generation = ~0u;
+   }
+
+   if (info->clean_generation == ir_generation) {
+      info->skips++;
+      return NULL;
+   }
+
+   invalidated_analyses = DEPENDENCY_NOTHING;
+   info->start = (INTEL_DEBUG & DEBUG_OPT_TIME) ? os_time_get_nano() : 0;
+   return info;
+}
+
+void
+fs_visitor::end_opt_pass(opt_pass_info *info, bool progress)
+{
+   if (INTEL_DEBUG & DEBUG_OPT_TIME)
+      info->time += os_time_get_nano() - info->start;
+
+   info->runs++;
+   info->invalidated = info->invalidated | invalidated_analyses;
+
+   if (progress) {
+      /* Don't rely on the pass invalidating the analyses it affected for
+       * skipping the passes that follow.
+       */
+      info->progress++;
+      ir_generation++;
+   } else {
+      info->clean_generation = ir_generation;
+   }
+}
+
+void
+fs_visitor::report_opt_passes() const
+{
+   static const struct {
+      analysis_dependency_class c;
+      char name;
+   } classes[] = {
+      { DEPENDENCY_INSTRUCTION_IDENTITY, 'I' },
+      { DEPENDENCY_INSTRUCTION_DETAIL, 'D' },
+      { DEPENDENCY_INSTRUCTION_DATA_FLOW, 'F' },
+      { DEPENDENCY_VARIABLES, 'V' },
+      { DEPENDENCY_BLOCKS, 'B' },
+   };
+
+   uint64_t total = 0;
+   for (unsigned i = 0; i < num_opt_passes; i++)
+      total += opt_passes[i].time;
+
+   fprintf(stderr, "%s SIMD%d optimization passes for %s: %.3f ms\n",
+           stage_abbrev, dispatch_width, nir->info.name,
+           total / 1000000.0);
+   fprintf(stderr, "  %-32s %5s %5s %8s %10s %s\n",
+           "pass", "runs", "skips", "progress", "ms", "invalidates");
+
+   for (unsigned i = 0; i < num_opt_passes; i++) {
+      const opt_pass_info *info = &opt_passes[i];
+      char invalidated[ARRAY_SIZE(classes) + 1];
+
+      for (unsigned j = 0; j < ARRAY_SIZE(classes); j++)
+         invalidated[j] = (info->invalidated & classes[j].c) ?
+                          classes[j].name : '-';
+      invalidated[ARRAY_SIZE(classes)] = '\0';
+
+      fprintf(stderr, "  %-32s %5u %5u %8u %10.3f %s\n",
+              info->name, info->runs, info->skips, info->progress,
+              info->time / 1000000.0, invalidated);
+   }
 }
 
 void
@@ -7848,7 +7958,13 @@ fs_visitor::optimize()
 
 #define OPT(pass, args...) ({                                           \
       pass_num++;                                                       \
-      bool this_progress = pass(args);                                  \
+      bool this_progress = false;                                       \
+      opt_pass_info *this_pass = begin_opt_pass(#pass);                 \
+                                                                        \
+      if (this_pass) {                                                  \
+         this_progress = pass(args);                                    \
+         end_opt_pass(this_pass, this_progress);                        \
+      }                                                                 \
                                                                         \
       if ((INTEL_DEBUG & DEBUG_OPTIMIZER) && this_progress) {           \
          char filename[64];                                             \
@@ -7858,7 +7974,8 @@ fs_visitor::optimize()
          backend_shader::dump_instructions(filename);                   \
       }                                                                 \
                                                                         \
-      validate();                                                       \
+      if (this_pass)                                                    \
+         validate();                                                    \
                                                                         \
       progress = progress || this_progress;                             \
       this_progress;                                                    \
@@ -8230,6 +8347,17 @@ fs_visitor::allocate_registers(bool allow_spilling)
       schedule_instructions(pre_modes[i]);
       this->shader_stats.scheduler_mode = scheduler_mode_name[i];
 
+      if (i == 0) {
+         const register_pressure &rp = regpressure_analysis.require();
+         const unsigned num_instructions = cfg->num_blocks ?
+            cfg->blocks[cfg->num_blocks - 1]->end_ip + 1 : 0;
+
+         max_register_pressure = 0;
+         for (unsigned ip = 0; ip < num_instructions; ip++)
+            max_register_pressure = MAX2(max_register_pressure,
+                                         rp.regs_live_at_ip[ip]);
+      }
+
       if (0) {
          assign_regs_trivial();
          allocated = true;
@@ -8325,6 +8453,9 @@ fs_visitor::allocate_registers(bool allow_spilling)
    }
 
    lower_scoreboard();
+
+   if (unlikely(INTEL_DEBUG & DEBUG_OPT_TIME))
+      report_opt_passes();
 }
 
 bool
@@ -9161,8 +9292,41 @@ brw_compile_fs(const struct brw_compiler *compiler,
 
    const bool simd16_failed = v16 && !simd16_cfg;
 
+   /* Compiling SIMD32 is about as expensive as SIMD8 and SIMD16 together and
+    * it gets thrown away whenever it doesn't beat the narrower variants, so
+    * use the SIMD16 result to skip it when it's unlikely to win:
+    *
+    *  - If SIMD16 didn't improve the estimated throughput over SIMD8, the
+    *    shader is bound by something that doesn't scale with the dispatch
+    *    width and SIMD32 won't do better.
+    *
+    *  - Vector values take twice the registers in SIMD32.  If doubling the
+    *    SIMD16 register pressure doesn't fit in the register file, SIMD32
+    *    would have to spill, which isn't allowed at this point anyway.
+    */
+   bool simd32_unprofitable = false;
+   if (simd16_cfg && !(INTEL_DEBUG & DEBUG_DO32)) {
+      const performance &perf16 = v16->performance_analysis.require();
+
+      if (simd8_cfg &&
+          perf16.throughput <= v8->performance_analysis.require().throughput) {
+         compiler->shader_perf_log(params->log_data,
+                                   "SIMD32 shader skipped: SIMD16 is not "
+                                   "faster than SIMD8\n");
+         simd32_unprofitable = true;
+      } else if (!allow_spilling &&
+                 2 * v16->max_register_pressure > BRW_MAX_GRF) {
+         compiler->shader_perf_log(params->log_data,
+                                   "SIMD32 shader skipped: estimated register "
+                                   "pressure %u exceeds %u GRFs\n",
+                                   2 * v16->max_register_pressure,
+                                   BRW_MAX_GRF);
+         simd32_unprofitable = true;
+      }
+   }
+
    /* Currently, the compiler only supports SIMD32 on SNB+ */
-   if (!has_spilled &&
+   if (!has_spilled && !simd32_unprofitable &&
        v8->max_dispatch_width >= 32 && !params->use_rep_send &&
        devinfo->ver >= 6 && !simd16_failed &&
        !(INTEL_DEBUG & DEBUG_NO32)) {
@@ -9411,15 +9575,13 @@ brw_nir_lower_simd(nir_shader *nir, unsigned dispatch_width)
                                  (void *)(uintptr_t)dispatch_width);
 }
 
-static nir_shader *
-compile_cs_to_nir(const struct brw_compiler *compiler,
-                  void *mem_ctx,
-                  const struct brw_cs_prog_key *key,
-                  const nir_shader *src_shader,
-                  unsigned dispatch_width,
-                  bool debug_enabled)
+static void
+lower_cs_nir(const struct brw_compiler *compiler,
+             const struct brw_cs_prog_key *key,
+             nir_shader *shader,
+             unsigned dispatch_width,
+             bool debug_enabled)
 {
-   nir_shader *shader = nir_shader_clone(mem_ctx, src_shader);
    brw_nir_apply_key(shader, compiler, &key->base, dispatch_width, true);
 
    NIR_PASS_V(shader, brw_nir_lower_simd, dispatch_width);
@@ -9430,10 +9592,110 @@ compile_cs_to_nir(const struct brw_compiler *compiler,
 
    brw_postprocess_nir(shader, compiler, true, debug_enabled,
                        key->base.robust_buffer_access);
+}
 
+static nir_shader *
+compile_cs_to_nir(const struct brw_compiler *compiler,
+                  void *mem_ctx,
+                  const struct brw_cs_prog_key *key,
+                  const nir_shader *src_shader,
+                  unsigned dispatch_width,
+                  bool debug_enabled)
+{
+   nir_shader *shader = nir_shader_clone(mem_ctx, src_shader);
+   lower_cs_nir(compiler, key, shader, dispatch_width, debug_enabled);
    return shader;
 }
 
+struct cs_nir_job {
+   const struct brw_compiler *compiler;
+   const struct brw_cs_prog_key *key;
+   nir_shader *shader;
+   unsigned dispatch_width;
+   int64_t cpu_time;
+};
+
+static int64_t
+thread_cpu_time_nano()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+   return ts.tv_sec * INT64_C(1000000000) + ts.tv_nsec;
+}
+
+static int
+lower_cs_nir_job(void *data)
+{
+   struct cs_nir_job *job = (struct cs_nir_job *)data;
+   int64_t start = thread_cpu_time_nano();
+   lower_cs_nir(job->compiler, job->key, job->shader, job->dispatch_width,
+                false);
+   job->cpu_time = thread_cpu_time_nano() - start;
+   return 0;
+}
+
+/**
+ * Lower the NIR for all SIMD widths in simd_mask concurrently.  Every clone
+ * gets its own ralloc context, so the threads never allocate from the same
+ * parent.  The lowering of each width is independent of the others, so the
+ * result is the same as with compile_cs_to_nir().
+ */
+static void
+compile_cs_to_nir_parallel(const struct brw_compiler *compiler,
+                           void *log_data,
+                           void *mem_ctx,
+                           const struct brw_cs_prog_key *key,
+                           const nir_shader *src_shader,
+                           unsigned simd_mask,
+                           nir_shader **simd_nir)
+{
+   struct cs_nir_job jobs[3];
+   thrd_t threads[3];
+   bool started[3] = { false, false, false };
+
+   for (unsigned i = 0; i < 3; i++) {
+      if (!(simd_mask & (1 << i)))
+         continue;
+
+      jobs[i].compiler = compiler;
+      jobs[i].key = key;
+      jobs[i].shader = nir_shader_clone(ralloc_context(mem_ctx), src_shader);
+      jobs[i].dispatch_width = 8 << i;
+      jobs[i].cpu_time = 0;
+      simd_nir[i] = jobs[i].shader;
+   }
+
+   const int64_t start = os_time_get_nano();
+
+   /* Lower the smallest width on this thread and the others on new ones. */
+   const unsigned first = ffs(simd_mask) - 1;
+   for (unsigned i = first + 1; i < 3; i++) {
+      if (simd_mask & (1 << i))
+         started[i] = thrd_create(&threads[i], lower_cs_nir_job, &jobs[i]) == thrd_success;
+   }
+
+   lower_cs_nir_job(&jobs[first]);
+
+   int64_t cpu_time = jobs[first].cpu_time;
+   for (unsigned i = first + 1; i < 3; i++) {
+      if (!(simd_mask & (1 << i)))
+         continue;
+
+      if (started[i])
+         thrd_join(threads[i], NULL);
+      else
+         lower_cs_nir_job(&jobs[i]);
+      cpu_time += jobs[i].cpu_time;
+   }
+
+   compiler->shader_perf_log(log_data,
+                             "CS NIR lowering for %u SIMD widths: "
+                             "%.3f ms wall clock, %.3f ms CPU\n",
+                             util_bitcount(simd_mask),
+                             (os_time_get_nano() - start) / 1000000.0,
+                             cpu_time / 1000000.0);
+}
+
 const unsigned *
 brw_compile_cs(const struct brw_compiler *compiler,
                void *mem_ctx,
@@ -9499,10 +9761,33 @@ brw_compile_cs(const struct brw_compiler *compiler,
    fs_visitor *v8 = NULL, *v16 = NULL, *v32 = NULL;
    fs_visitor *v = NULL;
 
+   /* Only the widths which are going to be compiled unless an earlier one
+    * spills get lowered up front.  SIMD32 is usually only needed when the
+    * smaller widths fail, so it is left to be lowered on demand.
+    */
+   nir_shader *simd_nir[3] = { NULL, NULL, NULL };
+   if (compiler->parallel_simd_nir && !debug_enabled) {
+      unsigned simd_mask = 0;
+      if (!(INTEL_DEBUG & DEBUG_NO8) && min_dispatch_width <= 8)
+         simd_mask |= 1 << 0;
+      if (!(INTEL_DEBUG & DEBUG_NO16) &&
+          min_dispatch_width <= 16 && max_dispatch_width >= 16)
+         simd_mask |= 1 << 1;
+      if (!(INTEL_DEBUG & DEBUG_NO32) &&
+          (generate_all || (INTEL_DEBUG & DEBUG_DO32) ||
+           min_dispatch_width == 32))
+         simd_mask |= 1 << 2;
+
+      if (util_bitcount(simd_mask) > 1) {
+         compile_cs_to_nir_parallel(compiler, params->log_data, mem_ctx, key,
+                                    nir, simd_mask, simd_nir);
+      }
+   }
+
    if (!(INTEL_DEBUG & DEBUG_NO8) &&
        min_dispatch_width <= 8 && max_dispatch_width >= 8) {
-      nir_shader *nir8 = compile_cs_to_nir(compiler, mem_ctx, key,
-                                           nir, 8, debug_enabled);
+      nir_shader *nir8 = simd_nir[0] ? simd_nir[0] :
+         compile_cs_to_nir(compiler, mem_ctx, key, nir, 8, debug_enabled);
       v8 = new fs_visitor(compiler, params->log_data, mem_ctx, &key->base,
                           &prog_data->base,
                           nir8, 8, shader_time_index, debug_enabled);
@@ -9526,8 +9811,8 @@ brw_compile_cs(const struct brw_compiler *compiler,
        (generate_all || !prog_data->prog_spilled) &&
        min_dispatch_width <= 16 && max_dispatch_width >= 16) {
       /* Try a SIMD16 compile */
-      nir_shader *nir16 = compile_cs_to_nir(compiler, mem_ctx, key,
-                                            nir, 16, debug_enabled);
+      nir_shader *nir16 = simd_nir[1] ? simd_nir[1] :
+         compile_cs_to_nir(compiler, mem_ctx, key, nir, 16, debug_enabled);
       v16 = new fs_visitor(compiler, params->log_data, mem_ctx, &key->base,
                            &prog_data->base,
                            nir16, 16, shader_time_index, debug_enabled);
@@ -9572,8 +9857,8 @@ brw_compile_cs(const struct brw_compiler *compiler,
        needs_32 &&
        min_dispatch_width <= 32 && max_dispatch_width >= 32) {
       /* Try a SIMD32 compile */
-      nir_shader *nir32 = compile_cs_to_nir(compiler, mem_ctx, key,
-                                            nir, 32, debug_enabled);
+      nir_shader *nir32 = simd_nir[2] ? simd_nir[2] :
+         compile_cs_to_nir(compiler, mem_ctx, key, nir, 32, debug_enabled);
       v32 = new fs_visitor(compiler, params->log_data, mem_ctx, &key->base,
                            &prog_data->base,
                            nir32, 32, shader_time_index, debug_enabled);
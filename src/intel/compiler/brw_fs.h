@@ -38,6 +38,7 @@
 struct bblock_t;
 namespace {
    struct acp_entry;
+   struct acp;
 }
 
 class fs_visitor;
@@ -80,9 +81,34 @@ offset(const fs_reg &reg, const brw::fs_builder &bld, unsigned delta)
 
 #define UBO_START ((1 << 16) - 4)
 
+/**
+ * Book-keeping for one optimization pass run through the OPT() macro.
+ */
+struct opt_pass_info {
+   const char *name;
+   unsigned runs;
+   unsigned skips;
+   unsigned progress;
+   uint64_t time;
+
+   /** Union of the analysis dependency classes invalidated by the pass. */
+   brw::analysis_dependency_class invalidated;
+
+   /**
+    * Value of fs_visitor::ir_generation after the last run of the pass which
+    * made no progress.  Running it again while the IR hasn't changed since
+    * then can't make progress either, so it's skipped.
+    */
+   unsigned clean_generation;
+
+   int64_t start;
+};
+
 struct shader_stats {
    const char *scheduler_mode;
    unsigned promoted_constants;
+   /** Nanoseconds spent in all instruction scheduling passes. */
+   uint64_t schedule_time;
 };
 
 /**
@@ -157,17 +183,19 @@ public:
                       unsigned *out_pull_index);
    void lower_constant_loads();
    virtual void invalidate_analysis(brw::analysis_dependency_class c);
+   opt_pass_info *begin_opt_pass(const char *name);
+   void end_opt_pass(opt_pass_info *info, bool progress);
+   void report_opt_passes() const;
    void validate();
    bool opt_algebraic();
    bool opt_redundant_halt();
    bool opt_cse();
-   bool opt_cse_local(const brw::fs_live_variables &live, bblock_t *block, int &ip);
 
    bool opt_copy_propagation();
    bool try_copy_propagate(fs_inst *inst, int arg, acp_entry *entry);
    bool try_constant_propagate(fs_inst *inst, acp_entry *entry);
    bool opt_copy_propagation_local(void *mem_ctx, bblock_t *block,
-                                   exec_list *acp);
+                                   struct acp &acp);
    bool opt_drop_redundant_mov_to_flags();
    bool opt_register_renaming();
    bool opt_bank_conflicts();
@@ -383,6 +411,13 @@ public:
    fs_reg *nir_ssa_values;
    fs_reg *nir_system_values;
 
+   /**
+    * System values which need setup code.  This only depends on the NIR, so
+    * it is shared between SIMD variants of the same shader by
+    * import_uniforms().
+    */
+   BITSET_WORD *nir_system_values_used;
+
    bool failed;
    char *fail_msg;
 
@@ -418,6 +453,24 @@ public:
    unsigned grf_used;
    bool spilled_any_registers;
 
+   /**
+    * Incremented every time the IR changes, i.e. whenever an analysis is
+    * invalidated.
+    */
+   unsigned ir_generation;
+
+   /** Analysis dependency classes invalidated by the current pass. */
+   brw::analysis_dependency_class invalidated_analyses;
+
+   opt_pass_info *opt_passes;
+   unsigned num_opt_passes;
+
+   /**
+    * Maximum number of GRFs live at once after the first pre-RA scheduling
+    * pass, used to estimate whether a wider dispatch could be allocated.
+    */
+   unsigned max_register_pressure;
+
    const unsigned dispatch_width; /**< 8, 16 or 32 */
    unsigned max_dispatch_width;
 
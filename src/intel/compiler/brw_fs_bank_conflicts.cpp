@@ -502,43 +502,83 @@ namespace {
    }
 
    /**
-    * Calculate the finest partitioning of the GRF space compatible with the
-    * register contiguity requirements derived from all instructions part of
-    * the program.
+    * Ternary instruction with both sources in the GRF.
     */
-   partitioning
-   shader_reg_partitioning(const fs_visitor *v)
-   {
-      partitioning p(BRW_MAX_GRF);
+   struct ternary_conflict {
+      unsigned reg_r;
+      unsigned reg_s;
+      /** Cycle-count cost of incurring a bank conflict for the instruction. */
+      unsigned cycle_scale;
+   };
 
-      foreach_block_and_inst(block, fs_inst, inst, v->cfg) {
-         if (is_grf(inst->dst))
-            p.require_contiguous(reg_of(inst->dst), regs_written(inst));
+   /**
+    * Register usage of the whole program relevant to bank conflict
+    * optimization, gathered in a single walk over the instructions so that
+    * the rest of the pass doesn't need to look at the IR again.
+    */
+   struct shader_reg_accesses {
+      shader_reg_accesses() : p(BRW_MAX_GRF), constrained_regs(),
+                              conflicts(NULL), num_conflicts(0)
+      {
+      }
 
-         for (int i = 0; i < inst->sources; i++) {
-            if (is_grf(inst->src[i]))
-               p.require_contiguous(reg_of(inst->src[i]), regs_read(inst, i));
-         }
+      ~shader_reg_accesses()
+      {
+         delete[] conflicts;
       }
 
-      return p;
+      /**
+       * Finest partitioning of the GRF space compatible with the register
+       * contiguity requirements derived from all instructions part of the
+       * program.
+       */
+      partitioning p;
+
+      /**
+       * GRFs that should be left untouched at their original location to
+       * avoid violating hardware or software assumptions.
+       */
+      bool constrained_regs[BRW_MAX_GRF];
+
+      ternary_conflict *conflicts;
+      unsigned num_conflicts;
+
+   private:
+      shader_reg_accesses(const shader_reg_accesses &);
+      shader_reg_accesses &
+      operator=(const shader_reg_accesses &);
+   };
+
+   /**
+    * Return whether the hardware will be able to prevent a bank conflict by
+    * optimizing out the read cycle of a source register.  The formula was
+    * found experimentally.
+    */
+   bool
+   is_conflict_optimized_out(const gen_device_info *devinfo, const fs_inst *inst)
+   {
+      return devinfo->ver >= 9 &&
+         ((is_grf(inst->src[0]) && (reg_of(inst->src[0]) == reg_of(inst->src[1]) ||
+                                    reg_of(inst->src[0]) == reg_of(inst->src[2]))) ||
+          reg_of(inst->src[1]) == reg_of(inst->src[2]));
    }
 
    /**
-    * Return the set of GRF atoms that should be left untouched at their
-    * original location to avoid violating hardware or software assumptions.
+    * Walk the program once and gather its register contiguity requirements,
+    * register constraints and potential bank conflicts.
     */
-   bool *
-   shader_reg_constraints(const fs_visitor *v, const partitioning &p)
+   void
+   gather_shader_reg_accesses(const fs_visitor *v, shader_reg_accesses &a)
    {
-      bool *constrained = new bool[p.num_atoms()]();
+      const unsigned num_insts = v->cfg->last_block()->end_ip + 1;
+      a.conflicts = new ternary_conflict[num_insts];
 
       /* These are read implicitly by some send-message instructions without
        * any indication at the IR level.  Assume they are unsafe to move
        * around.
        */
       for (unsigned reg = 0; reg < 2; reg++)
-         constrained[p.atom_of_reg(reg)] = true;
+         a.constrained_regs[reg] = true;
 
       /* At Intel Broadwell PRM, vol 07, section "Instruction Set Reference",
        * subsection "EUISA Instructions", Send Message (page 990):
@@ -550,21 +590,34 @@ namespace {
        * breaking that property.
        */
       if (v->devinfo->ver >= 8)
-         constrained[p.atom_of_reg(127)] = true;
+         a.constrained_regs[127] = true;
+
+      /* Crude approximation of the number of times the current basic block
+       * will be executed at run-time.
+       */
+      unsigned block_scale = 1;
 
       foreach_block_and_inst(block, fs_inst, inst, v->cfg) {
+         if (is_grf(inst->dst))
+            a.p.require_contiguous(reg_of(inst->dst), regs_written(inst));
+
+         for (int i = 0; i < inst->sources; i++) {
+            if (is_grf(inst->src[i]))
+               a.p.require_contiguous(reg_of(inst->src[i]), regs_read(inst, i));
+         }
+
          /* Assume that anything referenced via fixed GRFs is baked into the
           * hardware's fixed-function logic and may be unsafe to move around.
           * Also take into account the source GRF restrictions of EOT
           * send-message instructions.
           */
          if (inst->dst.file == FIXED_GRF)
-            constrained[p.atom_of_reg(reg_of(inst->dst))] = true;
+            a.constrained_regs[reg_of(inst->dst)] = true;
 
          for (int i = 0; i < inst->sources; i++) {
             if (inst->src[i].file == FIXED_GRF ||
                 (is_grf(inst->src[i]) && inst->eot))
-               constrained[p.atom_of_reg(reg_of(inst->src[i]))] = true;
+               a.constrained_regs[reg_of(inst->src[i])] = true;
          }
 
          /* Preserve the original allocation of VGRFs used by the barycentric
@@ -573,7 +626,7 @@ namespace {
           */
          if (v->devinfo->has_pln && v->devinfo->ver <= 6 &&
              inst->opcode == FS_OPCODE_LINTERP)
-            constrained[p.atom_of_reg(reg_of(inst->src[0]))] = true;
+            a.constrained_regs[reg_of(inst->src[0])] = true;
 
          /* The location of the Gfx7 MRF hack registers is hard-coded in the
           * rest of the compiler back-end.  Don't attempt to move them around.
@@ -583,26 +636,51 @@ namespace {
 
             for (unsigned i = 0; i < inst->implied_mrf_writes(); i++) {
                const unsigned reg = GFX7_MRF_HACK_START + inst->base_mrf + i;
-               constrained[p.atom_of_reg(reg)] = true;
+               a.constrained_regs[reg] = true;
             }
          }
-      }
 
-      return constrained;
+         if (inst->opcode == BRW_OPCODE_DO) {
+            block_scale *= 10;
+
+         } else if (inst->opcode == BRW_OPCODE_WHILE) {
+            block_scale /= 10;
+
+         } else if (inst->is_3src(v->devinfo) &&
+                    is_grf(inst->src[1]) && is_grf(inst->src[2]) &&
+                    !is_conflict_optimized_out(v->devinfo, inst)) {
+            /* Estimate of the cycle-count cost of incurring a bank conflict
+             * for this instruction.  This is only true on the average, for a
+             * sequence of back-to-back ternary instructions, since the EU
+             * front-end only seems to be able to issue a new instruction at
+             * an even cycle.  The cost of a bank conflict incurred by an
+             * isolated ternary instruction may be higher.
+             */
+            const unsigned exec_size = inst->dst.component_size(inst->exec_size);
+            ternary_conflict &c = a.conflicts[a.num_conflicts++];
+            c.reg_r = reg_of(inst->src[1]);
+            c.reg_s = reg_of(inst->src[2]);
+            c.cycle_scale = block_scale * DIV_ROUND_UP(exec_size, REG_SIZE);
+         }
+      }
    }
 
    /**
-    * Return whether the hardware will be able to prevent a bank conflict by
-    * optimizing out the read cycle of a source register.  The formula was
-    * found experimentally.
+    * Return the set of GRF atoms that should be left untouched at their
+    * original location to avoid violating hardware or software assumptions.
     */
-   bool
-   is_conflict_optimized_out(const gen_device_info *devinfo, const fs_inst *inst)
+   bool *
+   shader_reg_constraints(const shader_reg_accesses &a)
    {
-      return devinfo->ver >= 9 &&
-         ((is_grf(inst->src[0]) && (reg_of(inst->src[0]) == reg_of(inst->src[1]) ||
-                                    reg_of(inst->src[0]) == reg_of(inst->src[2]))) ||
-          reg_of(inst->src[1]) == reg_of(inst->src[2]));
+      const partitioning &p = a.p;
+      bool *constrained = new bool[p.num_atoms()]();
+
+      for (unsigned reg = 0; reg < BRW_MAX_GRF; reg++) {
+         if (a.constrained_regs[reg])
+            constrained[p.atom_of_reg(reg)] = true;
+      }
+
+      return constrained;
    }
 
    /**
@@ -626,66 +704,43 @@ namespace {
     *           helpful than not optimizing at all.
     */
    weight_vector_type *
-   shader_conflict_weight_matrix(const fs_visitor *v, const partitioning &p)
+   shader_conflict_weight_matrix(const shader_reg_accesses &a)
    {
+      const partitioning &p = a.p;
       weight_vector_type *conflicts = new weight_vector_type[p.num_atoms()];
       for (unsigned r = 0; r < p.num_atoms(); r++)
          conflicts[r] = weight_vector_type(2 * p.num_atoms());
 
-      /* Crude approximation of the number of times the current basic block
-       * will be executed at run-time.
-       */
-      unsigned block_scale = 1;
-
-      foreach_block_and_inst(block, fs_inst, inst, v->cfg) {
-         if (inst->opcode == BRW_OPCODE_DO) {
-            block_scale *= 10;
+      for (unsigned i = 0; i < a.num_conflicts; i++) {
+         const ternary_conflict &c = a.conflicts[i];
+         const unsigned r = p.atom_of_reg(c.reg_r);
+         const unsigned s = p.atom_of_reg(c.reg_s);
 
-         } else if (inst->opcode == BRW_OPCODE_WHILE) {
-            block_scale /= 10;
-
-         } else if (inst->is_3src(v->devinfo) &&
-                    is_grf(inst->src[1]) && is_grf(inst->src[2])) {
-            const unsigned r = p.atom_of_reg(reg_of(inst->src[1]));
-            const unsigned s = p.atom_of_reg(reg_of(inst->src[2]));
-
-            /* Estimate of the cycle-count cost of incurring a bank conflict
-             * for this instruction.  This is only true on the average, for a
-             * sequence of back-to-back ternary instructions, since the EU
-             * front-end only seems to be able to issue a new instruction at
-             * an even cycle.  The cost of a bank conflict incurred by an
-             * isolated ternary instruction may be higher.
+         /* Neglect same-atom conflicts (since they're either trivial or
+          * impossible to avoid without splitting the atom).  Conflicts known
+          * to be optimized out by the hardware weren't recorded at all.
+          */
+         if (r != s) {
+            /* Calculate the parity of the sources relative to the start of
+             * their respective atoms.  If their parity is the same (and
+             * none of the atoms straddle the 2KB mark), the instruction
+             * will incur a conflict iff both atoms are assigned the same
+             * bank b.  If their parity is opposite, the instruction will
+             * incur a conflict iff they are assigned opposite banks (b and
+             * b^1).
              */
-            const unsigned exec_size = inst->dst.component_size(inst->exec_size);
-            const unsigned cycle_scale = block_scale * DIV_ROUND_UP(exec_size,
-                                                                    REG_SIZE);
+            const bool p_r = 1 & (c.reg_r - p.reg_of_atom(r));
+            const bool p_s = 1 & (c.reg_s - p.reg_of_atom(s));
+            const unsigned p = p_r ^ p_s;
 
-            /* Neglect same-atom conflicts (since they're either trivial or
-             * impossible to avoid without splitting the atom), and conflicts
-             * known to be optimized out by the hardware.
+            /* Calculate the updated cost of a hypothetical conflict
+             * between atoms r and s.  Note that the weight matrix is
+             * symmetric with respect to indices r and s by construction.
              */
-            if (r != s && !is_conflict_optimized_out(v->devinfo, inst)) {
-               /* Calculate the parity of the sources relative to the start of
-                * their respective atoms.  If their parity is the same (and
-                * none of the atoms straddle the 2KB mark), the instruction
-                * will incur a conflict iff both atoms are assigned the same
-                * bank b.  If their parity is opposite, the instruction will
-                * incur a conflict iff they are assigned opposite banks (b and
-                * b^1).
-                */
-               const bool p_r = 1 & (reg_of(inst->src[1]) - p.reg_of_atom(r));
-               const bool p_s = 1 & (reg_of(inst->src[2]) - p.reg_of_atom(s));
-               const unsigned p = p_r ^ p_s;
-
-               /* Calculate the updated cost of a hypothetical conflict
-                * between atoms r and s.  Note that the weight matrix is
-                * symmetric with respect to indices r and s by construction.
-                */
-               const scalar_type w = MIN2(unsigned(max_scalar),
-                                          get(conflicts[r], s, p) + cycle_scale);
-               set(conflicts[r], s, p, w);
-               set(conflicts[s], r, p, w);
-            }
+            const scalar_type w = MIN2(unsigned(max_scalar),
+                                       get(conflicts[r], s, p) + c.cycle_scale);
+            set(conflicts[r], s, p, w);
+            set(conflicts[s], r, p, w);
          }
       }
 
@@ -914,10 +969,12 @@ fs_visitor::opt_bank_conflicts()
    if (devinfo->ver < 6)
       return false;
 
-   const partitioning p = shader_reg_partitioning(this);
-   const bool *constrained = shader_reg_constraints(this, p);
-   const weight_vector_type *conflicts =
-      shader_conflict_weight_matrix(this, p);
+   shader_reg_accesses a;
+   gather_shader_reg_accesses(this, a);
+
+   const partitioning &p = a.p;
+   const bool *constrained = shader_reg_constraints(a);
+   const weight_vector_type *conflicts = shader_conflict_weight_matrix(a);
    const permutation map =
       optimize_reg_permutation(p, constrained, conflicts,
                                identity_reg_permutation(p));
@@ -154,6 +154,9 @@ struct imm {
 
    uint16_t first_use_ip;
    uint16_t last_use_ip;
+
+   /** The innermost loop containing all uses of this immediate, or -1. */
+   int loop;
 };
 
 /** The working set of information about immediates. */
@@ -163,6 +166,27 @@ struct table {
    int len;
 };
 
+/**
+ * Information about a DO/WHILE loop.
+ */
+struct loop {
+   bblock_t *do_block;
+
+   /** The innermost loop containing this one, or -1. */
+   int parent;
+   unsigned depth;
+
+   unsigned start_ip;
+   unsigned end_ip;
+};
+
+/** The loops of the program, indexed in the order their DO appears. */
+struct loop_table {
+   struct loop *loop;
+   int size;
+   int len;
+};
+
 static struct imm *
 find_imm(struct table *table, void *data, uint8_t size)
 {
@@ -185,6 +209,51 @@ new_imm(struct table *table, void *mem_ctx)
    return &table->imm[table->len++];
 }
 
+static struct loop *
+new_loop(struct loop_table *loops, void *mem_ctx)
+{
+   if (loops->len == loops->size) {
+      loops->size *= 2;
+      loops->loop = reralloc(mem_ctx, loops->loop, struct loop, loops->size);
+   }
+   return &loops->loop[loops->len++];
+}
+
+/**
+ * Returns the innermost loop containing both loops \p a and \p b, or -1.
+ */
+static int
+common_loop(const struct loop_table *loops, int a, int b)
+{
+   while (a != b) {
+      if (a < 0 || b < 0)
+         return -1;
+
+      if (loops->loop[a].depth >= loops->loop[b].depth)
+         a = loops->loop[a].parent;
+      else
+         b = loops->loop[b].parent;
+   }
+
+   return a;
+}
+
+/**
+ * Returns the maximum number of registers live at any instruction between
+ * \p start_ip and \p end_ip (inclusive).
+ */
+static unsigned
+max_pressure(const brw::register_pressure &rp,
+             unsigned start_ip, unsigned end_ip)
+{
+   unsigned pressure = 0;
+
+   for (unsigned ip = start_ip; ip <= end_ip; ip++)
+      pressure = MAX2(pressure, rp.regs_live_at_ip[ip]);
+
+   return pressure;
+}
+
 /**
  * Comparator used for sorting an array of imm structures.
  *
@@ -360,6 +429,12 @@ fs_visitor::opt_combine_constants()
    table.len = 0;
    table.imm = ralloc_array(const_ctx, struct imm, table.size);
 
+   struct loop_table loops;
+   loops.size = 8;
+   loops.len = 0;
+   loops.loop = ralloc_array(const_ctx, struct loop, loops.size);
+   int cur_loop = -1;
+
    const brw::idom_tree &idom = idom_analysis.require();
    unsigned ip = -1;
 
@@ -370,6 +445,22 @@ fs_visitor::opt_combine_constants()
    foreach_block_and_inst(block, fs_inst, inst, cfg) {
       ip++;
 
+      if (inst->opcode == BRW_OPCODE_DO) {
+         struct loop *loop = new_loop(&loops, const_ctx);
+         loop->do_block = block;
+         loop->parent = cur_loop;
+         loop->depth = cur_loop < 0 ? 0 : loops.loop[cur_loop].depth + 1;
+         loop->start_ip = ip;
+         loop->end_ip = ip;
+         cur_loop = loops.len - 1;
+         continue;
+      } else if (inst->opcode == BRW_OPCODE_WHILE) {
+         assert(cur_loop >= 0);
+         loops.loop[cur_loop].end_ip = ip;
+         cur_loop = loops.loop[cur_loop].parent;
+         continue;
+      }
+
       if (!could_coissue(devinfo, inst) && !must_promote_imm(devinfo, inst))
          continue;
 
@@ -403,6 +494,7 @@ fs_visitor::opt_combine_constants()
             imm->uses_by_coissue += could_coissue(devinfo, inst);
             imm->must_promote = imm->must_promote || must_promote_imm(devinfo, inst);
             imm->last_use_ip = ip;
+            imm->loop = common_loop(&loops, imm->loop, cur_loop);
             if (type == BRW_REGISTER_TYPE_HF)
                imm->is_half_float = true;
          } else {
@@ -418,17 +510,28 @@ fs_visitor::opt_combine_constants()
             imm->must_promote = must_promote_imm(devinfo, inst);
             imm->first_use_ip = ip;
             imm->last_use_ip = ip;
+            imm->loop = cur_loop;
          }
       }
    }
 
+   if (table.len == 0) {
+      ralloc_free(const_ctx);
+      return false;
+   }
+
+   const brw::register_pressure &rp = regpressure_analysis.require();
+
    /* Remove constants from the table that don't have enough uses to make them
-    * profitable to store in a register.
+    * profitable to store in a register, or that would need a register where
+    * there is none to spare.
     */
    for (int i = 0; i < table.len;) {
       struct imm *imm = &table.imm[i];
 
-      if (!imm->must_promote && imm->uses_by_coissue < 4) {
+      if (!imm->must_promote &&
+          (imm->uses_by_coissue < 4 ||
+           max_pressure(rp, imm->first_use_ip, imm->last_use_ip) >= max_grf)) {
          table.imm[i] = table.imm[table.len - 1];
          table.len--;
          continue;
@@ -439,12 +542,42 @@ fs_visitor::opt_combine_constants()
       ralloc_free(const_ctx);
       return false;
    }
+
+   /* A constant only used inside of a loop would otherwise be loaded on
+    * every iteration. Load it before as many of the enclosing loops as
+    * register pressure allows instead, keeping its register live across the
+    * whole loop.
+    */
+   for (int i = 0; i < table.len; i++) {
+      struct imm *imm = &table.imm[i];
+      int target = -1;
+
+      for (int l = imm->loop; l >= 0; l = loops.loop[l].parent) {
+         const struct loop *loop = &loops.loop[l];
+
+         if (idom.parent(loop->do_block) == NULL ||
+             max_pressure(rp, loop->start_ip, loop->end_ip) >= max_grf)
+            break;
+
+         target = l;
+      }
+
+      if (target >= 0) {
+         const struct loop *loop = &loops.loop[target];
+         imm->block = idom.parent(loop->do_block);
+         imm->inst = NULL;
+         imm->first_use_ip = loop->start_ip;
+         imm->last_use_ip = loop->end_ip;
+      }
+   }
+
    if (cfg->num_blocks != 1)
       qsort(table.imm, table.len, sizeof(struct imm), compare);
 
    /* Insert MOVs to load the constant values into GRFs. */
    fs_reg reg(VGRF, alloc.allocate(1));
    reg.stride = 0;
+   unsigned reg_last_use_ip = 0;
    for (int i = 0; i < table.len; i++) {
       struct imm *imm = &table.imm[i];
       /* Insert it either before the instruction that generated the immediate
@@ -474,12 +607,18 @@ fs_visitor::opt_combine_constants()
        */
       reg.offset = ALIGN(reg.offset, get_alignment_for_imm(imm));
 
-      /* Ensure we have enough space in the register to copy the immediate */
+      /* Ensure we have enough space in the register to copy the immediate.
+       * Don't pack constants that are never live at the same time into one
+       * register either, that would only keep it live in between them.
+       */
       struct brw_reg imm_reg = build_imm_reg_for_copy(imm);
-      if (reg.offset + type_sz(imm_reg.type) * width > REG_SIZE) {
+      if (reg.offset + type_sz(imm_reg.type) * width > REG_SIZE ||
+          (reg.offset > 0 && imm->first_use_ip > reg_last_use_ip)) {
          reg.nr = alloc.allocate(1);
          reg.offset = 0;
+         reg_last_use_ip = 0;
       }
+      reg_last_use_ip = MAX2(reg_last_use_ip, imm->last_use_ip);
 
       ibld.MOV(retype(reg, imm_reg.type), imm_reg);
       imm->nr = reg.nr;
@@ -32,8 +32,6 @@
  * 12.5 (p356).
  */
 
-#define ACP_HASH_SIZE 64
-
 #include "util/bitset.h"
 #include "util/u_math.h"
 #include "brw_fs.h"
@@ -45,6 +43,12 @@ using namespace brw;
 
 namespace { /* avoid conflict with opt_copy_propagation_elements */
 struct acp_entry : public exec_node {
+   /** Link in the acp::by_dst() list of the destination VGRF. */
+   exec_node dst_link;
+
+   /** Link in the acp list of the source register, if it can be written. */
+   exec_node src_link;
+
    fs_reg dst;
    fs_reg src;
    unsigned global_idx;
@@ -54,6 +58,114 @@ struct acp_entry : public exec_node {
    bool saturate;
 };
 
+/**
+ * Set of available copies, indexed by destination VGRF for propagation and
+ * by source register for kills, so that neither has to walk entries that
+ * can't possibly match.  The entries themselves are also kept in a single
+ * list in the order they were added.
+ */
+struct acp {
+   acp(unsigned num_vgrfs)
+      : num_vgrfs(num_vgrfs),
+        dst_lists(new exec_list[num_vgrfs]),
+        src_lists(new exec_list[num_vgrfs])
+   {
+   }
+
+   ~acp()
+   {
+      delete[] dst_lists;
+      delete[] src_lists;
+   }
+
+   exec_list *
+   by_dst(unsigned nr)
+   {
+      assert(nr < num_vgrfs);
+      return &dst_lists[nr];
+   }
+
+   /**
+    * The list of entries that may read \p reg, or NULL for files that
+    * instructions never write.
+    */
+   exec_list *
+   by_src(const fs_reg &reg)
+   {
+      switch (reg.file) {
+      case VGRF:
+         assert(reg.nr < num_vgrfs);
+         return &src_lists[reg.nr];
+      case FIXED_GRF:
+         return &fixed_src;
+      default:
+         return NULL;
+      }
+   }
+
+   void
+   add(acp_entry *entry)
+   {
+      entries.push_tail(entry);
+      by_dst(entry->dst.nr)->push_tail(&entry->dst_link);
+
+      exec_list *srcs = by_src(entry->src);
+      if (srcs)
+         srcs->push_tail(&entry->src_link);
+   }
+
+   void
+   remove(acp_entry *entry)
+   {
+      entry->remove();
+      entry->dst_link.remove();
+      if (by_src(entry->src))
+         entry->src_link.remove();
+   }
+
+   /**
+    * Remove all the entries whose source or destination is overwritten by
+    * \p inst.
+    */
+   void
+   kill(const fs_inst *inst)
+   {
+      if (inst->dst.file == VGRF) {
+         foreach_list_typed_safe(acp_entry, entry, dst_link,
+                                 by_dst(inst->dst.nr)) {
+            if (regions_overlap(entry->dst, entry->size_written,
+                                inst->dst, inst->size_written))
+               remove(entry);
+         }
+      }
+
+      exec_list *srcs = by_src(inst->dst);
+      if (srcs) {
+         foreach_list_typed_safe(acp_entry, entry, src_link, srcs) {
+            if (regions_overlap(entry->src, entry->size_read,
+                                inst->dst, inst->size_written))
+               remove(entry);
+         }
+      }
+   }
+
+   void
+   clear()
+   {
+      foreach_in_list_safe(acp_entry, entry, &entries)
+         remove(entry);
+   }
+
+   /** All the entries, in the order they were added. */
+   exec_list entries;
+
+private:
+   unsigned num_vgrfs;
+   exec_list *dst_lists;
+   exec_list *src_lists;
+   exec_list fixed_src;
+};
+
 struct block_data {
    /**
     * Which entries in the fs_copy_prop_dataflow acp table are live at the
@@ -95,7 +207,7 @@ class fs_copy_prop_dataflow
 public:
    fs_copy_prop_dataflow(void *mem_ctx, cfg_t *cfg,
                          const fs_live_variables &live,
-                         exec_list *out_acp[ACP_HASH_SIZE]);
+                         unsigned num_vgrfs, exec_list *out_acp);
 
    void setup_initial_values();
    void run();
@@ -105,6 +217,7 @@ public:
    void *mem_ctx;
    cfg_t *cfg;
    const fs_live_variables &live;
+   unsigned num_vgrfs;
 
    acp_entry **acp;
    int num_acp;
@@ -116,17 +229,15 @@ public:
 
 fs_copy_prop_dataflow::fs_copy_prop_dataflow(void *mem_ctx, cfg_t *cfg,
                                              const fs_live_variables &live,
-                                             exec_list *out_acp[ACP_HASH_SIZE])
-   : mem_ctx(mem_ctx), cfg(cfg), live(live)
+                                             unsigned num_vgrfs,
+                                             exec_list *out_acp)
+   : mem_ctx(mem_ctx), cfg(cfg), live(live), num_vgrfs(num_vgrfs)
 {
    bd = rzalloc_array(mem_ctx, struct block_data, cfg->num_blocks);
 
    num_acp = 0;
-   foreach_block (block, cfg) {
-      for (int i = 0; i < ACP_HASH_SIZE; i++) {
-         num_acp += out_acp[block->num][i].length();
-      }
-   }
+   foreach_block (block, cfg)
+      num_acp += out_acp[block->num].length();
 
    acp = rzalloc_array(mem_ctx, struct acp_entry *, num_acp);
 
@@ -140,20 +251,19 @@ fs_copy_prop_dataflow::fs_copy_prop_dataflow(void *mem_ctx, cfg_t *cfg,
       bd[block->num].kill = rzalloc_array(bd, BITSET_WORD, bitset_words);
       bd[block->num].undef = rzalloc_array(bd, BITSET_WORD, bitset_words);
 
-      for (int i = 0; i < ACP_HASH_SIZE; i++) {
-         foreach_in_list(acp_entry, entry, &out_acp[block->num][i]) {
-            acp[next_acp] = entry;
+      foreach_in_list_safe(acp_entry, entry, &out_acp[block->num]) {
+         entry->remove();
+         acp[next_acp] = entry;
 
-            entry->global_idx = next_acp;
+         entry->global_idx = next_acp;
 
-            /* opt_copy_propagation_local populates out_acp with copies created
-             * in a block which are still live at the end of the block.  This
-             * is exactly what we want in the COPY set.
-             */
-            BITSET_SET(bd[block->num].copy, next_acp);
+         /* opt_copy_propagation_local populates out_acp with copies created
+          * in a block which are still live at the end of the block.  This
+          * is exactly what we want in the COPY set.
+          */
+         BITSET_SET(bd[block->num].copy, next_acp);
 
-            next_acp++;
-         }
+         next_acp++;
       }
    }
 
@@ -170,76 +280,38 @@ fs_copy_prop_dataflow::fs_copy_prop_dataflow(void *mem_ctx, cfg_t *cfg,
 void
 fs_copy_prop_dataflow::setup_initial_values()
 {
-   /* Initialize the COPY and KILL sets. */
+   /* Initialize the KILL sets, looking up the entries affected by each
+    * write in a table of all the ACP entries.
+    */
    {
-      /* Create a temporary table of ACP entries which we'll use for efficient
-       * look-up.  Unfortunately, we have to do this in two steps because we
-       * have to match both sources and destinations and an ACP entry can only
-       * be in one list at a time.
-       *
-       * We choose to make the table size between num_acp/2 and num_acp/4 to
-       * try and trade off between the time it takes to initialize the table
-       * via exec_list constructors or make_empty() and the cost of
-       * collisions.  In practice, it doesn't appear to matter too much what
-       * size we make the table as long as it's roughly the same order of
-       * magnitude as num_acp.  We get most of the benefit of the table
-       * approach even if we use a table of size ACP_HASH_SIZE though a
-       * full-sized table is 1-2% faster in practice.
-       */
-      unsigned acp_table_size = util_next_power_of_two(num_acp) / 4;
-      acp_table_size = MAX2(acp_table_size, ACP_HASH_SIZE);
-      exec_list *acp_table = new exec_list[acp_table_size];
+      struct acp table(num_vgrfs);
 
-      /* First, get all the KILLs for instructions which overwrite ACP
-       * destinations.
-       */
-      for (int i = 0; i < num_acp; i++) {
-         unsigned idx = reg_space(acp[i]->dst) & (acp_table_size - 1);
-         acp_table[idx].push_tail(acp[i]);
-      }
+      for (int i = 0; i < num_acp; i++)
+         table.add(acp[i]);
 
       foreach_block (block, cfg) {
          foreach_inst_in_block(fs_inst, inst, block) {
-            if (inst->dst.file != VGRF)
-               continue;
-
-            unsigned idx = reg_space(inst->dst) & (acp_table_size - 1);
-            foreach_in_list(acp_entry, entry, &acp_table[idx]) {
-               if (regions_overlap(inst->dst, inst->size_written,
-                                   entry->dst, entry->size_written))
-                  BITSET_SET(bd[block->num].kill, entry->global_idx);
+            if (inst->dst.file == VGRF) {
+               foreach_list_typed(acp_entry, entry, dst_link,
+                                  table.by_dst(inst->dst.nr)) {
+                  if (regions_overlap(inst->dst, inst->size_written,
+                                      entry->dst, entry->size_written))
+                     BITSET_SET(bd[block->num].kill, entry->global_idx);
+               }
             }
-         }
-      }
-
-      /* Clear the table for the second pass */
-      for (unsigned i = 0; i < acp_table_size; i++)
-         acp_table[i].make_empty();
-
-      /* Next, get all the KILLs for instructions which overwrite ACP
-       * sources.
-       */
-      for (int i = 0; i < num_acp; i++) {
-         unsigned idx = reg_space(acp[i]->src) & (acp_table_size - 1);
-         acp_table[idx].push_tail(acp[i]);
-      }
 
-      foreach_block (block, cfg) {
-         foreach_inst_in_block(fs_inst, inst, block) {
-            if (inst->dst.file != VGRF &&
-                inst->dst.file != FIXED_GRF)
-               continue;
-
-            unsigned idx = reg_space(inst->dst) & (acp_table_size - 1);
-            foreach_in_list(acp_entry, entry, &acp_table[idx]) {
-               if (regions_overlap(inst->dst, inst->size_written,
-                                   entry->src, entry->size_read))
-                  BITSET_SET(bd[block->num].kill, entry->global_idx);
+            exec_list *srcs = table.by_src(inst->dst);
+            if (srcs) {
+               foreach_list_typed(acp_entry, entry, src_link, srcs) {
+                  if (regions_overlap(inst->dst, inst->size_written,
+                                      entry->src, entry->size_read))
+                     BITSET_SET(bd[block->num].kill, entry->global_idx);
+               }
             }
          }
       }
 
-      delete [] acp_table;
+      table.clear();
    }
 
    /* Populate the initial values for the livein and liveout sets.  For the
@@ -959,7 +1031,7 @@ can_propagate_from(fs_inst *inst)
  */
 bool
 fs_visitor::opt_copy_propagation_local(void *copy_prop_ctx, bblock_t *block,
-                                       exec_list *acp)
+                                       struct acp &acp)
 {
    bool progress = false;
 
@@ -969,7 +1041,8 @@ fs_visitor::opt_copy_propagation_local(void *copy_prop_ctx, bblock_t *block,
          if (inst->src[i].file != VGRF)
             continue;
 
-         foreach_in_list(acp_entry, entry, &acp[inst->src[i].nr % ACP_HASH_SIZE]) {
+         foreach_list_typed(acp_entry, entry, dst_link,
+                            acp.by_dst(inst->src[i].nr)) {
             if (try_constant_propagate(inst, entry))
                progress = true;
             else if (try_copy_propagate(inst, i, entry))
@@ -978,27 +1051,7 @@ fs_visitor::opt_copy_propagation_local(void *copy_prop_ctx, bblock_t *block,
       }
 
       /* kill the destination from the ACP */
-      if (inst->dst.file == VGRF || inst->dst.file == FIXED_GRF) {
-         foreach_in_list_safe(acp_entry, entry, &acp[inst->dst.nr % ACP_HASH_SIZE]) {
-            if (regions_overlap(entry->dst, entry->size_written,
-                                inst->dst, inst->size_written))
-               entry->remove();
-         }
-
-         /* Oops, we only have the chaining hash based on the destination, not
-          * the source, so walk across the entire table.
-          */
-         for (int i = 0; i < ACP_HASH_SIZE; i++) {
-            foreach_in_list_safe(acp_entry, entry, &acp[i]) {
-               /* Make sure we kill the entry if this instruction overwrites
-                * _any_ of the registers that it reads
-                */
-               if (regions_overlap(entry->src, entry->size_read,
-                                   inst->dst, inst->size_written))
-                  entry->remove();
-            }
-	 }
-      }
+      acp.kill(inst);
 
       /* If this instruction's source could potentially be folded into the
        * operand of another instruction, add it to the ACP.
@@ -1012,7 +1065,7 @@ fs_visitor::opt_copy_propagation_local(void *copy_prop_ctx, bblock_t *block,
             entry->size_read += inst->size_read(i);
          entry->opcode = inst->opcode;
          entry->saturate = inst->saturate;
-         acp[entry->dst.nr % ACP_HASH_SIZE].push_tail(entry);
+         acp.add(entry);
       } else if (inst->opcode == SHADER_OPCODE_LOAD_PAYLOAD &&
                  inst->dst.file == VGRF) {
          int offset = 0;
@@ -1031,7 +1084,7 @@ fs_visitor::opt_copy_propagation_local(void *copy_prop_ctx, bblock_t *block,
                entry->size_read = inst->size_read(i);
                entry->opcode = inst->opcode;
                if (!entry->dst.equals(inst->src[i])) {
-                  acp[entry->dst.nr % ACP_HASH_SIZE].push_tail(entry);
+                  acp.add(entry);
                } else {
                   ralloc_free(entry);
                }
@@ -1049,10 +1102,8 @@ fs_visitor::opt_copy_propagation()
 {
    bool progress = false;
    void *copy_prop_ctx = ralloc_context(NULL);
-   exec_list *out_acp[cfg->num_blocks];
-
-   for (int i = 0; i < cfg->num_blocks; i++)
-      out_acp[i] = new exec_list [ACP_HASH_SIZE];
+   exec_list *out_acp = new exec_list[cfg->num_blocks];
+   struct acp acp(alloc.count);
 
    const fs_live_variables &live = live_analysis.require();
 
@@ -1060,12 +1111,12 @@ fs_visitor::opt_copy_propagation()
     * the set of copies available at the end of the block.
     */
    foreach_block (block, cfg) {
-      progress = opt_copy_propagation_local(copy_prop_ctx, block,
-                                            out_acp[block->num]) || progress;
+      progress = opt_copy_propagation_local(copy_prop_ctx, block, acp) ||
+                 progress;
 
       /* If the destination of an ACP entry exists only within this block,
-       * then there's no need to keep it for dataflow analysis.  We can delete
-       * it from the out_acp table and avoid growing the bitsets any bigger
+       * then there's no need to keep it for dataflow analysis.  We can leave
+       * it out of the out_acp list and avoid growing the bitsets any bigger
        * than we absolutely have to.
        *
        * Because nothing in opt_copy_propagation_local touches the block
@@ -1073,38 +1124,35 @@ fs_visitor::opt_copy_propagation()
        * extending the live range of an ACP destination beyond the block,
        * it's safe to use the liveness information in this way.
        */
-      for (unsigned a = 0; a < ACP_HASH_SIZE; a++) {
-         foreach_in_list_safe(acp_entry, entry, &out_acp[block->num][a]) {
-            assert(entry->dst.file == VGRF);
-            if (block->start_ip <= live.vgrf_start[entry->dst.nr] &&
-                live.vgrf_end[entry->dst.nr] <= block->end_ip)
-               entry->remove();
-         }
+      foreach_in_list_safe(acp_entry, entry, &acp.entries) {
+         assert(entry->dst.file == VGRF);
+         acp.remove(entry);
+         if (block->start_ip > live.vgrf_start[entry->dst.nr] ||
+             live.vgrf_end[entry->dst.nr] > block->end_ip)
+            out_acp[block->num].push_tail(entry);
       }
    }
 
    /* Do dataflow analysis for those available copies. */
-   fs_copy_prop_dataflow dataflow(copy_prop_ctx, cfg, live, out_acp);
+   fs_copy_prop_dataflow dataflow(copy_prop_ctx, cfg, live, alloc.count,
+                                  out_acp);
 
    /* Next, re-run local copy propagation, this time with the set of copies
     * provided by the dataflow analysis available at the start of a block.
     */
    foreach_block (block, cfg) {
-      exec_list in_acp[ACP_HASH_SIZE];
+      unsigned i;
+      BITSET_FOREACH_SET(i, dataflow.bd[block->num].livein,
+                         unsigned(dataflow.num_acp))
+         acp.add(dataflow.acp[i]);
 
-      for (int i = 0; i < dataflow.num_acp; i++) {
-         if (BITSET_TEST(dataflow.bd[block->num].livein, i)) {
-            struct acp_entry *entry = dataflow.acp[i];
-            in_acp[entry->dst.nr % ACP_HASH_SIZE].push_tail(entry);
-         }
-      }
-
-      progress = opt_copy_propagation_local(copy_prop_ctx, block, in_acp) ||
+      progress = opt_copy_propagation_local(copy_prop_ctx, block, acp) ||
                  progress;
+
+      acp.clear();
    }
 
-   for (int i = 0; i < cfg->num_blocks; i++)
-      delete [] out_acp[i];
+   delete [] out_acp;
    ralloc_free(copy_prop_ctx);
 
    if (progress)
@@ -26,7 +26,11 @@
 
 /** @file brw_fs_cse.cpp
  *
- * Support for local common subexpression elimination.
+ * Support for common subexpression elimination.
+ *
+ * Expressions are eliminated within each basic block, plus across blocks
+ * for plain ALU expressions whose sources can't change once defined, which
+ * are reused from any dominating block.
  *
  * See Muchnick's Advanced Compiler Design and Implementation, section
  * 13.1 (p378).
@@ -34,6 +38,9 @@
 
 using namespace brw;
 
+#define AEB_HASH_SIZE 256
+#define AEB_USE_HASH_SIZE 64
+
 namespace {
 struct aeb_entry : public exec_node {
    /** The instruction that generates the expression value. */
@@ -41,6 +48,26 @@ struct aeb_entry : public exec_node {
 
    /** The temporary where the value is stored. */
    fs_reg tmp;
+
+   /** The block containing the generator. */
+   bblock_t *block;
+
+   /** hash_inst() of the generator. */
+   unsigned hash;
+
+   /** Whether the value has been overwritten since the generator. */
+   bool killed;
+
+   /** Whether the value stays available in blocks dominated by ours. */
+   bool global;
+};
+
+/**
+ * Link from one of the registers read by an AEB entry back to the entry,
+ * so that writes only have to look at the entries they may affect.
+ */
+struct aeb_use : public exec_node {
+   aeb_entry *entry;
 };
 }
 
@@ -169,6 +196,42 @@ operands_match(const fs_inst *a, const fs_inst *b, bool *negate)
    }
 }
 
+/**
+ * Hashes the parts of a source compared by operands_match().  Negate and
+ * abs are left out, as is the value of immediates, since operands_match()
+ * may look through them for MUL.
+ */
+static unsigned
+hash_reg(const fs_reg &r)
+{
+   unsigned hash = r.file | r.type << 4;
+
+   if (r.file != IMM)
+      hash = (hash * 31 + r.nr) * 31 + r.offset;
+
+   return hash * 0x9e3779b1;
+}
+
+/**
+ * Hashes an instruction so that instructions_match() implies equal hashes.
+ * Sources are summed, which keeps the hash independent of their order for
+ * commutative operations.
+ */
+static unsigned
+hash_inst(const fs_inst *inst)
+{
+   unsigned src_hash = 0;
+   for (int i = 0; i < inst->sources; i++)
+      src_hash += hash_reg(inst->src[i]);
+
+   unsigned hash = inst->opcode;
+   hash = hash * 31 + inst->exec_size;
+   hash = hash * 31 + inst->dst.type;
+   hash = hash * 31 + inst->sources;
+
+   return hash ^ src_hash;
+}
+
 static bool
 instructions_match(fs_inst *a, fs_inst *b, bool *negate)
 {
@@ -242,55 +305,351 @@ create_copy_instr(const fs_builder &bld, fs_inst *inst, fs_reg src, bool negate)
    assert(regs_written(copy) == written);
 }
 
+/**
+ * Whether \p inst can safely be reused from a block it dominates.  This is
+ * limited to ALU instructions whose result only depends on the value of
+ * their sources in the enabled channels, so anything that reads or writes
+ * the flag, depends on the execution mask or has a side effect stays local.
+ */
+static bool
+is_global_expression(const gen_device_info *devinfo, const fs_inst *inst)
+{
+   switch (inst->opcode) {
+   case BRW_OPCODE_SEL:
+   case BRW_OPCODE_NOT:
+   case BRW_OPCODE_AND:
+   case BRW_OPCODE_OR:
+   case BRW_OPCODE_XOR:
+   case BRW_OPCODE_SHR:
+   case BRW_OPCODE_SHL:
+   case BRW_OPCODE_ASR:
+   case BRW_OPCODE_ADD:
+   case BRW_OPCODE_MUL:
+   case SHADER_OPCODE_MULH:
+   case BRW_OPCODE_FRC:
+   case BRW_OPCODE_RNDU:
+   case BRW_OPCODE_RNDD:
+   case BRW_OPCODE_RNDE:
+   case BRW_OPCODE_RNDZ:
+   case BRW_OPCODE_MAD:
+   case BRW_OPCODE_LRP:
+   case SHADER_OPCODE_RCP:
+   case SHADER_OPCODE_RSQ:
+   case SHADER_OPCODE_SQRT:
+   case SHADER_OPCODE_EXP2:
+   case SHADER_OPCODE_LOG2:
+   case SHADER_OPCODE_POW:
+   case SHADER_OPCODE_INT_QUOTIENT:
+   case SHADER_OPCODE_INT_REMAINDER:
+   case SHADER_OPCODE_SIN:
+   case SHADER_OPCODE_COS:
+      return inst->dst.file == VGRF && !inst->force_writemask_all &&
+             !inst->flags_read(devinfo) && !inst->flags_written();
+   default:
+      return false;
+   }
+}
+
+/**
+ * Returns true if \p a dominates \p b.  Blocks are numbered in program
+ * order, so a dominator always has a lower number than the blocks it
+ * dominates.
+ */
+static bool
+dominates(const idom_tree &idom, const bblock_t *a, const bblock_t *b)
+{
+   while (b && b->num > a->num)
+      b = idom.parent(b);
+
+   return a == b;
+}
+
+namespace {
+class cse_state {
+public:
+   cse_state(fs_visitor *v);
+   ~cse_state();
+
+   bool opt_cse_local(bblock_t *block);
+
+private:
+   aeb_entry *find(bblock_t *block, fs_inst *inst, unsigned hash,
+                   bool *negate);
+   void add(bblock_t *block, fs_inst *inst, unsigned hash);
+   void add_use(exec_list *uses, aeb_entry *entry);
+   void kill(fs_inst *inst);
+   void kill_all();
+   void end_block();
+   bool source_is_fixed(const bblock_t *block, const fs_reg &src) const;
+
+   fs_visitor *v;
+   void *mem_ctx;
+
+   /** Available expressions of this block and global ones of earlier
+    * blocks, chained by hash_inst().
+    */
+   exec_list aeb[AEB_HASH_SIZE];
+
+   /** Entries of this block by VGRF read, chained by register number. */
+   exec_list vgrf_uses[AEB_USE_HASH_SIZE];
+
+   /** Entries of this block reading any other kind of register. */
+   exec_list other_uses;
+
+   /** Entries of this block reading or writing the flag. */
+   exec_list flag_uses;
+
+   /** Entries created for this block. */
+   exec_list block_entries;
+
+   /**
+    * Def information about the VGRFs allocated before the pass, only used
+    * for global entries.
+    */
+   bool allow_global;
+   const idom_tree *idom;
+   unsigned num_vgrfs;
+   unsigned *vgrf_defs;
+   bblock_t **vgrf_def_block;
+   bool *vgrf_fully_defined;
+   bool *vgrf_def_seen;
+};
+}
+
+cse_state::cse_state(fs_visitor *v)
+   : v(v), mem_ctx(ralloc_context(NULL)), allow_global(true), idom(NULL),
+     num_vgrfs(v->alloc.count)
+{
+   vgrf_defs = rzalloc_array(mem_ctx, unsigned, num_vgrfs);
+   vgrf_def_block = rzalloc_array(mem_ctx, bblock_t *, num_vgrfs);
+   vgrf_fully_defined = rzalloc_array(mem_ctx, bool, num_vgrfs);
+   vgrf_def_seen = rzalloc_array(mem_ctx, bool, num_vgrfs);
+
+   foreach_block_and_inst(block, fs_inst, inst, v->cfg) {
+      /* Discard jumps aren't represented in the CFG, so the dominance tree
+       * doesn't tell whether an expression computed before one is still
+       * valid in every channel after it.
+       */
+      if (inst->opcode == BRW_OPCODE_HALT ||
+          inst->opcode == SHADER_OPCODE_HALT_TARGET)
+         allow_global = false;
+
+      if (inst->dst.file == VGRF) {
+         const unsigned nr = inst->dst.nr;
+         vgrf_defs[nr]++;
+         vgrf_def_block[nr] = block;
+         vgrf_fully_defined[nr] =
+            !inst->predicate && !inst->is_partial_write() &&
+            inst->dst.offset == 0 &&
+            inst->size_written == v->alloc.sizes[nr] * REG_SIZE;
+      }
+   }
+
+   if (allow_global)
+      idom = &v->idom_analysis.require();
+}
+
+cse_state::~cse_state()
+{
+   ralloc_free(mem_ctx);
+}
+
+/**
+ * Whether \p src holds the same value everywhere \p block and the blocks it
+ * dominates could read it: immediates, uniforms, and VGRFs with a single
+ * full definition that has already been seen and dominates \p block.
+ */
 bool
-fs_visitor::opt_cse_local(const fs_live_variables &live, bblock_t *block, int &ip)
+cse_state::source_is_fixed(const bblock_t *block, const fs_reg &src) const
 {
-   bool progress = false;
-   exec_list aeb;
+   switch (src.file) {
+   case BAD_FILE:
+   case IMM:
+   case UNIFORM:
+      return true;
+   case VGRF:
+      return src.nr < num_vgrfs &&
+             vgrf_defs[src.nr] == 1 &&
+             vgrf_fully_defined[src.nr] &&
+             vgrf_def_seen[src.nr] &&
+             dominates(*idom, vgrf_def_block[src.nr], block);
+   default:
+      return false;
+   }
+}
+
+aeb_entry *
+cse_state::find(bblock_t *block, fs_inst *inst, unsigned hash, bool *negate)
+{
+   foreach_in_list(aeb_entry, entry, &aeb[hash % AEB_HASH_SIZE]) {
+      if (entry->killed || entry->hash != hash)
+         continue;
+
+      /* Entries of earlier blocks are all global, but only usable from the
+       * blocks they dominate.
+       */
+      if (entry->block != block && !dominates(*idom, entry->block, block))
+         continue;
+
+      if (!(entry->generator->dst.is_null() && !inst->dst.is_null()) &&
+          instructions_match(inst, entry->generator, negate))
+         return entry;
+   }
+
+   return NULL;
+}
+
+void
+cse_state::add_use(exec_list *uses, aeb_entry *entry)
+{
+   aeb_use *use = ralloc(mem_ctx, aeb_use);
+   use->entry = entry;
+   uses->push_tail(use);
+}
+
+void
+cse_state::add(bblock_t *block, fs_inst *inst, unsigned hash)
+{
+   aeb_entry *entry = ralloc(mem_ctx, aeb_entry);
+   entry->tmp = reg_undef;
+   entry->generator = inst;
+   entry->block = block;
+   entry->hash = hash;
+   entry->killed = false;
+   entry->global = allow_global && is_global_expression(v->devinfo, inst);
+
+   for (int i = 0; i < inst->sources; i++)
+      entry->global = entry->global && source_is_fixed(block, inst->src[i]);
+
+   aeb[hash % AEB_HASH_SIZE].push_tail(entry);
+   add_use(&block_entries, entry);
+
+   if (inst->flags_read(v->devinfo) || inst->flags_written())
+      add_use(&flag_uses, entry);
+
+   bool other = false;
+   for (int i = 0; i < inst->sources; i++) {
+      switch (inst->src[i].file) {
+      case VGRF:
+         add_use(&vgrf_uses[inst->src[i].nr % AEB_USE_HASH_SIZE], entry);
+         break;
+      case BAD_FILE:
+      case IMM:
+      case UNIFORM:
+         break;
+      default:
+         other = true;
+         break;
+      }
+   }
+
+   if (other)
+      add_use(&other_uses, entry);
+}
+
+void
+cse_state::kill(fs_inst *inst)
+{
+   /* Kill all AEB entries that write a different value to or read from the
+    * flag register if we just wrote it.
+    */
+   if (inst->flags_written()) {
+      foreach_in_list(aeb_use, use, &flag_uses) {
+         const fs_inst *generator = use->entry->generator;
+         bool negate; /* dummy */
+         if (generator->flags_read(v->devinfo) ||
+             (generator->flags_written() &&
+              !instructions_match(inst, use->entry->generator, &negate)))
+            use->entry->killed = true;
+      }
+   }
+
+   /* Kill all AEB entries that use the destination we just overwrote. */
+   exec_list *uses;
+   if (inst->dst.file == VGRF)
+      uses = &vgrf_uses[inst->dst.nr % AEB_USE_HASH_SIZE];
+   else if (inst->dst.file != BAD_FILE)
+      uses = &other_uses;
+   else
+      return;
+
+   foreach_in_list(aeb_use, use, uses) {
+      const fs_inst *generator = use->entry->generator;
+      for (int i = 0; i < generator->sources; i++) {
+         if (regions_overlap(inst->dst, inst->size_written,
+                             generator->src[i], generator->size_read(i))) {
+            use->entry->killed = true;
+            break;
+         }
+      }
+   }
+}
+
+void
+cse_state::kill_all()
+{
+   foreach_in_list(aeb_use, use, &block_entries)
+      use->entry->killed = true;
+}
+
+/**
+ * Drops everything but the global entries of the block we're leaving, which
+ * nothing can kill anymore since their sources are never redefined.
+ */
+void
+cse_state::end_block()
+{
+   foreach_in_list(aeb_use, use, &block_entries) {
+      if (use->entry->killed || !use->entry->global)
+         use->entry->remove();
+   }
+
+   for (unsigned i = 0; i < AEB_USE_HASH_SIZE; i++)
+      vgrf_uses[i].make_empty();
+   other_uses.make_empty();
+   flag_uses.make_empty();
+   block_entries.make_empty();
+}
 
-   void *cse_ctx = ralloc_context(NULL);
+bool
+cse_state::opt_cse_local(bblock_t *block)
+{
+   bool progress = false;
 
    foreach_inst_in_block(fs_inst, inst, block) {
       /* Skip some cases. */
-      if (is_expression(this, inst) && !inst->is_partial_write() &&
+      if (is_expression(v, inst) && !inst->is_partial_write() &&
           ((inst->dst.file != ARF && inst->dst.file != FIXED_GRF) ||
            inst->dst.is_null()))
       {
-         bool found = false;
          bool negate = false;
+         const unsigned hash = hash_inst(inst);
 
-         foreach_in_list_use_after(aeb_entry, entry, &aeb) {
-            /* Match current instruction's expression against those in AEB. */
-            if (!(entry->generator->dst.is_null() && !inst->dst.is_null()) &&
-                instructions_match(inst, entry->generator, &negate)) {
-               found = true;
-               progress = true;
-               break;
-            }
-         }
+         /* Match current instruction's expression against those in AEB. */
+         aeb_entry *entry = find(block, inst, hash, &negate);
 
-         if (!found) {
+         if (!entry) {
             if (inst->opcode != BRW_OPCODE_MOV ||
                 (inst->opcode == BRW_OPCODE_MOV &&
                  inst->src[0].file == IMM &&
                  inst->src[0].type == BRW_REGISTER_TYPE_VF)) {
                /* Our first sighting of this expression.  Create an entry. */
-               aeb_entry *entry = ralloc(cse_ctx, aeb_entry);
-               entry->tmp = reg_undef;
-               entry->generator = inst;
-               aeb.push_tail(entry);
+               add(block, inst, hash);
             }
          } else {
+            progress = true;
+
             /* This is at least our second sighting of this expression.
              * If we don't have a temporary already, make one.
              */
             bool no_existing_temp = entry->tmp.file == BAD_FILE;
             if (no_existing_temp && !entry->generator->dst.is_null()) {
-               const fs_builder ibld = fs_builder(this, block, entry->generator)
-                                       .at(block, entry->generator->next);
+               const fs_builder ibld =
+                  fs_builder(v, entry->block, entry->generator)
+                  .at(entry->block, entry->generator->next);
                int written = regs_written(entry->generator);
 
-               entry->tmp = fs_reg(VGRF, alloc.allocate(written),
+               entry->tmp = fs_reg(VGRF, v->alloc.allocate(written),
                                    entry->generator->dst.type);
 
                create_copy_instr(ibld, entry->generator, entry->tmp, false);
@@ -302,7 +661,7 @@ fs_visitor::opt_cse_local(const fs_live_variables &live, bblock_t *block, int &i
             if (!inst->dst.is_null()) {
                assert(inst->size_written == entry->generator->size_written);
                assert(inst->dst.type == entry->tmp.type);
-               const fs_builder ibld(this, block, inst);
+               const fs_builder ibld(v, block, inst);
 
                create_copy_instr(ibld, inst, entry->tmp, negate);
             }
@@ -326,52 +685,15 @@ fs_visitor::opt_cse_local(const fs_live_variables &live, bblock_t *block, int &i
        */
       if (inst->opcode == BRW_OPCODE_HALT ||
           inst->opcode == SHADER_OPCODE_HALT_TARGET)
-         aeb.make_empty();
-
-      foreach_in_list_safe(aeb_entry, entry, &aeb) {
-         /* Kill all AEB entries that write a different value to or read from
-          * the flag register if we just wrote it.
-          */
-         if (inst->flags_written()) {
-            bool negate; /* dummy */
-            if (entry->generator->flags_read(devinfo) ||
-                (entry->generator->flags_written() &&
-                 !instructions_match(inst, entry->generator, &negate))) {
-               entry->remove();
-               ralloc_free(entry);
-               continue;
-            }
-         }
+         kill_all();
 
-         for (int i = 0; i < entry->generator->sources; i++) {
-            fs_reg *src_reg = &entry->generator->src[i];
-
-            /* Kill all AEB entries that use the destination we just
-             * overwrote.
-             */
-            if (regions_overlap(inst->dst, inst->size_written,
-                                entry->generator->src[i],
-                                entry->generator->size_read(i))) {
-               entry->remove();
-               ralloc_free(entry);
-               break;
-            }
-
-            /* Kill any AEB entries using registers that don't get reused any
-             * more -- a sure sign they'll fail operands_match().
-             */
-            if (src_reg->file == VGRF && live.vgrf_end[src_reg->nr] < ip) {
-               entry->remove();
-               ralloc_free(entry);
-               break;
-            }
-         }
-      }
+      kill(inst);
 
-      ip++;
+      if (inst->dst.file == VGRF && inst->dst.nr < num_vgrfs)
+         vgrf_def_seen[inst->dst.nr] = true;
    }
 
-   ralloc_free(cse_ctx);
+   end_block();
 
    return progress;
 }
@@ -379,12 +701,11 @@ fs_visitor::opt_cse_local(const fs_live_variables &live, bblock_t *block, int &i
 bool
 fs_visitor::opt_cse()
 {
-   const fs_live_variables &live = live_analysis.require();
+   cse_state state(this);
    bool progress = false;
-   int ip = 0;
 
    foreach_block (block, cfg) {
-      progress = opt_cse_local(live, block, ip) || progress;
+      progress = state.opt_cse_local(block) || progress;
    }
 
    if (progress)
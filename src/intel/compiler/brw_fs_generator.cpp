@@ -32,6 +32,8 @@
 #include "brw_cfg.h"
 #include "util/mesa-sha1.h"
 
+#include <inttypes.h>
+
 static enum brw_reg_file
 brw_file_from_reg(fs_reg *reg)
 {
@@ -2719,7 +2721,7 @@ fs_generator::generate_code(const cfg_t *cfg, int dispatch_width,
       fprintf(stderr, "Native code for %s (sha1 %s)\n"
               "SIMD%d shader: %d instructions. %d loops. %u cycles. "
               "%d:%d spills:fills, %u sends, "
-              "scheduled with mode %s. "
+              "scheduled with mode %s in %" PRIu64 " us. "
               "Promoted %u constants. "
               "Compacted %d to %d bytes (%.0f%%)\n",
               shader_name, sha1buf,
@@ -2727,6 +2729,7 @@ fs_generator::generate_code(const cfg_t *cfg, int dispatch_width,
               loop_count, perf.latency,
               spill_count, fill_count, send_count,
               shader_stats.scheduler_mode,
+              shader_stats.schedule_time / 1000,
               shader_stats.promoted_constants,
               before_size, after_size,
               100.0f * (before_size - after_size) / before_size);
@@ -66,8 +66,10 @@ fs_live_variables::setup_one_read(struct block_data *bd,
     * channel) without having completely defined that variable within the
     * block.
     */
-   if (!BITSET_TEST(bd->def, var))
+   if (!BITSET_TEST(bd->def, var)) {
       BITSET_SET(bd->use, var);
+      bd->use_words.add(BITSET_BITWORD(var));
+   }
 }
 
 void
@@ -88,6 +90,7 @@ fs_live_variables::setup_one_write(struct block_data *bd, fs_inst *inst,
          BITSET_SET(bd->def, var);
 
       BITSET_SET(bd->defout, var);
+      bd->defout_words.add(BITSET_BITWORD(var));
    }
 }
 
@@ -148,81 +151,128 @@ fs_live_variables::setup_def_use()
 /**
  * The algorithm incrementally sets bits in liveout and livein,
  * propagating it through control flow.  It will eventually terminate
- * because it only ever adds bits, and stops when no bits are added in
- * a pass.
+ * because it only ever adds bits, and stops when no bits are added.
+ *
+ * Only the blocks whose inputs changed are revisited, and only the words
+ * of the bitsets which may be non-zero are looked at.
  */
 void
 fs_live_variables::compute_live_variables()
 {
-   bool cont = true;
-
-   while (cont) {
-      cont = false;
-
-      foreach_block_reverse (block, cfg) {
-         struct block_data *bd = &block_data[block->num];
-
-	 /* Update liveout */
-	 foreach_list_typed(bblock_link, child_link, link, &block->children) {
-       struct block_data *child_bd = &block_data[child_link->block->num];
-
-	    for (int i = 0; i < bitset_words; i++) {
-               BITSET_WORD new_liveout = (child_bd->livein[i] &
-                                          ~bd->liveout[i]);
-               if (new_liveout) {
-                  bd->liveout[i] |= new_liveout;
-                  cont = true;
-               }
-	    }
-            BITSET_WORD new_liveout = (child_bd->flag_livein[0] &
-                                       ~bd->flag_liveout[0]);
-            if (new_liveout) {
-               bd->flag_liveout[0] |= new_liveout;
-               cont = true;
-            }
-	 }
+   void *worklist_ctx = ralloc_context(NULL);
+   const int num_blocks = cfg->num_blocks;
 
-         /* Update livein */
-         for (int i = 0; i < bitset_words; i++) {
-            BITSET_WORD new_livein = (bd->use[i] |
-                                      (bd->liveout[i] &
-                                       ~bd->def[i]));
-            if (new_livein & ~bd->livein[i]) {
-               bd->livein[i] |= new_livein;
-               cont = true;
-            }
-         }
-         BITSET_WORD new_livein = (bd->flag_use[0] |
-                                   (bd->flag_liveout[0] &
-                                    ~bd->flag_def[0]));
-         if (new_livein & ~bd->flag_livein[0]) {
-            bd->flag_livein[0] |= new_livein;
-            cont = true;
+   /* FIFO of block numbers.  Each block is in it at most once, so a ring
+    * buffer of num_blocks entries is enough.
+    */
+   int *worklist = ralloc_array(worklist_ctx, int, num_blocks);
+   bool *in_worklist = ralloc_array(worklist_ctx, bool, num_blocks);
+   int head = 0, count = 0;
+
+#define WORKLIST_PUSH(b) do {                          \
+      if (!in_worklist[b]) {                           \
+         worklist[(head + count++) % num_blocks] = (b);\
+         in_worklist[b] = true;                        \
+      }                                                \
+   } while (0)
+
+   for (int b = num_blocks - 1; b >= 0; b--) {
+      in_worklist[b] = false;
+      WORKLIST_PUSH(b);
+   }
+
+   while (count) {
+      const int b = worklist[head];
+      head = (head + 1) % num_blocks;
+      count--;
+      in_worklist[b] = false;
+
+      bblock_t *block = cfg->blocks[b];
+      struct block_data *bd = &block_data[b];
+
+      /* Update liveout */
+      foreach_list_typed(bblock_link, child_link, link, &block->children) {
+         const struct block_data *child_bd = &block_data[child_link->block->num];
+         const word_range &r = child_bd->livein_words;
+
+         for (int i = r.start; i < r.end; i++)
+            bd->liveout[i] |= child_bd->livein[i];
+
+         bd->liveout_words.add(r);
+         bd->flag_liveout[0] |= child_bd->flag_livein[0];
+      }
+
+      /* Update livein */
+      bool changed = false;
+      word_range r = bd->use_words;
+      r.add(bd->liveout_words);
+
+      for (int i = r.start; i < r.end; i++) {
+         BITSET_WORD new_livein = (bd->use[i] |
+                                   (bd->liveout[i] &
+                                    ~bd->def[i]));
+         if (new_livein & ~bd->livein[i]) {
+            bd->livein[i] |= new_livein;
+            changed = true;
          }
       }
+      bd->livein_words = r;
+
+      BITSET_WORD new_livein = (bd->flag_use[0] |
+                                (bd->flag_liveout[0] &
+                                 ~bd->flag_def[0]));
+      if (new_livein & ~bd->flag_livein[0]) {
+         bd->flag_livein[0] |= new_livein;
+         changed = true;
+      }
+
+      if (changed) {
+         foreach_list_typed(bblock_link, parent_link, link, &block->parents)
+            WORKLIST_PUSH(parent_link->block->num);
+      }
    }
 
    /* Propagate defin and defout down the CFG to calculate the union of live
     * variables potentially defined along any possible control flow path.
     */
-   do {
-      cont = false;
-
-      foreach_block (block, cfg) {
-         const struct block_data *bd = &block_data[block->num];
-
-	 foreach_list_typed(bblock_link, child_link, link, &block->children) {
-       struct block_data *child_bd = &block_data[child_link->block->num];
-
-	    for (int i = 0; i < bitset_words; i++) {
-               const BITSET_WORD new_def = bd->defout[i] & ~child_bd->defin[i];
+   for (int b = 0; b < num_blocks; b++)
+      WORKLIST_PUSH(b);
+
+   while (count) {
+      const int b = worklist[head];
+      head = (head + 1) % num_blocks;
+      count--;
+      in_worklist[b] = false;
+
+      const bblock_t *block = cfg->blocks[b];
+      const struct block_data *bd = &block_data[b];
+      const word_range &r = bd->defout_words;
+
+      foreach_list_typed(bblock_link, child_link, link, &block->children) {
+         const int child = child_link->block->num;
+         struct block_data *child_bd = &block_data[child];
+         word_range changed = { 0, 0 };
+
+         for (int i = r.start; i < r.end; i++) {
+            const BITSET_WORD new_def = bd->defout[i] & ~child_bd->defin[i];
+            if (new_def) {
                child_bd->defin[i] |= new_def;
                child_bd->defout[i] |= new_def;
-               cont |= new_def;
-	    }
-	 }
+               changed.add(i);
+            }
+         }
+
+         if (!changed.is_empty()) {
+            child_bd->defin_words.add(changed);
+            child_bd->defout_words.add(changed);
+            WORKLIST_PUSH(child);
+         }
       }
-   } while (cont);
+   }
+
+#undef WORKLIST_PUSH
+
+   ralloc_free(worklist_ctx);
 }
 
 /**
@@ -235,21 +285,23 @@ fs_live_variables::compute_start_end()
    foreach_block (block, cfg) {
       struct block_data *bd = &block_data[block->num];
 
-      for (int w = 0; w < bitset_words; w++) {
+      for (int w = MAX2(bd->livein_words.start, bd->defin_words.start);
+           w < MIN2(bd->livein_words.end, bd->defin_words.end); w++) {
          BITSET_WORD livedefin = bd->livein[w] & bd->defin[w];
+         while (livedefin) {
+            unsigned i = w * BITSET_WORDBITS + u_bit_scan(&livedefin);
+            start[i] = MIN2(start[i], block->start_ip);
+            end[i] = MAX2(end[i], block->start_ip);
+         }
+      }
+
+      for (int w = MAX2(bd->liveout_words.start, bd->defout_words.start);
+           w < MIN2(bd->liveout_words.end, bd->defout_words.end); w++) {
          BITSET_WORD livedefout = bd->liveout[w] & bd->defout[w];
-         BITSET_WORD livedefinout = livedefin | livedefout;
-         while (livedefinout) {
-            unsigned b = u_bit_scan(&livedefinout);
-            unsigned i = w * BITSET_WORDBITS + b;
-            if (livedefin & (1u << b)) {
-               start[i] = MIN2(start[i], block->start_ip);
-               end[i] = MAX2(end[i], block->start_ip);
-            }
-            if (livedefout & (1u << b)) {
-               start[i] = MIN2(start[i], block->end_ip);
-               end[i] = MAX2(end[i], block->end_ip);
-            }
+         while (livedefout) {
+            unsigned i = w * BITSET_WORDBITS + u_bit_scan(&livedefout);
+            start[i] = MIN2(start[i], block->end_ip);
+            end[i] = MAX2(end[i], block->end_ip);
          }
       }
    }
@@ -291,14 +343,20 @@ fs_live_variables::fs_live_variables(const backend_shader *s)
 
    block_data = rzalloc_array(mem_ctx, struct block_data, cfg->num_blocks);
 
+   /* Allocate the bitsets of all blocks at once, there can be many of them
+    * on large CFGs.
+    */
    bitset_words = BITSET_WORDS(num_vars);
+   BITSET_WORD *sets = rzalloc_array(mem_ctx, BITSET_WORD,
+                                     6 * bitset_words * cfg->num_blocks);
    for (int i = 0; i < cfg->num_blocks; i++) {
-      block_data[i].def = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
-      block_data[i].use = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
-      block_data[i].livein = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
-      block_data[i].liveout = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
-      block_data[i].defin = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
-      block_data[i].defout = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
+      block_data[i].def = sets;
+      block_data[i].use = sets + bitset_words;
+      block_data[i].livein = sets + 2 * bitset_words;
+      block_data[i].liveout = sets + 3 * bitset_words;
+      block_data[i].defin = sets + 4 * bitset_words;
+      block_data[i].defout = sets + 5 * bitset_words;
+      sets += 6 * bitset_words;
 
       block_data[i].flag_def[0] = 0;
       block_data[i].flag_use[0] = 0;
@@ -39,6 +39,38 @@ namespace brw {
 
 class fs_live_variables {
 public:
+   /**
+    * Half-open range of bitset words, empty if start >= end.
+    */
+   struct word_range {
+      int start;
+      int end;
+
+      bool is_empty() const { return start >= end; }
+
+      void add(int word)
+      {
+         add(word, word + 1);
+      }
+
+      void add(int word_start, int word_end)
+      {
+         if (is_empty()) {
+            start = word_start;
+            end = word_end;
+         } else {
+            start = MIN2(start, word_start);
+            end = MAX2(end, word_end);
+         }
+      }
+
+      void add(const word_range &r)
+      {
+         if (!r.is_empty())
+            add(r.start, r.end);
+      }
+   };
+
    struct block_data {
       /**
        * Which variables are defined before being used in the block.
@@ -75,6 +107,18 @@ public:
       BITSET_WORD flag_use[1];
       BITSET_WORD flag_livein[1];
       BITSET_WORD flag_liveout[1];
+
+      /** @{
+       * Words of the corresponding bitsets which may be non-zero.  Most
+       * variables are local to a block, so the analysis only has to look at
+       * a small part of the bitsets of each block.
+       */
+      word_range use_words;
+      word_range livein_words;
+      word_range liveout_words;
+      word_range defin_words;
+      word_range defout_words;
+      /** @} */
    };
 
    fs_live_variables(const backend_shader *s);
@@ -132,11 +132,15 @@ fs_visitor::nir_setup_uniforms()
    }
 }
 
-static bool
-emit_system_values_block(nir_block *block, fs_visitor *v)
+/**
+ * Records the system values read by a block which need setup code.  This only
+ * depends on the NIR, so it is done once and shared with the other SIMD
+ * variants compiled from the same shader.
+ */
+static void
+scan_system_values_block(nir_block *block, const fs_visitor *v,
+                         BITSET_WORD *used)
 {
-   fs_reg *reg;
-
    nir_foreach_instr(instr, block) {
       if (instr->type != nir_instr_type_intrinsic)
          continue;
@@ -159,107 +163,111 @@ emit_system_values_block(nir_block *block, fs_visitor *v)
          if (v->stage == MESA_SHADER_TESS_CTRL)
             break;
          assert(v->stage == MESA_SHADER_GEOMETRY);
-         reg = &v->nir_system_values[SYSTEM_VALUE_INVOCATION_ID];
-         if (reg->file == BAD_FILE) {
-            const fs_builder abld = v->bld.annotate("gl_InvocationID", NULL);
-            fs_reg g1(retype(brw_vec8_grf(1, 0), BRW_REGISTER_TYPE_UD));
-            fs_reg iid = abld.vgrf(BRW_REGISTER_TYPE_UD, 1);
-            abld.SHR(iid, g1, brw_imm_ud(27u));
-            *reg = iid;
-         }
+         BITSET_SET(used, SYSTEM_VALUE_INVOCATION_ID);
          break;
 
       case nir_intrinsic_load_sample_pos:
-         assert(v->stage == MESA_SHADER_FRAGMENT);
-         reg = &v->nir_system_values[SYSTEM_VALUE_SAMPLE_POS];
-         if (reg->file == BAD_FILE)
-            *reg = *v->emit_samplepos_setup();
-         break;
-
       case nir_intrinsic_load_sample_id:
+      case nir_intrinsic_load_helper_invocation:
          assert(v->stage == MESA_SHADER_FRAGMENT);
-         reg = &v->nir_system_values[SYSTEM_VALUE_SAMPLE_ID];
-         if (reg->file == BAD_FILE)
-            *reg = *v->emit_sampleid_setup();
+         BITSET_SET(used, nir_system_value_from_intrinsic(intrin->intrinsic));
          break;
 
       case nir_intrinsic_load_sample_mask_in:
          assert(v->stage == MESA_SHADER_FRAGMENT);
          assert(v->devinfo->ver >= 7);
-         reg = &v->nir_system_values[SYSTEM_VALUE_SAMPLE_MASK_IN];
-         if (reg->file == BAD_FILE)
-            *reg = *v->emit_samplemaskin_setup();
+         BITSET_SET(used, SYSTEM_VALUE_SAMPLE_MASK_IN);
          break;
 
       case nir_intrinsic_load_work_group_id:
          assert(v->stage == MESA_SHADER_COMPUTE ||
                 v->stage == MESA_SHADER_KERNEL);
-         reg = &v->nir_system_values[SYSTEM_VALUE_WORK_GROUP_ID];
-         if (reg->file == BAD_FILE)
-            *reg = *v->emit_cs_work_group_id_setup();
+         BITSET_SET(used, SYSTEM_VALUE_WORK_GROUP_ID);
          break;
 
-      case nir_intrinsic_load_helper_invocation:
-         assert(v->stage == MESA_SHADER_FRAGMENT);
-         reg = &v->nir_system_values[SYSTEM_VALUE_HELPER_INVOCATION];
-         if (reg->file == BAD_FILE) {
-            const fs_builder abld =
-               v->bld.annotate("gl_HelperInvocation", NULL);
+      default:
+         break;
+      }
+   }
+}
 
-            /* On Gfx6+ (gl_HelperInvocation is only exposed on Gfx7+) the
-             * pixel mask is in g1.7 of the thread payload.
-             *
-             * We move the per-channel pixel enable bit to the low bit of each
-             * channel by shifting the byte containing the pixel mask by the
-             * vector immediate 0x76543210UV.
-             *
-             * The region of <1,8,0> reads only 1 byte (the pixel masks for
-             * subspans 0 and 1) in SIMD8 and an additional byte (the pixel
-             * masks for 2 and 3) in SIMD16.
-             */
-            fs_reg shifted = abld.vgrf(BRW_REGISTER_TYPE_UW, 1);
-
-            for (unsigned i = 0; i < DIV_ROUND_UP(v->dispatch_width, 16); i++) {
-               const fs_builder hbld = abld.group(MIN2(16, v->dispatch_width), i);
-               hbld.SHR(offset(shifted, hbld, i),
-                        stride(retype(brw_vec1_grf(1 + i, 7),
-                                      BRW_REGISTER_TYPE_UB),
-                               1, 8, 0),
-                        brw_imm_v(0x76543210));
-            }
+static fs_reg
+emit_system_value(fs_visitor *v, gl_system_value value)
+{
+   switch (value) {
+   case SYSTEM_VALUE_INVOCATION_ID: {
+      const fs_builder abld = v->bld.annotate("gl_InvocationID", NULL);
+      fs_reg g1(retype(brw_vec8_grf(1, 0), BRW_REGISTER_TYPE_UD));
+      fs_reg iid = abld.vgrf(BRW_REGISTER_TYPE_UD, 1);
+      abld.SHR(iid, g1, brw_imm_ud(27u));
+      return iid;
+   }
 
-            /* A set bit in the pixel mask means the channel is enabled, but
-             * that is the opposite of gl_HelperInvocation so we need to invert
-             * the mask.
-             *
-             * The negate source-modifier bit of logical instructions on Gfx8+
-             * performs 1's complement negation, so we can use that instead of
-             * a NOT instruction.
-             */
-            fs_reg inverted = negate(shifted);
-            if (v->devinfo->ver < 8) {
-               inverted = abld.vgrf(BRW_REGISTER_TYPE_UW);
-               abld.NOT(inverted, shifted);
-            }
+   case SYSTEM_VALUE_SAMPLE_POS:
+      return *v->emit_samplepos_setup();
 
-            /* We then resolve the 0/1 result to 0/~0 boolean values by ANDing
-             * with 1 and negating.
-             */
-            fs_reg anded = abld.vgrf(BRW_REGISTER_TYPE_UD, 1);
-            abld.AND(anded, inverted, brw_imm_uw(1));
+   case SYSTEM_VALUE_SAMPLE_ID:
+      return *v->emit_sampleid_setup();
 
-            fs_reg dst = abld.vgrf(BRW_REGISTER_TYPE_D, 1);
-            abld.MOV(dst, negate(retype(anded, BRW_REGISTER_TYPE_D)));
-            *reg = dst;
-         }
-         break;
+   case SYSTEM_VALUE_SAMPLE_MASK_IN:
+      return *v->emit_samplemaskin_setup();
 
-      default:
-         break;
+   case SYSTEM_VALUE_WORK_GROUP_ID:
+      return *v->emit_cs_work_group_id_setup();
+
+   case SYSTEM_VALUE_HELPER_INVOCATION: {
+      const fs_builder abld = v->bld.annotate("gl_HelperInvocation", NULL);
+
+      /* On Gfx6+ (gl_HelperInvocation is only exposed on Gfx7+) the
+       * pixel mask is in g1.7 of the thread payload.
+       *
+       * We move the per-channel pixel enable bit to the low bit of each
+       * channel by shifting the byte containing the pixel mask by the
+       * vector immediate 0x76543210UV.
+       *
+       * The region of <1,8,0> reads only 1 byte (the pixel masks for
+       * subspans 0 and 1) in SIMD8 and an additional byte (the pixel
+       * masks for 2 and 3) in SIMD16.
+       */
+      fs_reg shifted = abld.vgrf(BRW_REGISTER_TYPE_UW, 1);
+
+      for (unsigned i = 0; i < DIV_ROUND_UP(v->dispatch_width, 16); i++) {
+         const fs_builder hbld = abld.group(MIN2(16, v->dispatch_width), i);
+         hbld.SHR(offset(shifted, hbld, i),
+                  stride(retype(brw_vec1_grf(1 + i, 7),
+                                BRW_REGISTER_TYPE_UB),
+                         1, 8, 0),
+                  brw_imm_v(0x76543210));
       }
+
+      /* A set bit in the pixel mask means the channel is enabled, but
+       * that is the opposite of gl_HelperInvocation so we need to invert
+       * the mask.
+       *
+       * The negate source-modifier bit of logical instructions on Gfx8+
+       * performs 1's complement negation, so we can use that instead of
+       * a NOT instruction.
+       */
+      fs_reg inverted = negate(shifted);
+      if (v->devinfo->ver < 8) {
+         inverted = abld.vgrf(BRW_REGISTER_TYPE_UW);
+         abld.NOT(inverted, shifted);
+      }
+
+      /* We then resolve the 0/1 result to 0/~0 boolean values by ANDing
+       * with 1 and negating.
+       */
+      fs_reg anded = abld.vgrf(BRW_REGISTER_TYPE_UD, 1);
+      abld.AND(anded, inverted, brw_imm_uw(1));
+
+      fs_reg dst = abld.vgrf(BRW_REGISTER_TYPE_D, 1);
+      abld.MOV(dst, negate(retype(anded, BRW_REGISTER_TYPE_D)));
+      return dst;
    }
 
-   return true;
+   default:
+      unreachable("system value without setup code");
+   }
 }
 
 void
@@ -288,9 +296,18 @@ fs_visitor::nir_emit_system_values()
       }
    }
 
-   nir_function_impl *impl = nir_shader_get_entrypoint((nir_shader *)nir);
-   nir_foreach_block(block, impl)
-      emit_system_values_block(block, this);
+   if (!nir_system_values_used) {
+      nir_system_values_used =
+         rzalloc_array(mem_ctx, BITSET_WORD, BITSET_WORDS(SYSTEM_VALUE_MAX));
+
+      nir_function_impl *impl = nir_shader_get_entrypoint((nir_shader *)nir);
+      nir_foreach_block(block, impl)
+         scan_system_values_block(block, this, nir_system_values_used);
+   }
+
+   unsigned i;
+   BITSET_FOREACH_SET(i, nir_system_values_used, SYSTEM_VALUE_MAX)
+      nir_system_values[i] = emit_system_value(this, (gl_system_value)i);
 }
 
 void
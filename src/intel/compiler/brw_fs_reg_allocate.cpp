@@ -423,7 +423,7 @@ public:
    fs_reg_alloc(fs_visitor *fs):
       fs(fs), devinfo(fs->devinfo), compiler(fs->compiler),
       live(fs->live_analysis.require()), g(NULL),
-      have_spill_costs(false)
+      have_spill_costs(false), spilling_enabled(false)
    {
       mem_ctx = ralloc_context(NULL);
 
@@ -472,9 +472,10 @@ private:
    void setup_live_interference(unsigned node,
                                 int node_start_ip, int node_end_ip);
    void setup_inst_interference(const fs_inst *inst);
+   void setup_eot_reg(const fs_inst *inst);
 
    void build_interference_graph(bool allow_spilling);
-   void discard_interference_graph();
+   void enable_spilling();
 
    void emit_unspill(const fs_builder &bld, fs_reg dst,
                      uint32_t spill_offset, unsigned count);
@@ -502,6 +503,9 @@ private:
    ra_graph *g;
    bool have_spill_costs;
 
+   /* Whether the graph accounts for the registers used by spilling */
+   bool spilling_enabled;
+
    int payload_node_count;
    int *payload_last_use_ip;
 
@@ -622,7 +626,7 @@ fs_reg_alloc::setup_live_interference(unsigned node,
    /* If we have the MRF hack enabled, mark this node as interfering with all
     * MRF registers.
     */
-   if (first_mrf_hack_node >= 0) {
+   if (spilling_enabled && first_mrf_hack_node >= 0) {
       for (int i = spill_base_mrf(fs); i < BRW_MAX_MRF(devinfo->ver); i++)
          ra_add_node_interference(g, node, first_mrf_hack_node + i);
    }
@@ -739,37 +743,47 @@ fs_reg_alloc::setup_inst_interference(const fs_inst *inst)
     * We could just do "something high".  Instead, we just pick the highest
     * register that works.
     */
-   if (inst->eot) {
-      const int vgrf = inst->opcode == SHADER_OPCODE_SEND ?
-                       inst->src[2].nr : inst->src[0].nr;
-      int size = fs->alloc.sizes[vgrf];
-      int reg = compiler->fs_reg_sets[rsi].class_to_ra_reg_range[size] - 1;
-
-      if (first_mrf_hack_node >= 0) {
-         /* If something happened to spill, we want to push the EOT send
-          * register early enough in the register file that we don't
-          * conflict with any used MRF hack registers.
-          */
-         reg -= BRW_MAX_MRF(devinfo->ver) - spill_base_mrf(fs);
-      } else if (grf127_send_hack_node >= 0) {
-         /* Avoid r127 which might be unusable if the node was previously
-          * written by a SIMD8 SEND message with source/destination overlap.
-          */
-         reg--;
-      }
+   if (inst->eot)
+      setup_eot_reg(inst);
+}
 
-      ra_set_node_reg(g, first_vgrf_node + vgrf, reg);
+void
+fs_reg_alloc::setup_eot_reg(const fs_inst *inst)
+{
+   const int vgrf = inst->opcode == SHADER_OPCODE_SEND ?
+                    inst->src[2].nr : inst->src[0].nr;
+   int size = fs->alloc.sizes[vgrf];
+   int reg = compiler->fs_reg_sets[rsi].class_to_ra_reg_range[size] - 1;
+
+   if (spilling_enabled && first_mrf_hack_node >= 0) {
+      /* If something happened to spill, we want to push the EOT send
+       * register early enough in the register file that we don't
+       * conflict with any used MRF hack registers.
+       */
+      reg -= BRW_MAX_MRF(devinfo->ver) - spill_base_mrf(fs);
+   } else if (grf127_send_hack_node >= 0) {
+      /* Avoid r127 which might be unusable if the node was previously
+       * written by a SIMD8 SEND message with source/destination overlap.
+       */
+      reg--;
    }
+
+   ra_set_node_reg(g, first_vgrf_node + vgrf, reg);
 }
 
 void
 fs_reg_alloc::build_interference_graph(bool allow_spilling)
 {
-   /* Compute the RA node layout */
+   spilling_enabled = allow_spilling;
+
+   /* Compute the RA node layout.  The MRF hack nodes are always part of it,
+    * so that enable_spilling() doesn't have to renumber the VGRF nodes, but
+    * nothing interferes with them until spilling is enabled.
+    */
    node_count = 0;
    first_payload_node = node_count;
    node_count += payload_node_count;
-   if (devinfo->ver >= 7 && devinfo->ver < 9 && allow_spilling) {
+   if (devinfo->ver >= 7 && devinfo->ver < 9) {
       first_mrf_hack_node = node_count;
       node_count += BRW_MAX_GRF - GFX7_MRF_HACK_START;
    } else {
@@ -872,12 +886,38 @@ fs_reg_alloc::build_interference_graph(bool allow_spilling)
       setup_inst_interference(inst);
 }
 
+/**
+ * Extends a graph built without spilling support with the interference
+ * required by the spill code, which is much cheaper than building it again:
+ * nothing else about the VGRFs changes.
+ */
 void
-fs_reg_alloc::discard_interference_graph()
+fs_reg_alloc::enable_spilling()
 {
-   ralloc_free(g);
-   g = NULL;
-   have_spill_costs = false;
+   assert(!spilling_enabled && spill_node_count == 0);
+   spilling_enabled = true;
+
+   if (first_mrf_hack_node >= 0) {
+      for (int n = first_vgrf_node; n <= last_vgrf_node; n++) {
+         for (int i = spill_base_mrf(fs); i < BRW_MAX_MRF(devinfo->ver); i++)
+            ra_add_node_interference(g, n, first_mrf_hack_node + i);
+      }
+
+      foreach_block_and_inst(block, fs_inst, inst, fs->cfg) {
+         if (inst->eot)
+            setup_eot_reg(inst);
+      }
+   }
+
+   if (devinfo->ver >= 9) {
+      /* The scratch header takes the place of the first spill node, its
+       * interference is set up by alloc_scratch_header().
+       */
+      scratch_header_node = ra_add_node(g, compiler->fs_reg_sets[rsi].classes[0]);
+      assert(scratch_header_node == first_spill_node);
+      first_spill_node++;
+      node_count++;
+   }
 }
 
 void
@@ -1321,12 +1361,10 @@ fs_reg_alloc::assign_regs(bool allow_spilling, bool spill_all)
          return false;
 
       /* If we're going to spill but we've never spilled before, we need to
-       * re-build the interference graph with MRFs enabled to allow spilling.
+       * extend the interference graph with MRFs enabled to allow spilling.
        */
-      if (!fs->spilled_any_registers) {
-         discard_interference_graph();
-         build_interference_graph(true);
-      }
+      if (!spilling_enabled)
+         enable_spilling();
 
       spilled = true;
 
@@ -110,26 +110,6 @@ namespace {
       return shader->cfg->blocks[shader->cfg->num_blocks - 1]->end_ip + 1;
    }
 
-   /**
-    * Calculate the local ordered_address instruction counter at every
-    * instruction of the shader for subsequent constant-time look-up.
-    */
-   ordered_address *
-   ordered_inst_addresses(const fs_visitor *shader)
-   {
-      ordered_address *jps = new ordered_address[num_instructions(shader)];
-      ordered_address jp = 0;
-      unsigned ip = 0;
-
-      foreach_block_and_inst(block, fs_inst, inst, shader->cfg) {
-         jps[ip] = jp;
-         jp += ordered_unit(inst);
-         ip++;
-      }
-
-      return jps;
-   }
-
    /**
     * Synchronization mode required for data manipulated by in-order
     * instructions.
@@ -317,7 +297,7 @@ namespace {
        * instruction of the current block is exactly the number of in-order
        * instructions across that control flow path.  It is not guaranteed to
        * be equal to the local ordered_address of the generating instruction
-       * [as returned by ordered_inst_addresses()], except for block-local
+       * [as calculated by gather_block_scoreboards()], except for block-local
        * dependencies.
        */
       ordered_address jp;
@@ -835,16 +815,24 @@ namespace {
     * Calculate scoreboard objects locally that represent any pending (and
     * unconditionally resolved) dependencies at the end of each block of the
     * program.
+    *
+    * The local ordered_address instruction counter of every instruction is
+    * calculated into \p jps along the way for subsequent constant-time
+    * look-up, since it only needs the counters of the instructions that came
+    * before.
     */
    scoreboard *
-   gather_block_scoreboards(const fs_visitor *shader,
-                            const ordered_address *jps)
+   gather_block_scoreboards(const fs_visitor *shader, ordered_address *jps)
    {
       scoreboard *sbs = new scoreboard[shader->cfg->num_blocks];
+      ordered_address jp = 0;
       unsigned ip = 0;
 
-      foreach_block_and_inst(block, fs_inst, inst, shader->cfg)
+      foreach_block_and_inst(block, fs_inst, inst, shader->cfg) {
+         jps[ip] = jp;
+         jp += ordered_unit(inst);
          update_inst_scoreboard(jps, inst, ip++, sbs[block->num]);
+      }
 
       return sbs;
    }
@@ -858,7 +846,7 @@ namespace {
     */
    scoreboard *
    propagate_block_scoreboards(const fs_visitor *shader,
-                               const ordered_address *jps,
+                               ordered_address *jps,
                                equivalence_relation &eq)
    {
       const scoreboard *delta_sbs = gather_block_scoreboards(shader, jps);
@@ -897,11 +885,11 @@ namespace {
 
    /**
     * Return the list of potential dependencies of each instruction in the
-    * shader based on the result of global dependency analysis.
+    * shader based on the result of global dependency analysis, and fill in
+    * the ordered_address counter of each instruction into \p jps.
     */
    dependency_list *
-   gather_inst_dependencies(const fs_visitor *shader,
-                            const ordered_address *jps)
+   gather_inst_dependencies(const fs_visitor *shader, ordered_address *jps)
    {
       equivalence_relation eq(num_instructions(shader));
       scoreboard *sbs = propagate_block_scoreboards(shader, jps, eq);
@@ -1076,7 +1064,7 @@ bool
 fs_visitor::lower_scoreboard()
 {
    if (devinfo->ver >= 12) {
-      const ordered_address *jps = ordered_inst_addresses(this);
+      ordered_address *jps = new ordered_address[num_instructions(this)];
       const dependency_list *deps0 = gather_inst_dependencies(this, jps);
       const dependency_list *deps1 = allocate_inst_dependencies(this, deps0);
       emit_inst_dependencies(this, jps, deps1);
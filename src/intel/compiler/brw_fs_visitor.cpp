@@ -952,6 +952,7 @@ fs_visitor::init()
    this->nir_locals = NULL;
    this->nir_ssa_values = NULL;
    this->nir_system_values = NULL;
+   this->nir_system_values_used = NULL;
 
    memset(&this->payload, 0, sizeof(this->payload));
    this->source_depth_to_render_target = false;
@@ -966,9 +967,16 @@ fs_visitor::init()
 
    this->shader_stats.scheduler_mode = NULL;
    this->shader_stats.promoted_constants = 0,
+   this->shader_stats.schedule_time = 0;
 
    this->grf_used = 0;
    this->spilled_any_registers = false;
+   this->max_register_pressure = 0;
+
+   this->ir_generation = 0;
+   this->invalidated_analyses = DEPENDENCY_NOTHING;
+   this->opt_passes = NULL;
+   this->num_opt_passes = 0;
 }
 
 fs_visitor::~fs_visitor()
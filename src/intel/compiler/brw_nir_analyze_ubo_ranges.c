@@ -42,6 +42,9 @@
  * of registers required) and "benefit" (number of pull loads eliminated
  * by pushing the range).  We then sort the list to obtain the four best
  * ranges (most benefit for the least cost).
+ *
+ * Loads inside of loops are likely to be executed many times, so they count
+ * for more than one load each, depending on how deeply nested they are.
  */
 
 struct ubo_range_entry
@@ -88,7 +91,7 @@ struct ubo_block_info
     * not, there's a "hole" - padding between data - or just nothing at all.
     */
    uint64_t offsets;
-   uint8_t uses[64];
+   uint32_t uses[64];
 };
 
 struct ubo_analysis_state
@@ -116,9 +119,29 @@ get_block_info(struct ubo_analysis_state *state, int block)
    return info;
 }
 
+/* The weight of a load is multiplied by this for each loop it's nested in. */
+#define LOOP_USE_WEIGHT 4
+#define MAX_LOOP_DEPTH 3
+
+static unsigned
+use_weight(nir_block *block)
+{
+   unsigned weight = 1;
+   unsigned depth = 0;
+
+   for (nir_cf_node *node = block->cf_node.parent; node; node = node->parent) {
+      if (node->type == nir_cf_node_loop && depth++ < MAX_LOOP_DEPTH)
+         weight *= LOOP_USE_WEIGHT;
+   }
+
+   return weight;
+}
+
 static void
 analyze_ubos_block(struct ubo_analysis_state *state, nir_block *block)
 {
+   const unsigned weight = use_weight(block);
+
    nir_foreach_instr(instr, block) {
       if (instr->type != nir_instr_type_intrinsic)
          continue;
@@ -171,11 +194,9 @@ analyze_ubos_block(struct ubo_analysis_state *state, nir_block *block)
          const int end = ALIGN(byte_offset + bytes, 32);
          const int chunks = (end - start) / 32;
 
-         /* TODO: should we count uses in loops as higher benefit? */
-
          struct ubo_block_info *info = get_block_info(state, block);
          info->offsets |= ((1ull << chunks) - 1) << offset;
-         info->uses[offset]++;
+         info->uses[offset] += weight;
       }
    }
 }
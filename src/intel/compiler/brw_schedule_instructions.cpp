@@ -30,6 +30,9 @@
 #include "brw_vec4.h"
 #include "brw_cfg.h"
 #include "brw_shader.h"
+#include "util/os_time.h"
+
+#include <inttypes.h>
 
 using namespace brw;
 
@@ -53,6 +56,15 @@ using namespace brw;
  * Note that often there will be many things which could execute
  * immediately, and there are a range of heuristic options to choose
  * from in picking among those.
+ *
+ * The DAG heads are kept in a binary heap ordered by the heuristic, so
+ * picking one doesn't require a walk over all of them.  Most parts of the
+ * priority of a node only get worse while other nodes are scheduled (the
+ * unblocked time of its exit node only grows), so those are re-evaluated
+ * lazily when the node reaches the top of the heap.  The register pressure
+ * benefit can only improve, and the nodes affected by it are requeued
+ * explicitly when a register is written for the first time or is down to its
+ * last read.
  */
 
 static bool debug = false;
@@ -94,6 +106,30 @@ public:
     * successors is an exit node.
     */
    schedule_node *exit;
+
+   /** Index of this node in the ready queue, or -1 if it's not queued. */
+   int ready_index;
+
+   /**
+    * Position of this node in the list of DAG heads, used to break ties in
+    * favor of the node which would come first in that list.
+    */
+   int cand_order;
+
+   /**
+    * Cached priority of this node in the ready queue, see
+    * instruction_scheduler::update_candidate_key().
+    */
+   int cand_benefit;
+   int cand_exit_time;
+   int cand_unblocked_time;
+
+   /**
+    * For software-pipelined loop bodies, the latency of this node plus the
+    * delay of the instructions reading its result in the next iteration of
+    * the loop.  Used as a lower bound of the delay.
+    */
+   int carried_delay;
 };
 
 /**
@@ -569,6 +605,11 @@ public:
       this->mode = mode;
       this->reg_pressure = 0;
       this->block_idx = 0;
+      this->use_ready_queue = true;
+      this->pipeline_block = false;
+      this->ready = NULL;
+      this->ready_size = 0;
+      this->ready_count = 0;
       if (!post_reg_alloc) {
          this->reg_pressure_in = rzalloc_array(mem_ctx, int, block_count);
 
@@ -618,6 +659,43 @@ public:
    virtual void calculate_deps() = 0;
    virtual schedule_node *choose_instruction_to_schedule() = 0;
 
+   /**
+    * Recomputes the cached priority of a DAG head, returning whether it
+    * changed.
+    */
+   virtual bool update_candidate_key(schedule_node *n) = 0;
+
+   /**
+    * Returns whether @a should be scheduled before @b according to their
+    * cached priorities.
+    */
+   virtual bool is_better_candidate(const schedule_node *a,
+                                    const schedule_node *b) = 0;
+
+   /**
+    * Called with all the nodes of a block in the instruction list, before
+    * it's reduced to the DAG heads.
+    */
+   virtual void setup_ready_queue() {}
+
+   /**
+    * Returns whether the block is the body of a loop which should be
+    * scheduled taking into account the overlap between iterations.
+    */
+   virtual bool should_pipeline_block(bblock_t *) { return false; }
+
+   /**
+    * Sets schedule_node::carried_delay for the nodes of a loop body whose
+    * results are read by the next iteration.
+    */
+   virtual void compute_carried_delays() {}
+
+   void ready_queue_push(schedule_node *n);
+   void ready_queue_update(schedule_node *n);
+   schedule_node *ready_queue_pop();
+   void ready_queue_sift_up(int i);
+   void ready_queue_sift_down(int i);
+
    /**
     * Returns how many cycles it takes the instruction to issue.
     *
@@ -644,6 +722,19 @@ public:
    exec_list instructions;
    const backend_shader *bs;
 
+   /*
+    * Binary heap of the DAG heads, if choose_instruction_to_schedule() isn't
+    * used instead.
+    */
+   bool use_ready_queue;
+
+   /* Whether the current block is scheduled as a software-pipelined loop. */
+   bool pipeline_block;
+
+   schedule_node **ready;
+   int ready_size;
+   int ready_count;
+
    instruction_scheduler_mode mode;
 
    /*
@@ -698,6 +789,11 @@ public:
    void calculate_deps();
    bool is_compressed(const fs_inst *inst);
    schedule_node *choose_instruction_to_schedule();
+   bool update_candidate_key(schedule_node *n);
+   bool is_better_candidate(const schedule_node *a, const schedule_node *b);
+   void setup_ready_queue();
+   bool should_pipeline_block(bblock_t *block);
+   void compute_carried_delays();
    int issue_time(backend_instruction *inst);
    const fs_visitor *v;
 
@@ -705,6 +801,32 @@ public:
    void setup_liveness(cfg_t *cfg);
    void update_register_pressure(backend_instruction *inst);
    int get_register_pressure_benefit(backend_instruction *inst);
+   void add_register_user(unsigned reg, schedule_node *n, bool count_only);
+   void add_register_users(schedule_node *n, bool count_only);
+   void requeue_register_users(unsigned reg);
+
+   /**
+    * The time used to order the candidates in the latency-based modes.  In
+    * software-pipelined blocks the critical path to the next iteration is
+    * subtracted, so that a node on it is preferred over one which became
+    * ready slightly earlier.
+    */
+   int candidate_time(const schedule_node *n) const
+   {
+      return pipeline_block ? n->unblocked_time - n->delay : n->unblocked_time;
+   }
+
+   /*
+    * For the pre-RA heuristics based on register pressure: the DAG nodes of
+    * the current block which access each register, VGRFs first and hardware
+    * GRFs after them, so that the nodes whose register pressure benefit
+    * changes can be requeued.  The users of register i are
+    * reg_users[reg_users_start[i]] to reg_users[reg_users_start[i + 1] - 1].
+    */
+   bool track_register_users;
+   int *reg_users_start;
+   schedule_node **reg_users;
+   int reg_users_size;
 };
 
 fs_instruction_scheduler::fs_instruction_scheduler(const fs_visitor *v,
@@ -714,6 +836,23 @@ fs_instruction_scheduler::fs_instruction_scheduler(const fs_visitor *v,
    : instruction_scheduler(v, grf_count, hw_reg_count, block_count, mode),
      v(v)
 {
+   /* The gfx4-6 LIFO heuristic has an MRF tie-breaker which doesn't define a
+    * consistent ordering of the nodes, so keep walking the whole list there.
+    */
+   if (mode == SCHEDULE_PRE_LIFO && v->devinfo->ver < 7)
+      use_ready_queue = false;
+
+   track_register_users = use_ready_queue &&
+                          (mode == SCHEDULE_PRE_NON_LIFO ||
+                           mode == SCHEDULE_PRE_LIFO);
+   if (track_register_users) {
+      reg_users_start = ralloc_array(mem_ctx, int,
+                                     grf_count + hw_reg_count + 1);
+   } else {
+      reg_users_start = NULL;
+   }
+   reg_users = NULL;
+   reg_users_size = 0;
 }
 
 static bool
@@ -817,6 +956,8 @@ fs_instruction_scheduler::update_register_pressure(backend_instruction *be)
       return;
 
    if (inst->dst.file == VGRF) {
+      if (!written[inst->dst.nr] && track_register_users)
+         requeue_register_users(inst->dst.nr);
       written[inst->dst.nr] = true;
    }
 
@@ -825,13 +966,200 @@ fs_instruction_scheduler::update_register_pressure(backend_instruction *be)
           continue;
 
       if (inst->src[i].file == VGRF) {
-         reads_remaining[inst->src[i].nr]--;
+         if (--reads_remaining[inst->src[i].nr] == 1 && track_register_users)
+            requeue_register_users(inst->src[i].nr);
+      } else if (inst->src[i].file == FIXED_GRF &&
+                 inst->src[i].nr < hw_reg_count) {
+         for (unsigned off = 0; off < regs_read(inst, i); off++) {
+            const unsigned reg = inst->src[i].nr + off;
+            if (--hw_reads_remaining[reg] == 1 && track_register_users)
+               requeue_register_users(grf_count + reg);
+         }
+      }
+   }
+}
+
+/**
+ * Requeues the DAG heads accessing a register whose state just changed in a
+ * way that may improve their register pressure benefit.
+ */
+void
+fs_instruction_scheduler::requeue_register_users(unsigned reg)
+{
+   for (int i = reg_users_start[reg]; i < reg_users_start[reg + 1]; i++) {
+      if (reg_users[i]->ready_index >= 0)
+         ready_queue_update(reg_users[i]);
+   }
+}
+
+void
+fs_instruction_scheduler::add_register_user(unsigned reg, schedule_node *n,
+                                            bool count_only)
+{
+   if (count_only)
+      reg_users_start[reg]++;
+   else
+      reg_users[--reg_users_start[reg]] = n;
+}
+
+void
+fs_instruction_scheduler::add_register_users(schedule_node *n, bool count_only)
+{
+   fs_inst *inst = (fs_inst *)n->inst;
+
+   if (inst->dst.file == VGRF)
+      add_register_user(inst->dst.nr, n, count_only);
+
+   for (int i = 0; i < inst->sources; i++) {
+      if (is_src_duplicate(inst, i))
+         continue;
+
+      if (inst->src[i].file == VGRF) {
+         add_register_user(inst->src[i].nr, n, count_only);
       } else if (inst->src[i].file == FIXED_GRF &&
                  inst->src[i].nr < hw_reg_count) {
          for (unsigned off = 0; off < regs_read(inst, i); off++)
-            hw_reads_remaining[inst->src[i].nr + off]--;
+            add_register_user(grf_count + inst->src[i].nr + off, n, count_only);
+      }
+   }
+}
+
+void
+fs_instruction_scheduler::setup_ready_queue()
+{
+   if (!track_register_users)
+      return;
+
+   const unsigned reg_count = grf_count + hw_reg_count;
+   memset(reg_users_start, 0, (reg_count + 1) * sizeof(*reg_users_start));
+
+   foreach_in_list(schedule_node, n, &instructions)
+      add_register_users(n, true);
+
+   /* Turn the counts into the end of each range, which then gets moved back
+    * to its start as the users are added.
+    */
+   for (unsigned i = 1; i < reg_count; i++)
+      reg_users_start[i] += reg_users_start[i - 1];
+
+   const int count = reg_count ? reg_users_start[reg_count - 1] : 0;
+   reg_users_start[reg_count] = count;
+
+   if (count > reg_users_size) {
+      reg_users_size = MAX2(count, 2 * reg_users_size);
+      reg_users = reralloc(mem_ctx, reg_users, schedule_node *, reg_users_size);
+   }
+
+   foreach_in_list(schedule_node, n, &instructions)
+      add_register_users(n, false);
+}
+
+/**
+ * Only small innermost loops with a single exit and sampler or memory
+ * messages in their last block are pipelined, and only if the performance
+ * analysis estimates that the block is bound by the latency of its
+ * instructions rather than by their issue.
+ */
+bool
+fs_instruction_scheduler::should_pipeline_block(bblock_t *block)
+{
+   if (!post_reg_alloc || !v->compiler->pipelined_loop_scheduling ||
+       block->end()->opcode != BRW_OPCODE_WHILE)
+      return false;
+
+   int issue = 0;
+   bool has_send = false;
+   foreach_inst_in_block(fs_inst, inst, block) {
+      issue += issue_time(inst);
+      has_send |= is_send(inst);
+   }
+
+   if (!has_send)
+      return false;
+
+   /* Walk back to the DO, giving up on nested loops and on any control flow
+    * other than the loop exit.
+    */
+   unsigned num_insts = 0;
+   unsigned num_breaks = 0;
+   for (bblock_t *b = block; b; b = b->prev()) {
+      foreach_inst_in_block_reverse(fs_inst, inst, b) {
+         switch (inst->opcode) {
+         case BRW_OPCODE_DO:
+            if (num_breaks != 1 || num_insts > 128)
+               return false;
+
+            return v->performance_analysis.require().block_latency[block->num] >
+                   (unsigned)(2 * issue);
+         case BRW_OPCODE_BREAK:
+            num_breaks++;
+            break;
+         case BRW_OPCODE_WHILE:
+            if (inst != block->end())
+               return false;
+            break;
+         case BRW_OPCODE_IF:
+         case BRW_OPCODE_ELSE:
+         case BRW_OPCODE_ENDIF:
+         case BRW_OPCODE_CONTINUE:
+         case BRW_OPCODE_HALT:
+            return false;
+         default:
+            break;
+         }
+
+         num_insts++;
+      }
+   }
+
+   return false;
+}
+
+/**
+ * Software pipelining without modulo variable expansion: the GRFs read by a
+ * loop body before it writes them hold the values of the previous iteration,
+ * so the last write of such a register in the block feeds the next iteration.
+ * Giving the writer the delay of those readers makes the list scheduler
+ * issue it early, overlapping its latency with the rest of the current
+ * iteration rather than stalling at the top of the next one.
+ */
+void
+fs_instruction_scheduler::compute_carried_delays()
+{
+   int exposed_delay[BRW_MAX_GRF];
+   schedule_node *last_write[BRW_MAX_GRF];
+   memset(exposed_delay, 0, sizeof(exposed_delay));
+   memset(last_write, 0, sizeof(last_write));
+
+   foreach_in_list(schedule_node, n, &instructions) {
+      const fs_inst *inst = (const fs_inst *)n->inst;
+
+      for (int i = 0; i < inst->sources; i++) {
+         if (inst->src[i].file != VGRF && inst->src[i].file != FIXED_GRF)
+            continue;
+
+         for (unsigned r = 0; r < regs_read(inst, i); r++) {
+            const unsigned reg = inst->src[i].nr + r;
+            if (reg < BRW_MAX_GRF && !last_write[reg])
+               exposed_delay[reg] = MAX2(exposed_delay[reg], n->delay);
+         }
+      }
+
+      if (inst->dst.file == VGRF || inst->dst.file == FIXED_GRF) {
+         for (unsigned r = 0; r < regs_written(inst); r++) {
+            const unsigned reg = inst->dst.nr + r;
+            if (reg < BRW_MAX_GRF)
+               last_write[reg] = n;
+         }
       }
    }
+
+   for (unsigned reg = 0; reg < BRW_MAX_GRF; reg++) {
+      schedule_node *n = last_write[reg];
+      if (n && exposed_delay[reg])
+         n->carried_delay = MAX2(n->carried_delay,
+                                 n->latency + exposed_delay[reg]);
+   }
 }
 
 int
@@ -876,6 +1204,8 @@ public:
    vec4_instruction_scheduler(const vec4_visitor *v, int grf_count);
    void calculate_deps();
    schedule_node *choose_instruction_to_schedule();
+   bool update_candidate_key(schedule_node *n);
+   bool is_better_candidate(const schedule_node *a, const schedule_node *b);
    int issue_time(backend_instruction *inst);
    const vec4_visitor *v;
 
@@ -928,6 +1258,12 @@ schedule_node::schedule_node(backend_instruction *inst,
    this->cand_generation = 0;
    this->delay = 0;
    this->exit = NULL;
+   this->ready_index = -1;
+   this->cand_order = 0;
+   this->cand_benefit = 0;
+   this->cand_exit_time = 0;
+   this->cand_unblocked_time = 0;
+   this->carried_delay = 0;
 
    /* We can't measure Gfx6 timings directly but expect them to be much
     * closer to Gfx7 than Gfx4.
@@ -963,6 +1299,8 @@ instruction_scheduler::compute_delays()
             n->delay = MAX2(n->delay, n->latency + n->children[i]->delay);
          }
       }
+
+      n->delay = MAX2(n->delay, n->carried_delay);
    }
 }
 
@@ -1548,12 +1886,14 @@ fs_instruction_scheduler::choose_instruction_to_schedule()
        * otherwise the oldest one.
        */
       foreach_in_list(schedule_node, n, &instructions) {
+         const int time = candidate_time(n);
+
          if (!chosen ||
              exit_unblocked_time(n) < exit_unblocked_time(chosen) ||
              (exit_unblocked_time(n) == exit_unblocked_time(chosen) &&
-              n->unblocked_time < chosen_time)) {
+              time < chosen_time)) {
             chosen = n;
-            chosen_time = n->unblocked_time;
+            chosen_time = time;
          }
       }
    } else {
@@ -1665,6 +2005,61 @@ fs_instruction_scheduler::choose_instruction_to_schedule()
    return chosen;
 }
 
+bool
+fs_instruction_scheduler::update_candidate_key(schedule_node *n)
+{
+   /* Like choose_instruction_to_schedule(), only a positive register pressure
+    * benefit is taken into account.
+    */
+   const int benefit = track_register_users ?
+      MAX2(get_register_pressure_benefit(n->inst), 0) : 0;
+   const int exit_time = exit_unblocked_time(n);
+   const int time = candidate_time(n);
+
+   const bool changed = n->cand_benefit != benefit ||
+                        n->cand_exit_time != exit_time ||
+                        n->cand_unblocked_time != time;
+
+   n->cand_benefit = benefit;
+   n->cand_exit_time = exit_time;
+   n->cand_unblocked_time = time;
+
+   return changed;
+}
+
+/**
+ * The same ordering as implemented by choose_instruction_to_schedule(), where
+ * ties are broken in favor of the node that comes first in the candidate
+ * list.
+ */
+bool
+fs_instruction_scheduler::is_better_candidate(const schedule_node *a,
+                                              const schedule_node *b)
+{
+   if (mode == SCHEDULE_PRE || mode == SCHEDULE_POST) {
+      if (a->cand_exit_time != b->cand_exit_time)
+         return a->cand_exit_time < b->cand_exit_time;
+
+      if (a->cand_unblocked_time != b->cand_unblocked_time)
+         return a->cand_unblocked_time < b->cand_unblocked_time;
+   } else {
+      if (a->cand_benefit != b->cand_benefit)
+         return a->cand_benefit > b->cand_benefit;
+
+      if (mode == SCHEDULE_PRE_LIFO &&
+          a->cand_generation != b->cand_generation)
+         return a->cand_generation > b->cand_generation;
+
+      if (a->delay != b->delay)
+         return a->delay > b->delay;
+
+      if (a->cand_exit_time != b->cand_exit_time)
+         return a->cand_exit_time < b->cand_exit_time;
+   }
+
+   return a->cand_order < b->cand_order;
+}
+
 schedule_node *
 vec4_instruction_scheduler::choose_instruction_to_schedule()
 {
@@ -1684,6 +2079,24 @@ vec4_instruction_scheduler::choose_instruction_to_schedule()
    return chosen;
 }
 
+bool
+vec4_instruction_scheduler::update_candidate_key(schedule_node *n)
+{
+   const bool changed = n->cand_unblocked_time != n->unblocked_time;
+   n->cand_unblocked_time = n->unblocked_time;
+   return changed;
+}
+
+bool
+vec4_instruction_scheduler::is_better_candidate(const schedule_node *a,
+                                                const schedule_node *b)
+{
+   if (a->cand_unblocked_time != b->cand_unblocked_time)
+      return a->cand_unblocked_time < b->cand_unblocked_time;
+
+   return a->cand_order < b->cand_order;
+}
+
 int
 fs_instruction_scheduler::issue_time(backend_instruction *inst0)
 {
@@ -1703,6 +2116,93 @@ vec4_instruction_scheduler::issue_time(backend_instruction *)
    return 2;
 }
 
+static inline void
+ready_queue_swap(schedule_node **ready, int i, int j)
+{
+   schedule_node *tmp = ready[i];
+   ready[i] = ready[j];
+   ready[j] = tmp;
+   ready[i]->ready_index = i;
+   ready[j]->ready_index = j;
+}
+
+void
+instruction_scheduler::ready_queue_sift_up(int i)
+{
+   while (i > 0) {
+      const int parent = (i - 1) / 2;
+      if (!is_better_candidate(ready[i], ready[parent]))
+         break;
+
+      ready_queue_swap(ready, i, parent);
+      i = parent;
+   }
+}
+
+void
+instruction_scheduler::ready_queue_sift_down(int i)
+{
+   while (true) {
+      const int left = 2 * i + 1;
+      const int right = left + 1;
+      int best = i;
+
+      if (left < ready_count && is_better_candidate(ready[left], ready[best]))
+         best = left;
+      if (right < ready_count && is_better_candidate(ready[right], ready[best]))
+         best = right;
+      if (best == i)
+         break;
+
+      ready_queue_swap(ready, i, best);
+      i = best;
+   }
+}
+
+void
+instruction_scheduler::ready_queue_push(schedule_node *n)
+{
+   assert(ready_count < ready_size);
+   update_candidate_key(n);
+   n->ready_index = ready_count;
+   ready[ready_count++] = n;
+   ready_queue_sift_up(n->ready_index);
+}
+
+void
+instruction_scheduler::ready_queue_update(schedule_node *n)
+{
+   assert(n->ready_index >= 0);
+   if (update_candidate_key(n)) {
+      ready_queue_sift_up(n->ready_index);
+      ready_queue_sift_down(n->ready_index);
+   }
+}
+
+schedule_node *
+instruction_scheduler::ready_queue_pop()
+{
+   assert(ready_count > 0);
+
+   /* The cached priority of the nodes in the queue may be better than their
+    * current one, so refresh the top of the heap until it's up to date.  At
+    * that point no other node can be better.
+    */
+   while (update_candidate_key(ready[0]))
+      ready_queue_sift_down(0);
+
+   schedule_node *n = ready[0];
+   n->ready_index = -1;
+
+   if (--ready_count > 0) {
+      ready[0] = ready[ready_count];
+      ready[0]->ready_index = 0;
+      ready_queue_sift_down(0);
+   }
+
+   return n;
+}
+
 void
 instruction_scheduler::schedule_instructions(bblock_t *block)
 {
@@ -1714,15 +2214,34 @@ instruction_scheduler::schedule_instructions(bblock_t *block)
       reg_pressure = reg_pressure_in[block->num];
    block_idx = block->num;
 
+   if (use_ready_queue) {
+      setup_ready_queue();
+
+      if (instructions_to_schedule > ready_size) {
+         ready_size = MAX2(instructions_to_schedule, 2 * ready_size);
+         ready = reralloc(mem_ctx, ready, schedule_node *, ready_size);
+      }
+      ready_count = 0;
+   }
+
    /* Remove non-DAG heads from the list. */
+   int cand_order = 0;
    foreach_in_list_safe(schedule_node, n, &instructions) {
-      if (n->parent_count != 0)
+      if (n->parent_count != 0) {
          n->remove();
+      } else if (use_ready_queue) {
+         n->cand_order = cand_order++;
+         ready_queue_push(n);
+      }
    }
 
+   /* Nodes which become available are added at the head of the list. */
+   cand_order = 0;
+
    unsigned cand_generation = 1;
    while (!instructions.is_empty()) {
-      schedule_node *chosen = choose_instruction_to_schedule();
+      schedule_node *chosen = use_ready_queue ? ready_queue_pop() :
+                                                choose_instruction_to_schedule();
 
       /* Schedule this instruction. */
       assert(chosen);
@@ -1779,6 +2298,11 @@ instruction_scheduler::schedule_instructions(bblock_t *block)
                fprintf(stderr, "\t\tnow available\n");
             }
             instructions.push_head(child);
+
+            if (use_ready_queue) {
+               child->cand_order = --cand_order;
+               ready_queue_push(child);
+            }
          }
       }
       cand_generation++;
@@ -1824,14 +2348,33 @@ instruction_scheduler::run(cfg_t *cfg)
             count_reads_remaining(inst);
       }
 
+      const int64_t start = debug ? os_time_get_nano() : 0;
+
       add_insts_from_block(block);
 
       calculate_deps();
 
       compute_delays();
+
+      pipeline_block = should_pipeline_block(block);
+      if (pipeline_block) {
+         compute_carried_delays();
+         compute_delays();
+
+         if (debug)
+            fprintf(stderr, "block %d: scheduled as pipelined loop\n",
+                    block->num);
+      }
+
       compute_exits();
 
       schedule_instructions(block);
+
+      if (debug) {
+         fprintf(stderr, "block %d: %d instructions scheduled in %" PRId64
+                 " ns\n", block->num, block->end_ip - block->start_ip + 1,
+                 os_time_get_nano() - start);
+      }
    }
 
    if (debug && !post_reg_alloc) {
@@ -1850,10 +2393,14 @@ fs_visitor::schedule_instructions(instruction_scheduler_mode mode)
    else
       grf_count = alloc.count;
 
+   const int64_t start = os_time_get_nano();
+
    fs_instruction_scheduler sched(this, grf_count, first_non_payload_grf,
                                   cfg->num_blocks, mode);
    sched.run(cfg);
 
+   shader_stats.schedule_time += os_time_get_nano() - start;
+
    invalidate_analysis(DEPENDENCY_INSTRUCTIONS);
 }
 
@@ -1273,9 +1273,18 @@ vec4_visitor::opt_register_coalesce()
       /* Can't coalesce this GRF if someone else was going to
        * read it later.
        */
-      if (live.var_range_end(var_from_reg(alloc, dst_reg(inst->src[0])), 8) > ip)
+      const unsigned src_var = var_from_reg(alloc, dst_reg(inst->src[0]));
+      if (live.var_range_end(src_var, 8) > ip)
 	 continue;
 
+      /* Nothing before the start of the live range of the GRF can write it,
+       * so there is no point in walking up the block any further than that
+       * looking for the remaining channels.  This keeps large straight-line
+       * shaders (such as geometry shaders emitting many vertices) from
+       * rescanning the whole block for every copy that can't be coalesced.
+       */
+      const int src_start = live.var_range_start(src_var, 8);
+
       /* We need to check interference with the final destination between this
        * instruction and the earliest instruction involved in writing the GRF
        * we're eliminating.  To do that, keep track of which of our source
@@ -1291,8 +1300,15 @@ vec4_visitor::opt_register_coalesce()
        * instead.
        */
       vec4_instruction *_scan_inst = (vec4_instruction *)inst->prev;
+      int scan_ip = ip;
       foreach_inst_in_block_reverse_starting_from(vec4_instruction, scan_inst,
                                                   inst) {
+         /* Instructions removed earlier in the pass only make this an upper
+          * bound of the IP the liveness analysis saw.
+          */
+         if (--scan_ip < src_start)
+            break;
+
          _scan_inst = scan_inst;
 
          if (regions_overlap(inst->src[0], inst->size_read(0),
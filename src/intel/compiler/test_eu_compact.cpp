@@ -24,6 +24,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <inttypes.h>
+#include "util/os_time.h"
 #include "util/ralloc.h"
 #include "brw_eu.h"
 #include "brw_gen_enum.h"
@@ -327,10 +329,45 @@ run_tests(const struct gen_device_info *devinfo)
    return fail;
 }
 
+/**
+ * Not a correctness test: measures how fast the instructions of all the tests
+ * above are compacted, so that changes to the table lookups can be compared.
+ * Only run when $EU_COMPACT_BENCH_ITERATIONS is set.
+ */
+static void
+run_benchmark(const struct gen_device_info *devinfo, unsigned iterations)
+{
+   struct brw_codegen *p = rzalloc(NULL, struct brw_codegen);
+   brw_init_codegen(devinfo, p, p);
+   brw_set_default_access_mode(p, BRW_ALIGN_1);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(tests); i++) {
+      if (tests[i].gens & gen_from_devinfo(devinfo))
+         tests[i].func(p);
+   }
+
+   unsigned compacted = 0;
+   int64_t start = os_time_get_nano();
+   for (unsigned iter = 0; iter < iterations; iter++) {
+      for (unsigned i = 0; i < p->nr_insn; i++) {
+         brw_compact_inst dst;
+         compacted += brw_try_compact_instruction(devinfo, &dst, &p->store[i]);
+      }
+   }
+   int64_t elapsed = os_time_get_nano() - start;
+
+   printf("gfx%d: %.1f ns per instruction (%u of %u compacted)\n",
+          devinfo->ver, (double)elapsed / (iterations * p->nr_insn),
+          compacted / iterations, p->nr_insn);
+
+   ralloc_free(p);
+}
+
 int
 main(UNUSED int argc, UNUSED char **argv)
 {
    struct gen_device_info *devinfo = (struct gen_device_info *)calloc(1, sizeof(*devinfo));
+   const char *bench_iterations = getenv("EU_COMPACT_BENCH_ITERATIONS");
    bool fail = false;
 
    for (devinfo->ver = 5; devinfo->ver <= 12; devinfo->ver++) {
@@ -339,6 +376,9 @@ main(UNUSED int argc, UNUSED char **argv)
 
       devinfo->verx10 = devinfo->ver * 10;
       fail |= run_tests(devinfo);
+
+      if (bench_iterations)
+         run_benchmark(devinfo, MAX2(atoi(bench_iterations), 1));
    }
 
    free(devinfo);
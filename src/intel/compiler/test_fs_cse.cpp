@@ -0,0 +1,274 @@
+/*
+ * Copyright © 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "brw_fs.h"
+#include "brw_cfg.h"
+#include "program/program.h"
+
+using namespace brw;
+
+class cse_test : public ::testing::Test {
+   virtual void SetUp();
+   virtual void TearDown();
+
+public:
+   struct brw_compiler *compiler;
+   struct gen_device_info *devinfo;
+   void *ctx;
+   struct brw_wm_prog_data *prog_data;
+   struct gl_shader_program *shader_prog;
+   fs_visitor *v;
+};
+
+class cse_fs_visitor : public fs_visitor
+{
+public:
+   cse_fs_visitor(struct brw_compiler *compiler,
+                  void *mem_ctx,
+                  struct brw_wm_prog_data *prog_data,
+                  nir_shader *shader)
+      : fs_visitor(compiler, NULL, mem_ctx, NULL,
+                   &prog_data->base, shader, 8, -1, false) {}
+};
+
+
+void cse_test::SetUp()
+{
+   ctx = ralloc_context(NULL);
+   compiler = rzalloc(ctx, struct brw_compiler);
+   devinfo = rzalloc(ctx, struct gen_device_info);
+   compiler->devinfo = devinfo;
+
+   prog_data = ralloc(ctx, struct brw_wm_prog_data);
+   nir_shader *shader =
+      nir_shader_create(ctx, MESA_SHADER_FRAGMENT, NULL, NULL);
+
+   v = new cse_fs_visitor(compiler, ctx, prog_data, shader);
+
+   devinfo->ver = 7;
+   devinfo->verx10 = devinfo->ver * 10;
+}
+
+void cse_test::TearDown()
+{
+   delete v;
+   v = NULL;
+
+   ralloc_free(ctx);
+   ctx = NULL;
+}
+
+static fs_inst *
+instruction(bblock_t *block, int num)
+{
+   fs_inst *inst = (fs_inst *)block->start();
+   for (int i = 0; i < num; i++) {
+      inst = (fs_inst *)inst->next;
+   }
+   return inst;
+}
+
+static bool
+cse(fs_visitor *v)
+{
+   const bool print = getenv("TEST_DEBUG");
+
+   if (print) {
+      fprintf(stderr, "= Before =\n");
+      v->cfg->dump();
+   }
+
+   bool ret = v->opt_cse();
+
+   if (print) {
+      fprintf(stderr, "\n= After =\n");
+      v->cfg->dump();
+   }
+
+   return ret;
+}
+
+TEST_F(cse_test, local_commuted)
+{
+   const fs_builder &bld = v->bld;
+   fs_reg dst0 = v->vgrf(glsl_type::float_type);
+   fs_reg dst1 = v->vgrf(glsl_type::float_type);
+   fs_reg src0 = v->vgrf(glsl_type::float_type);
+   fs_reg src1 = v->vgrf(glsl_type::float_type);
+   bld.ADD(dst0, src0, src1);
+   bld.ADD(dst1, src1, src0);
+
+   /* = Before =
+    *
+    * 0: add(8)        dst0  src0  src1
+    * 1: add(8)        dst1  src1  src0
+    *
+    * = After =
+    * 0: add(8)        tmp   src0  src1
+    * 1: mov(8)        dst0  tmp
+    * 2: mov(8)        dst1  tmp
+    */
+
+   v->calculate_cfg();
+   bblock_t *block0 = v->cfg->blocks[0];
+
+   EXPECT_EQ(0, block0->start_ip);
+   EXPECT_EQ(1, block0->end_ip);
+
+   EXPECT_TRUE(cse(v));
+   EXPECT_EQ(0, block0->start_ip);
+   EXPECT_EQ(2, block0->end_ip);
+
+   fs_inst *add = instruction(block0, 0);
+   EXPECT_EQ(BRW_OPCODE_ADD, add->opcode);
+   EXPECT_EQ(BRW_OPCODE_MOV, instruction(block0, 1)->opcode);
+   EXPECT_TRUE(instruction(block0, 1)->dst.equals(dst0));
+   EXPECT_TRUE(instruction(block0, 1)->src[0].equals(add->dst));
+   EXPECT_EQ(BRW_OPCODE_MOV, instruction(block0, 2)->opcode);
+   EXPECT_TRUE(instruction(block0, 2)->dst.equals(dst1));
+   EXPECT_TRUE(instruction(block0, 2)->src[0].equals(add->dst));
+}
+
+TEST_F(cse_test, global_dominating_block)
+{
+   const fs_builder &bld = v->bld;
+   fs_reg dst0 = v->vgrf(glsl_type::float_type);
+   fs_reg dst1 = v->vgrf(glsl_type::float_type);
+   fs_reg src0 = v->vgrf(glsl_type::float_type);
+   fs_reg src1 = v->vgrf(glsl_type::float_type);
+   bld.MOV(src0, brw_imm_f(1.0f));
+   bld.MOV(src1, brw_imm_f(2.0f));
+   bld.ADD(dst0, src0, src1);
+   bld.emit(BRW_OPCODE_IF);
+   bld.ADD(dst1, src0, src1);
+   bld.emit(BRW_OPCODE_ENDIF);
+
+   /* = Before =
+    *
+    * 0: mov(8)        src0  1.0f
+    * 1: mov(8)        src1  2.0f
+    * 2: add(8)        dst0  src0  src1
+    * 3: if(8)
+    * 4: add(8)        dst1  src0  src1
+    * 5: endif(8)
+    *
+    * = After =
+    * 0: mov(8)        src0  1.0f
+    * 1: mov(8)        src1  2.0f
+    * 2: add(8)        tmp   src0  src1
+    * 3: mov(8)        dst0  tmp
+    * 4: if(8)
+    * 5: mov(8)        dst1  tmp
+    * 6: endif(8)
+    */
+
+   v->calculate_cfg();
+   bblock_t *block0 = v->cfg->blocks[0];
+   bblock_t *block1 = v->cfg->blocks[1];
+
+   EXPECT_EQ(3, block0->end_ip);
+   EXPECT_EQ(4, block1->start_ip);
+   EXPECT_EQ(4, block1->end_ip);
+
+   EXPECT_TRUE(cse(v));
+   EXPECT_EQ(4, block0->end_ip);
+   EXPECT_EQ(5, block1->start_ip);
+   EXPECT_EQ(5, block1->end_ip);
+
+   fs_inst *add = instruction(block0, 2);
+   EXPECT_EQ(BRW_OPCODE_ADD, add->opcode);
+   EXPECT_EQ(BRW_OPCODE_MOV, instruction(block0, 3)->opcode);
+   EXPECT_TRUE(instruction(block0, 3)->dst.equals(dst0));
+
+   fs_inst *mov = instruction(block1, 0);
+   EXPECT_EQ(BRW_OPCODE_MOV, mov->opcode);
+   EXPECT_TRUE(mov->dst.equals(dst1));
+   EXPECT_TRUE(mov->src[0].equals(add->dst));
+}
+
+TEST_F(cse_test, global_non_dominating_block)
+{
+   const fs_builder &bld = v->bld;
+   fs_reg dst0 = v->vgrf(glsl_type::float_type);
+   fs_reg dst1 = v->vgrf(glsl_type::float_type);
+   fs_reg src0 = v->vgrf(glsl_type::float_type);
+   fs_reg src1 = v->vgrf(glsl_type::float_type);
+   bld.MOV(src0, brw_imm_f(1.0f));
+   bld.MOV(src1, brw_imm_f(2.0f));
+   bld.emit(BRW_OPCODE_IF);
+   bld.ADD(dst0, src0, src1);
+   bld.emit(BRW_OPCODE_ENDIF);
+   bld.ADD(dst1, src0, src1);
+
+   /* = Before =
+    *
+    * 0: mov(8)        src0  1.0f
+    * 1: mov(8)        src1  2.0f
+    * 2: if(8)
+    * 3: add(8)        dst0  src0  src1
+    * 4: endif(8)
+    * 5: add(8)        dst1  src0  src1
+    *
+    * = After =
+    * (no changes)
+    */
+
+   v->calculate_cfg();
+
+   EXPECT_FALSE(cse(v));
+}
+
+TEST_F(cse_test, global_redefined_source)
+{
+   const fs_builder &bld = v->bld;
+   fs_reg dst0 = v->vgrf(glsl_type::float_type);
+   fs_reg dst1 = v->vgrf(glsl_type::float_type);
+   fs_reg src0 = v->vgrf(glsl_type::float_type);
+   fs_reg src1 = v->vgrf(glsl_type::float_type);
+   bld.MOV(src0, brw_imm_f(1.0f));
+   bld.MOV(src1, brw_imm_f(2.0f));
+   bld.ADD(dst0, src0, src1);
+   bld.emit(BRW_OPCODE_IF);
+   bld.MOV(src0, brw_imm_f(3.0f));
+   bld.ADD(dst1, src0, src1);
+   bld.emit(BRW_OPCODE_ENDIF);
+
+   /* = Before =
+    *
+    * 0: mov(8)        src0  1.0f
+    * 1: mov(8)        src1  2.0f
+    * 2: add(8)        dst0  src0  src1
+    * 3: if(8)
+    * 4: mov(8)        src0  3.0f
+    * 5: add(8)        dst1  src0  src1
+    * 6: endif(8)
+    *
+    * = After =
+    * (no changes)
+    */
+
+   v->calculate_cfg();
+
+   EXPECT_FALSE(cse(v));
+}
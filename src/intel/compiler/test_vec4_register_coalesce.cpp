@@ -253,3 +253,28 @@ TEST_F(register_coalesce_test, test_channel_mul_grf)
 
    EXPECT_EQ(mul->dst.nr, to.nr);
 }
+
+TEST_F(register_coalesce_test, test_predicated_def)
+{
+   src_reg something = src_reg(v, glsl_type::float_type);
+   dst_reg temp = dst_reg(v, glsl_type::float_type);
+   dst_reg other = dst_reg(v, glsl_type::float_type);
+
+   dst_reg m0 = dst_reg(MRF, 0);
+   m0.writemask = WRITEMASK_X;
+   m0.type = BRW_REGISTER_TYPE_F;
+
+   /* Instructions before the live range of temp don't stop the scan from
+    * failing on the predicated write.
+    */
+   vec4_instruction *mul = v->emit(v->MUL(other, something, brw_imm_f(2.0f)));
+   v->emit(v->MOV(dst_reg(MRF, 1), src_reg(other)));
+   vec4_instruction *pred = v->emit(v->MUL(temp, something, brw_imm_f(1.0f)));
+   pred->predicate = BRW_PREDICATE_NORMAL;
+   v->emit(v->MOV(m0, src_reg(temp)));
+
+   register_coalesce(v);
+
+   EXPECT_EQ(pred->dst.file, VGRF);
+   EXPECT_EQ(mul->dst.file, MRF);
+}
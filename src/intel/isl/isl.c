@@ -26,6 +26,7 @@
 #include <stdio.h>
 
 #include "genxml/genX_bits.h"
+#include "util/u_cpu_detect.h"
 
 #include "isl.h"
 #include "isl_gfx4.h"
@@ -36,6 +37,15 @@
 #include "isl_gfx12.h"
 #include "isl_priv.h"
 
+#ifdef USE_AVX2
+static bool
+isl_memcpy_has_avx2(void)
+{
+   util_cpu_detect();
+   return util_get_cpu_caps()->has_avx2;
+}
+#endif
+
 void
 isl_memcpy_linear_to_tiled(uint32_t xt1, uint32_t xt2,
                            uint32_t yt1, uint32_t yt2,
@@ -45,6 +55,15 @@ isl_memcpy_linear_to_tiled(uint32_t xt1, uint32_t xt2,
                            enum isl_tiling tiling,
                            isl_memcpy_type copy_type)
 {
+#ifdef USE_AVX2
+   if (isl_memcpy_has_avx2()) {
+      _isl_memcpy_linear_to_tiled_avx2(
+         xt1, xt2, yt1, yt2, dst, src, dst_pitch, src_pitch, has_swizzling,
+         tiling, copy_type);
+      return;
+   }
+#endif
+
 #ifdef USE_SSE41
    if (copy_type == ISL_MEMCPY_STREAMING_LOAD) {
       _isl_memcpy_linear_to_tiled_sse41(
@@ -68,6 +87,15 @@ isl_memcpy_tiled_to_linear(uint32_t xt1, uint32_t xt2,
                            enum isl_tiling tiling,
                            isl_memcpy_type copy_type)
 {
+#ifdef USE_AVX2
+   if (isl_memcpy_has_avx2()) {
+      _isl_memcpy_tiled_to_linear_avx2(
+         xt1, xt2, yt1, yt2, dst, src, dst_pitch, src_pitch, has_swizzling,
+         tiling, copy_type);
+      return;
+   }
+#endif
+
 #ifdef USE_SSE41
    if (copy_type == ISL_MEMCPY_STREAMING_LOAD) {
       _isl_memcpy_tiled_to_linear_sse41(
@@ -36,7 +36,9 @@
 
 #include "isl_priv.h"
 
-#if defined(__SSSE3__)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
 #include <tmmintrin.h>
 #elif defined(__SSE2__)
 #include <emmintrin.h>
@@ -120,6 +122,24 @@ rgba8_copy_16_aligned_src(void *dst, const void *src)
                                      *(__m128i *)rgba8_permutation));
 }
 
+#ifdef __AVX2__
+static const uint8_t rgba8_permutation_32[32] =
+   { 2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15,
+     2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15 };
+
+/* The tiled side is only guaranteed to be 16-byte aligned, so these use
+ * unaligned accesses, which are as fast as aligned ones on AVX2 hardware
+ * when the data doesn't cross a cacheline.
+ */
+static inline void
+rgba8_copy_32(void *dst, const void *src)
+{
+   _mm256_storeu_si256(dst,
+                       _mm256_shuffle_epi8(_mm256_loadu_si256(src),
+                                           *(__m256i *)rgba8_permutation_32));
+}
+#endif
+
 #elif defined(__SSE2__)
 static inline void
 rgba8_copy_16_aligned_dst(void *dst, const void *src)
@@ -164,6 +184,15 @@ rgba8_copy_aligned_dst(void *dst, const void *src, size_t bytes)
 {
    assert(bytes == 0 || !(((uintptr_t)dst) & 0xf));
 
+#if defined(__AVX2__)
+   while (bytes >= 32) {
+      rgba8_copy_32(dst, src);
+      src += 32;
+      dst += 32;
+      bytes -= 32;
+   }
+#endif
+
 #if defined(__SSSE3__) || defined(__SSE2__)
    if (bytes == 64) {
       rgba8_copy_16_aligned_dst(dst +  0, src +  0);
@@ -194,6 +223,15 @@ rgba8_copy_aligned_src(void *dst, const void *src, size_t bytes)
 {
    assert(bytes == 0 || !(((uintptr_t)src) & 0xf));
 
+#if defined(__AVX2__)
+   while (bytes >= 32) {
+      rgba8_copy_32(dst, src);
+      src += 32;
+      dst += 32;
+      bytes -= 32;
+   }
+#endif
+
 #if defined(__SSSE3__) || defined(__SSE2__)
    if (bytes == 64) {
       rgba8_copy_16_aligned_src(dst +  0, src +  0);
@@ -578,6 +616,16 @@ _memcpy_streaming_load(void *dest, const void *src, size_t count)
       _mm_storeu_si128((__m128i *)dest, val);
       return dest;
    } else if (count == 64) {
+#if defined(INLINE_AVX2)
+      /* X tile spans are 64-byte aligned, which vmovntdqa on ymm needs. */
+      if (!(((uintptr_t)src) & 0x1f)) {
+         __m256i val0 = _mm256_stream_load_si256(((__m256i *)src) + 0);
+         __m256i val1 = _mm256_stream_load_si256(((__m256i *)src) + 1);
+         _mm256_storeu_si256(((__m256i *)dest) + 0, val0);
+         _mm256_storeu_si256(((__m256i *)dest) + 1, val1);
+         return dest;
+      }
+#endif
       __m128i val0 = _mm_stream_load_si128(((__m128i *)src) + 0);
       __m128i val1 = _mm_stream_load_si128(((__m128i *)src) + 1);
       __m128i val2 = _mm_stream_load_si128(((__m128i *)src) + 2);
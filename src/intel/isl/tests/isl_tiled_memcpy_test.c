@@ -0,0 +1,276 @@
+/*
+ * Copyright 2021 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Checks that the SIMD variants of the tiled memcpy functions produce the
+ * same results as the generic one, and measures their throughput when run
+ * with --bench.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "isl/isl.h"
+#include "isl/isl_priv.h"
+#include "util/os_time.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_math.h"
+
+// An asssert that works regardless of NDEBUG.
+#define t_assert(cond) \
+   do { \
+      if (!(cond)) { \
+         fprintf(stderr, "%s:%d: assertion failed\n", __FILE__, __LINE__); \
+         abort(); \
+      } \
+   } while (0)
+
+typedef void (*linear_to_tiled_fn)(uint32_t xt1, uint32_t xt2,
+                                   uint32_t yt1, uint32_t yt2,
+                                   char *dst, const char *src,
+                                   uint32_t dst_pitch, int32_t src_pitch,
+                                   bool has_swizzling,
+                                   enum isl_tiling tiling,
+                                   isl_memcpy_type copy_type);
+
+typedef void (*tiled_to_linear_fn)(uint32_t xt1, uint32_t xt2,
+                                   uint32_t yt1, uint32_t yt2,
+                                   char *dst, const char *src,
+                                   int32_t dst_pitch, uint32_t src_pitch,
+                                   bool has_swizzling,
+                                   enum isl_tiling tiling,
+                                   isl_memcpy_type copy_type);
+
+struct variant {
+   const char *name;
+   bool supported;
+   linear_to_tiled_fn linear_to_tiled;
+   tiled_to_linear_fn tiled_to_linear;
+};
+
+static struct variant variants[] = {
+   { "generic", true,
+     _isl_memcpy_linear_to_tiled, _isl_memcpy_tiled_to_linear },
+#ifdef USE_SSE41
+   { "sse41", false,
+     _isl_memcpy_linear_to_tiled_sse41, _isl_memcpy_tiled_to_linear_sse41 },
+#endif
+#ifdef USE_AVX2
+   { "avx2", false,
+     _isl_memcpy_linear_to_tiled_avx2, _isl_memcpy_tiled_to_linear_avx2 },
+#endif
+};
+
+static const char *copy_type_names[] = {
+   [ISL_MEMCPY] = "memcpy",
+   [ISL_MEMCPY_BGRA8] = "bgra8",
+   [ISL_MEMCPY_STREAMING_LOAD] = "streaming",
+};
+
+/* 4x4 tiles of either tiling. */
+#define SURF_PITCH (4 * 512)
+#define SURF_HEIGHT (4 * 32)
+#define SURF_SIZE (SURF_PITCH * SURF_HEIGHT)
+
+static void
+fill_random(char *data, size_t size)
+{
+   for (size_t i = 0; i < size; i++)
+      data[i] = rand();
+}
+
+static bool
+variant_supports(const struct variant *v, isl_memcpy_type copy_type)
+{
+   return v->supported &&
+          (copy_type != ISL_MEMCPY_STREAMING_LOAD ||
+           strcmp(v->name, "generic") != 0);
+}
+
+static void
+test_region(enum isl_tiling tiling, bool has_swizzling,
+            isl_memcpy_type copy_type,
+            uint32_t xt1, uint32_t xt2, uint32_t yt1, uint32_t yt2,
+            const char *linear, const char *tiled,
+            char *ref, char *out)
+{
+   const struct variant *generic = &variants[0];
+   const size_t linear_offset = (size_t)yt1 * SURF_PITCH + xt1;
+
+   /* Streaming loads only apply to reads from tiled memory. */
+   if (copy_type != ISL_MEMCPY_STREAMING_LOAD) {
+      memcpy(ref, tiled, SURF_SIZE);
+      generic->linear_to_tiled(xt1, xt2, yt1, yt2, ref,
+                               linear + linear_offset, SURF_PITCH,
+                               SURF_PITCH, has_swizzling, tiling, copy_type);
+
+      for (unsigned i = 1; i < ARRAY_SIZE(variants); i++) {
+         if (!variant_supports(&variants[i], copy_type))
+            continue;
+
+         memcpy(out, tiled, SURF_SIZE);
+         variants[i].linear_to_tiled(xt1, xt2, yt1, yt2, out,
+                                     linear + linear_offset, SURF_PITCH,
+                                     SURF_PITCH, has_swizzling, tiling,
+                                     copy_type);
+         t_assert(memcmp(ref, out, SURF_SIZE) == 0);
+      }
+   }
+
+   /* The generic variant has no streaming load path, plain memcpy gives the
+    * same result.
+    */
+   memcpy(ref, linear, SURF_SIZE);
+   generic->tiled_to_linear(xt1, xt2, yt1, yt2, ref + linear_offset, tiled,
+                            SURF_PITCH, SURF_PITCH, has_swizzling, tiling,
+                            copy_type == ISL_MEMCPY_STREAMING_LOAD ?
+                            ISL_MEMCPY : copy_type);
+
+   for (unsigned i = 1; i < ARRAY_SIZE(variants); i++) {
+      if (!variant_supports(&variants[i], copy_type))
+         continue;
+
+      memcpy(out, linear, SURF_SIZE);
+      variants[i].tiled_to_linear(xt1, xt2, yt1, yt2, out + linear_offset,
+                                  tiled, SURF_PITCH, SURF_PITCH,
+                                  has_swizzling, tiling, copy_type);
+      t_assert(memcmp(ref, out, SURF_SIZE) == 0);
+   }
+}
+
+static void
+test_variants(void)
+{
+   char *linear = aligned_alloc(64, SURF_SIZE);
+   char *tiled = aligned_alloc(64, SURF_SIZE);
+   char *ref = aligned_alloc(64, SURF_SIZE);
+   char *out = aligned_alloc(64, SURF_SIZE);
+
+   fill_random(linear, SURF_SIZE);
+   fill_random(tiled, SURF_SIZE);
+
+   const enum isl_tiling tilings[] = { ISL_TILING_X, ISL_TILING_Y0 };
+   const isl_memcpy_type copy_types[] = {
+      ISL_MEMCPY, ISL_MEMCPY_BGRA8, ISL_MEMCPY_STREAMING_LOAD,
+   };
+
+   for (unsigned t = 0; t < ARRAY_SIZE(tilings); t++) {
+      for (unsigned c = 0; c < ARRAY_SIZE(copy_types); c++) {
+         for (unsigned s = 0; s < 2; s++) {
+            /* The whole surface, then random regions in whole pixels. */
+            test_region(tilings[t], s, copy_types[c],
+                        0, SURF_PITCH, 0, SURF_HEIGHT,
+                        linear, tiled, ref, out);
+
+            for (unsigned i = 0; i < 200; i++) {
+               uint32_t xt1 = (rand() % (SURF_PITCH / 4)) * 4;
+               uint32_t xt2 = xt1 + (rand() % ((SURF_PITCH - xt1) / 4) + 1) * 4;
+               uint32_t yt1 = rand() % SURF_HEIGHT;
+               uint32_t yt2 = yt1 + rand() % (SURF_HEIGHT - yt1) + 1;
+
+               test_region(tilings[t], s, copy_types[c], xt1, xt2, yt1, yt2,
+                           linear, tiled, ref, out);
+            }
+         }
+      }
+   }
+
+   free(linear);
+   free(tiled);
+   free(ref);
+   free(out);
+}
+
+static void
+bench_variants(void)
+{
+   const uint32_t pitch = 16384, height = 4096;
+   const size_t size = (size_t)pitch * height;
+   const unsigned iterations = 8;
+
+   char *linear = aligned_alloc(64, size);
+   char *tiled = aligned_alloc(64, size);
+
+   fill_random(linear, size);
+   fill_random(tiled, size);
+
+   const enum isl_tiling tilings[] = { ISL_TILING_X, ISL_TILING_Y0 };
+   const char *tiling_names[] = { "X", "Y0" };
+
+   for (unsigned t = 0; t < ARRAY_SIZE(tilings); t++) {
+      for (unsigned c = ISL_MEMCPY; c <= ISL_MEMCPY_STREAMING_LOAD; c++) {
+         for (unsigned i = 0; i < ARRAY_SIZE(variants); i++) {
+            const struct variant *v = &variants[i];
+            if (!variant_supports(v, c))
+               continue;
+
+            double up_mbps = 0;
+            if (c != ISL_MEMCPY_STREAMING_LOAD) {
+               int64_t start = os_time_get_nano();
+               for (unsigned n = 0; n < iterations; n++) {
+                  v->linear_to_tiled(0, pitch, 0, height, tiled, linear,
+                                     pitch, pitch, false, tilings[t], c);
+               }
+               int64_t elapsed = os_time_get_nano() - start;
+               up_mbps = (double)size * iterations / elapsed * 1000.0;
+            }
+
+            int64_t start = os_time_get_nano();
+            for (unsigned n = 0; n < iterations; n++) {
+               v->tiled_to_linear(0, pitch, 0, height, linear, tiled,
+                                  pitch, pitch, false, tilings[t], c);
+            }
+            int64_t elapsed = os_time_get_nano() - start;
+            double down_mbps = (double)size * iterations / elapsed * 1000.0;
+
+            printf("tile %-2s %-9s %-7s linear->tiled %8.0f MB/s, "
+                   "tiled->linear %8.0f MB/s\n",
+                   tiling_names[t], copy_type_names[c], v->name,
+                   up_mbps, down_mbps);
+         }
+      }
+   }
+
+   free(linear);
+   free(tiled);
+}
+
+int main(int argc, char **argv)
+{
+   util_cpu_detect();
+
+   for (unsigned i = 1; i < ARRAY_SIZE(variants); i++) {
+      if (strcmp(variants[i].name, "sse41") == 0)
+         variants[i].supported = util_get_cpu_caps()->has_sse4_1;
+      else if (strcmp(variants[i].name, "avx2") == 0)
+         variants[i].supported = util_get_cpu_caps()->has_avx2;
+   }
+
+   test_variants();
+
+   if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+      bench_variants();
+
+   return 0;
+}
@@ -296,6 +296,12 @@ struct batch_window {
    struct aub_viewer_decode_cfg decode_cfg;
    struct aub_viewer_decode_ctx decode_ctx;
 
+   struct aub_viewer_batch_index index;
+
+   char search[64];
+   int search_row;
+   int focus_row;
+
    struct pml4_window pml4_window;
 
    char edit_address[20];
@@ -682,29 +688,19 @@ batch_get_bo(void *user_data, bool ppgtt, uint64_t address)
 }
 
 static void
-update_batch_window(struct batch_window *window, bool reset, int exec_idx)
-{
-   if (reset)
-      aub_mem_fini(&window->mem);
-   aub_mem_init(&window->mem);
-
-   window->exec_idx = MAX2(MIN2(context.file->n_execs - 1, exec_idx), 0);
-   update_mem_for_exec(&window->mem, context.file, window->exec_idx);
-}
-
-static void
-display_batch_ring_write(void *user_data, enum drm_i915_gem_engine_class engine,
-                         const void *data, uint32_t data_len)
+index_batch_ring_write(void *user_data, enum drm_i915_gem_engine_class engine,
+                       const void *data, uint32_t data_len)
 {
    struct batch_window *window = (struct batch_window *) user_data;
 
    window->uses_ppgtt = false;
 
-   aub_viewer_render_batch(&window->decode_ctx, data, data_len, 0, false);
+   aub_viewer_index_batch(&window->decode_ctx, &window->index,
+                          data, data_len, 0, false);
 }
 
 static void
-display_batch_execlist_write(void *user_data,
+index_batch_execlist_write(void *user_data,
                              enum drm_i915_gem_engine_class engine,
                              uint64_t context_descriptor)
 {
@@ -733,9 +729,50 @@ display_batch_execlist_write(void *user_data,
    window->uses_ppgtt = true;
 
    window->decode_ctx.engine = engine;
-   aub_viewer_render_batch(&window->decode_ctx, commands,
-                           MIN2(ring_buffer_tail - ring_buffer_head, ring_buffer_length),
-                           ring_buffer_start + ring_buffer_head, true);
+   aub_viewer_index_batch(&window->decode_ctx, &window->index, commands,
+                          MIN2(ring_buffer_tail - ring_buffer_head, ring_buffer_length),
+                          ring_buffer_start + ring_buffer_head, true);
+}
+
+static void
+update_batch_window(struct batch_window *window, bool reset, int exec_idx)
+{
+   if (reset) {
+      aub_mem_fini(&window->mem);
+      aub_viewer_batch_index_fini(&window->index);
+   }
+   aub_mem_init(&window->mem);
+   aub_viewer_batch_index_init(&window->index);
+
+   window->exec_idx = MAX2(MIN2(context.file->n_execs - 1, exec_idx), 0);
+   update_mem_for_exec(&window->mem, context.file, window->exec_idx);
+
+   /* Walk the batch once, rendering then only goes through the index. */
+   struct aub_read read = {};
+   read.user_data = window;
+   read.ring_write = index_batch_ring_write;
+   read.execlist_write = index_batch_execlist_write;
+
+   const uint8_t *iter = context.file->execs[window->exec_idx].start;
+   while (iter < context.file->execs[window->exec_idx].end) {
+      iter += aub_read_command(&read, iter,
+                               context.file->execs[window->exec_idx].end - iter);
+   }
+
+   window->search_row = -1;
+   window->focus_row = -1;
+}
+
+static void
+search_batch_window(struct batch_window *window, int dir)
+{
+   int row = aub_viewer_batch_index_find(&window->index, window->search,
+                                         window->search_row, dir);
+   if (row < 0)
+      return;
+
+   window->search_row = row;
+   window->focus_row = row;
 }
 
 static void
@@ -756,21 +793,25 @@ display_batch_window(struct window *win)
    if (window_has_ctrl_key('n'))
       update_batch_window(window, true, window->exec_idx + 1);
 
-   ImGui::Text("execbuf %i", window->exec_idx);
+   ImGui::PushItemWidth(ImGui::GetContentRegionAvailWidth() / 2);
+   if (ImGui::InputText("##search", window->search, sizeof(window->search),
+                        ImGuiInputTextFlags_EnterReturnsTrue))
+      search_batch_window(window, 1);
+   ImGui::PopItemWidth();
+   ImGui::SameLine();
+   if (ImGui::Button("Prev")) search_batch_window(window, -1);
+   ImGui::SameLine();
+   if (ImGui::Button("Next")) search_batch_window(window, 1);
+
+   ImGui::Text("execbuf %i, %u commands", window->exec_idx,
+               aub_viewer_batch_index_n_rows(&window->index));
    if (ImGui::Button("Show PPGTT")) { show_pml4_window(&window->pml4_window, &window->mem); }
 
    ImGui::BeginChild(ImGui::GetID("##block"));
 
-   struct aub_read read = {};
-   read.user_data = window;
-   read.ring_write = display_batch_ring_write;
-   read.execlist_write = display_batch_execlist_write;
-
-   const uint8_t *iter = context.file->execs[window->exec_idx].start;
-   while (iter < context.file->execs[window->exec_idx].end) {
-      iter += aub_read_command(&read, iter,
-                               context.file->execs[window->exec_idx].end - iter);
-   }
+   aub_viewer_render_batch(&window->decode_ctx, &window->index,
+                           window->focus_row);
+   window->focus_row = -1;
 
    ImGui::EndChild();
 }
@@ -781,6 +822,7 @@ destroy_batch_window(struct window *win)
    struct batch_window *window = (struct batch_window *) win;
 
    aub_mem_fini(&window->mem);
+   aub_viewer_batch_index_fini(&window->index);
 
    /* This works because children windows are inserted at the back of the
     * list, ensuring the deletion loop goes through the children after calling
@@ -6,6 +6,8 @@
 #include "common/intel_decoder.h"
 #include "common/intel_disasm.h"
 
+#include "util/u_dynarray.h"
+
 struct aub_viewer_cfg {
    ImColor clear_color;
    ImColor dwords_color;
@@ -86,6 +88,50 @@ struct aub_viewer_decode_ctx {
    int n_batch_buffer_start;
 };
 
+/* Decoder state a command sees when it is displayed, captured while indexing
+ * so that rows can be rendered in any order.
+ */
+struct aub_viewer_batch_state {
+   enum drm_i915_gem_engine_class engine;
+
+   uint64_t surface_base;
+   uint64_t dynamic_base;
+   uint64_t instruction_base;
+
+   uint32_t end_urb_offset;
+   struct aub_decode_urb_stage_state urb_stages[AUB_DECODE_N_STAGE];
+};
+
+enum aub_viewer_batch_row_type {
+   AUB_VIEWER_ROW_INSTRUCTION,
+   AUB_VIEWER_ROW_UNKNOWN_INSTRUCTION,
+   AUB_VIEWER_ROW_MISSING_BATCH,
+   AUB_VIEWER_ROW_MAX_JUMPS,
+};
+
+struct aub_viewer_batch_row {
+   enum aub_viewer_batch_row_type type;
+
+   const uint32_t *p;
+   uint64_t address;
+   struct intel_group *inst;
+   uint32_t length;
+
+   /* Index into aub_viewer_batch_index::states */
+   uint32_t state;
+
+   /* Height of the row the last time it was rendered, 0 if never */
+   float height;
+};
+
+/* Flattened list of the commands of a batch (following batch buffer jumps),
+ * built once so that each frame only decodes the rows that are visible.
+ */
+struct aub_viewer_batch_index {
+   struct util_dynarray rows;
+   struct util_dynarray states;
+};
+
 void aub_viewer_decode_ctx_init(struct aub_viewer_decode_ctx *ctx,
                                 struct aub_viewer_cfg *cfg,
                                 struct aub_viewer_decode_cfg *decode_cfg,
@@ -95,8 +141,26 @@ void aub_viewer_decode_ctx_init(struct aub_viewer_decode_ctx *ctx,
                                 unsigned (*get_state_size)(void *, uint32_t),
                                 void *user_data);
 
+void aub_viewer_batch_index_init(struct aub_viewer_batch_index *index);
+
+void aub_viewer_batch_index_fini(struct aub_viewer_batch_index *index);
+
+static inline unsigned
+aub_viewer_batch_index_n_rows(const struct aub_viewer_batch_index *index)
+{
+   return util_dynarray_num_elements(&index->rows, struct aub_viewer_batch_row);
+}
+
+void aub_viewer_index_batch(struct aub_viewer_decode_ctx *ctx,
+                            struct aub_viewer_batch_index *index,
+                            const void *batch, uint32_t batch_size,
+                            uint64_t batch_addr, bool from_ring);
+
+int aub_viewer_batch_index_find(const struct aub_viewer_batch_index *index,
+                                const char *str, int from_row, int dir);
+
 void aub_viewer_render_batch(struct aub_viewer_decode_ctx *ctx,
-                             const void *batch, uint32_t batch_size,
-                             uint64_t batch_addr, bool from_ring);
+                             struct aub_viewer_batch_index *index,
+                             int focus_row);
 
 #endif /* AUBINATOR_VIEWER_H */
@@ -894,17 +894,89 @@ struct custom_decoder info_decoders[] = {
 };
 
 void
-aub_viewer_render_batch(struct aub_viewer_decode_ctx *ctx,
-                        const void *_batch, uint32_t batch_size,
-                        uint64_t batch_addr, bool from_ring)
+aub_viewer_batch_index_init(struct aub_viewer_batch_index *index)
+{
+   util_dynarray_init(&index->rows, NULL);
+   util_dynarray_init(&index->states, NULL);
+}
+
+void
+aub_viewer_batch_index_fini(struct aub_viewer_batch_index *index)
+{
+   util_dynarray_fini(&index->rows);
+   util_dynarray_fini(&index->states);
+}
+
+static void
+index_save_state(struct aub_viewer_decode_ctx *ctx,
+                 struct aub_viewer_batch_index *index)
+{
+   struct aub_viewer_batch_state state;
+   memset(&state, 0, sizeof(state));
+   state.engine = ctx->engine;
+   state.surface_base = ctx->surface_base;
+   state.dynamic_base = ctx->dynamic_base;
+   state.instruction_base = ctx->instruction_base;
+   state.end_urb_offset = ctx->end_urb_offset;
+   memcpy(state.urb_stages, ctx->urb_stages, sizeof(state.urb_stages));
+
+   /* Most commands don't touch the decoder state, only store changes. */
+   if (index->states.size > 0 &&
+       memcmp(util_dynarray_top_ptr(&index->states, struct aub_viewer_batch_state),
+              &state, sizeof(state)) == 0)
+      return;
+
+   util_dynarray_append(&index->states, struct aub_viewer_batch_state, state);
+}
+
+static void
+index_restore_state(struct aub_viewer_decode_ctx *ctx,
+                    const struct aub_viewer_batch_index *index,
+                    uint32_t state_idx)
+{
+   const struct aub_viewer_batch_state *state =
+      util_dynarray_element(&index->states, struct aub_viewer_batch_state,
+                            state_idx);
+
+   ctx->engine = state->engine;
+   ctx->surface_base = state->surface_base;
+   ctx->dynamic_base = state->dynamic_base;
+   ctx->instruction_base = state->instruction_base;
+   ctx->end_urb_offset = state->end_urb_offset;
+   memcpy(ctx->urb_stages, state->urb_stages, sizeof(ctx->urb_stages));
+}
+
+static void
+index_add_row(struct aub_viewer_batch_index *index,
+              enum aub_viewer_batch_row_type type,
+              const uint32_t *p, uint64_t address,
+              struct intel_group *inst, uint32_t length)
+{
+   struct aub_viewer_batch_row row;
+   memset(&row, 0, sizeof(row));
+   row.type = type;
+   row.p = p;
+   row.address = address;
+   row.inst = inst;
+   row.length = length;
+   row.state = util_dynarray_num_elements(&index->states,
+                                          struct aub_viewer_batch_state) - 1;
+
+   util_dynarray_append(&index->rows, struct aub_viewer_batch_row, row);
+}
+
+static void
+index_batch(struct aub_viewer_decode_ctx *ctx,
+            struct aub_viewer_batch_index *index,
+            const void *_batch, uint32_t batch_size,
+            uint64_t batch_addr, bool from_ring)
 {
    struct intel_group *inst;
    const uint32_t *p, *batch = (const uint32_t *) _batch, *end = batch + batch_size / sizeof(uint32_t);
    int length;
 
    if (ctx->n_batch_buffer_start >= 100) {
-      ImGui::TextColored(ctx->cfg->error_color,
-                         "0x%08" PRIx64 ": Max batch buffer jumps exceeded", batch_addr);
+      index_add_row(index, AUB_VIEWER_ROW_MAX_JUMPS, batch, batch_addr, NULL, 0);
       return;
    }
 
@@ -919,9 +991,8 @@ aub_viewer_render_batch(struct aub_viewer_decode_ctx *ctx,
       uint64_t offset = batch_addr + ((char *)p - (char *)batch);
 
       if (inst == NULL) {
-         ImGui::TextColored(ctx->cfg->error_color,
-                            "0x%012" PRIx64 ": unknown instruction %012x",
-                            offset, p[0]);
+         index_add_row(index, AUB_VIEWER_ROW_UNKNOWN_INSTRUCTION,
+                       p, offset, NULL, 1);
          continue;
       }
 
@@ -931,32 +1002,12 @@ aub_viewer_render_batch(struct aub_viewer_decode_ctx *ctx,
          if (strcmp(inst_name, info_decoders[i].cmd_name) == 0) {
             ctx->stage = info_decoders[i].stage;
             info_decoders[i].decode(ctx, inst, p);
+            index_save_state(ctx, index);
             break;
          }
       }
 
-      if (ctx->decode_cfg->command_filter.PassFilter(inst->name) &&
-          ImGui::TreeNodeEx(p,
-                            ImGuiTreeNodeFlags_Framed,
-                            "0x%012" PRIx64 ":  %s",
-                            offset, inst->name)) {
-         aub_viewer_print_group(ctx, inst, offset, p);
-
-         for (unsigned i = 0; i < ARRAY_SIZE(display_decoders); i++) {
-            if (strcmp(inst_name, display_decoders[i].cmd_name) == 0) {
-               ctx->stage = display_decoders[i].stage;
-               display_decoders[i].decode(ctx, inst, p);
-               break;
-            }
-         }
-
-         if (ctx->edit_address) {
-            if (ImGui::Button("Edit instruction"))
-               ctx->edit_address(ctx->user_data, offset, length * 4);
-         }
-
-         ImGui::TreePop();
-      }
+      index_add_row(index, AUB_VIEWER_ROW_INSTRUCTION, p, offset, inst, length);
 
       if (strcmp(inst_name, "MI_BATCH_BUFFER_START") == 0) {
          uint64_t next_batch_addr = 0xd0d0d0d0;
@@ -977,12 +1028,11 @@ aub_viewer_render_batch(struct aub_viewer_decode_ctx *ctx,
          struct intel_batch_decode_bo next_batch = ctx_get_bo(ctx, ppgtt, next_batch_addr);
 
          if (next_batch.map == NULL) {
-            ImGui::TextColored(ctx->cfg->missing_color,
-                               "Secondary batch at 0x%012" PRIx64 " unavailable",
-                               next_batch_addr);
+            index_add_row(index, AUB_VIEWER_ROW_MISSING_BATCH,
+                          NULL, next_batch_addr, NULL, 0);
          } else {
-            aub_viewer_render_batch(ctx, next_batch.map, next_batch.size,
-                                    next_batch.addr, false);
+            index_batch(ctx, index, next_batch.map, next_batch.size,
+                        next_batch.addr, false);
          }
          if (second_level) {
             /* MI_BATCH_BUFFER_START with "2nd Level Batch Buffer" set acts
@@ -1006,3 +1056,164 @@ aub_viewer_render_batch(struct aub_viewer_decode_ctx *ctx,
 
    ctx->n_batch_buffer_start--;
 }
+
+void
+aub_viewer_index_batch(struct aub_viewer_decode_ctx *ctx,
+                       struct aub_viewer_batch_index *index,
+                       const void *batch, uint32_t batch_size,
+                       uint64_t batch_addr, bool from_ring)
+{
+   /* Rows added before any state change refer to the state at the start of
+    * the batch.
+    */
+   index_save_state(ctx, index);
+   index_batch(ctx, index, batch, batch_size, batch_addr, from_ring);
+}
+
+static bool
+row_matches(const struct aub_viewer_batch_row *row, const char *str,
+            bool is_address, uint64_t address)
+{
+   if (is_address) {
+      return row->p != NULL &&
+             address >= row->address &&
+             address < row->address + 4 * row->length;
+   }
+
+   return row->inst != NULL && strcasestr(row->inst->name, str) != NULL;
+}
+
+int
+aub_viewer_batch_index_find(const struct aub_viewer_batch_index *index,
+                            const char *str, int from_row, int dir)
+{
+   const int n_rows = aub_viewer_batch_index_n_rows(index);
+
+   if (str[0] == '\0' || n_rows == 0)
+      return -1;
+
+   /* Anything starting with 0x is looked up as an address within the batch,
+    * everything else as part of an instruction name.
+    */
+   char *end;
+   uint64_t address = 0;
+   bool is_address = strncmp(str, "0x", 2) == 0;
+   if (is_address) {
+      address = strtoull(str, &end, 16);
+      if (*end != '\0')
+         return -1;
+   }
+
+   if (from_row < 0)
+      from_row = dir > 0 ? -1 : 0;
+
+   for (int i = 1; i <= n_rows; i++) {
+      int row_idx = ((from_row + dir * i) % n_rows + n_rows) % n_rows;
+      const struct aub_viewer_batch_row *row =
+         util_dynarray_element(&index->rows, struct aub_viewer_batch_row,
+                               row_idx);
+
+      if (row_matches(row, str, is_address, address))
+         return row_idx;
+   }
+
+   return -1;
+}
+
+static void
+render_row(struct aub_viewer_decode_ctx *ctx,
+           const struct aub_viewer_batch_index *index,
+           const struct aub_viewer_batch_row *row)
+{
+   switch (row->type) {
+   case AUB_VIEWER_ROW_MAX_JUMPS:
+      ImGui::TextColored(ctx->cfg->error_color,
+                         "0x%08" PRIx64 ": Max batch buffer jumps exceeded",
+                         row->address);
+      return;
+   case AUB_VIEWER_ROW_MISSING_BATCH:
+      ImGui::TextColored(ctx->cfg->missing_color,
+                         "Secondary batch at 0x%012" PRIx64 " unavailable",
+                         row->address);
+      return;
+   case AUB_VIEWER_ROW_UNKNOWN_INSTRUCTION:
+      ImGui::TextColored(ctx->cfg->error_color,
+                         "0x%012" PRIx64 ": unknown instruction %012x",
+                         row->address, row->p[0]);
+      return;
+   case AUB_VIEWER_ROW_INSTRUCTION:
+      break;
+   }
+
+   struct intel_group *inst = row->inst;
+   const char *inst_name = intel_group_get_name(inst);
+
+   if (!ImGui::TreeNodeEx(row->p,
+                          ImGuiTreeNodeFlags_Framed,
+                          "0x%012" PRIx64 ":  %s",
+                          row->address, inst->name))
+      return;
+
+   index_restore_state(ctx, index, row->state);
+
+   aub_viewer_print_group(ctx, inst, row->address, row->p);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(display_decoders); i++) {
+      if (strcmp(inst_name, display_decoders[i].cmd_name) == 0) {
+         ctx->stage = display_decoders[i].stage;
+         display_decoders[i].decode(ctx, inst, row->p);
+         break;
+      }
+   }
+
+   if (ctx->edit_address) {
+      if (ImGui::Button("Edit instruction"))
+         ctx->edit_address(ctx->user_data, row->address, row->length * 4);
+   }
+
+   ImGui::TreePop();
+}
+
+void
+aub_viewer_render_batch(struct aub_viewer_decode_ctx *ctx,
+                        struct aub_viewer_batch_index *index,
+                        int focus_row)
+{
+   const float view_start = ImGui::GetScrollY();
+   const float view_end = view_start + ImGui::GetWindowHeight();
+   const float text_height = ImGui::GetTextLineHeightWithSpacing();
+   const float node_height = ImGui::GetFrameHeightWithSpacing();
+   float y = ImGui::GetCursorPosY();
+   int row_idx = 0;
+
+   util_dynarray_foreach(&index->rows, struct aub_viewer_batch_row, row) {
+      bool focused = row_idx++ == focus_row;
+
+      if (!focused && row->inst != NULL &&
+          !ctx->decode_cfg->command_filter.PassFilter(row->inst->name))
+         continue;
+
+      /* Rows outside of the view only take up space. Rows that have never
+       * been rendered are assumed to be collapsed.
+       */
+      float height = row->height;
+      if (height == 0.0f)
+         height = row->type == AUB_VIEWER_ROW_INSTRUCTION ? node_height : text_height;
+
+      if (!focused && (y + height < view_start || y > view_end)) {
+         y += height;
+         continue;
+      }
+
+      if (focused)
+         ImGui::SetScrollFromPosY(y - view_start, 0.25f);
+
+      ImGui::SetCursorPosY(y);
+      render_row(ctx, index, row);
+      row->height = ImGui::GetCursorPosY() - y;
+      y += row->height;
+   }
+
+   /* Extend the scrolling region over the skipped rows at the end. */
+   ImGui::SetCursorPosY(y);
+}
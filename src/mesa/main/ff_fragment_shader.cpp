@@ -51,6 +51,7 @@
 #include "program/prog_print.h"
 #include "program/prog_statevars.h"
 #include "util/bitscan.h"
+#include "util/mesa-sha1.h"
 
 using namespace ir_builder;
 
@@ -1028,8 +1029,36 @@ emit_instructions(texenv_fragment_program *p)
  * Generate a new fragment program which implements the context's
  * current texture env/combine mode.
  */
+/**
+ * Compute the sha1 of the fragment shader generated for \p key, which is
+ * used instead of the hash of the source by the shader cache.
+ */
+static void
+compute_shader_sha1(struct gl_context *ctx, const struct state_key *key,
+                    GLuint keySize, unsigned char *sha1)
+{
+   struct mesa_sha1 sha1_ctx;
+   static const char tag[] = "ff_fragment_shader";
+   const bool egl_image_external =
+      _mesa_is_gles(ctx) && ctx->Extensions.OES_EGL_image_external;
+
+   _mesa_sha1_init(&sha1_ctx);
+   _mesa_sha1_update(&sha1_ctx, tag, sizeof(tag));
+   _mesa_sha1_update(&sha1_ctx, key, keySize);
+   _mesa_sha1_update(&sha1_ctx, &ctx->Const.MaxTextureUnits,
+                     sizeof(ctx->Const.MaxTextureUnits));
+   _mesa_sha1_update(&sha1_ctx, &ctx->Const.GLSLOptimizeConservatively,
+                     sizeof(ctx->Const.GLSLOptimizeConservatively));
+   _mesa_sha1_update(&sha1_ctx, &ctx->Const.NativeIntegers,
+                     sizeof(ctx->Const.NativeIntegers));
+   _mesa_sha1_update(&sha1_ctx, &egl_image_external,
+                     sizeof(egl_image_external));
+   _mesa_sha1_final(&sha1_ctx, sha1);
+}
+
 static struct gl_shader_program *
-create_new_program(struct gl_context *ctx, struct state_key *key)
+create_new_program(struct gl_context *ctx, struct state_key *key,
+                   GLuint keySize)
 {
    texenv_fragment_program p;
    unsigned int unit;
@@ -1049,6 +1078,12 @@ create_new_program(struct gl_context *ctx, struct state_key *key)
    p.state = key;
    p.shader_program = _mesa_new_shader_program(0);
 
+   /* The generated program only depends on the state, so it can be found
+    * in the shader cache by the state key instead of the source.
+    */
+   p.shader_program->IsFixedFunction = true;
+   compute_shader_sha1(ctx, key, keySize, p.shader->sha1);
+
    /* Tell the linker to ignore the fact that we're building a
     * separate shader, in case we're in a GLES2 context that would
     * normally reject that.  The real problem is that we're building a
@@ -1145,7 +1180,7 @@ _mesa_get_fixed_func_fragment_program(struct gl_context *ctx)
                                  &key, keySize);
 
    if (!shader_program) {
-      shader_program = create_new_program(ctx, &key);
+      shader_program = create_new_program(ctx, &key, keySize);
 
       _mesa_shader_cache_insert(ctx, ctx->FragmentProgram.Cache,
 				&key, keySize, shader_program);
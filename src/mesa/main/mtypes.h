@@ -3043,6 +3043,12 @@ struct gl_shader_program
     */
    GLboolean SeparateShader;
 
+   /**
+    * Whether this is a fixed-function fragment program generated by Mesa.
+    * Its shader has no source, the sha1 is computed from the state key.
+    */
+   bool IsFixedFunction;
+
    GLuint NumShaders;          /**< number of attached shaders */
    struct gl_shader **Shaders; /**< List of attached the shaders */
 
@@ -3171,6 +3177,7 @@ struct gl_shader_program
 #define GLSL_DUMP_ON_ERROR 0x80 /**< Dump shaders to stderr on compile error */
 #define GLSL_CACHE_INFO 0x100 /**< Print debug information about shader cache */
 #define GLSL_CACHE_FALLBACK 0x200 /**< Force shader cache fallback paths */
+#define GLSL_LINK_TIME 0x400 /**< Print the time spent in each link phase */
 
 
 /**
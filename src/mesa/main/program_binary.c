@@ -199,7 +199,7 @@ read_program_payload(struct gl_context *ctx, struct blob_reader *blob,
 {
    sh_prog->SeparateShader = blob_read_uint32(blob);
 
-   if (!deserialize_glsl_program(blob, ctx, sh_prog))
+   if (!deserialize_glsl_program(blob, ctx, sh_prog, false))
       return false;
 
    unsigned int stage;
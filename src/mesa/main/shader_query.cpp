@@ -568,6 +568,29 @@ compute_resource_key(GLenum programInterface, const char *name, size_t len)
    return _mesa_hash_data_with_seed(name, len, programInterface + len);
 }
 
+static struct gl_program_resource *
+lookup_resource_hash(struct gl_shader_program *shProg,
+                     GLenum programInterface, const char *name, size_t len)
+{
+   uint32_t key = compute_resource_key(programInterface, name, len);
+   struct gl_program_resource *res = (struct gl_program_resource *)
+      _mesa_hash_table_u64_search(shProg->data->ProgramResourceHash, key);
+
+   /* The key is only a hash of the name, so check for collisions. Array
+    * blocks are also inserted under their name without the "[0]".
+    */
+   if (res) {
+      const char *rname = _mesa_program_resource_name(res);
+      bool is_block = programInterface == GL_UNIFORM_BLOCK ||
+                      programInterface == GL_SHADER_STORAGE_BLOCK;
+      if (res->Type != programInterface || strncmp(rname, name, len) ||
+          (rname[len] != '\0' && (!is_block || strcmp(rname + len, "[0]"))))
+         return NULL;
+   }
+
+   return res;
+}
+
 static struct gl_program_resource *
 search_resource_hash(struct gl_shader_program *shProg,
                      GLenum programInterface, const char *name,
@@ -575,28 +598,29 @@ search_resource_hash(struct gl_shader_program *shProg,
 {
    const char *base_name_end;
    size_t len = strlen(name);
-   long index = parse_program_resource_name(name, len, &base_name_end);
-   char *name_copy;
 
-   /* If dealing with array, we need to get the basename. */
-   if (index >= 0) {
-      name_copy = (char *) malloc(base_name_end - name + 1);
-      memcpy(name_copy, name, base_name_end - name);
-      name_copy[base_name_end - name] = '\0';
-      len = base_name_end - name;
-   } else {
-      name_copy = (char*) name;
+   struct gl_program_resource *res =
+      lookup_resource_hash(shProg, programInterface, name, len);
+   if (res) {
+      if (array_index)
+         *array_index = 0;
+      return res;
    }
 
-   uint32_t key = compute_resource_key(programInterface, name_copy, len);
-   struct gl_program_resource *res = (struct gl_program_resource *)
-      _mesa_hash_table_u64_search(shProg->data->ProgramResourceHash, key);
+   /* Each element of a block array is a separate resource. */
+   if (programInterface == GL_UNIFORM_BLOCK ||
+       programInterface == GL_SHADER_STORAGE_BLOCK)
+      return NULL;
 
-   if (name_copy != name)
-      free(name_copy);
+   /* If dealing with array, we need to get the basename. */
+   long index = parse_program_resource_name(name, len, &base_name_end);
+   if (index < 0)
+      return NULL;
 
+   res = lookup_resource_hash(shProg, programInterface, name,
+                              base_name_end - name);
    if (res && array_index)
-      *array_index = index >= 0 ? index : 0;
+      *array_index = index;
 
    return res;
 }
@@ -1959,9 +1983,19 @@ _mesa_create_program_resource_hash(struct gl_shader_program *shProg)
    for (unsigned i = 0; i < shProg->data->NumProgramResourceList; i++, res++) {
       const char *name = _mesa_program_resource_name(res);
       if (name) {
-         uint32_t key = compute_resource_key(res->Type, name, strlen(name));
+         size_t len = strlen(name);
+         uint32_t key = compute_resource_key(res->Type, name, len);
          _mesa_hash_table_u64_insert(shProg->data->ProgramResourceHash, key,
                                      res);
+
+         /* Block arrays are also found by their name without "[0]". */
+         if ((res->Type == GL_UNIFORM_BLOCK ||
+              res->Type == GL_SHADER_STORAGE_BLOCK) &&
+             len > 3 && !strcmp(name + len - 3, "[0]")) {
+            key = compute_resource_key(res->Type, name, len - 3);
+            _mesa_hash_table_u64_insert(shProg->data->ProgramResourceHash,
+                                        key, res);
+         }
       }
    }
 }
@@ -96,6 +96,8 @@ _mesa_get_shader_flags(void)
          flags |= GLSL_USE_PROG;
       if (strstr(env, "errors"))
          flags |= GLSL_REPORT_ERRORS;
+      if (strstr(env, "link_time"))
+         flags |= GLSL_LINK_TIME;
    }
 
    return flags;
@@ -36,8 +36,11 @@
 #include "texcompress_astc.h"
 #include "macros.h"
 #include "util/half_float.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
 #include <stdio.h>
 #include <cstdlib>  // for abort() on windows
+#include <vector>
 
 static bool VERBOSE_DECODE = false;
 static bool VERBOSE_WRITE = false;
@@ -48,6 +51,21 @@ uint16_div_64k_to_half_to_unorm8(uint16_t v)
    return _mesa_half_to_unorm8(_mesa_uint16_div_64k_to_half(v));
 }
 
+/* The UNORM8 conversion of the interpolated colours, with 65535 mapping to
+ * 0xff. Going through half floats for every channel of every texel is the
+ * most expensive part of writing the decoded blocks.
+ */
+static uint8_t unorm16_to_unorm8_table[65536];
+static once_flag unorm16_to_unorm8_once = ONCE_FLAG_INIT;
+
+static void
+init_unorm16_to_unorm8_table(void)
+{
+   for (unsigned v = 0; v < 65535; ++v)
+      unorm16_to_unorm8_table[v] = uint16_div_64k_to_half_to_unorm8(v);
+   unorm16_to_unorm8_table[65535] = 0xff;
+}
+
 class decode_error
 {
 public:
@@ -539,17 +557,45 @@ struct OutputBitVector
 };
 
 
+/* How a texel is interpolated from the 2x2 weights around it. */
+struct infill_texel
+{
+   uint8_t v0; /* index of the top left weight */
+   uint8_t w00, w01, w10, w11;
+};
+
 class Decoder
 {
 public:
    Decoder(int block_w, int block_h, int block_d, bool srgb, bool output_unorm8)
       : block_w(block_w), block_h(block_h), block_d(block_d), srgb(srgb),
-        output_unorm8(output_unorm8) {}
+        output_unorm8(output_unorm8)
+   {
+      if (block_d == 1)
+         init_infill_tables();
+      if (output_unorm8)
+         call_once(&unorm16_to_unorm8_once, init_unorm16_to_unorm8_table);
+   }
 
    decode_error::type decode(const uint8_t *in, uint16_t *output) const;
 
+   /* Only valid for 2D blocks, and weight grids which fit in the block. */
+   const infill_texel *get_infill_table(int wt_w, int wt_h) const
+   {
+      assert(!infill_tables.empty());
+      assert(wt_w >= 2 && wt_w <= block_w && wt_h >= 2 && wt_h <= block_h);
+      int table = (wt_h - 2) * (block_w - 1) + (wt_w - 2);
+      return &infill_tables[table * block_w * block_h];
+   }
+
    int block_w, block_h, block_d;
    bool srgb, output_unorm8;
+
+private:
+   void init_infill_tables();
+
+   /* Calculated by init_infill_tables(), one table per weight grid size */
+   std::vector<infill_texel> infill_tables;
 };
 
 struct Block
@@ -638,11 +684,45 @@ struct Block
    void decode_colour_endpoints();
    void unpack_weights(InputBitVector in);
    void compute_infill_weights(int block_w, int block_h, int block_d);
+   void compute_infill_weights_2d(const infill_texel *table, int num_texels);
 
    void write_decoded(const Decoder &decoder, uint16_t *output);
 };
 
 
+/* The same interpolation as Block::compute_infill_weights(), for every
+ * weight grid size a 2D block of this size can have.
+ */
+void Decoder::init_infill_tables()
+{
+   int Ds = (1024 + block_w / 2) / (block_w - 1);
+   int Dt = (1024 + block_h / 2) / (block_h - 1);
+
+   infill_tables.resize((block_w - 1) * (block_h - 1) * block_w * block_h);
+
+   for (int wt_h = 2; wt_h <= block_h; ++wt_h) {
+      for (int wt_w = 2; wt_w <= block_w; ++wt_w) {
+         infill_texel *table = &infill_tables[((wt_h - 2) * (block_w - 1) +
+                                               (wt_w - 2)) * block_w * block_h];
+         for (int t = 0; t < block_h; ++t) {
+            for (int s = 0; s < block_w; ++s) {
+               int gs = (Ds * s * (wt_w - 1) + 32) >> 6;
+               int gt = (Dt * t * (wt_h - 1) + 32) >> 6;
+               int fs = gs & 0xf;
+               int ft = gt & 0xf;
+               infill_texel &texel = table[s + t * block_w];
+
+               texel.v0 = (gs >> 4) + (gt >> 4) * wt_w;
+               texel.w11 = (fs * ft + 8) >> 4;
+               texel.w10 = ft - texel.w11;
+               texel.w01 = fs - texel.w11;
+               texel.w00 = 16 - fs - ft + texel.w11;
+            }
+         }
+      }
+   }
+}
+
 decode_error::type Decoder::decode(const uint8_t *in, uint16_t *output) const
 {
    Block blk;
@@ -1327,6 +1407,33 @@ void Block::compute_infill_weights(int block_w, int block_h, int block_d)
    }
 }
 
+void Block::compute_infill_weights_2d(const infill_texel *table, int num_texels)
+{
+   if (dual_plane) {
+      for (int i = 0; i < num_texels; ++i) {
+         const infill_texel &texel = table[i];
+         int v0 = texel.v0;
+         for (int plane = 0; plane < 2; ++plane) {
+            infill_weights[plane][i] =
+               (weights[v0 * 2 + plane] * texel.w00 +
+                weights[(v0 + 1) * 2 + plane] * texel.w01 +
+                weights[(v0 + wt_w) * 2 + plane] * texel.w10 +
+                weights[(v0 + wt_w + 1) * 2 + plane] * texel.w11 + 8) >> 4;
+         }
+      }
+   } else {
+      for (int i = 0; i < num_texels; ++i) {
+         const infill_texel &texel = table[i];
+         int v0 = texel.v0;
+         infill_weights[0][i] =
+            (weights[v0] * texel.w00 +
+             weights[v0 + 1] * texel.w01 +
+             weights[v0 + wt_w] * texel.w10 +
+             weights[v0 + wt_w + 1] * texel.w11 + 8) >> 4;
+      }
+   }
+}
+
 void Block::unquantise_colour_endpoints()
 {
    assert(num_cem_values <= (int)ARRAY_SIZE(colour_endpoints_quant));
@@ -1580,7 +1687,12 @@ decode_error::type Block::decode(const Decoder &decoder, InputBitVector in)
       }
    }
 
-   compute_infill_weights(decoder.block_w, decoder.block_h, decoder.block_d);
+   if (decoder.block_d == 1) {
+      compute_infill_weights_2d(decoder.get_infill_table(wt_w, wt_h),
+                                decoder.block_w * decoder.block_h);
+   } else {
+      compute_infill_weights(decoder.block_w, decoder.block_h, decoder.block_d);
+   }
 
    if (VERBOSE_DECODE) {
       for (int plane = 0; plane <= dual_plane; ++plane) {
@@ -1704,11 +1816,11 @@ void Block::write_decoded(const Decoder &decoder, uint16_t *output)
                   output[idx*4+1] = c[1] >> 8;
                   output[idx*4+2] = c[2] >> 8;
                } else {
-                  output[idx*4+0] = c[0] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[0]);
-                  output[idx*4+1] = c[1] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[1]);
-                  output[idx*4+2] = c[2] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[2]);
+                  output[idx*4+0] = unorm16_to_unorm8_table[c[0]];
+                  output[idx*4+1] = unorm16_to_unorm8_table[c[1]];
+                  output[idx*4+2] = unorm16_to_unorm8_table[c[2]];
                }
-               output[idx*4+3] = c[3] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[3]);
+               output[idx*4+3] = unorm16_to_unorm8_table[c[3]];
             } else {
                /* Store the color as FP16. */
                output[idx*4+0] = c[0] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[0]);
@@ -1814,9 +1926,123 @@ decode_error::type Block::calculate_colour_endpoints_size()
    return decode_error::invalid_colour_endpoints_size;
 }
 
+/* Textures with fewer blocks than this are decoded by the calling thread. */
+#define ASTC_MIN_BLOCKS_PER_JOB 1024
+#define ASTC_MAX_DECODE_JOBS 16
+
+struct astc_decode_job
+{
+   struct util_queue_fence fence;
+   const Decoder *dec;
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const uint8_t *src_row;
+   unsigned src_stride;
+   unsigned src_width;
+   unsigned src_height;
+   unsigned first_row; /* in blocks */
+   unsigned num_rows;
+};
+
+static struct util_queue astc_decode_queue;
+static bool astc_decode_queue_initialized;
+static once_flag astc_decode_queue_once = ONCE_FLAG_INIT;
+
+static void
+init_astc_decode_queue(void)
+{
+   util_cpu_detect();
+
+   /* The calling thread decodes a part of the texture too. */
+   int num_threads = MIN2(util_get_cpu_caps()->nr_cpus - 1,
+                          ASTC_MAX_DECODE_JOBS - 1);
+   if (num_threads < 1)
+      return;
+
+   astc_decode_queue_initialized =
+      util_queue_init(&astc_decode_queue, "astc", ASTC_MAX_DECODE_JOBS,
+                      num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+}
+
+/* Recently decoded blocks, so that repeated blocks (e.g. the solid colour
+ * areas of atlases) are only decoded once.
+ */
+#define ASTC_BLOCK_CACHE_SIZE 64
+
+struct astc_block_cache_entry
+{
+   uint8_t block[16];
+   bool valid;
+   uint8_t texels[12 * 12 * 4];
+};
+
+static inline unsigned
+astc_block_cache_index(const uint8_t *block)
+{
+   uint32_t words[4];
+   memcpy(words, block, sizeof(words));
+   uint32_t hash = (words[0] ^ words[1] ^ words[2] ^ words[3]) * 2654435761u;
+   return hash >> 26;
+}
+
+static void
+decode_astc_rows(void *data, int thread_index)
+{
+   const astc_decode_job *job = (const astc_decode_job *)data;
+   const Decoder &dec = *job->dec;
+   const unsigned block_size = 16;
+   unsigned blk_w = dec.block_w, blk_h = dec.block_h;
+   unsigned x_blocks = (job->src_width + blk_w - 1) / blk_w;
+
+   STATIC_ASSERT(ASTC_BLOCK_CACHE_SIZE == 1 << 6);
+   astc_block_cache_entry *cache = (astc_block_cache_entry *)
+      calloc(ASTC_BLOCK_CACHE_SIZE, sizeof(*cache));
+   astc_block_cache_entry uncached;
+
+   const uint8_t *src_row = job->src_row + job->first_row * job->src_stride;
+   uint8_t *dst_row = job->dst_row + job->first_row * job->dst_stride * blk_h;
+
+   for (unsigned y = job->first_row; y < job->first_row + job->num_rows; ++y) {
+      for (unsigned x = 0; x < x_blocks; ++x) {
+         const uint8_t *block = src_row + x * block_size;
+         astc_block_cache_entry *entry =
+            cache ? &cache[astc_block_cache_index(block)] : &uncached;
+
+         if (entry == &uncached || !entry->valid ||
+             memcmp(entry->block, block, block_size)) {
+            /* Same size as the largest block. */
+            uint16_t block_out[12 * 12 * 4];
+
+            dec.decode(block, block_out);
+
+            for (unsigned i = 0; i < blk_w * blk_h * 4; ++i)
+               entry->texels[i] = block_out[i];
+            memcpy(entry->block, block, block_size);
+            entry->valid = true;
+         }
+
+         /* This can be smaller with NPOT dimensions. */
+         unsigned dst_blk_w = MIN2(blk_w, job->src_width  - x*blk_w);
+         unsigned dst_blk_h = MIN2(blk_h, job->src_height - y*blk_h);
+
+         for (unsigned sub_y = 0; sub_y < dst_blk_h; ++sub_y) {
+            memcpy(dst_row + sub_y * job->dst_stride + x * blk_w * 4,
+                   &entry->texels[sub_y * blk_w * 4], dst_blk_w * 4);
+         }
+      }
+      src_row += job->src_stride;
+      dst_row += job->dst_stride * blk_h;
+   }
+
+   free(cache);
+}
+
 /**
  * Decode ASTC 2D LDR texture data.
  *
+ * Large textures are split into ranges of block rows, which are decoded in
+ * parallel.
+ *
  * \param src_width in pixels
  * \param src_height in pixels
  * \param dst_stride in bytes
@@ -1836,37 +2062,49 @@ _mesa_unpack_astc_2d_ldr(uint8_t *dst_row,
    unsigned blk_w, blk_h;
    _mesa_get_format_block_size(format, &blk_w, &blk_h);
 
-   const unsigned block_size = 16;
    unsigned x_blocks = (src_width + blk_w - 1) / blk_w;
    unsigned y_blocks = (src_height + blk_h - 1) / blk_h;
 
    Decoder dec(blk_w, blk_h, 1, srgb, true);
 
-   for (unsigned y = 0; y < y_blocks; ++y) {
-      for (unsigned x = 0; x < x_blocks; ++x) {
-         /* Same size as the largest block. */
-         uint16_t block_out[12 * 12 * 4];
-
-         dec.decode(src_row + x * block_size, block_out);
+   unsigned num_jobs = MIN2(x_blocks * y_blocks / ASTC_MIN_BLOCKS_PER_JOB,
+                            y_blocks);
+   if (num_jobs > 1) {
+      call_once(&astc_decode_queue_once, init_astc_decode_queue);
+      if (astc_decode_queue_initialized)
+         num_jobs = MIN2(num_jobs, astc_decode_queue.num_threads + 1);
+      else
+         num_jobs = 1;
+   }
+   num_jobs = MAX2(num_jobs, 1);
+
+   astc_decode_job jobs[ASTC_MAX_DECODE_JOBS];
+   unsigned first_row = 0;
+   for (unsigned i = 0; i < num_jobs; ++i) {
+      astc_decode_job *job = &jobs[i];
+      job->dec = &dec;
+      job->dst_row = dst_row;
+      job->dst_stride = dst_stride;
+      job->src_row = src_row;
+      job->src_stride = src_stride;
+      job->src_width = src_width;
+      job->src_height = src_height;
+      job->first_row = first_row;
+      job->num_rows = (y_blocks - first_row) / (num_jobs - i);
+      first_row += job->num_rows;
+
+      /* The first range is decoded by this thread. */
+      if (i > 0) {
+         util_queue_fence_init(&job->fence);
+         util_queue_add_job(&astc_decode_queue, job, &job->fence,
+                            decode_astc_rows, NULL, 0);
+      }
+   }
 
-         /* This can be smaller with NPOT dimensions. */
-         unsigned dst_blk_w = MIN2(blk_w, src_width  - x*blk_w);
-         unsigned dst_blk_h = MIN2(blk_h, src_height - y*blk_h);
+   decode_astc_rows(&jobs[0], 0);
 
-         for (unsigned sub_y = 0; sub_y < dst_blk_h; ++sub_y) {
-            for (unsigned sub_x = 0; sub_x < dst_blk_w; ++sub_x) {
-               uint8_t *dst = dst_row + sub_y * dst_stride +
-                              (x * blk_w + sub_x) * 4;
-               const uint16_t *src = &block_out[(sub_y * blk_w + sub_x) * 4];
-
-               dst[0] = src[0];
-               dst[1] = src[1];
-               dst[2] = src[2];
-               dst[3] = src[3];
-            }
-         }
-      }
-      src_row += src_stride;
-      dst_row += dst_stride * blk_h;
+   for (unsigned i = 1; i < num_jobs; ++i) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
    }
 }
@@ -1254,6 +1254,80 @@ copy_uniforms_to_storage(gl_constant_value *storage,
 }
 
 
+/**
+ * Set a 32-bit float or integer scalar or vector uniform without going
+ * through the type dispatch of copy_uniforms_to_storage(). This covers
+ * the vast majority of glUniform calls.
+ *
+ * \return false if the slow path has to be taken instead, which also
+ * happens for all the calls that generate errors.
+ */
+static inline bool
+uniform_fast_path(GLint location, GLsizei count, const GLvoid *values,
+                  struct gl_context *ctx, struct gl_shader_program *shProg,
+                  enum glsl_base_type basicType, unsigned src_components)
+{
+   if (!shProg || location < 0 ||
+       location >= (GLint) shProg->NumUniformRemapTable || count < 0)
+      return false;
+
+   struct gl_uniform_storage *uni = shProg->UniformRemapTable[location];
+   if (!uni || uni == INACTIVE_UNIFORM_EXPLICIT_LOCATION || uni->builtin)
+      return false;
+
+   const struct glsl_type *type = uni->type;
+   if (type->base_type != basicType ||
+       type->vector_elements != src_components ||
+       type->matrix_columns != 1 ||
+       (basicType != GLSL_TYPE_FLOAT && basicType != GLSL_TYPE_INT &&
+        basicType != GLSL_TYPE_UINT))
+      return false;
+
+   if (unlikely(ctx->_Shader->Flags & GLSL_UNIFORMS))
+      return false;
+
+   unsigned offset = location - uni->remap_location;
+   if (uni->array_elements == 0) {
+      if (count > 1)
+         return false;
+   } else {
+      if (offset >= uni->array_elements)
+         return false;
+      count = MIN2(count, (int) (uni->array_elements - offset));
+   }
+
+   const unsigned components = src_components;
+   const unsigned size = sizeof(gl_constant_value) * components * count;
+
+   if (ctx->Const.PackedDriverUniformStorage) {
+      bool flushed = false;
+
+      for (unsigned s = 0; s < uni->num_driver_storage; s++) {
+         gl_constant_value *storage = (gl_constant_value *)
+            uni->driver_storage[s].data + offset * components;
+
+         if (!memcmp(storage, values, size))
+            continue;
+
+         if (!flushed) {
+            _mesa_flush_vertices_for_uniforms(ctx, uni);
+            flushed = true;
+         }
+         memcpy(storage, values, size);
+      }
+   } else {
+      gl_constant_value *storage = &uni->storage[components * offset];
+
+      if (memcmp(storage, values, size)) {
+         _mesa_flush_vertices_for_uniforms(ctx, uni);
+         memcpy(storage, values, size);
+         _mesa_propagate_uniforms_to_driver_storage(uni, offset, count);
+      }
+   }
+
+   return true;
+}
+
 /**
  * Called via glUniform*() functions.
  */
@@ -1265,6 +1339,10 @@ _mesa_uniform(GLint location, GLsizei count, const GLvoid *values,
    unsigned offset;
    int size_mul = glsl_base_type_is_64bit(basicType) ? 2 : 1;
 
+   if (uniform_fast_path(location, count, values, ctx, shProg, basicType,
+                         src_components))
+      return;
+
    struct gl_uniform_storage *uni;
    if (_mesa_is_no_error_enabled(ctx)) {
       /* From Seciton 7.6 (UNIFORM VARIABLES) of the OpenGL 4.5 spec:
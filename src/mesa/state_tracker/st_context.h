@@ -182,6 +182,12 @@ struct st_context
     */
    boolean shader_has_one_variant[MESA_SHADER_STAGES];
 
+   /**
+    * Set while the variants recorded in the shader cache are compiled at
+    * link time, so that they don't get recorded again.
+    */
+   boolean precompiling_cached_variants;
+
    boolean needs_texcoord_semantic;
    boolean apply_texture_swizzle_to_border_color;
    boolean emulate_gl_clamp;
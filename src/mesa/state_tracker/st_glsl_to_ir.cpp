@@ -126,11 +126,13 @@ st_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
          lower_blend_equation_advanced(
             shader, ctx->Extensions.KHR_blend_equation_advanced_coherent);
 
+      /* glsl_to_nir translates exp and log to their base 2 versions itself,
+       * there is no need to walk the IR for them.
+       */
       lower_instructions(ir,
                          (use_nir ? 0 : MOD_TO_FLOOR) |
                          FDIV_TO_MUL_RCP |
-                         EXP_TO_EXP2 |
-                         LOG_TO_LOG2 |
+                         (use_nir ? 0 : EXP_TO_EXP2 | LOG_TO_LOG2) |
                          MUL64_TO_MUL_AND_MUL_HIGH |
                          (have_ldexp ? 0 : LDEXP_TO_ARITH) |
                          (have_dfrexp ? 0 : DFREXP_DLDEXP_TO_ARITH) |
@@ -156,9 +158,15 @@ st_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
                             IMUL_HIGH_TO_MUL
                           : 0));
 
-      do_vec_index_to_cond_assign(ir);
+      /* glsl_to_nir handles vector_extract with a non-constant index (as a
+       * chain of bcsel) and ir_quadop_vector directly, and NIR cleans up the
+       * result better than the GLSL IR conditional assignments.
+       */
+      if (!use_nir)
+         do_vec_index_to_cond_assign(ir);
       lower_vector_insert(ir, true);
-      lower_quadop_vector(ir, false);
+      if (!use_nir)
+         lower_quadop_vector(ir, false);
       if (options->MaxIfDepth == 0) {
          lower_discard(ir);
       }
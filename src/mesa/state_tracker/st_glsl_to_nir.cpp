@@ -51,6 +51,8 @@
 #include "compiler/glsl/ir.h"
 #include "compiler/glsl/ir_optimization.h"
 #include "compiler/glsl/string_to_uint_map.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
 
 static int
 type_size(const struct glsl_type *type)
@@ -369,11 +371,10 @@ st_nir_preprocess(struct st_context *st, struct gl_program *prog,
       nir->info.next_stage = MESA_SHADER_FRAGMENT;
    }
 
+   /* st_init_soft_fp64() checks this info once the stage is preprocessed,
+    * since stages may be preprocessed in parallel.
+    */
    nir_shader_gather_info(nir, nir_shader_get_entrypoint(nir));
-   if (!st->ctx->SoftFP64 && ((nir->info.bit_sizes_int | nir->info.bit_sizes_float) & 64) &&
-       (options->lower_doubles_options & nir_lower_fp64_full_software) != 0) {
-      st->ctx->SoftFP64 = glsl_float64_funcs_to_nir(st->ctx, options);
-   }
 
    /* ES has strict SSO validation rules for shader IO matching so we can't
     * remove dead IO until the resource list has been built. Here we skip
@@ -422,6 +423,19 @@ st_nir_preprocess(struct st_context *st, struct gl_program *prog,
    NIR_PASS_V(nir, nir_opt_constant_folding);
 }
 
+/* Build the software fp64 functions if a preprocessed shader needs them. */
+static void
+st_init_soft_fp64(struct st_context *st, nir_shader *nir)
+{
+   const nir_shader_compiler_options *options = nir->options;
+
+   if (!st->ctx->SoftFP64 &&
+       ((nir->info.bit_sizes_int | nir->info.bit_sizes_float) & 64) &&
+       (options->lower_doubles_options & nir_lower_fp64_full_software) != 0) {
+      st->ctx->SoftFP64 = glsl_float64_funcs_to_nir(st->ctx, options);
+   }
+}
+
 static bool
 dest_is_64bit(nir_dest *dest, void *state)
 {
@@ -710,12 +724,59 @@ st_nir_lower_wpos_ytransform(struct nir_shader *nir,
    }
 }
 
+struct st_glsl_to_nir_job
+{
+   struct util_queue_fence fence;
+   struct st_context *st;
+   struct gl_shader_program *shader_program;
+   struct gl_linked_shader *shader;
+};
+
+/* The GLSL IR to NIR conversion and the preprocessing only touch the stage
+ * itself, so the stages of a program are converted in parallel.
+ */
+static struct util_queue glsl_to_nir_queue;
+static bool glsl_to_nir_queue_initialized;
+static once_flag glsl_to_nir_queue_once = ONCE_FLAG_INIT;
+
+static void
+init_glsl_to_nir_queue(void)
+{
+   util_cpu_detect();
+
+   /* The linking thread converts one of the stages itself. */
+   int num_threads = MIN2(util_get_cpu_caps()->nr_cpus - 1,
+                          MESA_SHADER_STAGES - 1);
+   if (num_threads < 1)
+      return;
+
+   glsl_to_nir_queue_initialized =
+      util_queue_init(&glsl_to_nir_queue, "glsl2nir", MESA_SHADER_STAGES,
+                      num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+}
+
+static void
+st_glsl_to_nir_execute(void *data, int thread_index)
+{
+   struct st_glsl_to_nir_job *job = (struct st_glsl_to_nir_job *)data;
+   struct st_context *st = job->st;
+   struct gl_linked_shader *shader = job->shader;
+   const nir_shader_compiler_options *options =
+      st->ctx->Const.ShaderCompilerOptions[shader->Stage].NirOptions;
+   struct gl_program *prog = shader->Program;
+
+   prog->nir = glsl_to_nir(st->ctx, job->shader_program, shader->Stage,
+                           options);
+   st_nir_preprocess(st, prog, job->shader_program, shader->Stage);
+}
+
 bool
 st_link_nir(struct gl_context *ctx,
             struct gl_shader_program *shader_program)
 {
    struct st_context *st = st_context(ctx);
    struct gl_linked_shader *linked_shader[MESA_SHADER_STAGES];
+   struct st_glsl_to_nir_job jobs[MESA_SHADER_STAGES];
    unsigned num_shaders = 0;
 
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
@@ -753,9 +814,41 @@ st_link_nir(struct gl_context *ctx,
             _mesa_log("\n\n");
          }
 
-         prog->nir = glsl_to_nir(st->ctx, shader_program, shader->Stage, options);
-         st_nir_preprocess(st, prog, shader_program, shader->Stage);
+         jobs[i].st = st;
+         jobs[i].shader_program = shader_program;
+         jobs[i].shader = shader;
+      }
+   }
+
+   if (!shader_program->data->spirv) {
+      bool use_queue = false;
+      if (num_shaders > 1) {
+         call_once(&glsl_to_nir_queue_once, init_glsl_to_nir_queue);
+         use_queue = glsl_to_nir_queue_initialized;
+      }
+
+      for (unsigned i = 1; i < num_shaders && use_queue; i++) {
+         util_queue_fence_init(&jobs[i].fence);
+         util_queue_add_job(&glsl_to_nir_queue, &jobs[i], &jobs[i].fence,
+                            st_glsl_to_nir_execute, NULL, 0);
+      }
+
+      for (unsigned i = 0; i < (use_queue ? 1 : num_shaders); i++)
+         st_glsl_to_nir_execute(&jobs[i], 0);
+
+      for (unsigned i = 1; i < num_shaders && use_queue; i++) {
+         util_queue_fence_wait(&jobs[i].fence);
+         util_queue_fence_destroy(&jobs[i].fence);
       }
+   }
+
+   for (unsigned i = 0; i < num_shaders; i++) {
+      struct gl_linked_shader *shader = linked_shader[i];
+      const nir_shader_compiler_options *options =
+         st->ctx->Const.ShaderCompilerOptions[shader->Stage].NirOptions;
+
+      if (!shader_program->data->spirv)
+         st_init_soft_fp64(st, shader->Program->nir);
 
       if (options->lower_to_scalar) {
          NIR_PASS_V(shader->Program->nir, nir_lower_load_const_to_scalar);
@@ -783,6 +876,7 @@ st_link_nir(struct gl_context *ctx,
          prog->ExternalSamplersUsed = gl_external_samplers(prog);
          _mesa_update_shader_textures_used(shader_program, prog);
          st_nir_preprocess(st, prog, shader_program, shader->Stage);
+         st_init_soft_fp64(st, prog->nir);
       }
    }
 
@@ -129,6 +129,7 @@
 #include <ostream>
 #include <cassert>
 #include <algorithm>
+#include <vector>
 
 #include <iostream>
 
@@ -430,16 +431,32 @@ public:
    array_merge_evaluator(int _narrays, array_live_range *_ranges,
 			 bool _restart);
 
+   virtual ~array_merge_evaluator() {}
+
    /** Run the merge strategy on all arrays
     * @returns number of successfull merges
     */
-   int run();
+   virtual int run();
 
-private:
-   virtual int do_run(array_live_range& range_1, array_live_range& range_2) = 0;
+protected:
+   /** Run the merge strategy on all pairs of the given arrays, in the order
+    * of the indices.
+    */
+   int run_on(const int *indices, int nindices);
+
+   /** Collect the arrays that are not yet merged into another one. Once an
+    * array is mapped it stays mapped, so these can be skipped for the
+    * whole run.
+    */
+   int get_unmapped(int *indices) const;
 
    int narrays;
    array_live_range *ranges;
+   std::vector<int> unmapped;
+
+private:
+   virtual int do_run(array_live_range& range_1, array_live_range& range_2) = 0;
+
    bool restart;
 };
 
@@ -448,19 +465,37 @@ array_merge_evaluator::array_merge_evaluator(int _narrays,
 					     bool _restart):
    narrays(_narrays),
    ranges(_ranges),
+   unmapped(_narrays),
    restart(_restart)
 {
 }
 
+int array_merge_evaluator::get_unmapped(int *indices) const
+{
+   int n = 0;
+   for (int i = 0; i < narrays; ++i) {
+      if (!ranges[i].is_mapped())
+	 indices[n++] = i;
+   }
+   return n;
+}
+
 int array_merge_evaluator::run()
+{
+   return run_on(unmapped.data(), get_unmapped(unmapped.data()));
+}
+
+int array_merge_evaluator::run_on(const int *indices, int nindices)
 {
    int remaps = 0;
 
-   for (int i = 0; i < narrays; ++i) {
+   for (int ii = 0; ii < nindices; ++ii) {
+      int i = indices[ii];
       if (ranges[i].is_mapped())
 	 continue;
 
-      for (int j = i + 1; j < narrays; ++j) {
+      for (int jj = ii + 1; jj < nindices; ++jj) {
+	 int j = indices[jj];
 	 if (!ranges[j].is_mapped()) {
 	    ARRAY_MERGE_DUMP("try merge " << i << " id:" << ranges[i].array_id()
 			     << " and " << j  << " id: "<< ranges[j].array_id()
@@ -498,6 +533,37 @@ public:
    merge_live_range_equal_swizzle(int _narrays, array_live_range *_ranges):
       merge_live_range_always(_narrays, _ranges) {
    }
+
+   /* Merging doesn't change the access mask, so it is enough to pair the
+    * arrays that have the same mask, in the same order as they would be
+    * visited with all arrays. The masks only change by interleaving, so the
+    * buckets are re-evaluated on each run.
+    */
+   int run() {
+      int bucket_start[17] = {0};
+      int fill[16];
+
+      int n = get_unmapped(unmapped.data());
+      for (int i = 0; i < n; ++i) {
+	 assert(ranges[unmapped[i]].access_mask() < 16);
+	 ++bucket_start[ranges[unmapped[i]].access_mask() + 1];
+      }
+      for (int m = 1; m <= 16; ++m)
+	 bucket_start[m] += bucket_start[m - 1];
+
+      memcpy(fill, bucket_start, sizeof(fill));
+      by_mask.resize(n);
+      for (int i = 0; i < n; ++i)
+	 by_mask[fill[ranges[unmapped[i]].access_mask()]++] = unmapped[i];
+
+      int remaps = 0;
+      for (int m = 0; m < 16; ++m) {
+	 int count = bucket_start[m + 1] - bucket_start[m];
+	 if (count > 1)
+	    remaps += run_on(&by_mask[bucket_start[m]], count);
+      }
+      return remaps;
+   }
 private:
    int do_run(array_live_range& range_1, array_live_range& range_2){
       if (range_1.access_mask() == range_2.access_mask()) {
@@ -505,6 +571,8 @@ private:
       }
       return 0;
    }
+
+   std::vector<int> by_mask;
 };
 
 /* Interleave arrays if possible */
@@ -1000,7 +1000,9 @@ public:
    int begin;
    int end;
    int reg;
-   bool erase;
+   /* Index of the record itself as long as it is not merged, then a
+    * record further up for find_unmerged() to continue with. */
+   int next_unmerged;
 
    bool operator < (const register_merge_record& rhs) const {
       return begin < rhs.begin;
@@ -1322,6 +1324,21 @@ find_next_rename(register_merge_record* start, register_merge_record* end, int b
    return start;
 }
 
+/* Find the first record at or after idx that was not yet merged into
+ * another register, the record past the end is always unmerged. The paths
+ * are halved on the way so that the look-ups stay cheap.
+ */
+static int
+find_unmerged(register_merge_record *records, int idx)
+{
+   while (records[idx].next_unmerged != idx) {
+      records[idx].next_unmerged =
+         records[records[idx].next_unmerged].next_unmerged;
+      idx = records[idx].next_unmerged;
+   }
+   return idx;
+}
+
 #ifndef USE_STL_SORT
 static int register_merge_record_compare (const void *a, const void *b) {
    const register_merge_record *aa = static_cast<const register_merge_record*>(a);
@@ -1331,12 +1348,16 @@ static int register_merge_record_compare (const void *a, const void *b) {
 #endif
 
 /* This functions evaluates the register merges by using a binary
- * search to find suitable merge candidates. */
+ * search to find suitable merge candidates. The records are sorted only
+ * once, merged records are skipped by find_unmerged() instead of compacting
+ * the array after each merge target, which made this quadratic in the
+ * register pressure.
+ */
 void get_temp_registers_remapping(void *mem_ctx, int ntemps,
 				  const struct register_live_range *live_ranges,
 				  struct rename_reg_pair *result)
 {
-   register_merge_record *reg_access = ralloc_array(mem_ctx, register_merge_record, ntemps);
+   register_merge_record *reg_access = ralloc_array(mem_ctx, register_merge_record, ntemps + 1);
 
    int used_temps = 0;
    for (int i = 0; i < ntemps; ++i) {
@@ -1344,7 +1365,6 @@ void get_temp_registers_remapping(void *mem_ctx, int ntemps,
 	 reg_access[used_temps].begin =live_ranges[i].begin;
 	 reg_access[used_temps].end =live_ranges[i].end;
          reg_access[used_temps].reg = i;
-         reg_access[used_temps].erase = false;
          ++used_temps;
       }
    }
@@ -1356,46 +1376,34 @@ void get_temp_registers_remapping(void *mem_ctx, int ntemps,
 	      register_merge_record_compare);
 #endif
 
-   register_merge_record *trgt = reg_access;
-   register_merge_record *reg_access_end = reg_access + used_temps;
-   register_merge_record *first_erase = reg_access_end;
-   register_merge_record *search_start = trgt + 1;
-
-   while (trgt != reg_access_end) {
-      register_merge_record *src = find_next_rename(search_start, reg_access_end,
-                                            trgt->end);
-      if (src != reg_access_end) {
-         result[src->reg].new_reg = trgt->reg;
-         result[src->reg].valid = true;
-         trgt->end = src->end;
-
-         /* Since we only search forward, don't remove the renamed
-          * register just now, only mark it. */
-         src->erase = true;
-
-         if (first_erase == reg_access_end)
-            first_erase = src;
+   for (int i = 0; i <= used_temps; ++i)
+      reg_access[i].next_unmerged = i;
 
+   register_merge_record *reg_access_end = reg_access + used_temps;
+   int trgt = 0;
+
+   while (trgt < used_temps) {
+      int search_start = trgt + 1;
+
+      while (true) {
+         register_merge_record *first = find_next_rename(reg_access + search_start,
+                                                         reg_access_end,
+                                                         reg_access[trgt].end);
+         int src = find_unmerged(reg_access, first - reg_access);
+         if (src == used_temps)
+            break;
+
+         result[reg_access[src].reg].new_reg = reg_access[trgt].reg;
+         result[reg_access[src].reg].valid = true;
+         reg_access[trgt].end = reg_access[src].end;
+
+         /* Only the begin is used for searching, so the record can stay in
+          * place, it is just skipped from now on. */
+         reg_access[src].next_unmerged = src + 1;
          search_start = src + 1;
-      } else {
-         /* Moving to the next target register it is time to remove
-          * the already merged registers from the search range */
-         if (first_erase != reg_access_end) {
-	    register_merge_record *outp = first_erase;
-	    register_merge_record *inp = first_erase + 1;
-
-            while (inp != reg_access_end) {
-               if (!inp->erase)
-                  *outp++ = *inp;
-               ++inp;
-            }
-
-            reg_access_end = outp;
-            first_erase = reg_access_end;
-         }
-         ++trgt;
-         search_start = trgt + 1;
       }
+
+      trgt = find_unmerged(reg_access, trgt + 1);
    }
    ralloc_free(reg_access);
 }
@@ -963,6 +963,8 @@ st_get_common_variant(struct st_context *st,
       }
 
       /* create now */
+      bool is_default = stp->variants == NULL;
+
       v = st_create_common_variant(st, stp, key);
       if (v) {
          v->base.st = key->st;
@@ -979,6 +981,10 @@ st_get_common_variant(struct st_context *st,
          }
 
          st_add_variant(&stp->variants, &v->base);
+
+         if (!is_default && !key->is_draw_shader &&
+             !st->precompiling_cached_variants)
+            st_store_variant_keys_in_disk_cache(st, &stp->Base);
       }
    }
 
@@ -1669,11 +1675,17 @@ st_get_fp_variant(struct st_context *st,
                           key->gl_clamp[0] || key->gl_clamp[1] || key->gl_clamp[2] ? "GL_CLAMP," : "");
       }
 
+      bool is_default = stfp->variants == NULL;
+
       fpv = st_create_fp_variant(st, stfp, key);
       if (fpv) {
          fpv->base.st = key->st;
 
          st_add_variant(&stfp->variants, &fpv->base);
+
+         if (!is_default && !key->bitmap && !key->drawpixels &&
+             !st->precompiling_cached_variants)
+            st_store_variant_keys_in_disk_cache(st, &stfp->Base);
       }
    }
 
@@ -1981,6 +1993,47 @@ st_precompile_shader_variant(struct st_context *st,
    }
 }
 
+/**
+ * Compile the variants that the shader cache recorded for this program
+ * when it was used before, instead of waiting for the draw that needs them.
+ */
+static void
+st_precompile_cached_variants(struct st_context *st,
+                              struct gl_program *prog)
+{
+   struct st_program *p = st_program(prog);
+   unsigned num_keys;
+   void *keys;
+
+   if (st->shader_has_one_variant[prog->info.stage])
+      return;
+
+   keys = st_load_variant_keys_from_disk_cache(st, prog, &num_keys);
+   if (!keys)
+      return;
+
+   st->precompiling_cached_variants = true;
+
+   for (unsigned i = 0; i < num_keys; i++) {
+      if (prog->Target == GL_FRAGMENT_PROGRAM_ARB) {
+         struct st_fp_variant_key *key =
+            &((struct st_fp_variant_key *)keys)[i];
+
+         key->st = st->has_shareable_shaders ? NULL : st;
+         st_get_fp_variant(st, p, key);
+      } else {
+         struct st_common_variant_key *key =
+            &((struct st_common_variant_key *)keys)[i];
+
+         key->st = st->has_shareable_shaders ? NULL : st;
+         st_get_common_variant(st, p, key);
+      }
+   }
+
+   st->precompiling_cached_variants = false;
+   free(keys);
+}
+
 void
 st_serialize_nir(struct st_program *stp)
 {
@@ -2017,4 +2070,7 @@ st_finalize_program(struct st_context *st, struct gl_program *prog)
 
    /* Always create the default variant of the program. */
    st_precompile_shader_variant(st, prog);
+
+   /* And the ones that were needed the last time the program was used. */
+   st_precompile_cached_variants(st, prog);
 }
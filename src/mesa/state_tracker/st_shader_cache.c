@@ -275,6 +275,143 @@ st_load_ir_from_disk_cache(struct gl_context *ctx,
    return true;
 }
 
+/* Only record the 16 first variants, programs that need more than that are
+ * rare and would just make the link slower.
+ */
+#define ST_MAX_CACHED_VARIANT_KEYS 16
+
+static size_t
+variant_key_size(struct gl_program *prog)
+{
+   return prog->info.stage == MESA_SHADER_FRAGMENT ?
+      sizeof(struct st_fp_variant_key) : sizeof(struct st_common_variant_key);
+}
+
+/**
+ * The variant keys are stored separately from the IR, because they are
+ * only known after the program was used for drawing.
+ */
+static bool
+compute_variant_keys_cache_key(struct st_context *st, struct gl_program *prog,
+                               cache_key key)
+{
+   static const char zero[sizeof(prog->sh.data->sha1)] = {0};
+   uint8_t data[sizeof(prog->sh.data->sha1) + 2 * sizeof(uint32_t)];
+   uint32_t stage = prog->info.stage;
+   uint32_t key_size = variant_key_size(prog);
+
+   if (!st->ctx->Cache || !prog->sh.data ||
+       memcmp(prog->sh.data->sha1, zero, sizeof(prog->sh.data->sha1)) == 0)
+      return false;
+
+   memcpy(data, prog->sh.data->sha1, sizeof(prog->sh.data->sha1));
+   memcpy(data + sizeof(prog->sh.data->sha1), &stage, sizeof(stage));
+   memcpy(data + sizeof(prog->sh.data->sha1) + sizeof(stage), &key_size,
+          sizeof(key_size));
+   disk_cache_compute_key(st->ctx->Cache, data, sizeof(data), key);
+   return true;
+}
+
+/**
+ * Store the keys of the variants of a program that were compiled at draw
+ * time, so that they can be compiled at link time the next time the
+ * program is used. Variants for glBitmap, glDrawPixels and the draw module
+ * are internal and not recorded.
+ */
+void
+st_store_variant_keys_in_disk_cache(struct st_context *st,
+                                    struct gl_program *prog)
+{
+   struct st_program *stp = st_program(prog);
+   cache_key key;
+
+   if (!compute_variant_keys_cache_key(st, prog, key))
+      return;
+
+   struct blob blob;
+   blob_init(&blob);
+
+   unsigned num_keys = 0;
+   intptr_t num_keys_offset = blob_reserve_uint32(&blob);
+
+   for (struct st_variant *v = stp->variants;
+        v && num_keys < ST_MAX_CACHED_VARIANT_KEYS; v = v->next) {
+      if (prog->info.stage == MESA_SHADER_FRAGMENT) {
+         struct st_fp_variant_key fp_key;
+
+         memcpy(&fp_key, &st_fp_variant(v)->key, sizeof(fp_key));
+         if (fp_key.bitmap || fp_key.drawpixels)
+            continue;
+         fp_key.st = NULL;
+         blob_write_bytes(&blob, &fp_key, sizeof(fp_key));
+      } else {
+         struct st_common_variant_key common_key;
+
+         memcpy(&common_key, &st_common_variant(v)->key, sizeof(common_key));
+         if (common_key.is_draw_shader)
+            continue;
+         common_key.st = NULL;
+         blob_write_bytes(&blob, &common_key, sizeof(common_key));
+      }
+      num_keys++;
+   }
+   blob_overwrite_uint32(&blob, num_keys_offset, num_keys);
+
+   if (!blob.out_of_memory) {
+      disk_cache_put(st->ctx->Cache, key, blob.data, blob.size, NULL);
+
+      if (st->ctx->_Shader->Flags & GLSL_CACHE_INFO) {
+         fprintf(stderr, "putting %u %s shader variant keys in cache\n",
+                 num_keys, _mesa_shader_stage_to_string(prog->info.stage));
+      }
+   }
+   blob_finish(&blob);
+}
+
+/**
+ * Load the variant keys stored by st_store_variant_keys_in_disk_cache.
+ * Returns an array of st_fp_variant_key or st_common_variant_key with
+ * \p num_keys entries that must be freed by the caller, or NULL.
+ */
+void *
+st_load_variant_keys_from_disk_cache(struct st_context *st,
+                                     struct gl_program *prog,
+                                     unsigned *num_keys)
+{
+   size_t key_size = variant_key_size(prog);
+   cache_key key;
+   size_t size;
+
+   if (!compute_variant_keys_cache_key(st, prog, key))
+      return NULL;
+
+   uint8_t *buffer = disk_cache_get(st->ctx->Cache, key, &size);
+   if (!buffer)
+      return NULL;
+
+   struct blob_reader blob_reader;
+   blob_reader_init(&blob_reader, buffer, size);
+
+   *num_keys = blob_read_uint32(&blob_reader);
+   if (blob_reader.overrun || *num_keys == 0 ||
+       *num_keys > ST_MAX_CACHED_VARIANT_KEYS ||
+       size != sizeof(uint32_t) + *num_keys * key_size) {
+      free(buffer);
+      return NULL;
+   }
+
+   void *keys = malloc(*num_keys * key_size);
+   if (keys)
+      blob_copy_bytes(&blob_reader, keys, *num_keys * key_size);
+   free(buffer);
+
+   if (keys && st->ctx->_Shader->Flags & GLSL_CACHE_INFO) {
+      fprintf(stderr, "%u %s shader variant keys retrieved from cache\n",
+              *num_keys, _mesa_shader_stage_to_string(prog->info.stage));
+   }
+   return keys;
+}
+
 void
 st_serialise_tgsi_program(struct gl_context *ctx, struct gl_program *prog)
 {
@@ -73,6 +73,15 @@ void
 st_store_ir_in_disk_cache(struct st_context *st, struct gl_program *prog,
                           bool nir);
 
+void
+st_store_variant_keys_in_disk_cache(struct st_context *st,
+                                    struct gl_program *prog);
+
+void *
+st_load_variant_keys_from_disk_cache(struct st_context *st,
+                                     struct gl_program *prog,
+                                     unsigned *num_keys);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1772,6 +1772,24 @@ TEST_F(RegisterRemappingTest, RegisterRemappingMergeZeroLifetimeRegisters)
    run(lt, expect);
 }
 
+/* Many registers that are alive at the same time, this used to be
+ * quadratic in the number of overlapping live ranges, and it can be
+ * used as a micro-benchmark by running it with --gtest_repeat.
+ */
+TEST_F(RegisterRemappingTest, RegisterRemappingHighRegisterPressure)
+{
+   const int n = 8192;
+   vector<register_live_range> lt(2 * n + 1);
+   vector<int> expect(2 * n + 1);
+
+   lt[0] = {-1, -1};
+   for (int i = 1; i <= 2 * n; ++i) {
+      lt[i] = {i, i + n};
+      expect[i] = i <= n ? i : i - n;
+   }
+   run(lt, expect);
+}
+
 TEST_F(RegisterLifetimeAndRemappingTest, LifetimeAndRemapping)
 {
    const vector<FakeCodeline> code = {
@@ -32,7 +32,9 @@
 #include "../compiler/dxil_nir_lower_int_samplers.h"
 #include "../compiler/nir_to_dxil.h"
 
+#include "util/u_cpu_detect.h"
 #include "util/u_debug.h"
+#include "util/u_queue.h"
 #include <util/u_math.h>
 #include "spirv/nir_spirv.h"
 #include "nir_builder.h"
@@ -1465,6 +1467,120 @@ err_free_dxil:
    return NULL;
 }
 
+struct clc_locked_logger {
+   struct clc_logger base;
+   const struct clc_logger *logger;
+   mtx_t lock;
+};
+
+static void
+clc_locked_error(void *priv, const char *msg)
+{
+   struct clc_locked_logger *locked = priv;
+   mtx_lock(&locked->lock);
+   locked->logger->error(locked->logger->priv, msg);
+   mtx_unlock(&locked->lock);
+}
+
+static void
+clc_locked_warning(void *priv, const char *msg)
+{
+   struct clc_locked_logger *locked = priv;
+   mtx_lock(&locked->lock);
+   locked->logger->warning(locked->logger->priv, msg);
+   mtx_unlock(&locked->lock);
+}
+
+struct clc_dxil_job {
+   struct clc_context *ctx;
+   const struct clc_object *obj;
+   const struct clc_runtime_kernel_conf *conf;
+   const struct clc_logger *logger;
+   unsigned kernel;
+   struct clc_dxil_object **dxils;
+   struct util_queue_fence fence;
+};
+
+static void
+clc_dxil_job_execute(void *data, int thread_index)
+{
+   struct clc_dxil_job *job = data;
+   job->dxils[job->kernel] = clc_to_dxil(job->ctx, job->obj,
+                                         job->obj->kernels[job->kernel].name,
+                                         job->conf, job->logger);
+}
+
+bool
+clc_kernels_to_dxil(struct clc_context *ctx,
+                    const struct clc_object *obj,
+                    const struct clc_runtime_kernel_conf *conf,
+                    const struct clc_logger *logger,
+                    struct clc_dxil_object **dxils)
+{
+   /* The argument configuration is specific to one kernel */
+   assert(!conf || !conf->args);
+
+   if (!obj->num_kernels)
+      return true;
+
+   /* Each kernel goes through its own spirv_to_nir, since the result depends
+    * on the entrypoint, but nothing is shared between them except the
+    * libclc shader, which is only read, so they can run in parallel.
+    */
+   struct clc_locked_logger locked_logger = {
+      .base = {
+         .priv = &locked_logger,
+         .error = logger && logger->error ? clc_locked_error : NULL,
+         .warning = logger && logger->warning ? clc_locked_warning : NULL,
+      },
+      .logger = logger,
+   };
+   mtx_init(&locked_logger.lock, mtx_plain);
+
+   struct clc_dxil_job *jobs = calloc(obj->num_kernels, sizeof(*jobs));
+   if (!jobs) {
+      clc_error(logger, "failed to allocate the dxil jobs");
+      mtx_destroy(&locked_logger.lock);
+      return false;
+   }
+
+   util_cpu_detect();
+   struct util_queue queue;
+   unsigned num_threads = MIN2(util_get_cpu_caps()->nr_cpus, obj->num_kernels);
+   bool threaded = num_threads > 1 &&
+                   util_queue_init(&queue, "clcdxil", obj->num_kernels,
+                                   num_threads, 0);
+
+   for (unsigned i = 0; i < obj->num_kernels; i++) {
+      struct clc_dxil_job *job = &jobs[i];
+      job->ctx = ctx;
+      job->obj = obj;
+      job->conf = conf;
+      job->logger = &locked_logger.base;
+      job->kernel = i;
+      job->dxils = dxils;
+      util_queue_fence_init(&job->fence);
+
+      if (threaded)
+         util_queue_add_job(&queue, job, &job->fence, clc_dxil_job_execute, NULL, 0);
+      else
+         clc_dxil_job_execute(job, 0);
+   }
+
+   bool success = true;
+   for (unsigned i = 0; i < obj->num_kernels; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+      success &= dxils[i] != NULL;
+   }
+
+   if (threaded)
+      util_queue_destroy(&queue);
+   free(jobs);
+   mtx_destroy(&locked_logger.lock);
+   return success;
+}
+
 void clc_free_dxil_object(struct clc_dxil_object *dxil)
 {
    for (unsigned i = 0; i < dxil->metadata.num_consts; i++)
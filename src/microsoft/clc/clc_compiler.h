@@ -243,6 +243,19 @@ clc_to_dxil(struct clc_context *ctx,
             const struct clc_runtime_kernel_conf *conf,
             const struct clc_logger *logger);
 
+/* Compiles all the kernels of obj, spread over worker threads. dxils must
+ * have room for obj->num_kernels objects, which are returned in the order of
+ * obj->kernels, NULL for the kernels that failed to compile. conf applies to
+ * all the kernels, so it can't have any argument configuration. The logger
+ * is only called from one thread at a time.
+ */
+bool
+clc_kernels_to_dxil(struct clc_context *ctx,
+                    const struct clc_object *obj,
+                    const struct clc_runtime_kernel_conf *conf,
+                    const struct clc_logger *logger,
+                    struct clc_dxil_object **dxils);
+
 void clc_free_dxil_object(struct clc_dxil_object *dxil);
 
 /* This struct describes the layout of data expected in the CB bound at global_work_offset_cbv_id */
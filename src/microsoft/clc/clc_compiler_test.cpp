@@ -2220,3 +2220,37 @@ TEST_F(ComputeTest, unused_arg)
    for (int i = 0; i < 4; ++i)
       EXPECT_EQ(dest[i], i + 1);
 }
+
+TEST_F(ComputeTest, kernels_to_dxil)
+{
+   const char *kernel_source = R"(
+   __kernel void main_test(__global int *dst, __global int *src)
+   {
+      int i = get_global_id(0);
+      dst[i] = src[i];
+   }
+
+   __kernel void other_kernel(__global float *dst)
+   {
+      dst[get_global_id(0)] = 1.0f;
+   })";
+   Shader shader = compile({ kernel_source }, {}, true);
+   const struct clc_object *obj = shader.obj.get();
+   ASSERT_EQ(obj->num_kernels, 2u);
+
+   const struct clc_logger logger = {
+      NULL,
+      [](void *priv, const char *msg) { fprintf(stderr, "ERROR: %s\n", msg); },
+      [](void *priv, const char *msg) { fprintf(stderr, "WARNING: %s\n", msg); },
+   };
+   vector<struct clc_dxil_object *> dxils(obj->num_kernels);
+   EXPECT_TRUE(clc_kernels_to_dxil(compiler_ctx, obj, NULL, &logger, dxils.data()));
+   for (unsigned i = 0; i < obj->num_kernels; ++i) {
+      ASSERT_NE(dxils[i], nullptr);
+      EXPECT_EQ(dxils[i]->kernel, &obj->kernels[i]);
+
+      Shader kernel = shader;
+      kernel.dxil = std::shared_ptr<struct clc_dxil_object>(dxils[i], clc_free_dxil_object);
+      validate(kernel);
+   }
+}
@@ -23,6 +23,8 @@
 // ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 // OTHER DEALINGS IN THE SOFTWARE.
 
+#include <map>
+#include <mutex>
 #include <sstream>
 
 #include <llvm/ADT/ArrayRef.h>
@@ -30,6 +32,7 @@
 #include <llvm/IR/DiagnosticInfo.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Type.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm-c/Core.h>
 #include <llvm-c/Target.h>
@@ -38,6 +41,7 @@
 #include <clang/CodeGen/CodeGenAction.h>
 #include <clang/Lex/PreprocessorOptions.h>
 #include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendActions.h>
 #include <clang/Frontend/TextDiagnosticBuffer.h>
 #include <clang/Frontend/TextDiagnosticPrinter.h>
 #include <clang/Basic/TargetInfo.h>
@@ -563,46 +567,16 @@ clc_free_kernels_info(const struct clc_kernel_info *kernels,
    free((void *)kernels);
 }
 
-int
-clc_to_spirv(const struct clc_compile_args *args,
-             struct spirv_binary *spvbin,
-             const struct clc_logger *logger)
+static std::unique_ptr<clang::CompilerInstance>
+create_compiler_instance(const std::vector<const char *> &clang_opts,
+                         std::string &log)
 {
-   LLVMInitializeAllTargets();
-   LLVMInitializeAllTargetInfos();
-   LLVMInitializeAllTargetMCs();
-   LLVMInitializeAllAsmPrinters();
-
-   std::string log;
-   std::unique_ptr<LLVMContext> llvm_ctx { new LLVMContext };
-   llvm_ctx->setDiagnosticHandlerCallBack(llvm_log_handler, &log);
-
    std::unique_ptr<clang::CompilerInstance> c { new clang::CompilerInstance };
    clang::DiagnosticsEngine diag { new clang::DiagnosticIDs,
          new clang::DiagnosticOptions,
          new clang::TextDiagnosticPrinter(*new raw_string_ostream(log),
                                           &c->getDiagnosticOpts(), true)};
 
-   std::vector<const char *> clang_opts = {
-      args->source.name,
-      "-triple", "spir64-unknown-unknown",
-      // By default, clang prefers to use modules to pull in the default headers,
-      // which doesn't work with our technique of embedding the headers in our binary
-      "-finclude-default-header",
-      // Add a default CL compiler version. Clang will pick the last one specified
-      // on the command line, so the app can override this one.
-      "-cl-std=cl1.2",
-      // The LLVM-SPIRV-Translator doesn't support memset with variable size
-      "-fno-builtin-memset",
-      // LLVM's optimizations can produce code that the translator can't translate
-      "-O0",
-      // Ensure inline functions are actually emitted
-      "-fgnu89-inline"
-   };
-   // We assume there's appropriate defines for __OPENCL_VERSION__ and __IMAGE_SUPPORT__
-   // being provided by the caller here.
-   clang_opts.insert(clang_opts.end(), args->args, args->args + args->num_args);
-
    if (!clang::CompilerInvocation::CreateFromArgs(c->getInvocation(),
 #if LLVM_VERSION_MAJOR >= 10
                                                   clang_opts,
@@ -612,14 +586,12 @@ clc_to_spirv(const struct clc_compile_args *args,
 #endif
                                                   diag)) {
       log += "Couldn't create Clang invocation.\n";
-      clc_error(logger, log.c_str());
-      return -1;
+      return nullptr;
    }
 
    if (diag.hasErrorOccurred()) {
       log += "Errors occurred during Clang invocation.\n";
-      clc_error(logger, log.c_str());
-      return -1;
+      return nullptr;
    }
 
    // This is a workaround for a Clang bug which causes the number
@@ -657,6 +629,124 @@ clc_to_spirv(const struct clc_compile_args *args,
          ::llvm::MemoryBuffer::getMemBuffer(llvm::StringRef(opencl_c_base_source, _countof(opencl_c_base_source) - 1)).release());
    }
 
+   return c;
+}
+
+// Parsing opencl-c.h takes most of the time spent compiling a small kernel,
+// so it's only done once per process for each set of compiler options, into
+// a PCH that is then included by each compile with the same options. The
+// options are part of the key, because the CL version and the defines the
+// caller passes change what the header declares, and clang rejects a PCH
+// built with different language options.
+class OpenCLHeaderPCHCache {
+public:
+   ~OpenCLHeaderPCHCache() {
+      for (auto &entry : pchs) {
+         if (!entry.second.empty())
+            ::llvm::sys::fs::remove(entry.second);
+      }
+   }
+
+   // Returns the path of the PCH, or an empty string if it couldn't be built
+   std::string get(const std::vector<const char *> &clang_opts) {
+      std::string key;
+      for (const char *opt : clang_opts) {
+         key += opt;
+         key += '\0';
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      auto entry = pchs.find(key);
+      if (entry != pchs.end())
+         return entry->second;
+      return pchs[key] = build(clang_opts);
+   }
+
+private:
+   static std::string build(const std::vector<const char *> &clang_opts) {
+      ::llvm::SmallString<128> pch_path;
+      if (::llvm::sys::fs::createTemporaryFile("opencl-c", "pch", pch_path))
+         return "";
+
+      // Build the PCH from an empty source with the same name, so that it's
+      // compiled as the same language as the kernels, with the default
+      // header included.
+      std::string log;
+      auto c = create_compiler_instance(clang_opts, log);
+      if (c) {
+         c->getPreprocessorOpts().addRemappedFile(clang_opts[0],
+            ::llvm::MemoryBuffer::getMemBuffer("").release());
+         c->getFrontendOpts().OutputFile = pch_path.str().str();
+
+         clang::GeneratePCHAction act;
+         if (c->ExecuteAction(act))
+            return pch_path.str().str();
+      }
+
+      ::llvm::sys::fs::remove(pch_path);
+      return "";
+   }
+
+   std::mutex mutex;
+   std::map<std::string, std::string> pchs;
+};
+
+static OpenCLHeaderPCHCache opencl_header_pchs;
+
+int
+clc_to_spirv(const struct clc_compile_args *args,
+             struct spirv_binary *spvbin,
+             const struct clc_logger *logger)
+{
+   LLVMInitializeAllTargets();
+   LLVMInitializeAllTargetInfos();
+   LLVMInitializeAllTargetMCs();
+   LLVMInitializeAllAsmPrinters();
+
+   std::string log;
+   std::unique_ptr<LLVMContext> llvm_ctx { new LLVMContext };
+   llvm_ctx->setDiagnosticHandlerCallBack(llvm_log_handler, &log);
+
+   std::vector<const char *> clang_opts = {
+      args->source.name,
+      "-triple", "spir64-unknown-unknown",
+      // By default, clang prefers to use modules to pull in the default headers,
+      // which doesn't work with our technique of embedding the headers in our binary
+      "-finclude-default-header",
+      // Add a default CL compiler version. Clang will pick the last one specified
+      // on the command line, so the app can override this one.
+      "-cl-std=cl1.2",
+      // The LLVM-SPIRV-Translator doesn't support memset with variable size
+      "-fno-builtin-memset",
+      // LLVM's optimizations can produce code that the translator can't translate
+      "-O0",
+      // Ensure inline functions are actually emitted
+      "-fgnu89-inline"
+   };
+   // We assume there's appropriate defines for __OPENCL_VERSION__ and __IMAGE_SUPPORT__
+   // being provided by the caller here.
+   clang_opts.insert(clang_opts.end(), args->args, args->args + args->num_args);
+
+   std::unique_ptr<clang::CompilerInstance> c = create_compiler_instance(clang_opts, log);
+   if (!c) {
+      clc_error(logger, log.c_str());
+      return -1;
+   }
+
+   // The default header is still included, but its include guard makes that
+   // a no-op after the PCH. The headers the PCH was built from are remapped
+   // in memory, so there's nothing on disk to validate it against.
+   std::string pch_path = opencl_header_pchs.get(clang_opts);
+   if (!pch_path.empty()) {
+      c->getPreprocessorOpts().ImplicitPCHInclude = pch_path;
+#if LLVM_VERSION_MAJOR >= 13
+      c->getPreprocessorOpts().DisablePCHOrModuleValidation =
+         clang::DisableValidationForModuleKind::PCH;
+#else
+      c->getPreprocessorOpts().DisablePCHValidation = true;
+#endif
+   }
+
    if (args->num_headers) {
       ::llvm::SmallString<128> tmp_header_path;
       ::llvm::sys::path::system_temp_directory(true, tmp_header_path);
@@ -23,77 +23,55 @@
 
 #include "D3D12ResourceState.h"
 
+constexpr D3D12_RESOURCE_STATES RESOURCE_STATE_SHADER_RESOURCE_BITS =
+D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE  |
+D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+
 //----------------------------------------------------------------------------------------------------------------------------------
- D3D12_RESOURCE_STATES CDesiredResourceState::GetSubresourceState(UINT SubresourceIndex) const
+D3D12_RESOURCE_STATES CDesiredResourceState::GetSubresourceState(UINT SubresourceIndex) const
 {
-   if (AreAllSubresourcesSame())
-   {
-      SubresourceIndex = 0;
-   }
-   return m_spSubresourceStates[SubresourceIndex];
+   return m_SubresourceStates.Get(SubresourceIndex);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
-void CDesiredResourceState::UpdateSubresourceState(unsigned SubresourceIndex, D3D12_RESOURCE_STATES state)
+/*static*/ D3D12_RESOURCE_STATES CDesiredResourceState::UpdatedState(D3D12_RESOURCE_STATES current, D3D12_RESOURCE_STATES state)
 {
-   assert(SubresourceIndex < m_spSubresourceStates.size());
-   if (m_spSubresourceStates[SubresourceIndex] == UNKNOWN_RESOURCE_STATE ||
+   if (current == UNKNOWN_RESOURCE_STATE ||
        state == UNKNOWN_RESOURCE_STATE ||
        IsD3D12WriteState(state))
    {
-      m_spSubresourceStates[SubresourceIndex] = state;
-   }
-   else
-   {
-      // Accumulate read state state bits
-      m_spSubresourceStates[SubresourceIndex] |= state;
+      return state;
    }
+   // Accumulate read state state bits
+   return current | state;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 void CDesiredResourceState::SetResourceState(D3D12_RESOURCE_STATES state)
 {
-   m_bAllSubresourcesSame = true;
-   UpdateSubresourceState(0, state);
+   // Only accumulate with the previous state if it was the same for the entire resource
+   D3D12_RESOURCE_STATES current = AreAllSubresourcesSame() ? m_SubresourceStates.Get(0) : UNKNOWN_RESOURCE_STATE;
+   m_SubresourceStates.SetAll(UpdatedState(current, state));
 }
     
 //----------------------------------------------------------------------------------------------------------------------------------
 void CDesiredResourceState::SetSubresourceState(UINT SubresourceIndex, D3D12_RESOURCE_STATES state)
 {
-   if (m_bAllSubresourcesSame && m_spSubresourceStates.size() > 1)
-   {
-      std::fill(m_spSubresourceStates.begin() + 1, m_spSubresourceStates.end(), m_spSubresourceStates[0]);
-      m_bAllSubresourcesSame = false;
-   }
-   if (m_spSubresourceStates.size() == 1)
-   {
-      SubresourceIndex = 0;
-   }
-   UpdateSubresourceState(SubresourceIndex, state);
+   D3D12_RESOURCE_STATES current = m_SubresourceStates.Get(SubresourceIndex);
+   m_SubresourceStates.SetRange(SubresourceIndex, SubresourceIndex + 1, UpdatedState(current, state));
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 void CDesiredResourceState::Reset()
 {
-   SetResourceState(UNKNOWN_RESOURCE_STATE);
-}
-
-//----------------------------------------------------------------------------------------------------------------------------------
-void CCurrentResourceState::ConvertToSubresourceTracking()
-{
-   if (m_bAllSubresourcesSame && m_spLogicalState.size() > 1)
-   {
-      std::fill(m_spLogicalState.begin() + 1, m_spLogicalState.end(), m_spLogicalState[0]);
-      m_bAllSubresourcesSame = false;
-   }
+   m_SubresourceStates.SetAll(UNKNOWN_RESOURCE_STATE);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 CCurrentResourceState::CCurrentResourceState(UINT SubresourceCount, bool bSimultaneousAccess)
    : m_bSimultaneousAccess(bSimultaneousAccess)
-   , m_spLogicalState(SubresourceCount)
+   , m_LogicalStates(SubresourceCount)
 {
-   m_spLogicalState[0] = LogicalState{};
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -131,38 +109,38 @@ D3D12_RESOURCE_STATES CCurrentResourceState::StateIfPromoted(D3D12_RESOURCE_STAT
 //----------------------------------------------------------------------------------------------------------------------------------
 void CCurrentResourceState::SetLogicalResourceState(LogicalState const& State)
 {
-   m_bAllSubresourcesSame = true;
-   m_spLogicalState[0] = State;
+   m_LogicalStates.SetAll(State);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 void CCurrentResourceState::SetLogicalSubresourceState(UINT SubresourceIndex, LogicalState const& State)
 {
-   ConvertToSubresourceTracking();
-   m_spLogicalState[SubresourceIndex] = State;
+   m_LogicalStates.SetRange(SubresourceIndex, SubresourceIndex + 1, State);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void CCurrentResourceState::SetLogicalSubresourceRange(UINT StartSubresource, UINT EndSubresource, LogicalState const& State)
+{
+   m_LogicalStates.SetRange(StartSubresource, EndSubresource, State);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 auto CCurrentResourceState::GetLogicalSubresourceState(UINT SubresourceIndex) const -> LogicalState const&
 {
-   if (AreAllSubresourcesSame())
-   {
-      SubresourceIndex = 0;
-   }
-   return m_spLogicalState[SubresourceIndex];
+   return m_LogicalStates.Get(SubresourceIndex);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 void CCurrentResourceState::Reset()
 {
-   m_bAllSubresourcesSame = true;
-   m_spLogicalState[0] = LogicalState{};
+   m_LogicalStates.SetAll(LogicalState{});
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 ResourceStateManager::ResourceStateManager()
 {
    list_inithead(&m_TransitionListHead);
+   list_inithead(&m_SplitTransitionListHead);
    // Reserve some space in these vectors upfront. Values are arbitrary.
    m_vResourceBarriers.reserve(50);
 }
@@ -225,23 +203,62 @@ void ResourceStateManager::ApplyResourceTransitionsPreamble()
    {
       DestinationState |= CurrentState;
    }
+
+   // A resource read by one shader stage is often read by another next. Make it readable from both,
+   // so that doesn't need a read-to-read transition.
+   if (!IsD3D12WriteState(DestinationState) && (DestinationState & RESOURCE_STATE_SHADER_RESOURCE_BITS))
+   {
+      DestinationState |= RESOURCE_STATE_SHADER_RESOURCE_BITS;
+   }
    return true;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
-void ResourceStateManager::AddCurrentStateUpdate(TransitionableResourceState& Resource,
-                                                 CCurrentResourceState& CurrentState,
-                                                 UINT SubresourceIndex,
-                                                 const CCurrentResourceState::LogicalState &NewLogicalState)
+void ResourceStateManager::EndSplitTransition(TransitionableResourceState& Resource, UINT64 ExecutionId)
+{
+   CCurrentResourceState& CurrentState = Resource.GetCurrentState();
+
+   // Transitions of the resource end the split barrier first, so it's still in the state the barrier began from.
+   D3D12_RESOURCE_BARRIER TransitionDesc;
+   memset(&TransitionDesc, 0, sizeof(TransitionDesc));
+   TransitionDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+   TransitionDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+   TransitionDesc.Transition.pResource = Resource.GetD3D12Resource();
+   TransitionDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+   TransitionDesc.Transition.StateBefore = CurrentState.GetLogicalSubresourceState(0).State;
+   TransitionDesc.Transition.StateAfter = Resource.m_SplitTransitionState;
+   m_vResourceBarriers.push_back(TransitionDesc); // throw( bad_alloc )
+
+   CCurrentResourceState::LogicalState NewLogicalState{Resource.m_SplitTransitionState, ExecutionId, false, false};
+   CurrentState.SetLogicalResourceState(NewLogicalState);
+   list_delinit(&Resource.m_SplitTransitionListEntry);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void ResourceStateManager::CoalesceSubresourceBarriers(size_t FirstBarrier, UINT NumTotalSubresources)
 {
-   if (SubresourceIndex == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+   // Each subresource gets at most one barrier, so if there's one for every subresource and they all
+   // do the same transition, a single barrier for the entire resource does the same.
+   if (NumTotalSubresources < 2 || m_vResourceBarriers.size() - FirstBarrier != NumTotalSubresources)
    {
-      CurrentState.SetLogicalResourceState(NewLogicalState);
+      return;
    }
-   else
+
+   D3D12_RESOURCE_BARRIER Barrier = m_vResourceBarriers[FirstBarrier];
+   for (size_t i = FirstBarrier + 1; i < m_vResourceBarriers.size(); ++i)
    {
-      CurrentState.SetLogicalSubresourceState(SubresourceIndex, NewLogicalState);
+      D3D12_RESOURCE_BARRIER const& Other = m_vResourceBarriers[i];
+      if (Other.Flags != Barrier.Flags ||
+          Other.Transition.StateBefore != Barrier.Transition.StateBefore ||
+          Other.Transition.StateAfter != Barrier.Transition.StateAfter)
+      {
+         return;
+      }
    }
+
+   Barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+   m_vResourceBarriers.resize(FirstBarrier);
+   m_vResourceBarriers.push_back(Barrier);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -251,61 +268,70 @@ void ResourceStateManager::ProcessTransitioningResource(ID3D12Resource* pTransit
                                                             UINT NumTotalSubresources,
                                                             UINT64 ExecutionId)
 {
-   // Figure out the set of subresources that are transitioning
+   // A split barrier that was begun for this resource has to end before it's transitioned again
+   if (TransitionableResourceState.IsSplitTransitionPending())
+   {
+      EndSplitTransition(TransitionableResourceState, ExecutionId);
+   }
+
    auto& DestinationState = TransitionableResourceState.m_DesiredState;
-   bool bAllSubresourcesAtOnce = CurrentState.AreAllSubresourcesSame() && DestinationState.AreAllSubresourcesSame();
+   size_t FirstBarrier = m_vResourceBarriers.size();
 
    D3D12_RESOURCE_BARRIER TransitionDesc;
    memset(&TransitionDesc, 0, sizeof(TransitionDesc));
    TransitionDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
    TransitionDesc.Transition.pResource = pTransitioningResource;
 
-   UINT numSubresources = bAllSubresourcesAtOnce ? 1 : NumTotalSubresources;
-   for (UINT i = 0; i < numSubresources; ++i)
+   // Walk the ranges of subresources that have both the same current and the same desired state,
+   // so the work done depends on how fragmented the states are rather than on the subresource count.
+   for (UINT Start = 0, End; Start < NumTotalSubresources; Start = End)
    {
-      D3D12_RESOURCE_STATES SubresourceDestinationState = DestinationState.GetSubresourceState(i);
-      TransitionDesc.Transition.Subresource = bAllSubresourcesAtOnce ? D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES : i;
+      End = std::min(DestinationState.GetSubresourceRunEnd(Start), CurrentState.GetSubresourceRunEnd(Start));
 
-      // Is this subresource currently being used, or is it just being iterated over?
-      D3D12_RESOURCE_STATES after = DestinationState.GetSubresourceState(i);
+      // Are these subresources currently being used, or are they just being iterated over?
+      D3D12_RESOURCE_STATES after = DestinationState.GetSubresourceState(Start);
       if (after == UNKNOWN_RESOURCE_STATE)
       {
-            // This subresource doesn't have any transition requested - move on to the next.
-            continue;
+         // These subresources don't have any transition requested - move on to the next.
+         continue;
       }
 
-      ProcessTransitioningSubresourceExplicit(
+      ProcessTransitioningSubresources(
          CurrentState,
-         i,
-         SubresourceDestinationState,
+         Start,
+         End,
+         NumTotalSubresources,
          after,
-         TransitionableResourceState,
          TransitionDesc,
          ExecutionId); // throw( bad_alloc )
    }
 
+   CoalesceSubresourceBarriers(FirstBarrier, NumTotalSubresources);
+
    // Update destination states.
    // Coalesce destination state to ensure that it's set for the entire resource.
-   DestinationState.SetResourceState(UNKNOWN_RESOURCE_STATE);
+   DestinationState.Reset();
 
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
-void ResourceStateManager::ProcessTransitioningSubresourceExplicit(
+void ResourceStateManager::ProcessTransitioningSubresources(
    CCurrentResourceState& CurrentState,
-   UINT SubresourceIndex,
-   D3D12_RESOURCE_STATES state,
+   UINT StartSubresource,
+   UINT EndSubresource,
+   UINT NumTotalSubresources,
    D3D12_RESOURCE_STATES after,
-   TransitionableResourceState& TransitionableResourceState,
    D3D12_RESOURCE_BARRIER& TransitionDesc,
    UINT64 ExecutionId)
 {
+   bool bEntireResource = StartSubresource == 0 && EndSubresource == NumTotalSubresources;
+
    // Simultaneous access resources currently in the COMMON
    // state can be implicitly promoted to any state other state.
    // Any non-simultaneous-access resources currently in the
    // COMMON state can still be implicitly  promoted to SRV,
    // NON_PS_SRV, COPY_SRC, or COPY_DEST.
-   CCurrentResourceState::LogicalState CurrentLogicalState = CurrentState.GetLogicalSubresourceState(SubresourceIndex);
+   CCurrentResourceState::LogicalState CurrentLogicalState = CurrentState.GetLogicalSubresourceState(StartSubresource);
 
    // If the last time this logical state was set was in a different
    // execution period and is decayable then decay the current state
@@ -319,17 +345,30 @@ void ResourceStateManager::ProcessTransitioningSubresourceExplicit(
    bool IsPromotion = false;
 
    // If not promotable then StateIfPromoted will be D3D12_RESOURCE_STATE_COMMON
-   auto StateIfPromoted = CurrentState.StateIfPromoted(after, SubresourceIndex);
+   auto StateIfPromoted = CurrentState.StateIfPromoted(after, StartSubresource);
 
    if ( D3D12_RESOURCE_STATE_COMMON == StateIfPromoted )
    {
       if (TransitionRequired(CurrentLogicalState.State, /*inout*/ after))
       {
-         // Insert a single concrete barrier (for non-simultaneous access resources).
+         // Insert concrete barriers (for non-simultaneous access resources). D3D12 barriers name either a
+         // single subresource or all of them, so a partial range still needs one per subresource.
          TransitionDesc.Transition.StateBefore = D3D12_RESOURCE_STATES(CurrentLogicalState.State);
          TransitionDesc.Transition.StateAfter = D3D12_RESOURCE_STATES(after);
          assert(TransitionDesc.Transition.StateBefore != TransitionDesc.Transition.StateAfter);
-         m_vResourceBarriers.push_back(TransitionDesc); // throw( bad_alloc )
+         if (bEntireResource)
+         {
+            TransitionDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+            m_vResourceBarriers.push_back(TransitionDesc); // throw( bad_alloc )
+         }
+         else
+         {
+            for (UINT i = StartSubresource; i < EndSubresource; ++i)
+            {
+               TransitionDesc.Transition.Subresource = i;
+               m_vResourceBarriers.push_back(TransitionDesc); // throw( bad_alloc )
+            }
+         }
 
          MayDecay = CurrentState.SupportsSimultaneousAccess() && !IsD3D12WriteState(after);
          IsPromotion = false;
@@ -347,10 +386,14 @@ void ResourceStateManager::ProcessTransitioningSubresourceExplicit(
    }
 
    CCurrentResourceState::LogicalState NewLogicalState{after, ExecutionId, IsPromotion, MayDecay};
-   AddCurrentStateUpdate(TransitionableResourceState,
-                         CurrentState,
-                         TransitionDesc.Transition.Subresource,
-                         NewLogicalState);
+   if (bEntireResource)
+   {
+      CurrentState.SetLogicalResourceState(NewLogicalState);
+   }
+   else
+   {
+      CurrentState.SetLogicalSubresourceRange(StartSubresource, EndSubresource, NewLogicalState);
+   }
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -396,3 +439,62 @@ void ResourceStateManager::ApplyAllResourceTransitions(ID3D12GraphicsCommandList
 
    SubmitResourceTransitions(pCommandList);
 }
+
+//----------------------------------------------------------------------------------------------------------------------------------
+bool ResourceStateManager::BeginSplitTransition(ID3D12GraphicsCommandList *pCommandList,
+                                                TransitionableResourceState* pResource,
+                                                D3D12_RESOURCE_STATES State,
+                                                UINT64 ExecutionId)
+{
+   TransitionableResourceState& Resource = *pResource;
+   CCurrentResourceState& CurrentState = Resource.GetCurrentState();
+
+   if (Resource.IsTransitionPending() ||
+       Resource.IsSplitTransitionPending() ||
+       CurrentState.SupportsSimultaneousAccess() ||
+       !CurrentState.AreAllSubresourcesSame())
+   {
+      return false;
+   }
+
+   // Resources in the COMMON state are promoted without a barrier, and decayed ones are in COMMON.
+   CCurrentResourceState::LogicalState const& CurrentLogicalState = CurrentState.GetLogicalSubresourceState(0);
+   if (CurrentLogicalState.State == D3D12_RESOURCE_STATE_COMMON ||
+       (CurrentLogicalState.MayDecay && CurrentLogicalState.ExecutionId != ExecutionId))
+   {
+      return false;
+   }
+
+   D3D12_RESOURCE_STATES After = State;
+   if (!TransitionRequired(CurrentLogicalState.State, /*inout*/ After))
+   {
+      return false;
+   }
+
+   D3D12_RESOURCE_BARRIER TransitionDesc;
+   memset(&TransitionDesc, 0, sizeof(TransitionDesc));
+   TransitionDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+   TransitionDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+   TransitionDesc.Transition.pResource = Resource.GetD3D12Resource();
+   TransitionDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+   TransitionDesc.Transition.StateBefore = CurrentLogicalState.State;
+   TransitionDesc.Transition.StateAfter = After;
+   pCommandList->ResourceBarrier(1, &TransitionDesc);
+
+   Resource.m_SplitTransitionState = After;
+   list_add(&Resource.m_SplitTransitionListEntry, &m_SplitTransitionListHead);
+   return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+void ResourceStateManager::EndSplitTransitions(ID3D12GraphicsCommandList *pCommandList, UINT64 ExecutionId)
+{
+   ApplyResourceTransitionsPreamble();
+
+   list_for_each_entry_safe(TransitionableResourceState, pResource, &m_SplitTransitionListHead, m_SplitTransitionListEntry)
+   {
+      EndSplitTransition(*pResource, ExecutionId);
+   }
+
+   SubmitResourceTransitions(pCommandList);
+}
@@ -28,6 +28,7 @@
 #include <wsl/winadapter.h>
 #endif
 
+#include <algorithm>
 #include <vector>
 #include <assert.h>
 #include <directx/d3d12.h>
@@ -63,6 +64,84 @@ inline bool SupportsSimultaneousAccess(const D3D12_RESOURCE_DESC &desc)
           !!(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS);
 }
 
+//==================================================================================================================================
+// CSubresourceRuns
+// Run-length encoded value per subresource. Each run holds the value of the subresources from its start up to the next run's.
+// Adjacent runs never hold the same value, so a resource with all subresources alike has a single run, and the cost of
+// lookups and updates depends on the number of distinct ranges rather than the number of subresources.
+//==================================================================================================================================
+template <typename T>
+class CSubresourceRuns
+{
+private:
+   struct Run
+   {
+      UINT Start;
+      T Value;
+   };
+
+   std::vector<Run> m_Runs;
+   UINT m_Count;
+
+   size_t FindRun(UINT Index) const
+   {
+      assert(Index < m_Count);
+      auto it = std::upper_bound(m_Runs.begin(), m_Runs.end(), Index,
+                                 [](UINT i, Run const& run) { return i < run.Start; });
+      return (it - m_Runs.begin()) - 1;
+   }
+
+public:
+   CSubresourceRuns(UINT Count, T const& Value = T()) :
+      m_Runs(1, Run{0, Value}),
+      m_Count(Count)
+   {
+   }
+
+   bool IsUniform() const { return m_Runs.size() == 1; }
+
+   T const& Get(UINT Index) const { return m_Runs[FindRun(Index)].Value; }
+
+   // Returns the end of the run containing Index: all subresources from Index up to there have the same value.
+   UINT RunEnd(UINT Index) const
+   {
+      size_t Next = FindRun(Index) + 1;
+      return Next < m_Runs.size() ? m_Runs[Next].Start : m_Count;
+   }
+
+   void SetAll(T const& Value) { m_Runs.assign(1, Run{0, Value}); }
+
+   // Sets the value of subresources [Start, End).
+   void SetRange(UINT Start, UINT End, T const& Value)
+   {
+      assert(Start < End && End <= m_Count);
+
+      size_t First = FindRun(Start);
+      size_t Last = FindRun(End - 1);
+      UINT LastEnd = Last + 1 < m_Runs.size() ? m_Runs[Last + 1].Start : m_Count;
+      T Tail = m_Runs[Last].Value;
+      bool NeedTail = LastEnd > End && !(Tail == Value);
+
+      // Drop the runs starting inside the range, then put the new one in their place,
+      // merging it with the runs around it when they hold the same value.
+      size_t Pos = m_Runs[First].Start < Start ? First + 1 : First;
+      m_Runs.erase(m_Runs.begin() + Pos, m_Runs.begin() + Last + 1);
+
+      if (Pos == 0 || !(m_Runs[Pos - 1].Value == Value))
+      {
+         m_Runs.insert(m_Runs.begin() + Pos++, Run{Start, Value});
+      }
+      if (NeedTail)
+      {
+         m_Runs.insert(m_Runs.begin() + Pos, Run{End, Tail});
+      }
+      else if (Pos < m_Runs.size() && m_Runs[Pos].Value == Value)
+      {
+         m_Runs.erase(m_Runs.begin() + Pos);
+      }
+   }
+};
+
 //==================================================================================================================================
 // CDesiredResourceState
 // Stores the current desired state of either an entire resource, or each subresource.
@@ -70,17 +149,18 @@ inline bool SupportsSimultaneousAccess(const D3D12_RESOURCE_DESC &desc)
 class CDesiredResourceState
 {
 private:
-   bool m_bAllSubresourcesSame = true;
-
-   std::vector<D3D12_RESOURCE_STATES> m_spSubresourceStates;
+   CSubresourceRuns<D3D12_RESOURCE_STATES> m_SubresourceStates;
 
 public:
    CDesiredResourceState(UINT SubresourceCount) :
-      m_spSubresourceStates(SubresourceCount)
+      m_SubresourceStates(SubresourceCount, D3D12_RESOURCE_STATES(0))
    {
    }
 
-   bool AreAllSubresourcesSame() const { return m_bAllSubresourcesSame; }
+   bool AreAllSubresourcesSame() const { return m_SubresourceStates.IsUniform(); }
+
+   // Returns the end of the range of subresources starting at SubresourceIndex that have the same desired state.
+   UINT GetSubresourceRunEnd(UINT SubresourceIndex) const { return m_SubresourceStates.RunEnd(SubresourceIndex); }
 
    D3D12_RESOURCE_STATES GetSubresourceState(UINT SubresourceIndex) const;
    void SetResourceState(D3D12_RESOURCE_STATES state);
@@ -89,7 +169,7 @@ public:
    void Reset();
 
 private:
-   void UpdateSubresourceState(unsigned SubresourceIndex, D3D12_RESOURCE_STATES state);
+   static D3D12_RESOURCE_STATES UpdatedState(D3D12_RESOURCE_STATES current, D3D12_RESOURCE_STATES state);
 };
 
 //==================================================================================================================================
@@ -106,15 +186,18 @@ public:
       UINT64 ExecutionId = 0;
       bool IsPromotedState = false;
       bool MayDecay = false;
+
+      bool operator==(LogicalState const& Other) const
+      {
+         return State == Other.State && ExecutionId == Other.ExecutionId &&
+                IsPromotedState == Other.IsPromotedState && MayDecay == Other.MayDecay;
+      }
    };
 
 private:
    const bool m_bSimultaneousAccess;
-   bool m_bAllSubresourcesSame = true;
-
-   std::vector<LogicalState> m_spLogicalState;
 
-   void ConvertToSubresourceTracking();
+   CSubresourceRuns<LogicalState> m_LogicalStates;
 
 public:
    CCurrentResourceState(UINT SubresourceCount, bool bSimultaneousAccess);
@@ -125,10 +208,15 @@ public:
    // Returns D3D12_RESOURCE_STATE_COMMON if not.
    D3D12_RESOURCE_STATES StateIfPromoted(D3D12_RESOURCE_STATES state, UINT SubresourceIndex);
 
-   bool AreAllSubresourcesSame() const { return m_bAllSubresourcesSame; }
+   bool AreAllSubresourcesSame() const { return m_LogicalStates.IsUniform(); }
+
+   // Returns the end of the range of subresources starting at SubresourceIndex that are in the same state.
+   UINT GetSubresourceRunEnd(UINT SubresourceIndex) const { return m_LogicalStates.RunEnd(SubresourceIndex); }
 
    void SetLogicalResourceState(LogicalState const& State);
    void SetLogicalSubresourceState(UINT SubresourceIndex, LogicalState const& State);
+   // Sets the state of subresources [StartSubresource, EndSubresource).
+   void SetLogicalSubresourceRange(UINT StartSubresource, UINT EndSubresource, LogicalState const& State);
    LogicalState const& GetLogicalSubresourceState(UINT SubresourceIndex) const;
 
    void Reset();
@@ -143,6 +231,11 @@ struct TransitionableResourceState
    struct list_head m_TransitionListEntry;
    CDesiredResourceState m_DesiredState;
 
+   // Entry in the list of resources with a split barrier that was begun but not ended,
+   // and the state that barrier transitions the entire resource to.
+   struct list_head m_SplitTransitionListEntry;
+   D3D12_RESOURCE_STATES m_SplitTransitionState = D3D12_RESOURCE_STATE_COMMON;
+
    TransitionableResourceState(ID3D12Resource *pResource, UINT TotalSubresources, bool SupportsSimultaneousAccess) :
       m_DesiredState(TotalSubresources),
       m_TotalSubresources(TotalSubresources),
@@ -150,6 +243,7 @@ struct TransitionableResourceState
       m_pResource(pResource)
    {
       list_inithead(&m_TransitionListEntry);
+      list_inithead(&m_SplitTransitionListEntry);
    }
 
    ~TransitionableResourceState()
@@ -158,9 +252,14 @@ struct TransitionableResourceState
       {
          list_del(&m_TransitionListEntry);
       }
+      if (IsSplitTransitionPending())
+      {
+         list_del(&m_SplitTransitionListEntry);
+      }
    }
 
    bool IsTransitionPending() const { return !list_is_empty(&m_TransitionListEntry); }
+   bool IsSplitTransitionPending() const { return !list_is_empty(&m_SplitTransitionListEntry); }
 
    UINT NumSubresources() { return m_TotalSubresources; }
 
@@ -203,12 +302,23 @@ private:
 // Only once all of this has been done do we update the "current" state of resources,
 // because this is the only way that we know whether or not the destination queue has been flushed,
 // and therefore, we can get the correct fence values to store in the subresources.
+//
+// Barriers are kept to a minimum: when every subresource of a resource tracked per subresource gets the
+// same transition, a single barrier for the entire resource is emitted instead, and the resource goes back
+// to being tracked as a whole. Transitions to a shader resource state go to both shader resource states,
+// so that using the resource from another stage doesn't need a read-to-read transition.
+//
+// When the next use of a resource is known ahead of time, BeginSplitTransition starts a BEGIN_ONLY barrier
+// to that state. The matching END_ONLY barrier is emitted when the resource is next transitioned, or by
+// EndSplitTransitions before the command list is closed, so that the GPU can overlap the transition with
+// the work recorded in between.
 //==================================================================================================================================
 class ResourceStateManager
 {
 protected:
 
    struct list_head m_TransitionListHead;
+   struct list_head m_SplitTransitionListHead;
 
    std::vector<D3D12_RESOURCE_BARRIER> m_vResourceBarriers;
 
@@ -219,6 +329,7 @@ public:
    {
       // All resources should be gone by this point, and each resource ensures it is no longer in this list.
       assert(list_is_empty(&m_TransitionListHead));
+      assert(list_is_empty(&m_SplitTransitionListHead));
    }
 
    // Call the D3D12 APIs to perform the resource barriers, command list submission, and command queue sync
@@ -236,6 +347,17 @@ public:
    // Submit all barriers and queue sync.
    void ApplyAllResourceTransitions(ID3D12GraphicsCommandList *pCommandList, UINT64 ExecutionId);
 
+   // Begin a split barrier transitioning the entire resource to the state it will be used in next.
+   // Returns false, without a barrier, if the resource has transitions pending, is tracked per
+   // subresource, or doesn't need a barrier to get to that state.
+   bool BeginSplitTransition(ID3D12GraphicsCommandList *pCommandList,
+                             TransitionableResourceState* pResource,
+                             D3D12_RESOURCE_STATES State,
+                             UINT64 ExecutionId);
+
+   // End all split barriers that were begun; split barriers can't span command lists.
+   void EndSplitTransitions(ID3D12GraphicsCommandList *pCommandList, UINT64 ExecutionId);
+
 private:
    // These methods set the destination state of the resource/subresources and ensure it's in the transition list.
    void TransitionResource(TransitionableResourceState& Resource,
@@ -280,17 +402,16 @@ private:
 private:
    // Helpers
    static bool TransitionRequired(D3D12_RESOURCE_STATES CurrentState, D3D12_RESOURCE_STATES& DestinationState);
-   void AddCurrentStateUpdate(TransitionableResourceState& Resource,
-                              CCurrentResourceState& CurrentState,
-                              UINT SubresourceIndex,
-                              const CCurrentResourceState::LogicalState &NewLogicalState);
-   void ProcessTransitioningSubresourceExplicit(CCurrentResourceState& CurrentState,
-                                                UINT i,
-                                                D3D12_RESOURCE_STATES state,
-                                                D3D12_RESOURCE_STATES after,
-                                                TransitionableResourceState& TransitionableResourceState,
-                                                D3D12_RESOURCE_BARRIER& TransitionDesc,
-                                                UINT64 ExecutionId);
+   void EndSplitTransition(TransitionableResourceState& Resource, UINT64 ExecutionId);
+   void CoalesceSubresourceBarriers(size_t FirstBarrier, UINT NumTotalSubresources);
+   // Transitions subresources [StartSubresource, EndSubresource), which are all in the same current state.
+   void ProcessTransitioningSubresources(CCurrentResourceState& CurrentState,
+                                         UINT StartSubresource,
+                                         UINT EndSubresource,
+                                         UINT NumTotalSubresources,
+                                         D3D12_RESOURCE_STATES after,
+                                         D3D12_RESOURCE_BARRIER& TransitionDesc,
+                                         UINT64 ExecutionId);
 };
 
 #endif // D3D12_RESOURCE_STATE_H
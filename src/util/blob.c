@@ -136,6 +136,26 @@ blob_finish_get_buffer(struct blob *blob, void **buffer, size_t *size)
    *buffer = realloc(*buffer, *size);
 }
 
+bool
+blob_ensure_capacity(struct blob *blob, size_t size)
+{
+   if (blob->out_of_memory || blob->fixed_allocation ||
+       blob->size + size <= blob->allocated)
+      return grow_to_fit(blob, size);
+
+   /* Allocate exactly what was asked for, rather than doubling. */
+   uint8_t *new_data = realloc(blob->data, blob->size + size);
+   if (new_data == NULL) {
+      blob->out_of_memory = true;
+      return false;
+   }
+
+   blob->data = new_data;
+   blob->allocated = blob->size + size;
+
+   return true;
+}
+
 bool
 blob_overwrite_bytes(struct blob *blob,
                      size_t offset,
@@ -120,6 +120,16 @@ blob_finish(struct blob *blob)
 void
 blob_finish_get_buffer(struct blob *blob, void **buffer, size_t *size);
 
+/**
+ * Make sure that \size more bytes can be written to \blob without growing
+ * it, for callers which know how much they are going to write. Unlike
+ * \sa blob_reserve_bytes, this doesn't change the size of the blob.
+ *
+ * \return True unless allocation failed.
+ */
+bool
+blob_ensure_capacity(struct blob *blob, size_t size);
+
 /**
  * Add some unstructured, fixed-size data to a blob.
  *
@@ -33,9 +33,15 @@
  */
 
 
+#include <string.h>
+
 #ifdef HAVE_ZLIB
 #include <zlib.h>
 #endif
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+#include "c11/threads.h"
 #include "crc32.h"
 
 
@@ -108,6 +114,29 @@ util_crc32_table[256] = {
 };
 
 
+#if UTIL_ARCH_LITTLE_ENDIAN && !defined(__ARM_FEATURE_CRC32)
+/* Tables for processing 8 bytes at a time ("slicing-by-8") without zlib,
+ * where util_crc32_slice_table[n][i] is the CRC of byte i followed by n + 1
+ * zero bytes.
+ */
+static uint32_t util_crc32_slice_table[7][256];
+static once_flag util_crc32_slice_once = ONCE_FLAG_INIT;
+
+static void
+util_crc32_init_slice_table(void)
+{
+   for (unsigned i = 0; i < 256; i++) {
+      uint32_t crc = util_crc32_table[i];
+
+      for (unsigned n = 0; n < 7; n++) {
+         crc = util_crc32_table[crc & 0xff] ^ (crc >> 8);
+         util_crc32_slice_table[n][i] = crc;
+      }
+   }
+}
+#endif
+
+
 /**
  * @sa http://www.w3.org/TR/PNG/#D-CRCAppendix
  */
@@ -116,7 +145,15 @@ util_hash_crc32(const void *data, size_t size)
 {
    const uint8_t *p = data;
    uint32_t crc = 0xffffffff;
- 
+
+#if defined(__ARM_FEATURE_CRC32)
+   /* The ARMv8 CRC32 instructions use the same polynomial as we do. */
+   for (; size >= 8; p += 8, size -= 8) {
+      uint64_t v;
+      memcpy(&v, p, sizeof(v));
+      crc = __crc32d(crc, v);
+   }
+#else
 #ifdef HAVE_ZLIB
    /* Prefer zlib's implementation for better performance.
     * zlib's uInt is always "unsigned int" while size_t can be 64bit.
@@ -127,8 +164,29 @@ util_hash_crc32(const void *data, size_t size)
       return ~crc32(0, data, size);
 #endif
 
+#if UTIL_ARCH_LITTLE_ENDIAN
+   call_once(&util_crc32_slice_once, util_crc32_init_slice_table);
+
+   for (; size >= 8; p += 8, size -= 8) {
+      uint32_t lo, hi;
+      memcpy(&lo, p, sizeof(lo));
+      memcpy(&hi, p + 4, sizeof(hi));
+      lo ^= crc;
+
+      crc = util_crc32_slice_table[6][lo & 0xff] ^
+            util_crc32_slice_table[5][(lo >> 8) & 0xff] ^
+            util_crc32_slice_table[4][(lo >> 16) & 0xff] ^
+            util_crc32_slice_table[3][lo >> 24] ^
+            util_crc32_slice_table[2][hi & 0xff] ^
+            util_crc32_slice_table[1][(hi >> 8) & 0xff] ^
+            util_crc32_slice_table[0][(hi >> 16) & 0xff] ^
+            util_crc32_table[hi >> 24];
+   }
+#endif
+#endif
+
    while (size--)
       crc = util_crc32_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
-   
+
    return crc;
 }
@@ -39,6 +39,7 @@
 
 #include "util/crc32.h"
 #include "util/debug.h"
+#include "util/hash_table.h"
 #include "util/rand_xor.h"
 #include "util/u_atomic.h"
 #include "util/mesa-sha1.h"
@@ -62,15 +63,151 @@
  */
 #define CACHE_VERSION 1
 
+/* Upper bound of the memory used by the in-memory LRU in front of the cache
+ * files. Entries larger than a quarter of it are not kept in memory, so that
+ * a single big item doesn't flush everything else.
+ */
+#define CACHE_RAM_MAX_SIZE (32 * 1024 * 1024)
+
+struct disk_cache_ram_entry {
+   struct list_head link;
+   cache_key key;
+   size_t size;
+   uint8_t data[];
+};
+
 #define DRV_KEY_CPY(_dst, _src, _src_size) \
 do {                                       \
    memcpy(_dst, _src, _src_size);          \
    _dst += _src_size;                      \
 } while (0);
 
+static uint32_t
+ram_key_hash(const void *key)
+{
+   /* Keys are SHA-1 hashes already. */
+   uint32_t hash;
+   memcpy(&hash, key, sizeof(hash));
+   return hash;
+}
+
+static bool
+ram_key_equals(const void *a, const void *b)
+{
+   return memcmp(a, b, CACHE_KEY_SIZE) == 0;
+}
+
+static void
+ram_remove_entry(struct disk_cache *cache, struct hash_entry *he)
+{
+   struct disk_cache_ram_entry *entry = he->data;
+
+   _mesa_hash_table_remove(cache->ram_ht, he);
+   list_del(&entry->link);
+   cache->ram_size -= entry->size;
+   free(entry);
+}
+
+/* Return a malloc'ed copy of the in-memory entry for \key, or NULL. */
+static void *
+ram_get(struct disk_cache *cache, const cache_key key, size_t *size)
+{
+   void *data = NULL;
+
+   simple_mtx_lock(&cache->ram_mtx);
+   struct hash_entry *he = _mesa_hash_table_search(cache->ram_ht, key);
+   if (he) {
+      struct disk_cache_ram_entry *entry = he->data;
+
+      data = malloc(entry->size);
+      if (data) {
+         memcpy(data, entry->data, entry->size);
+         if (size)
+            *size = entry->size;
+      }
+      list_del(&entry->link);
+      list_addtail(&entry->link, &cache->ram_lru);
+   }
+   simple_mtx_unlock(&cache->ram_mtx);
+
+   return data;
+}
+
+static bool
+ram_has(struct disk_cache *cache, const cache_key key)
+{
+   simple_mtx_lock(&cache->ram_mtx);
+   bool found = _mesa_hash_table_search(cache->ram_ht, key) != NULL;
+   simple_mtx_unlock(&cache->ram_mtx);
+
+   return found;
+}
+
+static void
+ram_put(struct disk_cache *cache, const cache_key key, const void *data,
+        size_t size)
+{
+   if (size > cache->ram_max_size / 4)
+      return;
+
+   struct disk_cache_ram_entry *entry =
+      malloc(sizeof(struct disk_cache_ram_entry) + size);
+   if (!entry)
+      return;
+
+   memcpy(entry->key, key, CACHE_KEY_SIZE);
+   memcpy(entry->data, data, size);
+   entry->size = size;
+
+   simple_mtx_lock(&cache->ram_mtx);
+
+   struct hash_entry *he = _mesa_hash_table_search(cache->ram_ht, key);
+   if (he)
+      ram_remove_entry(cache, he);
+
+   while (cache->ram_size + size > cache->ram_max_size) {
+      struct disk_cache_ram_entry *lru =
+         list_first_entry(&cache->ram_lru, struct disk_cache_ram_entry, link);
+      ram_remove_entry(cache,
+                       _mesa_hash_table_search(cache->ram_ht, lru->key));
+   }
+
+   _mesa_hash_table_insert(cache->ram_ht, entry->key, entry);
+   list_addtail(&entry->link, &cache->ram_lru);
+   cache->ram_size += size;
+
+   simple_mtx_unlock(&cache->ram_mtx);
+}
+
+static void
+ram_remove(struct disk_cache *cache, const cache_key key)
+{
+   simple_mtx_lock(&cache->ram_mtx);
+   struct hash_entry *he = _mesa_hash_table_search(cache->ram_ht, key);
+   if (he)
+      ram_remove_entry(cache, he);
+   simple_mtx_unlock(&cache->ram_mtx);
+}
+
+/* We don't know which entry an eviction of a random cache file removed, so
+ * drop all of them, to not return items the cache has given up on.
+ */
+static void
+ram_clear(struct disk_cache *cache)
+{
+   simple_mtx_lock(&cache->ram_mtx);
+   list_for_each_entry_safe(struct disk_cache_ram_entry, entry,
+                            &cache->ram_lru, link)
+      free(entry);
+   list_inithead(&cache->ram_lru);
+   _mesa_hash_table_clear(cache->ram_ht, NULL);
+   cache->ram_size = 0;
+   simple_mtx_unlock(&cache->ram_mtx);
+}
+
 struct disk_cache *
-disk_cache_create(const char *gpu_name, const char *driver_id,
-                  uint64_t driver_flags)
+disk_cache_type_create(const char *gpu_name, const char *driver_id,
+                       uint64_t driver_flags, enum disk_cache_type cache_type)
 {
    void *local;
    struct disk_cache *cache = NULL;
@@ -94,6 +231,7 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
 
    /* Assume failure. */
    cache->path_init_failed = true;
+   cache->type = cache_type;
 
 #ifdef ANDROID
    /* Android needs the "disk cache" to be enabled for
@@ -103,7 +241,8 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    goto path_fail;
 #endif
 
-   char *path = disk_cache_generate_cache_dir(local, gpu_name, driver_id);
+   char *path = disk_cache_generate_cache_dir(local, gpu_name, driver_id,
+                                              cache_type);
    if (!path)
       goto path_fail;
 
@@ -111,7 +250,7 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    if (cache->path == NULL)
       goto path_fail;
 
-   if (env_var_as_boolean("MESA_DISK_CACHE_SINGLE_FILE", false)) {
+   if (cache->type == DISK_CACHE_SINGLE_FILE) {
       if (!disk_cache_load_cache_index(local, cache))
          goto path_fail;
    }
@@ -161,6 +300,15 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
 
    cache->max_size = max_size;
 
+   cache->ram_ht = _mesa_hash_table_create(cache, ram_key_hash,
+                                           ram_key_equals);
+   if (!cache->ram_ht)
+      goto fail;
+
+   simple_mtx_init(&cache->ram_mtx, mtx_plain);
+   list_inithead(&cache->ram_lru);
+   cache->ram_max_size = MIN2(max_size, CACHE_RAM_MAX_SIZE);
+
    /* 4 threads were chosen below because just about all modern CPUs currently
     * available that run Mesa have *at least* 4 cores. For these CPUs allowing
     * more threads can result in the queue being processed faster, thus
@@ -169,12 +317,15 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
     * flag this should have little negative impact on low core systems.
     *
     * The queue will resize automatically when it's full, so adding new jobs
-    * doesn't stall.
+    * doesn't stall. Work stealing keeps the threads that compile shaders
+    * from contending on one lock when they all store their results at once,
+    * and lets prefetches run after the writes.
     */
    if (!util_queue_init(&cache->cache_queue, "disk$", 32, 4,
                         UTIL_QUEUE_INIT_RESIZE_IF_FULL |
                         UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY |
-                        UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY))
+                        UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY |
+                        UTIL_QUEUE_INIT_WORK_STEALING))
       goto fail;
 
    cache->path_init_failed = false;
@@ -226,6 +377,19 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    return NULL;
 }
 
+struct disk_cache *
+disk_cache_create(const char *gpu_name, const char *driver_id,
+                  uint64_t driver_flags)
+{
+   enum disk_cache_type cache_type = DISK_CACHE_MULTI_FILE;
+
+   if (env_var_as_boolean("MESA_DISK_CACHE_SINGLE_FILE", false))
+      cache_type = DISK_CACHE_SINGLE_FILE;
+
+   return disk_cache_type_create(gpu_name, driver_id, driver_flags,
+                                 cache_type);
+}
+
 void
 disk_cache_destroy(struct disk_cache *cache)
 {
@@ -233,10 +397,13 @@ disk_cache_destroy(struct disk_cache *cache)
       util_queue_finish(&cache->cache_queue);
       util_queue_destroy(&cache->cache_queue);
 
-      if (env_var_as_boolean("MESA_DISK_CACHE_SINGLE_FILE", false))
+      if (cache->type == DISK_CACHE_SINGLE_FILE)
          foz_destroy(&cache->foz_db);
 
       disk_cache_destroy_mmap(cache);
+
+      ram_clear(cache);
+      simple_mtx_destroy(&cache->ram_mtx);
    }
 
    ralloc_free(cache);
@@ -256,6 +423,7 @@ disk_cache_remove(struct disk_cache *cache, const cache_key key)
       return;
    }
 
+   ram_remove(cache, key);
    disk_cache_evict_item(cache, filename);
 }
 
@@ -324,8 +492,11 @@ cache_put(void *job, int thread_index)
    char *filename = NULL;
    struct disk_cache_put_job *dc_job = (struct disk_cache_put_job *) job;
 
-   if (env_var_as_boolean("MESA_DISK_CACHE_SINGLE_FILE", false)) {
+   if (dc_job->cache->type == DISK_CACHE_SINGLE_FILE) {
       disk_cache_write_item_to_disk_foz(dc_job);
+
+      if (disk_cache_compact_foz(dc_job->cache))
+         ram_clear(dc_job->cache);
    } else {
       filename = disk_cache_get_cache_filename(dc_job->cache, dc_job->key);
       if (filename == NULL)
@@ -338,6 +509,9 @@ cache_put(void *job, int thread_index)
          i++;
       }
 
+      if (i)
+         ram_clear(dc_job->cache);
+
       disk_cache_write_item_to_disk(dc_job, filename);
 
 done:
@@ -358,6 +532,8 @@ disk_cache_put(struct disk_cache *cache, const cache_key key,
    if (cache->path_init_failed)
       return;
 
+   ram_put(cache, key, data, size);
+
    struct disk_cache_put_job *dc_job =
       create_put_job(cache, key, data, size, cache_item_metadata);
 
@@ -368,6 +544,20 @@ disk_cache_put(struct disk_cache *cache, const cache_key key,
    }
 }
 
+static void *
+load_item(struct disk_cache *cache, const cache_key key, size_t *size)
+{
+   if (cache->type == DISK_CACHE_SINGLE_FILE) {
+      return disk_cache_load_item_foz(cache, key, size);
+   } else {
+      char *filename = disk_cache_get_cache_filename(cache, key);
+      if (filename == NULL)
+         return NULL;
+
+      return disk_cache_load_item(cache, filename, size);
+   }
+}
+
 void *
 disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
 {
@@ -396,14 +586,73 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
       return blob;
    }
 
-   if (env_var_as_boolean("MESA_DISK_CACHE_SINGLE_FILE", false)) {
-      return disk_cache_load_item_foz(cache, key, size);
-   } else {
-      char *filename = disk_cache_get_cache_filename(cache, key);
-      if (filename == NULL)
-         return NULL;
+   if (cache->path_init_failed)
+      return NULL;
 
-      return disk_cache_load_item(cache, filename, size);
+   void *data = ram_get(cache, key, size);
+   if (data)
+      return data;
+
+   size_t data_size = 0;
+   data = load_item(cache, key, &data_size);
+   if (!data)
+      return NULL;
+
+   ram_put(cache, key, data, data_size);
+
+   if (size)
+      *size = data_size;
+   return data;
+}
+
+static void
+cache_prefetch(void *job, int thread_index)
+{
+   struct disk_cache_prefetch_job *dc_job =
+      (struct disk_cache_prefetch_job *) job;
+   struct disk_cache *cache = dc_job->cache;
+
+   if (ram_has(cache, dc_job->key))
+      return;
+
+   size_t size = 0;
+   void *data = load_item(cache, dc_job->key, &size);
+   if (data) {
+      ram_put(cache, dc_job->key, data, size);
+      free(data);
+   }
+}
+
+static void
+destroy_prefetch_job(void *job, int thread_index)
+{
+   free(job);
+}
+
+void
+disk_cache_prefetch(struct disk_cache *cache, const cache_key *keys,
+                    unsigned num_keys)
+{
+   if (cache->blob_get_cb || cache->path_init_failed)
+      return;
+
+   for (unsigned i = 0; i < num_keys; i++) {
+      if (ram_has(cache, keys[i]))
+         continue;
+
+      struct disk_cache_prefetch_job *dc_job =
+         malloc(sizeof(struct disk_cache_prefetch_job));
+      if (!dc_job)
+         return;
+
+      dc_job->cache = cache;
+      memcpy(dc_job->key, keys[i], sizeof(cache_key));
+
+      util_queue_fence_init(&dc_job->fence);
+      util_queue_add_job_with_priority(&cache->cache_queue, dc_job,
+                                       &dc_job->fence, cache_prefetch,
+                                       destroy_prefetch_job, 0,
+                                       UTIL_QUEUE_PRIORITY_LOW);
    }
 }
 
@@ -54,6 +54,16 @@ typedef uint8_t cache_key[CACHE_KEY_SIZE];
 #define CACHE_ITEM_TYPE_UNKNOWN  0x0
 #define CACHE_ITEM_TYPE_GLSL     0x1
 
+/* How the cache entries are stored on disk. */
+enum disk_cache_type {
+   /* One file per entry, in two level hex directories. */
+   DISK_CACHE_MULTI_FILE,
+   /* Entries appended to a single pack file with an index (see
+    * fossilize_db.h), compacted when the cache gets too large.
+    */
+   DISK_CACHE_SINGLE_FILE,
+};
+
 typedef void
 (*disk_cache_put_cb) (const void *key, signed long keySize,
                       const void *value, signed long valueSize);
@@ -175,6 +185,16 @@ struct disk_cache *
 disk_cache_create(const char *gpu_name, const char *timestamp,
                   uint64_t driver_flags);
 
+/**
+ * Create a new cache object using the storage backend \cache_type.
+ *
+ * disk_cache_create() picks the backend from the environment, with
+ * MESA_DISK_CACHE_SINGLE_FILE selecting DISK_CACHE_SINGLE_FILE.
+ */
+struct disk_cache *
+disk_cache_type_create(const char *gpu_name, const char *timestamp,
+                       uint64_t driver_flags, enum disk_cache_type cache_type);
+
 /**
  * Destroy a cache object, (freeing all associated resources).
  */
@@ -223,6 +243,17 @@ disk_cache_put(struct disk_cache *cache, const cache_key key,
 void *
 disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size);
 
+/**
+ * Start loading the items stored under the names in \keys in the background.
+ *
+ * Recently used items are kept in memory, so disk_cache_get() calls for the
+ * prefetched keys won't have to read the cache files, (unless the items have
+ * been evicted in the interim). Keys which aren't in the cache are ignored.
+ */
+void
+disk_cache_prefetch(struct disk_cache *cache, const cache_key *keys,
+                    unsigned num_keys);
+
 /**
  * Store the name \key within the cache, (without any associated data).
  *
@@ -268,6 +299,13 @@ disk_cache_create(const char *gpu_name, const char *timestamp,
    return NULL;
 }
 
+static inline struct disk_cache *
+disk_cache_type_create(const char *gpu_name, const char *timestamp,
+                       uint64_t driver_flags, enum disk_cache_type cache_type)
+{
+   return NULL;
+}
+
 static inline void
 disk_cache_destroy(struct disk_cache *cache) {
    return;
@@ -293,6 +331,13 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
    return NULL;
 }
 
+static inline void
+disk_cache_prefetch(struct disk_cache *cache, const cache_key *keys,
+                    unsigned num_keys)
+{
+   return;
+}
+
 static inline void
 disk_cache_put_key(struct disk_cache *cache, const cache_key key)
 {
@@ -529,6 +529,20 @@ create_cache_item_header_and_blob(struct disk_cache_put_job *dc_job,
    if (compressed_size == 0)
       goto fail;
 
+   size_t metadata_size = sizeof(uint32_t);
+   if (dc_job->cache_item_metadata.type == CACHE_ITEM_TYPE_GLSL) {
+      metadata_size += sizeof(uint32_t) +
+         dc_job->cache_item_metadata.num_keys * sizeof(cache_key);
+   }
+
+   /* Allocate the whole item at once. */
+   if (!blob_ensure_capacity(cache_blob,
+                             dc_job->cache->driver_keys_blob_size +
+                             metadata_size +
+                             sizeof(struct cache_entry_file_data) +
+                             compressed_size))
+      goto fail;
+
    /* Copy the driver_keys_blob, this can be used find information about the
     * mesa version that produced the entry or deal with hash collisions,
     * should that ever become a real problem.
@@ -692,10 +706,11 @@ disk_cache_write_item_to_disk(struct disk_cache_put_job *dc_job,
  */
 char *
 disk_cache_generate_cache_dir(void *mem_ctx, const char *gpu_name,
-                              const char *driver_id)
+                              const char *driver_id,
+                              enum disk_cache_type cache_type)
 {
    char *cache_dir_name = CACHE_DIR_NAME;
-   if (env_var_as_boolean("MESA_DISK_CACHE_SINGLE_FILE", false))
+   if (cache_type == DISK_CACHE_SINGLE_FILE)
       cache_dir_name = CACHE_DIR_NAME_SF;
 
    char *path = getenv("MESA_GLSL_CACHE_DIR");
@@ -756,7 +771,7 @@ disk_cache_generate_cache_dir(void *mem_ctx, const char *gpu_name,
          return NULL;
    }
 
-   if (env_var_as_boolean("MESA_DISK_CACHE_SINGLE_FILE", false)) {
+   if (cache_type == DISK_CACHE_SINGLE_FILE) {
       path = concatenate_and_mkdir(mem_ctx, path, driver_id);
       if (!path)
          return NULL;
@@ -820,6 +835,16 @@ disk_cache_write_item_to_disk_foz(struct disk_cache_put_job *dc_job)
    return r;
 }
 
+/* The single file cache can't drop individual entries, so once it is larger
+ * than the maximum size it is rewritten with only the most recently added
+ * entries, (see foz_compact). Returns true if entries were evicted.
+ */
+bool
+disk_cache_compact_foz(struct disk_cache *cache)
+{
+   return foz_compact(&cache->foz_db, cache->max_size);
+}
+
 bool
 disk_cache_load_cache_index(void *mem_ctx, struct disk_cache *cache)
 {
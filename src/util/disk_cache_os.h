@@ -33,6 +33,8 @@
 #else
 
 #include "util/fossilize_db.h"
+#include "util/list.h"
+#include "util/simple_mtx.h"
 
 /* Number of bits to mask off from a cache key to get an index. */
 #define CACHE_INDEX_KEY_BITS 16
@@ -48,6 +50,8 @@ struct disk_cache {
    char *path;
    bool path_init_failed;
 
+   enum disk_cache_type type;
+
    /* Thread queue for compressing and writing cache entries to disk */
    struct util_queue cache_queue;
 
@@ -75,6 +79,23 @@ struct disk_cache {
 
    disk_cache_put_cb blob_put_cb;
    disk_cache_get_cb blob_get_cb;
+
+   /* In-memory LRU of recently used entries, kept in front of the files.
+    * ram_lru is ordered from the least to the most recently used entry.
+    */
+   simple_mtx_t ram_mtx;
+   struct hash_table *ram_ht;
+   struct list_head ram_lru;
+   size_t ram_size;
+   size_t ram_max_size;
+};
+
+struct disk_cache_prefetch_job {
+   struct util_queue_fence fence;
+
+   struct disk_cache *cache;
+
+   cache_key key;
 };
 
 struct disk_cache_put_job {
@@ -95,7 +116,8 @@ struct disk_cache_put_job {
 
 char *
 disk_cache_generate_cache_dir(void *mem_ctx, const char *gpu_name,
-                              const char *driver_id);
+                              const char *driver_id,
+                              enum disk_cache_type cache_type);
 
 void
 disk_cache_evict_lru_item(struct disk_cache *cache);
@@ -116,6 +138,9 @@ disk_cache_get_cache_filename(struct disk_cache *cache, const cache_key key);
 bool
 disk_cache_write_item_to_disk_foz(struct disk_cache_put_job *dc_job);
 
+bool
+disk_cache_compact_foz(struct disk_cache *cache);
+
 void
 disk_cache_write_item_to_disk(struct disk_cache_put_job *dc_job,
                               char *filename);
@@ -37,6 +37,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -190,7 +192,11 @@ load_foz_dbs(struct foz_db *foz_db, FILE *db_idx, uint8_t file_idx,
           */
          hash_str[16] = '\0';
          uint64_t key = strtoull(hash_str, NULL, 16);
-         _mesa_hash_table_u64_insert(foz_db->index_db, key, entry);
+         _mesa_hash_table_u64_insert(read_only ? foz_db->index_db_ro :
+                                                 foz_db->index_db,
+                                     key, entry);
+         if (!read_only)
+            util_dynarray_append(&foz_db->entries, struct foz_db_entry *, entry);
 
          offset += header->payload_size;
       }
@@ -220,6 +226,26 @@ fail:
    return false;
 }
 
+/* Read only foz dbs never change while we use them, so map them to save
+ * readers the system calls.  If this fails entries are read with pread().
+ */
+static void
+map_foz_db(struct foz_db *foz_db, uint8_t file_idx)
+{
+   int fd = fileno(foz_db->file[file_idx]);
+   struct stat st;
+
+   if (fstat(fd, &st) < 0 || st.st_size <= 0)
+      return;
+
+   void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   if (map == MAP_FAILED)
+      return;
+
+   foz_db->map[file_idx] = map;
+   foz_db->map_size[file_idx] = st.st_size;
+}
+
 /* Here we open mesa cache foz dbs files. If the files exist we load the index
  * db into a hash table. The index db contains the offsets needed to later
  * read cache entries from the foz db containing the actual cache entries.
@@ -245,8 +271,12 @@ foz_prepare(struct foz_db *foz_db, char *cache_path)
       return false;
 
    simple_mtx_init(&foz_db->mtx, mtx_plain);
+   u_rwlock_init(&foz_db->compact_lock);
    foz_db->mem_ctx = ralloc_context(NULL);
+   foz_db->cache_path = ralloc_strdup(foz_db->mem_ctx, cache_path);
    foz_db->index_db = _mesa_hash_table_u64_create(NULL);
+   foz_db->index_db_ro = _mesa_hash_table_u64_create(NULL);
+   util_dynarray_init(&foz_db->entries, foz_db->mem_ctx);
 
    if (!load_foz_dbs(foz_db, foz_db->db_idx, 0, false))
       return false;
@@ -285,6 +315,7 @@ foz_prepare(struct foz_db *foz_db, char *cache_path)
       }
 
       fclose(db_idx);
+      map_foz_db(foz_db, file_idx);
       file_idx++;
 
       if (file_idx >= FOZ_MAX_DBS)
@@ -299,87 +330,171 @@ foz_destroy(struct foz_db *foz_db)
 {
    fclose(foz_db->db_idx);
    for (unsigned i = 0; i < FOZ_MAX_DBS; i++) {
+      if (foz_db->map[i])
+         munmap((void *)foz_db->map[i], foz_db->map_size[i]);
       if (foz_db->file[i])
          fclose(foz_db->file[i]);
    }
 
    if (foz_db->mem_ctx) {
       _mesa_hash_table_u64_destroy(foz_db->index_db, NULL);
+      _mesa_hash_table_u64_destroy(foz_db->index_db_ro, NULL);
       ralloc_free(foz_db->mem_ctx);
+      u_rwlock_destroy(&foz_db->compact_lock);
       simple_mtx_destroy(&foz_db->mtx);
    }
 }
 
-/* Here we lookup a cache entry in the index hash table. If an entry is found
- * we use the retrieved offset to read the cache entry from disk.
+/* Read the payload of an entry, either from the mapping of a read only foz
+ * db or with pread(), so that readers don't need to share a file offset.
  */
-void *
-foz_read_entry(struct foz_db *foz_db, const uint8_t *cache_key_160bit,
-               size_t *size)
+static void *
+read_entry_payload(struct foz_db *foz_db, const struct foz_db_entry *entry,
+                   const uint8_t *cache_key_160bit, size_t *size)
 {
-   uint64_t hash = truncate_hash_to_64bits(cache_key_160bit);
-
+   struct foz_payload_header header;
+   uint8_t file_idx = entry->file_idx;
+   const uint8_t *map = foz_db->map[file_idx];
    void *data = NULL;
 
-   if (!foz_db->alive)
+   /* Check for collision using full 160bit hash for increased assurance
+    * against potential collisions.
+    */
+   if (memcmp(cache_key_160bit, entry->key, 20) != 0)
       return NULL;
 
-   simple_mtx_lock(&foz_db->mtx);
+   if (map) {
+      size_t map_size = foz_db->map_size[file_idx];
 
-   struct foz_db_entry *entry =
-      _mesa_hash_table_u64_search(foz_db->index_db, hash);
-   if (!entry) {
-      simple_mtx_unlock(&foz_db->mtx);
-      return NULL;
-   }
+      if (entry->offset > map_size ||
+          map_size - entry->offset < sizeof(header))
+         return NULL;
+      memcpy(&header, map + entry->offset, sizeof(header));
 
-   uint8_t file_idx = entry->file_idx;
-   off_t offset = ftell(foz_db->file[file_idx]);
-   if (fseek(foz_db->file[file_idx], entry->offset, SEEK_SET) < 0)
-      goto fail;
+      if (header.payload_size > map_size - entry->offset - sizeof(header))
+         return NULL;
 
-   uint32_t header_size = sizeof(struct foz_payload_header);
-   if (fread(&entry->header, 1, header_size, foz_db->file[file_idx]) !=
-       header_size)
-      goto fail;
+      data = malloc(header.payload_size);
+      if (!data)
+         return NULL;
+      memcpy(data, map + entry->offset + sizeof(header), header.payload_size);
+   } else {
+      int fd = fileno(foz_db->file[file_idx]);
 
-   /* Check for collision using full 160bit hash for increased assurance
-    * against potential collisions.
-    */
-   for (int i = 0; i < 20; i++) {
-      if (cache_key_160bit[i] != entry->key[i])
+      if (pread(fd, &header, sizeof(header), entry->offset) !=
+          (ssize_t)sizeof(header))
+         return NULL;
+
+      data = malloc(header.payload_size);
+      if (!data)
+         return NULL;
+      if (pread(fd, data, header.payload_size, entry->offset + sizeof(header)) !=
+          (ssize_t)header.payload_size)
          goto fail;
    }
 
-   uint32_t data_sz = entry->header.payload_size;
-   data = malloc(data_sz);
-   if (fread(data, 1, data_sz, foz_db->file[file_idx]) != data_sz)
-      goto fail;
-
    /* verify checksum */
-   if (entry->header.crc != 0) {
-      if (util_hash_crc32(data, data_sz) != entry->header.crc)
+   if (header.crc != 0) {
+      if (util_hash_crc32(data, header.payload_size) != header.crc)
          goto fail;
    }
 
-   simple_mtx_unlock(&foz_db->mtx);
-
    if (size)
-      *size = data_sz;
-
-   /* Reset file offset to the end of the file ready for writing */
-   fseek(foz_db->file[file_idx], offset, SEEK_SET);
+      *size = header.payload_size;
 
    return data;
 
 fail:
    free(data);
+   return NULL;
+}
 
-   /* reading db entry failed. reset the file offset */
-   fseek(foz_db->file[file_idx], offset, SEEK_SET);
+/* Here we lookup a cache entry in the index hash tables. If an entry is found
+ * we use the retrieved offset to read the cache entry from disk.
+ *
+ * Entries of read only foz dbs take precedence, and their index never changes
+ * after foz_prepare() so it is searched without locking.  Entries are never
+ * modified once they are in an index, so they can be used after unlocking,
+ * but the default foz db may be rewritten by foz_compact() while we read it.
+ */
+void *
+foz_read_entry(struct foz_db *foz_db, const uint8_t *cache_key_160bit,
+               size_t *size)
+{
+   uint64_t hash = truncate_hash_to_64bits(cache_key_160bit);
+
+   if (!foz_db->alive)
+      return NULL;
+
+   struct foz_db_entry *entry =
+      _mesa_hash_table_u64_search(foz_db->index_db_ro, hash);
+   if (entry)
+      return read_entry_payload(foz_db, entry, cache_key_160bit, size);
+
+   void *data = NULL;
+
+   u_rwlock_rdlock(&foz_db->compact_lock);
+
+   simple_mtx_lock(&foz_db->mtx);
+   entry = _mesa_hash_table_u64_search(foz_db->index_db, hash);
    simple_mtx_unlock(&foz_db->mtx);
 
-   return NULL;
+   if (entry)
+      data = read_entry_payload(foz_db, entry, cache_key_160bit, size);
+
+   u_rwlock_rdunlock(&foz_db->compact_lock);
+
+   return data;
+}
+
+/* Append an entry to a foz db and its index, returning the offset of its
+ * header in *offset.
+ */
+static bool
+append_entry(FILE *file, FILE *db_idx, const char *hash_str,
+             const struct foz_payload_header *header, const void *blob,
+             uint64_t *offset)
+{
+   /* Write hash header to db */
+   if (fwrite(hash_str, 1, FOSSILIZE_BLOB_HASH_LENGTH, file) !=
+       FOSSILIZE_BLOB_HASH_LENGTH)
+      return false;
+
+   *offset = ftell(file);
+
+   /* Write db entry header */
+   if (fwrite(header, 1, sizeof(*header), file) != sizeof(*header))
+      return false;
+
+   /* Now write the db entry blob */
+   if (fwrite(blob, 1, header->payload_size, file) != header->payload_size)
+      return false;
+
+   /* Flush everything to file to reduce chance of cache corruption */
+   fflush(file);
+
+   /* Write hash header to index db */
+   if (fwrite(hash_str, 1, FOSSILIZE_BLOB_HASH_LENGTH, db_idx) !=
+       FOSSILIZE_BLOB_HASH_LENGTH)
+      return false;
+
+   struct foz_payload_header idx_header;
+   idx_header.uncompressed_size = sizeof(uint64_t);
+   idx_header.format = FOSSILIZE_COMPRESSION_NONE;
+   idx_header.payload_size = sizeof(uint64_t);
+   idx_header.crc = 0;
+
+   if (fwrite(&idx_header, 1, sizeof(idx_header), db_idx) !=
+       sizeof(idx_header))
+      return false;
+
+   if (fwrite(offset, 1, sizeof(uint64_t), db_idx) != sizeof(uint64_t))
+      return false;
+
+   /* Flush everything to file to reduce chance of cache corruption */
+   fflush(db_idx);
+
+   return true;
 }
 
 /* Here we write the cache entry to disk and store its offset in the index db.
@@ -393,6 +508,9 @@ foz_write_entry(struct foz_db *foz_db, const uint8_t *cache_key_160bit,
    if (!foz_db->alive)
       return false;
 
+   if (_mesa_hash_table_u64_search(foz_db->index_db_ro, hash))
+      return false;
+
    simple_mtx_lock(&foz_db->mtx);
 
    struct foz_db_entry *entry =
@@ -409,53 +527,21 @@ foz_write_entry(struct foz_db *foz_db, const uint8_t *cache_key_160bit,
    header.payload_size = blob_size;
    header.crc = util_hash_crc32(blob, blob_size);
 
-   /* Write hash header to db */
    char hash_str[FOSSILIZE_BLOB_HASH_LENGTH + 1]; /* 40 digits + null */
    _mesa_sha1_format(hash_str, cache_key_160bit);
-   if (fwrite(hash_str, 1, FOSSILIZE_BLOB_HASH_LENGTH, foz_db->file[0]) !=
-       FOSSILIZE_BLOB_HASH_LENGTH)
-      goto fail;
-
-   off_t offset = ftell(foz_db->file[0]);
-
-   /* Write db entry header */
-   if (fwrite(&header, 1, sizeof(header), foz_db->file[0]) != sizeof(header))
-      goto fail;
-
-   /* Now write the db entry blob */
-   if (fwrite(blob, 1, blob_size, foz_db->file[0]) != blob_size)
-      goto fail;
-
-   /* Flush everything to file to reduce chance of cache corruption */
-   fflush(foz_db->file[0]);
-
-   /* Write hash header to index db */
-   if (fwrite(hash_str, 1, FOSSILIZE_BLOB_HASH_LENGTH, foz_db->db_idx) !=
-       FOSSILIZE_BLOB_HASH_LENGTH)
-      goto fail;
-
-   header.uncompressed_size = sizeof(uint64_t);
-   header.format = FOSSILIZE_COMPRESSION_NONE;
-   header.payload_size = sizeof(uint64_t);
-   header.crc = 0;
 
-   if (fwrite(&header, 1, sizeof(header), foz_db->db_idx) !=
-       sizeof(header))
+   uint64_t offset;
+   if (!append_entry(foz_db->file[0], foz_db->db_idx, hash_str, &header, blob,
+                     &offset))
       goto fail;
 
-   if (fwrite(&offset, 1, sizeof(uint64_t), foz_db->db_idx) !=
-       sizeof(uint64_t))
-      goto fail;
-
-   /* Flush everything to file to reduce chance of cache corruption */
-   fflush(foz_db->db_idx);
-
    entry = ralloc(foz_db->mem_ctx, struct foz_db_entry);
    entry->header = header;
    entry->offset = offset;
    entry->file_idx = 0;
    _mesa_sha1_hex_to_sha1(entry->key, hash_str);
    _mesa_hash_table_u64_insert(foz_db->index_db, hash, entry);
+   util_dynarray_append(&foz_db->entries, struct foz_db_entry *, entry);
 
    simple_mtx_unlock(&foz_db->mtx);
 
@@ -465,6 +551,196 @@ fail:
    simple_mtx_unlock(&foz_db->mtx);
    return false;
 }
+
+/* Copy the entries of the default foz db from index \first on to new files,
+ * replacing those of the foz db on success.
+ */
+static bool
+rewrite_foz_db(struct foz_db *foz_db, unsigned first)
+{
+   struct foz_db_entry **entries = util_dynarray_begin(&foz_db->entries);
+   unsigned num_entries =
+      util_dynarray_num_elements(&foz_db->entries, struct foz_db_entry *);
+   char *filename = NULL, *idx_filename = NULL;
+   char *tmp_filename = NULL, *tmp_idx_filename = NULL;
+   FILE *file = NULL, *db_idx = NULL;
+   int old_fd = fileno(foz_db->file[0]);
+   bool ok = false;
+
+   struct hash_table_u64 *index_db = _mesa_hash_table_u64_create(NULL);
+   struct util_dynarray new_entries;
+   util_dynarray_init(&new_entries, foz_db->mem_ctx);
+
+   if (!create_foz_db_filenames(foz_db->cache_path, "foz_cache", &filename,
+                                &idx_filename))
+      goto out;
+
+   if (asprintf(&tmp_filename, "%s.tmp", filename) == -1) {
+      tmp_filename = NULL;
+      goto out;
+   }
+   if (asprintf(&tmp_idx_filename, "%s.tmp", idx_filename) == -1) {
+      tmp_idx_filename = NULL;
+      goto out;
+   }
+
+   file = fopen(tmp_filename, "w+b");
+   db_idx = fopen(tmp_idx_filename, "w+b");
+   if (!check_files_opened_successfully(file, db_idx)) {
+      file = db_idx = NULL;
+      goto out;
+   }
+
+   /* Keep other processes away from the new files, like from the old ones. */
+   if (flock(fileno(file), LOCK_EX | LOCK_NB) == -1 ||
+       flock(fileno(db_idx), LOCK_EX | LOCK_NB) == -1)
+      goto out;
+
+   if (fwrite(stream_reference_magic_and_version, 1,
+              sizeof(stream_reference_magic_and_version), file) !=
+       sizeof(stream_reference_magic_and_version) ||
+       fwrite(stream_reference_magic_and_version, 1,
+              sizeof(stream_reference_magic_and_version), db_idx) !=
+       sizeof(stream_reference_magic_and_version))
+      goto out;
+
+   for (unsigned i = first; i < num_entries; i++) {
+      struct foz_payload_header header;
+      if (pread(old_fd, &header, sizeof(header), entries[i]->offset) !=
+          (ssize_t)sizeof(header))
+         goto out;
+
+      void *blob = malloc(header.payload_size);
+      if (!blob)
+         goto out;
+
+      if (pread(old_fd, blob, header.payload_size,
+                entries[i]->offset + sizeof(header)) !=
+          (ssize_t)header.payload_size) {
+         free(blob);
+         goto out;
+      }
+
+      char hash_str[FOSSILIZE_BLOB_HASH_LENGTH + 1];
+      _mesa_sha1_format(hash_str, entries[i]->key);
+
+      uint64_t offset;
+      bool written = append_entry(file, db_idx, hash_str, &header, blob,
+                                  &offset);
+      free(blob);
+      if (!written)
+         goto out;
+
+      struct foz_db_entry *entry = ralloc(foz_db->mem_ctx, struct foz_db_entry);
+      *entry = *entries[i];
+      entry->offset = offset;
+      _mesa_hash_table_u64_insert(index_db,
+                                  truncate_hash_to_64bits(entry->key), entry);
+      util_dynarray_append(&new_entries, struct foz_db_entry *, entry);
+   }
+
+   if (rename(tmp_filename, filename) == -1)
+      goto out;
+
+   /* The new entries are in place, a stale index would point into them. */
+   if (rename(tmp_idx_filename, idx_filename) == -1)
+      unlink(idx_filename);
+
+   ok = true;
+
+out:
+   if (ok) {
+      fclose(foz_db->file[0]);
+      fclose(foz_db->db_idx);
+      foz_db->file[0] = file;
+      foz_db->db_idx = db_idx;
+
+      for (unsigned i = 0; i < num_entries; i++)
+         ralloc_free(entries[i]);
+      util_dynarray_fini(&foz_db->entries);
+      _mesa_hash_table_u64_destroy(foz_db->index_db, NULL);
+
+      foz_db->entries = new_entries;
+      foz_db->index_db = index_db;
+   } else {
+      if (file) {
+         fclose(file);
+         fclose(db_idx);
+         unlink(tmp_filename);
+         unlink(tmp_idx_filename);
+      }
+
+      util_dynarray_foreach(&new_entries, struct foz_db_entry *, entry)
+         ralloc_free(*entry);
+      util_dynarray_fini(&new_entries);
+      _mesa_hash_table_u64_destroy(index_db, NULL);
+   }
+
+   free(filename);
+   free(idx_filename);
+   free(tmp_filename);
+   free(tmp_idx_filename);
+
+   return ok;
+}
+
+/* The default foz db is append only, so entries are evicted by compacting it:
+ * once it is larger than max_size, it is rewritten with only the most
+ * recently written entries that fit in half of max_size, so that it doesn't
+ * need compacting again for a while.  The files are locked by this process,
+ * so nobody else can be using them.
+ *
+ * Returns true if entries were evicted.
+ */
+bool
+foz_compact(struct foz_db *foz_db, uint64_t max_size)
+{
+   if (!foz_db->alive)
+      return false;
+
+   simple_mtx_lock(&foz_db->mtx);
+   long size = ftell(foz_db->file[0]);
+   simple_mtx_unlock(&foz_db->mtx);
+
+   if (size < 0 || (uint64_t)size <= max_size)
+      return false;
+
+   u_rwlock_wrlock(&foz_db->compact_lock);
+   simple_mtx_lock(&foz_db->mtx);
+
+   /* Someone else might have compacted the foz db in the meantime. */
+   size = ftell(foz_db->file[0]);
+
+   struct foz_db_entry **entries = util_dynarray_begin(&foz_db->entries);
+   unsigned first =
+      util_dynarray_num_elements(&foz_db->entries, struct foz_db_entry *);
+   bool compacted = false;
+
+   if (size >= 0 && (uint64_t)size > max_size) {
+      /* An entry's hash precedes the header at its offset, so each entry
+       * takes up the space from its offset to the next one.
+       */
+      uint64_t end = size + FOSSILIZE_BLOB_HASH_LENGTH;
+      uint64_t kept_size = 0;
+
+      while (first > 0) {
+         uint64_t entry_size = end - entries[first - 1]->offset;
+         if (kept_size + entry_size > max_size / 2)
+            break;
+
+         kept_size += entry_size;
+         end = entries[first - 1]->offset;
+         first--;
+      }
+
+      compacted = rewrite_foz_db(foz_db, first);
+   }
+
+   simple_mtx_unlock(&foz_db->mtx);
+   u_rwlock_wrunlock(&foz_db->compact_lock);
+
+   return compacted;
+}
 #else
 
 bool
@@ -495,4 +771,10 @@ foz_write_entry(struct foz_db *foz_db, const uint8_t *cache_key_160bit,
    return false;
 }
 
+bool
+foz_compact(struct foz_db *foz_db, uint64_t max_size)
+{
+   return false;
+}
+
 #endif
@@ -41,7 +41,9 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include "rwlock.h"
 #include "simple_mtx.h"
+#include "u_dynarray.h"
 
 /* Max number of DBs our implementation can read from at once */
 #define FOZ_MAX_DBS 9 /* Default DB + 8 Read only DBs */
@@ -75,9 +77,18 @@ struct foz_db_entry {
 struct foz_db {
    FILE *file[FOZ_MAX_DBS];          /* An array of all foz dbs */
    FILE *db_idx;                     /* The default writable foz db idx */
-   simple_mtx_t mtx;                 /* Mutex for file/hash table read/writes */
+   simple_mtx_t mtx;                 /* Mutex for writes and index_db */
+   struct u_rwlock compact_lock;     /* Held exclusively while the default foz
+                                      * db is being compacted */
    void *mem_ctx;
-   struct hash_table_u64 *index_db;  /* Hash table of all foz db entries */
+   char *cache_path;
+   struct hash_table_u64 *index_db;  /* Hash table of the default foz db entries */
+   struct util_dynarray entries;     /* The default foz db entries, in the
+                                      * order they were written */
+   struct hash_table_u64 *index_db_ro; /* Hash table of the read only foz db
+                                        * entries, immutable after foz_prepare */
+   const uint8_t *map[FOZ_MAX_DBS];  /* Read only foz dbs mapped in memory */
+   size_t map_size[FOZ_MAX_DBS];
    bool alive;
 };
 
@@ -95,4 +106,7 @@ bool
 foz_write_entry(struct foz_db *foz_db, const uint8_t *cache_key_160bit,
                 const void *blob, size_t size);
 
+bool
+foz_compact(struct foz_db *foz_db, uint64_t max_size);
+
 #endif /* FOSSILIZE_DB_H */
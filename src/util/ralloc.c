@@ -83,6 +83,11 @@ __declspec(align(16))
    struct ralloc_header *next;
 
    void (*destructor)(void *);
+
+   /* The arena allocations below this block are made from, if any.  The
+    * low bit is set when the block itself lives in the arena's memory.
+    */
+   uintptr_t arena;
 };
 
 typedef struct ralloc_header ralloc_header;
@@ -90,6 +95,13 @@ typedef struct ralloc_header ralloc_header;
 static void unlink_block(ralloc_header *info);
 static void unsafe_free(ralloc_header *info);
 
+struct ralloc_arena;
+static void arena_unref(struct ralloc_arena *arena);
+
+#define ARENA_BLOCK 0x1
+#define ARENA_FROM_HEADER(info) \
+   ((struct ralloc_arena *) ((info)->arena & ~(uintptr_t) ARENA_BLOCK))
+
 static ralloc_header *
 get_header(const void *ptr)
 {
@@ -148,6 +160,7 @@ ralloc_size(const void *ctx, size_t size)
    info->prev = NULL;
    info->next = NULL;
    info->destructor = NULL;
+   info->arena = 0;
 
    parent = ctx != NULL ? get_header(ctx) : NULL;
 
@@ -178,6 +191,8 @@ resize(void *ptr, size_t size)
    ralloc_header *child, *old, *info;
 
    old = get_header(ptr);
+   /* Arena blocks don't know their size, so they can't be moved. */
+   assert(!(old->arena & ARENA_BLOCK));
    info = realloc(old, align64(size + sizeof(ralloc_header),
                                alignof(ralloc_header)));
 
@@ -312,6 +327,14 @@ unsafe_free(ralloc_header *info)
    if (info->destructor != NULL)
       info->destructor(PTR_FROM_HEADER(info));
 
+   if (info->arena != 0) {
+      bool in_arena = info->arena & ARENA_BLOCK;
+
+      arena_unref(ARENA_FROM_HEADER(info));
+      if (in_arena)
+         return;
+   }
+
    free(info);
 }
 
@@ -574,6 +597,147 @@ ralloc_vasprintf_rewrite_tail(char **str, size_t *start, const char *fmt,
    return true;
 }
 
+/***************************************************************************
+ * Arena allocator for many small, long-lived blocks.
+ ***************************************************************************
+ *
+ * Blocks allocated with rzalloc_arena_size() are ordinary ralloc blocks:
+ * they have a parent, children and a destructor, and can be stolen and
+ * freed.  Only their memory is carved out of large chunks owned by the
+ * arena instead of coming from malloc each.  Freeing such a block doesn't
+ * give its memory back; the chunks are released at once when the arena's
+ * owner and every block and context using the arena are gone.
+ */
+
+#define ARENA_CHUNK_SIZE (32 * 1024)
+#define ARENA_MAX_BLOCK_SIZE (ARENA_CHUNK_SIZE / 8)
+
+struct ralloc_arena_chunk {
+   struct ralloc_arena_chunk *next;
+};
+
+struct ralloc_arena {
+   /* Blocks in the arena plus contexts allocating from it. */
+   unsigned refs;
+
+   /* The arena's owner has been freed, stop handing out memory. */
+   bool released;
+
+   char *top;
+   char *end;
+   struct ralloc_arena_chunk *chunks;
+};
+
+#define ARENA_CHUNK_HEADER_SIZE \
+   align64(sizeof(struct ralloc_arena_chunk), alignof(ralloc_header))
+
+static void
+arena_unref(struct ralloc_arena *arena)
+{
+   assert(arena->refs > 0);
+   if (--arena->refs != 0)
+      return;
+
+   while (arena->chunks != NULL) {
+      struct ralloc_arena_chunk *next = arena->chunks->next;
+      free(arena->chunks);
+      arena->chunks = next;
+   }
+   free(arena);
+}
+
+static void
+release_arena(void *ptr)
+{
+   ARENA_FROM_HEADER(get_header(ptr))->released = true;
+}
+
+static void
+use_arena(ralloc_header *info, struct ralloc_arena *arena)
+{
+   if (info->arena != 0) {
+      assert(!(info->arena & ARENA_BLOCK));
+      arena_unref(ARENA_FROM_HEADER(info));
+   }
+
+   info->arena = (uintptr_t) arena;
+   arena->refs++;
+}
+
+void *
+ralloc_arena_create(const void *ctx)
+{
+   struct ralloc_arena *arena = calloc(1, sizeof(*arena));
+   if (unlikely(arena == NULL))
+      return NULL;
+
+   void *owner = ralloc_context(ctx);
+   if (unlikely(owner == NULL)) {
+      free(arena);
+      return NULL;
+   }
+
+   use_arena(get_header(owner), arena);
+   ralloc_set_destructor(owner, release_arena);
+   return owner;
+}
+
+void
+ralloc_use_arena(const void *ctx, const void *arena_ctx)
+{
+   ralloc_header *info = get_header(ctx);
+   ralloc_header *arena_info = get_header(arena_ctx);
+
+   if (arena_info->arena == 0 || ARENA_FROM_HEADER(arena_info)->released)
+      return;
+
+   use_arena(info, ARENA_FROM_HEADER(arena_info));
+}
+
+void *
+rzalloc_arena_size(const void *ctx, size_t size)
+{
+   ralloc_header *parent = ctx != NULL ? get_header(ctx) : NULL;
+   size_t block_size = align64(size + sizeof(ralloc_header),
+                               alignof(ralloc_header));
+   struct ralloc_arena *arena;
+   ralloc_header *info;
+
+   if (parent == NULL || parent->arena == 0 ||
+       block_size > ARENA_MAX_BLOCK_SIZE)
+      return rzalloc_size(ctx, size);
+
+   arena = ARENA_FROM_HEADER(parent);
+   if (arena->released)
+      return rzalloc_size(ctx, size);
+
+   if (unlikely((size_t) (arena->end - arena->top) < block_size)) {
+      struct ralloc_arena_chunk *chunk = malloc(ARENA_CHUNK_SIZE);
+      if (unlikely(chunk == NULL))
+         return NULL;
+
+      chunk->next = arena->chunks;
+      arena->chunks = chunk;
+      arena->top = (char *) chunk + ARENA_CHUNK_HEADER_SIZE;
+      arena->end = (char *) chunk + ARENA_CHUNK_SIZE;
+   }
+
+   info = (ralloc_header *) arena->top;
+   arena->top += block_size;
+   memset(info, 0, block_size);
+
+   info->arena = (uintptr_t) arena | ARENA_BLOCK;
+   arena->refs++;
+
+   add_child(parent, info);
+
+#ifndef NDEBUG
+   info->canary = CANARY;
+#endif
+
+   return PTR_FROM_HEADER(info);
+}
+
 /***************************************************************************
  * Linear allocator for short-lived allocations.
  ***************************************************************************
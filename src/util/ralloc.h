@@ -313,6 +313,39 @@ void *ralloc_parent(const void *ptr);
  */
 void ralloc_set_destructor(const void *ptr, void(*destructor)(void *));
 
+/// \defgroup arena Arena Functions @{
+/**
+ * Create an arena, owned by \p ctx.
+ *
+ * The returned context is an ordinary ralloc context.  rzalloc_arena_size()
+ * calls below it, or below any context made to use the arena, carve their
+ * blocks out of large chunks of memory instead of calling malloc for each.
+ *
+ * The chunks are freed once the arena context and every block allocated
+ * from the arena have been freed, so blocks may safely be stolen by
+ * contexts outliving the arena; they only keep its memory alive.
+ */
+void *ralloc_arena_create(const void *ctx);
+
+/**
+ * Make rzalloc_arena_size() calls on \p ctx allocate from the arena that
+ * \p arena_ctx (an arena from ralloc_arena_create() or a block allocated
+ * from one) belongs to.
+ */
+void ralloc_use_arena(const void *ctx, const void *arena_ctx);
+
+/**
+ * Like rzalloc_size(), but allocate the block from the arena \p ctx uses,
+ * if any.
+ *
+ * Blocks allocated from an arena behave like any other ralloc block, except
+ * that they cannot be resized and freeing them doesn't give their memory
+ * back until the whole arena goes away.  This suits many small objects
+ * which mostly live as long as the arena.
+ */
+void *rzalloc_arena_size(const void *ctx, size_t size) MALLOCLIKE;
+/// @}
+
 /// \defgroup array String Functions @{
 /**
  * Duplicate a string, allocating the memory from the given context.
@@ -516,6 +516,116 @@ test_put_key_and_get_key(void)
 
    disk_cache_destroy(cache);
 }
+
+static void
+test_prefetch(void)
+{
+   struct disk_cache *cache;
+   char blob[] = "This is a blob of thirty-seven bytes";
+   char string[] = "While this string has thirty-four";
+   char missing[] = "This one is never stored";
+   cache_key keys[3];
+   char *result;
+   size_t size;
+
+#ifdef SHADER_CACHE_DISABLE_BY_DEFAULT
+   setenv("MESA_GLSL_CACHE_DISABLE", "false", 1);
+#endif /* SHADER_CACHE_DISABLE_BY_DEFAULT */
+
+   cache = disk_cache_create("test", "make_check", 0);
+
+   disk_cache_compute_key(cache, blob, sizeof(blob), keys[0]);
+   disk_cache_compute_key(cache, string, sizeof(string), keys[1]);
+   disk_cache_compute_key(cache, missing, sizeof(missing), keys[2]);
+
+   disk_cache_put(cache, keys[0], blob, sizeof(blob), NULL);
+   disk_cache_put(cache, keys[1], string, sizeof(string), NULL);
+   disk_cache_wait_for_idle(cache);
+   disk_cache_destroy(cache);
+
+   /* Use a new cache object so that nothing is in memory yet. */
+   cache = disk_cache_create("test", "make_check", 0);
+
+   disk_cache_prefetch(cache, (const cache_key *)keys, 3);
+   disk_cache_wait_for_idle(cache);
+
+   result = disk_cache_get(cache, keys[0], &size);
+   expect_equal_str(blob, result, "disk_cache_get of prefetched item (pointer)");
+   expect_equal(size, sizeof(blob), "disk_cache_get of prefetched item (size)");
+   free(result);
+
+   result = disk_cache_get(cache, keys[1], &size);
+   expect_equal_str(string, result, "2nd disk_cache_get of prefetched item (pointer)");
+   expect_equal(size, sizeof(string), "2nd disk_cache_get of prefetched item (size)");
+   free(result);
+
+   result = disk_cache_get(cache, keys[2], &size);
+   expect_null(result, "disk_cache_get of prefetched non-existent item (pointer)");
+   expect_equal(size, 0, "disk_cache_get of prefetched non-existent item (size)");
+
+   disk_cache_destroy(cache);
+}
+
+#ifdef HAVE_FLOCK
+static void
+test_single_file_compaction(void)
+{
+   struct disk_cache *cache;
+   uint8_t data[4][1024];
+   cache_key keys[4];
+   int count;
+
+#ifdef SHADER_CACHE_DISABLE_BY_DEFAULT
+   setenv("MESA_GLSL_CACHE_DISABLE", "false", 1);
+#endif /* SHADER_CACHE_DISABLE_BY_DEFAULT */
+
+   /* Room for three 1KB items, which don't compress, but not for four. */
+   setenv("MESA_GLSL_CACHE_MAX_SIZE", "4K", 1);
+   cache = disk_cache_type_create("test", "make_check", 0,
+                                  DISK_CACHE_SINGLE_FILE);
+
+   srand(42);
+   for (unsigned i = 0; i < 4; i++) {
+      for (unsigned j = 0; j < sizeof(data[i]); j++)
+         data[i][j] = rand();
+      disk_cache_compute_key(cache, data[i], sizeof(data[i]), keys[i]);
+   }
+
+   /* Wait for each item, so that they are written in order. */
+   for (unsigned i = 0; i < 3; i++) {
+      disk_cache_put(cache, keys[i], data[i], sizeof(data[i]), NULL);
+      disk_cache_wait_for_idle(cache);
+   }
+
+   count = 0;
+   for (unsigned i = 0; i < 3; i++)
+      count += does_cache_contain(cache, keys[i]);
+   expect_equal(count, 3, "no compaction of the single file cache before overflow");
+
+   disk_cache_put(cache, keys[3], data[3], sizeof(data[3]), NULL);
+   disk_cache_wait_for_idle(cache);
+
+   count = 0;
+   for (unsigned i = 0; i < 3; i++)
+      count += does_cache_contain(cache, keys[i]);
+   expect_equal(count, 0, "compaction of the single file cache evicts old items");
+   expect_true(does_cache_contain(cache, keys[3]),
+               "compaction of the single file cache keeps the last item");
+
+   disk_cache_destroy(cache);
+
+   /* The compacted files must be usable by the next cache object. */
+   cache = disk_cache_type_create("test", "make_check", 0,
+                                  DISK_CACHE_SINGLE_FILE);
+   expect_true(does_cache_contain(cache, keys[3]),
+               "single file cache item after compaction and reload");
+   expect_false(does_cache_contain(cache, keys[0]),
+                "evicted single file cache item after reload");
+
+   disk_cache_destroy(cache);
+   unsetenv("MESA_GLSL_CACHE_MAX_SIZE");
+}
+#endif /* HAVE_FLOCK */
 #endif /* ENABLE_SHADER_CACHE */
 
 int
@@ -530,6 +640,12 @@ main(void)
 
    test_put_key_and_get_key();
 
+   test_prefetch();
+
+#ifdef HAVE_FLOCK
+   test_single_file_compaction();
+#endif
+
    err = rmrf_local(CACHE_TEST_TMP);
    expect_equal(err, 0, "Removing " CACHE_TEST_TMP " again");
 #endif /* ENABLE_SHADER_CACHE */
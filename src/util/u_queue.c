@@ -247,6 +247,198 @@ struct thread_input {
    int thread_index;
 };
 
+/****************************************************************************
+ * UTIL_QUEUE_INIT_WORK_STEALING
+ *
+ * Every thread has a deque with a ring buffer for each priority. Producers
+ * spread the jobs over the deques of the active threads, and threads take
+ * jobs from their own deque first and steal from the others when it's empty.
+ * Owners and thieves both take the oldest job, so that jobs of a deque run in
+ * the order they were added like in the default mode. queue->lock is only
+ * used by threads going to sleep and the producers waking them up.
+ */
+
+static void
+util_queue_ring_push(struct util_queue_ring *ring,
+                     const struct util_queue_job *job)
+{
+   if (ring->num_queued == ring->max_jobs) {
+      int new_max_jobs = MAX2(ring->max_jobs * 2, 8);
+      struct util_queue_job *jobs =
+         (struct util_queue_job*)calloc(new_max_jobs,
+                                        sizeof(struct util_queue_job));
+      assert(jobs);
+
+      for (int i = 0; i < ring->num_queued; i++)
+         jobs[i] = ring->jobs[(ring->read_idx + i) % ring->max_jobs];
+
+      free(ring->jobs);
+      ring->jobs = jobs;
+      ring->read_idx = 0;
+      ring->max_jobs = new_max_jobs;
+   }
+
+   ring->jobs[(ring->read_idx + ring->num_queued) % ring->max_jobs] = *job;
+   p_atomic_inc(&ring->num_queued);
+}
+
+static void
+util_queue_push_job(struct util_queue *queue, unsigned deque_index,
+                    const struct util_queue_job *job,
+                    enum util_queue_priority priority)
+{
+   struct util_queue_deque *deque = &queue->deques[deque_index];
+
+   mtx_lock(&deque->lock);
+   util_queue_ring_push(&deque->rings[priority], job);
+   mtx_unlock(&deque->lock);
+
+   p_atomic_inc(&queue->num_queued);
+
+   /* Threads increment num_sleeping before checking num_queued, so either
+    * they see the new job or we see them.
+    */
+   if (p_atomic_read(&queue->num_sleeping)) {
+      mtx_lock(&queue->lock);
+      cnd_signal(&queue->has_queued_cond);
+      mtx_unlock(&queue->lock);
+   }
+}
+
+/* Take the queued job of the highest priority from a deque. Jobs of lower
+ * priorities are never started before those of higher ones in the same
+ * deque, which util_queue_finish relies on.
+ */
+static bool
+util_queue_deque_pop(struct util_queue_deque *deque,
+                     struct util_queue_job *job)
+{
+   bool found = false;
+
+   mtx_lock(&deque->lock);
+   for (unsigned p = 0; p < UTIL_QUEUE_NUM_PRIORITIES; p++) {
+      struct util_queue_ring *ring = &deque->rings[p];
+
+      if (ring->num_queued) {
+         *job = ring->jobs[ring->read_idx];
+         memset(&ring->jobs[ring->read_idx], 0, sizeof(*job));
+         ring->read_idx = (ring->read_idx + 1) % ring->max_jobs;
+         p_atomic_dec(&ring->num_queued);
+         found = true;
+         break;
+      }
+   }
+   mtx_unlock(&deque->lock);
+
+   return found;
+}
+
+static bool
+util_queue_steal_job(struct util_queue *queue, int thread_index,
+                     struct util_queue_job *job)
+{
+   for (unsigned p = 0; p < UTIL_QUEUE_NUM_PRIORITIES; p++) {
+      for (unsigned i = 0; i < queue->max_threads; i++) {
+         struct util_queue_deque *deque =
+            &queue->deques[(thread_index + i) % queue->max_threads];
+
+         if (p_atomic_read(&deque->rings[p].num_queued) &&
+             util_queue_deque_pop(deque, job)) {
+            p_atomic_dec(&queue->num_queued);
+            return true;
+         }
+      }
+   }
+   return false;
+}
+
+/* Move the jobs of a deque to the end of another one. */
+static void
+util_queue_move_jobs(struct util_queue *queue, unsigned from, unsigned to)
+{
+   struct util_queue_deque *src = &queue->deques[from];
+   struct util_queue_deque *dst = &queue->deques[to];
+
+   mtx_lock(&src->lock);
+   mtx_lock(&dst->lock);
+   for (unsigned p = 0; p < UTIL_QUEUE_NUM_PRIORITIES; p++) {
+      struct util_queue_ring *ring = &src->rings[p];
+
+      for (int i = 0; i < ring->num_queued; i++) {
+         util_queue_ring_push(&dst->rings[p],
+                              &ring->jobs[(ring->read_idx + i) % ring->max_jobs]);
+      }
+      memset(ring->jobs, 0, ring->max_jobs * sizeof(*ring->jobs));
+      ring->read_idx = 0;
+      p_atomic_set(&ring->num_queued, 0);
+   }
+   mtx_unlock(&dst->lock);
+   mtx_unlock(&src->lock);
+}
+
+/* Signal the fences of all queued jobs, after all threads were terminated. */
+static void
+util_queue_signal_queued_jobs(struct util_queue *queue)
+{
+   for (unsigned i = 0; i < queue->max_threads; i++) {
+      struct util_queue_deque *deque = &queue->deques[i];
+
+      mtx_lock(&deque->lock);
+      for (unsigned p = 0; p < UTIL_QUEUE_NUM_PRIORITIES; p++) {
+         struct util_queue_ring *ring = &deque->rings[p];
+
+         for (int j = 0; j < ring->num_queued; j++) {
+            struct util_queue_job *job =
+               &ring->jobs[(ring->read_idx + j) % ring->max_jobs];
+            if (job->job)
+               util_queue_fence_signal(job->fence);
+            memset(job, 0, sizeof(*job));
+         }
+         ring->read_idx = 0;
+         p_atomic_set(&ring->num_queued, 0);
+      }
+      mtx_unlock(&deque->lock);
+   }
+   p_atomic_set(&queue->num_queued, 0);
+}
+
+static void
+util_queue_work_stealing_loop(struct util_queue *queue, int thread_index)
+{
+   while (1) {
+      struct util_queue_job job;
+
+      /* only kill threads that are above "num_threads" */
+      if (thread_index >= p_atomic_read(&queue->num_threads))
+         break;
+
+      if (!util_queue_steal_job(queue, thread_index, &job)) {
+         /* wait if the queue is empty */
+         mtx_lock(&queue->lock);
+         p_atomic_inc(&queue->num_sleeping);
+         while (thread_index < p_atomic_read(&queue->num_threads) &&
+                p_atomic_read(&queue->num_queued) == 0)
+            cnd_wait(&queue->has_queued_cond, &queue->lock);
+         p_atomic_dec(&queue->num_sleeping);
+         mtx_unlock(&queue->lock);
+         continue;
+      }
+
+      if (job.job) {
+         job.execute(job.job, thread_index);
+         util_queue_fence_signal(job.fence);
+         if (job.cleanup)
+            job.cleanup(job.job, thread_index);
+      }
+   }
+
+   /* signal remaining jobs if all threads are being terminated */
+   mtx_lock(&queue->lock);
+   if (queue->num_threads == 0)
+      util_queue_signal_queued_jobs(queue);
+   mtx_unlock(&queue->lock);
+}
+
 static int
 util_queue_thread_func(void *input)
 {
@@ -283,6 +475,11 @@ util_queue_thread_func(void *input)
       u_thread_setname(name);
    }
 
+   if (queue->flags & UTIL_QUEUE_INIT_WORK_STEALING) {
+      util_queue_work_stealing_loop(queue, thread_index);
+      return 0;
+   }
+
    while (1) {
       struct util_queue_job job;
 
@@ -391,7 +588,7 @@ util_queue_adjust_num_threads(struct util_queue *queue, unsigned num_threads)
     * We need to update num_threads first, because threads terminate
     * when thread_index < num_threads.
     */
-   queue->num_threads = num_threads;
+   p_atomic_set(&queue->num_threads, num_threads);
    for (unsigned i = old_num_threads; i < num_threads; i++) {
       if (!util_queue_create_thread(queue, i))
          break;
@@ -446,6 +643,16 @@ util_queue_init(struct util_queue *queue,
    if (!queue->jobs)
       goto fail;
 
+   if (flags & UTIL_QUEUE_INIT_WORK_STEALING) {
+      queue->deques = (struct util_queue_deque*)
+                      calloc(num_threads, sizeof(struct util_queue_deque));
+      if (!queue->deques)
+         goto fail;
+
+      for (i = 0; i < num_threads; i++)
+         (void) mtx_init(&queue->deques[i].lock, mtx_plain);
+   }
+
    (void) mtx_init(&queue->lock, mtx_plain);
    (void) mtx_init(&queue->finish_lock, mtx_plain);
 
@@ -477,6 +684,12 @@ util_queue_init(struct util_queue *queue,
 fail:
    free(queue->threads);
 
+   if (queue->deques) {
+      for (i = 0; i < num_threads; i++)
+         mtx_destroy(&queue->deques[i].lock);
+      free(queue->deques);
+   }
+
    if (queue->jobs) {
       cnd_destroy(&queue->has_space_cond);
       cnd_destroy(&queue->has_queued_cond);
@@ -508,13 +721,19 @@ util_queue_kill_threads(struct util_queue *queue, unsigned keep_num_threads,
    /* Setting num_threads is what causes the threads to terminate.
     * Then cnd_broadcast wakes them up and they will exit their function.
     */
-   queue->num_threads = keep_num_threads;
+   p_atomic_set(&queue->num_threads, keep_num_threads);
    cnd_broadcast(&queue->has_queued_cond);
    mtx_unlock(&queue->lock);
 
    for (i = keep_num_threads; i < old_num_threads; i++)
       thrd_join(queue->threads[i], NULL);
 
+   /* util_queue_finish only waits for the deques of the active threads. */
+   if (queue->deques && keep_num_threads) {
+      for (i = keep_num_threads; i < old_num_threads; i++)
+         util_queue_move_jobs(queue, i, i % keep_num_threads);
+   }
+
    if (!finish_locked)
       mtx_unlock(&queue->finish_lock);
 }
@@ -531,18 +750,48 @@ util_queue_destroy(struct util_queue *queue)
    mtx_destroy(&queue->lock);
    free(queue->jobs);
    free(queue->threads);
+
+   if (queue->deques) {
+      for (unsigned i = 0; i < queue->max_threads; i++) {
+         for (unsigned p = 0; p < UTIL_QUEUE_NUM_PRIORITIES; p++)
+            free(queue->deques[i].rings[p].jobs);
+         mtx_destroy(&queue->deques[i].lock);
+      }
+      free(queue->deques);
+   }
 }
 
 void
-util_queue_add_job(struct util_queue *queue,
-                   void *job,
-                   struct util_queue_fence *fence,
-                   util_queue_execute_func execute,
-                   util_queue_execute_func cleanup,
-                   const size_t job_size)
+util_queue_add_job_with_priority(struct util_queue *queue,
+                                 void *job,
+                                 struct util_queue_fence *fence,
+                                 util_queue_execute_func execute,
+                                 util_queue_execute_func cleanup,
+                                 const size_t job_size,
+                                 enum util_queue_priority priority)
 {
    struct util_queue_job *ptr;
 
+   if (queue->deques) {
+      unsigned num_threads = p_atomic_read(&queue->num_threads);
+      if (num_threads == 0)
+         return;
+
+      struct util_queue_job ws_job = {
+         .job = job,
+         .job_size = job_size,
+         .fence = fence,
+         .execute = execute,
+         .cleanup = cleanup,
+      };
+
+      util_queue_fence_reset(fence);
+      util_queue_push_job(queue,
+                          p_atomic_inc_return(&queue->next_deque) % num_threads,
+                          &ws_job, priority);
+      return;
+   }
+
    mtx_lock(&queue->lock);
    if (queue->num_threads == 0) {
       mtx_unlock(&queue->lock);
@@ -607,6 +856,49 @@ util_queue_add_job(struct util_queue *queue,
    mtx_unlock(&queue->lock);
 }
 
+void
+util_queue_add_job(struct util_queue *queue,
+                   void *job,
+                   struct util_queue_fence *fence,
+                   util_queue_execute_func execute,
+                   util_queue_execute_func cleanup,
+                   const size_t job_size)
+{
+   util_queue_add_job_with_priority(queue, job, fence, execute, cleanup,
+                                    job_size, UTIL_QUEUE_PRIORITY_NORMAL);
+}
+
+static bool
+util_queue_deques_drop_job(struct util_queue *queue,
+                           struct util_queue_fence *fence)
+{
+   for (unsigned i = 0; i < queue->max_threads; i++) {
+      struct util_queue_deque *deque = &queue->deques[i];
+
+      mtx_lock(&deque->lock);
+      for (unsigned p = 0; p < UTIL_QUEUE_NUM_PRIORITIES; p++) {
+         struct util_queue_ring *ring = &deque->rings[p];
+
+         for (int j = 0; j < ring->num_queued; j++) {
+            struct util_queue_job *job =
+               &ring->jobs[(ring->read_idx + j) % ring->max_jobs];
+
+            if (job->fence == fence) {
+               if (job->cleanup)
+                  job->cleanup(job->job, -1);
+
+               /* Just clear it. The threads will treat as a no-op job. */
+               memset(job, 0, sizeof(*job));
+               mtx_unlock(&deque->lock);
+               return true;
+            }
+         }
+      }
+      mtx_unlock(&deque->lock);
+   }
+   return false;
+}
+
 /**
  * Remove a queued job. If the job hasn't started execution, it's removed from
  * the queue. If the job has started execution, the function waits for it to
@@ -625,6 +917,14 @@ util_queue_drop_job(struct util_queue *queue, struct util_queue_fence *fence)
    if (util_queue_fence_is_signalled(fence))
       return;
 
+   if (queue->deques) {
+      if (util_queue_deques_drop_job(queue, fence))
+         util_queue_fence_signal(fence);
+      else
+         util_queue_fence_wait(fence);
+      return;
+   }
+
    mtx_lock(&queue->lock);
    for (unsigned i = queue->read_idx; i != queue->write_idx;
         i = (i + 1) % queue->max_jobs) {
@@ -679,8 +979,23 @@ util_queue_finish(struct util_queue *queue)
 
    for (unsigned i = 0; i < queue->num_threads; ++i) {
       util_queue_fence_init(&fences[i]);
-      util_queue_add_job(queue, &barrier, &fences[i],
-                         util_queue_finish_execute, NULL, 0);
+
+      if (queue->deques) {
+         /* Put one barrier at the end of every deque, so that all previous
+          * jobs of the deque are started before it.
+          */
+         struct util_queue_job job = {
+            .job = &barrier,
+            .fence = &fences[i],
+            .execute = util_queue_finish_execute,
+         };
+
+         util_queue_fence_reset(&fences[i]);
+         util_queue_push_job(queue, i, &job, UTIL_QUEUE_PRIORITY_LOW);
+      } else {
+         util_queue_add_job(queue, &barrier, &fences[i],
+                            util_queue_finish_execute, NULL, 0);
+      }
    }
 
    for (unsigned i = 0; i < queue->num_threads; ++i) {
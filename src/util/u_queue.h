@@ -49,6 +49,12 @@ extern "C" {
 #define UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY      (1 << 0)
 #define UTIL_QUEUE_INIT_RESIZE_IF_FULL            (1 << 1)
 #define UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY  (1 << 2)
+/* Give every thread its own deques of jobs, which other threads steal from
+ * when theirs are empty, instead of sharing one ring buffer and lock between
+ * all producers and threads. Job priorities are only honoured in this mode.
+ * The deques grow as needed, so adding jobs never waits for a free slot.
+ */
+#define UTIL_QUEUE_INIT_WORK_STEALING             (1 << 3)
 
 #if UTIL_FUTEX_SUPPORTED
 #define UTIL_QUEUE_FENCE_FUTEX
@@ -191,6 +197,16 @@ util_queue_fence_wait_timeout(struct util_queue_fence *fence,
 
 typedef void (*util_queue_execute_func)(void *job, int thread_index);
 
+/* Jobs of a higher priority are started before all queued jobs of a lower
+ * priority, e.g. compiles that block a draw before speculative ones.
+ */
+enum util_queue_priority {
+   UTIL_QUEUE_PRIORITY_HIGH,
+   UTIL_QUEUE_PRIORITY_NORMAL,
+   UTIL_QUEUE_PRIORITY_LOW,
+   UTIL_QUEUE_NUM_PRIORITIES,
+};
+
 struct util_queue_job {
    void *job;
    size_t job_size;
@@ -199,6 +215,19 @@ struct util_queue_job {
    util_queue_execute_func cleanup;
 };
 
+/* A ring buffer of jobs of the same priority, for UTIL_QUEUE_INIT_WORK_STEALING */
+struct util_queue_ring {
+   struct util_queue_job *jobs;
+   int max_jobs;
+   int read_idx;
+   int num_queued; /* also read without the lock, to skip empty rings */
+};
+
+struct util_queue_deque {
+   mtx_t lock;
+   struct util_queue_ring rings[UTIL_QUEUE_NUM_PRIORITIES];
+};
+
 /* Put this into your context. */
 struct util_queue {
    char name[14]; /* 13 characters = the thread name without the index */
@@ -216,6 +245,11 @@ struct util_queue {
    size_t total_jobs_size;  /* memory use of all jobs in the queue */
    struct util_queue_job *jobs;
 
+   /* for UTIL_QUEUE_INIT_WORK_STEALING, where num_queued is atomic */
+   struct util_queue_deque *deques; /* one per thread */
+   unsigned next_deque;
+   int num_sleeping;
+
    /* for cleanup at exit(), protected by exit_mutex */
    struct list_head head;
 };
@@ -234,6 +268,13 @@ void util_queue_add_job(struct util_queue *queue,
                         util_queue_execute_func execute,
                         util_queue_execute_func cleanup,
                         const size_t job_size);
+void util_queue_add_job_with_priority(struct util_queue *queue,
+                                      void *job,
+                                      struct util_queue_fence *fence,
+                                      util_queue_execute_func execute,
+                                      util_queue_execute_func cleanup,
+                                      const size_t job_size,
+                                      enum util_queue_priority priority);
 void util_queue_drop_job(struct util_queue *queue,
                          struct util_queue_fence *fence);
 
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+#
+# Converts a trace written by the overlay layer's trace_file option into
+# comma separated text, one line per frame.
+
+import argparse
+import struct
+import sys
+
+MAGIC = b'MESAOVLT'
+VERSION = 1
+
+
+def read_header(f):
+    magic = f.read(len(MAGIC))
+    if magic != MAGIC:
+        sys.exit('not a mesa overlay trace')
+
+    version, num_columns = struct.unpack('<II', f.read(8))
+    if version != VERSION:
+        sys.exit('unsupported trace version {}'.format(version))
+
+    names = []
+    for _ in range(num_columns):
+        name = bytearray()
+        while True:
+            c = f.read(1)
+            if not c:
+                sys.exit('truncated trace header')
+            if c == b'\0':
+                break
+            name += c
+        names.append(name.decode('utf-8'))
+
+    return names
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Mesa Overlay trace converter')
+    parser.add_argument('trace', help='trace file written by the overlay layer')
+    parser.add_argument('-o', '--output', help='output file (default: stdout)')
+    args = parser.parse_args()
+
+    with open(args.trace, 'rb') as f:
+        names = read_header(f)
+        record = struct.Struct('<{}Q'.format(len(names)))
+
+        out = open(args.output, 'w') if args.output else sys.stdout
+        out.write(', '.join(names) + '\n')
+        while True:
+            data = f.read(record.size)
+            if len(data) < record.size:
+                break
+            out.write(', '.join(str(v) for v in record.unpack(data)) + '\n')
+        if out is not sys.stdout:
+            out.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -25,6 +25,8 @@
 #include <stdlib.h>
 #include <assert.h>
 
+#include <atomic>
+
 #include <vulkan/vulkan.h>
 #include <vulkan/vk_layer.h>
 
@@ -33,14 +35,15 @@
 #include "imgui.h"
 
 #include "overlay_params.h"
+#include "overlay_trace.h"
 
 #include "util/debug.h"
-#include "util/hash_table.h"
 #include "util/list.h"
 #include "util/ralloc.h"
 #include "util/os_time.h"
 #include "util/os_socket.h"
 #include "util/simple_mtx.h"
+#include "util/u_dynarray.h"
 
 #include "vk_enum_to_str.h"
 #include "vk_dispatch_table.h"
@@ -64,12 +67,29 @@ struct instance_data {
 
    /* Dumping of frame stats to a file has been enabled and started. */
    bool capture_started;
+
+   /* Per-frame stats, written to params.trace_file. */
+   struct overlay_trace *trace;
 };
 
 struct frame_stat {
    uint64_t stats[OVERLAY_PARAM_ENABLED_MAX];
 };
 
+/* Work accounted to a pipeline */
+struct pipeline_stats {
+   uint64_t draws;
+   uint64_t dispatches;
+   uint64_t vertices; /* of the direct draws */
+   uint64_t gpu_time; /* ns */
+};
+
+struct top_pipeline {
+   VkPipeline pipeline;
+   VkPipelineBindPoint bind_point;
+   struct pipeline_stats stats;
+};
+
 /* Mapped from VkDevice */
 struct queue_data;
 struct device_data {
@@ -88,10 +108,73 @@ struct device_data {
    struct queue_data **queues;
    uint32_t n_queues;
 
+   /* Protects the queue_data::pending_queries lists, command buffers get
+    * recorded from other threads than the ones presenting.
+    */
+   simple_mtx_t queries_mutex;
+
+   /* With top_pipelines, all the pipelines of the device, and the most
+    * expensive ones over the last fps_sampling_period, for display.
+    */
+   simple_mtx_t pipelines_mutex;
+   struct list_head pipelines;
+   struct top_pipeline *top_pipelines;
+   unsigned n_top_pipelines;
+
    /* For a single frame */
    struct frame_stat frame_stats;
 };
 
+/* Mapped from VkPipeline, only with top_pipelines */
+struct pipeline_data {
+   VkPipeline pipeline;
+   VkPipelineBindPoint bind_point;
+
+   /* Over the current fps_sampling_period */
+   struct pipeline_stats stats;
+
+   struct list_head link; /* link into device_data::pipelines */
+};
+
+/* Number of times a command buffer can be recorded before we reuse its
+ * queries. Results are read at present time, once the GPU made them
+ * available, so this bounds how many frames they can lag behind.
+ */
+#define OVERLAY_QUERY_RING_SIZE 8
+
+/* Timestamps per recording with top_pipelines. The first and last ones
+ * frame the command buffer, the others start the segments of work done
+ * with a pipeline.
+ */
+#define OVERLAY_PIPELINE_TIMESTAMPS 64
+
+/* Work done with one pipeline in a command buffer recording */
+struct pipeline_segment {
+   VkPipeline pipeline;
+
+   /* Timestamp starting the segment, the next one ends it. -1 if the
+    * segment isn't timed, because it was recorded in a secondary command
+    * buffer or we ran out of timestamps.
+    */
+   int timestamp;
+
+   struct pipeline_stats stats;
+};
+
+struct command_buffer_data;
+
+/* Queries of one recording of a command buffer */
+struct command_buffer_query_slot {
+   struct command_buffer_data *cmd_buffer;
+   uint32_t query_index;
+
+   uint32_t n_timestamps;
+   struct util_dynarray segments; /* struct pipeline_segment */
+   int current_segment;
+
+   struct list_head link; /* link into queue_data::pending_queries */
+};
+
 /* Mapped from VkCommandBuffer */
 struct command_buffer_data {
    struct device_data *device;
@@ -102,10 +185,17 @@ struct command_buffer_data {
    VkQueryPool pipeline_query_pool;
    VkQueryPool timestamp_query_pool;
    uint32_t query_index;
+   uint32_t timestamps_per_slot;
 
    struct frame_stat stats;
 
-   struct list_head link; /* link into queue_data::running_command_buffer */
+   /* Pipelines bound in the current recording */
+   VkPipeline graphics_pipeline;
+   VkPipeline compute_pipeline;
+
+   /* Slot used by the current recording */
+   uint32_t query_slot;
+   struct command_buffer_query_slot query_slots[OVERLAY_QUERY_RING_SIZE];
 };
 
 /* Mapped from VkQueue */
@@ -117,9 +207,8 @@ struct queue_data {
    uint32_t family_index;
    uint64_t timestamp_mask;
 
-   VkFence queries_fence;
-
-   struct list_head running_command_buffer;
+   /* Submitted queries we haven't got the results of yet */
+   struct list_head pending_queries;
 };
 
 struct overlay_draw {
@@ -214,41 +303,243 @@ static const VkQueryPipelineStatisticFlags overlay_query_flags =
    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
 #define OVERLAY_QUERY_COUNT (11)
 
-static struct hash_table_u64 *vk_object_to_data = NULL;
+/* Map from Vulkan handles to our layer data.
+ *
+ * This is looked up on every intercepted call, including all the
+ * vkCmd*() entrypoints, so lookups don't take any lock. The map is an
+ * open addressing table of atomic entries: writers are serialized by
+ * vk_object_to_data_mutex, readers only follow the published table.
+ *
+ * Removed entries keep their key with a NULL data pointer, so probe
+ * sequences stay intact, and are reused by later insertions. When the
+ * table fills up a new one is published, and the old one is freed once
+ * no reader has it in its hazard pointer anymore.
+ */
+struct object_map_entry {
+   std::atomic<uint64_t> key;
+   std::atomic<void *> data;
+};
+
+struct object_map {
+   unsigned size_log2;
+   unsigned used;
+   struct object_map *retired;
+   struct object_map_entry entries[];
+};
+
+/* One per thread doing lookups, reused once the thread is gone. */
+struct object_map_reader {
+   std::atomic<struct object_map *> map;
+   std::atomic<bool> in_use;
+   struct object_map_reader *next;
+};
+
+struct object_map_reader_slot {
+   struct object_map_reader *reader;
+
+   ~object_map_reader_slot() {
+      if (reader)
+         reader->in_use.store(false, std::memory_order_release);
+   }
+};
+
+static std::atomic<struct object_map *> vk_object_to_data(NULL);
+static struct object_map *vk_object_to_data_retired = NULL;
+static unsigned vk_object_to_data_count = 0;
+static std::atomic<struct object_map_reader *> vk_object_to_data_readers(NULL);
 static simple_mtx_t vk_object_to_data_mutex = _SIMPLE_MTX_INITIALIZER_NP;
 
 thread_local ImGuiContext* __MesaImGui;
+static thread_local struct object_map_reader_slot vk_object_to_data_reader;
+
+#define HKEY(obj) ((uint64_t)(obj))
+#define FIND(type, obj) ((type *)find_object_data(HKEY(obj)))
 
-static inline void ensure_vk_object_map(void)
+static inline uint32_t object_map_hash(const struct object_map *map, uint64_t obj)
 {
-   if (!vk_object_to_data)
-      vk_object_to_data = _mesa_hash_table_u64_create(NULL);
+   return (obj * 0x9e3779b97f4a7c15ull) >> (64 - map->size_log2);
 }
 
-#define HKEY(obj) ((uint64_t)(obj))
-#define FIND(type, obj) ((type *)find_object_data(HKEY(obj)))
+static struct object_map_reader *get_object_map_reader(void)
+{
+   struct object_map_reader *reader = vk_object_to_data_reader.reader;
+   if (reader)
+      return reader;
+
+   for (reader = vk_object_to_data_readers.load(std::memory_order_acquire);
+        reader; reader = reader->next) {
+      bool expected = false;
+      if (reader->in_use.compare_exchange_strong(expected, true))
+         break;
+   }
+
+   if (!reader) {
+      reader = (struct object_map_reader *)calloc(1, sizeof(*reader));
+      reader->in_use.store(true, std::memory_order_relaxed);
+      simple_mtx_lock(&vk_object_to_data_mutex);
+      reader->next = vk_object_to_data_readers.load(std::memory_order_relaxed);
+      vk_object_to_data_readers.store(reader, std::memory_order_release);
+      simple_mtx_unlock(&vk_object_to_data_mutex);
+   }
+
+   vk_object_to_data_reader.reader = reader;
+   return reader;
+}
 
 static void *find_object_data(uint64_t obj)
 {
-   simple_mtx_lock(&vk_object_to_data_mutex);
-   ensure_vk_object_map();
-   void *data = _mesa_hash_table_u64_search(vk_object_to_data, obj);
-   simple_mtx_unlock(&vk_object_to_data_mutex);
+   if (!obj)
+      return NULL;
+
+   struct object_map_reader *reader = get_object_map_reader();
+   struct object_map *map = vk_object_to_data.load(std::memory_order_acquire);
+   struct object_map *current;
+   do {
+      if (!map)
+         return NULL;
+      reader->map.store(map, std::memory_order_seq_cst);
+      current = map;
+      map = vk_object_to_data.load(std::memory_order_seq_cst);
+   } while (map != current);
+
+   void *data = NULL;
+   uint32_t mask = (1u << map->size_log2) - 1;
+   for (uint32_t i = object_map_hash(map, obj); ; i = (i + 1) & mask) {
+      uint64_t key = map->entries[i].key.load(std::memory_order_acquire);
+      if (key == obj) {
+         data = map->entries[i].data.load(std::memory_order_acquire);
+         break;
+      }
+      if (key == 0)
+         break;
+   }
+
+   reader->map.store(NULL, std::memory_order_release);
    return data;
 }
 
+/* Called with vk_object_to_data_mutex held. Returns the entry holding
+ * obj, or the entry obj should be inserted into.
+ */
+static struct object_map_entry *object_map_find_entry(struct object_map *map,
+                                                      uint64_t obj)
+{
+   struct object_map_entry *free_entry = NULL;
+   uint32_t mask = (1u << map->size_log2) - 1;
+   for (uint32_t i = object_map_hash(map, obj); ; i = (i + 1) & mask) {
+      struct object_map_entry *entry = &map->entries[i];
+      uint64_t key = entry->key.load(std::memory_order_relaxed);
+      if (key == obj)
+         return entry;
+      if (key == 0)
+         return free_entry ? free_entry : entry;
+      if (!free_entry && !entry->data.load(std::memory_order_relaxed))
+         free_entry = entry;
+   }
+}
+
+/* Called with vk_object_to_data_mutex held. */
+static void object_map_free_retired(void)
+{
+   struct object_map **link = &vk_object_to_data_retired;
+   while (*link) {
+      struct object_map *map = *link;
+      bool in_use = false;
+
+      for (struct object_map_reader *reader =
+              vk_object_to_data_readers.load(std::memory_order_relaxed);
+           reader; reader = reader->next) {
+         if (reader->map.load(std::memory_order_seq_cst) == map) {
+            in_use = true;
+            break;
+         }
+      }
+
+      if (in_use) {
+         link = &map->retired;
+      } else {
+         *link = map->retired;
+         free(map);
+      }
+   }
+}
+
+/* Called with vk_object_to_data_mutex held. */
+static struct object_map *object_map_grow(struct object_map *old_map)
+{
+   unsigned size_log2 = 6;
+   while ((2u << size_log2) < 3 * (vk_object_to_data_count + 1))
+      size_log2++;
+
+   size_t size = sizeof(struct object_map) +
+      (sizeof(struct object_map_entry) << size_log2);
+   struct object_map *map = (struct object_map *)calloc(1, size);
+   map->size_log2 = size_log2;
+
+   if (old_map) {
+      for (uint32_t i = 0; i < (1u << old_map->size_log2); i++) {
+         uint64_t key = old_map->entries[i].key.load(std::memory_order_relaxed);
+         void *data = old_map->entries[i].data.load(std::memory_order_relaxed);
+         if (!data)
+            continue;
+         struct object_map_entry *entry = object_map_find_entry(map, key);
+         entry->key.store(key, std::memory_order_relaxed);
+         entry->data.store(data, std::memory_order_relaxed);
+         map->used++;
+      }
+   }
+
+   vk_object_to_data.store(map, std::memory_order_seq_cst);
+
+   if (old_map) {
+      old_map->retired = vk_object_to_data_retired;
+      vk_object_to_data_retired = old_map;
+      object_map_free_retired();
+   }
+
+   return map;
+}
+
 static void map_object(uint64_t obj, void *data)
 {
+   assert(obj && data);
+
    simple_mtx_lock(&vk_object_to_data_mutex);
-   ensure_vk_object_map();
-   _mesa_hash_table_u64_insert(vk_object_to_data, obj, data);
+   struct object_map *map = vk_object_to_data.load(std::memory_order_relaxed);
+   if (!map)
+      map = object_map_grow(NULL);
+
+   struct object_map_entry *entry = object_map_find_entry(map, obj);
+   if (entry->key.load(std::memory_order_relaxed) == 0 &&
+       4 * (map->used + 1) > 3u << map->size_log2) {
+      map = object_map_grow(map);
+      entry = object_map_find_entry(map, obj);
+   }
+
+   uint64_t key = entry->key.load(std::memory_order_relaxed);
+   if (key == 0)
+      map->used++;
+   if (key == 0 || !entry->data.load(std::memory_order_relaxed))
+      vk_object_to_data_count++;
+
+   /* Publish the data before the key, so a reader finding the key
+    * doesn't pick up a stale pointer.
+    */
+   entry->data.store(data, std::memory_order_release);
+   entry->key.store(obj, std::memory_order_release);
    simple_mtx_unlock(&vk_object_to_data_mutex);
 }
 
 static void unmap_object(uint64_t obj)
 {
    simple_mtx_lock(&vk_object_to_data_mutex);
-   _mesa_hash_table_u64_remove(vk_object_to_data, obj);
+   struct object_map *map = vk_object_to_data.load(std::memory_order_relaxed);
+   struct object_map_entry *entry = map ? object_map_find_entry(map, obj) : NULL;
+   if (entry && entry->key.load(std::memory_order_relaxed) == obj &&
+       entry->data.load(std::memory_order_relaxed)) {
+      entry->data.store(NULL, std::memory_order_release);
+      vk_object_to_data_count--;
+   }
    simple_mtx_unlock(&vk_object_to_data_mutex);
 }
 
@@ -336,6 +627,9 @@ static void destroy_instance_data(struct instance_data *data)
 {
    if (data->params.output_file)
       fclose(data->params.output_file);
+   overlay_trace_destroy(data->trace);
+   if (data->params.trace_file)
+      fclose(data->params.trace_file);
    if (data->params.control >= 0)
       os_socket_close(data->params.control);
    unmap_object(HKEY(data->instance));
@@ -371,6 +665,11 @@ static struct device_data *new_device_data(VkDevice device, struct instance_data
    struct device_data *data = rzalloc(NULL, struct device_data);
    data->instance = instance;
    data->device = device;
+   simple_mtx_init(&data->queries_mutex, mtx_plain);
+   simple_mtx_init(&data->pipelines_mutex, mtx_plain);
+   list_inithead(&data->pipelines);
+   data->top_pipelines = rzalloc_array(data, struct top_pipeline,
+                                       instance->params.top_pipelines);
    map_object(HKEY(data->device), data);
    return data;
 }
@@ -386,18 +685,9 @@ static struct queue_data *new_queue_data(VkQueue queue,
    data->flags = family_props->queueFlags;
    data->timestamp_mask = (1ull << family_props->timestampValidBits) - 1;
    data->family_index = family_index;
-   list_inithead(&data->running_command_buffer);
+   list_inithead(&data->pending_queries);
    map_object(HKEY(data->queue), data);
 
-   /* Fence synchronizing access to queries on that queue. */
-   VkFenceCreateInfo fence_info = {};
-   fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-   fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-   VK_CHECK(device_data->vtable.CreateFence(device_data->device,
-                                            &fence_info,
-                                            NULL,
-                                            &data->queries_fence));
-
    if (data->flags & VK_QUEUE_GRAPHICS_BIT)
       device_data->graphic_queue = data;
 
@@ -406,8 +696,11 @@ static struct queue_data *new_queue_data(VkQueue queue,
 
 static void destroy_queue(struct queue_data *data)
 {
-   struct device_data *device_data = data->device;
-   device_data->vtable.DestroyFence(device_data->device, data->queries_fence, NULL);
+   simple_mtx_lock(&data->device->queries_mutex);
+   list_for_each_entry_safe(struct command_buffer_query_slot, slot,
+                            &data->pending_queries, link)
+      list_delinit(&slot->link);
+   simple_mtx_unlock(&data->device->queries_mutex);
    unmap_object(HKEY(data->queue));
    ralloc_free(data);
 }
@@ -457,10 +750,85 @@ static void device_unmap_queues(struct device_data *data)
 
 static void destroy_device_data(struct device_data *data)
 {
+   list_for_each_entry_safe(struct pipeline_data, pipeline_data,
+                            &data->pipelines, link)
+      unmap_object(HKEY(pipeline_data->pipeline));
    unmap_object(HKEY(data->device));
+   simple_mtx_destroy(&data->pipelines_mutex);
+   simple_mtx_destroy(&data->queries_mutex);
+   ralloc_free(data);
+}
+
+/**/
+static void new_pipeline_data(struct device_data *device_data,
+                              VkPipeline pipeline,
+                              VkPipelineBindPoint bind_point)
+{
+   struct pipeline_data *data = rzalloc(device_data, struct pipeline_data);
+   data->pipeline = pipeline;
+   data->bind_point = bind_point;
+   simple_mtx_lock(&device_data->pipelines_mutex);
+   list_addtail(&data->link, &device_data->pipelines);
+   simple_mtx_unlock(&device_data->pipelines_mutex);
+   map_object(HKEY(data->pipeline), data);
+}
+
+static void destroy_pipeline_data(struct device_data *device_data,
+                                  struct pipeline_data *data)
+{
+   unmap_object(HKEY(data->pipeline));
+   simple_mtx_lock(&device_data->pipelines_mutex);
+   list_del(&data->link);
+   simple_mtx_unlock(&device_data->pipelines_mutex);
    ralloc_free(data);
 }
 
+static int compare_top_pipelines(const void *a, const void *b)
+{
+   const struct top_pipeline *pa = (const struct top_pipeline *)a;
+   const struct top_pipeline *pb = (const struct top_pipeline *)b;
+   if (pa->stats.gpu_time != pb->stats.gpu_time)
+      return pa->stats.gpu_time < pb->stats.gpu_time ? 1 : -1;
+   if (pa->stats.draws + pa->stats.dispatches != pb->stats.draws + pb->stats.dispatches)
+      return pa->stats.draws + pa->stats.dispatches <
+             pb->stats.draws + pb->stats.dispatches ? 1 : -1;
+   return 0;
+}
+
+/* Keeps the most expensive pipelines of the sampling period that just
+ * ended, and starts a new one.
+ */
+static void update_top_pipelines(struct device_data *data)
+{
+   unsigned max = data->instance->params.top_pipelines;
+   struct top_pipeline *top = data->top_pipelines;
+   unsigned n = 0;
+
+   simple_mtx_lock(&data->pipelines_mutex);
+   list_for_each_entry(struct pipeline_data, pipeline_data, &data->pipelines, link) {
+      struct top_pipeline entry = {
+         pipeline_data->pipeline, pipeline_data->bind_point, pipeline_data->stats,
+      };
+      memset(&pipeline_data->stats, 0, sizeof(pipeline_data->stats));
+
+      if (!entry.stats.draws && !entry.stats.dispatches)
+         continue;
+      if (n == max) {
+         if (compare_top_pipelines(&entry, &top[n - 1]) >= 0)
+            continue;
+         n--;
+      }
+
+      /* Insertion in the sorted array */
+      unsigned i = n++;
+      for (; i > 0 && compare_top_pipelines(&entry, &top[i - 1]) < 0; i--)
+         top[i] = top[i - 1];
+      top[i] = entry;
+   }
+   data->n_top_pipelines = n;
+   simple_mtx_unlock(&data->pipelines_mutex);
+}
+
 /**/
 static struct command_buffer_data *new_command_buffer_data(VkCommandBuffer cmd_buffer,
                                                            VkCommandBufferLevel level,
@@ -476,7 +844,15 @@ static struct command_buffer_data *new_command_buffer_data(VkCommandBuffer cmd_b
    data->pipeline_query_pool = pipeline_query_pool;
    data->timestamp_query_pool = timestamp_query_pool;
    data->query_index = query_index;
-   list_inithead(&data->link);
+   data->timestamps_per_slot =
+      device_data->instance->params.top_pipelines ? OVERLAY_PIPELINE_TIMESTAMPS : 2;
+   for (uint32_t i = 0; i < OVERLAY_QUERY_RING_SIZE; i++) {
+      data->query_slots[i].cmd_buffer = data;
+      data->query_slots[i].query_index = query_index * OVERLAY_QUERY_RING_SIZE + i;
+      util_dynarray_init(&data->query_slots[i].segments, data);
+      data->query_slots[i].current_segment = -1;
+      list_inithead(&data->query_slots[i].link);
+   }
    map_object(HKEY(data->cmd_buffer), data);
    return data;
 }
@@ -484,10 +860,89 @@ static struct command_buffer_data *new_command_buffer_data(VkCommandBuffer cmd_b
 static void destroy_command_buffer_data(struct command_buffer_data *data)
 {
    unmap_object(HKEY(data->cmd_buffer));
-   list_delinit(&data->link);
+   simple_mtx_lock(&data->device->queries_mutex);
+   for (uint32_t i = 0; i < OVERLAY_QUERY_RING_SIZE; i++)
+      list_delinit(&data->query_slots[i].link);
+   simple_mtx_unlock(&data->device->queries_mutex);
    ralloc_free(data);
 }
 
+static void reset_pipeline_segments(struct command_buffer_data *data)
+{
+   struct command_buffer_query_slot *slot = &data->query_slots[data->query_slot];
+
+   util_dynarray_clear(&slot->segments);
+   slot->current_segment = -1;
+   slot->n_timestamps = 0;
+   data->graphics_pipeline = VK_NULL_HANDLE;
+   data->compute_pipeline = VK_NULL_HANDLE;
+}
+
+/* Accounts work to a pipeline, starting a new segment with a timestamp
+ * when the pipeline changes. The GPU time between two timestamps, which
+ * includes whatever else was recorded in between, goes to the pipeline of
+ * the segment.
+ */
+static struct pipeline_segment *
+cmd_buffer_pipeline_segment(struct command_buffer_data *data,
+                            VkPipeline pipeline)
+{
+   struct device_data *device_data = data->device;
+   struct command_buffer_query_slot *slot = &data->query_slots[data->query_slot];
+
+   if (slot->current_segment >= 0) {
+      struct pipeline_segment *segment =
+         util_dynarray_element(&slot->segments, struct pipeline_segment,
+                               slot->current_segment);
+      if (segment->pipeline == pipeline)
+         return segment;
+   }
+
+   slot->current_segment =
+      util_dynarray_num_elements(&slot->segments, struct pipeline_segment);
+   struct pipeline_segment *segment = (struct pipeline_segment *)
+      util_dynarray_grow(&slot->segments, struct pipeline_segment, 1);
+   memset(segment, 0, sizeof(*segment));
+   segment->pipeline = pipeline;
+   segment->timestamp = -1;
+
+   /* Keep the last timestamp for the end of the command buffer. */
+   if (data->level == VK_COMMAND_BUFFER_LEVEL_PRIMARY &&
+       data->timestamp_query_pool &&
+       slot->n_timestamps < data->timestamps_per_slot - 1) {
+      segment->timestamp = slot->n_timestamps++;
+      device_data->vtable.CmdWriteTimestamp(data->cmd_buffer,
+                                            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                            data->timestamp_query_pool,
+                                            slot->query_index * data->timestamps_per_slot +
+                                            segment->timestamp);
+   }
+
+   return segment;
+}
+
+static void cmd_buffer_account_draw(struct command_buffer_data *data,
+                                    uint64_t vertices)
+{
+   if (!data->device->instance->params.top_pipelines)
+      return;
+
+   struct pipeline_segment *segment =
+      cmd_buffer_pipeline_segment(data, data->graphics_pipeline);
+   segment->stats.draws++;
+   segment->stats.vertices += vertices;
+}
+
+static void cmd_buffer_account_dispatch(struct command_buffer_data *data)
+{
+   if (!data->device->instance->params.top_pipelines)
+      return;
+
+   struct pipeline_segment *segment =
+      cmd_buffer_pipeline_segment(data, data->compute_pipeline);
+   segment->stats.dispatches++;
+}
+
 /**/
 static struct swapchain_data *new_swapchain_data(VkSwapchainKHR swapchain,
                                                  struct device_data *device_data)
@@ -768,6 +1223,25 @@ static void process_control_socket(struct instance_data *instance_data)
    }
 }
 
+static void trace_swapchain_frame(struct swapchain_data *data,
+                                  const struct frame_stat *stats,
+                                  uint64_t now)
+{
+   struct instance_data *instance_data = data->device->instance;
+   uint64_t values[3 + OVERLAY_PARAM_ENABLED_MAX];
+   unsigned n = 0;
+
+   values[n++] = now;
+   values[n++] = HKEY(data->swapchain);
+   values[n++] = data->n_frames;
+   for (int s = 0; s < OVERLAY_PARAM_ENABLED_MAX; s++) {
+      if (s != OVERLAY_PARAM_ENABLED_fps && instance_data->params.enabled[s])
+         values[n++] = stats->stats[s];
+   }
+
+   overlay_trace_add_record(instance_data->trace, values);
+}
+
 static void snapshot_swapchain_frame(struct swapchain_data *data)
 {
    struct device_data *device_data = data->device;
@@ -791,6 +1265,9 @@ static void snapshot_swapchain_frame(struct swapchain_data *data)
       data->accumulated_stats.stats[s] += device_data->frame_stats.stats[s] + data->frame_stats.stats[s];
    }
 
+   if (instance_data->trace && instance_data->capture_started)
+      trace_swapchain_frame(data, &data->frames_stats[f_idx], now);
+
    /* If capture has been enabled but it hasn't started yet, it means we are on
     * the first snapshot after it has been enabled. At this point we want to
     * use the stats captured so far to update the display, but we don't want
@@ -810,7 +1287,8 @@ static void snapshot_swapchain_frame(struct swapchain_data *data)
       if (capture_begin ||
           elapsed >= instance_data->params.fps_sampling_period) {
          data->fps = 1000000.0f * data->n_frames_since_update / elapsed;
-         if (instance_data->capture_started) {
+         if (instance_data->capture_started &&
+             instance_data->params.output_file) {
             if (!instance_data->first_line_printed) {
                bool first_column = true;
 
@@ -846,6 +1324,9 @@ static void snapshot_swapchain_frame(struct swapchain_data *data)
             fflush(instance_data->params.output_file);
          }
 
+         if (instance_data->params.top_pipelines)
+            update_top_pipelines(device_data);
+
          memset(&data->accumulated_stats, 0, sizeof(data->accumulated_stats));
          data->n_frames_since_update = 0;
          data->last_fps_update = now;
@@ -998,6 +1479,32 @@ static void compute_swapchain_display(struct swapchain_data *data)
                      data->stats_min.stats[s], data->stats_max.stats[s]);
       }
    }
+
+   if (device_data->n_top_pipelines > 0) {
+      double period_ms = instance_data->params.fps_sampling_period / 1000.0;
+
+      ImGui::Separator();
+      ImGui::Text("Top pipelines (GPU time per %.0fms)", period_ms);
+      ImGui::Columns(5, "##top_pipelines", false);
+      ImGui::Text("pipeline"); ImGui::NextColumn();
+      ImGui::Text("draws"); ImGui::NextColumn();
+      ImGui::Text("dispatches"); ImGui::NextColumn();
+      ImGui::Text("vertices"); ImGui::NextColumn();
+      ImGui::Text("gpu (ms)"); ImGui::NextColumn();
+      for (unsigned i = 0; i < device_data->n_top_pipelines; i++) {
+         const struct top_pipeline *top = &device_data->top_pipelines[i];
+         ImGui::Text("%s 0x%" PRIx64,
+                     top->bind_point == VK_PIPELINE_BIND_POINT_COMPUTE ? "cs" : "gfx",
+                     HKEY(top->pipeline));
+         ImGui::NextColumn();
+         ImGui::Text("%" PRIu64, top->stats.draws); ImGui::NextColumn();
+         ImGui::Text("%" PRIu64, top->stats.dispatches); ImGui::NextColumn();
+         ImGui::Text("%" PRIu64, top->stats.vertices); ImGui::NextColumn();
+         ImGui::Text("%.3f", top->stats.gpu_time / 1000000.0); ImGui::NextColumn();
+      }
+      ImGui::Columns(1);
+   }
+
    data->window_size = ImVec2(data->window_size.x, ImGui::GetCursorPosY() + 10.0f);
    ImGui::End();
    ImGui::EndFrame();
@@ -1888,55 +2395,74 @@ static VkResult overlay_QueuePresentKHR(
    struct queue_data *queue_data = FIND(struct queue_data, queue);
    struct device_data *device_data = queue_data->device;
    struct instance_data *instance_data = device_data->instance;
-   uint32_t query_results[OVERLAY_QUERY_COUNT];
 
    device_data->frame_stats.stats[OVERLAY_PARAM_ENABLED_frame]++;
 
-   if (list_length(&queue_data->running_command_buffer) > 0) {
-      /* Before getting the query results, make sure the operations have
-       * completed.
-       */
-      VK_CHECK(device_data->vtable.ResetFences(device_data->device,
-                                               1, &queue_data->queries_fence));
-      VK_CHECK(device_data->vtable.QueueSubmit(queue, 0, NULL, queue_data->queries_fence));
-      VK_CHECK(device_data->vtable.WaitForFences(device_data->device,
-                                                 1, &queue_data->queries_fence,
-                                                 VK_FALSE, UINT64_MAX));
-
-      /* Now get the results. */
-      list_for_each_entry_safe(struct command_buffer_data, cmd_buffer_data,
-                               &queue_data->running_command_buffer, link) {
-         list_delinit(&cmd_buffer_data->link);
-
-         if (cmd_buffer_data->pipeline_query_pool) {
-            memset(query_results, 0, sizeof(query_results));
-            VK_CHECK(device_data->vtable.GetQueryPoolResults(device_data->device,
-                                                             cmd_buffer_data->pipeline_query_pool,
-                                                             cmd_buffer_data->query_index, 1,
-                                                             sizeof(uint32_t) * OVERLAY_QUERY_COUNT,
-                                                             query_results, 0, VK_QUERY_RESULT_WAIT_BIT));
-
-            for (uint32_t i = OVERLAY_PARAM_ENABLED_vertices;
-                 i <= OVERLAY_PARAM_ENABLED_compute_invocations; i++) {
-               device_data->frame_stats.stats[i] += query_results[i - OVERLAY_PARAM_ENABLED_vertices];
-            }
+   /* Gather the results the GPU made available since the last present,
+    * without waiting for the others, which we'll look at again next time.
+    */
+   simple_mtx_lock(&device_data->queries_mutex);
+   list_for_each_entry_safe(struct command_buffer_query_slot, slot,
+                            &queue_data->pending_queries, link) {
+      struct command_buffer_data *cmd_buffer_data = slot->cmd_buffer;
+      uint32_t query_results[OVERLAY_QUERY_COUNT] = { 0 };
+      uint64_t gpu_timestamps[OVERLAY_PIPELINE_TIMESTAMPS] = { 0 };
+      uint32_t n_timestamps = slot->n_timestamps;
+
+      if (cmd_buffer_data->pipeline_query_pool &&
+          device_data->vtable.GetQueryPoolResults(device_data->device,
+                                                  cmd_buffer_data->pipeline_query_pool,
+                                                  slot->query_index, 1,
+                                                  sizeof(uint32_t) * OVERLAY_QUERY_COUNT,
+                                                  query_results, 0, 0) != VK_SUCCESS)
+         continue;
+      if (cmd_buffer_data->timestamp_query_pool &&
+          device_data->vtable.GetQueryPoolResults(device_data->device,
+                                                  cmd_buffer_data->timestamp_query_pool,
+                                                  slot->query_index * cmd_buffer_data->timestamps_per_slot,
+                                                  n_timestamps,
+                                                  n_timestamps * sizeof(uint64_t), gpu_timestamps, sizeof(uint64_t),
+                                                  VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+         continue;
+
+      list_delinit(&slot->link);
+
+      if (cmd_buffer_data->pipeline_query_pool) {
+         for (uint32_t i = OVERLAY_PARAM_ENABLED_vertices;
+              i <= OVERLAY_PARAM_ENABLED_compute_invocations; i++) {
+            device_data->frame_stats.stats[i] += query_results[i - OVERLAY_PARAM_ENABLED_vertices];
          }
-         if (cmd_buffer_data->timestamp_query_pool) {
-            uint64_t gpu_timestamps[2] = { 0 };
-            VK_CHECK(device_data->vtable.GetQueryPoolResults(device_data->device,
-                                                             cmd_buffer_data->timestamp_query_pool,
-                                                             cmd_buffer_data->query_index * 2, 2,
-                                                             2 * sizeof(uint64_t), gpu_timestamps, sizeof(uint64_t),
-                                                             VK_QUERY_RESULT_WAIT_BIT | VK_QUERY_RESULT_64_BIT));
-
-            gpu_timestamps[0] &= queue_data->timestamp_mask;
-            gpu_timestamps[1] &= queue_data->timestamp_mask;
-            device_data->frame_stats.stats[OVERLAY_PARAM_ENABLED_gpu_timing] +=
-               (gpu_timestamps[1] - gpu_timestamps[0]) *
-               device_data->properties.limits.timestampPeriod;
+      }
+      if (cmd_buffer_data->timestamp_query_pool) {
+         for (uint32_t i = 0; i < n_timestamps; i++)
+            gpu_timestamps[i] &= queue_data->timestamp_mask;
+         device_data->frame_stats.stats[OVERLAY_PARAM_ENABLED_gpu_timing] +=
+            (gpu_timestamps[n_timestamps - 1] - gpu_timestamps[0]) *
+            device_data->properties.limits.timestampPeriod;
+      }
+
+      if (instance_data->params.top_pipelines) {
+         simple_mtx_lock(&device_data->pipelines_mutex);
+         util_dynarray_foreach(&slot->segments, struct pipeline_segment, segment) {
+            struct pipeline_data *pipeline_data =
+               FIND(struct pipeline_data, segment->pipeline);
+            if (!pipeline_data)
+               continue;
+
+            pipeline_data->stats.draws += segment->stats.draws;
+            pipeline_data->stats.dispatches += segment->stats.dispatches;
+            pipeline_data->stats.vertices += segment->stats.vertices;
+            if (segment->timestamp >= 0) {
+               pipeline_data->stats.gpu_time +=
+                  (gpu_timestamps[segment->timestamp + 1] -
+                   gpu_timestamps[segment->timestamp]) *
+                  device_data->properties.limits.timestampPeriod;
+            }
          }
+         simple_mtx_unlock(&device_data->pipelines_mutex);
       }
    }
+   simple_mtx_unlock(&device_data->queries_mutex);
 
    /* Otherwise we need to add our overlay drawing semaphore to the list of
     * semaphores to wait on. If we don't do that the presented picture might
@@ -2059,6 +2585,7 @@ static void overlay_CmdDraw(
    struct command_buffer_data *cmd_buffer_data =
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw]++;
+   cmd_buffer_account_draw(cmd_buffer_data, (uint64_t)vertexCount * instanceCount);
    struct device_data *device_data = cmd_buffer_data->device;
    device_data->vtable.CmdDraw(commandBuffer, vertexCount, instanceCount,
                                firstVertex, firstInstance);
@@ -2075,6 +2602,7 @@ static void overlay_CmdDrawIndexed(
    struct command_buffer_data *cmd_buffer_data =
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw_indexed]++;
+   cmd_buffer_account_draw(cmd_buffer_data, (uint64_t)indexCount * instanceCount);
    struct device_data *device_data = cmd_buffer_data->device;
    device_data->vtable.CmdDrawIndexed(commandBuffer, indexCount, instanceCount,
                                       firstIndex, vertexOffset, firstInstance);
@@ -2090,6 +2618,7 @@ static void overlay_CmdDrawIndirect(
    struct command_buffer_data *cmd_buffer_data =
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw_indirect]++;
+   cmd_buffer_account_draw(cmd_buffer_data, 0);
    struct device_data *device_data = cmd_buffer_data->device;
    device_data->vtable.CmdDrawIndirect(commandBuffer, buffer, offset, drawCount, stride);
 }
@@ -2104,6 +2633,7 @@ static void overlay_CmdDrawIndexedIndirect(
    struct command_buffer_data *cmd_buffer_data =
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw_indexed_indirect]++;
+   cmd_buffer_account_draw(cmd_buffer_data, 0);
    struct device_data *device_data = cmd_buffer_data->device;
    device_data->vtable.CmdDrawIndexedIndirect(commandBuffer, buffer, offset, drawCount, stride);
 }
@@ -2120,6 +2650,7 @@ static void overlay_CmdDrawIndirectCount(
    struct command_buffer_data *cmd_buffer_data =
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw_indirect_count]++;
+   cmd_buffer_account_draw(cmd_buffer_data, 0);
    struct device_data *device_data = cmd_buffer_data->device;
    device_data->vtable.CmdDrawIndirectCount(commandBuffer, buffer, offset,
                                             countBuffer, countBufferOffset,
@@ -2138,6 +2669,7 @@ static void overlay_CmdDrawIndexedIndirectCount(
    struct command_buffer_data *cmd_buffer_data =
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw_indexed_indirect_count]++;
+   cmd_buffer_account_draw(cmd_buffer_data, 0);
    struct device_data *device_data = cmd_buffer_data->device;
    device_data->vtable.CmdDrawIndexedIndirectCount(commandBuffer, buffer, offset,
                                                    countBuffer, countBufferOffset,
@@ -2153,6 +2685,7 @@ static void overlay_CmdDispatch(
    struct command_buffer_data *cmd_buffer_data =
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_dispatch]++;
+   cmd_buffer_account_dispatch(cmd_buffer_data);
    struct device_data *device_data = cmd_buffer_data->device;
    device_data->vtable.CmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
 }
@@ -2165,6 +2698,7 @@ static void overlay_CmdDispatchIndirect(
    struct command_buffer_data *cmd_buffer_data =
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_dispatch_indirect]++;
+   cmd_buffer_account_dispatch(cmd_buffer_data);
    struct device_data *device_data = cmd_buffer_data->device;
    device_data->vtable.CmdDispatchIndirect(commandBuffer, buffer, offset);
 }
@@ -2177,8 +2711,14 @@ static void overlay_CmdBindPipeline(
    struct command_buffer_data *cmd_buffer_data =
       FIND(struct command_buffer_data, commandBuffer);
    switch (pipelineBindPoint) {
-   case VK_PIPELINE_BIND_POINT_GRAPHICS: cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_pipeline_graphics]++; break;
-   case VK_PIPELINE_BIND_POINT_COMPUTE: cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_pipeline_compute]++; break;
+   case VK_PIPELINE_BIND_POINT_GRAPHICS:
+      cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_pipeline_graphics]++;
+      cmd_buffer_data->graphics_pipeline = pipeline;
+      break;
+   case VK_PIPELINE_BIND_POINT_COMPUTE:
+      cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_pipeline_compute]++;
+      cmd_buffer_data->compute_pipeline = pipeline;
+      break;
    case VK_PIPELINE_BIND_POINT_RAY_TRACING_NV: cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_pipeline_raytracing]++; break;
    default: break;
    }
@@ -2186,6 +2726,68 @@ static void overlay_CmdBindPipeline(
    device_data->vtable.CmdBindPipeline(commandBuffer, pipelineBindPoint, pipeline);
 }
 
+static VkResult overlay_CreateGraphicsPipelines(
+    VkDevice                                    device,
+    VkPipelineCache                             pipelineCache,
+    uint32_t                                    createInfoCount,
+    const VkGraphicsPipelineCreateInfo*         pCreateInfos,
+    const VkAllocationCallbacks*                pAllocator,
+    VkPipeline*                                 pPipelines)
+{
+   struct device_data *device_data = FIND(struct device_data, device);
+   VkResult result =
+      device_data->vtable.CreateGraphicsPipelines(device, pipelineCache,
+                                                  createInfoCount, pCreateInfos,
+                                                  pAllocator, pPipelines);
+
+   if (device_data->instance->params.top_pipelines) {
+      for (uint32_t i = 0; i < createInfoCount; i++) {
+         if (pPipelines[i])
+            new_pipeline_data(device_data, pPipelines[i], VK_PIPELINE_BIND_POINT_GRAPHICS);
+      }
+   }
+
+   return result;
+}
+
+static VkResult overlay_CreateComputePipelines(
+    VkDevice                                    device,
+    VkPipelineCache                             pipelineCache,
+    uint32_t                                    createInfoCount,
+    const VkComputePipelineCreateInfo*          pCreateInfos,
+    const VkAllocationCallbacks*                pAllocator,
+    VkPipeline*                                 pPipelines)
+{
+   struct device_data *device_data = FIND(struct device_data, device);
+   VkResult result =
+      device_data->vtable.CreateComputePipelines(device, pipelineCache,
+                                                 createInfoCount, pCreateInfos,
+                                                 pAllocator, pPipelines);
+
+   if (device_data->instance->params.top_pipelines) {
+      for (uint32_t i = 0; i < createInfoCount; i++) {
+         if (pPipelines[i])
+            new_pipeline_data(device_data, pPipelines[i], VK_PIPELINE_BIND_POINT_COMPUTE);
+      }
+   }
+
+   return result;
+}
+
+static void overlay_DestroyPipeline(
+    VkDevice                                    device,
+    VkPipeline                                  pipeline,
+    const VkAllocationCallbacks*                pAllocator)
+{
+   struct device_data *device_data = FIND(struct device_data, device);
+   struct pipeline_data *pipeline_data = FIND(struct pipeline_data, pipeline);
+
+   if (pipeline_data)
+      destroy_pipeline_data(device_data, pipeline_data);
+
+   device_data->vtable.DestroyPipeline(device, pipeline, pAllocator);
+}
+
 static VkResult overlay_BeginCommandBuffer(
     VkCommandBuffer                             commandBuffer,
     const VkCommandBufferBeginInfo*             pBeginInfo)
@@ -2229,6 +2831,8 @@ static VkResult overlay_BeginCommandBuffer(
 
       free_chain((struct VkBaseOutStructure *)begin_info);
 
+      reset_pipeline_segments(cmd_buffer_data);
+
       return result;
    }
 
@@ -2236,26 +2840,41 @@ static VkResult overlay_BeginCommandBuffer(
    VkResult result = device_data->vtable.BeginCommandBuffer(commandBuffer, pBeginInfo);
 
    if (result == VK_SUCCESS) {
+      /* Move on to the next query slot. If the results of its previous use
+       * still aren't available, they never will be since we're about to
+       * reset them, so forget about them.
+       */
+      cmd_buffer_data->query_slot =
+         (cmd_buffer_data->query_slot + 1) % OVERLAY_QUERY_RING_SIZE;
+      struct command_buffer_query_slot *slot =
+         &cmd_buffer_data->query_slots[cmd_buffer_data->query_slot];
+      simple_mtx_lock(&device_data->queries_mutex);
+      list_delinit(&slot->link);
+      simple_mtx_unlock(&device_data->queries_mutex);
+      reset_pipeline_segments(cmd_buffer_data);
+
+      uint32_t first_timestamp = slot->query_index * cmd_buffer_data->timestamps_per_slot;
       if (cmd_buffer_data->pipeline_query_pool) {
          device_data->vtable.CmdResetQueryPool(commandBuffer,
                                                cmd_buffer_data->pipeline_query_pool,
-                                               cmd_buffer_data->query_index, 1);
+                                               slot->query_index, 1);
       }
       if (cmd_buffer_data->timestamp_query_pool) {
          device_data->vtable.CmdResetQueryPool(commandBuffer,
                                                cmd_buffer_data->timestamp_query_pool,
-                                               cmd_buffer_data->query_index * 2, 2);
+                                               first_timestamp,
+                                               cmd_buffer_data->timestamps_per_slot);
       }
       if (cmd_buffer_data->pipeline_query_pool) {
          device_data->vtable.CmdBeginQuery(commandBuffer,
                                            cmd_buffer_data->pipeline_query_pool,
-                                           cmd_buffer_data->query_index, 0);
+                                           slot->query_index, 0);
       }
       if (cmd_buffer_data->timestamp_query_pool) {
          device_data->vtable.CmdWriteTimestamp(commandBuffer,
                                                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
                                                cmd_buffer_data->timestamp_query_pool,
-                                               cmd_buffer_data->query_index * 2);
+                                               first_timestamp + slot->n_timestamps++);
       }
    }
 
@@ -2268,17 +2887,21 @@ static VkResult overlay_EndCommandBuffer(
    struct command_buffer_data *cmd_buffer_data =
       FIND(struct command_buffer_data, commandBuffer);
    struct device_data *device_data = cmd_buffer_data->device;
+   struct command_buffer_query_slot *slot =
+      &cmd_buffer_data->query_slots[cmd_buffer_data->query_slot];
 
-   if (cmd_buffer_data->timestamp_query_pool) {
+   if (cmd_buffer_data->timestamp_query_pool &&
+       slot->n_timestamps < cmd_buffer_data->timestamps_per_slot) {
       device_data->vtable.CmdWriteTimestamp(commandBuffer,
                                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
                                             cmd_buffer_data->timestamp_query_pool,
-                                            cmd_buffer_data->query_index * 2 + 1);
+                                            slot->query_index * cmd_buffer_data->timestamps_per_slot +
+                                            slot->n_timestamps++);
    }
    if (cmd_buffer_data->pipeline_query_pool) {
       device_data->vtable.CmdEndQuery(commandBuffer,
                                       cmd_buffer_data->pipeline_query_pool,
-                                      cmd_buffer_data->query_index);
+                                      slot->query_index);
    }
 
    return device_data->vtable.EndCommandBuffer(commandBuffer);
@@ -2306,6 +2929,14 @@ static void overlay_CmdExecuteCommands(
       FIND(struct command_buffer_data, commandBuffer);
    struct device_data *device_data = cmd_buffer_data->device;
 
+   /* The GPU time of the secondary command buffers can't be split between
+    * their pipelines, it goes to a segment without pipeline.
+    */
+   struct command_buffer_query_slot *slot =
+      &cmd_buffer_data->query_slots[cmd_buffer_data->query_slot];
+   if (device_data->instance->params.top_pipelines)
+      cmd_buffer_pipeline_segment(cmd_buffer_data, VK_NULL_HANDLE);
+
    /* Add the stats of the executed command buffers to the primary one. */
    for (uint32_t c = 0; c < commandBufferCount; c++) {
       struct command_buffer_data *sec_cmd_buffer_data =
@@ -2313,6 +2944,14 @@ static void overlay_CmdExecuteCommands(
 
       for (uint32_t s = 0; s < OVERLAY_PARAM_ENABLED_MAX; s++)
          cmd_buffer_data->stats.stats[s] += sec_cmd_buffer_data->stats.stats[s];
+
+      struct command_buffer_query_slot *sec_slot =
+         &sec_cmd_buffer_data->query_slots[sec_cmd_buffer_data->query_slot];
+      util_dynarray_foreach(&sec_slot->segments, struct pipeline_segment, segment) {
+         struct pipeline_segment untimed = *segment;
+         untimed.timestamp = -1;
+         util_dynarray_append(&slot->segments, struct pipeline_segment, untimed);
+      }
    }
 
    device_data->vtable.CmdExecuteCommands(commandBuffer, commandBufferCount, pCommandBuffers);
@@ -2338,19 +2977,21 @@ static VkResult overlay_AllocateCommandBuffers(
          NULL,
          0,
          VK_QUERY_TYPE_PIPELINE_STATISTICS,
-         pAllocateInfo->commandBufferCount,
+         pAllocateInfo->commandBufferCount * OVERLAY_QUERY_RING_SIZE,
          overlay_query_flags,
       };
       VK_CHECK(device_data->vtable.CreateQueryPool(device_data->device, &pool_info,
                                                    NULL, &pipeline_query_pool));
    }
-   if (device_data->instance->params.enabled[OVERLAY_PARAM_ENABLED_gpu_timing]) {
+   if (device_data->instance->params.enabled[OVERLAY_PARAM_ENABLED_gpu_timing] ||
+       device_data->instance->params.top_pipelines) {
       VkQueryPoolCreateInfo pool_info = {
          VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
          NULL,
          0,
          VK_QUERY_TYPE_TIMESTAMP,
-         pAllocateInfo->commandBufferCount * 2,
+         pAllocateInfo->commandBufferCount * OVERLAY_QUERY_RING_SIZE *
+         (device_data->instance->params.top_pipelines ? OVERLAY_PIPELINE_TIMESTAMPS : 2),
          0,
       };
       VK_CHECK(device_data->vtable.CreateQueryPool(device_data->device, &pool_info,
@@ -2429,20 +3070,21 @@ static VkResult overlay_QueueSubmit(
          for (uint32_t st = 0; st < OVERLAY_PARAM_ENABLED_MAX; st++)
             device_data->frame_stats.stats[st] += cmd_buffer_data->stats.stats[st];
 
-         /* Attach the command buffer to the queue so we remember to read its
-          * pipeline statistics & timestamps at QueuePresent().
+         /* Attach the command buffer queries to the queue so we remember to
+          * read its pipeline statistics & timestamps at QueuePresent(). If
+          * the same recording is submitted again before we got them, only
+          * one of the executions gets accounted for.
           */
          if (!cmd_buffer_data->pipeline_query_pool &&
              !cmd_buffer_data->timestamp_query_pool)
             continue;
 
-         if (list_is_empty(&cmd_buffer_data->link)) {
-            list_addtail(&cmd_buffer_data->link,
-                         &queue_data->running_command_buffer);
-         } else {
-            fprintf(stderr, "Command buffer submitted multiple times before present.\n"
-                    "This could lead to invalid data.\n");
-         }
+         struct command_buffer_query_slot *slot =
+            &cmd_buffer_data->query_slots[cmd_buffer_data->query_slot];
+         simple_mtx_lock(&device_data->queries_mutex);
+         if (list_is_empty(&slot->link))
+            list_addtail(&slot->link, &queue_data->pending_queries);
+         simple_mtx_unlock(&device_data->queries_mutex);
       }
    }
 
@@ -2560,11 +3202,36 @@ static VkResult overlay_CreateInstance(
 
    parse_overlay_env(&instance_data->params, getenv("VK_LAYER_MESA_OVERLAY_CONFIG"));
 
-   /* If there's no control file, and an output_file was specified, start
-    * capturing fps data right away.
+   /* Columns of the trace records, see trace_swapchain_frame(). The fps
+    * can be computed from the timestamps.
+    */
+   if (instance_data->params.trace_file) {
+      char names[3 + OVERLAY_PARAM_ENABLED_MAX][64];
+      const char *columns[3 + OVERLAY_PARAM_ENABLED_MAX];
+      unsigned n = 0;
+
+      columns[n++] = "timestamp(us)";
+      columns[n++] = "swapchain";
+      columns[n++] = "frame";
+      for (int s = 0; s < OVERLAY_PARAM_ENABLED_MAX; s++) {
+         if (s == OVERLAY_PARAM_ENABLED_fps || !instance_data->params.enabled[s])
+            continue;
+         snprintf(names[n], sizeof(names[n]), "%s%s", overlay_param_names[s],
+                  param_unit((enum overlay_param_enabled)s));
+         columns[n] = names[n];
+         n++;
+      }
+
+      instance_data->trace =
+         overlay_trace_create(instance_data->params.trace_file, n, columns);
+   }
+
+   /* If there's no control file, and an output_file or trace_file was
+    * specified, start capturing fps data right away.
     */
    instance_data->capture_enabled =
-      instance_data->params.output_file && instance_data->params.control < 0;
+      (instance_data->params.output_file || instance_data->trace) &&
+      instance_data->params.control < 0;
    instance_data->capture_started = instance_data->capture_enabled;
 
    for (int i = OVERLAY_PARAM_ENABLED_vertices;
@@ -2616,6 +3283,10 @@ static const struct {
 
    ADD_HOOK(CmdBindPipeline),
 
+   ADD_HOOK(CreateGraphicsPipelines),
+   ADD_HOOK(CreateComputePipelines),
+   ADD_HOOK(DestroyPipeline),
+
    ADD_HOOK(CreateSwapchainKHR),
    ADD_HOOK(QueuePresentKHR),
    ADD_HOOK(DestroySwapchainKHR),
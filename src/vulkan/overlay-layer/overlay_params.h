@@ -67,11 +67,13 @@ extern "C" {
    OVERLAY_PARAM_BOOL(gpu_timing)                    \
    OVERLAY_PARAM_CUSTOM(fps_sampling_period)         \
    OVERLAY_PARAM_CUSTOM(output_file)                 \
+   OVERLAY_PARAM_CUSTOM(trace_file)                  \
    OVERLAY_PARAM_CUSTOM(position)                    \
    OVERLAY_PARAM_CUSTOM(width)                       \
    OVERLAY_PARAM_CUSTOM(height)                      \
    OVERLAY_PARAM_CUSTOM(no_display)                  \
    OVERLAY_PARAM_CUSTOM(control)                     \
+   OVERLAY_PARAM_CUSTOM(top_pipelines)               \
    OVERLAY_PARAM_CUSTOM(help)
 
 enum overlay_param_position {
@@ -94,12 +96,14 @@ struct overlay_params {
    bool enabled[OVERLAY_PARAM_ENABLED_MAX];
    enum overlay_param_position position;
    FILE *output_file;
+   FILE *trace_file;
    int control;
    uint32_t fps_sampling_period; /* us */
    bool help;
    bool no_display;
    unsigned width;
    unsigned height;
+   unsigned top_pipelines;
 };
 
 const extern char *overlay_param_names[];
@@ -0,0 +1,152 @@
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "overlay_trace.h"
+
+#include "util/simple_mtx.h"
+#include "util/u_queue.h"
+
+#define OVERLAY_TRACE_CHUNK_SIZE (64 * 1024)
+#define OVERLAY_TRACE_NUM_CHUNKS 8
+
+struct overlay_trace_chunk {
+   struct util_queue_fence fence;
+   struct overlay_trace *trace;
+   size_t size;
+   uint8_t data[OVERLAY_TRACE_CHUNK_SIZE];
+};
+
+struct overlay_trace {
+   FILE *file;
+   struct util_queue queue;
+
+   simple_mtx_t mutex;
+   size_t record_size;
+   unsigned current_chunk;
+   uint64_t dropped_records;
+
+   struct overlay_trace_chunk chunks[OVERLAY_TRACE_NUM_CHUNKS];
+};
+
+static void
+write_chunk(void *job, int thread_index)
+{
+   struct overlay_trace_chunk *chunk = job;
+
+   fwrite(chunk->data, 1, chunk->size, chunk->trace->file);
+   fflush(chunk->trace->file);
+   chunk->size = 0;
+}
+
+static void
+submit_chunk(struct overlay_trace *trace)
+{
+   struct overlay_trace_chunk *chunk = &trace->chunks[trace->current_chunk];
+
+   util_queue_add_job(&trace->queue, chunk, &chunk->fence,
+                      write_chunk, NULL, 0);
+   trace->current_chunk = (trace->current_chunk + 1) % OVERLAY_TRACE_NUM_CHUNKS;
+}
+
+struct overlay_trace *
+overlay_trace_create(FILE *file, unsigned num_columns,
+                     const char **column_names)
+{
+   struct overlay_trace *trace = calloc(1, sizeof(*trace));
+   if (!trace)
+      return NULL;
+
+   trace->file = file;
+   trace->record_size = num_columns * sizeof(uint64_t);
+   if (trace->record_size > OVERLAY_TRACE_CHUNK_SIZE ||
+       !util_queue_init(&trace->queue, "overlay_trace", OVERLAY_TRACE_NUM_CHUNKS,
+                        1, UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY)) {
+      free(trace);
+      return NULL;
+   }
+
+   simple_mtx_init(&trace->mutex, mtx_plain);
+   for (unsigned i = 0; i < OVERLAY_TRACE_NUM_CHUNKS; i++) {
+      util_queue_fence_init(&trace->chunks[i].fence);
+      trace->chunks[i].trace = trace;
+   }
+
+   const uint32_t header[2] = { OVERLAY_TRACE_VERSION, num_columns };
+   fwrite("MESAOVLT", 1, 8, file);
+   fwrite(header, sizeof(header), 1, file);
+   for (unsigned i = 0; i < num_columns; i++)
+      fwrite(column_names[i], 1, strlen(column_names[i]) + 1, file);
+   fflush(file);
+
+   return trace;
+}
+
+void
+overlay_trace_add_record(struct overlay_trace *trace, const uint64_t *values)
+{
+   simple_mtx_lock(&trace->mutex);
+
+   struct overlay_trace_chunk *chunk = &trace->chunks[trace->current_chunk];
+   if (!util_queue_fence_is_signalled(&chunk->fence)) {
+      trace->dropped_records++;
+      simple_mtx_unlock(&trace->mutex);
+      return;
+   }
+
+   memcpy(chunk->data + chunk->size, values, trace->record_size);
+   chunk->size += trace->record_size;
+   if (chunk->size + trace->record_size > OVERLAY_TRACE_CHUNK_SIZE)
+      submit_chunk(trace);
+
+   simple_mtx_unlock(&trace->mutex);
+}
+
+void
+overlay_trace_destroy(struct overlay_trace *trace)
+{
+   if (!trace)
+      return;
+
+   simple_mtx_lock(&trace->mutex);
+   struct overlay_trace_chunk *chunk = &trace->chunks[trace->current_chunk];
+   if (util_queue_fence_is_signalled(&chunk->fence) && chunk->size > 0)
+      submit_chunk(trace);
+   simple_mtx_unlock(&trace->mutex);
+
+   util_queue_finish(&trace->queue);
+   util_queue_destroy(&trace->queue);
+
+   if (trace->dropped_records > 0) {
+      fprintf(stderr, "mesa-overlay: %" PRIu64 " trace records dropped\n",
+              trace->dropped_records);
+   }
+
+   for (unsigned i = 0; i < OVERLAY_TRACE_NUM_CHUNKS; i++)
+      util_queue_fence_destroy(&trace->chunks[i].fence);
+   simple_mtx_destroy(&trace->mutex);
+   free(trace);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2019 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef OVERLAY_TRACE_H
+#define OVERLAY_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Binary trace of per-frame statistics.
+ *
+ * The file starts with a header :
+ *
+ *    char     magic[8];        "MESAOVLT"
+ *    uint32_t version;         OVERLAY_TRACE_VERSION
+ *    uint32_t num_columns;
+ *    char     names[];         num_columns NUL terminated column names
+ *
+ * followed by records of num_columns uint64_t values in host byte order.
+ *
+ * Records are accumulated in memory and written out by a background
+ * thread, so adding one is only a copy. If the writer thread can't keep
+ * up, records are dropped rather than stalling the caller.
+ */
+
+#define OVERLAY_TRACE_VERSION 1
+
+struct overlay_trace;
+
+struct overlay_trace *overlay_trace_create(FILE *file,
+                                           unsigned num_columns,
+                                           const char **column_names);
+
+void overlay_trace_add_record(struct overlay_trace *trace,
+                              const uint64_t *values);
+
+void overlay_trace_destroy(struct overlay_trace *trace);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OVERLAY_TRACE_H */